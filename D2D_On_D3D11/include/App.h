@@ -14,6 +14,29 @@
 #include <d2d1_2.h>     // Direct2D 1.2
 #include <dwrite.h>     // DirectWrite
 #include <d3d11.h>      // Direct3D 11
+#include <string>
+#include <vector>
+#include <Timer.h>
+#include <DrawTransform.h>
+#include <InitGraph.h>
+#include <RenderGraph.h>
+#include <ResourceTracker.h>
+#include <RingBuffer.h>
+#include <FrameRecorder.h>
+#include <ThreadPool.h>
+#include <SurfaceGroup.h>
+#include <FramePacer.h>
+#include <InputLatency.h>
+#include <GeometryCache.h>
+#include <SpriteBatch.h>
+#include <SpriteRenderer.h>
+#include <StateCache.h>
+#include <SceneGraph.h>
+#include <SpatialIndex.h>
+#include <FontFace.h>
+#include <Surface.h>
+#include <TextBuffer.h>
+#include <TextView.h>
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,7 +60,25 @@ public:
     //=============================================================================================
     App();
     virtual ~App();
-    void Run();
+    bool Run();
+    void SetRecordPath( const char* path );
+    void SetSurfaceCount( UINT count );
+    void SetThreadCount( UINT count );
+    void EnableSurfaceBenchmark( bool enable );
+    void SetTargetFrameRate( double framesPerSec );
+    void SetSyncInterval( UINT interval );
+    void SetBackBufferCount( UINT count );
+    void SetSyntheticInputRate( double eventsPerSec );
+    void SetShapeCount( UINT count );
+    void EnableShapeCache( bool enable );
+    void EnableStateCache( bool enable );
+    void SetSpriteCount( UINT count );
+    void SetSceneNodeCount( UINT count );
+    void SetLogPath( const char* path );
+    void SetLogFontPath( const char* path );
+    void EnableParallelInit( bool enable );
+    void SetMemoryBudget( UINT64 bytes );
+    void SetResizeTestCycles( UINT cycles );
 
 protected:
     //=============================================================================================
@@ -45,13 +86,47 @@ protected:
     //=============================================================================================
     bool InitWnd();
     void TermWnd();
+    bool InitDWrite();
     bool InitD2D();
+    bool InitD2DDevice();
+    bool InitHeadless();
     void TermD2D();
     bool InitD3D();
     void TermD3D();
     void OnRenderD3D();
     void OnRenderD2D();
+    void BuildFrameGraph();
+    void RenderFixedPasses();
+    void* CreateTransientTexture( const RenderTextureDesc& desc );
+    void DestroyTransientTexture( void* pPhysical );
     void OnResize( UINT width, UINT height );
+    bool InitCapture();
+    void TermCapture();
+    void CaptureFrame();
+    void ReadbackCapture();
+    void FlushCapture();
+    bool InitSurfaces( UINT surfaceCount, UINT threadCount );
+    bool RunSurfaceBenchmark();
+    bool RunResizeTest();
+    void PrintMemoryUsage();
+    void WaitForGpu();
+    void OnInput( INPUT_EVENT_TYPE type, int64_t arrivalTicks );
+    void PumpInputMessages();
+    void UpdateTitle();
+    bool InitShapes( UINT shapeCount );
+    void DrawShapes();
+    bool UploadDrawTransforms();
+    bool InitSprites( UINT spriteCount );
+    void DrawSprites();
+    bool InitScene( UINT nodeCount );
+    void UpdateScene();
+    void DrawScene();
+    void HitTestScene( int x, int y );
+    bool InitLogView();
+    void UploadLogView( void* pPhysical );
+    void DrawLogView();
+    void ScrollLogView( int wheelDelta );
+    void OnLogKey( UINT key );
 
     //=============================================================================================
     // protected methods.
@@ -59,9 +134,47 @@ protected:
     /* NOTHING */
 
 private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // ShapeItem structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct ShapeItem
+    {
+        Path            Geometry;       //!< 形状です (正規化デバイス座標).
+        bool            IsStroke;       //!< 線として描画するかどうかです.
+        FILL_RULE       Rule;           //!< 塗りつぶし規則です.
+        StrokeStyle     Style;          //!< 線のスタイルです.
+        float           Color[4];       //!< 色です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // SpriteItem structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct SpriteItem
+    {
+        Sprite          Shape;          //!< 描画するスプライトです.
+        float           VelocityX;      //!< X 方向の速度 (ピクセル/フレーム) です.
+        float           VelocityY;      //!< Y 方向の速度 (ピクセル/フレーム) です.
+        float           Spin;           //!< 回転速度 (ラジアン/フレーム) です.
+        UINT            Texture;        //!< テクスチャ番号です.
+        SPRITE_BLEND    Blend;          //!< ブレンドステートです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // TransientTexture structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct TransientTexture
+    {
+        ID3D11Texture2D*            pTexture;   //!< テクスチャです.
+        ID3D11RenderTargetView*     pRTV;       //!< レンダーターゲットビューです.
+        ID3D11ShaderResourceView*   pSRV;       //!< シェーダリソースビューです.
+        ID2D1Bitmap1*               pBitmap;    //!< Direct2D で描画するためのビットマップです. 必要になった時に生成します.
+    };
+
     //=============================================================================================
     // private variables.
     //=============================================================================================
+    static const UINT       CaptureLatency = 3;     // 読み戻しを遅延させるフレーム数.
+
     HWND                    m_hWnd;
     HINSTANCE               m_hInstance;
     UINT                    m_Width;
@@ -75,6 +188,7 @@ private:
     ID2D1Bitmap1*           m_pD2DBitmap;
     IDWriteFactory*         m_pDWriteFactory;
     IDWriteTextFormat*      m_pTextFormat;
+    IDWriteTextLayout*      m_pTextLayout;          // 中央に表示する文字列 (リサイズ時だけ更新).
 
     // Direct3D 11
     ID3D11Device*           m_pD3DDevice;
@@ -84,7 +198,8 @@ private:
     ID3D11InputLayout*      m_pD3DInputLayout;
     ID3D11VertexShader*     m_pD3DVertexShader;
     ID3D11PixelShader*      m_pD3DPixelShader;
-    ID3D11Buffer*           m_pD3DVertexBuffer;
+    ID3D11Buffer*           m_pD3DVertexBuffer;     // 毎フレームの描画ごとの変換を書き込む動的バッファ (インスタンスデータ).
+    ID3D11Buffer*           m_pD3DTriangleBuffer;   // 三角形の頂点データ. 回転は描画ごとの変換で行うので書き換えない.
     D3D_FEATURE_LEVEL       m_FeatureLevel;
     D3D11_VIEWPORT          m_Viewport;
 
@@ -92,6 +207,94 @@ private:
     IDXGISwapChain*         m_pDXGISwapChain;
     IDXGIDevice*            m_pDXGIDevice;
 
+    // Recording
+    FrameRecorder           m_Recorder;
+    std::string             m_RecordPath;
+    ID3D11Texture2D*        m_pD3DCaptureTexture[CaptureLatency];
+    UINT                    m_CaptureWidth;
+    UINT                    m_CaptureHeight;
+    UINT                    m_CaptureHead;      // 次にコピーするスロット.
+    UINT                    m_CapturePending;   // 読み戻し待ちのスロット数.
+
+    // Multi Surface
+    ThreadPool              m_ThreadPool;
+    SurfaceGroup            m_SurfaceGroup;
+    UINT                    m_SurfaceCount;
+    UINT                    m_ThreadCount;
+    bool                    m_SurfaceBenchmark;
+    UINT                    m_FrameIndex;
+    UINT                    m_StatFrames;
+    Timer                   m_StatTimer;
+
+    // Frame Pacing
+    FramePacer              m_FramePacer;
+    double                  m_TargetFrameRate;
+    UINT                    m_SyncInterval;
+    UINT                    m_BackBufferCount;
+
+    // Input Latency
+    InputLatencyTracker     m_InputTracker;
+    SyntheticInputGenerator m_InputGenerator;
+    double                  m_SyntheticInputRate;
+
+    // Vector Shapes
+    GeometryCache           m_GeometryCache;
+    std::vector<ShapeItem>  m_Shapes;
+    UINT                    m_ShapeCount;
+    bool                    m_ShapeCacheEnabled;
+
+    // Sprites
+    SpriteBatch             m_SpriteBatch;
+    SpriteRenderer          m_SpriteRenderer;
+    std::vector<SpriteItem> m_Sprites;
+    UINT                    m_SpriteCount;
+
+    // Scene Graph
+    SceneGraph                  m_Scene;
+    std::vector<SceneNodeId>    m_SceneNodes;
+    std::vector<SceneNodeId>    m_SceneVisible;
+    UINT                        m_SceneNodeCount;
+    UINT                        m_SceneSeed;
+    SpatialIndex                m_SceneIndex;       // 項目のワールド空間の範囲 (ヒットテスト用).
+    std::vector<SpatialHandle>  m_SceneHandles;     // m_SceneNodes と同じ順. 項目以外は無効値.
+    std::vector<UINT>           m_SceneMoved;       // 今フレームで変換行列を変更したノードの配列位置.
+    std::vector<uint32_t>       m_SceneHits;
+
+    // Log View
+    FontFace                m_LogFont;
+    TextBuffer              m_LogBuffer;
+    TextView                m_LogView;
+    Surface                 m_LogSurface;       // TextView の描画先 (ウィンドウと同じサイズ).
+    ID2D1Bitmap1*           m_pLogBitmap;       // 今フレームのログ表示. レンダーグラフの一時テクスチャが所有する.
+    std::string             m_LogPath;
+    std::string             m_LogFontPath;
+
+    // Startup
+    InitGraph               m_InitGraph;
+    Timer                   m_StartupTimer;
+    double                  m_FirstFrameMsec;   // Init() の開始から最初の Present() までの時間.
+    bool                    m_ParallelInit;
+
+    // Vertex Streaming
+    D3D11GpuFence           m_D3DFence;
+    RingBuffer              m_VertexRing;       // m_pD3DVertexBuffer の領域をフレームごとに割り当てる.
+    std::vector<DrawTransform>  m_DrawTransforms;   // 今フレームの描画ごとの変換. 0 番は三角形, 以降は形状.
+
+    // State Cache
+    D3D11RenderContext      m_RenderContext;
+    StateCache              m_StateCache;       // 冗長なステート設定を省いてデバイスコンテキストに発行する.
+    UINT                    m_SimplePipeline;
+    bool                    m_StateCacheEnabled;
+
+    // Render Graph
+    RenderGraph             m_RenderGraph;      // 毎フレーム組み立て直す描画パスの依存グラフ.
+    bool                    m_RenderGraphFailed;    // コンパイルに失敗した後はリサイズまで固定の順序で描画する.
+
+    // Resource Memory
+    ResourceTracker         m_ResourceTracker;
+    UINT64                  m_MemoryBudget;     // 0 の場合は無制限.
+    UINT                    m_ResizeTestCycles;
+
     //=============================================================================================
     // private methods.
     //=============================================================================================
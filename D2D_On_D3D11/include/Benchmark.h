@@ -0,0 +1,22 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Benchmark.h
+// Desc : Headless Benchmarks.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      名前を指定してベンチマークを実行します. ウィンドウやデバイスは生成しません.
+//!
+//! @param[in]      name        ベンチマーク名です. nullptr または "list" の場合は一覧を表示します.
+//! @param[in]      argc        ベンチマークに渡す引数の数です.
+//! @param[in]      argv        ベンチマークに渡す引数です (フォントファイルのパスなど).
+//! @retval true    実行に成功しました.
+//! @retval false   該当するベンチマークが無いか, 実行に失敗しました.
+//-------------------------------------------------------------------------------------------------
+bool RunBenchmark( const char* name, int argc = 0, char** argv = nullptr );
+
+#endif//__BENCHMARK_H__
@@ -0,0 +1,123 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Blur.h
+// Desc : Gaussian Blur and Drop Shadow Effect.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __BLUR_H__
+#define __BLUR_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <Surface.h>
+#include <ThreadPool.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BLUR_MODE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum BLUR_MODE
+{
+    BLUR_MODE_AUTO = 0,         //!< 半径に応じてガウスカーネルとボックス近似を切り替えます.
+    BLUR_MODE_GAUSSIAN,         //!< 分離可能なガウスカーネルを使います.
+    BLUR_MODE_BOX,              //!< 3回のボックスブラーでガウスを近似します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BlurEffect class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class BlurEffect
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    ApplyCount;         //!< Apply 呼び出し回数です.
+        uint64_t    CacheHitCount;      //!< 入力が変化しておらず再計算を省略した回数です.
+        double      HashMsec;           //!< 入力のハッシュ計算にかかった合計時間 (ミリ秒) です.
+        double      ProcessMsec;        //!< ブラーと合成にかかった合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   GaussianRadiusLimit = 8;    // BLUR_MODE_AUTO でガウスカーネルを使う最大半径.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    BlurEffect();
+    ~BlurEffect();
+
+    void            SetThreadPool( ThreadPool* pPool );
+    void            SetMode( BLUR_MODE mode );
+    const Surface*  ApplyBlur  ( const Surface& source, float radius );
+    const Surface*  ApplyShadow( const Surface& source, float radius, const float color[4], int offsetX, int offsetY );
+    void            Invalidate();
+    Stats           GetStats() const;
+    void            ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Key structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Key
+    {
+        uint64_t    Hash;               //!< 入力画素とパラメータのハッシュです.
+        uint32_t    Width;              //!< 入力の横幅です.
+        uint32_t    Height;             //!< 入力の縦幅です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    ThreadPool*             m_pPool;
+    BLUR_MODE               m_Mode;
+    Surface                 m_Output;
+    Surface                 m_Temp[2];          // [1] は転置した大きさで使います.
+    std::vector<uint16_t>   m_Kernel;           // 16bit 固定小数のガウス重み.
+    std::vector<uint32_t>   m_Scratch;          // ボックスブラーの短冊ごとの作業領域.
+    std::vector<uint64_t>   m_RowHash;
+    Key                     m_Key;
+    bool                    m_KeyValid;
+    Stats                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool    CheckCache  ( const Surface& source, const void* pParams, size_t paramSize );
+    void    Blur        ( const Surface& source, float radius, Surface& dest );
+    void    GaussianH   ( const Surface& source, Surface& dest, int radius );
+    void    GaussianV   ( const Surface& source, Surface& dest, int radius );
+    void    BoxV        ( const Surface& source, Surface& dest, const int radii[3] );
+    void    Transpose   ( const Surface& source, Surface& dest );
+    void    Dispatch    ( uint32_t count, const std::function<void(uint32_t)>& task );
+
+    BlurEffect              ( const BlurEffect& );  // アクセス禁止.
+    BlurEffect& operator =  ( const BlurEffect& );  // アクセス禁止.
+};
+
+#endif//__BLUR_H__
@@ -0,0 +1,263 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : BoundedQueue.h
+// Desc : Bounded Blocking Queue.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __BOUNDED_QUEUE_H__
+#define __BOUNDED_QUEUE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <Timer.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BoundedQueue class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class BoundedQueue
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    PushCount;          //!< 投入回数です.
+        uint64_t    DepthSum;           //!< 投入時のキュー長の累計です.
+        size_t      MaxDepth;           //!< 最大キュー長です.
+        uint64_t    BlockedCount;       //!< 満杯のため待機した回数です.
+        int64_t     BlockedTicks;       //!< 満杯のため待機した合計ティック数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //---------------------------------------------------------------------------------------------
+    explicit BoundedQueue( size_t capacity )
+    : m_Items   ( ( capacity > 0 ) ? capacity : 1 )
+    , m_Head    ( 0 )
+    , m_Count   ( 0 )
+    , m_Closed  ( false )
+    { ResetStats(); }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      要素を追加します. 満杯の場合は空きができるまで待機します.
+    //!
+    //! @retval true    追加に成功.
+    //! @retval false   キューが閉じられています.
+    //---------------------------------------------------------------------------------------------
+    bool Push( const T& value )
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+
+        if ( !m_Closed && m_Count == m_Items.size() )
+        {
+            const int64_t begin = Timer::GetTicks();
+            m_NotFull.wait( lock, [this] { return m_Closed || m_Count < m_Items.size(); } );
+            m_Stats.BlockedCount++;
+            m_Stats.BlockedTicks += Timer::GetTicks() - begin;
+        }
+
+        if ( m_Closed )
+        { return false; }
+
+        Enqueue( value );
+        lock.unlock();
+        m_NotEmpty.notify_one();
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      要素の追加を試みます. 満杯の場合は待機せずに失敗します.
+    //---------------------------------------------------------------------------------------------
+    bool TryPush( const T& value )
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+
+        if ( m_Closed || m_Count == m_Items.size() )
+        { return false; }
+
+        Enqueue( value );
+        lock.unlock();
+        m_NotEmpty.notify_one();
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      要素を取り出します. 空の場合は要素が追加されるまで待機します.
+    //!
+    //! @retval true    取り出しに成功.
+    //! @retval false   キューが閉じられ, かつ空になっています.
+    //---------------------------------------------------------------------------------------------
+    bool Pop( T& value )
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+        m_NotEmpty.wait( lock, [this] { return m_Closed || m_Count > 0; } );
+
+        if ( m_Count == 0 )
+        { return false; }
+
+        Dequeue( value );
+        lock.unlock();
+        m_NotFull.notify_one();
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      要素の取り出しを試みます. 空の場合は待機せずに失敗します.
+    //---------------------------------------------------------------------------------------------
+    bool TryPop( T& value )
+    {
+        std::unique_lock<std::mutex> lock( m_Mutex );
+
+        if ( m_Count == 0 )
+        { return false; }
+
+        Dequeue( value );
+        lock.unlock();
+        m_NotFull.notify_one();
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      キューを閉じます. 待機中のスレッドは全て起床します.
+    //---------------------------------------------------------------------------------------------
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_Closed = true;
+        }
+        m_NotEmpty.notify_all();
+        m_NotFull.notify_all();
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      最大要素数を指定してキューを再び開きます. 残っている要素は破棄されます.
+    //---------------------------------------------------------------------------------------------
+    void Reopen( size_t capacity )
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Items.assign( ( capacity > 0 ) ? capacity : 1, T() );
+        m_Head   = 0;
+        m_Count  = 0;
+        m_Closed = false;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      現在の要素数を取得します.
+    //---------------------------------------------------------------------------------------------
+    size_t GetCount() const
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        return m_Count;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      最大要素数を取得します.
+    //---------------------------------------------------------------------------------------------
+    size_t GetCapacity() const
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        return m_Items.size();
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //---------------------------------------------------------------------------------------------
+    Stats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        return m_Stats;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      統計情報をリセットします.
+    //---------------------------------------------------------------------------------------------
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Stats.PushCount    = 0;
+        m_Stats.DepthSum     = 0;
+        m_Stats.MaxDepth     = 0;
+        m_Stats.BlockedCount = 0;
+        m_Stats.BlockedTicks = 0;
+    }
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<T>              m_Items;
+    size_t                      m_Head;
+    size_t                      m_Count;
+    bool                        m_Closed;
+    Stats                       m_Stats;
+    mutable std::mutex          m_Mutex;
+    std::condition_variable     m_NotEmpty;
+    std::condition_variable     m_NotFull;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      ロック取得済みの状態で末尾に追加します.
+    //---------------------------------------------------------------------------------------------
+    void Enqueue( const T& value )
+    {
+        m_Items[ ( m_Head + m_Count ) % m_Items.size() ] = value;
+        m_Count++;
+
+        m_Stats.PushCount++;
+        m_Stats.DepthSum += m_Count;
+        if ( m_Count > m_Stats.MaxDepth )
+        { m_Stats.MaxDepth = m_Count; }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      ロック取得済みの状態で先頭から取り出します.
+    //---------------------------------------------------------------------------------------------
+    void Dequeue( T& value )
+    {
+        value  = m_Items[ m_Head ];
+        m_Head = ( m_Head + 1 ) % m_Items.size();
+        m_Count--;
+    }
+
+    BoundedQueue            ( const BoundedQueue& );    // アクセス禁止.
+    BoundedQueue& operator= ( const BoundedQueue& );    // アクセス禁止.
+};
+
+#endif//__BOUNDED_QUEUE_H__
@@ -0,0 +1,168 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ClipStack.h
+// Desc : Clip and Layer Stack with Scissor Fast Path.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __CLIP_STACK_H__
+#define __CLIP_STACK_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Rect.h>
+#include <Surface.h>
+#include <SurfacePool.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ClipStack class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class ClipStack
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    ClipCount;          //!< クリップを積んだ回数です.
+        uint64_t    ScissorCount;       //!< マスクを作らずシザー矩形だけで処理したクリップ数です.
+        uint64_t    MaskCount;          //!< カバレッジマスクを生成したクリップ数です.
+        uint64_t    MaskAllocCount;     //!< マスク用のメモリを新たに確保した回数です.
+        uint64_t    MaskBytes;          //!< 確保済みのマスク用メモリの合計サイズです.
+        uint64_t    LayerCount;         //!< レイヤーを積んだ回数です.
+        uint32_t    MaxDepth;           //!< スタックの最大深さです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const int    SubSamples = 4;     // マスクのラスタライズで1画素あたりに取る走査線の数.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    ClipStack();
+    ~ClipStack();
+
+    bool        Init( Surface* pTarget, SurfacePool* pPool );
+    void        Term();
+    void        Reset();
+    void        SetScissorFastPath( bool enable );
+    void        SetTransform( const float matrix[6] );
+    void        PushAxisAlignedClip( float left, float top, float right, float bottom );
+    void        PushPolygonClip( const float* pPoints, uint32_t count );
+    void        PopClip();
+    bool        PushLayer( float opacity );
+    void        PopLayer();
+    void        FillRect ( const ClipRect& rect, uint32_t color );
+    void        BlendSpan( int x, int y, uint32_t count, const uint32_t* pSrc );
+    ClipRect    GetScissor() const;
+    uint32_t    GetDepth() const;
+    Stats       GetStats() const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // ENTRY_TYPE enum
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    enum ENTRY_TYPE
+    {
+        ENTRY_TYPE_CLIP = 0,        //!< クリップです.
+        ENTRY_TYPE_LAYER,           //!< レイヤーです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Mask structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Mask
+    {
+        ClipRect                Bounds;     //!< デバイス座標での範囲です.
+        std::vector<uint8_t>    Coverage;   //!< 範囲内の 8bit カバレッジです.
+
+        const uint8_t* GetRow( int y ) const
+        { return &Coverage[size_t( y - Bounds.Top ) * size_t( Bounds.Right - Bounds.Left )]; }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Crossing structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Crossing
+    {
+        float       X;              //!< 走査線と辺が交わる x 座標です.
+        int         Winding;        //!< 辺の向き (+1 または -1) です.
+
+        bool operator < ( const Crossing& value ) const
+        { return X < value.X; }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        ENTRY_TYPE  Type;           //!< 種別です.
+        ClipRect    Scissor;        //!< 積む前のシザー矩形です.
+        Mask*       pMask;          //!< 積む前のマスクです.
+        bool        OwnsMask;       //!< このエントリでマスクを生成したかどうかです.
+        Surface*    pTarget;        //!< 積む前の描画先です.
+        int         OriginX;        //!< 積む前の描画先の原点です.
+        int         OriginY;        //!< 積む前の描画先の原点です.
+        Surface*    pLayer;         //!< レイヤーのサーフェイスです.
+        float       Opacity;        //!< レイヤーの不透明度です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    Surface*                            m_pSurface;     // 最終的な描画先.
+    SurfacePool*                        m_pPool;
+    Surface*                            m_pTarget;      // 現在の描画先 (レイヤーの場合あり).
+    int                                 m_OriginX;      // 描画先の左上のデバイス座標.
+    int                                 m_OriginY;
+    ClipRect                            m_Scissor;
+    Mask*                               m_pMask;
+    float                               m_Transform[6];
+    bool                                m_FastPath;
+    std::vector<Entry>                  m_Stack;
+    std::vector<std::unique_ptr<Mask>>  m_Masks;        // 確保した全マスク.
+    std::vector<Mask*>                  m_FreeMasks;
+    std::vector<float>                  m_Points;       // デバイス座標に変換した多角形.
+    std::vector<Crossing>               m_Crossings;
+    std::vector<float>                  m_Accum;        // 1行分のカバレッジ (差分配列込み).
+    Stats                               m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    PushEntry   ( ENTRY_TYPE type );
+    void    PushMask    ();
+    Mask*   AcquireMask ( const ClipRect& bounds );
+    void    Rasterize   ( Mask& mask );
+    void    AddSpan     ( float x0, float x1, const ClipRect& bounds );
+
+    ClipStack               ( const ClipStack& );   // アクセス禁止.
+    ClipStack& operator =   ( const ClipStack& );   // アクセス禁止.
+};
+
+#endif//__CLIP_STACK_H__
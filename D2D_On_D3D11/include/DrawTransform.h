@@ -0,0 +1,76 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : DrawTransform.h
+// Desc : Per-Draw Transform and Color Constants.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __DRAW_TRANSFORM_H__
+#define __DRAW_TRANSFORM_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <Tessellator.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// DrawTransform structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct DrawTransform
+{
+    float   Row0[4];        //!< 変換行列の 1 行目です. x' = dot( Row0, float4( x, y, z, 1 ) ).
+    float   Row1[4];        //!< 変換行列の 2 行目です.
+    float   Row2[4];        //!< 変換行列の 3 行目です.
+    float   Color[4];       //!< 頂点カラーに乗算する色です.
+};
+
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      恒等変換と白色を設定します.
+//-------------------------------------------------------------------------------------------------
+void SetIdentityTransform( DrawTransform& result );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      XY 平面の拡大・回転・平行移動を設定します. z は変換しません.
+//!
+//! @param[out]     result      設定先.
+//! @param[in]      x           平行移動量の x 成分.
+//! @param[in]      y           平行移動量の y 成分.
+//! @param[in]      rotation    原点周りの回転角 (ラジアン).
+//! @param[in]      scale       拡大率.
+//! @param[in]      pColor      乗算する色 (RGBA). nullptr なら白です.
+//-------------------------------------------------------------------------------------------------
+void SetDrawTransform(
+    DrawTransform&  result,
+    float           x,
+    float           y,
+    float           rotation,
+    float           scale,
+    const float*    pColor );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      頂点に描画ごとの変換と色を適用します. SimpleVS.hlsl と同じ計算を SSE2 で行い,
+//!             スカラー版と同じ結果になります.
+//!
+//! @param[in]      pSrc        変換元の頂点.
+//! @param[in]      count       頂点数.
+//! @param[in]      transform   適用する変換と色.
+//! @param[out]     pDst        変換先の頂点. pSrc と同じでも構いません.
+//-------------------------------------------------------------------------------------------------
+void TransformVertices(
+    const MeshVertex*       pSrc,
+    size_t                  count,
+    const DrawTransform&    transform,
+    MeshVertex*             pDst );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      TransformVertices() のスカラー版です. 検証用に公開しています.
+//-------------------------------------------------------------------------------------------------
+void TransformVertices_Scalar(
+    const MeshVertex*       pSrc,
+    size_t                  count,
+    const DrawTransform&    transform,
+    MeshVertex*             pDst );
+
+#endif//__DRAW_TRANSFORM_H__
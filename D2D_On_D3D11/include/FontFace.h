@@ -0,0 +1,181 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FontFace.h
+// Desc : TrueType / OpenType Font Face.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __FONT_FACE_H__
+#define __FONT_FACE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <MappedFile.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GLYPH_COMMAND enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum GLYPH_COMMAND
+{
+    GLYPH_COMMAND_MOVE_TO = 0,          //!< 輪郭を開始します (点 1 つ). 前の輪郭は閉じたものとして扱います.
+    GLYPH_COMMAND_LINE_TO,              //!< 直線です (点 1 つ).
+    GLYPH_COMMAND_QUAD_TO,              //!< 2 次ベジェ曲線です (点 2 つ).
+    GLYPH_COMMAND_CUBIC_TO,             //!< 3 次ベジェ曲線です (点 3 つ).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GlyphOutline structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct GlyphOutline
+{
+    std::vector<uint8_t>    Commands;   //!< GLYPH_COMMAND の列です.
+    std::vector<float>      Points;     //!< 各コマンドの点 (x, y) の列です. フォント単位で y は上向きです.
+
+    void Clear()
+    {
+        Commands.clear();
+        Points  .clear();
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FontMetrics structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct FontMetrics
+{
+    uint32_t    UnitsPerEm;             //!< 1em あたりのフォント単位数です.
+    int32_t     Ascender;               //!< ベースラインから上端までの距離です.
+    int32_t     Descender;              //!< ベースラインから下端までの距離です (負の値).
+    int32_t     LineGap;                //!< 行間です.
+    uint32_t    GlyphCount;             //!< グリフ数です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FontFace class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class FontFace
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    FontFace();
+    ~FontFace();
+
+    bool        Init( const char* path, uint32_t faceIndex = 0 );
+    void        Term();
+    bool        IsValid() const;
+    bool        IsCFF  () const;
+
+    uint32_t    GetGlyphIndex( uint32_t codePoint ) const;
+    bool        GetOutline   ( uint32_t glyph, GlyphOutline& outline ) const;
+    uint32_t    GetAdvance   ( uint32_t glyph ) const;
+    FontMetrics GetMetrics   () const;
+    size_t      GetMemoryUsage() const;
+    size_t      GetFileSize   () const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // TableRange structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct TableRange
+    {
+        uint32_t    Offset;             //!< ファイル先頭からの位置です.
+        uint32_t    Length;             //!< 長さです. テーブルが無い場合は 0 です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // CffIndex structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct CffIndex
+    {
+        uint32_t    Count;              //!< 要素数です.
+        uint32_t    OffsetPos;          //!< オフセット配列のファイル先頭からの位置です.
+        uint32_t    DataPos;            //!< データ領域の位置から 1 を引いた値です (オフセットは 1 始まり).
+        uint32_t    OffSize;            //!< オフセット 1 つのバイト数です.
+        uint32_t    End;                //!< INDEX 全体の終端の位置です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // CharStringState structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct CharStringState
+    {
+        float           Stack[48];      //!< 引数スタックです.
+        uint32_t        Count;          //!< 引数の数です.
+        uint32_t        Stems;          //!< ステムヒントの数です (hintmask の長さの決定に使います).
+        float           X;              //!< 現在の X 座標です.
+        float           Y;              //!< 現在の Y 座標です.
+        bool            Ended;          //!< endchar を処理したかどうかです.
+        const CffIndex* pLocalSubrs;    //!< ローカルサブルーチンです.
+        GlyphOutline*   pOutline;       //!< 出力先です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    MappedFile              m_File;
+    const uint8_t*          m_pData;
+    uint32_t                m_Size;
+    TableRange              m_Head;
+    TableRange              m_Hhea;
+    TableRange              m_Hmtx;
+    TableRange              m_Loca;
+    TableRange              m_Glyf;
+    TableRange              m_Cff;
+    uint32_t                m_CmapPos;          // 使用する cmap サブテーブルの位置. 無い場合は 0.
+    uint32_t                m_CmapFormat;
+    FontMetrics             m_Metrics;
+    uint32_t                m_MetricCount;      // hmtx の advanceWidth の数.
+    uint32_t                m_LocaFormat;
+    CffIndex                m_CharStrings;
+    CffIndex                m_GlobalSubrs;
+    std::vector<CffIndex>   m_LocalSubrs;       // Font DICT ごとのローカルサブルーチン (CID でなければ 1 つ).
+    uint32_t                m_FDSelectPos;      // CID フォントの FDSelect の位置. 無い場合は 0.
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool        ParseTables   ( uint32_t faceIndex );
+    bool        ParseCmap     ( const TableRange& cmap );
+    bool        ParseCff      ();
+    bool        ReadIndex     ( uint32_t pos, CffIndex& index ) const;
+    bool        GetIndexItem  ( const CffIndex& index, uint32_t item, uint32_t& begin, uint32_t& end ) const;
+    bool        ReadPrivateSubrs( uint32_t dictBegin, uint32_t dictEnd, CffIndex& subrs ) const;
+    uint32_t    GetFontDict   ( uint32_t glyph ) const;
+    bool        DecodeGlyf    ( uint32_t glyph, const float matrix[6], uint32_t depth, GlyphOutline& outline ) const;
+    bool        DecodeCff     ( uint32_t glyph, GlyphOutline& outline ) const;
+    bool        RunCharString ( uint32_t begin, uint32_t end, uint32_t depth, CharStringState& state ) const;
+
+    FontFace             ( const FontFace& );   // アクセス禁止.
+    FontFace& operator = ( const FontFace& );   // アクセス禁止.
+};
+
+#endif//__FONT_FACE_H__
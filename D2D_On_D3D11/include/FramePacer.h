@@ -0,0 +1,170 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FramePacer.h
+// Desc : Frame Rate Limiter and Pacing Controller.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FrameClock class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class FrameClock
+{
+public:
+    virtual ~FrameClock() { /* DO_NOTHING */ }
+
+    //! @brief      現在時刻をティック単位で取得します.
+    virtual int64_t GetTicks() = 0;
+
+    //! @brief      1秒あたりのティック数を取得します.
+    virtual int64_t GetTicksPerSec() = 0;
+
+    //! @brief      指定ティック数だけスリープします. 実際には長めに眠ることがあります.
+    virtual void    SleepFor( int64_t ticks ) = 0;
+
+    //! @brief      スピン待機の1回分を実行します.
+    virtual void    Spin() = 0;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SystemFrameClock class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SystemFrameClock : public FrameClock
+{
+public:
+    SystemFrameClock();
+    virtual ~SystemFrameClock();
+
+    virtual int64_t GetTicks() override;
+    virtual int64_t GetTicksPerSec() override;
+    virtual void    SleepFor( int64_t ticks ) override;
+    virtual void    Spin() override;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SimulatedFrameClock class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SimulatedFrameClock : public FrameClock
+{
+public:
+    SimulatedFrameClock( int64_t ticksPerSec, int64_t sleepOvershoot, int64_t spinCost );
+    virtual ~SimulatedFrameClock();
+
+    virtual int64_t GetTicks() override;
+    virtual int64_t GetTicksPerSec() override;
+    virtual void    SleepFor( int64_t ticks ) override;
+    virtual void    Spin() override;
+
+    void    Advance( int64_t ticks );
+    void    SetSleepOvershoot( int64_t ticks );
+
+private:
+    int64_t     m_Now;
+    int64_t     m_TicksPerSec;
+    int64_t     m_SleepOvershoot;   // SleepFor() が余分に眠るティック数.
+    int64_t     m_SpinCost;         // Spin() 1回で進むティック数.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    FrameCount;             //!< 計測したフレーム数です.
+        uint64_t    MissedDeadlines;        //!< 表示期限に間に合わなかったフレーム数です.
+        double      MeanFrameMsec;          //!< 表示間隔の平均 (ミリ秒) です.
+        double      FrameVarianceMsec2;     //!< 表示間隔の分散 (ミリ秒^2) です.
+        double      MaxLatenessMsec;        //!< 表示期限からの最大遅れ (ミリ秒) です.
+        double      PredictedRenderMsec;    //!< 現在の描画時間の予測値 (ミリ秒) です.
+        double      OversleepMsec;          //!< スリープの寝過ごし量の推定値 (ミリ秒) です.
+        double      SleepMsec;              //!< スリープで待機した合計時間 (ミリ秒) です.
+        double      SpinMsec;               //!< スピンで待機した合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    explicit FramePacer( FrameClock* pClock = nullptr );
+    ~FramePacer();
+
+    void    SetTargetRate( double framesPerSec );
+    void    SetSafetyMargin( double msec );
+    void    BeginFrame();
+    void    EndFrame();
+    void    Resync();
+    Stats   GetStats() const;
+    void    ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    FrameClock*         m_pClock;
+    SystemFrameClock*   m_pSystemClock;     // クロックが指定されなかった場合のみ生成する.
+    double              m_TicksPerMsec;
+    int64_t             m_Period;           // 0 の場合は制限なし.
+    int64_t             m_SafetyMargin;
+    int64_t             m_Deadline;         // 次フレームの表示期限. 0 は未設定.
+    int64_t             m_FrameBegin;
+    int64_t             m_LastPresent;
+    double              m_RenderMean;       // 描画時間の指数移動平均.
+    double              m_RenderVar;        // 描画時間の指数移動分散.
+    double              m_Oversleep;        // スリープの寝過ごし量の推定値.
+
+    uint64_t            m_FrameCount;
+    uint64_t            m_MissedCount;
+    double              m_IntervalMean;     // Welford 法による平均.
+    double              m_IntervalM2;       // Welford 法による二乗偏差和.
+    int64_t             m_MaxLateness;
+    int64_t             m_SleepTicks;
+    int64_t             m_SpinTicks;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    WaitUntil( int64_t target );
+    int64_t PredictRenderTicks() const;
+
+    FramePacer              ( const FramePacer& );      // アクセス禁止.
+    FramePacer& operator =  ( const FramePacer& );      // アクセス禁止.
+};
+
+#endif//__FRAME_PACER_H__
@@ -0,0 +1,117 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FrameRecorder.h
+// Desc : Y4M Frame Recorder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __FRAME_RECORDER_H__
+#define __FRAME_RECORDER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <BoundedQueue.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FrameRecorder class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class FrameRecorder
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    SubmittedFrames;    //!< 投入されたフレーム数です.
+        uint64_t    WrittenFrames;      //!< 書き出したフレーム数です.
+        double      ConvertNsPerPixel;  //!< 1画素あたりの平均変換時間 (ナノ秒) です.
+        double      AvgQueueDepth;      //!< 投入時の平均キュー長です.
+        size_t      MaxQueueDepth;      //!< 最大キュー長です.
+        uint64_t    BlockedFrames;      //!< バッファ待ちで描画スレッドが停止したフレーム数です.
+        double      BlockedMsec;        //!< 描画スレッドの停止時間の合計 (ミリ秒) です.
+        bool        WriteFailed;        //!< ファイルへの書き出しに失敗したかどうかです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    FrameRecorder();
+    ~FrameRecorder();
+
+    bool    Open( const char* path, uint32_t width, uint32_t height, uint32_t fps, uint32_t queueDepth = 4 );
+    void    Close();
+    bool    PushFrame( const uint8_t* pBGRA, uint32_t pitch, uint32_t width, uint32_t height );
+    bool    IsOpen() const;
+    bool    IsFailed() const;
+    Stats   GetStats() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Frame structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Frame
+    {
+        std::vector<uint8_t>    BGRA;   //!< 変換前の画素データです.
+        std::vector<uint8_t>    YUV;    //!< 変換後の画素データです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    FILE*                       m_pFile;
+    uint32_t                    m_Width;
+    uint32_t                    m_Height;
+    std::vector<Frame>          m_Frames;
+    BoundedQueue<Frame*>        m_FreeQueue;        // 描画スレッドが取得する空きバッファ.
+    BoundedQueue<Frame*>        m_ConvertQueue;     // 変換待ちのフレーム.
+    BoundedQueue<Frame*>        m_WriteQueue;       // 書き出し待ちのフレーム.
+    std::thread                 m_ConvertThread;
+    std::thread                 m_WriteThread;
+    uint64_t                    m_SubmittedFrames;
+    uint64_t                    m_BlockedFrames;
+    int64_t                     m_BlockedTicks;
+    std::atomic<uint64_t>       m_WrittenFrames;
+    std::atomic<int64_t>        m_ConvertTicks;
+    std::atomic<uint64_t>       m_ConvertPixels;
+    std::atomic<bool>           m_WriteFailed;      // 書き出しに失敗したら以降のフレームは受け付けない.
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void ConvertProc();
+    void WriteProc();
+    void SetWriteFailed( const char* what );
+
+    FrameRecorder           ( const FrameRecorder& );   // アクセス禁止.
+    FrameRecorder& operator=( const FrameRecorder& );   // アクセス禁止.
+};
+
+#endif//__FRAME_RECORDER_H__
@@ -0,0 +1,142 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : GeometryCache.h
+// Desc : Tessellated Geometry Realization Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __GEOMETRY_CACHE_H__
+#define __GEOMETRY_CACHE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <d3d11.h>
+#include <map>
+#include <vector>
+#include <Tessellator.h>
+#include <ResourceTracker.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GeometryMesh structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct GeometryMesh
+{
+    ID3D11Buffer*   pVertexBuffer;      //!< MeshVertex の頂点バッファです. 空の形状では nullptr です.
+    UINT            VertexCount;        //!< 頂点数です (三角形リスト).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GeometryCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class GeometryCache
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        UINT64      HitCount;           //!< キャッシュヒット数です.
+        UINT64      MissCount;          //!< テッセレーションした回数です.
+        UINT64      EvictCount;         //!< 容量超過で破棄したエントリ数です.
+        UINT64      TessellatedVertices;//!< テッセレーションで生成した頂点の総数です.
+        double      TessellateMsec;     //!< テッセレーションにかかった合計時間 (ミリ秒) です.
+        double      UploadMsec;         //!< 頂点バッファの生成にかかった合計時間 (ミリ秒) です.
+        UINT        EntryCount;         //!< 現在のエントリ数です.
+        UINT64      BufferBytes;        //!< 現在の頂点バッファの合計サイズです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    GeometryCache();
+    ~GeometryCache();
+
+    bool    Init( ID3D11Device* pDevice, UINT64 budgetBytes = 32 * 1024 * 1024, ResourceTracker* pTracker = nullptr );
+    void    Term();
+    void    SetEnabled( bool enable );
+    bool    IsEnabled() const;
+    bool    GetFill  ( const Path& path, FILL_RULE rule, float scale, const float color[4], GeometryMesh& result );
+    bool    GetStroke( const Path& path, const StrokeStyle& style, float scale, const float color[4], GeometryMesh& result );
+    void    EndFrame();
+    void    Trim    ( UINT64 targetBytes );
+    Stats   GetStats() const;
+    void    ResetStats();
+
+    static int      GetScaleBand ( float scale );
+    static float    GetBandScale ( int band );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Key structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Key
+    {
+        UINT64      Hash;               //!< 形状, スタイル, 色を合わせたハッシュです.
+        int         Band;               //!< スケール帯です.
+
+        bool operator < ( const Key& value ) const
+        { return ( Hash < value.Hash ) || ( Hash == value.Hash && Band < value.Band ); }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        GeometryMesh    Mesh;           //!< 生成済みのメッシュです.
+        UINT            Bytes;          //!< 頂点バッファのサイズです.
+        UINT64          LastFrame;      //!< 最後に使用したフレーム番号です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    ID3D11Device*               m_pDevice;
+    ResourceTracker*            m_pTracker;     // 頂点バッファの使用量の登録先 (nullptr 可).
+    Tessellator                 m_Tessellator;
+    std::map<Key, Entry>        m_Entries;
+    std::vector<MeshVertex>     m_Vertices;
+    std::vector<ID3D11Buffer*>  m_Transient;    // キャッシュ無効時にフレーム末で解放するバッファ.
+    UINT64                      m_BudgetBytes;
+    UINT64                      m_BufferBytes;
+    UINT64                      m_FrameIndex;
+    bool                        m_Enabled;
+    Stats                       m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool    Find   ( const Key& key, GeometryMesh& result );
+    bool    Realize( const Key& key, GeometryMesh& result );
+    void    Evict  ( UINT64 limitBytes );
+    void    Release( ID3D11Buffer*& pBuffer );
+
+    GeometryCache           ( const GeometryCache& );   // アクセス禁止.
+    GeometryCache& operator=( const GeometryCache& );   // アクセス禁止.
+};
+
+#endif//__GEOMETRY_CACHE_H__
@@ -0,0 +1,87 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : GlyphRasterizer.h
+// Desc : Analytic Coverage Glyph Rasterizer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __GLYPH_RASTERIZER_H__
+#define __GLYPH_RASTERIZER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <FontFace.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GlyphBitmap structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct GlyphBitmap
+{
+    int                     Left;       //!< ペン位置からビットマップ左端までの距離 (ピクセル) です.
+    int                     Top;        //!< ベースラインからビットマップ上端までの距離 (ピクセル, 下向き正) です.
+    uint32_t                Width;      //!< 横幅です.
+    uint32_t                Height;     //!< 縦幅です.
+    std::vector<uint8_t>    Pixels;     //!< A8 のカバレッジです (行ピッチは Width).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GlyphRasterizer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class GlyphRasterizer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MaxBitmapSize = 4096;   // ビットマップの一辺の最大値.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    GlyphRasterizer();
+    ~GlyphRasterizer();
+
+    bool    Rasterize( const GlyphOutline& outline, float scale, float offsetX, float offsetY, GlyphBitmap& bitmap );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<float>  m_Accumulation;     // 行ごとの符号付き面積 (行ピッチは m_Stride).
+    std::vector<float>  m_Points;           // ピクセル座標に変換した点.
+    uint32_t            m_Stride;
+    uint32_t            m_Width;
+    uint32_t            m_Height;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    DrawLine ( float x0, float y0, float x1, float y1 );
+    void    DrawQuad ( const float* p0, const float* p1, const float* p2 );
+    void    DrawCubic( const float* p0, const float* p1, const float* p2, const float* p3 );
+
+    GlyphRasterizer             ( const GlyphRasterizer& );     // アクセス禁止.
+    GlyphRasterizer& operator = ( const GlyphRasterizer& );     // アクセス禁止.
+};
+
+#endif//__GLYPH_RASTERIZER_H__
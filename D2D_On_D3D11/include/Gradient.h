@@ -0,0 +1,171 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Gradient.h
+// Desc : Gradient Brush Span Generators.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __GRADIENT_H__
+#define __GRADIENT_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <Surface.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// EXTEND_MODE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum EXTEND_MODE
+{
+    EXTEND_MODE_CLAMP = 0,      //!< 端の色を延長します.
+    EXTEND_MODE_WRAP,           //!< 繰り返します.
+    EXTEND_MODE_MIRROR,         //!< 折り返しながら繰り返します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GradientStop structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct GradientStop
+{
+    float   Position;           //!< 位置 [0, 1] です.
+    float   Color[4];           //!< ストレートアルファの RGBA です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class GradientBrush
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   LutSize = 256;      // 色テーブルの要素数.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    GradientBrush();
+    virtual ~GradientBrush();
+
+    bool        SetStops( const GradientStop* pStops, uint32_t count );
+    void        SetExtendMode( EXTEND_MODE mode );
+    bool        SetTransform( const float matrix[6] );
+    void        FillRect( Surface& surface, int x0, int y0, int x1, int y1 ) const;
+    void        FillRectReference( Surface& surface, int x0, int y0, int x1, int y1 ) const;
+    void        FillSpanReference( int x, int y, uint32_t count, uint32_t* pDst ) const;
+
+    //! @brief      (x, y) から count 画素分の乗算済み B8G8R8A8 を色テーブルから生成します.
+    virtual void FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const = 0;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    uint32_t                    m_Lut[LutSize];     // 乗算済み B8G8R8A8.
+    std::vector<GradientStop>   m_Stops;
+    EXTEND_MODE                 m_ExtendMode;
+    float                       m_Inverse[6];       // デバイス座標からグラデーション空間への変換.
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    void        MapPoint( float px, float py, float& gx, float& gy ) const;
+    float       ApplyExtend( float t ) const;
+    uint32_t    EvaluateStops( float t ) const;
+
+    //! @brief      グラデーション空間の点からパラメータ t (延長前) を求めます.
+    virtual float ComputeT( float gx, float gy ) const = 0;
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    GradientBrush             ( const GradientBrush& );     // アクセス禁止.
+    GradientBrush& operator = ( const GradientBrush& );     // アクセス禁止.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LinearGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class LinearGradientBrush : public GradientBrush
+{
+public:
+    LinearGradientBrush();
+    virtual ~LinearGradientBrush();
+
+    void            SetPoints( float x0, float y0, float x1, float y1 );
+    virtual void    FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const override;
+
+protected:
+    virtual float   ComputeT( float gx, float gy ) const override;
+
+private:
+    float   m_StartX;
+    float   m_StartY;
+    float   m_DirX;     // (終点 - 始点) / 長さ^2.
+    float   m_DirY;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RadialGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class RadialGradientBrush : public GradientBrush
+{
+public:
+    RadialGradientBrush();
+    virtual ~RadialGradientBrush();
+
+    void            SetEllipse( float centerX, float centerY, float radiusX, float radiusY );
+    virtual void    FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const override;
+
+protected:
+    virtual float   ComputeT( float gx, float gy ) const override;
+
+private:
+    float   m_CenterX;
+    float   m_CenterY;
+    float   m_InvRadiusX;
+    float   m_InvRadiusY;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SweepGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SweepGradientBrush : public GradientBrush
+{
+public:
+    SweepGradientBrush();
+    virtual ~SweepGradientBrush();
+
+    void            SetCenter( float centerX, float centerY, float startAngle );
+    virtual void    FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const override;
+
+protected:
+    virtual float   ComputeT( float gx, float gy ) const override;
+
+private:
+    float   m_CenterX;
+    float   m_CenterY;
+    float   m_StartTurn;    // 開始角度 (1周 = 1.0).
+};
+
+#endif//__GRADIENT_H__
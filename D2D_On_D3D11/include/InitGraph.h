@@ -0,0 +1,138 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : InitGraph.h
+// Desc : Dependency Graph of Initialization Tasks.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __INIT_GRAPH_H__
+#define __INIT_GRAPH_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//-------------------------------------------------------------------------------------------------
+// Forward Declarations.
+//-------------------------------------------------------------------------------------------------
+class ThreadPool;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// INIT_TASK_STATE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum INIT_TASK_STATE
+{
+    INIT_TASK_STATE_PENDING = 0,    //!< 未実行です.
+    INIT_TASK_STATE_DONE,           //!< 成功しました.
+    INIT_TASK_STATE_FAILED,         //!< 失敗しました.
+    INIT_TASK_STATE_SKIPPED,        //!< 他のタスクが失敗したため実行しませんでした.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// InitGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class InitGraph
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Record structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Record
+    {
+        std::string         Name;           //!< タスク名です.
+        INIT_TASK_STATE     State;          //!< 実行結果です.
+        uint32_t            ThreadIndex;    //!< 実行したスレッドの番号です (0 は Run() を呼び出したスレッド).
+        int64_t             ReadyTicks;     //!< 依存するタスクが全て完了した時刻です (Run() の開始からの相対値).
+        int64_t             BeginTicks;     //!< 実行を開始した時刻です.
+        int64_t             EndTicks;       //!< 実行を終了した時刻です.
+        bool                Critical;       //!< クリティカルパス上にあるかどうかです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    typedef std::function<bool()>   Task;
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    InitGraph();
+    ~InitGraph();
+
+    uint32_t    AddTask      ( const char* name, const Task& task, bool mainThread = false );
+    bool        AddDependency( uint32_t task, uint32_t dependsOn );
+    bool        Run          ( ThreadPool* pPool );
+    void        Clear        ();
+
+    uint32_t                GetTaskCount   () const;
+    const Record&           GetRecord      ( uint32_t index ) const;
+    std::vector<uint32_t>   GetCriticalPath() const;
+    double                  GetTotalMsec   () const;
+    void                    PrintTimeline  () const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // TaskInfo structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct TaskInfo
+    {
+        Task                    Func;           //!< 実行する処理です.
+        bool                    MainThread;     //!< Run() を呼び出したスレッドで実行するかどうかです.
+        std::vector<uint32_t>   Dependencies;   //!< 先に完了している必要があるタスクです.
+        std::vector<uint32_t>   Successors;     //!< このタスクの完了を待っているタスクです.
+        uint32_t                Remaining;      //!< 未完了の依存タスク数です.
+        Record                  Result;         //!< 実行記録です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<TaskInfo>           m_Tasks;
+    std::deque<uint32_t>            m_MainQueue;    // 呼び出し元スレッドで実行する準備ができたタスク.
+    std::vector<std::thread::id>    m_ThreadIds;    // 記録用のスレッド番号の対応表.
+    std::mutex                      m_Mutex;
+    std::condition_variable         m_Cond;
+    ThreadPool*                     m_pPool;
+    uint32_t                        m_DoneCount;
+    int64_t                         m_BaseTicks;
+    int64_t                         m_TotalTicks;
+    bool                            m_Failed;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void        Schedule( uint32_t index, int64_t now );
+    void        Execute ( uint32_t index );
+    void        MarkCriticalPath();
+
+    InitGraph             ( const InitGraph& );     // アクセス禁止.
+    InitGraph& operator = ( const InitGraph& );     // アクセス禁止.
+};
+
+#endif//__INIT_GRAPH_H__
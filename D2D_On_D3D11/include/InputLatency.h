@@ -0,0 +1,187 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : InputLatency.h
+// Desc : Input-to-Present Latency Tracker.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __INPUT_LATENCY_H__
+#define __INPUT_LATENCY_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// INPUT_EVENT_TYPE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum INPUT_EVENT_TYPE
+{
+    INPUT_EVENT_KEY = 0,            //!< キー入力です.
+    INPUT_EVENT_MOUSE_MOVE,         //!< マウス移動です.
+    INPUT_EVENT_MOUSE_BUTTON,       //!< マウスボタンです.
+    INPUT_EVENT_MOUSE_WHEEL,        //!< マウスホイールです.
+    INPUT_EVENT_SYNTHETIC,          //!< 合成イベントです.
+    INPUT_EVENT_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LatencyHistogram class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class LatencyHistogram
+{
+public:
+    static const uint32_t   BucketCount = 2000;     // 0.1ms 刻みで 200ms まで.
+    static const uint32_t   BucketUsec  = 100;
+
+    LatencyHistogram();
+    void        AddSample( uint64_t usec );
+    void        Reset();
+    uint64_t    GetCount() const;
+    double      GetMeanMsec() const;
+    double      GetMaxMsec() const;
+    double      GetPercentileMsec( double percentile ) const;
+
+private:
+    uint32_t    m_Buckets[BucketCount + 1];     // 末尾はオーバーフロー用.
+    uint64_t    m_Count;
+    uint64_t    m_SumUsec;
+    uint64_t    m_MaxUsec;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// InputLatencyTracker class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class InputLatencyTracker
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Summary structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Summary
+    {
+        uint64_t    Count;          //!< サンプル数です.
+        double      MeanMsec;       //!< 平均遅延 (ミリ秒) です.
+        double      P50Msec;        //!< 50パーセンタイル (ミリ秒) です.
+        double      P95Msec;        //!< 95パーセンタイル (ミリ秒) です.
+        double      P99Msec;        //!< 99パーセンタイル (ミリ秒) です.
+        double      MaxMsec;        //!< 最大遅延 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    InputLatencyTracker();
+    ~InputLatencyTracker();
+
+    bool        Init( uint32_t capacity = 4096 );
+    void        Term();
+    bool        PushEvent( INPUT_EVENT_TYPE type, int64_t timestamp );
+    void        BeginFrame();
+    void        EndFrame( int64_t presentTicks );
+    Summary     GetSummary( INPUT_EVENT_TYPE type ) const;
+    Summary     GetTotalSummary() const;
+    Summary     GetRecentSummary() const;
+    void        ResetRecent();
+    uint64_t    GetDroppedCount() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Event structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Event
+    {
+        INPUT_EVENT_TYPE    Type;           //!< イベントの種別です.
+        int64_t             Timestamp;      //!< 到着時刻 (ティック) です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Cell structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Cell
+    {
+        std::atomic<size_t>     Sequence;   //!< 書き込み/読み込み可否を表す通し番号です.
+        Event                   Data;       //!< イベントデータです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    Cell*                   m_pCells;
+    size_t                  m_Mask;
+    std::atomic<size_t>     m_EnqueuePos;
+    std::atomic<size_t>     m_DequeuePos;
+    std::atomic<uint64_t>   m_DroppedCount;
+    std::vector<Event>      m_FrameEvents;      // 描画スレッド専用.
+    LatencyHistogram        m_Histograms[INPUT_EVENT_COUNT];
+    LatencyHistogram        m_Total;
+    LatencyHistogram        m_Recent;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool PopEvent( Event& result );
+    static Summary MakeSummary( const LatencyHistogram& histogram );
+
+    InputLatencyTracker             ( const InputLatencyTracker& );     // アクセス禁止.
+    InputLatencyTracker& operator = ( const InputLatencyTracker& );     // アクセス禁止.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SyntheticInputGenerator class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SyntheticInputGenerator
+{
+public:
+    typedef std::function<void( int64_t )>  EmitFunc;     // 引数は発行時刻 (Timer のティック) です.
+
+    SyntheticInputGenerator();
+    ~SyntheticInputGenerator();
+
+    bool        Start( double eventsPerSec, const EmitFunc& emit );
+    void        Stop();
+    uint64_t    GetEmittedCount() const;
+
+private:
+    std::thread             m_Thread;
+    std::atomic<bool>       m_Running;
+    std::atomic<uint64_t>   m_EmittedCount;
+    EmitFunc                m_Emit;
+    double                  m_EventsPerSec;
+
+    void ThreadProc();
+
+    SyntheticInputGenerator             ( const SyntheticInputGenerator& );     // アクセス禁止.
+    SyntheticInputGenerator& operator = ( const SyntheticInputGenerator& );     // アクセス禁止.
+};
+
+#endif//__INPUT_LATENCY_H__
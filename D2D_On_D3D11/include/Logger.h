@@ -0,0 +1,341 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Logger.h
+// Desc : Asynchronous Binary Logger.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __LOGGER_H__
+#define __LOGGER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  LOG_MAX_ARGS    = 8;        // 1 メッセージの引数の最大数.
+const uint32_t  LOG_MAX_STRING  = 255;      // 文字列引数の最大長. 超えた分は切り捨てます.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LOG_LEVEL enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum LOG_LEVEL
+{
+    LOG_LEVEL_DEBUG = 0,        //!< デバッグ用のメッセージです.
+    LOG_LEVEL_INFO,             //!< 情報メッセージです.
+    LOG_LEVEL_ERROR,            //!< エラーメッセージです. ファイル名と行番号を付けて出力します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LOG_ARG_TYPE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum LOG_ARG_TYPE
+{
+    LOG_ARG_TYPE_INT32 = 0,     //!< 32bit 以下の符号付き整数です.
+    LOG_ARG_TYPE_UINT32,        //!< 32bit 以下の符号無し整数です.
+    LOG_ARG_TYPE_INT64,         //!< 64bit 符号付き整数です.
+    LOG_ARG_TYPE_UINT64,        //!< 64bit 符号無し整数です.
+    LOG_ARG_TYPE_DOUBLE,        //!< 浮動小数です.
+    LOG_ARG_TYPE_POINTER,       //!< ポインタです. 値だけを記録します.
+    LOG_ARG_TYPE_STRING,        //!< 文字列です. 内容をコピーして記録します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LogSite structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct LogSite
+{
+    LOG_LEVEL       Level;      //!< ログレベルです.
+    const char*     File;       //!< 呼び出し元のファイル名です.
+    int             Line;       //!< 呼び出し元の行番号です.
+    const char*     Format;     //!< printf 形式の書式文字列です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LogRecord structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct LogRecord
+{
+    uint32_t        Size;                   //!< 引数を含むレコードのバイト数です (8 の倍数).
+    uint32_t        ArgCount;               //!< 引数の数です.
+    const LogSite*  pSite;                  //!< 呼び出し元の情報です. 書式の ID を兼ねます.
+    int64_t         Ticks;                  //!< 書き込んだ時刻です.
+    uint8_t         Types[LOG_MAX_ARGS];    //!< 引数の型 (LOG_ARG_TYPE) です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Logger class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Logger
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    WriteCount;         //!< リングバッファに書き込んだメッセージ数です.
+        uint64_t    DropCount;          //!< リングバッファが満杯で破棄したメッセージ数です.
+        uint64_t    OutputCount;        //!< バックグラウンドスレッドが出力したメッセージ数です.
+        uint64_t    OutputBytes;        //!< 出力した文字列のバイト数です.
+        uint32_t    BufferCount;        //!< 書き込みを行ったスレッド数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    Logger();
+    ~Logger();
+
+    bool    Init      ( FILE* pFile = stderr, uint32_t bufferBytes = 64 * 1024, uint32_t flushMsec = 10 );
+    void    Term      ();
+    void    Flush     ();
+    void    SetLevel  ( LOG_LEVEL level );
+    Stats   GetStats  () const;
+    void    ResetStats();
+
+    static Logger&  GetDefault();
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      書式の ID と引数をそのままスレッドごとのリングバッファに書き込みます.
+    //!             文字列への変換と出力はバックグラウンドスレッドで行います.
+    //!             Init() の前と Term() の後は呼び出したスレッドで直ちに出力します.
+    //---------------------------------------------------------------------------------------------
+    template<typename... Args>
+    void Write( const LogSite* pSite, const Args&... args )
+    {
+        static_assert( sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments." );
+
+        if ( uint32_t( pSite->Level ) < m_Level.load( std::memory_order_relaxed ) )
+        { return; }
+
+        const uint32_t size = uint32_t( sizeof(LogRecord) ) + SizeOfArgs( args... );
+
+        Buffer* pBuffer = nullptr;
+        LogRecord* pRecord = Begin( size, pBuffer );
+        if ( pRecord == nullptr )
+        { return; }
+
+        pRecord->Size     = size;
+        pRecord->ArgCount = uint32_t( sizeof...(Args) );
+        pRecord->pSite    = pSite;
+
+        uint8_t* pArgs = reinterpret_cast<uint8_t*>( pRecord + 1 );
+        EncodeArgs( pRecord->Types, pArgs, args... );
+
+        End( pBuffer, pRecord );
+    }
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    struct Buffer;
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // ArgType structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename T>
+    struct ArgType
+    {
+        static const uint8_t Value =
+            std::is_floating_point<T>::value ? uint8_t( LOG_ARG_TYPE_DOUBLE ) :
+            std::is_pointer<T>::value        ? uint8_t( LOG_ARG_TYPE_POINTER ) :
+            ( std::is_signed<T>::value || std::is_enum<T>::value )
+                ? uint8_t( ( sizeof(T) > 4 ) ? LOG_ARG_TYPE_INT64  : LOG_ARG_TYPE_INT32 )
+                : uint8_t( ( sizeof(T) > 4 ) ? LOG_ARG_TYPE_UINT64 : LOG_ARG_TYPE_UINT32 );
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<Buffer*>        m_Buffers;
+    mutable std::mutex          m_Mutex;
+    std::condition_variable     m_WakeCond;
+    std::condition_variable     m_FlushCond;
+    std::thread                 m_Thread;
+    FILE*                       m_pFile;
+    uint32_t                    m_BufferBytes;
+    uint32_t                    m_FlushMsec;
+    uint32_t                    m_Generation;       // Init() ごとに変わる番号. スレッドごとのキャッシュの判定に使う.
+    uint64_t                    m_FlushRequest;
+    uint64_t                    m_FlushDone;
+    uint64_t                    m_OutputCount;
+    uint64_t                    m_OutputBytes;
+    bool                        m_Exit;
+    std::atomic<bool>           m_Running;
+    std::atomic<uint32_t>       m_Level;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    LogRecord*  Begin     ( uint32_t size, Buffer*& pBuffer );
+    void        End       ( Buffer* pBuffer, LogRecord* pRecord );
+    Buffer*     GetBuffer ();
+    void        ThreadMain();
+    void        Drain     ( const std::vector<Buffer*>& buffers, std::vector<char>& output, uint64_t& count, uint64_t& bytes );
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      文字列引数の長さを求めます.
+    //---------------------------------------------------------------------------------------------
+    static uint32_t StringLength( const char* value )
+    {
+        if ( value == nullptr )
+        { return 0; }
+
+        uint32_t length = 0;
+        while( length < LOG_MAX_STRING && value[length] != '\0' )
+        { length++; }
+
+        return length;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      引数 1 つが使うバイト数を求めます.
+    //---------------------------------------------------------------------------------------------
+    static uint32_t SizeOfArg( const char* value )
+    { return 8 + ( ( StringLength( value ) + 7 ) & ~7u ); }
+
+    static uint32_t SizeOfArg( char* value )
+    { return SizeOfArg( static_cast<const char*>( value ) ); }
+
+    template<typename T>
+    static uint32_t SizeOfArg( T )
+    {
+        static_assert( std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value, "Unsupported log argument type." );
+        return 8;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      全ての引数が使うバイト数を求めます.
+    //---------------------------------------------------------------------------------------------
+    static uint32_t SizeOfArgs()
+    { return 0; }
+
+    template<typename T, typename... Rest>
+    static uint32_t SizeOfArgs( const T& value, const Rest&... rest )
+    { return SizeOfArg( value ) + SizeOfArgs( rest... ); }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      引数 1 つを書き込みます. 文字列は長さの後に内容をコピーします.
+    //---------------------------------------------------------------------------------------------
+    static void EncodeArg( uint8_t& type, uint8_t*& pDst, const char* value )
+    {
+        const uint64_t length = StringLength( value );
+        type = uint8_t( ( value != nullptr ) ? LOG_ARG_TYPE_STRING : LOG_ARG_TYPE_POINTER );
+        memcpy( pDst, &length, sizeof(length) );
+        if ( length > 0 )
+        { memcpy( pDst + 8, value, size_t( length ) ); }
+        pDst += 8 + ( ( length + 7 ) & ~7ull );
+    }
+
+    static void EncodeArg( uint8_t& type, uint8_t*& pDst, char* value )
+    { EncodeArg( type, pDst, static_cast<const char*>( value ) ); }
+
+    template<typename T>
+    static void EncodeArg( uint8_t& type, uint8_t*& pDst, T value )
+    {
+        const uint64_t bits = ToBits( value );
+        type = ArgType<T>::Value;
+        memcpy( pDst, &bits, sizeof(bits) );
+        pDst += 8;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      数値とポインタを 8 バイトの値に変換します. 整数は符号拡張します.
+    //---------------------------------------------------------------------------------------------
+    static uint64_t ToBits( double value )
+    {
+        uint64_t bits;
+        memcpy( &bits, &value, sizeof(bits) );
+        return bits;
+    }
+
+    static uint64_t ToBits( float value )
+    { return ToBits( double( value ) ); }
+
+    static uint64_t ToBits( long double value )
+    { return ToBits( double( value ) ); }
+
+    template<typename T>
+    static uint64_t ToBits( T* value )
+    { return uint64_t( uintptr_t( value ) ); }
+
+    template<typename T>
+    static uint64_t ToBits( T value )
+    { return std::is_signed<T>::value ? uint64_t( int64_t( value ) ) : uint64_t( value ); }
+
+    //---------------------------------------------------------------------------------------------
+    //! @brief      全ての引数を書き込みます.
+    //---------------------------------------------------------------------------------------------
+    static void EncodeArgs( uint8_t*, uint8_t*& )
+    { /* DO_NOTHING */ }
+
+    template<typename T, typename... Rest>
+    static void EncodeArgs( uint8_t* pTypes, uint8_t*& pDst, const T& value, const Rest&... rest )
+    {
+        EncodeArg( pTypes[0], pDst, value );
+        EncodeArgs( pTypes + 1, pDst, rest... );
+    }
+
+    Logger             ( const Logger& );   // アクセス禁止.
+    Logger& operator = ( const Logger& );   // アクセス禁止.
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Macros.
+//-------------------------------------------------------------------------------------------------
+#define LOG_WRITE( level, x, ... )                                                      \
+    do {                                                                                \
+        static const LogSite s_LogSite = { level, __FILE__, __LINE__, x };              \
+        Logger::GetDefault().Write( &s_LogSite, ##__VA_ARGS__ );                        \
+    } while( 0 )
+
+#ifndef ELOG
+#define ELOG( x, ... ) LOG_WRITE( LOG_LEVEL_ERROR, x, ##__VA_ARGS__ )
+#endif//ELOG
+
+#ifndef ILOG
+#define ILOG( x, ... ) LOG_WRITE( LOG_LEVEL_INFO, x, ##__VA_ARGS__ )
+#endif//ILOG
+
+#ifndef DLOG
+#define DLOG( x, ... ) LOG_WRITE( LOG_LEVEL_DEBUG, x, ##__VA_ARGS__ )
+#endif//DLOG
+
+#endif//__LOGGER_H__
@@ -0,0 +1,72 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : MappedFile.h
+// Desc : Read-Only Memory Mapped File.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    MappedFile();
+    ~MappedFile();
+
+    bool            Open ( const char* path );
+    void            Close();
+    bool            IsOpen () const;
+    const uint8_t*  GetData() const;
+    size_t          GetSize() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    const uint8_t*  m_pData;
+    size_t          m_Size;
+    void*           m_hFile;        // Windows のファイルハンドル.
+    void*           m_hMapping;     // Windows のマッピングハンドル.
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    MappedFile             ( const MappedFile& );   // アクセス禁止.
+    MappedFile& operator = ( const MappedFile& );   // アクセス禁止.
+};
+
+#endif//__MAPPED_FILE_H__
@@ -0,0 +1,127 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : PixelConvert.h
+// Desc : Pixel Format Conversion Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __PIXEL_CONVERT_H__
+#define __PIXEL_CONVERT_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+
+
+//-------------------------------------------------------------------------------------------------
+// Forward Declarations.
+//-------------------------------------------------------------------------------------------------
+class ThreadPool;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PIXEL_FORMAT enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum PIXEL_FORMAT
+{
+    PIXEL_FORMAT_B8G8R8A8 = 0,          //!< 8bit sRGB, ストレートアルファです.
+    PIXEL_FORMAT_B8G8R8A8_PREMUL,       //!< 8bit sRGB, sRGB 空間で乗算済みのアルファです (スワップチェインと D2D ビットマップの形式).
+    PIXEL_FORMAT_R8G8B8A8,              //!< 8bit sRGB, ストレートアルファです.
+    PIXEL_FORMAT_R8G8B8A8_PREMUL,       //!< 8bit sRGB, sRGB 空間で乗算済みのアルファです.
+    PIXEL_FORMAT_R16G16B16A16_FLOAT,    //!< 半精度浮動小数, リニア, 乗算済みアルファです.
+    PIXEL_FORMAT_R32G32B32A32_FLOAT,    //!< 単精度浮動小数, リニア, 乗算済みアルファです.
+    PIXEL_FORMAT_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SIMD_LEVEL enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum SIMD_LEVEL
+{
+    SIMD_LEVEL_SCALAR = 0,              //!< スカラー演算のみです.
+    SIMD_LEVEL_SSE2,                    //!< SSE2 です.
+    SIMD_LEVEL_AVX2,                    //!< AVX2 と F16C です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PlanarYUV structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct PlanarYUV
+{
+    uint8_t*    pY;             //!< 輝度プレーンの先頭です.
+    uint8_t*    pU;             //!< Cb プレーンの先頭です.
+    uint8_t*    pV;             //!< Cr プレーンの先頭です.
+    uint32_t    PitchY;         //!< 輝度プレーンの行ピッチです.
+    uint32_t    PitchUV;        //!< 色差プレーンの行ピッチです.
+};
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      B8G8R8A8 画像を YUV 4:2:0 (BT.601 リミテッドレンジ) に変換します.
+//!
+//! @param[in]      pSrc        変換元画像の先頭.
+//! @param[in]      srcPitch    変換元画像の行ピッチ (バイト単位).
+//! @param[in]      width       画像の横幅.
+//! @param[in]      height      画像の縦幅.
+//! @param[out]     dst         変換先プレーン. 色差は (width+1)/2 x (height+1)/2 です.
+//-------------------------------------------------------------------------------------------------
+void ConvertBGRAToI420(
+    const uint8_t*      pSrc,
+    uint32_t            srcPitch,
+    uint32_t            width,
+    uint32_t            height,
+    const PlanarYUV&    dst );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      ConvertBGRAToI420() のスカラー版です. 検証用に公開しています.
+//-------------------------------------------------------------------------------------------------
+void ConvertBGRAToI420_Scalar(
+    const uint8_t*      pSrc,
+    uint32_t            srcPitch,
+    uint32_t            width,
+    uint32_t            height,
+    const PlanarYUV&    dst );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      実行中の CPU で使える最も高い SIMD レベルを取得します.
+//-------------------------------------------------------------------------------------------------
+SIMD_LEVEL GetSimdLevel();
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      1画素あたりのバイト数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t GetPixelFormatSize( PIXEL_FORMAT format );
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      画素フォーマットを変換します.
+//!
+//! @details    8bit 形式は sRGB, 浮動小数形式はリニアとして扱い, sRGB の変換はテーブル引きで
+//!             行います. 浮動小数から 8bit への量子化誤差は最大 1 です. どの SIMD レベルでも
+//!             スカラー版と同じ結果になります.
+//!
+//! @param[in]      pSrc        変換元画像の先頭.
+//! @param[in]      srcPitch    変換元画像の行ピッチ (バイト単位).
+//! @param[in]      srcFormat   変換元の画素フォーマット.
+//! @param[out]     pDst        変換先画像の先頭.
+//! @param[in]      dstPitch    変換先画像の行ピッチ (バイト単位).
+//! @param[in]      dstFormat   変換先の画素フォーマット.
+//! @param[in]      width       画像の横幅.
+//! @param[in]      height      画像の縦幅.
+//! @param[in]      pPool       行を分割して並列に変換するスレッドプール. nullptr の場合は呼び出し元で変換します.
+//! @param[in]      maxLevel    使用する SIMD レベルの上限. CPU が対応していない場合は下げます.
+//! @retval true    変換に成功.
+//! @retval false   引数が不正.
+//-------------------------------------------------------------------------------------------------
+bool ConvertPixels(
+    const void*         pSrc,
+    uint32_t            srcPitch,
+    PIXEL_FORMAT        srcFormat,
+    void*               pDst,
+    uint32_t            dstPitch,
+    PIXEL_FORMAT        dstFormat,
+    uint32_t            width,
+    uint32_t            height,
+    ThreadPool*         pPool    = nullptr,
+    SIMD_LEVEL          maxLevel = SIMD_LEVEL_AVX2 );
+
+#endif//__PIXEL_CONVERT_H__
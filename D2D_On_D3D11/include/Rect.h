@@ -0,0 +1,110 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Rect.h
+// Desc : Axis Aligned Rectangle Utilities.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __RECT_H__
+#define __RECT_H__
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ClipRect structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct ClipRect
+{
+    int     Left;           //!< 左端 (含む) です.
+    int     Top;            //!< 上端 (含む) です.
+    int     Right;          //!< 右端 (含まない) です.
+    int     Bottom;         //!< 下端 (含まない) です.
+
+    bool IsEmpty() const
+    { return ( Left >= Right ) || ( Top >= Bottom ); }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SceneRect structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct SceneRect
+{
+    float   Left;                   //!< 左端です.
+    float   Top;                    //!< 上端です.
+    float   Right;                  //!< 右端です (含まない).
+    float   Bottom;                 //!< 下端です (含まない).
+
+    bool IsEmpty() const
+    { return !( Left < Right ) || !( Top < Bottom ); }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      2つの矩形の共通部分を求めます. 重ならない場合は IsEmpty() が true になる矩形を返します.
+//-------------------------------------------------------------------------------------------------
+inline ClipRect Intersect( const ClipRect& a, const ClipRect& b )
+{
+    ClipRect result = {
+        ( a.Left   > b.Left   ) ? a.Left   : b.Left,
+        ( a.Top    > b.Top    ) ? a.Top    : b.Top,
+        ( a.Right  < b.Right  ) ? a.Right  : b.Right,
+        ( a.Bottom < b.Bottom ) ? a.Bottom : b.Bottom };
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      2つの矩形の共通部分を求めます. 重ならない場合は IsEmpty() が true になる矩形を返します.
+//-------------------------------------------------------------------------------------------------
+inline SceneRect Intersect( const SceneRect& a, const SceneRect& b )
+{
+    SceneRect result = {
+        ( a.Left   > b.Left   ) ? a.Left   : b.Left,
+        ( a.Top    > b.Top    ) ? a.Top    : b.Top,
+        ( a.Right  < b.Right  ) ? a.Right  : b.Right,
+        ( a.Bottom < b.Bottom ) ? a.Bottom : b.Bottom };
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      2つの矩形を囲む矩形を求めます. 空の矩形は無視します.
+//-------------------------------------------------------------------------------------------------
+inline SceneRect Union( const SceneRect& a, const SceneRect& b )
+{
+    if ( a.IsEmpty() )
+    { return b; }
+    if ( b.IsEmpty() )
+    { return a; }
+
+    SceneRect result = {
+        ( a.Left   < b.Left   ) ? a.Left   : b.Left,
+        ( a.Top    < b.Top    ) ? a.Top    : b.Top,
+        ( a.Right  > b.Right  ) ? a.Right  : b.Right,
+        ( a.Bottom > b.Bottom ) ? a.Bottom : b.Bottom };
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      2つの矩形が重なるかどうかを判定します. 空の矩形はどこにも重なりません.
+//-------------------------------------------------------------------------------------------------
+inline bool Overlaps( const SceneRect& a, const SceneRect& b )
+{
+    return !a.IsEmpty()
+        && a.Left < b.Right && b.Left < a.Right
+        && a.Top < b.Bottom && b.Top < a.Bottom;
+}
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      矩形 a が矩形 b を完全に含むかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+inline bool Contains( const SceneRect& a, const SceneRect& b )
+{
+    return a.Left <= b.Left && b.Right  <= a.Right
+        && a.Top  <= b.Top  && b.Bottom <= a.Bottom;
+}
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      矩形が点を含むかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+inline bool Contains( const SceneRect& rect, float x, float y )
+{ return rect.Left <= x && x < rect.Right && rect.Top <= y && y < rect.Bottom; }
+
+#endif//__RECT_H__
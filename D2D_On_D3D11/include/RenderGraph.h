@@ -0,0 +1,189 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : RenderGraph.h
+// Desc : Frame Render Graph with Transient Resource Aliasing.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __RENDER_GRAPH_H__
+#define __RENDER_GRAPH_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  INVALID_RENDER_RESOURCE = 0xffffffff;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderTextureDesc structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct RenderTextureDesc
+{
+    uint32_t    Width;              //!< 横幅です.
+    uint32_t    Height;             //!< 縦幅です.
+    uint32_t    Format;             //!< ピクセルフォーマットです (DXGI_FORMAT の値).
+    uint32_t    BytesPerPixel;      //!< 1 ピクセルのバイト数です.
+    uint32_t    SampleCount;        //!< マルチサンプル数です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class RenderGraph
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint32_t    PassCount;          //!< 追加されたパス数です.
+        uint32_t    CulledPassCount;    //!< 出力が使われないため実行しないパス数です.
+        uint32_t    TransientCount;     //!< 実体を割り当てた一時リソース数です.
+        uint32_t    PhysicalCount;      //!< 一時リソースに使う実テクスチャ数です.
+        uint64_t    UnaliasedBytes;     //!< 一時リソースを全て個別に確保した場合のバイト数です.
+        uint64_t    PooledBytes;        //!< 同じ記述のテクスチャを使い回した場合のバイト数です (D3D11).
+        uint64_t    PlacedBytes;        //!< 共有ヒープ内のオフセットに配置した場合のバイト数です.
+        uint64_t    LowerBoundBytes;    //!< 同時に生存する一時リソースの合計の最大値です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // ResourceInfo structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct ResourceInfo
+    {
+        const char*         Name;           //!< リソース名です.
+        RenderTextureDesc   Desc;           //!< テクスチャの記述です.
+        uint64_t            Bytes;          //!< テクスチャのバイト数です.
+        bool                Imported;       //!< 外部から渡されたリソースかどうかです.
+        void*               pPhysical;      //!< 実体です. 一時リソースは Execute() の間だけ有効です.
+        uint32_t            FirstPass;      //!< 最初に使う実行順の位置です.
+        uint32_t            LastPass;       //!< 最後に使う実行順の位置です.
+        uint32_t            Slot;           //!< 使い回す実テクスチャの番号です.
+        uint64_t            HeapOffset;     //!< 共有ヒープ内のオフセットです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    typedef std::function<void( const RenderGraph& graph )>                 PassFunc;
+    typedef std::function<void*( const RenderTextureDesc& desc )>           CreateFunc;
+    typedef std::function<void( void* pPhysical )>                          DestroyFunc;
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    RenderGraph();
+    ~RenderGraph();
+
+    void        SetAllocator  ( const CreateFunc& create, const DestroyFunc& destroy );
+    uint32_t    CreateTexture ( const char* name, const RenderTextureDesc& desc );
+    uint32_t    ImportTexture ( const char* name, const RenderTextureDesc& desc, void* pPhysical );
+    uint32_t    AddPass       ( const char* name, const PassFunc& func, bool sideEffect = false );
+    bool        Read          ( uint32_t pass, uint32_t resource );
+    bool        Write         ( uint32_t pass, uint32_t resource );
+    bool        Compile       ();
+    bool        Execute       ();
+    void        Reset         ();
+    void        Term          ();
+
+    void*                           GetPhysical    ( uint32_t resource ) const;
+    const ResourceInfo&             GetResourceInfo( uint32_t resource ) const;
+    uint32_t                        GetResourceCount() const;
+    const std::vector<uint32_t>&    GetOrder       () const;
+    const Stats&                    GetStats       () const;
+    void                            PrintSchedule  () const;
+
+    static uint64_t                 GetTextureBytes( const RenderTextureDesc& desc );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Access structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Access
+    {
+        uint32_t    Resource;       //!< アクセスするリソースです.
+        bool        Read;           //!< 読み込むかどうかです.
+        bool        Write;          //!< 書き込むかどうかです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // PassInfo structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct PassInfo
+    {
+        const char*             Name;           //!< パス名です.
+        PassFunc                Func;           //!< 実行する処理です.
+        bool                    SideEffect;     //!< 出力が使われなくても実行するかどうかです.
+        bool                    Live;           //!< 実行するかどうかです.
+        std::vector<Access>     Accesses;       //!< 読み書きするリソースです.
+        std::vector<uint32_t>   Producers;      //!< 読み込むリソースを書き込むパスです.
+        std::vector<uint32_t>   Successors;     //!< このパスの後に実行する必要があるパスです.
+        uint32_t                Remaining;      //!< 未スケジュールの先行パス数です.
+        uint32_t                Position;       //!< 実行順の位置です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Slot structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Slot
+    {
+        RenderTextureDesc   Desc;           //!< テクスチャの記述です.
+        void*               pPhysical;      //!< 実体です. フレームをまたいで保持します.
+        uint32_t            LastPass;       //!< 現在のフレームで最後に使う実行順の位置です.
+        bool                Used;           //!< 現在のフレームで使っているかどうかです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<PassInfo>       m_Passes;
+    std::vector<ResourceInfo>   m_Resources;
+    std::vector<Slot>           m_Slots;
+    std::vector<uint32_t>       m_Order;
+    std::vector<uint32_t>       m_Work;         // 作業用の配列.
+    CreateFunc                  m_Create;
+    DestroyFunc                 m_Destroy;
+    Stats                       m_Stats;
+    bool                        m_Compiled;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool        AddAccess     ( uint32_t pass, uint32_t resource, bool write );
+    void        BuildEdges    ();
+    void        CullPasses    ();
+    bool        SortPasses    ();
+    void        ComputeLifetimes();
+    void        AssignSlots   ();
+    void        PlaceInHeap   ();
+
+    RenderGraph             ( const RenderGraph& );     // アクセス禁止.
+    RenderGraph& operator = ( const RenderGraph& );     // アクセス禁止.
+};
+
+#endif//__RENDER_GRAPH_H__
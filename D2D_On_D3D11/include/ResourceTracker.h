@@ -0,0 +1,134 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ResourceTracker.h
+// Desc : GPU/CPU Resource Memory Accounting.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __RESOURCE_TRACKER_H__
+#define __RESOURCE_TRACKER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RESOURCE_CATEGORY enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum RESOURCE_CATEGORY
+{
+    RESOURCE_CATEGORY_SWAP_CHAIN = 0,       //!< スワップチェインのバックバッファです.
+    RESOURCE_CATEGORY_VIEW,                 //!< レンダーターゲットビューなどのビューです (メモリは持たず数だけ数えます).
+    RESOURCE_CATEGORY_DEPTH_STENCIL,        //!< 深度ステンシルテクスチャです.
+    RESOURCE_CATEGORY_D2D_BITMAP,           //!< Direct2D のビットマップです. DXGI サーフェイスを共有するものは 0 バイトです.
+    RESOURCE_CATEGORY_VERTEX_BUFFER,        //!< 頂点バッファとインスタンスバッファです.
+    RESOURCE_CATEGORY_TEXTURE,              //!< シェーダから読むテクスチャです.
+    RESOURCE_CATEGORY_STAGING,              //!< CPU への読み戻し用テクスチャです.
+    RESOURCE_CATEGORY_SURFACE,              //!< CPU 側の描画サーフェイスです.
+    RESOURCE_CATEGORY_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ResourceTracker class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class ResourceTracker
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Usage structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Usage
+    {
+        uint64_t    Bytes;              //!< 現在のバイト数です.
+        uint64_t    PeakBytes;          //!< バイト数の最大値です.
+        uint32_t    Count;              //!< 現在のリソース数です.
+        uint32_t    PeakCount;          //!< リソース数の最大値です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Snapshot structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Snapshot
+    {
+        Usage       Category[RESOURCE_CATEGORY_COUNT];  //!< 種類ごとの使用量です.
+        Usage       Total;              //!< 全体の使用量です.
+        uint64_t    BudgetBytes;        //!< 予算です. 0 は無制限です.
+        uint64_t    FrameCount;         //!< EndFrame() を呼び出した回数です.
+        uint64_t    FrameAllocBytes;    //!< 直前のフレームで確保したバイト数です.
+        uint64_t    FrameFreeBytes;     //!< 直前のフレームで解放したバイト数です.
+        uint64_t    MaxFrameChurnBytes; //!< 1 フレームで確保と解放をしたバイト数の最大値です.
+        uint64_t    TotalAllocBytes;    //!< 確保したバイト数の累計です.
+        uint64_t    TotalFreeBytes;     //!< 解放したバイト数の累計です.
+        uint64_t    TrimCount;          //!< 予算超過で削減処理を呼び出した回数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    typedef std::function<void( uint64_t excessBytes )>  TrimFunc;
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    ResourceTracker();
+    ~ResourceTracker();
+
+    bool        Track    ( const void* pResource, RESOURCE_CATEGORY category, uint64_t bytes );
+    bool        Untrack  ( const void* pResource );
+    void        Clear    ();
+    void        SetBudget( uint64_t bytes, const TrimFunc& trim );
+    void        EndFrame ();
+    Snapshot    GetSnapshot() const;
+    void        ResetStats ();
+
+    static const char*  GetCategoryName( RESOURCE_CATEGORY category );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        RESOURCE_CATEGORY   Category;   //!< 種類です.
+        uint64_t            Bytes;      //!< バイト数です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::unordered_map<const void*, Entry>  m_Entries;
+    mutable std::mutex                      m_Mutex;
+    TrimFunc                                m_Trim;
+    uint64_t                                m_FrameAlloc;   // 現在のフレームで確保したバイト数.
+    uint64_t                                m_FrameFree;    // 現在のフレームで解放したバイト数.
+    Snapshot                                m_Snapshot;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    ResourceTracker             ( const ResourceTracker& );     // アクセス禁止.
+    ResourceTracker& operator = ( const ResourceTracker& );     // アクセス禁止.
+};
+
+#endif//__RESOURCE_TRACKER_H__
@@ -0,0 +1,221 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : RingBuffer.h
+// Desc : Fenced Ring Allocator for Per-Frame Streaming Data.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+//-------------------------------------------------------------------------------------------------
+// Forward Declarations.
+//-------------------------------------------------------------------------------------------------
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+struct ID3D11Query;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RING_MAP enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum RING_MAP
+{
+    RING_MAP_DISCARD = 0,           //!< バッファ全体を破棄してマップします (D3D11_MAP_WRITE_DISCARD).
+    RING_MAP_NO_OVERWRITE,          //!< 使用中の領域に触れずにマップします (D3D11_MAP_WRITE_NO_OVERWRITE).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RingAllocation structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct RingAllocation
+{
+    uint64_t    Offset;             //!< バッファ先頭からのバイトオフセットです.
+    uint64_t    Size;               //!< 確保したバイト数です.
+    RING_MAP    MapType;            //!< 書き込むときのマップ方法です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GpuFence class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class GpuFence
+{
+public:
+    virtual ~GpuFence() { /* DO_NOTHING */ }
+
+    //! @brief      これまでに発行した処理の後ろにフェンスを置き, その値を返します. 値は 1 から増えていきます.
+    virtual uint64_t    Signal() = 0;
+
+    //! @brief      GPU が処理を終えたフェンスの最大値を取得します.
+    virtual uint64_t    GetCompletedValue() = 0;
+
+    //! @brief      指定したフェンスまで GPU が処理を終えるのを待ちます.
+    virtual void        Wait( uint64_t value ) = 0;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// D3D11GpuFence class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class D3D11GpuFence : public GpuFence
+{
+public:
+    D3D11GpuFence();
+    virtual ~D3D11GpuFence();
+
+    bool    Init( ID3D11Device* pDevice, ID3D11DeviceContext* pContext, uint32_t maxPending = 8 );
+    void    Term();
+
+    virtual uint64_t    Signal() override;
+    virtual uint64_t    GetCompletedValue() override;
+    virtual void        Wait( uint64_t value ) override;
+
+private:
+    ID3D11DeviceContext*        m_pContext;
+    std::vector<ID3D11Query*>   m_Queries;      // D3D11_QUERY_EVENT のリング. 値 v は (v - 1) % size 番目を使う.
+    uint64_t                    m_Signaled;
+    uint64_t                    m_Completed;
+
+    D3D11GpuFence             ( const D3D11GpuFence& );     // アクセス禁止.
+    D3D11GpuFence& operator = ( const D3D11GpuFence& );     // アクセス禁止.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SimulatedGpuFence class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SimulatedGpuFence : public GpuFence
+{
+public:
+    typedef std::function<void( uint64_t value )>   ExecuteFunc;
+
+    SimulatedGpuFence();
+    virtual ~SimulatedGpuFence();
+
+    bool    Init( double frameMsec, const ExecuteFunc& execute = nullptr );
+    void    Term();
+
+    virtual uint64_t    Signal() override;
+    virtual uint64_t    GetCompletedValue() override;
+    virtual void        Wait( uint64_t value ) override;
+
+private:
+    std::thread                 m_Thread;
+    std::mutex                  m_Mutex;
+    std::condition_variable     m_Cond;
+    std::deque<uint64_t>        m_Pending;      // GPU スレッドが未処理のフェンス.
+    std::atomic<uint64_t>       m_Completed;
+    uint64_t                    m_Signaled;
+    double                      m_FrameMsec;    // フェンス1つ分の処理にかかる時間.
+    ExecuteFunc                 m_Execute;      // フェンスを完了する前に GPU スレッドで呼び出す処理.
+    bool                        m_Quit;
+
+    void    ThreadMain();
+
+    SimulatedGpuFence             ( const SimulatedGpuFence& );     // アクセス禁止.
+    SimulatedGpuFence& operator = ( const SimulatedGpuFence& );     // アクセス禁止.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RingBuffer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class RingBuffer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    FrameCount;         //!< EndFrame() の呼び出し回数です.
+        uint64_t    AllocCount;         //!< 確保した回数です.
+        uint64_t    AllocBytes;         //!< 確保したバイト数の合計です.
+        uint64_t    PaddingBytes;       //!< アライメントと折り返しで使わずに飛ばしたバイト数です.
+        uint64_t    WrapCount;          //!< バッファ末尾から先頭に折り返した回数です.
+        uint64_t    StallCount;         //!< 空きを作るために GPU を待った回数です.
+        double      StallMsec;          //!< GPU を待った合計時間 (ミリ秒) です.
+        uint64_t    PeakBytes;          //!< GPU が使用中の領域を含めた最大使用量です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    RingBuffer();
+    ~RingBuffer();
+
+    bool        Init        ( uint64_t capacity, GpuFence* pFence );
+    void        Term        ();
+    bool        Allocate    ( uint64_t size, uint64_t alignment, RingAllocation& result );
+    void        EndFrame    ();
+    uint64_t    GetCapacity () const;
+    uint64_t    GetUsedBytes() const;
+    Stats       GetStats    () const;
+    void        ResetStats  ();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // FrameMark structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct FrameMark
+    {
+        uint64_t    Fence;          //!< フレーム末に置いたフェンスの値です.
+        uint64_t    End;            //!< フレームで最後に確保した領域の末尾です (通算位置).
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    GpuFence*               m_pFence;
+    std::deque<FrameMark>   m_Frames;       // GPU が使用中の可能性があるフレーム.
+    uint64_t                m_Capacity;
+    uint64_t                m_Head;         // 次に確保する通算位置. オフセットは容量で割った余り.
+    uint64_t                m_Tail;         // GPU が使用中の可能性がある最も古い通算位置.
+    bool                    m_Discard;      // 次の確保でバッファ全体を破棄するかどうか.
+    Stats                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    Retire();
+
+    RingBuffer             ( const RingBuffer& );   // アクセス禁止.
+    RingBuffer& operator = ( const RingBuffer& );   // アクセス禁止.
+};
+
+#endif//__RING_BUFFER_H__
@@ -0,0 +1,25 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SafeRelease.h
+// Desc : COM Object Release Helper.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SAFE_RELEASE_H__
+#define __SAFE_RELEASE_H__
+
+
+//-------------------------------------------------------------------------------------------------
+//! @brief      解放処理を行います. 解放後は nullptr を設定します.
+//!
+//! @param[in,out]  ptr     解放する COM オブジェクト. nullptr なら何もしません.
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+void SafeRelease( T*& ptr )
+{
+    if ( ptr )
+    { ptr->Release(); }
+
+    ptr = nullptr;
+}
+
+#endif//__SAFE_RELEASE_H__
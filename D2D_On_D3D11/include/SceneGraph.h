@@ -0,0 +1,148 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SceneGraph.h
+// Desc : Retained 2D Scene Graph.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SCENE_GRAPH_H__
+#define __SCENE_GRAPH_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <Rect.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Type Definitions.
+//-------------------------------------------------------------------------------------------------
+typedef uint32_t    SceneNodeId;
+
+const SceneNodeId   INVALID_SCENE_NODE = 0xffffffff;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SceneGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SceneGraph
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    UpdateCount;        //!< Update() の呼び出し回数です.
+        uint64_t    VisitCount;         //!< 更新時に走査したノード数です.
+        uint64_t    TransformCount;     //!< ワールド変換を再計算したノード数です.
+        uint64_t    BoundsCount;        //!< バウンディングボックスを再計算したノード数です.
+        double      UpdateMsec;         //!< Update() にかかった合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SceneGraph();
+    ~SceneGraph();
+
+    SceneNodeId CreateNode ( SceneNodeId parent );
+    void        DestroyNode( SceneNodeId id );
+    void        Clear      ();
+
+    void        SetTransform( SceneNodeId id, const float matrix[6] );
+    void        SetOpacity  ( SceneNodeId id, float opacity );
+    void        SetClip     ( SceneNodeId id, const SceneRect* pClip );
+    void        SetContent  ( SceneNodeId id, uint32_t content, const SceneRect& bounds );
+
+    void        Update   ();
+    void        UpdateAll();
+    void        Cull     ( const SceneRect& viewport, std::vector<SceneNodeId>& result ) const;
+
+    uint32_t            GetNodeCount     () const;
+    SceneNodeId         GetParent        ( SceneNodeId id ) const;
+    const float*        GetLocalTransform( SceneNodeId id ) const;
+    const float*        GetWorldTransform( SceneNodeId id ) const;
+    float               GetWorldOpacity  ( SceneNodeId id ) const;
+    SceneRect           GetWorldBounds   ( SceneNodeId id ) const;
+    uint32_t            GetContent       ( SceneNodeId id ) const;
+    SceneRect           GetContentBounds ( SceneNodeId id ) const;
+    Stats               GetStats         () const;
+    void                ResetStats       ();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // NodeLink structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct NodeLink
+    {
+        SceneNodeId Id;                 //!< ノード ID です.
+        uint32_t    Parent;             //!< 親ノードの配列位置です. 最上位の場合は無効値です.
+        uint32_t    End;                //!< 部分木の終端 (含まない) の配列位置です.
+        uint32_t    Flags;              //!< 属性と変更フラグです.
+        SceneRect   Bounds;             //!< 部分木全体のワールド空間でのバウンディングボックスです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // NodeData structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct NodeData
+    {
+        float       Local[6];           //!< 親空間への変換行列です.
+        float       World[6];           //!< ワールド変換行列です.
+        float       Opacity;            //!< 不透明度です.
+        float       WorldOpacity;       //!< 祖先の不透明度を掛け合わせた不透明度です.
+        uint32_t    Content;            //!< 描画内容の番号です.
+        SceneRect   ContentBounds;      //!< 描画内容のローカル空間での範囲です.
+        SceneRect   Clip;               //!< ローカル空間でのクリップ矩形です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<NodeLink>       m_Links;        // 深さ優先の行きがけ順に並べた階層と範囲 (走査用に小さく保つ).
+    std::vector<NodeData>       m_Data;         // m_Links と同じ順に並べたノードの属性.
+    std::vector<uint32_t>       m_Slots;        // ノード ID から配列位置への対応表.
+    std::vector<SceneNodeId>    m_FreeIds;
+    std::vector<SceneNodeId>    m_DirtyIds;     // 前回の更新以降に変更されたノード.
+    std::vector<uint32_t>       m_DirtyQueue;   // 変更されたノードの配列位置.
+    std::vector<uint32_t>       m_BoundsQueue;  // バウンディングボックスを再計算する配列位置.
+    Stats                       m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    NodeData*       FindNode     ( SceneNodeId id );
+    const NodeData* FindNode     ( SceneNodeId id ) const;
+    void            MarkDirty    ( uint32_t index, uint32_t flag );
+    void            UpdateNodes  ( bool force );
+    void            ComputeWorld ( uint32_t index );
+    void            ComputeBounds( uint32_t index );
+
+    SceneGraph             ( const SceneGraph& );   // アクセス禁止.
+    SceneGraph& operator = ( const SceneGraph& );   // アクセス禁止.
+};
+
+#endif//__SCENE_GRAPH_H__
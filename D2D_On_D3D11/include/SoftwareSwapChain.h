@@ -0,0 +1,151 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SoftwareSwapChain.h
+// Desc : CPU Swap Chain with Present Thread.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SOFTWARE_SWAP_CHAIN_H__
+#define __SOFTWARE_SWAP_CHAIN_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <Surface.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PRESENT_MODE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum PRESENT_MODE
+{
+    PRESENT_MODE_FIFO = 0,      //!< 提出した全フレームを順に 1 リフレッシュずつ表示します. 空きバッファが無ければ描画側が待機します.
+    PRESENT_MODE_MAILBOX,       //!< 待ち行列は 1 フレームだけで, 表示前に次のフレームが提出されると古い方を破棄します.
+    PRESENT_MODE_LATEST,        //!< 提出時には破棄せず, 表示の時点で最新のフレームだけを表示して残りを破棄します.
+    PRESENT_MODE_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SoftwareSwapChain class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SoftwareSwapChain
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    PresentCount;       //!< Present() で提出したフレーム数です.
+        uint64_t    DisplayCount;       //!< 表示したフレーム数です.
+        uint64_t    DropCount;          //!< 表示されずに破棄したフレーム数です.
+        uint64_t    RepeatCount;        //!< 新しいフレームが無く前のフレームを表示し続けたリフレッシュ数です.
+        uint64_t    InFlightSum;        //!< 提出時の表示待ちフレーム数の累計です.
+        uint32_t    MaxInFlight;        //!< 表示待ちフレーム数の最大値です.
+        int64_t     LatencyTicks;       //!< 提出から表示までの合計ティック数です (表示したフレームのみ).
+        int64_t     MaxLatencyTicks;    //!< 提出から表示までの最大ティック数です.
+        uint64_t    BlockedCount;       //!< Acquire() で空きバッファを待った回数です.
+        int64_t     BlockedTicks;       //!< Acquire() で待った合計ティック数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MinBufferCount = 2;     // 表示中のバッファと描画中のバッファ.
+    static const uint32_t   MaxBufferCount = 16;
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SoftwareSwapChain();
+    ~SoftwareSwapChain();
+
+    bool        Init( uint32_t width, uint32_t height, uint32_t bufferCount, PRESENT_MODE mode, double refreshRate,
+                      std::function<void( const Surface&, uint64_t )> scanout = nullptr );
+    void        Term();
+
+    Surface*    Acquire( uint32_t& index );
+    bool        Present( uint32_t index );
+    void        WaitIdle();
+
+    uint32_t    GetBufferCount() const;
+    PRESENT_MODE GetMode() const;
+    Stats       GetStats  () const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // BUFFER_STATE enum
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    enum BUFFER_STATE
+    {
+        BUFFER_STATE_FREE = 0,          //!< 描画側が取得できます.
+        BUFFER_STATE_RENDERING,         //!< 描画側が取得済みです.
+        BUFFER_STATE_QUEUED,            //!< 提出済みで表示を待っています.
+        BUFFER_STATE_FRONT,             //!< 表示中です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // BufferInfo structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct BufferInfo
+    {
+        BUFFER_STATE    State;          //!< 状態です.
+        uint64_t        FrameId;        //!< 提出順の通し番号です.
+        int64_t         SubmitTicks;    //!< 提出した時刻です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<std::unique_ptr<Surface>>   m_Surfaces;
+    std::vector<BufferInfo>                 m_Buffers;
+    std::deque<uint32_t>                    m_Queue;        // 表示待ちのバッファ番号 (提出順).
+    std::function<void( const Surface&, uint64_t )> m_Scanout;
+    std::thread                             m_Thread;
+    mutable std::mutex                      m_Mutex;
+    std::condition_variable                 m_FreeCond;     // バッファが空いた.
+    std::condition_variable                 m_IdleCond;     // 表示待ちが無くなった.
+    std::condition_variable                 m_WakeCond;     // 提出スレッドの終了要求.
+    PRESENT_MODE                            m_Mode;
+    int64_t                                 m_IntervalTicks;
+    uint32_t                                m_Front;        // 表示中のバッファ番号. 無い場合は UINT32_MAX.
+    uint64_t                                m_NextFrameId;
+    bool                                    m_Stop;
+    Stats                                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void        PresentThread();
+    void        Flip( int64_t now );
+
+    SoftwareSwapChain             ( const SoftwareSwapChain& );     // アクセス禁止.
+    SoftwareSwapChain& operator = ( const SoftwareSwapChain& );     // アクセス禁止.
+};
+
+#endif//__SOFTWARE_SWAP_CHAIN_H__
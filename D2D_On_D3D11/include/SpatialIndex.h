@@ -0,0 +1,156 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpatialIndex.h
+// Desc : Loose Quadtree Spatial Index.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SPATIAL_INDEX_H__
+#define __SPATIAL_INDEX_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <SceneGraph.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Type Definitions.
+//-------------------------------------------------------------------------------------------------
+typedef uint32_t    SpatialHandle;
+
+const SpatialHandle INVALID_SPATIAL_HANDLE = 0xffffffff;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpatialIndex class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SpatialIndex
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    InsertCount;        //!< Insert() の呼び出し回数です.
+        uint64_t    UpdateCount;        //!< Update() の呼び出し回数です.
+        uint64_t    RelinkCount;        //!< Update() でセルを移動した回数です.
+        uint64_t    RemoveCount;        //!< Remove() の呼び出し回数です.
+        uint64_t    QueryCount;         //!< 矩形と点の問い合わせ回数です.
+        uint64_t    CellVisitCount;     //!< 問い合わせで訪れたセル数です.
+        uint64_t    ItemTestCount;      //!< 問い合わせで範囲を判定した要素数です.
+        uint64_t    ResultCount;        //!< 問い合わせで返した要素数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MaxDepth = 10;      // 分割の最大深さ.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SpatialIndex();
+    ~SpatialIndex();
+
+    bool            Init  ( const SceneRect& world, uint32_t depth = 8 );
+    void            Term  ();
+    void            Clear ();
+    SpatialHandle   Insert( const SceneRect& bounds, uint32_t userData );
+    void            Update( SpatialHandle handle, const SceneRect& bounds );
+    void            Remove( SpatialHandle handle );
+
+    void            QueryRect ( const SceneRect& rect, std::vector<uint32_t>& result ) const;
+    void            QueryPoint( float x, float y, std::vector<uint32_t>& result ) const;
+
+    uint32_t        GetCount  () const;
+    SceneRect       GetBounds ( SpatialHandle handle ) const;
+    Stats           GetStats  () const;
+    void            ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        SceneRect   Bounds;             //!< 範囲です.
+        uint32_t    UserData;           //!< 問い合わせで返す値です.
+        uint32_t    Handle;             //!< 要素のハンドルです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Cell structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Cell
+    {
+        std::vector<Entry>  Entries;        //!< セルに属する要素です (問い合わせで連続して読めるように詰めて並べます).
+        uint32_t            SubtreeCount;   //!< 子孫のセルも含めた要素数です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Item structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Item
+    {
+        uint32_t    Cell;               //!< 属するセルです. 未使用の場合は無効値です.
+        uint32_t    Slot;               //!< セル内の位置です. 未使用の場合は次の空き要素です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Visit structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Visit
+    {
+        uint32_t    Level;              //!< 深さです.
+        uint32_t    X;                  //!< 深さ内のセルの列です.
+        uint32_t    Y;                  //!< 深さ内のセルの行です.
+        bool        Inside;             //!< 問い合わせ範囲に完全に含まれるかどうかです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    SceneRect               m_World;
+    float                   m_WorldSize;        // 最上位のセルの一辺.
+    uint32_t                m_Depth;
+    uint32_t                m_LevelOffset[MaxDepth + 2];
+    std::vector<Cell>       m_Cells;
+    std::vector<Item>       m_Items;
+    uint32_t                m_FreeItem;
+    uint32_t                m_Count;
+    mutable std::vector<Visit>  m_Stack;
+    mutable Stats               m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    uint32_t    FindCell  ( const SceneRect& bounds ) const;
+    void        Link      ( uint32_t item, uint32_t cell, const Entry& entry );
+    void        Unlink    ( uint32_t item );
+    void        AddCount  ( uint32_t cell, int delta );
+    SceneRect   GetLooseRect( uint32_t level, uint32_t x, uint32_t y ) const;
+
+    SpatialIndex             ( const SpatialIndex& );   // アクセス禁止.
+    SpatialIndex& operator = ( const SpatialIndex& );   // アクセス禁止.
+};
+
+#endif//__SPATIAL_INDEX_H__
@@ -0,0 +1,150 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpriteBatch.h
+// Desc : Sorted Sprite Instance Stream.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SPRITE_BATCH_H__
+#define __SPRITE_BATCH_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SPRITE_BLEND enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum SPRITE_BLEND
+{
+    SPRITE_BLEND_OPAQUE = 0,        //!< ブレンドしません.
+    SPRITE_BLEND_ALPHA,             //!< 乗算済みアルファでブレンドします.
+    SPRITE_BLEND_ADDITIVE,          //!< 加算合成します.
+    SPRITE_BLEND_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sprite structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct Sprite
+{
+    float       X;                  //!< 中心の X 座標 (ピクセル) です.
+    float       Y;                  //!< 中心の Y 座標 (ピクセル) です.
+    float       Width;              //!< 横幅 (ピクセル) です.
+    float       Height;             //!< 縦幅 (ピクセル) です.
+    float       Rotation;           //!< 回転角 (ラジアン, 時計回り) です.
+    float       TexCoord[4];        //!< テクスチャ座標の矩形 (u0, v0, u1, v1) です.
+    uint32_t    Color;              //!< 乗算済みの R8G8B8A8 (R が最下位バイト) です.
+    uint8_t     Layer;              //!< 描画順のレイヤーです. 小さい方から描画します.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteInstance structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct SpriteInstance
+{
+    float       Center[2];          //!< 中心 (正規化デバイス座標) です.
+    float       AxisX[2];           //!< 中心から右端への軸ベクトル (正規化デバイス座標) です.
+    float       AxisY[2];           //!< 中心から下端への軸ベクトル (正規化デバイス座標) です.
+    float       TexCoord[4];        //!< テクスチャ座標の矩形 (u0, v0, u1, v1) です.
+    uint32_t    Color;              //!< 乗算済みの R8G8B8A8 です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteRun structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct SpriteRun
+{
+    uint32_t        Texture;        //!< テクスチャ番号です.
+    SPRITE_BLEND    Blend;          //!< ブレンドステートです.
+    uint32_t        Start;          //!< ソート済みインスタンス列での開始位置です.
+    uint32_t        Count;          //!< インスタンス数です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteBatch class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SpriteBatch
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    FrameCount;         //!< End() の呼び出し回数です.
+        uint64_t    SpriteCount;        //!< 登録されたスプライトの総数です.
+        uint64_t    RunCount;           //!< 生成したラン (描画呼び出し) の総数です.
+        uint64_t    SortPassCount;      //!< 実行した基数ソートのパス数です.
+        double      SortMsec;           //!< ソートとラン構築にかかった合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MaxTextures = 1 << 16;  // テクスチャ番号の上限.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SpriteBatch();
+    ~SpriteBatch();
+
+    void    Begin   ( float viewportWidth, float viewportHeight );
+    void    Draw    ( const Sprite& sprite, uint32_t texture, SPRITE_BLEND blend );
+    void    End     ();
+
+    uint32_t                GetSpriteCount() const;
+    const SpriteInstance*   GetInstances  () const;
+    const SpriteRun*        GetRuns       () const;
+    uint32_t                GetRunCount   () const;
+    Stats                   GetStats      () const;
+    void                    ResetStats    ();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<SpriteInstance> m_Instances;    // 登録順のインスタンス.
+    std::vector<SpriteInstance> m_Sorted;       // ソート済みのインスタンス.
+    std::vector<uint64_t>       m_Keys;         // 上位 32bit がソートキー, 下位 32bit が登録番号.
+    std::vector<uint64_t>       m_Temp;         // 基数ソートの作業領域.
+    std::vector<SpriteRun>      m_Runs;
+    uint32_t                    m_Count;
+    float                       m_ScaleX;       // ピクセルから正規化デバイス座標への変換係数.
+    float                       m_ScaleY;
+    Stats                       m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    SortKeys ();
+    void    BuildRuns();
+
+    SpriteBatch             ( const SpriteBatch& );     // アクセス禁止.
+    SpriteBatch& operator = ( const SpriteBatch& );     // アクセス禁止.
+};
+
+#endif//__SPRITE_BATCH_H__
@@ -0,0 +1,101 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpriteRenderer.h
+// Desc : Instanced Sprite Renderer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SPRITE_RENDERER_H__
+#define __SPRITE_RENDERER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <d3d11.h>
+#include <vector>
+#include <SpriteBatch.h>
+#include <ResourceTracker.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteRenderer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SpriteRenderer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        UINT64      FrameCount;         //!< Render() の呼び出し回数です.
+        UINT64      SpriteCount;        //!< 描画したスプライトの総数です.
+        UINT64      DrawCount;          //!< DrawInstanced() の呼び出し回数です.
+        UINT64      TextureChangeCount; //!< テクスチャの切り替え回数です.
+        UINT64      BlendChangeCount;   //!< ブレンドステートの切り替え回数です.
+        UINT64      UploadBytes;        //!< インスタンスバッファへの転送量です.
+        double      RenderMsec;         //!< Render() にかかった合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SpriteRenderer();
+    ~SpriteRenderer();
+
+    bool    Init      ( ID3D11Device* pDevice, UINT maxInstances = 65536, ResourceTracker* pTracker = nullptr );
+    void    Term      ();
+    UINT    AddTexture( ID3D11ShaderResourceView* pTexture, UINT64 bytes = 0 );
+    void    Render    ( ID3D11DeviceContext* pContext, const SpriteBatch& batch );
+    Stats   GetStats  () const;
+    void    ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    ID3D11Device*                           m_pDevice;
+    ResourceTracker*                        m_pTracker;     // バッファとテクスチャの使用量の登録先 (nullptr 可).
+    ID3D11Buffer*                           m_pInstanceBuffer;
+    ID3D11InputLayout*                      m_pInputLayout;
+    ID3D11VertexShader*                     m_pVertexShader;
+    ID3D11PixelShader*                      m_pPixelShader;
+    ID3D11SamplerState*                     m_pSampler;
+    ID3D11RasterizerState*                  m_pRasterizer;
+    ID3D11DepthStencilState*                m_pDepthStencil;
+    ID3D11BlendState*                       m_pBlend[SPRITE_BLEND_COUNT];
+    std::vector<ID3D11ShaderResourceView*>  m_Textures;
+    UINT                                    m_MaxInstances;
+    Stats                                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool    CreateShaders();
+    bool    CreateStates ();
+
+    SpriteRenderer             ( const SpriteRenderer& );   // アクセス禁止.
+    SpriteRenderer& operator = ( const SpriteRenderer& );   // アクセス禁止.
+};
+
+#endif//__SPRITE_RENDERER_H__
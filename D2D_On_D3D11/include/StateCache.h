@@ -0,0 +1,295 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : StateCache.h
+// Desc : Redundant State Filter and Pipeline State Objects.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __STATE_CACHE_H__
+#define __STATE_CACHE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+//-------------------------------------------------------------------------------------------------
+// Forward Declarations.
+//-------------------------------------------------------------------------------------------------
+struct ID3D11DeviceContext;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RENDER_CALL enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum RENDER_CALL
+{
+    RENDER_CALL_TARGETS = 0,        //!< OMSetRenderTargets() です.
+    RENDER_CALL_INPUT_LAYOUT,       //!< IASetInputLayout() です.
+    RENDER_CALL_VERTEX_BUFFER,      //!< IASetVertexBuffers() です.
+    RENDER_CALL_TOPOLOGY,           //!< IASetPrimitiveTopology() です.
+    RENDER_CALL_VERTEX_SHADER,      //!< VSSetShader() です.
+    RENDER_CALL_PIXEL_SHADER,       //!< PSSetShader() です.
+    RENDER_CALL_BLEND,              //!< OMSetBlendState() です.
+    RENDER_CALL_DEPTH_STENCIL,      //!< OMSetDepthStencilState() です.
+    RENDER_CALL_RASTERIZER,         //!< RSSetState() です.
+    RENDER_CALL_TEXTURE,            //!< PSSetShaderResources() です.
+    RENDER_CALL_SAMPLER,            //!< PSSetSamplers() です.
+    RENDER_CALL_INSTANCE_BUFFER,    //!< スロット 1 の IASetVertexBuffers() です.
+    RENDER_CALL_DRAW,               //!< Draw() と DrawInstanced() です.
+    RENDER_CALL_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PipelineDesc structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct PipelineDesc
+{
+    void*       pInputLayout;       //!< 入力レイアウトです.
+    void*       pVertexShader;      //!< 頂点シェーダです.
+    void*       pPixelShader;       //!< ピクセルシェーダです.
+    void*       pBlendState;        //!< ブレンドステートです (nullptr で既定値).
+    void*       pDepthStencilState; //!< 深度ステンシルステートです (nullptr で既定値).
+    void*       pRasterizerState;   //!< ラスタライザーステートです (nullptr で既定値).
+    uint32_t    Topology;           //!< プリミティブトポロジーです (D3D11_PRIMITIVE_TOPOLOGY の値).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderContext class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class RenderContext
+{
+public:
+    virtual ~RenderContext() { /* DO_NOTHING */ }
+
+    //! @brief      レンダーターゲットと深度ステンシルビューを設定します.
+    virtual void    SetRenderTargets( void* pRenderTarget, void* pDepthStencil ) = 0;
+
+    //! @brief      入力レイアウトを設定します.
+    virtual void    SetInputLayout( void* pInputLayout ) = 0;
+
+    //! @brief      スロット 0 の頂点バッファを設定します.
+    virtual void    SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) = 0;
+
+    //! @brief      プリミティブトポロジーを設定します.
+    virtual void    SetTopology( uint32_t topology ) = 0;
+
+    //! @brief      頂点シェーダを設定します.
+    virtual void    SetVertexShader( void* pShader ) = 0;
+
+    //! @brief      ピクセルシェーダを設定します.
+    virtual void    SetPixelShader( void* pShader ) = 0;
+
+    //! @brief      ブレンドステートを設定します.
+    virtual void    SetBlendState( void* pState ) = 0;
+
+    //! @brief      深度ステンシルステートを設定します.
+    virtual void    SetDepthStencilState( void* pState ) = 0;
+
+    //! @brief      ラスタライザーステートを設定します.
+    virtual void    SetRasterizerState( void* pState ) = 0;
+
+    //! @brief      ピクセルシェーダのスロット 0 のテクスチャを設定します.
+    virtual void    SetTexture( void* pTexture ) = 0;
+
+    //! @brief      ピクセルシェーダのスロット 0 のサンプラーを設定します.
+    virtual void    SetSampler( void* pSampler ) = 0;
+
+    //! @brief      スロット 1 のインスタンスごとの頂点バッファを設定します.
+    virtual void    SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) = 0;
+
+    //! @brief      描画します.
+    virtual void    Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance ) = 0;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// D3D11RenderContext class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class D3D11RenderContext : public RenderContext
+{
+public:
+    D3D11RenderContext();
+    virtual ~D3D11RenderContext();
+
+    void            SetContext( ID3D11DeviceContext* pContext );
+
+    virtual void    SetRenderTargets( void* pRenderTarget, void* pDepthStencil ) override;
+    virtual void    SetInputLayout( void* pInputLayout ) override;
+    virtual void    SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) override;
+    virtual void    SetTopology( uint32_t topology ) override;
+    virtual void    SetVertexShader( void* pShader ) override;
+    virtual void    SetPixelShader( void* pShader ) override;
+    virtual void    SetBlendState( void* pState ) override;
+    virtual void    SetDepthStencilState( void* pState ) override;
+    virtual void    SetRasterizerState( void* pState ) override;
+    virtual void    SetTexture( void* pTexture ) override;
+    virtual void    SetSampler( void* pSampler ) override;
+    virtual void    SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) override;
+    virtual void    Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance ) override;
+
+private:
+    ID3D11DeviceContext*    m_pContext;     // 参照カウントは増やしません.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RecordingRenderContext class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class RecordingRenderContext : public RenderContext
+{
+public:
+    RecordingRenderContext();
+    virtual ~RecordingRenderContext();
+
+    virtual void    SetRenderTargets( void* pRenderTarget, void* pDepthStencil ) override;
+    virtual void    SetInputLayout( void* pInputLayout ) override;
+    virtual void    SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) override;
+    virtual void    SetTopology( uint32_t topology ) override;
+    virtual void    SetVertexShader( void* pShader ) override;
+    virtual void    SetPixelShader( void* pShader ) override;
+    virtual void    SetBlendState( void* pState ) override;
+    virtual void    SetDepthStencilState( void* pState ) override;
+    virtual void    SetRasterizerState( void* pState ) override;
+    virtual void    SetTexture( void* pTexture ) override;
+    virtual void    SetSampler( void* pSampler ) override;
+    virtual void    SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset ) override;
+    virtual void    Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance ) override;
+
+    void        Reset       ();
+    uint64_t    GetCallCount( RENDER_CALL call ) const;
+    uint64_t    GetStateCallCount() const;
+    uint64_t    GetChecksum () const;
+
+private:
+    uintptr_t   m_State[RENDER_CALL_COUNT];     // 呼び出しの種類ごとの現在のステート.
+    uintptr_t   m_DepthStencil;                 // 現在の深度ステンシルビュー.
+    uint32_t    m_Stride;                       // 現在の頂点ストライド.
+    uint32_t    m_Offset;                       // 現在の頂点バッファのオフセット.
+    uint32_t    m_InstanceStride;               // 現在のインスタンスバッファのストライド.
+    uint32_t    m_InstanceOffset;               // 現在のインスタンスバッファのオフセット.
+    uint64_t    m_CallCount[RENDER_CALL_COUNT];
+    uint64_t    m_Checksum;                     // 描画ごとに現在のステートを畳み込んだハッシュ.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// StateCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class StateCache
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    Issued[RENDER_CALL_COUNT];  //!< コンテキストに発行した呼び出し数です.
+        uint64_t    Elided[RENDER_CALL_COUNT];  //!< 現在のステートと同じため省いた呼び出し数です.
+        uint64_t    PipelineChangeCount;        //!< SetPipeline() でパイプラインが切り替わった回数です.
+        uint64_t    PipelineHitCount;           //!< SetPipeline() で同じパイプラインが指定された回数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    StateCache();
+    ~StateCache();
+
+    bool                    Init            ( RenderContext* pContext );
+    void                    Term            ();
+    uint32_t                CreatePipeline  ( const PipelineDesc& desc );
+    const PipelineDesc&     GetPipeline     ( uint32_t pipeline ) const;
+    uint32_t                GetPipelineCount() const;
+    void                    SetEnabled      ( bool enabled );
+    bool                    IsEnabled       () const;
+    void                    Invalidate      ();
+
+    void    SetRenderTargets( void* pRenderTarget, void* pDepthStencil );
+    void    SetPipeline     ( uint32_t pipeline );
+    void    SetVertexBuffer ( void* pBuffer, uint32_t stride, uint32_t offset );
+    void    SetTexture      ( void* pTexture );
+    void    SetSampler      ( void* pSampler );
+    void    SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset );
+    void    Draw            ( uint32_t vertexCount, uint32_t startVertex );
+    void    DrawInstanced   ( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance );
+
+    Stats   GetStats        () const;
+    void    ResetStats      ();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // PipelineState structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct PipelineState
+    {
+        PipelineDesc    Desc;       //!< 作成時の記述です. 作成後は変更しません.
+        uint64_t        Hash;       //!< 記述のハッシュです.
+        uint32_t        Next;       //!< 同じハッシュを持つ次のパイプラインです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // BoundState structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct BoundState
+    {
+        void*           pRenderTarget;  //!< レンダーターゲットビューです.
+        void*           pDepthStencil;  //!< 深度ステンシルビューです.
+        PipelineDesc    Pipeline;       //!< パイプラインを構成するステートです.
+        uint32_t        PipelineId;     //!< 最後に設定したパイプラインです.
+        void*           pVertexBuffer;  //!< 頂点バッファです.
+        uint32_t        Stride;         //!< 頂点ストライドです.
+        uint32_t        Offset;         //!< 頂点バッファのオフセットです.
+        void*           pTexture;       //!< テクスチャです.
+        void*           pSampler;       //!< サンプラーです.
+        void*           pInstanceBuffer;    //!< インスタンスバッファです.
+        uint32_t        InstanceStride;     //!< インスタンスバッファのストライドです.
+        uint32_t        InstanceOffset;     //!< インスタンスバッファのオフセットです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    RenderContext*                          m_pContext;
+    std::vector<PipelineState>              m_Pipelines;
+    std::unordered_map<uint64_t, uint32_t>  m_PipelineMap;  // ハッシュから最初のパイプラインへの対応.
+    BoundState                              m_Bound;
+    uint32_t                                m_ValidMask;    // m_Bound の内容が確かな呼び出しの種類 (1 << RENDER_CALL).
+    bool                                    m_Enabled;
+    Stats                                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    bool    NeedsCall( RENDER_CALL call, bool same );
+
+    StateCache             ( const StateCache& );   // アクセス禁止.
+    StateCache& operator = ( const StateCache& );   // アクセス禁止.
+};
+
+#endif//__STATE_CACHE_H__
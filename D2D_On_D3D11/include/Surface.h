@@ -0,0 +1,80 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Surface.h
+// Desc : CPU Pixel Surface (Premultiplied B8G8R8A8).
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SURFACE_H__
+#define __SURFACE_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Surface class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Surface
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   Alignment = 64;     // 先頭アドレスと行ピッチのアライメント.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    Surface();
+    ~Surface();
+
+    bool        Init( uint32_t width, uint32_t height );
+    void        Term();
+    void        Clear( uint32_t color );
+    bool        IsValid  () const;
+    uint32_t    GetWidth () const;
+    uint32_t    GetHeight() const;
+    uint32_t    GetPitch () const;
+    uint8_t*    GetPixels();
+    const uint8_t*  GetPixels() const;
+    uint32_t*       GetRow( uint32_t y );
+    const uint32_t* GetRow( uint32_t y ) const;
+
+    static uint32_t PackColor( float r, float g, float b, float a );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    uint8_t*    m_pPixels;
+    uint32_t    m_Width;
+    uint32_t    m_Height;
+    uint32_t    m_Pitch;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    Surface             ( const Surface& );     // アクセス禁止.
+    Surface& operator = ( const Surface& );     // アクセス禁止.
+};
+
+#endif//__SURFACE_H__
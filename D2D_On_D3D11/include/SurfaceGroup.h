@@ -0,0 +1,160 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SurfaceGroup.h
+// Desc : Offscreen Render Surface Group.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SURFACE_GROUP_H__
+#define __SURFACE_GROUP_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <d2d1_2.h>
+#include <dwrite.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <ThreadPool.h>
+#include <ResourceTracker.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLayoutCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TextLayoutCache
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TextLayoutCache();
+    ~TextLayoutCache();
+
+    bool                Init( IDWriteFactory* pFactory, IDWriteTextFormat* pFormat, FLOAT maxWidth, FLOAT maxHeight );
+    void                Term();
+    IDWriteTextLayout*  GetLayout( const std::wstring& text );
+    UINT                GetHitCount () const;
+    UINT                GetMissCount() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    IDWriteFactory*                                 m_pFactory;
+    IDWriteTextFormat*                              m_pFormat;
+    FLOAT                                           m_MaxWidth;
+    FLOAT                                           m_MaxHeight;
+    std::map<std::wstring, IDWriteTextLayout*>      m_Layouts;
+    mutable std::mutex                              m_Mutex;
+    UINT                                            m_HitCount;
+    UINT                                            m_MissCount;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    TextLayoutCache         ( const TextLayoutCache& );     // アクセス禁止.
+    TextLayoutCache& operator=( const TextLayoutCache& );   // アクセス禁止.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SurfaceGroup class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SurfaceGroup
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SurfaceGroup();
+    ~SurfaceGroup();
+
+    bool            Init(
+                        ID2D1Device*        pDevice,
+                        IDWriteFactory*     pDWriteFactory,
+                        IDWriteTextFormat*  pTextFormat,
+                        UINT                surfaceCount,
+                        UINT                width,
+                        UINT                height,
+                        ResourceTracker*    pTracker = nullptr );
+    void            Term();
+    void            Render( ThreadPool& pool, UINT frameIndex );
+    UINT            GetSurfaceCount() const;
+    ID2D1Bitmap1*   GetBitmap( UINT index ) const;
+    const TextLayoutCache& GetLayoutCache() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Surface structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Surface
+    {
+        ID2D1DeviceContext*     pContext;   //!< 描画スレッドごとに独立したデバイスコンテキストです.
+        ID2D1Bitmap1*           pTarget;    //!< 描画先ビットマップです.
+        ID2D1SolidColorBrush*   pBrush;     //!< 色を変更するのでサーフェイスごとに持ちます.
+        std::wstring            Title;      //!< パネルのタイトルです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<Surface>    m_Surfaces;
+    TextLayoutCache         m_LayoutCache;
+    ResourceTracker*        m_pTracker;     // 描画先ビットマップの使用量の登録先 (nullptr 可).
+    UINT                    m_Width;
+    UINT                    m_Height;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void RenderSurface( UINT index, UINT frameIndex );
+
+    SurfaceGroup            ( const SurfaceGroup& );    // アクセス禁止.
+    SurfaceGroup& operator= ( const SurfaceGroup& );    // アクセス禁止.
+};
+
+#endif//__SURFACE_GROUP_H__
@@ -0,0 +1,87 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SurfacePool.h
+// Desc : Pooled Offscreen Surface Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __SURFACE_POOL_H__
+#define __SURFACE_POOL_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Surface.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SurfacePool class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class SurfacePool
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    AcquireCount;       //!< Acquire() の呼び出し回数です.
+        uint64_t    ReuseCount;         //!< 解放済みのサーフェイスを再利用した回数です.
+        uint64_t    AllocCount;         //!< 新たにサーフェイスを確保した回数です.
+        uint32_t    LiveCount;          //!< 確保済みのサーフェイス数です.
+        uint32_t    FreeCount;          //!< 再利用待ちのサーフェイス数です.
+        uint64_t    LiveBytes;          //!< 確保済みのサーフェイスの合計サイズです.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    SurfacePool();
+    ~SurfacePool();
+
+    Surface*    Acquire( uint32_t width, uint32_t height );
+    void        Release( Surface* pSurface );
+    void        Trim();
+    void        Term();
+    Stats       GetStats() const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<std::unique_ptr<Surface>>   m_Surfaces;     // 確保した全サーフェイス.
+    std::vector<Surface*>                   m_Free;
+    Stats                                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    SurfacePool             ( const SurfacePool& );     // アクセス禁止.
+    SurfacePool& operator = ( const SurfacePool& );     // アクセス禁止.
+};
+
+#endif//__SURFACE_POOL_H__
@@ -0,0 +1,261 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Tessellator.h
+// Desc : Vector Path Tessellator.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TESSELLATOR_H__
+#define __TESSELLATOR_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FILL_RULE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum FILL_RULE
+{
+    FILL_RULE_EVEN_ODD = 0,     //!< 偶奇規則です.
+    FILL_RULE_NONZERO,          //!< 非ゼロ規則です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LINE_JOIN enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum LINE_JOIN
+{
+    LINE_JOIN_MITER = 0,        //!< マイター結合です. 制限を超えるとベベルになります.
+    LINE_JOIN_BEVEL,            //!< ベベル結合です.
+    LINE_JOIN_ROUND,            //!< ラウンド結合です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LINE_CAP enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum LINE_CAP
+{
+    LINE_CAP_BUTT = 0,          //!< 端点で切り落とします.
+    LINE_CAP_SQUARE,            //!< 線幅の半分だけ四角く延長します.
+    LINE_CAP_ROUND,             //!< 半円で丸めます.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// MeshVertex structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct MeshVertex
+{
+    float   Position[3];        //!< 位置座標です.
+    float   Color[4];           //!< 頂点カラーです.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// StrokeStyle structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct StrokeStyle
+{
+    float       Width;          //!< 線幅です.
+    LINE_JOIN   Join;           //!< 結合方法です.
+    LINE_CAP    Cap;            //!< 端点の形状です.
+    float       MiterLimit;     //!< マイター長の線幅に対する上限です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Path class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Path
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // VERB enum
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    enum VERB
+    {
+        VERB_MOVE = 0,          //!< 新しい輪郭を開始します (点1つ).
+        VERB_LINE,              //!< 直線です (点1つ).
+        VERB_QUAD,              //!< 2次ベジェ曲線です (点2つ).
+        VERB_CUBIC,             //!< 3次ベジェ曲線です (点3つ).
+        VERB_CLOSE,             //!< 輪郭を閉じます (点なし).
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    Path();
+
+    void    MoveTo ( float x, float y );
+    void    LineTo ( float x, float y );
+    void    QuadTo ( float cx, float cy, float x, float y );
+    void    CubicTo( float c0x, float c0y, float c1x, float c1y, float x, float y );
+    void    Close  ();
+    void    Clear  ();
+    bool    IsEmpty() const;
+
+    uint64_t                    GetHash  () const;
+    const std::vector<uint8_t>& GetVerbs () const;
+    const std::vector<float>&   GetPoints() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<uint8_t>    m_Verbs;
+    std::vector<float>      m_Points;   // x, y の順に格納.
+    uint64_t                m_Hash;     // 追加のたびに更新する FNV-1a ハッシュ.
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void AddVerb ( VERB verb );
+    void AddPoint( float x, float y );
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Tessellator class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Tessellator
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    Tessellator();
+
+    void    SetTolerance( float pixels );
+    float   GetTolerance() const;
+    void    Fill  ( const Path& path, FILL_RULE rule, float scale, const float color[4], std::vector<MeshVertex>& vertices );
+    void    Stroke( const Path& path, const StrokeStyle& style, float scale, const float color[4], std::vector<MeshVertex>& vertices );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Point structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Point
+    {
+        float   X;              //!< X座標です.
+        float   Y;              //!< Y座標です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Contour structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Contour
+    {
+        size_t  Begin;          //!< 先頭の点のインデックスです.
+        size_t  End;            //!< 終端の次の点のインデックスです.
+        bool    Closed;         //!< 閉じた輪郭かどうかです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Edge structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Edge
+    {
+        float   X0;             //!< 上端のX座標です.
+        float   Y0;             //!< 上端のY座標です.
+        float   Y1;             //!< 下端のY座標です.
+        float   DxDy;           //!< Yに対するXの傾きです.
+        int     Winding;        //!< 元の向きが +Y なら 1, -Y なら -1 です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // ActiveEdge structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct ActiveEdge
+    {
+        uint32_t    Index;      //!< 辺のインデックスです.
+        float       XTop;       //!< スラブ上端でのX座標です.
+        float       XBottom;    //!< スラブ下端でのX座標です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Span structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Span
+    {
+        uint32_t    Left;       //!< 左側の辺のインデックスです.
+        uint32_t    Right;      //!< 右側の辺のインデックスです.
+        float       YStart;     //!< 台形の開始Y座標です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    float                       m_Tolerance;    // デバイスピクセル単位の許容誤差.
+    std::vector<Point>          m_Points;
+    std::vector<Contour>        m_Contours;
+    std::vector<Point>          m_Directions;
+    std::vector<Edge>           m_Edges;
+    std::vector<uint32_t>       m_EdgeOrder;
+    std::vector<float>          m_SweepY;
+    std::vector<ActiveEdge>     m_Active;
+    std::vector<Span>           m_Open;
+    std::vector<Span>           m_NextOpen;
+    std::vector<int32_t>        m_OpenIndex;    // 左側の辺から m_Open へのインデックス.
+    std::vector<MeshVertex>*    m_pOutput;
+    float                       m_Color[4];
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    Flatten      ( const Path& path, float tolerance );
+    void    SweepSlab    ( FILL_RULE rule, float yTop );
+    void    FlushSpans   ( float y );
+    void    EmitTrapezoid( const Span& span, float yEnd );
+    void    EmitTriangle ( float x0, float y0, float x1, float y1, float x2, float y2 );
+    void    EmitJoin     ( const StrokeStyle& style, const Point& p, const Point& d0, const Point& d1, float halfWidth, float tolerance );
+    void    EmitCap      ( const StrokeStyle& style, const Point& p, const Point& d, float halfWidth, float tolerance );
+    void    EmitArc      ( const Point& center, float radius, float startAngle, float sweepAngle, float tolerance );
+};
+
+#endif//__TESSELLATOR_H__
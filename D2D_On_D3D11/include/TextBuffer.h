@@ -0,0 +1,133 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextBuffer.h
+// Desc : Piece Table Text Buffer with Sparse Line Index.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TEXT_BUFFER_H__
+#define __TEXT_BUFFER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <MappedFile.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextBuffer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TextBuffer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   LineIndexStride = 64;           // 行インデックスに位置を記録する改行の間隔.
+    static const uint64_t   NoChange        = UINT64_MAX;   // GetChangedLine() の変更無しを表す値.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TextBuffer();
+    ~TextBuffer();
+
+    bool        Open ( const char* path );
+    bool        Init ( const char* pText, size_t length );
+    void        Term ();
+
+    bool        Insert( uint64_t offset, const char* pText, size_t length );
+    bool        Erase ( uint64_t offset, uint64_t length );
+    bool        Append( const char* pText, size_t length );
+
+    uint64_t    GetLength      () const;
+    uint64_t    GetLineCount   () const;
+    uint64_t    GetLineStart   ( uint64_t line ) const;
+    uint64_t    GetLineOfOffset( uint64_t offset ) const;
+    bool        GetLine        ( uint64_t line, std::string& result, size_t maxBytes ) const;
+    size_t      GetPieceCount  () const;
+    size_t      GetMemoryUsage () const;
+
+    uint64_t    GetChangedLine  () const;
+    void        ClearChangedLine();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // SOURCE_TYPE enum
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    enum SOURCE_TYPE
+    {
+        SOURCE_ORIGINAL = 0,            //!< 読み込んだ元の文字列 (読み取り専用) です.
+        SOURCE_ADDED,                   //!< 挿入した文字列を追記していくバッファです.
+        SOURCE_COUNT,
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Source structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Source
+    {
+        const char*             pData;      //!< 先頭アドレスです. 追記バッファでは再確保のたびに更新します.
+        uint64_t                Size;       //!< バイト数です.
+        uint64_t                LineFeeds;  //!< 含まれる改行の数です.
+        std::vector<uint64_t>   Marks;      //!< LineIndexStride 個ごとの改行の直後の位置です ([0] は先頭).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Piece structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Piece
+    {
+        uint32_t    Source;             //!< 参照する文字列の種類 (SOURCE_TYPE) です.
+        uint64_t    Start;              //!< 参照する文字列内の開始位置です.
+        uint64_t    Length;             //!< バイト数です.
+        uint64_t    LineFeeds;          //!< 含まれる改行の数です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    MappedFile              m_File;
+    std::vector<char>       m_Original;         // Init() で渡された文字列のコピー.
+    std::vector<char>       m_Added;            // 追記バッファ.
+    Source                  m_Sources[SOURCE_COUNT];
+    std::vector<Piece>      m_Pieces;
+    std::vector<uint64_t>   m_PieceOffsets;     // 各ピースの先頭の文書内の位置 (末尾に全長).
+    std::vector<uint64_t>   m_PieceLines;       // 各ピースより前の改行の数 (末尾に総数).
+    uint64_t                m_ChangedLine;      // 最後に ClearChangedLine() してから変更された最初の行.
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void        IndexSource   ( Source& source, uint64_t from );
+    uint64_t    CountLineFeeds( const Source& source, uint64_t pos ) const;
+    uint64_t    FindLineFeed  ( const Source& source, uint64_t index ) const;
+    size_t      FindPiece     ( uint64_t offset ) const;
+    size_t      SplitPiece    ( uint64_t offset );
+    void        UpdatePrefix  ( size_t first );
+    void        MarkChanged   ( uint64_t offset );
+
+    TextBuffer             ( const TextBuffer& );   // アクセス禁止.
+    TextBuffer& operator = ( const TextBuffer& );   // アクセス禁止.
+};
+
+#endif//__TEXT_BUFFER_H__
@@ -0,0 +1,182 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextLayout.h
+// Desc : Incremental Paragraph Text Layout.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TEXT_LAYOUT_H__
+#define __TEXT_LAYOUT_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <FontFace.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TEXT_ALIGNMENT enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum TEXT_ALIGNMENT
+{
+    TEXT_ALIGNMENT_LEADING = 0,         //!< 左揃えです.
+    TEXT_ALIGNMENT_TRAILING,            //!< 右揃えです.
+    TEXT_ALIGNMENT_CENTER,              //!< 中央揃えです.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLine structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TextLine
+{
+    uint32_t    Begin;                  //!< 段落内の先頭のクラスタ番号です.
+    uint32_t    End;                    //!< 段落内の終端のクラスタ番号です (行末の空白を含みます).
+    float       Width;                  //!< 行末の空白を除いた幅 (ピクセル) です.
+    float       Offset;                 //!< 段落の先頭から行頭までの距離です.
+    float       X;                      //!< 揃えを適用した左端の位置です.
+    float       Baseline;               //!< ベースラインの位置です (文書の先頭から).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLayout class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TextLayout
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    ShapeCount;         //!< 整形 (グリフ化) した段落数です.
+        uint64_t    UpdateCount;        //!< Update() の呼び出し回数です.
+        uint64_t    ReflowCount;        //!< 行分割をやり直した段落数です.
+        uint64_t    SkipCount;          //!< 行分割が有効なままで再利用した段落数です.
+        uint64_t    TestCount;          //!< 行分割で改行位置やクラスタの幅を比較した回数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TextLayout();
+    ~TextLayout();
+
+    bool        Init ( const FontFace* pFace, float fontSize );
+    void        Term ();
+    void        Clear();
+
+    uint32_t    AddParagraph( const uint32_t* pText, uint32_t length );
+    void        AddText     ( const char* pUtf8, size_t length );
+
+    void        SetMaxWidth ( float width );
+    void        SetAlignment( TEXT_ALIGNMENT alignment );
+    void        Invalidate  ();
+    uint32_t    Update      ();
+
+    float       GetMaxWidth      () const;
+    float       GetLineHeight    () const;
+    float       GetHeight        () const;
+    uint32_t    GetParagraphCount() const;
+    uint32_t    GetLineCount     () const;
+    uint32_t    GetLineCount     ( uint32_t paragraph ) const;
+    bool        GetLine          ( uint32_t paragraph, uint32_t line, TextLine& result ) const;
+    float       GetParagraphTop  ( uint32_t paragraph ) const;
+    uint32_t    FindParagraph    ( float y ) const;
+
+    const uint16_t* GetGlyphs     ( uint32_t paragraph ) const;
+    const float*    GetClusterEnds( uint32_t paragraph ) const;
+    size_t          GetMemoryUsage() const;
+
+    Stats       GetStats  () const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Line structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Line
+    {
+        uint32_t    End;                //!< 段落内の終端のクラスタ番号です (先頭は前の行の End).
+        float       Width;              //!< 行末の空白を除いた幅です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // BreakPoint structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct BreakPoint
+    {
+        uint32_t    Pos;                //!< 改行できる位置 (段落内のクラスタ番号) です. 最後は段落末です.
+        float       Visible;            //!< 段落の先頭からこの位置までの行末の空白を除いた幅です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Paragraph structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Paragraph
+    {
+        uint32_t            First;      //!< クラスタ配列の先頭位置です.
+        uint32_t            Count;      //!< クラスタ数です.
+        uint32_t            BreakFirst; //!< 改行位置の配列の先頭位置です.
+        uint32_t            BreakCount; //!< 改行位置の数です (段落末を含みます).
+        float               MinWidth;   //!< 現在の行分割が有効な最小の幅です.
+        float               MaxWidth;   //!< 現在の行分割が有効な幅の上限です (この値は含みません).
+        std::vector<Line>   Lines;      //!< 行です. 空の段落も 1 行とします.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    const FontFace*         m_pFace;
+    float                   m_FontSize;
+    float                   m_Scale;            // フォント単位からピクセルへの倍率.
+    float                   m_LineHeight;
+    float                   m_Ascent;
+    float                   m_MaxWidth;
+    TEXT_ALIGNMENT          m_Alignment;
+    std::vector<uint16_t>   m_Glyphs;           // 全段落のクラスタごとのグリフ番号.
+    std::vector<float>      m_Ends;             // 全段落のクラスタごとの右端の位置 (段落の先頭からの累積, ピクセル).
+    std::vector<uint8_t>    m_Flags;            // 全段落のクラスタごとのフラグ.
+    std::vector<BreakPoint> m_Breaks;           // 全段落の改行位置.
+    std::vector<Paragraph>  m_Paragraphs;
+    std::vector<uint32_t>   m_LineTree;         // 段落ごとの行数の Fenwick 木.
+    uint32_t                m_LineCount;
+    bool                    m_Invalid;          // 全段落の行分割をやり直すかどうか.
+    Stats                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void        Reflow( Paragraph& paragraph );
+    void        AddLineCount( uint32_t paragraph, int32_t delta );
+    uint32_t    GetLineOffset( uint32_t paragraph ) const;
+
+    TextLayout             ( const TextLayout& );   // アクセス禁止.
+    TextLayout& operator = ( const TextLayout& );   // アクセス禁止.
+};
+
+#endif//__TEXT_LAYOUT_H__
@@ -0,0 +1,150 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextView.h
+// Desc : Virtualized Text View with Line Strip Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TEXT_VIEW_H__
+#define __TEXT_VIEW_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <FontFace.h>
+#include <GlyphRasterizer.h>
+#include <Surface.h>
+#include <TextBuffer.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextView class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TextView
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    FrameCount;         //!< Draw() の呼び出し回数です.
+        uint64_t    StripHitCount;      //!< 描画済みの行ストリップを再利用した回数です.
+        uint64_t    StripMissCount;     //!< 行を整形してストリップに描画した回数です.
+        uint64_t    GlyphHitCount;      //!< キャッシュ済みのグリフを使った回数です.
+        uint64_t    GlyphMissCount;     //!< グリフをラスタライズした回数です.
+        uint64_t    GlyphEvictCount;    //!< 容量超過で破棄したグリフ数です.
+        double      ShapeMsec;          //!< 行の取得, 整形, ストリップへの描画にかかった合計時間 (ミリ秒) です.
+        double      ComposeMsec;        //!< ストリップをサーフェイスへ合成した合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MaxLineBytes = 4096;    // 1 行から整形する最大バイト数 (それ以降は表示範囲外とみなします).
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TextView();
+    ~TextView();
+
+    bool        Init ( const FontFace* pFace, float fontSize, uint32_t width, uint32_t height, size_t glyphBudget = 4 * 1024 * 1024 );
+    void        Term ();
+    bool        Resize( uint32_t width, uint32_t height );
+    void        SetBuffer( TextBuffer* pBuffer );
+    void        SetColors( uint32_t textColor, uint32_t backColor );
+    void        Invalidate();
+
+    void        ScrollTo( double y );
+    void        ScrollBy( double dy );
+    void        ScrollToLine( uint64_t line );
+    double      GetScroll       () const;
+    double      GetContentHeight() const;
+    uint32_t    GetLineHeight   () const;
+    uint64_t    GetFirstVisibleLine() const;
+
+    bool        Draw( Surface& target );
+
+    size_t      GetMemoryUsage() const;
+    Stats       GetStats  () const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Strip structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Strip
+    {
+        uint64_t    Line;               //!< 描画済みの行番号です. 未使用の場合は UINT64_MAX です.
+        uint32_t    InkWidth;           //!< カバレッジを持つ右端の列 + 1 です. 空の行では 0 です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // GlyphEntry structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct GlyphEntry
+    {
+        GlyphBitmap     Bitmap;         //!< ラスタライズ結果です.
+        float           Advance;        //!< 送り幅 (ピクセル) です.
+        uint64_t        LastFrame;      //!< 最後に使用したフレーム番号です.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    const FontFace*                 m_pFace;
+    TextBuffer*                     m_pBuffer;
+    GlyphRasterizer                 m_Rasterizer;
+    GlyphOutline                    m_Outline;
+    std::map<uint32_t, GlyphEntry>  m_Glyphs;       // グリフ番号ごとのビットマップ.
+    std::vector<uint8_t>            m_StripPixels;  // 全ストリップの A8 カバレッジ (ストリップごとに幅 x 行の高さ).
+    std::vector<Strip>              m_Strips;       // 行番号 % ストリップ数 の位置に行を保持するリング.
+    std::string                     m_LineText;
+    float                           m_Scale;
+    uint32_t                        m_LineHeight;
+    uint32_t                        m_Baseline;
+    float                           m_TabWidth;
+    uint32_t                        m_Width;
+    uint32_t                        m_Height;
+    uint32_t                        m_TextColor;
+    uint32_t                        m_BackColor;
+    double                          m_ScrollY;
+    size_t                          m_GlyphBudget;
+    size_t                          m_GlyphBytes;
+    uint64_t                        m_FrameIndex;
+    Stats                           m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    const uint8_t*      GetStrip  ( uint64_t line, uint32_t& inkWidth );
+    uint32_t            RenderLine( uint64_t line, uint8_t* pPixels );
+    const GlyphEntry*   FindGlyph ( uint32_t glyph );
+    void                EvictGlyphs();
+
+    TextView             ( const TextView& );   // アクセス禁止.
+    TextView& operator = ( const TextView& );   // アクセス禁止.
+};
+
+#endif//__TEXT_VIEW_H__
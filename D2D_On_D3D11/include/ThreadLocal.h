@@ -0,0 +1,22 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ThreadLocal.h
+// Desc : Thread Local Storage Specifier.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __THREAD_LOCAL_H__
+#define __THREAD_LOCAL_H__
+
+
+//-------------------------------------------------------------------------------------------------
+// Macros.
+//-------------------------------------------------------------------------------------------------
+// VS2013 は thread_local に未対応なので処理系の拡張を使う.
+// どちらも静的初期化のみ可能で, デストラクタを持つ型には使えない.
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#endif//__THREAD_LOCAL_H__
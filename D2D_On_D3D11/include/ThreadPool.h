@@ -0,0 +1,101 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ThreadPool.h
+// Desc : Work Stealing Thread Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    typedef std::function<void()>           Task;
+    typedef std::function<void(uint32_t)>   IndexedTask;
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    ThreadPool();
+    ~ThreadPool();
+
+    bool        Init( uint32_t threadCount = 0 );
+    void        Term();
+    void        Submit( const Task& task );
+    void        ParallelFor( uint32_t count, const IndexedTask& task );
+    void        Wait();
+    uint32_t    GetThreadCount() const;
+    uint64_t    GetStealCount() const;
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // WorkQueue structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct WorkQueue
+    {
+        std::mutex          Mutex;      //!< 排他制御用ミューテックスです.
+        std::deque<Task>    Tasks;      //!< 所有スレッドは末尾から, 他スレッドは先頭から取り出します.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+    std::vector<std::thread>                m_Threads;
+    std::mutex                              m_SleepMutex;
+    std::condition_variable                 m_SleepCond;
+    std::atomic<int32_t>                    m_QueuedCount;      // キューに積まれている数.
+    std::atomic<int32_t>                    m_UnfinishedCount;  // 未完了の数 (実行中を含む).
+    std::atomic<uint32_t>                   m_NextQueue;
+    std::atomic<uint64_t>                   m_StealCount;
+    std::atomic<bool>                       m_Exit;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void WorkerProc( uint32_t index );
+    bool TryRunTask( uint32_t index );
+    bool TryPopLocal( uint32_t index, Task& task );
+    bool TrySteal( uint32_t index, Task& task );
+
+    ThreadPool              ( const ThreadPool& );      // アクセス禁止.
+    ThreadPool& operator =  ( const ThreadPool& );      // アクセス禁止.
+};
+
+#endif//__THREAD_POOL_H__
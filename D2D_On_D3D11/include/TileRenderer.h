@@ -0,0 +1,139 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TileRenderer.h
+// Desc : Screen Tile Binning Renderer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TILE_RENDERER_H__
+#define __TILE_RENDERER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <Surface.h>
+#include <ClipStack.h>
+#include <Gradient.h>
+#include <ThreadPool.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TILE_COMMAND_TYPE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum TILE_COMMAND_TYPE
+{
+    TILE_COMMAND_FILL_RECT = 0,         //!< 単色の矩形です.
+    TILE_COMMAND_FILL_GRADIENT,         //!< グラデーションの矩形です.
+    TILE_COMMAND_DRAW_IMAGE,            //!< 乗算済みアルファの画像です.
+    TILE_COMMAND_DRAW_MASK,             //!< A8 カバレッジマスク (グリフ列など) を単色で塗ります.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TileRenderer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TileRenderer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    FrameCount;         //!< Render() の呼び出し回数です.
+        uint64_t    CommandCount;       //!< 描画したコマンド数です.
+        uint64_t    BinCount;           //!< タイルに登録したコマンドの参照数です.
+        uint64_t    OccludedCount;      //!< 不透明な塗りつぶしに隠されて捨てた参照数です.
+        uint64_t    TileCount;          //!< 描画したタイル数です.
+        double      RenderMsec;         //!< Render() にかかった合計時間 (ミリ秒) です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   MaxTileSize = 256;      // タイルの一辺の最大値.
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TileRenderer();
+    ~TileRenderer();
+
+    bool        Init ( uint32_t width, uint32_t height, uint32_t tileSize = 64 );
+    void        Term ();
+    void        Reset();
+    void        SetScissor( const ClipRect* pRect );
+
+    void        FillRect    ( const ClipRect& rect, uint32_t color );
+    void        FillGradient( const ClipRect& rect, const GradientBrush* pBrush );
+    void        DrawImage   ( int x, int y, const Surface* pImage );
+    void        DrawMask    ( int x, int y, uint32_t width, uint32_t height, const uint8_t* pMask, uint32_t pitch, uint32_t color );
+
+    void        Render      ( Surface& target, ThreadPool* pPool );
+    void        RenderDirect( Surface& target ) const;
+
+    uint32_t    GetCommandCount() const;
+    uint32_t    GetTileCount   () const;
+    Stats       GetStats       () const;
+    void        ResetStats     ();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Command structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Command
+    {
+        TILE_COMMAND_TYPE       Type;       //!< コマンドの種類です.
+        ClipRect                Rect;       //!< シザー矩形を適用した描画範囲です.
+        int                     OriginX;    //!< 画像とマスクの左上の X 座標です.
+        int                     OriginY;    //!< 画像とマスクの左上の Y 座標です.
+        uint32_t                Color;      //!< 乗算済み B8G8R8A8 の色です.
+        const GradientBrush*    pBrush;     //!< グラデーションブラシです.
+        const Surface*          pImage;     //!< 画像です.
+        const uint8_t*          pMask;      //!< カバレッジマスクです.
+        uint32_t                MaskPitch;  //!< カバレッジマスクの行ピッチです.
+    };
+
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    uint32_t                            m_Width;
+    uint32_t                            m_Height;
+    uint32_t                            m_TileSize;
+    uint32_t                            m_TileCountX;
+    uint32_t                            m_TileCountY;
+    ClipRect                            m_Scissor;
+    std::vector<Command>                m_Commands;
+    std::vector<std::vector<uint32_t>>  m_Bins;         // タイルごとのコマンド番号 (投入順).
+    std::vector<uint32_t>               m_ActiveTiles;  // コマンドを持つタイル.
+    Stats                               m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void    AddCommand( const Command& command );
+    void    RenderTile( Surface& target, uint32_t tile ) const;
+    static void Execute( const Command& command, Surface& target, const ClipRect& clip, uint32_t* pScratch );
+
+    TileRenderer             ( const TileRenderer& );   // アクセス禁止.
+    TileRenderer& operator = ( const TileRenderer& );   // アクセス禁止.
+};
+
+#endif//__TILE_RENDERER_H__
@@ -0,0 +1,70 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Timer.h
+// Desc : High Resolution Timer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    Timer();
+    void    Reset();
+    int64_t GetElapsedTicks() const;
+    double  GetElapsedSec  () const;
+    double  GetElapsedMsec () const;
+
+    static int64_t GetTicks();
+    static int64_t GetTicksPerSec();
+    static double  ToSec ( int64_t ticks );
+    static double  ToMsec( int64_t ticks );
+    static double  ToNsec( int64_t ticks );
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    int64_t     m_Start;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    /* NOTHING */
+};
+
+#endif//__TIMER_H__
@@ -0,0 +1,122 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TriangleRasterizer.h
+// Desc : Software Triangle Rasterizer with Coverage Mask Antialiasing.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+#ifndef __TRIANGLE_RASTERIZER_H__
+#define __TRIANGLE_RASTERIZER_H__
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Surface.h>
+#include <Tessellator.h>
+#include <DrawTransform.h>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// AA_MODE enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum AA_MODE
+{
+    AA_MODE_NONE = 0,           //!< 画素中心の 1 サンプルです.
+    AA_MODE_MSAA_4X,            //!< 4 サンプルのカバレッジマスクで, シェーディングは画素ごとに 1 回です.
+    AA_MODE_MSAA_8X,            //!< 8 サンプルのカバレッジマスクで, シェーディングは画素ごとに 1 回です.
+    AA_MODE_SSAA_4X,            //!< 縦横 2 倍の解像度で描画して縮小します (サンプルごとにシェーディング).
+    AA_MODE_COUNT,
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TriangleRasterizer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TriangleRasterizer
+{
+    //=============================================================================================
+    // list of friend classes and methods.
+    //=============================================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint64_t    TriangleCount;      //!< 描画した三角形の数です (縮退したものを除く).
+        uint64_t    ShadedCount;        //!< シェーディングを行った回数です.
+        uint64_t    SampleWriteCount;   //!< 書き込んだサンプル数です. 圧縮された画素は 1 と数えます.
+        uint64_t    PartialCount;       //!< 一部のサンプルだけを覆った画素の数です.
+        uint64_t    DecompressCount;    //!< 圧縮された画素を展開した回数です.
+    };
+
+    //=============================================================================================
+    // public variables.
+    //=============================================================================================
+    static const uint32_t   SubPixelBits = 8;   // 頂点座標の固定小数の精度 (1/256 ピクセル).
+
+    //=============================================================================================
+    // public methods.
+    //=============================================================================================
+    TriangleRasterizer();
+    ~TriangleRasterizer();
+
+    bool        Init ( uint32_t width, uint32_t height, AA_MODE mode );
+    void        Term ();
+    void        Clear( uint32_t color );
+    void        DrawTriangles( const MeshVertex* pVertices, size_t count );
+    void        DrawTriangles( const MeshVertex* pVertices, size_t count, const DrawTransform& transform );
+    bool        Resolve      ( Surface& target ) const;
+    bool        ResolveScalar( Surface& target ) const;
+
+    AA_MODE     GetMode       () const;
+    uint32_t    GetSampleCount() const;
+    double      GetCompressedRatio() const;
+    size_t      GetMemoryUsage() const;
+    Stats       GetStats  () const;
+    void        ResetStats();
+
+protected:
+    //=============================================================================================
+    // protected variables.
+    //=============================================================================================
+    /* NOTHING */
+
+    //=============================================================================================
+    // protected methods.
+    //=============================================================================================
+    /* NOTHING */
+
+private:
+    //=============================================================================================
+    // private variables.
+    //=============================================================================================
+    AA_MODE                 m_Mode;
+    uint32_t                m_Width;            // 出力の横幅.
+    uint32_t                m_Height;           // 出力の縦幅.
+    uint32_t                m_BufferWidth;      // 内部バッファの横幅 (SSAA では出力の 2 倍).
+    uint32_t                m_BufferHeight;     // 内部バッファの縦幅 (SSAA では出力の 2 倍).
+    uint32_t                m_SampleCount;      // 内部バッファの画素あたりのサンプル数.
+    float                   m_Scale;            // 頂点座標から内部バッファの座標への倍率.
+    int32_t                 m_OffsetX[8];       // サンプル位置の画素中心からのずれ (固定小数).
+    int32_t                 m_OffsetY[8];
+    std::vector<uint32_t>   m_Samples;          // サンプルごとの面 (乗算済み B8G8R8A8). 面 0 は画素の代表色を兼ねる.
+    std::vector<uint8_t>    m_Compressed;       // 全サンプルが面 0 と同じ色の画素は 1.
+    std::vector<MeshVertex> m_Transformed;      // 描画ごとの変換を適用した頂点 (作業用).
+    Stats                   m_Stats;
+
+    //=============================================================================================
+    // private methods.
+    //=============================================================================================
+    void        DrawTriangle( const MeshVertex& v0, const MeshVertex& v1, const MeshVertex& v2 );
+    void        WritePixel  ( size_t index, uint32_t mask, uint32_t fullMask, uint32_t color );
+
+    TriangleRasterizer             ( const TriangleRasterizer& );   // アクセス禁止.
+    TriangleRasterizer& operator = ( const TriangleRasterizer& );   // アクセス禁止.
+};
+
+#endif//__TRIANGLE_RASTERIZER_H__
@@ -11,6 +11,10 @@ struct VSInput
 {
     float3  Position : POSITION;
     float4  Color    : VTX_COLOR;
+    float4  Row0     : DRAW_TRANSFORM0;     // `悲Ƃ̕ϊs 1 s (CX^Xf[^).
+    float4  Row1     : DRAW_TRANSFORM1;     // `悲Ƃ̕ϊs 2 s.
+    float4  Row2     : DRAW_TRANSFORM2;     // `悲Ƃ̕ϊs 3 s.
+    float4  Tint     : DRAW_COLOR;          // _J[ɏZF.
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -23,7 +27,9 @@ struct VSOutput
 };
 
 //-------------------------------------------------------------------------------------------------
-//      CGg[|Cgł.
+//      CGg[|Cgł. ϊƐF͕`悲Ƃ̃CX^Xf[^o,
+//      `摤 StartInstanceLocation Ńt[ɂ܂Ƃ߂ď񂾔z̗vfIт܂.
+//      vZ DrawTransform.cpp  TransformVertices() Ɠł.
 //-------------------------------------------------------------------------------------------------
 VSOutput VSFunc( const VSInput input )
 {
@@ -31,8 +37,8 @@ VSOutput VSFunc( const VSInput input )
 
     float4 localPos = float4( input.Position, 1.0f );
 
-    output.Position = localPos;
-    output.Color    = input.Color;
+    output.Position = float4( dot( input.Row0, localPos ), dot( input.Row1, localPos ), dot( input.Row2, localPos ), 1.0f );
+    output.Color    = input.Color * input.Tint;
 
     return output;
 }
\ No newline at end of file
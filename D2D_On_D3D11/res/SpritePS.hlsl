@@ -0,0 +1,41 @@
+//-------------------------------------------------------------------------------------------------
+// File : SpritePS.hlsl
+// Desc : Instanced Sprite Pixel Shader.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// VSOutput structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct VSOutput
+{
+    float4  Position : SV_POSITION;
+    float2  TexCoord : TEXCOORD0;
+    float4  Color    : VTX_COLOR;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PSOutput structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct PSOutput
+{
+    float4  Color : SV_TARGET0;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Resources
+//-------------------------------------------------------------------------------------------------
+Texture2D       SpriteTexture : register( t0 );
+SamplerState    SpriteSampler : register( s0 );
+
+//-------------------------------------------------------------------------------------------------
+//      CGg[|Cgł. eNX`ƒ_J[͂ǂZς݃At@ł.
+//-------------------------------------------------------------------------------------------------
+PSOutput PSFunc( const VSOutput input )
+{
+    PSOutput output = (PSOutput)0;
+
+    output.Color = SpriteTexture.Sample( SpriteSampler, input.TexCoord ) * input.Color;
+
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+//-------------------------------------------------------------------------------------------------
+// File : SpriteVS.hlsl
+// Desc : Instanced Sprite Vertex Shader.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// VSInput structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct VSInput
+{
+    float2  Center   : SPRITE_CENTER;       // S (KfoCXW).
+    float2  AxisX    : SPRITE_AXIS0;        // SE[ւ̎xNg.
+    float2  AxisY    : SPRITE_AXIS1;        // S牺[ւ̎xNg.
+    float4  TexCoord : SPRITE_TEXCOORD;     // (u0, v0, u1, v1).
+    float4  Color    : SPRITE_COLOR;        // Zς݃At@.
+    uint    VertexId : SV_VertexID;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// VSOutput structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct VSOutput
+{
+    float4  Position : SV_POSITION;
+    float2  TexCoord : TEXCOORD0;
+    float4  Color    : VTX_COLOR;
+};
+
+//-------------------------------------------------------------------------------------------------
+//      CGg[|Cgł. _obt@͎, _ԍ`̊p߂܂.
+//-------------------------------------------------------------------------------------------------
+VSOutput VSFunc( const VSInput input )
+{
+    VSOutput output = (VSOutput)0;
+
+    // Op`Xgbv̏ (0, 0), (1, 0), (0, 1), (1, 1).
+    float2 corner = float2( input.VertexId & 1, input.VertexId >> 1 );
+    float2 offset = corner * 2.0f - 1.0f;
+
+    float2 position = input.Center + offset.x * input.AxisX + offset.y * input.AxisY;
+
+    output.Position = float4( position, 0.0f, 1.0f );
+    output.TexCoord = lerp( input.TexCoord.xy, input.TexCoord.zw, corner );
+    output.Color    = input.Color;
+
+    return output;
+}
\ No newline at end of file
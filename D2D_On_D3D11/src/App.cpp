@@ -8,28 +8,35 @@
 // Includes
 //-------------------------------------------------------------------------------------------------
 #include <App.h>
+#include <Logger.h>
+#include <SafeRelease.h>
 #include <cstdio>
 #include <DirectXMath.h>
-#include <array>
+#include <cmath>
+#include <cstring>
 
 
-#ifndef DLOG
-#if defined(DEBUG) || defined(_DEBUG)
-#define DLOG( x, ... ) std::sprintf( x"\n", ##__VA_ARGS__ )
-#else
-#define DLOG( x, ... ) ((void)0)
-#endif
-#endif//DLOG
-
-#ifndef ELOG
-#define ELOG( x, ... ) std::fprintf( stderr, "[File: %s, Line: %d] "x"\n", __FILE__, __LINE__, ##__VA_ARGS__ )
-#endif//ELOG
-
 #define SAMPLE_CLASSNAME TEXT("SampleClass")
+#define WM_SYNTHETIC_INPUT ( WM_APP + 1 )
 
 
 namespace /* anonymous */ {
 
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const UINT  SPRITE_TEXTURE_COUNT    = 8;        // スプライト用に生成するテクスチャ数.
+const UINT  SPRITE_TEXTURE_SIZE     = 64;       // スプライト用テクスチャの縦横のピクセル数.
+const UINT  SCENE_PANEL_ITEMS       = 100;      // シーンのパネル1枚あたりの項目数 (10x10).
+const float SCENE_ITEM_PITCH        = 12.0f;    // シーンの項目の間隔 (ピクセル).
+const float LOG_FONT_SIZE           = 16.0f;    // ログ表示の文字サイズ (ピクセル).
+const UINT  LOG_WHEEL_LINES         = 3;        // ホイール 1 ノッチでスクロールする行数.
+const char* LOG_DEFAULT_FONT        = "C:\\Windows\\Fonts\\meiryo.ttc";
+const UINT  VERTEX_RING_SIZE        = 64 * 1024;    // 毎フレームの描画ごとの変換を書き込むリングバッファの最小バイト数.
+const UINT  VERTEX_RING_FRAMES      = 4;            // リングバッファに収める描画ごとの変換のフレーム数 (GPU の遅延分 + 1).
+const float TRIANGLE_SPIN           = 0.01f;        // 三角形を1フレームで回転させる角度 (ラジアン).
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // SimpleVertex structure
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,17 +47,63 @@ struct SimpleVertex
 };
 
 //-------------------------------------------------------------------------------------------------
-//      解放処理を行います.
+//      メモリ使用量の登録を解除して解放処理を行います.
 //-------------------------------------------------------------------------------------------------
 template<typename T>
-void SafeRelease( T*& ptr )
+void SafeRelease( T*& ptr, ResourceTracker& tracker )
+{
+    tracker.Untrack( ptr );
+    ::SafeRelease( ptr );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      3次ベジェ曲線4本で円を追加します. clockwise で回る向きを指定します.
+//-------------------------------------------------------------------------------------------------
+void AddCircle( Path& path, float cx, float cy, float r, bool clockwise )
+{
+    const float k = 0.5522847f * r;
+    const float s = clockwise ? -1.0f : 1.0f;
+
+    path.MoveTo ( cx + r, cy );
+    path.CubicTo( cx + r, cy + s * k, cx + k, cy + s * r, cx,     cy + s * r );
+    path.CubicTo( cx - k, cy + s * r, cx - r, cy + s * k, cx - r, cy );
+    path.CubicTo( cx - r, cy - s * k, cx - k, cy - s * r, cx,     cy - s * r );
+    path.CubicTo( cx + k, cy - s * r, cx + r, cy - s * k, cx + r, cy );
+    path.Close  ();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      取り出したメッセージがキューに入った時刻をティック単位で求めます.
+//      GetMessageTime() は GetTickCount() と同じミリ秒精度の時計なので, キューで待った時間だけを
+//      ミリ秒で求めて現在のティックから差し引きます.
+//-------------------------------------------------------------------------------------------------
+int64_t GetMessageArrivalTicks()
 {
-    if ( ptr )
-    { ptr->Release(); }
+    const int64_t now    = Timer::GetTicks();
+    const DWORD   queued = GetTickCount() - DWORD( GetMessageTime() );
+
+    // 時計の刻みのずれで未来の時刻になった場合は取り出した時刻とする.
+    if ( queued == 0 || queued > 0x7FFFFFFF )
+    { return now; }
+
+    return now - int64_t( queued ) * Timer::GetTicksPerSec() / 1000;
+}
 
-    ptr = nullptr;
+//-------------------------------------------------------------------------------------------------
+//      合成入力の発行時刻をメッセージのパラメータに詰めます. 32bit 環境でも収まるよう分割します.
+//-------------------------------------------------------------------------------------------------
+void PackTicks( int64_t ticks, WPARAM& wp, LPARAM& lp )
+{
+    wp = WPARAM( uint64_t( ticks ) & 0xFFFFFFFF );
+    lp = LPARAM( uint64_t( ticks ) >> 32 );
 }
 
+//-------------------------------------------------------------------------------------------------
+//      メッセージのパラメータから合成入力の発行時刻を取り出します.
+//-------------------------------------------------------------------------------------------------
+int64_t UnpackTicks( WPARAM wp, LPARAM lp )
+{ return int64_t( ( uint64_t( uint32_t( lp ) ) << 32 ) | uint64_t( uint32_t( wp ) ) ); }
+
 } // namespace /* anonymous */
 
 
@@ -73,6 +126,7 @@ App::App()
 , m_pD2DBitmap          ( nullptr )
 , m_pDWriteFactory      ( nullptr )
 , m_pTextFormat         ( nullptr )
+, m_pTextLayout         ( nullptr )
 , m_pD3DDevice          ( nullptr )
 , m_pD3DDeviceContext   ( nullptr )
 , m_pD3DRenderTargetView( nullptr )
@@ -81,9 +135,38 @@ App::App()
 , m_pD3DVertexShader    ( nullptr )
 , m_pD3DPixelShader     ( nullptr )
 , m_pD3DVertexBuffer    ( nullptr )
+, m_pD3DTriangleBuffer  ( nullptr )
 , m_pDXGISwapChain      ( nullptr )
 , m_pDXGIDevice         ( nullptr )
+, m_CaptureWidth        ( 0 )
+, m_CaptureHeight       ( 0 )
+, m_CaptureHead         ( 0 )
+, m_CapturePending      ( 0 )
+, m_SurfaceCount        ( 0 )
+, m_ThreadCount         ( 0 )
+, m_SurfaceBenchmark    ( false )
+, m_FrameIndex          ( 0 )
+, m_StatFrames          ( 0 )
+, m_TargetFrameRate     ( 60.0 )
+, m_SyncInterval        ( 0 )
+, m_BackBufferCount     ( 2 )
+, m_SyntheticInputRate  ( 0.0 )
+, m_ShapeCount          ( 0 )
+, m_ShapeCacheEnabled   ( true )
+, m_SpriteCount         ( 0 )
+, m_SceneNodeCount      ( 0 )
+, m_SceneSeed           ( 1 )
+, m_pLogBitmap          ( nullptr )
+, m_SimplePipeline      ( 0 )
+, m_StateCacheEnabled   ( true )
+, m_FirstFrameMsec      ( 0.0 )
+, m_ParallelInit        ( true )
+, m_RenderGraphFailed   ( false )
+, m_MemoryBudget        ( 0 )
+, m_ResizeTestCycles    ( 0 )
 {
+    for( UINT i = 0; i < CaptureLatency; ++i )
+    { m_pD3DCaptureTexture[i] = nullptr; }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -95,21 +178,164 @@ App::~App()
 }
 
 //-------------------------------------------------------------------------------------------------
-//      アプリケーションを実行します.
+//      アプリケーションを実行します. 初期化や計測, テストに失敗した場合は false を返します.
 //-------------------------------------------------------------------------------------------------
-void App::Run()
+bool App::Run()
 {
+    bool result = false;
+
+    // サーフェイスの計測はウィンドウもスワップチェインも使わない.
+    if ( m_SurfaceBenchmark )
+    {
+        if ( InitHeadless() )
+        { result = RunSurfaceBenchmark(); }
+
+        Term();
+        return result;
+    }
+
     if ( Init() )
-    { MainLoop(); }
+    {
+        if ( m_ResizeTestCycles > 0 )
+        { result = RunResizeTest(); }
+        else
+        {
+            MainLoop();
+            result = true;
+        }
+    }
 
     Term();
+    return result;
 }
 
+//-------------------------------------------------------------------------------------------------
+//      録画ファイルのパスを設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetRecordPath( const char* path )
+{ m_RecordPath = ( path != nullptr ) ? path : ""; }
+
+//-------------------------------------------------------------------------------------------------
+//      オフスクリーンサーフェイス数を設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetSurfaceCount( UINT count )
+{ m_SurfaceCount = count; }
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイス描画に使うスレッド数を設定します. 0 の場合は論理コア数を使います.
+//-------------------------------------------------------------------------------------------------
+void App::SetThreadCount( UINT count )
+{ m_ThreadCount = count; }
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイス数とスレッド数を変えながら描画性能を計測するモードを設定します.
+//-------------------------------------------------------------------------------------------------
+void App::EnableSurfaceBenchmark( bool enable )
+{ m_SurfaceBenchmark = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      目標フレームレートを設定します. 0 以下の場合は制限しません.
+//-------------------------------------------------------------------------------------------------
+void App::SetTargetFrameRate( double framesPerSec )
+{ m_TargetFrameRate = framesPerSec; }
+
+//-------------------------------------------------------------------------------------------------
+//      Present() の垂直同期間隔を設定します.
+//-------------------------------------------------------------------------------------------------
+void App::SetSyncInterval( UINT interval )
+{ m_SyncInterval = ( interval <= 4 ) ? interval : 4; }
+
+//-------------------------------------------------------------------------------------------------
+//      スワップチェインのバックバッファ数を設定します (2～16).
+//-------------------------------------------------------------------------------------------------
+void App::SetBackBufferCount( UINT count )
+{ m_BackBufferCount = ( count < 2 ) ? 2 : ( count > 16 ) ? 16 : count; }
+
+//-------------------------------------------------------------------------------------------------
+//      遅延計測用の合成入力イベントの発行レートを設定します. 0 の場合は発行しません.
+//-------------------------------------------------------------------------------------------------
+void App::SetSyntheticInputRate( double eventsPerSec )
+{ m_SyntheticInputRate = eventsPerSec; }
+
+//-------------------------------------------------------------------------------------------------
+//      Direct3D で描画するベクター形状の数を設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetShapeCount( UINT count )
+{ m_ShapeCount = count; }
+
+//-------------------------------------------------------------------------------------------------
+//      テッセレーション結果のキャッシュを使うかどうかを設定します.
+//-------------------------------------------------------------------------------------------------
+void App::EnableShapeCache( bool enable )
+{ m_ShapeCacheEnabled = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      変化していないステートの設定を省くかどうかを設定します.
+//-------------------------------------------------------------------------------------------------
+void App::EnableStateCache( bool enable )
+{ m_StateCacheEnabled = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      Direct3D で描画するスプライトの数を設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetSpriteCount( UINT count )
+{ m_SpriteCount = count; }
+
+//-------------------------------------------------------------------------------------------------
+//      Direct2D で描画するシーングラフのノード数を設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetSceneNodeCount( UINT count )
+{ m_SceneNodeCount = count; }
+
+//-------------------------------------------------------------------------------------------------
+//      表示するテキストファイルを設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetLogPath( const char* path )
+{ m_LogPath = ( path != nullptr ) ? path : ""; }
+
+//-------------------------------------------------------------------------------------------------
+//      テキストの表示に使うフォントファイルを設定します. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetLogFontPath( const char* path )
+{ m_LogFontPath = ( path != nullptr ) ? path : ""; }
+
+//-------------------------------------------------------------------------------------------------
+//      独立した初期化処理をスレッドプールで並行に実行するかどうかを設定します.
+//-------------------------------------------------------------------------------------------------
+void App::EnableParallelInit( bool enable )
+{ m_ParallelInit = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      リソースのメモリ予算を設定します. 0 の場合は無制限です. Run() の前に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void App::SetMemoryBudget( UINT64 bytes )
+{ m_MemoryBudget = bytes; }
+
+//-------------------------------------------------------------------------------------------------
+//      起動後にウィンドウのリサイズを指定回数繰り返して, メモリが増えないことを確認します.
+//-------------------------------------------------------------------------------------------------
+void App::SetResizeTestCycles( UINT cycles )
+{ m_ResizeTestCycles = cycles; }
+
 //-------------------------------------------------------------------------------------------------
 //      初期化処理です.
 //-------------------------------------------------------------------------------------------------
 bool App::Init()
 {
+    m_StartupTimer.Reset();
+    m_FirstFrameMsec = 0.0;
+
+    // 予算を超えたら, 作り直せるテッセレーション結果から削減する.
+    m_ResourceTracker.Clear();
+    if ( m_MemoryBudget > 0 )
+    {
+        m_ResourceTracker.SetBudget( m_MemoryBudget, [this]( uint64_t excessBytes )
+        {
+            const UINT64 bytes = m_GeometryCache.GetStats().BufferBytes;
+            m_GeometryCache.Trim( ( bytes > excessBytes ) ? bytes - excessBytes : 0 );
+        });
+    }
+
     HRESULT hr = CoInitialize( nullptr );
     if ( FAILED( hr ) )
     {
@@ -117,27 +343,102 @@ bool App::Init()
         return false;
     }
 
-    // ウィンドウの初期化.
-    if ( !InitWnd() )
+    // 初期化処理を依存関係のグラフとして登録し, 独立したものはスレッドプールで並行に実行する.
+    // ウィンドウとスワップチェインはメッセージを処理するメインスレッドで生成する.
+    // クライアント領域のサイズは WM_SIZE で更新されるので, サイズを使う処理はウィンドウの生成後に行う.
+    m_InitGraph.Clear();
+    const uint32_t wnd    = m_InitGraph.AddTask( "window", [this]() { return InitWnd(); }, true );
+    const uint32_t d3d    = m_InitGraph.AddTask( "d3d",    [this]() { return InitD3D(); }, true );
+    const uint32_t dwrite = m_InitGraph.AddTask( "dwrite", [this]() { return InitDWrite(); } );
+    const uint32_t d2d    = m_InitGraph.AddTask( "d2d",    [this]() { return InitD2D(); } );
+    m_InitGraph.AddDependency( d3d,    wnd );
+    m_InitGraph.AddDependency( dwrite, wnd );
+    m_InitGraph.AddDependency( d2d,    d3d );
+
+    // オフスクリーンサーフェイスの初期化.
+    if ( m_SurfaceCount > 0 )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "surfaces", [this]() { return InitSurfaces( m_SurfaceCount, m_ThreadCount ); } );
+        m_InitGraph.AddDependency( task, d2d );
+        m_InitGraph.AddDependency( task, dwrite );
+    }
+
+    // ベクター形状の初期化.
+    if ( m_ShapeCount > 0 )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "shapes", [this]() { return InitShapes( m_ShapeCount ); } );
+        m_InitGraph.AddDependency( task, d3d );
+    }
+
+    // スプライトの初期化.
+    if ( m_SpriteCount > 0 )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "sprites", [this]() { return InitSprites( m_SpriteCount ); } );
+        m_InitGraph.AddDependency( task, d3d );
+    }
+
+    // シーングラフの初期化.
+    if ( m_SceneNodeCount > 0 )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "scene", [this]() { return InitScene( m_SceneNodeCount ); } );
+        m_InitGraph.AddDependency( task, wnd );
+    }
+
+    // テキスト表示の初期化.
+    if ( !m_LogPath.empty() )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "logview", [this]() { return InitLogView(); } );
+        m_InitGraph.AddDependency( task, wnd );
+    }
+
+    // 録画の初期化.
+    if ( !m_RecordPath.empty() )
+    {
+        const uint32_t task = m_InitGraph.AddTask( "capture", [this]() { return InitCapture(); } );
+        m_InitGraph.AddDependency( task, wnd );
+    }
+
+    // 初期化が終われば不要なので, 描画用とは別のプールを使う.
+    ThreadPool pool;
+    if ( m_ParallelInit && !pool.Init() )
     {
-        ELOG( "Error : InitWnd() Failed." );
+        ELOG( "Error : ThreadPool::Init() Failed." );
         return false;
     }
 
-    // Direct3D の初期化.
-    if ( !InitD3D() )
+    const bool result = m_InitGraph.Run( m_ParallelInit ? &pool : nullptr );
+    pool.Term();
+    if ( !result )
     {
-        ELOG( "Error : InitD3D() Failed." );
+        ELOG( "Error : InitGraph::Run() Failed." );
         return false;
     }
 
-    // Direct2D の初期化.
-    if ( !InitD2D() )
+    // フレームペーシングの初期化.
+    m_FramePacer.SetTargetRate( m_TargetFrameRate );
+    m_FramePacer.ResetStats();
+
+    // 入力遅延計測の初期化.
+    if ( !m_InputTracker.Init() )
     {
-        ELOG( "Error : InitD2D() Failed." );
+        ELOG( "Error : InputLatencyTracker::Init() Failed." );
         return false;
     }
 
+    // 合成入力イベントはメッセージキューを経由させて実際の入力と同じ経路で計測する.
+    // キューで待った時間も含めるため, 発行時刻をパラメータに載せて到着時刻とする.
+    if ( m_SyntheticInputRate > 0.0 )
+    {
+        HWND hWnd = m_hWnd;
+        m_InputGenerator.Start( m_SyntheticInputRate, [hWnd]( int64_t ticks )
+        {
+            WPARAM wp;
+            LPARAM lp;
+            PackTicks( ticks, wp, lp );
+            PostMessageW( hWnd, WM_SYNTHETIC_INPUT, wp, lp );
+        } );
+    }
+
     // 正常終了.
     return true;
 }
@@ -147,9 +448,170 @@ bool App::Init()
 //-------------------------------------------------------------------------------------------------
 void App::Term()
 {
+    // 起動時間の内訳を出力.
+    if ( m_InitGraph.GetTaskCount() > 0 )
+    {
+        std::printf( "Startup : %s init %.3f ms, first frame %.3f ms\n",
+            m_ParallelInit ? "parallel" : "serial", m_InitGraph.GetTotalMsec(), m_FirstFrameMsec );
+        m_InitGraph.PrintTimeline();
+        m_InitGraph.Clear();
+    }
+
+    // 最後のフレームの描画パスの実行順を出力.
+    if ( m_RenderGraph.GetStats().PassCount > 0 )
+    { m_RenderGraph.PrintSchedule(); }
+    m_RenderGraph.Term();
+
+    // フレームペーシングの統計を出力.
+    const FramePacer::Stats pacing = m_FramePacer.GetStats();
+    if ( pacing.FrameCount > 0 )
+    {
+        std::printf( "Frame Pacing : %llu frames, target %.1f fps\n", (unsigned long long)pacing.FrameCount, m_TargetFrameRate );
+        std::printf( "  frame time : mean %.3f ms, variance %.4f ms^2\n", pacing.MeanFrameMsec, pacing.FrameVarianceMsec2 );
+        std::printf( "  deadlines  : %llu missed, max lateness %.3f ms\n", (unsigned long long)pacing.MissedDeadlines, pacing.MaxLatenessMsec );
+        std::printf( "  waiting    : sleep %.1f ms, spin %.1f ms, predicted render %.3f ms, oversleep %.3f ms\n",
+            pacing.SleepMsec, pacing.SpinMsec, pacing.PredictedRenderMsec, pacing.OversleepMsec );
+        m_FramePacer.ResetStats();
+    }
+
+    // 入力遅延の統計を出力.
+    m_InputGenerator.Stop();
+    const InputLatencyTracker::Summary latency = m_InputTracker.GetTotalSummary();
+    if ( latency.Count > 0 )
+    {
+        static const char* names[INPUT_EVENT_COUNT] = { "key", "mouse move", "mouse button", "mouse wheel", "synthetic" };
+
+        std::printf( "Input Latency : %llu events, %llu dropped\n", (unsigned long long)latency.Count, (unsigned long long)m_InputTracker.GetDroppedCount() );
+        for( UINT i = 0; i < INPUT_EVENT_COUNT; ++i )
+        {
+            const InputLatencyTracker::Summary s = m_InputTracker.GetSummary( INPUT_EVENT_TYPE( i ) );
+            if ( s.Count == 0 )
+            { continue; }
+
+            std::printf( "  %-12s : %6llu events, mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+                names[i], (unsigned long long)s.Count, s.MeanMsec, s.P50Msec, s.P95Msec, s.P99Msec, s.MaxMsec );
+        }
+    }
+    m_InputTracker.Term();
+
+    // テッセレーションの統計を出力.
+    const GeometryCache::Stats geometry = m_GeometryCache.GetStats();
+    if ( geometry.HitCount + geometry.MissCount > 0 )
+    {
+        const UINT64 lookups = geometry.HitCount + geometry.MissCount;
+        std::printf( "Geometry Cache : %s, %llu lookups, hit rate %.2f %%\n",
+            m_GeometryCache.IsEnabled() ? "enabled" : "disabled",
+            (unsigned long long)lookups, 100.0 * double( geometry.HitCount ) / double( lookups ) );
+        std::printf( "  tessellate : %llu meshes, %llu vertices, %.3f ms total, %.3f ms/mesh\n",
+            (unsigned long long)geometry.MissCount, (unsigned long long)geometry.TessellatedVertices,
+            geometry.TessellateMsec, ( geometry.MissCount > 0 ) ? geometry.TessellateMsec / double( geometry.MissCount ) : 0.0 );
+        std::printf( "  upload     : %.3f ms total, %u entries, %llu bytes, %llu evicted\n",
+            geometry.UploadMsec, geometry.EntryCount, (unsigned long long)geometry.BufferBytes, (unsigned long long)geometry.EvictCount );
+    }
+    m_GeometryCache.Term();
+    m_Shapes.clear();
+
+    // スプライトの統計を出力.
+    const SpriteBatch   ::Stats batch  = m_SpriteBatch.GetStats();
+    const SpriteRenderer::Stats sprite = m_SpriteRenderer.GetStats();
+    if ( sprite.FrameCount > 0 )
+    {
+        const double frames = double( sprite.FrameCount );
+        std::printf( "Sprites : %llu frames, %.0f sprites/frame, %.1f draws/frame (%.1f runs/frame)\n",
+            (unsigned long long)sprite.FrameCount, double( sprite.SpriteCount ) / frames,
+            double( sprite.DrawCount ) / frames, double( batch.RunCount ) / double( batch.FrameCount ) );
+        std::printf( "  changes : %.1f textures/frame, %.1f blend states/frame\n",
+            double( sprite.TextureChangeCount ) / frames, double( sprite.BlendChangeCount ) / frames );
+        std::printf( "  cpu     : sort %.3f ms/frame, submit %.3f ms/frame, upload %.2f MB/frame\n",
+            batch.SortMsec / double( batch.FrameCount ), sprite.RenderMsec / frames,
+            double( sprite.UploadBytes ) / frames / ( 1024.0 * 1024.0 ) );
+    }
+    m_SpriteRenderer.Term();
+    m_Sprites.clear();
+
+    // ステートキャッシュの統計を出力.
+    const StateCache::Stats state = m_StateCache.GetStats();
+    if ( state.Issued[RENDER_CALL_DRAW] > 0 )
+    {
+        UINT64 issued = 0;
+        UINT64 elided = 0;
+        for( UINT i = 0; i < RENDER_CALL_DRAW; ++i )
+        {
+            issued += state.Issued[i];
+            elided += state.Elided[i];
+        }
+        std::printf( "State Cache : %s, %llu draws, %llu state calls issued, %llu elided (%.1f %%)\n",
+            m_StateCache.IsEnabled() ? "enabled" : "disabled",
+            (unsigned long long)state.Issued[RENDER_CALL_DRAW], (unsigned long long)issued, (unsigned long long)elided,
+            ( issued + elided > 0 ) ? 100.0 * double( elided ) / double( issued + elided ) : 0.0 );
+        std::printf( "  pipelines : %u created, %llu changes, %llu hits\n",
+            m_StateCache.GetPipelineCount(), (unsigned long long)state.PipelineChangeCount, (unsigned long long)state.PipelineHitCount );
+    }
+
+    // 頂点データの転送の統計を出力.
+    const RingBuffer::Stats ring = m_VertexRing.GetStats();
+    if ( ring.FrameCount > 0 )
+    {
+        std::printf( "Vertex Ring : %llu frames, %.1f bytes/frame, %llu wraps, %llu stalls (%.3f ms total), peak %llu / %llu bytes\n",
+            (unsigned long long)ring.FrameCount, double( ring.AllocBytes ) / double( ring.FrameCount ),
+            (unsigned long long)ring.WrapCount, (unsigned long long)ring.StallCount, ring.StallMsec,
+            (unsigned long long)ring.PeakBytes, (unsigned long long)m_VertexRing.GetCapacity() );
+    }
+
+    // シーングラフの統計を出力.
+    const SceneGraph::Stats scene = m_Scene.GetStats();
+    if ( scene.UpdateCount > 0 )
+    {
+        const double updates = double( scene.UpdateCount );
+        std::printf( "Scene Graph : %u nodes, %llu updates, %.3f ms/update\n",
+            m_Scene.GetNodeCount(), (unsigned long long)scene.UpdateCount, scene.UpdateMsec / updates );
+        std::printf( "  per update : %.0f visited, %.0f transforms, %.0f bounds\n",
+            double( scene.VisitCount ) / updates, double( scene.TransformCount ) / updates, double( scene.BoundsCount ) / updates );
+    }
+    const SpatialIndex::Stats index = m_SceneIndex.GetStats();
+    if ( index.QueryCount > 0 )
+    {
+        std::printf( "Spatial Index : %u items, %llu hit tests, %.1f candidates/test, %llu of %llu updates relinked\n",
+            m_SceneIndex.GetCount(), (unsigned long long)index.QueryCount,
+            double( index.ResultCount ) / double( index.QueryCount ),
+            (unsigned long long)index.RelinkCount, (unsigned long long)index.UpdateCount );
+    }
+    m_Scene.Clear();
+    m_SceneIndex.Term();
+    m_SceneNodes.clear();
+    m_SceneHandles.clear();
+    m_SceneVisible.clear();
+
+    // テキスト表示の統計を出力.
+    const TextView::Stats view = m_LogView.GetStats();
+    if ( view.FrameCount > 0 )
+    {
+        const double frames  = double( view.FrameCount );
+        const UINT64 lookups = view.StripHitCount + view.StripMissCount;
+        std::printf( "Log View : %llu lines, %llu frames, %.2f shaped lines/frame, strip hit rate %.2f %%\n",
+            (unsigned long long)m_LogBuffer.GetLineCount(), (unsigned long long)view.FrameCount,
+            double( view.StripMissCount ) / frames,
+            ( lookups > 0 ) ? 100.0 * double( view.StripHitCount ) / double( lookups ) : 0.0 );
+        std::printf( "  cpu : shape %.3f ms/frame, compose %.3f ms/frame, %llu glyphs rasterized, view memory %.1f KiB\n",
+            view.ShapeMsec / frames, view.ComposeMsec / frames, (unsigned long long)view.GlyphMissCount,
+            double( m_LogView.GetMemoryUsage() ) / 1024.0 );
+    }
+    m_LogView.Term();
+    m_LogBuffer.Term();
+    m_ResourceTracker.Untrack( m_LogSurface.GetPixels() );
+    m_LogSurface.Term();
+    m_LogFont.Term();
+
+    TermCapture();
+    m_SurfaceGroup.Term();
+    m_ThreadPool.Term();
     TermD2D();
     TermD3D();
     TermWnd();
+
+    // 全て解放した後に残っているものはリークとして報告する.
+    PrintMemoryUsage();
+    m_ResourceTracker.Clear();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -274,9 +736,7 @@ bool App::InitD3D()
         D3D_FEATURE_LEVEL_11_0,
         D3D_FEATURE_LEVEL_10_1,
         D3D_FEATURE_LEVEL_10_0,
-        D3D_FEATURE_LEVEL_9_3,
-        D3D_FEATURE_LEVEL_9_2,
-        D3D_FEATURE_LEVEL_9_1,
+        D3D_FEATURE_LEVEL_9_3,     // 描画ごとの変換をインスタンスデータで渡すので, インスタンシングが使える 9.3 以上.
     };
 
     UINT numFeatureLevels = sizeof( featureLevels ) / sizeof( featureLevels[0] );
@@ -284,7 +744,7 @@ bool App::InitD3D()
     // スワップチェインの設定.
     DXGI_SWAP_CHAIN_DESC sd;
     ZeroMemory( &sd, sizeof(sd) );
-    sd.BufferCount                          = 2;
+    sd.BufferCount                          = m_BackBufferCount;
     sd.BufferDesc.Width                     = m_Width;
     sd.BufferDesc.Height                    = m_Height;
     sd.BufferDesc.Format                    = DXGI_FORMAT_B8G8R8A8_UNORM;   // Direct2D を使う関係でこのフォーマット.
@@ -316,6 +776,7 @@ bool App::InitD3D()
         ELOG( "Error : D3D11CreateDeviceAndSwapChain() Failed." );
         return false;
     }
+    m_ResourceTracker.Track( m_pDXGISwapChain, RESOURCE_CATEGORY_SWAP_CHAIN, UINT64( m_Width ) * m_Height * 4 * m_BackBufferCount );
 
     // IDXGIDeviceを取得.
     hr = m_pD3DDevice->QueryInterface( IID_IDXGIDevice, (LPVOID*)&m_pDXGIDevice );
@@ -345,6 +806,7 @@ bool App::InitD3D()
         }
 
         SafeRelease( pTexture );
+        m_ResourceTracker.Track( m_pD3DRenderTargetView, RESOURCE_CATEGORY_VIEW, 0 );
     }
 
     // 深度ステンシルビューを生成.
@@ -384,32 +846,69 @@ bool App::InitD3D()
         }
 
         SafeRelease( pTexture );
+
+        // ビューがテクスチャを保持するので, ビューに対して D24S8 のサイズを登録する.
+        m_ResourceTracker.Track( m_pD3DDepthStencilView, RESOURCE_CATEGORY_DEPTH_STENCIL, UINT64( m_Width ) * m_Height * 4 );
     }
 
-    // 頂点バッファを生成.
+    // 三角形の頂点バッファを生成. 回転は描画ごとの変換で行うので, 頂点データは書き換えない.
     {
+        const SimpleVertex vertices[] = {
+            { DirectX::XMFLOAT3( -0.3f, -0.5f, 0.0f ), DirectX::XMFLOAT4( 1.0f, 0.0f, 0.0f, 1.0f ) },
+            { DirectX::XMFLOAT3(  0.0f,  0.5f, 0.0f ), DirectX::XMFLOAT4( 0.0f, 1.0f, 0.0f, 1.0f ) },
+            { DirectX::XMFLOAT3(  0.3f, -0.5f, 0.0f ), DirectX::XMFLOAT4( 0.0f, 0.0f, 1.0f, 1.0f ) },
+        };
+
         D3D11_BUFFER_DESC bd;
         ZeroMemory( &bd, sizeof(bd) );
-        bd.ByteWidth = sizeof(SimpleVertex) * 3;
-        bd.Usage     = D3D11_USAGE_DEFAULT;
+        bd.ByteWidth = sizeof(vertices);
+        bd.Usage     = D3D11_USAGE_IMMUTABLE;
         bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
-        const std::array<SimpleVertex, 3> vertex = {{
-                { {-0.3f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f} },
-                { { 0.0f,  0.5f, 0.0f}, {0.0f, 1.0f, 0.0f, 1.0f} },
-                { { 0.3f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f, 1.0f} }
-       }};
+        D3D11_SUBRESOURCE_DATA initData;
+        ZeroMemory( &initData, sizeof(initData) );
+        initData.pSysMem = vertices;
 
-        D3D11_SUBRESOURCE_DATA res;
-        ZeroMemory( &res, sizeof(res) );
-        res.pSysMem = vertex.data();
+        hr = m_pD3DDevice->CreateBuffer( &bd, &initData, &m_pD3DTriangleBuffer );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            return false;
+        }
+        m_ResourceTracker.Track( m_pD3DTriangleBuffer, RESOURCE_CATEGORY_VERTEX_BUFFER, bd.ByteWidth );
+    }
+
+    // 描画ごとの変換を書き込む頂点バッファを生成. 作り直さずに毎フレーム書き込めるよう動的バッファにして,
+    // GPU が読み終えた領域だけをリングバッファで割り当てる. 三角形と全ての形状の変換が数フレーム分収まる大きさにする.
+    {
+        const UINT ringBytes = ( 1 + m_ShapeCount ) * UINT( sizeof(DrawTransform) ) * VERTEX_RING_FRAMES;
+
+        D3D11_BUFFER_DESC bd;
+        ZeroMemory( &bd, sizeof(bd) );
+        bd.ByteWidth      = ( ringBytes > VERTEX_RING_SIZE ) ? ringBytes : VERTEX_RING_SIZE;
+        bd.Usage          = D3D11_USAGE_DYNAMIC;
+        bd.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-        hr = m_pD3DDevice->CreateBuffer( &bd, &res, &m_pD3DVertexBuffer );
+        hr = m_pD3DDevice->CreateBuffer( &bd, nullptr, &m_pD3DVertexBuffer );
         if ( FAILED( hr ) )
         {
             ELOG( "Error : ID3D11dDevice::CreateBuffer() Failed." );
             return false;
         }
+        m_ResourceTracker.Track( m_pD3DVertexBuffer, RESOURCE_CATEGORY_VERTEX_BUFFER, bd.ByteWidth );
+
+        if ( !m_D3DFence.Init( m_pD3DDevice, m_pD3DDeviceContext ) )
+        {
+            ELOG( "Error : D3D11GpuFence::Init() Failed." );
+            return false;
+        }
+
+        if ( !m_VertexRing.Init( bd.ByteWidth, &m_D3DFence ) )
+        {
+            ELOG( "Error : RingBuffer::Init() Failed." );
+            return false;
+        }
     }
 
     // 頂点シェーダ・入力レイアウト生成.
@@ -423,12 +922,17 @@ bool App::InitD3D()
             return false;
         }
 
+        // スロット 1 は描画ごとの変換 (DrawTransform) で, 1 描画 1 インスタンスとして読み込む.
         D3D11_INPUT_ELEMENT_DESC elementDesc[] = {
-            { "POSITION",  0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "VTX_COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+            { "POSITION",       0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA,   0 },
+            { "VTX_COLOR",      0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA,   0 },
+            { "DRAW_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "DRAW_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "DRAW_TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "DRAW_COLOR",     0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
         };
 
-        hr = m_pD3DDevice->CreateInputLayout( elementDesc, 2, SimpleVS_VSFunc, sizeof(SimpleVS_VSFunc), &m_pD3DInputLayout );
+        hr = m_pD3DDevice->CreateInputLayout( elementDesc, _countof(elementDesc), SimpleVS_VSFunc, sizeof(SimpleVS_VSFunc), &m_pD3DInputLayout );
         if ( FAILED( hr ) )
         {
             ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
@@ -448,6 +952,29 @@ bool App::InitD3D()
         }
     }
 
+    // ステートキャッシュとパイプラインを生成.
+    {
+        m_RenderContext.SetContext( m_pD3DDeviceContext );
+        if ( !m_StateCache.Init( &m_RenderContext ) )
+        {
+            ELOG( "Error : StateCache::Init() Failed." );
+            return false;
+        }
+        m_StateCache.SetEnabled( m_StateCacheEnabled );
+
+        PipelineDesc desc = {};
+        desc.pInputLayout  = m_pD3DInputLayout;
+        desc.pVertexShader = m_pD3DVertexShader;
+        desc.pPixelShader  = m_pD3DPixelShader;
+        desc.Topology      = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        m_SimplePipeline = m_StateCache.CreatePipeline( desc );
+    }
+
+    // レンダーグラフの一時リソースはレンダーターゲットとしてもテクスチャとしても使えるように確保する.
+    m_RenderGraph.SetAllocator(
+        [this]( const RenderTextureDesc& desc ) { return CreateTransientTexture( desc ); },
+        [this]( void* pPhysical ) { DestroyTransientTexture( pPhysical ); } );
+
     // ビューポートを設定.
     m_Viewport.Width    = FLOAT( m_Width );
     m_Viewport.Height   = FLOAT( m_Height );
@@ -463,26 +990,16 @@ bool App::InitD3D()
 }
 
 //-------------------------------------------------------------------------------------------------
-//      Direct2D の初期化です.
+//      DirectWrite の初期化です. Direct3D のデバイスを使わないので, デバイスの生成と並行に実行できます.
 //-------------------------------------------------------------------------------------------------
-bool App::InitD2D()
+bool App::InitDWrite()
 {
     HRESULT hr = S_OK;
 
-    // D2Dファクトリーを生成.
-    hr = D2D1CreateFactory( D2D1_FACTORY_TYPE_MULTI_THREADED, &m_pD2DFactory );
-    if ( FAILED( hr ) )
-    {
-        SafeRelease( m_pD2DFactory );
-        ELOG( "Error : D2D1CreateFactory() Failed." );
-        return false;
-    }
-
     // DWriteファクトリーを生成.
     hr = DWriteCreateFactory( DWRITE_FACTORY_TYPE_SHARED, __uuidof(m_pDWriteFactory), reinterpret_cast<IUnknown**>( &m_pDWriteFactory ) );
     if ( FAILED( hr ) )
     {
-        SafeRelease( m_pD2DFactory );
         SafeRelease( m_pDWriteFactory );
         ELOG( "Error : DWriteCreateFactory() Failed." );
         return false;
@@ -503,7 +1020,6 @@ bool App::InitD2D()
 
     if ( FAILED( hr ) )
     {
-        SafeRelease( m_pD2DFactory );
         SafeRelease( m_pDWriteFactory );
         SafeRelease( m_pTextFormat );
         ELOG( "Error : IDWriteFactory::CreateTextFormat() Failed." );
@@ -514,14 +1030,36 @@ bool App::InitD2D()
     m_pTextFormat->SetTextAlignment( DWRITE_TEXT_ALIGNMENT_CENTER );
     m_pTextFormat->SetParagraphAlignment( DWRITE_PARAGRAPH_ALIGNMENT_CENTER );
 
-    // D2Dデバイスを生成.
-    hr = m_pD2DFactory->CreateDevice( m_pDXGIDevice, &m_pD2DDevice );
+    // 文字列のレイアウトは一度だけ作成し, 毎フレームの整形と行分割を避ける.
+    static const WCHAR text[] = L"ぽえ～ん。";
+    hr = m_pDWriteFactory->CreateTextLayout(
+        text,
+        UINT32( sizeof(text) / sizeof(text[0]) - 1 ),
+        m_pTextFormat,
+        FLOAT( m_Width ),
+        FLOAT( m_Height ),
+        &m_pTextLayout );
     if ( FAILED( hr ) )
     {
-        ELOG( "Error : ID2D1Factory1::CreateDevice() Failed." );
+        ELOG( "Error : IDWriteFactory::CreateTextLayout() Failed." );
         return false;
     }
 
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Direct2D の初期化です.
+//-------------------------------------------------------------------------------------------------
+bool App::InitD2D()
+{
+    HRESULT hr = S_OK;
+
+    // D2Dファクトリーとデバイスを生成.
+    if ( !InitD2DDevice() )
+    { return false; }
+
     // D2Dデバイスコンテキストを生成.
     hr = m_pD2DDevice->CreateDeviceContext( D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &m_pD2DDeviceContext );
     if ( FAILED( hr ) )
@@ -552,7 +1090,9 @@ bool App::InitD2D()
         return false;
     }
 
+    // バックバッファを共有するので, メモリは持たず数だけ数える.
     SafeRelease( pSurface );
+    m_ResourceTracker.Track( m_pD2DBitmap, RESOURCE_CATEGORY_D2D_BITMAP, 0 );
 
     // カラーブラシを生成.
     hr = m_pD2DDeviceContext->CreateSolidColorBrush( (D2D1::ColorF(D2D1::ColorF::White)), &m_pD2DSolidColorBrush );
@@ -567,52 +1107,137 @@ bool App::InitD2D()
 }
 
 //-------------------------------------------------------------------------------------------------
-//      ウィンドウの終了処理です.
+//      Direct2D のファクトリーとデバイスを生成します. m_pDXGIDevice を先に生成しておく必要があります.
 //-------------------------------------------------------------------------------------------------
-void App::TermWnd()
+bool App::InitD2DDevice()
 {
-    // ウィンドウクラスの登録を解除.
-    if ( m_hInstance != nullptr )
-    { UnregisterClass( L"d2dSampleClass", m_hInstance ); }
-
-    m_hInstance = nullptr;
-}
+    HRESULT hr = S_OK;
 
-//-------------------------------------------------------------------------------------------------
-//      Direct3D の終了処理です.
-//-------------------------------------------------------------------------------------------------
-void App::TermD3D()
-{
-    // ステートをクリアして，残っている描画コマンドを実行.
-    if ( m_pD3DDeviceContext )
+    // D2Dファクトリーを生成.
+    hr = D2D1CreateFactory( D2D1_FACTORY_TYPE_MULTI_THREADED, &m_pD2DFactory );
+    if ( FAILED( hr ) )
     {
-        m_pD3DDeviceContext->ClearState();
-        m_pD3DDeviceContext->Flush();
+        SafeRelease( m_pD2DFactory );
+        ELOG( "Error : D2D1CreateFactory() Failed." );
+        return false;
     }
 
-    SafeRelease( m_pD3DInputLayout );
-    SafeRelease( m_pD3DVertexShader );
-    SafeRelease( m_pD3DPixelShader );
-    SafeRelease( m_pD3DVertexBuffer );
-    SafeRelease( m_pD3DDepthStencilView );
-    SafeRelease( m_pD3DRenderTargetView );
-    SafeRelease( m_pD3DDeviceContext );
-    SafeRelease( m_pD3DDevice );
+    // D2Dデバイスを生成.
+    hr = m_pD2DFactory->CreateDevice( m_pDXGIDevice, &m_pD2DDevice );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID2D1Factory1::CreateDevice() Failed." );
+        return false;
+    }
 
-    SafeRelease( m_pDXGISwapChain );
-    SafeRelease( m_pDXGIDevice );
+    // 正常終了.
+    return true;
 }
 
 //-------------------------------------------------------------------------------------------------
-//      Direct2D の終了処理です.
+//      ウィンドウとスワップチェインを持たない初期化処理です. オフスクリーンサーフェイスの描画に
+//      必要な Direct3D / Direct2D のデバイスと DirectWrite だけを生成します.
 //-------------------------------------------------------------------------------------------------
-void App::TermD2D()
+bool App::InitHeadless()
 {
-    SafeRelease( m_pTextFormat );
-    SafeRelease( m_pDWriteFactory );
-
-    SafeRelease( m_pD2DBitmap );
-    SafeRelease( m_pD2DSolidColorBrush );
+    UINT createDeviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+#if defined(DEBUG) || defined(_DEBUG)
+    createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif//defined(DEBUG) || defined(_DEBUG)
+
+    // 描画先はオフスクリーンのビットマップだけなので, スワップチェインは作らない.
+    HRESULT hr = D3D11CreateDevice(
+        nullptr,
+        D3D_DRIVER_TYPE_HARDWARE,
+        nullptr,
+        createDeviceFlags,
+        nullptr,
+        0,
+        D3D11_SDK_VERSION,
+        &m_pD3DDevice,
+        &m_FeatureLevel,
+        &m_pD3DDeviceContext );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : D3D11CreateDevice() Failed." );
+        return false;
+    }
+
+    // IDXGIDeviceを取得.
+    hr = m_pD3DDevice->QueryInterface( IID_IDXGIDevice, (LPVOID*)&m_pDXGIDevice );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : QueryInterface() Failed." );
+        return false;
+    }
+
+    if ( !InitD2DDevice() )
+    { return false; }
+
+    if ( !InitDWrite() )
+    { return false; }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ウィンドウの終了処理です.
+//-------------------------------------------------------------------------------------------------
+void App::TermWnd()
+{
+    // ウィンドウクラスの登録を解除.
+    if ( m_hInstance != nullptr )
+    { UnregisterClass( L"d2dSampleClass", m_hInstance ); }
+
+    m_hInstance = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Direct3D の終了処理です.
+//-------------------------------------------------------------------------------------------------
+void App::TermD3D()
+{
+    // ステートをクリアして，残っている描画コマンドを実行.
+    if ( m_pD3DDeviceContext )
+    {
+        m_pD3DDeviceContext->ClearState();
+        m_pD3DDeviceContext->Flush();
+    }
+
+    m_StateCache.Term();
+    m_RenderContext.SetContext( nullptr );
+
+    // GPU が描画ごとの変換を読み終えるのを待ってから解放する.
+    m_VertexRing.Term();
+    m_D3DFence.Term();
+
+    SafeRelease( m_pD3DInputLayout );
+    SafeRelease( m_pD3DVertexShader );
+    SafeRelease( m_pD3DPixelShader );
+    SafeRelease( m_pD3DVertexBuffer, m_ResourceTracker );
+    SafeRelease( m_pD3DTriangleBuffer, m_ResourceTracker );
+    SafeRelease( m_pD3DDepthStencilView, m_ResourceTracker );
+    SafeRelease( m_pD3DRenderTargetView, m_ResourceTracker );
+    SafeRelease( m_pD3DDeviceContext );
+    SafeRelease( m_pD3DDevice );
+
+    SafeRelease( m_pDXGISwapChain, m_ResourceTracker );
+    SafeRelease( m_pDXGIDevice );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Direct2D の終了処理です.
+//-------------------------------------------------------------------------------------------------
+void App::TermD2D()
+{
+    m_pLogBitmap = nullptr;
+    SafeRelease( m_pTextLayout );
+    SafeRelease( m_pTextFormat );
+    SafeRelease( m_pDWriteFactory );
+
+    SafeRelease( m_pD2DBitmap, m_ResourceTracker );
+    SafeRelease( m_pD2DSolidColorBrush );
     SafeRelease( m_pD2DDeviceContext );
     SafeRelease( m_pD2DDevice );
     SafeRelease( m_pD2DFactory );
@@ -623,14 +1248,236 @@ void App::TermD2D()
 //-------------------------------------------------------------------------------------------------
 void App::Render()
 {
+    // 表示期限から逆算した描画開始時刻まで待機.
+    m_FramePacer.BeginFrame();
+
+    // 待機中に届いた入力を処理して, ここまでに到着した入力をこのフレームの描画に反映させる.
+    PumpInputMessages();
+    m_InputTracker.BeginFrame();
+
+    // 描画パスを組み立てて実行順に描画.
+    // 一時テクスチャを確保できずにコンパイルに失敗した場合は, 何も描画していないバックバッファを
+    // 表示しないよう固定の順序で描画する. 失敗後はリサイズまで再試行しない.
+    if ( !m_RenderGraphFailed )
+    {
+        BuildFrameGraph();
+        if ( m_RenderGraph.Compile() )
+        { m_RenderGraph.Execute(); }
+        else
+        {
+            ELOG( "Error : RenderGraph::Compile() Failed. Falling back to fixed passes until resize." );
+            m_RenderGraphFailed = true;
+        }
+    }
+    if ( m_RenderGraphFailed )
+    { RenderFixedPasses(); }
+
+    // 描画コマンドをフラッシュして表示.
+    const HRESULT hr = m_pDXGISwapChain->Present( m_SyncInterval, 0 );
+    if ( FAILED( hr ) )
+    { ELOG( "Error : IDXGISwapChain::Present() Failed. hr = 0x%08x, frame = %u", hr, m_FrameIndex ); }
+    m_VertexRing.EndFrame();
+    m_InputTracker.EndFrame( Timer::GetTicks() );
+    if ( m_FrameIndex == 0 )
+    { m_FirstFrameMsec = m_StartupTimer.GetElapsedMsec(); }
+    m_FramePacer.EndFrame();
+    m_ResourceTracker.EndFrame();
+    m_FrameIndex++;
+
+    // 1秒ごとに統計をタイトルに表示.
+    m_StatFrames++;
+    if ( m_StatTimer.GetElapsedSec() >= 1.0 )
+    { UpdateTitle(); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイスの総描画レートと直近の入力遅延をタイトルに表示します.
+//-------------------------------------------------------------------------------------------------
+void App::UpdateTitle()
+{
+    const double fps = double( m_StatFrames ) / m_StatTimer.GetElapsedSec();
+    const InputLatencyTracker::Summary latency = m_InputTracker.GetRecentSummary();
+
+    if ( m_SurfaceGroup.GetSurfaceCount() > 0 || latency.Count > 0 )
+    {
+        WCHAR title[256];
+        int   length = swprintf_s( title, L"d2d simple - %.1f fps", fps );
+
+        if ( m_SurfaceGroup.GetSurfaceCount() > 0 && length > 0 )
+        {
+            length += swprintf_s( title + length, _countof(title) - length, L", %u surfaces, %u threads, %.1f surfaces/s",
+                m_SurfaceGroup.GetSurfaceCount(), m_ThreadPool.GetThreadCount(), fps * m_SurfaceGroup.GetSurfaceCount() );
+        }
+
+        if ( latency.Count > 0 && length > 0 )
+        {
+            swprintf_s( title + length, _countof(title) - length, L" | input latency p50 %.1f ms, p99 %.1f ms, max %.1f ms",
+                latency.P50Msec, latency.P99Msec, latency.MaxMsec );
+        }
+
+        SetWindowTextW( m_hWnd, title );
+    }
+
+    m_InputTracker.ResetRecent();
+    m_StatFrames = 0;
+    m_StatTimer.Reset();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1 フレームの描画パスと読み書きするリソースをレンダーグラフに登録します.
+//      バックバッファなどの固定のリソースは外部リソースとして登録し, 書き込むパスを出力とします.
+//-------------------------------------------------------------------------------------------------
+void App::BuildFrameGraph()
+{
+    m_RenderGraph.Reset();
+    m_pLogBitmap = nullptr;
+
+    RenderTextureDesc desc = { m_Width, m_Height, UINT( DXGI_FORMAT_B8G8R8A8_UNORM ), 4, 1 };
+    const uint32_t backBuffer = m_RenderGraph.ImportTexture( "back buffer", desc, m_pD3DRenderTargetView );
+
+    desc.Format = UINT( DXGI_FORMAT_D24_UNORM_S8_UINT );
+    const uint32_t depth = m_RenderGraph.ImportTexture( "depth", desc, m_pD3DDepthStencilView );
+
+    // オフスクリーンサーフェイスを並列に描画. 各サーフェイスのビットマップを外部リソースとして登録する.
+    const UINT surfaceCount = m_SurfaceGroup.GetSurfaceCount();
+    const uint32_t firstSurface = m_RenderGraph.GetResourceCount();
+    if ( surfaceCount > 0 )
+    {
+        const uint32_t pass = m_RenderGraph.AddPass( "surfaces", [this]( const RenderGraph& )
+        { m_SurfaceGroup.Render( m_ThreadPool, m_FrameIndex ); } );
+
+        for( UINT i = 0; i < surfaceCount; ++i )
+        {
+            ID2D1Bitmap1* pBitmap = m_SurfaceGroup.GetBitmap( i );
+            const D2D1_SIZE_U size = pBitmap->GetPixelSize();
+            const RenderTextureDesc surfaceDesc = { size.width, size.height, UINT( DXGI_FORMAT_B8G8R8A8_UNORM ), 4, 1 };
+            m_RenderGraph.Write( pass, m_RenderGraph.ImportTexture( "surface", surfaceDesc, pBitmap ) );
+        }
+    }
+
     // Direct3D を描画.
-    OnRenderD3D();
+    {
+        const uint32_t pass = m_RenderGraph.AddPass( "d3d", [this]( const RenderGraph& )
+        { OnRenderD3D(); } );
+        m_RenderGraph.Write( pass, backBuffer );
+        m_RenderGraph.Write( pass, depth );
+    }
+
+    // ログ表示を CPU で描画して一時テクスチャに転送. 実体はレンダーグラフがフレームをまたいで使い回す.
+    uint32_t logView = INVALID_RENDER_RESOURCE;
+    if ( surfaceCount == 0 && !m_LogPath.empty() )
+    {
+        desc.Format = UINT( DXGI_FORMAT_B8G8R8A8_UNORM );
+        logView = m_RenderGraph.CreateTexture( "log view", desc );
+
+        const uint32_t pass = m_RenderGraph.AddPass( "log view", [this, logView]( const RenderGraph& graph )
+        { UploadLogView( graph.GetPhysical( logView ) ); } );
+        m_RenderGraph.Write( pass, logView );
+    }
 
     // Direct2D を描画.
+    {
+        const uint32_t pass = m_RenderGraph.AddPass( "d2d", [this]( const RenderGraph& )
+        { OnRenderD2D(); } );
+        m_RenderGraph.Read ( pass, backBuffer );
+        m_RenderGraph.Write( pass, backBuffer );
+        for( UINT i = 0; i < surfaceCount; ++i )
+        { m_RenderGraph.Read( pass, firstSurface + i ); }
+        if ( logView != INVALID_RENDER_RESOURCE )
+        { m_RenderGraph.Read( pass, logView ); }
+    }
+
+    // 録画中ならバックバッファを取り込む. 書き出しに失敗した後は取り込まない.
+    if ( m_Recorder.IsOpen() && !m_Recorder.IsFailed() )
+    {
+        const uint32_t pass = m_RenderGraph.AddPass( "capture", [this]( const RenderGraph& )
+        { CaptureFrame(); }, true );
+        m_RenderGraph.Read( pass, backBuffer );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーグラフを使わずに固定の順序で描画します.
+//      一時テクスチャを使うログ表示は省き, バックバッファに直接描くパスだけを実行します.
+//-------------------------------------------------------------------------------------------------
+void App::RenderFixedPasses()
+{
+    m_pLogBitmap = nullptr;
+
+    if ( m_SurfaceGroup.GetSurfaceCount() > 0 )
+    { m_SurfaceGroup.Render( m_ThreadPool, m_FrameIndex ); }
+
+    OnRenderD3D();
     OnRenderD2D();
 
-    // 描画コマンドをフラッシュして表示.
-    m_pDXGISwapChain->Present( 0, 0 );
+    if ( m_Recorder.IsOpen() && !m_Recorder.IsFailed() )
+    { CaptureFrame(); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーグラフの一時テクスチャを生成します. レンダーターゲットとシェーダリソースの両方の
+//      ビューを持たせます. 失敗した場合は nullptr を返し, RenderGraph::Compile() が失敗します.
+//-------------------------------------------------------------------------------------------------
+void* App::CreateTransientTexture( const RenderTextureDesc& desc )
+{
+    D3D11_TEXTURE2D_DESC td;
+    ZeroMemory( &td, sizeof(td) );
+    td.Width                = desc.Width;
+    td.Height               = desc.Height;
+    td.MipLevels            = 1;
+    td.ArraySize            = 1;
+    td.Format               = DXGI_FORMAT( desc.Format );
+    td.SampleDesc.Count     = ( desc.SampleCount > 0 ) ? desc.SampleCount : 1;
+    td.SampleDesc.Quality   = 0;
+    td.Usage                = D3D11_USAGE_DEFAULT;
+    td.BindFlags            = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    td.CPUAccessFlags       = 0;
+    td.MiscFlags            = 0;
+
+    TransientTexture* pResult = new TransientTexture();
+
+    HRESULT hr = m_pD3DDevice->CreateTexture2D( &td, nullptr, &pResult->pTexture );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateTexture2D() Failed." );
+        delete pResult;
+        return nullptr;
+    }
+    m_ResourceTracker.Track( pResult->pTexture, RESOURCE_CATEGORY_TEXTURE, RenderGraph::GetTextureBytes( desc ) );
+
+    hr = m_pD3DDevice->CreateRenderTargetView( pResult->pTexture, nullptr, &pResult->pRTV );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateRenderTargetView() Failed." );
+        DestroyTransientTexture( pResult );
+        return nullptr;
+    }
+
+    hr = m_pD3DDevice->CreateShaderResourceView( pResult->pTexture, nullptr, &pResult->pSRV );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateShaderResourceView() Failed." );
+        DestroyTransientTexture( pResult );
+        return nullptr;
+    }
+
+    return pResult;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーグラフの一時テクスチャを破棄します.
+//-------------------------------------------------------------------------------------------------
+void App::DestroyTransientTexture( void* pPhysical )
+{
+    TransientTexture* pTransient = static_cast<TransientTexture*>( pPhysical );
+    if ( pTransient == nullptr )
+    { return; }
+
+    SafeRelease( pTransient->pBitmap );
+    SafeRelease( pTransient->pSRV );
+    SafeRelease( pTransient->pRTV );
+    SafeRelease( pTransient->pTexture, m_ResourceTracker );
+    delete pTransient;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -639,21 +1486,34 @@ void App::Render()
 void App::OnRenderD3D()
 {
     FLOAT clearColor[4] = { 0.392156899f, 0.584313750f, 0.929411829f, 1.0f };   // CornflowerBlue.
-    UINT  stride = sizeof(SimpleVertex);
-    UINT  offset = 0;
 
-    m_pD3DDeviceContext->OMSetRenderTargets( 1, &m_pD3DRenderTargetView, m_pD3DDepthStencilView );
+    // 前のフレームから変化していないステートは StateCache が省く.
+    m_StateCache.SetRenderTargets( m_pD3DRenderTargetView, m_pD3DDepthStencilView );
     m_pD3DDeviceContext->ClearRenderTargetView( m_pD3DRenderTargetView, clearColor );
     m_pD3DDeviceContext->ClearDepthStencilView( m_pD3DDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0 );
 
-    m_pD3DDeviceContext->IASetInputLayout( m_pD3DInputLayout );
-    m_pD3DDeviceContext->IASetVertexBuffers( 0, 1, &m_pD3DVertexBuffer, &stride, &offset );
-    m_pD3DDeviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+    m_StateCache.SetPipeline( m_SimplePipeline );
+
+    // 描画ごとの変換を設定. 三角形は変換で回転させ, 形状は正規化デバイス座標のまま描画する.
+    m_DrawTransforms.resize( 1 + m_Shapes.size() );
+    SetDrawTransform( m_DrawTransforms[0], 0.0f, 0.0f, TRIANGLE_SPIN * float( m_FrameIndex ), 1.0f, nullptr );
+    for( size_t i = 1; i < m_DrawTransforms.size(); ++i )
+    { SetIdentityTransform( m_DrawTransforms[i] ); }
 
-    m_pD3DDeviceContext->VSSetShader( m_pD3DVertexShader, nullptr, 0 );
-    m_pD3DDeviceContext->PSSetShader( m_pD3DPixelShader,  nullptr, 0 );
+    if ( UploadDrawTransforms() )
+    {
+        // 三角形を描画.
+        m_StateCache.SetVertexBuffer( m_pD3DTriangleBuffer, sizeof(SimpleVertex), 0 );
+        m_StateCache.DrawInstanced( 3, 1, 0, 0 );
+
+        // ベクター形状を描画.
+        if ( !m_Shapes.empty() )
+        { DrawShapes(); }
+    }
 
-    m_pD3DDeviceContext->Draw( 3, 0 );
+    // スプライトを描画.
+    if ( !m_Sprites.empty() )
+    { DrawSprites(); }
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -661,13 +1521,34 @@ void App::OnRenderD3D()
 //-------------------------------------------------------------------------------------------------
 void App::OnRenderD2D()
 {
-    const WCHAR text[] = L"ぽえ～ん。";
-    const UINT  textSize = sizeof(text) / sizeof(text[0]);
-    D2D1_RECT_F layout = D2D1::RectF( 0, 0, FLOAT(m_Width), FLOAT(m_Height) );
-
     m_pD2DDeviceContext->SetTarget( m_pD2DBitmap );
     m_pD2DDeviceContext->BeginDraw();
-    m_pD2DDeviceContext->DrawTextW( text, textSize, m_pTextFormat, layout, m_pD2DSolidColorBrush );
+
+    // オフスクリーンサーフェイスを格子状に並べて表示.
+    const UINT surfaceCount = m_SurfaceGroup.GetSurfaceCount();
+    if ( surfaceCount > 0 )
+    {
+        const UINT  cols  = UINT( ceil( sqrt( double( surfaceCount ) ) ) );
+        const UINT  rows  = ( surfaceCount + cols - 1 ) / cols;
+        const FLOAT cellW = FLOAT( m_Width  ) / FLOAT( cols );
+        const FLOAT cellH = FLOAT( m_Height ) / FLOAT( rows );
+
+        for( UINT i = 0; i < surfaceCount; ++i )
+        {
+            const FLOAT x = cellW * FLOAT( i % cols );
+            const FLOAT y = cellH * FLOAT( i / cols );
+            m_pD2DDeviceContext->DrawBitmap( m_SurfaceGroup.GetBitmap( i ), D2D1::RectF( x, y, x + cellW, y + cellH ) );
+        }
+    }
+    else if ( !m_LogPath.empty() )
+    { DrawLogView(); }
+    else if ( m_SceneNodes.empty() )
+    { m_pD2DDeviceContext->DrawTextLayout( D2D1::Point2F( 0.0f, 0.0f ), m_pTextLayout, m_pD2DSolidColorBrush ); }
+
+    // シーングラフを描画.
+    if ( !m_SceneNodes.empty() )
+    { DrawScene(); }
+
     m_pD2DDeviceContext->EndDraw();
 }
 
@@ -678,33 +1559,54 @@ void App::OnResize( UINT width, UINT height )
 {
     m_Width  = ( width  > 1 ) ? width  : 1;
     m_Height = ( height > 1 ) ? height : 1;
+    DLOG( "Resize : %u x %u", m_Width, m_Height );
+
+    // 一時テクスチャはサイズが変わると作り直すので, コンパイルに失敗していても再試行する.
+    m_RenderGraphFailed = false;
 
     m_Viewport.Width  = FLOAT( m_Width );
     m_Viewport.Height = FLOAT( m_Height );
 
+    // レイアウト領域が変わったときだけ行分割をやり直させる.
+    if ( m_pTextLayout != nullptr )
+    {
+        m_pTextLayout->SetMaxWidth ( FLOAT( m_Width ) );
+        m_pTextLayout->SetMaxHeight( FLOAT( m_Height ) );
+    }
+
     if ( m_pDXGISwapChain != nullptr
       && m_pD3DDeviceContext != nullptr )
     {
         // フラッシュしておく.
         m_pDXGISwapChain->Present( 0, 0 );
 
+        // 読み戻し待ちのフレームを書き出して, 取り込み用テクスチャを作り直す.
+        if ( m_Recorder.IsOpen() )
+        {
+            FlushCapture();
+            for( UINT i = 0; i < CaptureLatency; ++i )
+            { SafeRelease( m_pD3DCaptureTexture[i], m_ResourceTracker ); }
+        }
+
         // ターゲットを外す.
-        ID3D11RenderTargetView* pNullRTV = nullptr;
-        m_pD3DDeviceContext->OMSetRenderTargets( 1, &pNullRTV, nullptr );
+        // 作り直したビューが解放したビューと同じアドレスになっても設定し直されるよう, StateCache を通す.
+        m_StateCache.SetRenderTargets( nullptr, nullptr );
         m_pD2DDeviceContext->SetTarget( nullptr );
 
         // 解放する.
-        SafeRelease( m_pD3DRenderTargetView );
-        SafeRelease( m_pD3DDepthStencilView );
-        SafeRelease( m_pD2DBitmap );
+        SafeRelease( m_pD3DRenderTargetView, m_ResourceTracker );
+        SafeRelease( m_pD3DDepthStencilView, m_ResourceTracker );
+        SafeRelease( m_pD2DBitmap, m_ResourceTracker );
 
         // バックバッファをリサイズ.
-        HRESULT hr = m_pDXGISwapChain->ResizeBuffers( 2, 0, 0, DXGI_FORMAT_B8G8R8A8_UNORM, 0 );
+        HRESULT hr = m_pDXGISwapChain->ResizeBuffers( m_BackBufferCount, 0, 0, DXGI_FORMAT_B8G8R8A8_UNORM, 0 );
         if ( FAILED( hr ) )
         {
             ELOG( "Error : IDXGISwapChain::ResizeBuffer() Failed." );
             return;
         }
+        m_ResourceTracker.Untrack( m_pDXGISwapChain );
+        m_ResourceTracker.Track( m_pDXGISwapChain, RESOURCE_CATEGORY_SWAP_CHAIN, UINT64( m_Width ) * m_Height * 4 * m_BackBufferCount );
 
         // レンダーターゲットを作成しなおす.
         {
@@ -726,6 +1628,7 @@ void App::OnResize( UINT width, UINT height )
             }
 
             SafeRelease( pTexture );
+            m_ResourceTracker.Track( m_pD3DRenderTargetView, RESOURCE_CATEGORY_VIEW, 0 );
         }
 
         // 深度ステンシルビューを生成しなおす.
@@ -765,6 +1668,7 @@ void App::OnResize( UINT width, UINT height )
             }
 
             SafeRelease( pTexture );
+            m_ResourceTracker.Track( m_pD3DDepthStencilView, RESOURCE_CATEGORY_DEPTH_STENCIL, UINT64( m_Width ) * m_Height * 4 );
         }
 
         // D2Dビットマップを作成しなおす.
@@ -790,6 +1694,7 @@ void App::OnResize( UINT width, UINT height )
             }
 
             SafeRelease( pSurface );
+            m_ResourceTracker.Track( m_pD2DBitmap, RESOURCE_CATEGORY_D2D_BITMAP, 0 );
         }
 
         // ビューポートを設定.
@@ -801,40 +1706,1135 @@ void App::OnResize( UINT width, UINT height )
         m_Viewport.TopLeftY = 0;
         m_pD3DDeviceContext->RSSetViewports( 1, &m_Viewport );
     }
+
+    // リサイズ中の停止を遅延として数えないよう, 表示期限を刻み直す.
+    m_FramePacer.Resync();
 }
 
 //-------------------------------------------------------------------------------------------------
-//      メッセージプロシージャです.
+//      オフスクリーンサーフェイスを初期化します.
 //-------------------------------------------------------------------------------------------------
-LRESULT App::MsgProc( HWND hWnd, UINT uMsg, WPARAM wp, LPARAM lp )
+bool App::InitSurfaces( UINT surfaceCount, UINT threadCount )
 {
-    if ( uMsg == WM_CREATE )
+    static const UINT SurfaceWidth  = 320;
+    static const UINT SurfaceHeight = 180;
+
+    m_SurfaceGroup.Term();
+
+    if ( !m_ThreadPool.Init( threadCount ) )
     {
-        LPCREATESTRUCT pcs = (LPCREATESTRUCT)lp;
-        App *pApp = (App *)pcs->lpCreateParams;
+        ELOG( "Error : ThreadPool::Init() Failed." );
+        return false;
+    }
 
-        SetWindowLongPtrW( hWnd, GWLP_USERDATA, PtrToUlong(pApp) );
+    if ( !m_SurfaceGroup.Init( m_pD2DDevice, m_pDWriteFactory, m_pTextFormat, surfaceCount, SurfaceWidth, SurfaceHeight, &m_ResourceTracker ) )
+    {
+        ELOG( "Error : SurfaceGroup::Init() Failed." );
+        return false;
     }
-    else
+
+    m_StatFrames = 0;
+    m_StatTimer.Reset();
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイス数とスレッド数を変えながら総描画レートを計測します. ウィンドウを作らずに
+//      InitHeadless() で生成したデバイスだけを使います.
+//-------------------------------------------------------------------------------------------------
+bool App::RunSurfaceBenchmark()
+{
+    static const UINT WarmupFrames  = 10;
+    static const UINT MeasureFrames = 120;
+
+    UINT maxThreads = std::thread::hardware_concurrency();
+    if ( maxThreads == 0 )
+    { maxThreads = 1; }
+
+    // 全サーフェイスが 1 つの ID2D1Device を共有するので, マルチスレッドファクトリーのロックで
+    // デバイスへのアクセスが直列化され, スレッド数を増やしても頭打ちになる.
+    std::printf( "Surface Bench : headless (no window, no swap chain), %u hardware threads\n", maxThreads );
+    std::printf( "  all surfaces share one ID2D1Device; the multithreaded D2D factory lock serializes device access and caps scaling\n" );
+    std::printf( "threads, surfaces, frames/s, surfaces/s, steals\n" );
+
+    for( UINT threads = 1; ; threads *= 2 )
     {
-        App *pApp = reinterpret_cast<App*>(
-            static_cast<LONG_PTR>( GetWindowLongPtrW( hWnd, GWLP_USERDATA )));
+        if ( threads > maxThreads )
+        { threads = maxThreads; }
 
-        switch( uMsg )
+        for( UINT surfaces = 1; surfaces <= 64; surfaces *= 2 )
         {
-            case WM_DESTROY:
-                { PostQuitMessage( 0 ); }
-                break;
+            if ( !InitSurfaces( surfaces, threads ) )
+            { return false; }
+
+            for( UINT i = 0; i < WarmupFrames; ++i )
+            { m_SurfaceGroup.Render( m_ThreadPool, i ); }
+            WaitForGpu();
+
+            // GPU の完了までを含めて計測する.
+            Timer timer;
+            for( UINT i = 0; i < MeasureFrames; ++i )
+            { m_SurfaceGroup.Render( m_ThreadPool, i ); }
+            WaitForGpu();
+
+            const double fps = double( MeasureFrames ) / timer.GetElapsedSec();
+            std::printf( "%u, %u, %.1f, %.1f, %llu\n",
+                threads, surfaces, fps, fps * surfaces, (unsigned long long)m_ThreadPool.GetStealCount() );
+        }
 
-            case WM_SIZE:
-                {
-                    UINT w = (UINT)LOWORD( lp );
-                    UINT h = (UINT)HIWORD( lp );
+        if ( threads == maxThreads )
+        { break; }
+    }
 
-                    if ( pApp )
-                    { pApp->OnResize( w, h ); }
-                }
-                break;
+    m_SurfaceGroup.Term();
+    m_ThreadPool.Term();
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ウィンドウのリサイズと描画を繰り返し, リソースのメモリが増えていないことを確認します.
+//      全体だけでなく種類ごとにも比較し, 増減が打ち消し合う場合も失敗として扱います.
+//-------------------------------------------------------------------------------------------------
+bool App::RunResizeTest()
+{
+    static const int Sizes[][2] = { { 640, 360 }, { 1280, 720 }, { 961, 541 }, { 320, 240 }, { 1600, 900 } };
+    const UINT sizeCount = UINT( sizeof(Sizes) / sizeof(Sizes[0]) );
+
+    RECT rc;
+    GetWindowRect( m_hWnd, &rc );
+
+    // 表示期限を待たずに描画して, 遅延生成されるリソースも作り直させる.
+    m_FramePacer.SetTargetRate( 0.0 );
+    Render();
+    const ResourceTracker::Snapshot before = m_ResourceTracker.GetSnapshot();
+
+    Timer timer;
+    for( UINT i = 0; i < m_ResizeTestCycles; ++i )
+    {
+        const int* size = Sizes[i % sizeCount];
+        SetWindowPos( m_hWnd, nullptr, 0, 0, size[0], size[1], SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE );
+
+        MSG msg;
+        while( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) == TRUE )
+        {
+            TranslateMessage( &msg );
+            DispatchMessage( &msg );
+        }
+
+        Render();
+    }
+
+    // 元のサイズに戻して比較する.
+    SetWindowPos( m_hWnd, nullptr, 0, 0, rc.right - rc.left, rc.bottom - rc.top, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE );
+    Render();
+    const ResourceTracker::Snapshot after = m_ResourceTracker.GetSnapshot();
+
+    bool passed = ( after.Total.Bytes == before.Total.Bytes && after.Total.Count == before.Total.Count );
+    for( UINT i = 0; i < RESOURCE_CATEGORY_COUNT; ++i )
+    {
+        if ( after.Category[i].Bytes != before.Category[i].Bytes || after.Category[i].Count != before.Category[i].Count )
+        { passed = false; }
+    }
+
+    std::printf( "Resize Test : %u cycles, %.1f ms/cycle, %s\n",
+        m_ResizeTestCycles, timer.GetElapsedMsec() / double( m_ResizeTestCycles + 1 ), passed ? "passed" : "FAILED" );
+    std::printf( "  before : %llu bytes in %u resources\n", (unsigned long long)before.Total.Bytes, before.Total.Count );
+    std::printf( "  after  : %llu bytes in %u resources, peak %llu bytes\n",
+        (unsigned long long)after.Total.Bytes, after.Total.Count, (unsigned long long)after.Total.PeakBytes );
+
+    // 変化した種類を出力.
+    for( UINT i = 0; i < RESOURCE_CATEGORY_COUNT; ++i )
+    {
+        const ResourceTracker::Usage& b = before.Category[i];
+        const ResourceTracker::Usage& a = after.Category[i];
+        if ( a.Bytes == b.Bytes && a.Count == b.Count )
+        { continue; }
+
+        std::printf( "  %-14s : %llu -> %llu bytes, %u -> %u resources\n",
+            ResourceTracker::GetCategoryName( RESOURCE_CATEGORY( i ) ),
+            (unsigned long long)b.Bytes, (unsigned long long)a.Bytes, b.Count, a.Count );
+    }
+
+    if ( !passed )
+    { ELOG( "Error : Resource memory changed across resize cycles." ); }
+
+    m_FramePacer.SetTargetRate( m_TargetFrameRate );
+    return passed;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リソースの種類ごとのメモリ使用量を出力します. 現在の使用量が残っていればリークとして扱います.
+//-------------------------------------------------------------------------------------------------
+void App::PrintMemoryUsage()
+{
+    const ResourceTracker::Snapshot snapshot = m_ResourceTracker.GetSnapshot();
+    if ( snapshot.FrameCount == 0 && snapshot.Total.PeakCount == 0 )
+    { return; }
+
+    const double MiB = 1024.0 * 1024.0;
+    std::printf( "Resource Memory : peak %.2f MiB, budget %.2f MiB, %llu trims, max churn %.2f MiB/frame\n",
+        double( snapshot.Total.PeakBytes ) / MiB, double( snapshot.BudgetBytes ) / MiB,
+        (unsigned long long)snapshot.TrimCount, double( snapshot.MaxFrameChurnBytes ) / MiB );
+
+    for( UINT i = 0; i < RESOURCE_CATEGORY_COUNT; ++i )
+    {
+        const ResourceTracker::Usage& usage = snapshot.Category[i];
+        if ( usage.PeakCount == 0 )
+        { continue; }
+
+        std::printf( "  %-14s : peak %8.2f MiB (%u), current %8.2f MiB (%u)\n",
+            ResourceTracker::GetCategoryName( RESOURCE_CATEGORY( i ) ),
+            double( usage.PeakBytes ) / MiB, usage.PeakCount,
+            double( usage.Bytes ) / MiB, usage.Count );
+    }
+
+    if ( snapshot.Total.Count > 0 )
+    {
+        std::printf( "  LEAKED : %llu bytes in %u resources\n",
+            (unsigned long long)snapshot.Total.Bytes, snapshot.Total.Count );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      GPU の処理完了を待機します.
+//-------------------------------------------------------------------------------------------------
+void App::WaitForGpu()
+{
+    D3D11_QUERY_DESC desc;
+    desc.Query     = D3D11_QUERY_EVENT;
+    desc.MiscFlags = 0;
+
+    ID3D11Query* pQuery = nullptr;
+    HRESULT hr = m_pD3DDevice->CreateQuery( &desc, &pQuery );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateQuery() Failed." );
+        return;
+    }
+
+    m_pD3DDeviceContext->End( pQuery );
+
+    BOOL done = FALSE;
+    while( m_pD3DDeviceContext->GetData( pQuery, &done, sizeof(done), 0 ) == S_FALSE )
+    { std::this_thread::yield(); }
+
+    SafeRelease( pQuery );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ベクター形状の初期化処理です. 毎フレーム同じ形状を描く UI を想定して,
+//      塗りつぶしと線の形状を格子状に並べます.
+//-------------------------------------------------------------------------------------------------
+bool App::InitShapes( UINT shapeCount )
+{
+    if ( !m_GeometryCache.Init( m_pD3DDevice, 32 * 1024 * 1024, &m_ResourceTracker ) )
+    {
+        ELOG( "Error : GeometryCache::Init() Failed." );
+        return false;
+    }
+    m_GeometryCache.SetEnabled( m_ShapeCacheEnabled );
+
+    const UINT  columns = UINT( std::ceil( std::sqrt( float( shapeCount ) ) ) );
+    const float cell    = 1.9f / float( columns );
+    const float r       = cell * 0.4f;
+
+    m_Shapes.clear();
+    m_Shapes.resize( shapeCount );
+    for( UINT i = 0; i < shapeCount; ++i )
+    {
+        ShapeItem& item = m_Shapes[i];
+        const float cx = -0.95f + cell * ( float( i % columns ) + 0.5f );
+        const float cy =  0.95f - cell * ( float( i / columns ) + 0.5f );
+
+        item.IsStroke         = false;
+        item.Rule             = FILL_RULE_NONZERO;
+        item.Style.Width      = r * 0.15f;
+        item.Style.Join       = LINE_JOIN_MITER;
+        item.Style.Cap        = LINE_CAP_BUTT;
+        item.Style.MiterLimit = 4.0f;
+        item.Color[0]         = 0.3f + 0.7f * float( ( i * 37 ) % 11 ) / 10.0f;
+        item.Color[1]         = 0.3f + 0.7f * float( ( i * 53 ) % 13 ) / 12.0f;
+        item.Color[2]         = 0.3f + 0.7f * float( ( i * 71 ) % 17 ) / 16.0f;
+        item.Color[3]         = 1.0f;
+
+        switch( i % 4 )
+        {
+            // 曲線の辺を持つ星形 (塗りつぶし).
+            case 0:
+                {
+                    for( int j = 0; j < 5; ++j )
+                    {
+                        const float a0 = 6.2831853f * float( j ) / 5.0f;
+                        const float a1 = a0 + 6.2831853f / 10.0f;
+                        const float a2 = a0 + 6.2831853f / 5.0f;
+                        if ( j == 0 )
+                        { item.Geometry.MoveTo( cx + r * std::sin( a0 ), cy + r * std::cos( a0 ) ); }
+                        item.Geometry.QuadTo( cx + r * 0.2f * std::sin( a1 ), cy + r * 0.2f * std::cos( a1 ),
+                                              cx + r * std::sin( a2 ), cy + r * std::cos( a2 ) );
+                    }
+                    item.Geometry.Close();
+                }
+                break;
+
+            // 穴の空いたリング (偶奇規則).
+            case 1:
+                {
+                    AddCircle( item.Geometry, cx, cy, r, true );
+                    AddCircle( item.Geometry, cx, cy, r * 0.55f, true );
+                    item.Rule = FILL_RULE_EVEN_ODD;
+                }
+                break;
+
+            // 波線 (ラウンド結合/端点の線).
+            case 2:
+                {
+                    item.Geometry.MoveTo( cx - r, cy );
+                    item.Geometry.QuadTo( cx - r * 0.5f, cy + r, cx, cy );
+                    item.Geometry.QuadTo( cx + r * 0.5f, cy - r, cx + r, cy );
+                    item.IsStroke   = true;
+                    item.Style.Join = LINE_JOIN_ROUND;
+                    item.Style.Cap  = LINE_CAP_ROUND;
+                }
+                break;
+
+            // 角丸矩形 (マイター結合の線).
+            default:
+                {
+                    const float e = r * 0.8f;
+                    const float k = r * 0.2f;
+                    item.Geometry.MoveTo( cx - e + k, cy - e );
+                    item.Geometry.LineTo( cx + e - k, cy - e );
+                    item.Geometry.QuadTo( cx + e, cy - e, cx + e, cy - e + k );
+                    item.Geometry.LineTo( cx + e, cy + e - k );
+                    item.Geometry.QuadTo( cx + e, cy + e, cx + e - k, cy + e );
+                    item.Geometry.LineTo( cx - e + k, cy + e );
+                    item.Geometry.QuadTo( cx - e, cy + e, cx - e, cy + e - k );
+                    item.Geometry.LineTo( cx - e, cy - e + k );
+                    item.Geometry.QuadTo( cx - e, cy - e, cx - e + k, cy - e );
+                    item.Geometry.Close();
+                    item.IsStroke = true;
+                }
+                break;
+        }
+    }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ベクター形状を描画します. 形状は正規化デバイス座標で保持して恒等変換で描画し,
+//      現在のビューポートから1単位あたりのピクセル数を求めてスケール帯を選びます.
+//      i 番目の形状は描画ごとの変換の 1 + i 番目を使います.
+//-------------------------------------------------------------------------------------------------
+void App::DrawShapes()
+{
+    const float scale  = 0.5f * float( ( m_Width > m_Height ) ? m_Width : m_Height );
+
+    for( size_t i = 0; i < m_Shapes.size(); ++i )
+    {
+        const ShapeItem& item = m_Shapes[i];
+
+        GeometryMesh mesh;
+        const bool ret = ( item.IsStroke )
+            ? m_GeometryCache.GetStroke( item.Geometry, item.Style, scale, item.Color, mesh )
+            : m_GeometryCache.GetFill  ( item.Geometry, item.Rule,  scale, item.Color, mesh );
+        if ( !ret || mesh.VertexCount == 0 )
+        { continue; }
+
+        m_StateCache.SetVertexBuffer( mesh.pVertexBuffer, sizeof(MeshVertex), 0 );
+        m_StateCache.DrawInstanced( mesh.VertexCount, 1, 0, UINT( 1 + i ) );
+    }
+
+    m_GeometryCache.EndFrame();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      今フレームの描画ごとの変換をリングバッファに1回で書き込み, スロット 1 に設定します.
+//      各描画は StartInstanceLocation で自分の要素を選ぶので, 物体を動かしても頂点データは
+//      書き換えずに済みます.
+//-------------------------------------------------------------------------------------------------
+bool App::UploadDrawTransforms()
+{
+    const UINT size = UINT( m_DrawTransforms.size() * sizeof(DrawTransform) );
+
+    RingAllocation alloc;
+    if ( !m_VertexRing.Allocate( size, sizeof(DrawTransform), alloc ) )
+    {
+        ELOG( "Error : RingBuffer::Allocate() Failed." );
+        return false;
+    }
+
+    const D3D11_MAP mapType = ( alloc.MapType == RING_MAP_DISCARD ) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = m_pD3DDeviceContext->Map( m_pD3DVertexBuffer, 0, mapType, 0, &mapped );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11DeviceContext::Map() Failed." );
+        return false;
+    }
+
+    memcpy( static_cast<BYTE*>( mapped.pData ) + alloc.Offset, m_DrawTransforms.data(), size );
+    m_pD3DDeviceContext->Unmap( m_pD3DVertexBuffer, 0 );
+
+    m_StateCache.SetInstanceBuffer( m_pD3DVertexBuffer, sizeof(DrawTransform), UINT( alloc.Offset ) );
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スプライトの初期化処理です. 模様と色の異なるテクスチャを生成し, 各スプライトに
+//      テクスチャとブレンドステートをばらばらに割り当てて, ソートの効果が分かるようにします.
+//-------------------------------------------------------------------------------------------------
+bool App::InitSprites( UINT spriteCount )
+{
+    if ( !m_SpriteRenderer.Init( m_pD3DDevice, 65536, &m_ResourceTracker ) )
+    {
+        ELOG( "Error : SpriteRenderer::Init() Failed." );
+        return false;
+    }
+
+    // テクスチャを生成 (乗算済みアルファの R8G8B8A8).
+    std::vector<UINT> pixels( SPRITE_TEXTURE_SIZE * SPRITE_TEXTURE_SIZE );
+    std::vector<UINT> textures( SPRITE_TEXTURE_COUNT );
+    for( UINT i = 0; i < SPRITE_TEXTURE_COUNT; ++i )
+    {
+        const float r = 0.4f + 0.6f * float( ( i >> 0 ) & 1 );
+        const float g = 0.4f + 0.6f * float( ( i >> 1 ) & 1 );
+        const float b = 0.4f + 0.6f * float( ( i >> 2 ) & 1 );
+
+        for( UINT y = 0; y < SPRITE_TEXTURE_SIZE; ++y )
+        {
+            for( UINT x = 0; x < SPRITE_TEXTURE_SIZE; ++x )
+            {
+                const float u = ( float( x ) + 0.5f ) / float( SPRITE_TEXTURE_SIZE ) * 2.0f - 1.0f;
+                const float v = ( float( y ) + 0.5f ) / float( SPRITE_TEXTURE_SIZE ) * 2.0f - 1.0f;
+                const float d = ( i & 1 ) ? std::sqrt( u * u + v * v ) : std::fmax( std::fabs( u ), std::fabs( v ) );
+
+                // 縁をぼかした円または正方形.
+                float a = ( 1.0f - d ) * 8.0f;
+                a = ( a < 0.0f ) ? 0.0f : ( a > 1.0f ) ? 1.0f : a;
+
+                pixels[y * SPRITE_TEXTURE_SIZE + x] =
+                      ( UINT( a * 255.0f + 0.5f ) << 24 )
+                    | ( UINT( b * a * 255.0f + 0.5f ) << 16 )
+                    | ( UINT( g * a * 255.0f + 0.5f ) << 8 )
+                    |   UINT( r * a * 255.0f + 0.5f );
+            }
+        }
+
+        D3D11_TEXTURE2D_DESC td;
+        ZeroMemory( &td, sizeof(td) );
+        td.Width            = SPRITE_TEXTURE_SIZE;
+        td.Height           = SPRITE_TEXTURE_SIZE;
+        td.MipLevels        = 1;
+        td.ArraySize        = 1;
+        td.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+        td.SampleDesc.Count = 1;
+        td.Usage            = D3D11_USAGE_IMMUTABLE;
+        td.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+
+        D3D11_SUBRESOURCE_DATA res;
+        ZeroMemory( &res, sizeof(res) );
+        res.pSysMem     = pixels.data();
+        res.SysMemPitch = SPRITE_TEXTURE_SIZE * sizeof(UINT);
+
+        ID3D11Texture2D*          pTexture = nullptr;
+        ID3D11ShaderResourceView* pSRV     = nullptr;
+
+        HRESULT hr = m_pD3DDevice->CreateTexture2D( &td, &res, &pTexture );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateTexture2D() Failed." );
+            return false;
+        }
+
+        hr = m_pD3DDevice->CreateShaderResourceView( pTexture, nullptr, &pSRV );
+        SafeRelease( pTexture );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateShaderResourceView() Failed." );
+            return false;
+        }
+
+        textures[i] = m_SpriteRenderer.AddTexture( pSRV, SPRITE_TEXTURE_SIZE * SPRITE_TEXTURE_SIZE * sizeof(UINT) );
+        SafeRelease( pSRV );
+    }
+
+    // スプライトを画面全体にばらまく.
+    m_Sprites.clear();
+    m_Sprites.resize( spriteCount );
+    for( UINT i = 0; i < spriteCount; ++i )
+    {
+        SpriteItem& item = m_Sprites[i];
+        const UINT  hash = i * 2654435761u;
+        const float size = 8.0f + float( ( hash >> 8 ) % 24 );
+
+        item.Shape.X           = float( ( hash >> 4 ) % ( m_Width  + 1 ) );
+        item.Shape.Y           = float( ( hash >> 12 ) % ( m_Height + 1 ) );
+        item.Shape.Width       = size;
+        item.Shape.Height      = size;
+        item.Shape.Rotation    = 0.0f;
+        item.Shape.TexCoord[0] = 0.0f;
+        item.Shape.TexCoord[1] = 0.0f;
+        item.Shape.TexCoord[2] = 1.0f;
+        item.Shape.TexCoord[3] = 1.0f;
+        item.Shape.Color       = 0xffffffff;
+        item.Shape.Layer       = 0;
+        item.VelocityX         = float( int( ( hash >> 16 ) % 9 ) - 4 ) * 0.5f;
+        item.VelocityY         = float( int( ( hash >> 20 ) % 9 ) - 4 ) * 0.5f;
+        item.Spin              = ( i % 3 == 0 ) ? 0.02f : 0.0f;
+        item.Texture           = textures[( hash >> 24 ) % SPRITE_TEXTURE_COUNT];
+        item.Blend             = ( i % 4 == 0 ) ? SPRITE_BLEND_ADDITIVE : SPRITE_BLEND_ALPHA;
+    }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スプライトを動かして描画します. 登録順はばらばらですが, SpriteBatch がテクスチャと
+//      ブレンドステートで並べ替えるので, 描画呼び出しはその組み合わせの数で済みます.
+//-------------------------------------------------------------------------------------------------
+void App::DrawSprites()
+{
+    const float width  = float( m_Width );
+    const float height = float( m_Height );
+
+    m_SpriteBatch.Begin( width, height );
+    for( size_t i = 0; i < m_Sprites.size(); ++i )
+    {
+        SpriteItem& item = m_Sprites[i];
+
+        item.Shape.X        += item.VelocityX;
+        item.Shape.Y        += item.VelocityY;
+        item.Shape.Rotation += item.Spin;
+        if ( item.Shape.X < 0.0f || item.Shape.X > width )
+        { item.VelocityX = -item.VelocityX; }
+        if ( item.Shape.Y < 0.0f || item.Shape.Y > height )
+        { item.VelocityY = -item.VelocityY; }
+
+        m_SpriteBatch.Draw( item.Shape, item.Texture, item.Blend );
+    }
+    m_SpriteBatch.End();
+
+    m_SpriteRenderer.Render( m_pD3DDeviceContext, m_SpriteBatch );
+
+    // SpriteRenderer は StateCache を通さずにステートを設定する.
+    m_StateCache.Invalidate();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      シーングラフの初期化処理です. 10x10 個の項目を持つパネルを格子状に並べます.
+//-------------------------------------------------------------------------------------------------
+bool App::InitScene( UINT nodeCount )
+{
+    const UINT  panelCount = ( nodeCount + SCENE_PANEL_ITEMS ) / ( SCENE_PANEL_ITEMS + 1 );
+    const UINT  columns    = UINT( std::ceil( std::sqrt( float( panelCount ) ) ) );
+    const float panelSize  = SCENE_ITEM_PITCH * 10.0f;
+
+    m_Scene.Clear();
+    m_SceneNodes.clear();
+    m_SceneNodes.reserve( panelCount * ( SCENE_PANEL_ITEMS + 1 ) );
+    m_SceneHandles.clear();
+
+    const SceneNodeId root = m_Scene.CreateNode( INVALID_SCENE_NODE );
+    if ( root == INVALID_SCENE_NODE )
+    { return false; }
+
+    // ウィンドウに収まるように全体を縮小する.
+    const float extent = panelSize * 1.2f * float( columns );
+    const float scale  = float( ( m_Width < m_Height ) ? m_Width : m_Height ) / extent;
+    const float rootMatrix[6] = { scale, 0.0f, 0.0f, scale, 0.0f, 0.0f };
+    m_Scene.SetTransform( root, rootMatrix );
+
+    for( UINT i = 0; i < panelCount; ++i )
+    {
+        const SceneNodeId panel = m_Scene.CreateNode( root );
+        const float panelMatrix[6] = {
+            1.0f, 0.0f, 0.0f, 1.0f,
+            panelSize * 1.2f * float( i % columns ),
+            panelSize * 1.2f * float( i / columns ) };
+        m_Scene.SetTransform( panel, panelMatrix );
+        m_Scene.SetOpacity( panel, 0.5f + 0.5f * float( i % 2 ) );
+
+        const SceneRect clip = { 0.0f, 0.0f, panelSize, panelSize };
+        m_Scene.SetClip( panel, &clip );
+        m_SceneNodes.push_back( panel );
+
+        for( UINT j = 0; j < SCENE_PANEL_ITEMS; ++j )
+        {
+            const SceneNodeId item = m_Scene.CreateNode( panel );
+            const float itemMatrix[6] = {
+                1.0f, 0.0f, 0.0f, 1.0f,
+                SCENE_ITEM_PITCH * float( j % 10 ),
+                SCENE_ITEM_PITCH * float( j / 10 ) };
+            const SceneRect content = { 1.0f, 1.0f, SCENE_ITEM_PITCH - 1.0f, SCENE_ITEM_PITCH - 1.0f };
+            m_Scene.SetTransform( item, itemMatrix );
+            m_Scene.SetContent( item, ( i + j ) % 8, content );
+            m_SceneNodes.push_back( item );
+        }
+    }
+
+    m_Scene.Update();
+    m_Scene.ResetStats();
+
+    // ヒットテスト用に項目のワールド空間の範囲を登録する.
+    if ( !m_SceneIndex.Init( m_Scene.GetWorldBounds( root ), 6 ) )
+    {
+        ELOG( "Error : SpatialIndex::Init() Failed." );
+        return false;
+    }
+
+    m_SceneHandles.resize( m_SceneNodes.size(), INVALID_SPATIAL_HANDLE );
+    for( UINT i = 0; i < m_SceneNodes.size(); ++i )
+    {
+        if ( i % ( SCENE_PANEL_ITEMS + 1 ) != 0 )
+        { m_SceneHandles[i] = m_SceneIndex.Insert( m_Scene.GetWorldBounds( m_SceneNodes[i] ), i ); }
+    }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      毎フレーム 1% のノードの変換行列を変更して, 差分更新します.
+//-------------------------------------------------------------------------------------------------
+void App::UpdateScene()
+{
+    const UINT count   = UINT( m_SceneNodes.size() );
+    const UINT changes = ( count >= 100 ) ? count / 100 : 1;
+
+    m_SceneMoved.clear();
+    for( UINT i = 0; i < changes; ++i )
+    {
+        m_SceneSeed = m_SceneSeed * 1664525u + 1013904223u;
+        const UINT        index = ( m_SceneSeed >> 8 ) % count;
+        const SceneNodeId id    = m_SceneNodes[index];
+        m_SceneMoved.push_back( index );
+
+        // 平行移動を保ったまま少し回転させる.
+        float matrix[6];
+        memcpy( matrix, m_Scene.GetLocalTransform( id ), sizeof(matrix) );
+
+        const float angle = 0.05f * ( ( m_SceneSeed & 1 ) ? 1.0f : -1.0f );
+        const float c = std::cos( angle );
+        const float s = std::sin( angle );
+        const float m0 = matrix[0] * c - matrix[1] * s;
+        const float m1 = matrix[0] * s + matrix[1] * c;
+        const float m2 = matrix[2] * c - matrix[3] * s;
+        const float m3 = matrix[2] * s + matrix[3] * c;
+        matrix[0] = m0;
+        matrix[1] = m1;
+        matrix[2] = m2;
+        matrix[3] = m3;
+
+        m_Scene.SetTransform( id, matrix );
+    }
+
+    m_Scene.Update();
+
+    // 動いた項目の範囲を空間インデックスに反映する. パネルが動いた場合は全ての子が動く.
+    for( size_t i = 0; i < m_SceneMoved.size(); ++i )
+    {
+        const UINT index = m_SceneMoved[i];
+        const UINT first = ( index % ( SCENE_PANEL_ITEMS + 1 ) == 0 ) ? index + 1 : index;
+        const UINT last  = ( index % ( SCENE_PANEL_ITEMS + 1 ) == 0 ) ? index + SCENE_PANEL_ITEMS : index;
+        for( UINT j = first; j <= last && j < count; ++j )
+        { m_SceneIndex.Update( m_SceneHandles[j], m_Scene.GetWorldBounds( m_SceneNodes[j] ) ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      シーングラフのうちウィンドウと重なる項目だけを, 保持しているワールド変換で描画します.
+//-------------------------------------------------------------------------------------------------
+void App::DrawScene()
+{
+    static const D2D1::ColorF colors[8] = {
+        D2D1::ColorF( D2D1::ColorF::Tomato ),
+        D2D1::ColorF( D2D1::ColorF::Gold ),
+        D2D1::ColorF( D2D1::ColorF::YellowGreen ),
+        D2D1::ColorF( D2D1::ColorF::MediumSeaGreen ),
+        D2D1::ColorF( D2D1::ColorF::DeepSkyBlue ),
+        D2D1::ColorF( D2D1::ColorF::RoyalBlue ),
+        D2D1::ColorF( D2D1::ColorF::MediumOrchid ),
+        D2D1::ColorF( D2D1::ColorF::HotPink ),
+    };
+
+    UpdateScene();
+
+    const SceneRect viewport = { 0.0f, 0.0f, FLOAT( m_Width ), FLOAT( m_Height ) };
+    m_Scene.Cull( viewport, m_SceneVisible );
+
+    for( size_t i = 0; i < m_SceneVisible.size(); ++i )
+    {
+        const SceneNodeId id    = m_SceneVisible[i];
+        const float*      world = m_Scene.GetWorldTransform( id );
+        const SceneRect   rect  = m_Scene.GetContentBounds( id );
+
+        m_pD2DDeviceContext->SetTransform( D2D1::Matrix3x2F( world[0], world[1], world[2], world[3], world[4], world[5] ) );
+        m_pD2DSolidColorBrush->SetColor( colors[m_Scene.GetContent( id ) % 8] );
+        m_pD2DSolidColorBrush->SetOpacity( m_Scene.GetWorldOpacity( id ) );
+        m_pD2DDeviceContext->FillRectangle( D2D1::RectF( rect.Left, rect.Top, rect.Right, rect.Bottom ), m_pD2DSolidColorBrush );
+    }
+
+    m_pD2DDeviceContext->SetTransform( D2D1::Matrix3x2F::Identity() );
+    m_pD2DSolidColorBrush->SetColor( D2D1::ColorF( D2D1::ColorF::White ) );
+    m_pD2DSolidColorBrush->SetOpacity( 1.0f );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      クリックされた位置にある最前面の項目を探して, 色を切り替えます.
+//      空間インデックスで候補を絞り込んだ後, ローカル空間に戻して描画内容の範囲と比較します.
+//-------------------------------------------------------------------------------------------------
+void App::HitTestScene( int x, int y )
+{
+    if ( m_SceneNodes.empty() )
+    { return; }
+
+    const float px = float( x ) + 0.5f;
+    const float py = float( y ) + 0.5f;
+    m_SceneIndex.QueryPoint( px, py, m_SceneHits );
+
+    // 配列位置が大きいほど後に描画される (手前にある).
+    UINT hit   = 0;
+    bool found = false;
+    for( size_t i = 0; i < m_SceneHits.size(); ++i )
+    {
+        const UINT        index = m_SceneHits[i];
+        const SceneNodeId id    = m_SceneNodes[index];
+        if ( found && index < hit )
+        { continue; }
+
+        const float* m   = m_Scene.GetWorldTransform( id );
+        const float  det = m[0] * m[3] - m[1] * m[2];
+        if ( det == 0.0f )
+        { continue; }
+
+        const float dx = px - m[4];
+        const float dy = py - m[5];
+        const float lx = ( dx * m[3] - dy * m[2] ) / det;
+        const float ly = ( dy * m[0] - dx * m[1] ) / det;
+
+        const SceneRect rect = m_Scene.GetContentBounds( id );
+        if ( rect.Left <= lx && lx < rect.Right && rect.Top <= ly && ly < rect.Bottom )
+        {
+            hit   = index;
+            found = true;
+        }
+    }
+
+    if ( found )
+    {
+        const SceneNodeId id = m_SceneNodes[hit];
+        m_Scene.SetContent( id, m_Scene.GetContent( id ) + 1, m_Scene.GetContentBounds( id ) );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テキスト表示の初期化処理です. ファイルはメモリマップして開き, 表示範囲の行だけを描画します.
+//-------------------------------------------------------------------------------------------------
+bool App::InitLogView()
+{
+    const char* fontPath = m_LogFontPath.empty() ? LOG_DEFAULT_FONT : m_LogFontPath.c_str();
+    if ( !m_LogFont.Init( fontPath ) )
+    {
+        ELOG( "Error : FontFace::Init() Failed. path = %s", fontPath );
+        return false;
+    }
+
+    if ( !m_LogBuffer.Open( m_LogPath.c_str() ) )
+    {
+        ELOG( "Error : TextBuffer::Open() Failed. path = %s", m_LogPath.c_str() );
+        return false;
+    }
+
+    if ( !m_LogView.Init( &m_LogFont, LOG_FONT_SIZE, m_Width, m_Height ) )
+    {
+        ELOG( "Error : TextView::Init() Failed." );
+        return false;
+    }
+
+    m_LogView.SetBuffer( &m_LogBuffer );
+    m_LogView.SetColors( Surface::PackColor( 0.9f, 0.9f, 0.9f, 1.0f ), Surface::PackColor( 0.1f, 0.1f, 0.15f, 1.0f ) );
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テキストを CPU で描画し, レンダーグラフの一時テクスチャに転送します.
+//      転送できた場合は, 今フレームの Direct2D の描画で使うビットマップを m_pLogBitmap に設定します.
+//-------------------------------------------------------------------------------------------------
+void App::UploadLogView( void* pPhysical )
+{
+    TransientTexture* pTarget = static_cast<TransientTexture*>( pPhysical );
+
+    // ウィンドウサイズが変わった場合は作り直す.
+    if ( m_LogSurface.GetWidth() != m_Width || m_LogSurface.GetHeight() != m_Height )
+    {
+        m_ResourceTracker.Untrack( m_LogSurface.GetPixels() );
+        if ( !m_LogSurface.Init( m_Width, m_Height ) || !m_LogView.Resize( m_Width, m_Height ) )
+        {
+            ELOG( "Error : Log View Resize Failed." );
+            return;
+        }
+        m_ResourceTracker.Track( m_LogSurface.GetPixels(), RESOURCE_CATEGORY_SURFACE, UINT64( m_LogSurface.GetPitch() ) * m_LogSurface.GetHeight() );
+    }
+
+    // 一時テクスチャを Direct2D から描画するビットマップは, テクスチャと同じ寿命で使い回す.
+    if ( pTarget->pBitmap == nullptr )
+    {
+        IDXGISurface* pSurface = nullptr;
+        HRESULT hr = pTarget->pTexture->QueryInterface( IID_IDXGISurface, (LPVOID*)&pSurface );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Texture2D::QueryInterface() Failed." );
+            return;
+        }
+
+        const auto bitmapProp = D2D1::BitmapProperties1(
+            D2D1_BITMAP_OPTIONS_NONE,
+            D2D1::PixelFormat( DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED ) );
+
+        hr = m_pD2DDeviceContext->CreateBitmapFromDxgiSurface( pSurface, bitmapProp, &pTarget->pBitmap );
+        SafeRelease( pSurface );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID2D1DeviceContext::CreateBitmapFromDxgiSurface() Failed." );
+            return;
+        }
+    }
+
+    if ( !m_LogView.Draw( m_LogSurface ) )
+    { return; }
+
+    m_pD3DDeviceContext->UpdateSubresource( pTarget->pTexture, 0, nullptr, m_LogSurface.GetPixels(), m_LogSurface.GetPitch(), 0 );
+    m_pLogBitmap = pTarget->pBitmap;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      一時テクスチャに転送したログ表示を描画します.
+//-------------------------------------------------------------------------------------------------
+void App::DrawLogView()
+{
+    if ( m_pLogBitmap != nullptr )
+    { m_pD2DDeviceContext->DrawBitmap( m_pLogBitmap ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      マウスホイールでテキストをスクロールします.
+//-------------------------------------------------------------------------------------------------
+void App::ScrollLogView( int wheelDelta )
+{
+    if ( m_LogPath.empty() )
+    { return; }
+
+    const double lines = -double( wheelDelta ) / double( WHEEL_DELTA ) * double( LOG_WHEEL_LINES );
+    m_LogView.ScrollBy( lines * double( m_LogView.GetLineHeight() ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      キー入力でテキストをスクロールします.
+//-------------------------------------------------------------------------------------------------
+void App::OnLogKey( UINT key )
+{
+    if ( m_LogPath.empty() )
+    { return; }
+
+    const double line = double( m_LogView.GetLineHeight() );
+    const double page = double( m_Height ) - line;
+    switch( key )
+    {
+        case VK_UP:
+            { m_LogView.ScrollBy( -line ); }
+            break;
+
+        case VK_DOWN:
+            { m_LogView.ScrollBy( line ); }
+            break;
+
+        case VK_PRIOR:
+            { m_LogView.ScrollBy( -page ); }
+            break;
+
+        case VK_NEXT:
+            { m_LogView.ScrollBy( page ); }
+            break;
+
+        case VK_HOME:
+            { m_LogView.ScrollTo( 0.0 ); }
+            break;
+
+        // 範囲は描画時に制限される.
+        case VK_END:
+            { m_LogView.ScrollTo( m_LogView.GetContentHeight() ); }
+            break;
+
+        default:
+            { /* DO_NOTHING */ }
+            break;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入力イベントの到着時刻を記録します.
+//-------------------------------------------------------------------------------------------------
+void App::OnInput( INPUT_EVENT_TYPE type, int64_t arrivalTicks )
+{ m_InputTracker.PushEvent( type, arrivalTicks ); }
+
+//-------------------------------------------------------------------------------------------------
+//      キューに溜まった入力メッセージだけを処理します.
+//      リサイズなどの他のメッセージは描画の途中で処理しないよう, メインループに残しておきます.
+//-------------------------------------------------------------------------------------------------
+void App::PumpInputMessages()
+{
+    static const UINT ranges[][2] = {
+        { WM_KEYFIRST,          WM_KEYLAST },
+        { WM_MOUSEFIRST,        WM_MOUSELAST },
+        { WM_SYNTHETIC_INPUT,   WM_SYNTHETIC_INPUT },
+    };
+
+    MSG msg;
+    for( size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i )
+    {
+        while( PeekMessage( &msg, nullptr, ranges[i][0], ranges[i][1], PM_REMOVE ) )
+        {
+            TranslateMessage( &msg );
+            DispatchMessage( &msg );
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      録画の初期化処理です.
+//-------------------------------------------------------------------------------------------------
+bool App::InitCapture()
+{
+    // 録画サイズは開始時のクライアント領域で固定. リサイズ後は切り抜き/黒埋めされる.
+    if ( !m_Recorder.Open( m_RecordPath.c_str(), m_Width, m_Height, 60 ) )
+    {
+        ELOG( "Error : FrameRecorder::Open() Failed." );
+        return false;
+    }
+
+    m_CaptureHead    = 0;
+    m_CapturePending = 0;
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      録画の終了処理です.
+//-------------------------------------------------------------------------------------------------
+void App::TermCapture()
+{
+    if ( m_Recorder.IsOpen() )
+    {
+        FlushCapture();
+        m_Recorder.Close();
+
+        const FrameRecorder::Stats stats = m_Recorder.GetStats();
+        std::printf( "Recording : %llu frames written (%llu submitted)\n",
+            (unsigned long long)stats.WrittenFrames, (unsigned long long)stats.SubmittedFrames );
+        std::printf( "  convert     : %.3f ns/pixel\n", stats.ConvertNsPerPixel );
+        std::printf( "  queue depth : avg %.2f, max %u\n", stats.AvgQueueDepth, UINT( stats.MaxQueueDepth ) );
+        std::printf( "  back-pressure : %llu frames blocked, %.3f ms total\n",
+            (unsigned long long)stats.BlockedFrames, stats.BlockedMsec );
+        if ( stats.WriteFailed )
+        { std::printf( "  write error : output is truncated after %llu frames\n", (unsigned long long)stats.WrittenFrames ); }
+    }
+
+    for( UINT i = 0; i < CaptureLatency; ++i )
+    { SafeRelease( m_pD3DCaptureTexture[i], m_ResourceTracker ); }
+
+    m_CaptureHead    = 0;
+    m_CapturePending = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      バックバッファを取り込みます.
+//-------------------------------------------------------------------------------------------------
+void App::CaptureFrame()
+{
+    HRESULT hr = S_OK;
+
+    // 取り込み用テクスチャを遅延生成.
+    if ( m_pD3DCaptureTexture[0] == nullptr )
+    {
+        D3D11_TEXTURE2D_DESC td;
+        ZeroMemory( &td, sizeof(td) );
+        td.Width                = m_Width;
+        td.Height               = m_Height;
+        td.MipLevels            = 1;
+        td.ArraySize            = 1;
+        td.Format               = DXGI_FORMAT_B8G8R8A8_UNORM;
+        td.SampleDesc.Count     = 1;
+        td.SampleDesc.Quality   = 0;
+        td.Usage                = D3D11_USAGE_STAGING;
+        td.BindFlags            = 0;
+        td.CPUAccessFlags       = D3D11_CPU_ACCESS_READ;
+        td.MiscFlags            = 0;
+
+        for( UINT i = 0; i < CaptureLatency; ++i )
+        {
+            hr = m_pD3DDevice->CreateTexture2D( &td, nullptr, &m_pD3DCaptureTexture[i] );
+            if ( FAILED( hr ) )
+            {
+                ELOG( "Error : ID3D11Device::CreateTexture2D() Failed." );
+                for( UINT j = 0; j < CaptureLatency; ++j )
+                { SafeRelease( m_pD3DCaptureTexture[j], m_ResourceTracker ); }
+                return;
+            }
+            m_ResourceTracker.Track( m_pD3DCaptureTexture[i], RESOURCE_CATEGORY_STAGING, UINT64( m_Width ) * m_Height * 4 );
+        }
+
+        m_CaptureWidth   = m_Width;
+        m_CaptureHeight  = m_Height;
+        m_CaptureHead    = 0;
+        m_CapturePending = 0;
+    }
+
+    // 全スロットが読み戻し待ちなら, 最も古いものを先に書き出す.
+    if ( m_CapturePending == CaptureLatency )
+    { ReadbackCapture(); }
+
+    // GPU 上でコピーだけ発行しておき, 読み戻しは数フレーム後に行う.
+    ID3D11Texture2D* pBackBuffer = nullptr;
+    hr = m_pDXGISwapChain->GetBuffer( 0, IID_ID3D11Texture2D, (LPVOID*)&pBackBuffer );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : IDXGISwapChain::GetBuffer() Failed." );
+        return;
+    }
+
+    m_pD3DDeviceContext->CopyResource( m_pD3DCaptureTexture[m_CaptureHead], pBackBuffer );
+    SafeRelease( pBackBuffer );
+
+    m_CaptureHead = ( m_CaptureHead + 1 ) % CaptureLatency;
+    m_CapturePending++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      最も古い読み戻し待ちのフレームを書き出します.
+//-------------------------------------------------------------------------------------------------
+void App::ReadbackCapture()
+{
+    if ( m_CapturePending == 0 )
+    { return; }
+
+    const UINT oldest = ( m_CaptureHead + CaptureLatency - m_CapturePending ) % CaptureLatency;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = m_pD3DDeviceContext->Map( m_pD3DCaptureTexture[oldest], 0, D3D11_MAP_READ, 0, &mapped );
+    if ( SUCCEEDED( hr ) )
+    {
+        m_Recorder.PushFrame(
+            static_cast<const uint8_t*>( mapped.pData ),
+            mapped.RowPitch,
+            m_CaptureWidth,
+            m_CaptureHeight );
+        m_pD3DDeviceContext->Unmap( m_pD3DCaptureTexture[oldest], 0 );
+    }
+    else
+    { ELOG( "Error : ID3D11DeviceContext::Map() Failed." ); }
+
+    m_CapturePending--;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      読み戻し待ちのフレームを全て書き出します.
+//-------------------------------------------------------------------------------------------------
+void App::FlushCapture()
+{
+    while( m_CapturePending > 0 )
+    { ReadbackCapture(); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      メッセージプロシージャです.
+//-------------------------------------------------------------------------------------------------
+LRESULT App::MsgProc( HWND hWnd, UINT uMsg, WPARAM wp, LPARAM lp )
+{
+    if ( uMsg == WM_CREATE )
+    {
+        LPCREATESTRUCT pcs = (LPCREATESTRUCT)lp;
+        App *pApp = (App *)pcs->lpCreateParams;
+
+        SetWindowLongPtrW( hWnd, GWLP_USERDATA, PtrToUlong(pApp) );
+    }
+    else
+    {
+        App *pApp = reinterpret_cast<App*>(
+            static_cast<LONG_PTR>( GetWindowLongPtrW( hWnd, GWLP_USERDATA )));
+
+        switch( uMsg )
+        {
+            case WM_DESTROY:
+                { PostQuitMessage( 0 ); }
+                break;
+
+            case WM_SIZE:
+                {
+                    UINT w = (UINT)LOWORD( lp );
+                    UINT h = (UINT)HIWORD( lp );
+
+                    if ( pApp )
+                    { pApp->OnResize( w, h ); }
+                }
+                break;
+
+            case WM_KEYDOWN:
+            case WM_SYSKEYDOWN:
+                {
+                    if ( pApp )
+                    {
+                        pApp->OnInput( INPUT_EVENT_KEY, GetMessageArrivalTicks() );
+                        pApp->OnLogKey( UINT( wp ) );
+                    }
+                }
+                break;
+
+            case WM_MOUSEMOVE:
+                {
+                    if ( pApp )
+                    { pApp->OnInput( INPUT_EVENT_MOUSE_MOVE, GetMessageArrivalTicks() ); }
+                }
+                break;
+
+            case WM_LBUTTONDOWN:
+            case WM_RBUTTONDOWN:
+            case WM_MBUTTONDOWN:
+                {
+                    if ( pApp )
+                    {
+                        pApp->OnInput( INPUT_EVENT_MOUSE_BUTTON, GetMessageArrivalTicks() );
+
+                        if ( uMsg == WM_LBUTTONDOWN )
+                        { pApp->HitTestScene( short( LOWORD( lp ) ), short( HIWORD( lp ) ) ); }
+                    }
+                }
+                break;
+
+            case WM_MOUSEWHEEL:
+                {
+                    if ( pApp )
+                    {
+                        pApp->OnInput( INPUT_EVENT_MOUSE_WHEEL, GetMessageArrivalTicks() );
+                        pApp->ScrollLogView( GET_WHEEL_DELTA_WPARAM( wp ) );
+                    }
+                }
+                break;
+
+            case WM_SYNTHETIC_INPUT:
+                {
+                    if ( pApp )
+                    { pApp->OnInput( INPUT_EVENT_SYNTHETIC, UnpackTicks( wp, lp ) ); }
+                }
+                return 0;
 
             default:
                 { /* DO_NOTHING */ }
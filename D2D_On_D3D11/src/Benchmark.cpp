@@ -0,0 +1,3982 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Benchmark.cpp
+// Desc : Headless Benchmarks.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Benchmark.h>
+#include <Blur.h>
+#include <ClipStack.h>
+#include <DrawTransform.h>
+#include <FontFace.h>
+#include <FramePacer.h>
+#include <FrameRecorder.h>
+#include <GlyphRasterizer.h>
+#include <InitGraph.h>
+#include <InputLatency.h>
+#include <Logger.h>
+#include <PixelConvert.h>
+#include <RenderGraph.h>
+#include <ResourceTracker.h>
+#include <RingBuffer.h>
+#include <SceneGraph.h>
+#include <SoftwareSwapChain.h>
+#include <SpatialIndex.h>
+#include <SpriteBatch.h>
+#include <StateCache.h>
+#include <Gradient.h>
+#include <Surface.h>
+#include <SurfacePool.h>
+#include <TextBuffer.h>
+#include <TextLayout.h>
+#include <TextView.h>
+#include <ThreadPool.h>
+#include <TileRenderer.h>
+#include <TriangleRasterizer.h>
+#include <Timer.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <vector>
+
+
+namespace /* anonymous */ {
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// InitStub structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct InitStub
+{
+    const char*     Name;               //!< タスク名です.
+    double          Msec;               //!< 待ち時間です (デバイス生成やファイル読み込みを模擬).
+    bool            MainThread;         //!< メインスレッドで実行するかどうかです.
+    int             Dependencies[4];    //!< 依存するタスクの番号です (-1 で終端).
+};
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t GRADIENT_WIDTH   = 1920;
+const uint32_t GRADIENT_HEIGHT  = 1080;
+const uint32_t GRADIENT_REPEAT  = 8;
+const uint32_t BLUR_REPEAT      = 4;
+const uint32_t CLIP_FRAMES      = 30;
+const int      CLIP_COLUMNS     = 24;
+const int      CLIP_ROWS        = 16;
+const int      CLIP_DEPTH       = 4;
+const uint32_t SPRITE_FRAMES    = 8;
+const uint32_t SPRITE_TEXTURES  = 16;
+const uint32_t SCENE_FANOUT[]   = { 10, 10, 10, 100 };  // 階層ごとの子の数 (葉 100k).
+const uint32_t SCENE_FRAMES     = 60;
+const uint32_t SPATIAL_COUNT    = 1000000;
+const float    SPATIAL_WORLD    = 32768.0f;
+const uint32_t SPATIAL_FRAMES   = 120;
+const uint32_t SPATIAL_POINTS   = 10000;
+const uint32_t TILE_FRAMES      = 20;
+const uint32_t TILE_MAX_THREADS = 32;
+const int      TILE_PANEL_COLS  = 6;
+const int      TILE_PANEL_ROWS  = 4;
+const int      TILE_PANEL_ROW_H = 26;      // パネル内の行の高さ.
+const int      TILE_GLYPH_W     = 7;       // マスクの1文字の幅.
+const int      TILE_GLYPH_H     = 12;      // マスクの1文字の高さ.
+const uint32_t FONT_SIZES[]     = { 12, 16, 24, 48 };   // ピクセル単位の文字サイズ.
+const uint32_t FONT_SAMPLES     = 4096;    // ラスタライズに使うグリフ数の上限.
+const uint32_t FONT_LOOKUPS     = 1000000;
+const uint32_t TEXT_PARAGRAPHS[]= { 1, 10, 100, 1000, 10000, 100000 };
+const float    TEXT_FONT_SIZE   = 16.0f;
+const uint32_t TEXT_MIN_LENGTH  = 20;      // 段落の文字数の下限.
+const uint32_t TEXT_MAX_LENGTH  = 400;     // 段落の文字数の上限.
+const uint32_t TEXT_MAX_WIDTH   = 1920;
+const uint32_t TEXT_MIN_WIDTH   = 640;
+const uint32_t TEXT_RESIZE_STEP = 16;      // ウィンドウのドラッグ 1 回分の幅の変化.
+const uint32_t VIEW_LINES[]     = { 1000, 10000, 100000, 1000000, 10000000 };
+const float    VIEW_FONT_SIZE   = 16.0f;
+const uint32_t VIEW_FRAMES      = 600;     // 連続スクロールのフレーム数.
+const uint32_t VIEW_SCROLL_STEP = 7;       // 1 フレームのスクロール量 (ピクセル).
+const uint32_t VIEW_APPEND_RATE = 10;      // 何フレームごとにログを 1 行追記するか.
+const uint32_t VIEW_JUMPS       = 32;      // ランダムな位置へのジャンプ回数.
+const char*    VIEW_TEMP_PATH   = "TextViewBench.log";
+const uint32_t SWAP_BUFFERS[]   = { 2, 3, 4 };
+const double   SWAP_RENDER_MSEC[] = { 4.0, 13.0 };   // 1 フレームの描画時間 (リフレッシュ間隔より短い/長い).
+const double   SWAP_REFRESH     = 100.0;   // 擬似的な垂直同期の周波数 (Hz).
+const uint32_t SWAP_FRAMES      = 100;
+const uint32_t CONVERT_WIDTH    = 3840;
+const uint32_t CONVERT_HEIGHT   = 2160;
+const uint32_t CONVERT_REPEAT   = 3;
+const uint32_t MSAA_WIDTH       = 960;
+const uint32_t MSAA_HEIGHT      = 540;
+const uint32_t MSAA_FRAMES      = 10;
+const uint32_t MSAA_SHAPES      = 300;
+const uint32_t MSAA_REFERENCE   = 8;       // 基準画像の縦横のスーパーサンプリング倍率.
+const uint32_t MSAA_BACKGROUND  = 0xFF202428;
+const uint32_t INIT_THREADS[]   = { 1, 2, 4 };
+const uint32_t INIT_REPEAT      = 5;
+const double   INIT_FRAME_MSEC  = 5.0;     // 最初のフレームの描画時間.
+const uint32_t MEMORY_CYCLES    = 10000;   // リサイズの繰り返し回数.
+const uint32_t MEMORY_SIZES[][2]= { { 640, 360 }, { 1280, 720 }, { 961, 541 }, { 320, 240 }, { 1600, 900 } };
+const uint32_t MEMORY_BUFFERS   = 2;       // スワップチェインのバックバッファ数.
+const uint32_t MEMORY_MESH_BYTES= 256 * 1024;  // 予算の確認で毎フレーム確保するキャッシュのサイズ.
+const uint64_t MEMORY_CACHE_BUDGET = 4 * 1024 * 1024;  // ウィンドウのリソースに加えてキャッシュに許す量.
+const uint32_t LOGGER_MESSAGES  = 200000;  // 計測で書き込むメッセージ数 (全スレッドの合計).
+const uint32_t LOGGER_VERIFY    = 10000;   // 出力内容を fprintf() と比較するメッセージ数.
+const uint32_t LOGGER_THREADS[] = { 1, 2, 4 };
+const uint32_t LOGGER_BATCH     = 64;      // 1 回の時間計測で書き込むメッセージ数.
+const uint32_t LOGGER_BUFFER    = 1024 * 1024;  // スレッドごとのリングバッファのサイズ.
+const uint32_t LOGGER_PAUSE_USEC= 200;     // 間隔を空ける場合の LOGGER_BATCH 件ごとの待ち時間 (描画の合間を模擬).
+const char*    LOGGER_PASSES[]  = { "shadow", "opaque", "transparent", "ui" };
+const LogSite  LOGGER_SITE      = { LOG_LEVEL_ERROR, __FILE__, __LINE__, "Frame %u : %.3f ms, draws = %d, pass = %s" };
+const uint32_t GRAPH_SIZES[][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+const uint32_t GRAPH_FRAMES     = 1000;    // 組み立てとコンパイルを繰り返すフレーム数.
+const uint32_t GRAPH_SHADOW_SIZE = 2048;    // シャドウマップの縦横のピクセル数.
+const uint32_t STATE_DRAWS      = 20000;   // 1フレームの描画数.
+const uint32_t STATE_FRAMES     = 50;      // 計測するフレーム数.
+const uint32_t STATE_SHADERS    = 4;       // 頂点シェーダと入力レイアウトの組の数.
+const uint32_t STATE_MATERIALS  = 4;       // ピクセルシェーダの数.
+const uint32_t STATE_BLENDS     = 2;       // ブレンドステートの数.
+const uint32_t STATE_TEXTURES   = 32;      // テクスチャの数.
+const uint32_t STATE_MESHES     = 64;      // 頂点バッファの数.
+const uint64_t RING_CAPACITIES[] = {       // リングバッファの容量.
+    1280 * 1024, 2 * 1024 * 1024, 4 * 1024 * 1024, 8 * 1024 * 1024
+};
+const double   RING_GPU_MSEC[]  = { 0.0, 2.0 };  // 1フレームの GPU 処理時間.
+const uint32_t RING_FRAMES      = 200;     // 計測するフレーム数.
+const uint32_t RING_LATENCY     = 3;       // CPU が先行できるフレーム数 (Present() の待ちに相当).
+const uint32_t RING_VERTEX_CHUNKS   = 24;  // 1フレームの頂点データの確保数 (8-56 KiB).
+const uint32_t RING_INDEX_CHUNKS    = 16;  // 1フレームのインデックスデータの確保数 (2-14 KiB).
+const uint32_t RING_CONSTANT_CHUNKS = 64;  // 1フレームの定数データの確保数 (256 バイト).
+const uint32_t XFORM_OBJECTS    = 100000;  // 1フレームで動かす物体数.
+const uint32_t XFORM_VERTICES[] = { 12, 48 };  // 物体1つの頂点数 (正方形と正 16 角形).
+const uint32_t XFORM_MESHES     = 16;      // 物体が共有するメッシュの数.
+const uint32_t XFORM_FRAMES     = 30;      // 計測するフレーム数.
+const uint32_t XFORM_WIDTH      = 1920;    // 物体が動き回る範囲 (ピクセル).
+const uint32_t XFORM_HEIGHT     = 1080;
+const uint32_t XFORM_VERIFY     = 2000;    // ラスタライザで描画結果を比較する物体数.
+const uint32_t XFORM_BACKGROUND = 0xFF202428;
+const uint32_t RECORD_WIDTH     = 1920;
+const uint32_t RECORD_HEIGHT    = 1080;
+const uint32_t RECORD_FRAMES    = 120;     // 1 回の録画で投入するフレーム数.
+const uint32_t RECORD_SOURCES   = 4;       // 使い回す合成フレームの数.
+const uint32_t RECORD_DEPTHS[]  = { 1, 2, 4, 8 };   // 変換待ちと書き出し待ちのキュー長.
+const uint32_t RECORD_VERIFY_SIZES[][2] = {        // SIMD 版とスカラー版を比較する画像サイズ (奇数を含む).
+    { 1, 1 }, { 2, 2 }, { 3, 5 }, { 7, 3 }, { 17, 9 }, { 31, 33 }, { 63, 17 }, { 1920, 1080 }, { 1921, 1081 }
+};
+const char*    RECORD_TEMP_PATH = "FrameRecorderBench.y4m";
+const int64_t  PACER_TICKS_PER_SEC  = 1000000;     // 模擬クロックの分解能 (1 ティック = 1us).
+const double   PACER_RATE           = 60.0;        // 目標フレームレート.
+const int64_t  PACER_RENDER_TICKS   = 4000;        // 1フレームの描画時間.
+const int64_t  PACER_JITTER_TICKS   = 600;         // 描画時間に加える揺らぎの上限.
+const int64_t  PACER_SPIN_TICKS     = 20;          // スピン1回で進む時間.
+const int64_t  PACER_OVERSLEEP_LOW  = 500;         // 通常時のスリープの寝過ごし量.
+const int64_t  PACER_OVERSLEEP_HIGH = 2000;        // 注入する大きな寝過ごし量.
+const int64_t  PACER_SPIKE_TICKS    = 40000;       // 1フレームだけ発生させる描画の遅れ (2.4 周期).
+const uint32_t PACER_WARMUP_FRAMES  = 30;          // 予測が収束するまで統計から除くフレーム数.
+const uint32_t PACER_PHASE_FRAMES   = 300;         // 各段階で計測するフレーム数.
+const uint32_t PACER_SETTLE_FRAMES  = 2;           // 寝過ごし量が増えた直後に遅れを許すフレーム数.
+const uint32_t PACER_BURST_PERIODS  = 10;          // 遅れの後に表示数を数える周期数.
+const uint32_t LATENCY_FRAMES       = 200;         // 計測するフレーム数.
+const uint32_t LATENCY_PER_FRAME    = 5;           // 1フレームに種別ごとに投入するイベント数.
+const uint64_t LATENCY_STEP_USEC    = 10;          // イベントごとの遅延の刻み.
+const uint64_t LATENCY_BASE_USEC[]  = {            // 種別ごとの最小遅延.
+    1000, 3000, 5000, 8000, 12000
+};
+const char*    LATENCY_NAMES[]      = { "key", "mouse move", "mouse button", "mouse wheel", "synthetic" };
+const double   LATENCY_PERCENTILES[] = { 50.0, 95.0, 99.0 };
+const uint32_t LATENCY_CAPACITY     = 64;          // 溢れを確認する時のリングバッファの容量.
+const uint32_t LATENCY_FLOOD        = 100;         // 溢れを確認する時に1フレームで投入するイベント数.
+const PIXEL_FORMAT CONVERT_PAIRS[][2] = {   // 変換元と変換先.
+    { PIXEL_FORMAT_B8G8R8A8,            PIXEL_FORMAT_B8G8R8A8_PREMUL },
+    { PIXEL_FORMAT_B8G8R8A8_PREMUL,     PIXEL_FORMAT_B8G8R8A8 },
+    { PIXEL_FORMAT_B8G8R8A8,            PIXEL_FORMAT_R8G8B8A8 },
+    { PIXEL_FORMAT_B8G8R8A8_PREMUL,     PIXEL_FORMAT_R8G8B8A8 },
+    { PIXEL_FORMAT_B8G8R8A8_PREMUL,     PIXEL_FORMAT_R32G32B32A32_FLOAT },
+    { PIXEL_FORMAT_R32G32B32A32_FLOAT,  PIXEL_FORMAT_B8G8R8A8_PREMUL },
+    { PIXEL_FORMAT_B8G8R8A8_PREMUL,     PIXEL_FORMAT_R16G16B16A16_FLOAT },
+    { PIXEL_FORMAT_R16G16B16A16_FLOAT,  PIXEL_FORMAT_B8G8R8A8_PREMUL },
+    { PIXEL_FORMAT_R32G32B32A32_FLOAT,  PIXEL_FORMAT_R16G16B16A16_FLOAT },
+    { PIXEL_FORMAT_R16G16B16A16_FLOAT,  PIXEL_FORMAT_R32G32B32A32_FLOAT },
+};
+const InitStub INIT_STUBS[]     = {        // App::Init() の初期化タスクを模擬した待ち時間と依存関係.
+    { "window",    12.0, true,  { -1 } },
+    { "d3d",       45.0, true,  { 0, -1 } },
+    { "dwrite",    20.0, false, { 0, -1 } },
+    { "d2d",        8.0, false, { 1, -1 } },
+    { "surfaces",  15.0, false, { 2, 3, -1 } },
+    { "shapes",    25.0, false, { 1, -1 } },
+    { "sprites",   10.0, false, { 1, -1 } },
+    { "scene",      6.0, false, { 0, -1 } },
+    { "logview",   30.0, false, { 0, -1 } },
+    { "capture",    3.0, false, { 0, -1 } },
+};
+const char*    FONT_PATHS[]     = {        // 引数で指定が無い場合に探すフォント.
+#if defined(_WIN32)
+    "C:\\Windows\\Fonts\\arial.ttf",
+    "C:\\Windows\\Fonts\\meiryo.ttc",
+    "C:\\Windows\\Fonts\\msgothic.ttc",
+    "C:\\Windows\\Fonts\\YuGothR.ttc",
+#else
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+    "/usr/share/fonts/truetype/noto/NotoSansCJKjp-Regular.otf",
+#endif
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Global Variables.
+//-------------------------------------------------------------------------------------------------
+int     g_ArgCount  = 0;        // ベンチマーク名に続くコマンドライン引数の数.
+char**  g_ppArgs    = nullptr;  // ベンチマーク名に続くコマンドライン引数.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BenchmarkEntry structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkEntry
+{
+    const char*     Name;               //!< ベンチマーク名です.
+    const char*     Desc;               //!< 説明です.
+    bool            (*Func)();          //!< 実行関数です.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      2つのサーフェイスのチャンネルごとの最大差を求めます.
+//-------------------------------------------------------------------------------------------------
+uint32_t GetMaxChannelDiff( const Surface& a, const Surface& b )
+{
+    uint32_t result = 0;
+    for( uint32_t y = 0; y < a.GetHeight(); ++y )
+    {
+        const uint32_t* pA = a.GetRow( y );
+        const uint32_t* pB = b.GetRow( y );
+        for( uint32_t x = 0; x < a.GetWidth(); ++x )
+        {
+            for( uint32_t shift = 0; shift < 32; shift += 8 )
+            {
+                const int ca = int( ( pA[x] >> shift ) & 0xff );
+                const int cb = int( ( pB[x] >> shift ) & 0xff );
+                const uint32_t diff = uint32_t( ( ca > cb ) ? ca - cb : cb - ca );
+                if ( diff > result )
+                { result = diff; }
+            }
+        }
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイス全体の塗りつぶしにかかる時間 (ミリ秒) を計測します.
+//-------------------------------------------------------------------------------------------------
+double MeasureFill( const GradientBrush& brush, Surface& surface, bool reference )
+{
+    const int w = int( surface.GetWidth () );
+    const int h = int( surface.GetHeight() );
+
+    double best = 0.0;
+    for( uint32_t i = 0; i < GRADIENT_REPEAT; ++i )
+    {
+        Timer timer;
+        if ( reference )
+        { brush.FillRectReference( surface, 0, 0, w, h ); }
+        else
+        { brush.FillRect( surface, 0, 0, w, h ); }
+
+        const double msec = timer.GetElapsedMsec();
+        if ( i == 0 || msec < best )
+        { best = msec; }
+    }
+    return best;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      グラデーションブラシのスパン生成を, 画素ごとの停止点評価と比較します.
+//-------------------------------------------------------------------------------------------------
+bool RunGradientBenchmark()
+{
+    Surface simd;
+    Surface reference;
+    if ( !simd.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) || !reference.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    const GradientStop stops[] = {
+        { 0.00f, { 1.0f, 0.2f, 0.1f, 1.0f } },
+        { 0.30f, { 1.0f, 0.9f, 0.2f, 0.8f } },
+        { 0.55f, { 0.1f, 0.8f, 0.4f, 1.0f } },
+        { 0.80f, { 0.2f, 0.3f, 1.0f, 0.5f } },
+        { 1.00f, { 0.6f, 0.1f, 0.9f, 1.0f } },
+    };
+
+    // 回転 + 非一様スケールを与えて, x 方向の増分が両軸に乗るようにする.
+    const float transform[6] = { 0.9f, 0.3f, -0.2f, 1.1f, 40.0f, -30.0f };
+
+    LinearGradientBrush linear;
+    linear.SetPoints( 200.0f, 100.0f, 700.0f, 400.0f );
+
+    RadialGradientBrush radial;
+    radial.SetEllipse( 960.0f, 540.0f, 300.0f, 180.0f );
+
+    SweepGradientBrush sweep;
+    sweep.SetCenter( 960.0f, 540.0f, 0.5f );
+
+    GradientBrush* brushes[] = { &linear, &radial, &sweep };
+    const char*    brushNames[] = { "linear", "radial", "sweep" };
+    const char*    modeNames [] = { "clamp", "wrap", "mirror" };
+
+    const double pixels = double( GRADIENT_WIDTH ) * double( GRADIENT_HEIGHT );
+
+    std::printf( "Gradient : %u x %u, %u stops, best of %u\n", GRADIENT_WIDTH, GRADIENT_HEIGHT, uint32_t( sizeof(stops) / sizeof(stops[0]) ), GRADIENT_REPEAT );
+    std::printf( "brush, extend, simd Mpix/s, reference Mpix/s, speedup, max diff\n" );
+
+    for( size_t b = 0; b < sizeof(brushes) / sizeof(brushes[0]); ++b )
+    {
+        GradientBrush* pBrush = brushes[b];
+        pBrush->SetStops( stops, uint32_t( sizeof(stops) / sizeof(stops[0]) ) );
+        pBrush->SetTransform( transform );
+
+        for( int mode = EXTEND_MODE_CLAMP; mode <= EXTEND_MODE_MIRROR; ++mode )
+        {
+            pBrush->SetExtendMode( EXTEND_MODE( mode ) );
+
+            const double simdMsec = MeasureFill( *pBrush, simd,      false );
+            const double refMsec  = MeasureFill( *pBrush, reference, true  );
+
+            std::printf( "%s, %s, %.1f, %.1f, %.2fx, %u\n",
+                brushNames[b],
+                modeNames[mode],
+                pixels / ( simdMsec * 1000.0 ),
+                pixels / ( refMsec  * 1000.0 ),
+                refMsec / simdMsec,
+                GetMaxChannelDiff( simd, reference ) );
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ブラー用の入力画像を生成します. 半透明のグラデーション矩形を並べます.
+//-------------------------------------------------------------------------------------------------
+bool CreateBlurSource( Surface& surface )
+{
+    if ( !surface.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    const GradientStop stops[] = {
+        { 0.0f, { 0.9f, 0.9f, 1.0f, 1.0f } },
+        { 1.0f, { 0.1f, 0.4f, 0.8f, 0.6f } },
+    };
+
+    LinearGradientBrush brush;
+    brush.SetStops( stops, uint32_t( sizeof(stops) / sizeof(stops[0]) ) );
+    brush.SetPoints( 0.0f, 0.0f, 240.0f, 60.0f );
+    brush.SetExtendMode( EXTEND_MODE_MIRROR );
+
+    for( int y = 40; y + 60 < int( GRADIENT_HEIGHT ); y += 120 )
+    {
+        for( int x = 40; x + 240 < int( GRADIENT_WIDTH ); x += 320 )
+        { brush.FillRect( surface, x, y, x + 240, y + 60 ); }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ブラー1回あたりの時間 (ミリ秒) を計測します. キャッシュは毎回破棄します.
+//-------------------------------------------------------------------------------------------------
+double MeasureBlur( BlurEffect& effect, const Surface& source, float radius )
+{
+    double best = 0.0;
+    for( uint32_t i = 0; i < BLUR_REPEAT; ++i )
+    {
+        effect.Invalidate();
+
+        Timer timer;
+        effect.ApplyBlur( source, radius );
+
+        const double msec = timer.GetElapsedMsec();
+        if ( i == 0 || msec < best )
+        { best = msec; }
+    }
+    return best;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1080p のブラーとドロップシャドウの処理時間を半径とスレッド数を変えて計測します.
+//-------------------------------------------------------------------------------------------------
+bool RunBlurBenchmark()
+{
+    Surface source;
+    if ( !CreateBlurSource( source ) )
+    { return false; }
+
+    // スレッド数 1 はプール無し, それ以外は呼び出しスレッド + (n - 1) ワーカー.
+    std::vector<uint32_t> threadCounts;
+    const uint32_t maxThreads = std::max( std::thread::hardware_concurrency(), 1u );
+    for( uint32_t n = 1; n < maxThreads; n *= 2 )
+    { threadCounts.push_back( n ); }
+    threadCounts.push_back( maxThreads );
+
+    const float     radii[] = { 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f };
+    const BLUR_MODE modes[] = { BLUR_MODE_GAUSSIAN, BLUR_MODE_BOX };
+    const char*     modeNames[] = { "gaussian", "box" };
+
+    std::printf( "Blur : %u x %u, best of %u\n", GRADIENT_WIDTH, GRADIENT_HEIGHT, BLUR_REPEAT );
+    std::printf( "radius, path" );
+    for( size_t t = 0; t < threadCounts.size(); ++t )
+    { std::printf( ", %uT ms", threadCounts[t] ); }
+    std::printf( ", scaling\n" );
+
+    ThreadPool pool;
+    BlurEffect effect;
+
+    for( size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); ++r )
+    {
+        for( size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m )
+        {
+            effect.SetMode( modes[m] );
+            std::printf( "%.0f, %s", radii[r], modeNames[m] );
+
+            double single = 0.0;
+            double msec   = 0.0;
+            for( size_t t = 0; t < threadCounts.size(); ++t )
+            {
+                if ( threadCounts[t] > 1 )
+                {
+                    pool.Init( threadCounts[t] - 1 );
+                    effect.SetThreadPool( &pool );
+                }
+                else
+                { effect.SetThreadPool( nullptr ); }
+
+                msec = MeasureBlur( effect, source, radii[r] );
+                if ( t == 0 )
+                { single = msec; }
+
+                std::printf( ", %.2f", msec );
+            }
+            std::printf( ", %.2fx\n", single / msec );
+        }
+    }
+
+    // 入力が変わらない場合はハッシュ計算のみで結果を再利用する.
+    effect.SetMode( BLUR_MODE_AUTO );
+    effect.Invalidate();
+    effect.ApplyBlur( source, 16.0f );
+    effect.ResetStats();
+    for( uint32_t i = 0; i < BLUR_REPEAT; ++i )
+    { effect.ApplyBlur( source, 16.0f ); }
+
+    BlurEffect::Stats stats = effect.GetStats();
+    std::printf( "cached : %llu / %llu hits, %.3f ms per lookup (%uT)\n",
+        (unsigned long long)stats.CacheHitCount,
+        (unsigned long long)stats.ApplyCount,
+        stats.HashMsec / double( stats.ApplyCount ),
+        threadCounts.back() );
+
+    const float shadowColor[4] = { 0.0f, 0.0f, 0.0f, 0.6f };
+    effect.ResetStats();
+    for( uint32_t i = 0; i < BLUR_REPEAT; ++i )
+    {
+        effect.Invalidate();
+        effect.ApplyShadow( source, 8.0f, shadowColor, 4, 4 );
+    }
+
+    stats = effect.GetStats();
+    std::printf( "shadow : radius 8, %.2f ms per frame (%uT)\n",
+        ( stats.HashMsec + stats.ProcessMsec ) / double( stats.ApplyCount ),
+        threadCounts.back() );
+
+    effect.SetThreadPool( nullptr );
+    pool.Term();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入れ子のパネルを1フレーム分描画します.
+//      各パネルは平行移動のみの変換で CLIP_DEPTH 段のクリップを積み, 16個に1個は子を回転させ,
+//      8個に1個は半透明のレイヤーで描画します.
+//-------------------------------------------------------------------------------------------------
+void DrawPanels( ClipStack& stack, Surface& surface )
+{
+    const float panelW = float( GRADIENT_WIDTH  ) / float( CLIP_COLUMNS );
+    const float panelH = float( GRADIENT_HEIGHT ) / float( CLIP_ROWS );
+    const float angle  = 0.0872665f;    // 5度.
+
+    surface.Clear( 0xff202020 );
+    stack.Reset();
+
+    for( int row = 0; row < CLIP_ROWS; ++row )
+    {
+        for( int column = 0; column < CLIP_COLUMNS; ++column )
+        {
+            const int   index = row * CLIP_COLUMNS + column;
+            const float x     = float( column ) * panelW;
+            const float y     = float( row    ) * panelH;
+            const bool  layer = ( index % 8 ) == 3;
+
+            const float translate[6] = { 1.0f, 0.0f, 0.0f, 1.0f, x, y };
+            stack.SetTransform( translate );
+            stack.PushAxisAlignedClip( 2.0f, 2.0f, panelW - 2.0f, panelH - 2.0f );
+            if ( layer )
+            { stack.PushLayer( 0.75f ); }
+
+            for( int depth = 1; depth <= CLIP_DEPTH; ++depth )
+            {
+                const float inset = 4.0f * float( depth );
+                if ( ( index % 16 ) == 5 && depth == 2 )
+                {
+                    // 回転したパネルはマスクが必要になる.
+                    const float c = std::cos( angle );
+                    const float s = std::sin( angle );
+                    const float cx = x + panelW * 0.5f;
+                    const float cy = y + panelH * 0.5f;
+                    const float rotate[6] = { c, s, -s, c, cx, cy };
+                    stack.SetTransform( rotate );
+                    stack.PushAxisAlignedClip( inset - panelW * 0.5f, inset - panelH * 0.5f, panelW * 0.5f - inset, panelH * 0.5f - inset );
+                    stack.SetTransform( translate );
+                }
+                else
+                { stack.PushAxisAlignedClip( inset, inset, panelW - inset, panelH - inset ); }
+
+                const uint32_t shade = 0x30 + uint32_t( depth ) * 0x20;
+                ClipRect rect;
+                rect.Left   = int( x );
+                rect.Top    = int( y );
+                rect.Right  = int( x + panelW );
+                rect.Bottom = int( y + panelH );
+                stack.FillRect( rect, 0xff000000 | ( shade << 16 ) | ( shade << 8 ) | 0xa0 );
+            }
+
+            for( int depth = 1; depth <= CLIP_DEPTH; ++depth )
+            { stack.PopClip(); }
+
+            if ( layer )
+            { stack.PopLayer(); }
+            stack.PopClip();
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入れ子のパネル描画で, シザー矩形による高速化の有無を比較します.
+//-------------------------------------------------------------------------------------------------
+bool RunClipBenchmark()
+{
+    Surface surface;
+    if ( !surface.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    std::printf( "Clip : %d panels x %d nested clips, %u frames\n", CLIP_COLUMNS * CLIP_ROWS, CLIP_DEPTH + 1, CLIP_FRAMES );
+    std::printf( "path, ms/frame, clips/frame, scissor/frame, masks/frame, mask allocs, mask bytes, layers/frame, layer allocs, layer reuses\n" );
+
+    uint64_t maskCount[2] = { 0, 0 };
+    uint64_t maskAlloc[2] = { 0, 0 };
+
+    for( int pass = 0; pass < 2; ++pass )
+    {
+        const bool fastPath = ( pass == 0 );
+
+        SurfacePool pool;
+        ClipStack   stack;
+        if ( !stack.Init( &surface, &pool ) )
+        { return false; }
+
+        stack.SetScissorFastPath( fastPath );
+
+        Timer timer;
+        for( uint32_t i = 0; i < CLIP_FRAMES; ++i )
+        { DrawPanels( stack, surface ); }
+        const double msec = timer.GetElapsedMsec() / double( CLIP_FRAMES );
+
+        const ClipStack  ::Stats stats     = stack.GetStats();
+        const SurfacePool::Stats poolStats = pool .GetStats();
+        std::printf( "%s, %.2f, %llu, %llu, %llu, %llu, %llu, %llu, %llu, %llu\n",
+            fastPath ? "scissor" : "mask-only",
+            msec,
+            (unsigned long long)( stats.ClipCount    / CLIP_FRAMES ),
+            (unsigned long long)( stats.ScissorCount / CLIP_FRAMES ),
+            (unsigned long long)( stats.MaskCount    / CLIP_FRAMES ),
+            (unsigned long long)stats.MaskAllocCount,
+            (unsigned long long)stats.MaskBytes,
+            (unsigned long long)( stats.LayerCount   / CLIP_FRAMES ),
+            (unsigned long long)poolStats.AllocCount,
+            (unsigned long long)poolStats.ReuseCount );
+
+        maskCount[pass] = stats.MaskCount;
+        maskAlloc[pass] = stats.MaskAllocCount;
+    }
+
+    std::printf( "avoided : %llu masks/frame rasterized, %llu mask allocations\n",
+        (unsigned long long)( ( maskCount[1] - maskCount[0] ) / CLIP_FRAMES ),
+        (unsigned long long)( maskAlloc[1] - maskAlloc[0] ) );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      登録順のままステートが変わるたびに描画する場合の描画呼び出し数を数えます.
+//-------------------------------------------------------------------------------------------------
+uint32_t CountUnsortedDraws( const std::vector<uint32_t>& textures, const std::vector<SPRITE_BLEND>& blends )
+{
+    uint32_t result = 0;
+    for( size_t i = 0; i < textures.size(); ++i )
+    {
+        if ( i == 0 || textures[i] != textures[i - 1] || blends[i] != blends[i - 1] )
+        { result++; }
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スプライトの収集, 基数ソート, ラン構築の CPU 側の処理速度と描画呼び出し数を計測します.
+//-------------------------------------------------------------------------------------------------
+bool RunSpriteBenchmark()
+{
+    const uint32_t counts[] = { 10000, 100000, 1000000 };
+
+    std::printf( "Sprite : %u textures x %u blend states, %u frames, %ux%u viewport\n",
+        SPRITE_TEXTURES, uint32_t( SPRITE_BLEND_COUNT ), SPRITE_FRAMES, GRADIENT_WIDTH, GRADIENT_HEIGHT );
+    std::printf( "sprites, unsorted draws/frame, sorted draws/frame, sort passes/frame, collect ms/frame, sort ms/frame, Msprites/s\n" );
+
+    for( size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c )
+    {
+        const uint32_t count = counts[c];
+
+        // 登録順でテクスチャとブレンドステートが入り混じるように割り当てる.
+        std::vector<Sprite>         sprites ( count );
+        std::vector<uint32_t>       textures( count );
+        std::vector<SPRITE_BLEND>   blends  ( count );
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            const uint32_t hash = i * 2654435761u;
+            Sprite& sprite = sprites[i];
+            sprite.X           = float( ( hash >> 4 ) % GRADIENT_WIDTH );
+            sprite.Y           = float( ( hash >> 12 ) % GRADIENT_HEIGHT );
+            sprite.Width       = 16.0f;
+            sprite.Height      = 16.0f;
+            sprite.Rotation    = ( i % 3 == 0 ) ? float( i % 628 ) * 0.01f : 0.0f;
+            sprite.TexCoord[0] = 0.0f;
+            sprite.TexCoord[1] = 0.0f;
+            sprite.TexCoord[2] = 1.0f;
+            sprite.TexCoord[3] = 1.0f;
+            sprite.Color       = 0xffffffff;
+            sprite.Layer       = 0;
+            textures[i] = ( hash >> 24 ) % SPRITE_TEXTURES;
+            blends  [i] = SPRITE_BLEND( ( hash >> 20 ) % SPRITE_BLEND_COUNT );
+        }
+
+        SpriteBatch batch;
+        double collectMsec = 0.0;
+        for( uint32_t frame = 0; frame < SPRITE_FRAMES; ++frame )
+        {
+            Timer timer;
+            batch.Begin( float( GRADIENT_WIDTH ), float( GRADIENT_HEIGHT ) );
+            for( uint32_t i = 0; i < count; ++i )
+            { batch.Draw( sprites[i], textures[i], blends[i] ); }
+            collectMsec += timer.GetElapsedMsec();
+
+            batch.End();
+        }
+
+        // ソート結果が正しく並んでいるか確認.
+        const SpriteRun* pRuns = batch.GetRuns();
+        uint32_t total = 0;
+        for( uint32_t i = 0; i < batch.GetRunCount(); ++i )
+        {
+            if ( pRuns[i].Start != total
+              || ( i > 0 && pRuns[i - 1].Blend == pRuns[i].Blend && pRuns[i - 1].Texture >= pRuns[i].Texture )
+              || ( i > 0 && pRuns[i - 1].Blend > pRuns[i].Blend ) )
+            {
+                ELOG( "Error : Sprite runs are not sorted." );
+                return false;
+            }
+            total += pRuns[i].Count;
+        }
+        if ( total != count )
+        {
+            ELOG( "Error : Sprite runs do not cover all sprites." );
+            return false;
+        }
+
+        const SpriteBatch::Stats stats = batch.GetStats();
+        const double frameMsec = ( collectMsec + stats.SortMsec ) / double( SPRITE_FRAMES );
+        std::printf( "%u, %u, %llu, %.1f, %.3f, %.3f, %.1f\n",
+            count,
+            CountUnsortedDraws( textures, blends ),
+            (unsigned long long)( stats.RunCount / SPRITE_FRAMES ),
+            double( stats.SortPassCount ) / double( SPRITE_FRAMES ),
+            collectMsec    / double( SPRITE_FRAMES ),
+            stats.SortMsec / double( SPRITE_FRAMES ),
+            double( count ) / frameMsec / 1000.0 );
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      UI を模した階層 (ウィンドウ, パネル, グループ, 項目) のシーンを深さ優先で構築します.
+//-------------------------------------------------------------------------------------------------
+void BuildScene( SceneGraph& scene, SceneNodeId parent, uint32_t depth, std::vector<SceneNodeId>& nodes )
+{
+    const uint32_t levels = sizeof(SCENE_FANOUT) / sizeof(SCENE_FANOUT[0]);
+    if ( depth >= levels )
+    { return; }
+
+    for( uint32_t i = 0; i < SCENE_FANOUT[depth]; ++i )
+    {
+        const SceneNodeId id = scene.CreateNode( parent );
+        const float matrix[6] = { 1.0f, 0.0f, 0.0f, 1.0f, float( i % 10 ) * 12.0f, float( i / 10 ) * 12.0f };
+        scene.SetTransform( id, matrix );
+        nodes.push_back( id );
+
+        if ( depth + 1 == levels )
+        {
+            const SceneRect content = { 0.0f, 0.0f, 10.0f, 10.0f };
+            scene.SetContent( id, i, content );
+        }
+        else
+        { BuildScene( scene, id, depth + 1, nodes ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      100k ノードのシーンで毎フレーム 1% のノードを動かし, 差分更新と全再計算を比較します.
+//-------------------------------------------------------------------------------------------------
+bool RunSceneBenchmark()
+{
+    SceneGraph incremental;
+    SceneGraph full;
+    std::vector<SceneNodeId> nodes[2];
+    BuildScene( incremental, INVALID_SCENE_NODE, 0, nodes[0] );
+    BuildScene( full,        INVALID_SCENE_NODE, 0, nodes[1] );
+    incremental.Update();
+    full       .UpdateAll();
+    incremental.ResetStats();
+    full       .ResetStats();
+
+    const uint32_t count   = uint32_t( nodes[0].size() );
+    const uint32_t changes = count / 100;
+
+    std::printf( "Scene : %u nodes, %u changed per frame (1%%), %u frames\n", count, changes, SCENE_FRAMES );
+
+    uint32_t seed = 1;
+    for( uint32_t frame = 0; frame < SCENE_FRAMES; ++frame )
+    {
+        for( uint32_t i = 0; i < changes; ++i )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const uint32_t index = ( seed >> 8 ) % count;
+
+            float matrix[6];
+            memcpy( matrix, incremental.GetLocalTransform( nodes[0][index] ), sizeof(matrix) );
+            matrix[4] += float( int( seed & 3 ) - 1 ) * 0.5f;
+            matrix[5] += float( int( ( seed >> 2 ) & 3 ) - 1 ) * 0.5f;
+
+            incremental.SetTransform( nodes[0][index], matrix );
+            full       .SetTransform( nodes[1][index], matrix );
+        }
+
+        incremental.Update();
+        full       .UpdateAll();
+    }
+
+    // 差分更新の結果が全再計算と一致するか確認.
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const SceneRect a = incremental.GetWorldBounds( nodes[0][i] );
+        const SceneRect b = full       .GetWorldBounds( nodes[1][i] );
+        if ( memcmp( &a, &b, sizeof(a) ) != 0 )
+        {
+            ELOG( "Error : Incremental update does not match full update." );
+            return false;
+        }
+    }
+
+    std::printf( "mode, ms/frame, visited/frame, transforms/frame, bounds/frame\n" );
+    const char*       names[2] = { "incremental", "full" };
+    const SceneGraph* graphs[2] = { &incremental, &full };
+    double msec[2];
+    for( int i = 0; i < 2; ++i )
+    {
+        const SceneGraph::Stats stats = graphs[i]->GetStats();
+        msec[i] = stats.UpdateMsec / double( stats.UpdateCount );
+        std::printf( "%s, %.3f, %llu, %llu, %llu\n",
+            names[i], msec[i],
+            (unsigned long long)( stats.VisitCount     / stats.UpdateCount ),
+            (unsigned long long)( stats.TransformCount / stats.UpdateCount ),
+            (unsigned long long)( stats.BoundsCount    / stats.UpdateCount ) );
+    }
+    std::printf( "speedup : %.2fx\n", ( msec[0] > 0.0 ) ? msec[1] / msec[0] : 0.0 );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ベンチマーク用の矩形を生成します. 大半は小さな項目で, 一部にパネル程度の大きさを混ぜます.
+//-------------------------------------------------------------------------------------------------
+SceneRect MakeSpatialRect( uint32_t& seed )
+{
+    seed = seed * 1664525u + 1013904223u;
+    const float x = float( seed >> 8 ) / 16777216.0f * SPATIAL_WORLD;
+    seed = seed * 1664525u + 1013904223u;
+    const float y = float( seed >> 8 ) / 16777216.0f * SPATIAL_WORLD;
+    seed = seed * 1664525u + 1013904223u;
+    const uint32_t kind = ( seed >> 8 ) % 100;
+    const float    size = float( ( seed >> 16 ) & 0xff ) / 255.0f;
+
+    float w = 4.0f + size * 32.0f;
+    if ( kind == 0 )
+    { w = 256.0f + size * 1792.0f; }
+    else if ( kind < 10 )
+    { w = 36.0f + size * 220.0f; }
+
+    const float h = w * ( 0.5f + float( seed & 0xff ) / 255.0f );
+    SceneRect result = { x, y, x + w, y + h };
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1M 個の矩形を登録したルーズ四分木で, ビューポートを動かしながら可視判定と点の問い合わせを計測し,
+//      全要素を走査する場合と比較します.
+//-------------------------------------------------------------------------------------------------
+bool RunSpatialBenchmark()
+{
+    const SceneRect world = { 0.0f, 0.0f, SPATIAL_WORLD, SPATIAL_WORLD };
+
+    SpatialIndex index;
+    if ( !index.Init( world ) )
+    {
+        ELOG( "Error : SpatialIndex::Init() Failed." );
+        return false;
+    }
+
+    std::vector<SceneRect>     rects  ( SPATIAL_COUNT );
+    std::vector<SpatialHandle> handles( SPATIAL_COUNT );
+    uint32_t seed = 1;
+
+    Timer timer;
+    for( uint32_t i = 0; i < SPATIAL_COUNT; ++i )
+    {
+        rects  [i] = MakeSpatialRect( seed );
+        handles[i] = index.Insert( rects[i], i );
+    }
+    const double buildMsec = timer.GetElapsedMsec();
+
+    std::printf( "Spatial : %u primitives, world %.0fx%.0f, build %.1f ms\n",
+        SPATIAL_COUNT, SPATIAL_WORLD, SPATIAL_WORLD, buildMsec );
+    std::printf( "view, moved/frame, relinked/frame, update ms/frame, query ms, linear ms, speedup, visible, culled %%, cells/query, tests/query\n" );
+
+    // 1080p と 4 倍に縮小表示したビューポートで, world を対角線方向にパンする.
+    const float scales[] = { 1.0f, 4.0f };
+    std::vector<uint32_t> result;
+    for( size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s )
+    {
+        const float viewW = 1920.0f * scales[s];
+        const float viewH = 1080.0f * scales[s];
+        const uint32_t moves = SPATIAL_COUNT / 100;
+
+        double   updateMsec = 0.0;
+        double   queryMsec  = 0.0;
+        double   linearMsec = 0.0;
+        uint64_t visible    = 0;
+        index.ResetStats();
+
+        for( uint32_t frame = 0; frame < SPATIAL_FRAMES; ++frame )
+        {
+            // 1% の要素を少しずつ動かす.
+            timer.Reset();
+            for( uint32_t i = 0; i < moves; ++i )
+            {
+                seed = seed * 1664525u + 1013904223u;
+                SceneRect& rect = rects[( seed >> 8 ) % SPATIAL_COUNT];
+                const float dx = float( int( seed & 15 ) - 8 );
+                const float dy = float( int( ( seed >> 4 ) & 15 ) - 8 );
+                rect.Left += dx; rect.Right  += dx;
+                rect.Top  += dy; rect.Bottom += dy;
+                index.Update( handles[( seed >> 8 ) % SPATIAL_COUNT], rect );
+            }
+            updateMsec += timer.GetElapsedMsec();
+
+            const float t = float( frame ) / float( SPATIAL_FRAMES - 1 );
+            const float x = t * ( SPATIAL_WORLD - viewW );
+            const float y = t * ( SPATIAL_WORLD - viewH );
+            const SceneRect view = { x, y, x + viewW, y + viewH };
+
+            timer.Reset();
+            index.QueryRect( view, result );
+            queryMsec += timer.GetElapsedMsec();
+
+            timer.Reset();
+            uint32_t linear = 0;
+            for( uint32_t i = 0; i < SPATIAL_COUNT; ++i )
+            {
+                const SceneRect& r = rects[i];
+                if ( r.Left < view.Right && view.Left < r.Right && r.Top < view.Bottom && view.Top < r.Bottom )
+                { linear++; }
+            }
+            linearMsec += timer.GetElapsedMsec();
+
+            if ( linear != result.size() )
+            {
+                ELOG( "Error : Query result does not match linear scan. (%u != %u)", uint32_t( result.size() ), linear );
+                return false;
+            }
+            visible += linear;
+        }
+
+        const SpatialIndex::Stats stats = index.GetStats();
+        const double frames = double( SPATIAL_FRAMES );
+        std::printf( "%.0fx%.0f, %u, %llu, %.3f, %.3f, %.3f, %.1fx, %llu, %.2f, %llu, %llu\n",
+            viewW, viewH, moves,
+            (unsigned long long)( stats.RelinkCount / SPATIAL_FRAMES ),
+            updateMsec / frames,
+            queryMsec  / frames,
+            linearMsec / frames,
+            ( queryMsec > 0.0 ) ? linearMsec / queryMsec : 0.0,
+            (unsigned long long)( visible / SPATIAL_FRAMES ),
+            100.0 * ( 1.0 - double( visible ) / ( frames * double( SPATIAL_COUNT ) ) ),
+            (unsigned long long)( stats.CellVisitCount / stats.QueryCount ),
+            (unsigned long long)( stats.ItemTestCount  / stats.QueryCount ) );
+    }
+
+    // ヒットテスト用の点の問い合わせ.
+    index.ResetStats();
+    uint64_t hits = 0;
+    timer.Reset();
+    for( uint32_t i = 0; i < SPATIAL_POINTS; ++i )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const float x = float( seed >> 8 ) / 16777216.0f * SPATIAL_WORLD;
+        seed = seed * 1664525u + 1013904223u;
+        const float y = float( seed >> 8 ) / 16777216.0f * SPATIAL_WORLD;
+        index.QueryPoint( x, y, result );
+        hits += result.size();
+    }
+    const double pointMsec = timer.GetElapsedMsec();
+
+    const SpatialIndex::Stats stats = index.GetStats();
+    std::printf( "point : %u queries, %.3f us/query, %.2f hits/query, %llu cells/query, %llu tests/query\n",
+        SPATIAL_POINTS,
+        pointMsec * 1000.0 / double( SPATIAL_POINTS ),
+        double( hits ) / double( SPATIAL_POINTS ),
+        (unsigned long long)( stats.CellVisitCount / stats.QueryCount ),
+        (unsigned long long)( stats.ItemTestCount  / stats.QueryCount ) );
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TileWorkload structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TileWorkload
+{
+    LinearGradientBrush                 Background;     //!< 背景のグラデーションです.
+    LinearGradientBrush                 Header;         //!< パネルの見出しのグラデーションです.
+    Surface                             Icons[4];       //!< アイコン画像です.
+    std::vector<std::vector<uint8_t>>   Texts;          //!< 文字列のカバレッジマスクです.
+    std::vector<uint32_t>               TextLengths;    //!< 文字列の文字数です.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      UI を模した描画に使うブラシ, アイコン, 文字列マスクを生成します.
+//-------------------------------------------------------------------------------------------------
+bool CreateTileWorkload( TileWorkload& workload )
+{
+    const GradientStop background[] = {
+        { 0.0f, { 0.16f, 0.18f, 0.24f, 1.0f } },
+        { 1.0f, { 0.05f, 0.06f, 0.09f, 1.0f } },
+    };
+    workload.Background.SetStops( background, 2 );
+    workload.Background.SetPoints( 0.0f, 0.0f, float( GRADIENT_WIDTH ) * 0.3f, float( GRADIENT_HEIGHT ) );
+
+    const GradientStop header[] = {
+        { 0.0f, { 0.25f, 0.45f, 0.85f, 0.95f } },
+        { 1.0f, { 0.45f, 0.25f, 0.75f, 0.85f } },
+    };
+    workload.Header.SetStops( header, 2 );
+    workload.Header.SetPoints( 0.0f, 0.0f, float( GRADIENT_WIDTH ), 0.0f );
+
+    // 縁をぼかした円のアイコン.
+    for( int i = 0; i < 4; ++i )
+    {
+        Surface& icon = workload.Icons[i];
+        if ( !icon.Init( 20, 20 ) )
+        { return false; }
+
+        for( uint32_t y = 0; y < 20; ++y )
+        {
+            uint32_t* pRow = icon.GetRow( y );
+            for( uint32_t x = 0; x < 20; ++x )
+            {
+                const float dx = float( x ) - 9.5f;
+                const float dy = float( y ) - 9.5f;
+                float a = 9.5f - std::sqrt( dx * dx + dy * dy );
+                a = ( a < 0.0f ) ? 0.0f : ( a > 1.0f ) ? 1.0f : a;
+                pRow[x] = Surface::PackColor( 0.3f + 0.2f * float( i ), 0.8f - 0.15f * float( i ), 0.5f, a );
+            }
+        }
+    }
+
+    // 文字の代わりに, 縦線と横線を組み合わせたアンチエイリアス付きのマスクを並べる.
+    uint32_t seed = 7;
+    for( uint32_t length = 6; length <= 36; length += 2 )
+    {
+        const uint32_t width = length * TILE_GLYPH_W;
+        std::vector<uint8_t> mask( width * TILE_GLYPH_H, 0 );
+
+        for( uint32_t g = 0; g < length; ++g )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const uint32_t bits = seed >> 8;
+            for( int y = 2; y < TILE_GLYPH_H - 1; ++y )
+            {
+                uint8_t* pRow = &mask[y * width + g * TILE_GLYPH_W];
+                if ( bits & ( 1u << ( y / 3 ) ) )
+                { pRow[1] = 255; pRow[2] = 255; pRow[3] = 255; pRow[4] = 128; }
+                if ( bits & ( 1u << ( 8 + y % 3 ) ) )
+                { pRow[1] = 255; pRow[5] = 96; }
+            }
+        }
+
+        workload.Texts.push_back( mask );
+        workload.TextLengths.push_back( length );
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      UI を模したコマンド列 (背景, 影付きのパネル, 見出し, アイコン, 文字列, ボタン, ツールチップ) を記録します.
+//      frame に応じてパネルの中身をスクロールさせます.
+//-------------------------------------------------------------------------------------------------
+void RecordTileWorkload( TileRenderer& renderer, const TileWorkload& workload, uint32_t frame )
+{
+    renderer.Reset();
+
+    const ClipRect screen = { 0, 0, int( GRADIENT_WIDTH ), int( GRADIENT_HEIGHT ) };
+    renderer.FillGradient( screen, &workload.Background );
+
+    const int panelW = int( GRADIENT_WIDTH  ) / TILE_PANEL_COLS;
+    const int panelH = int( GRADIENT_HEIGHT ) / TILE_PANEL_ROWS;
+    const int scroll = int( frame * 3 ) % TILE_PANEL_ROW_H;
+
+    uint32_t text = 0;
+    for( int py = 0; py < TILE_PANEL_ROWS; ++py )
+    {
+        for( int px = 0; px < TILE_PANEL_COLS; ++px )
+        {
+            const int left   = px * panelW + 12;
+            const int top    = py * panelH + 12;
+            const int right  = left + panelW - 24;
+            const int bottom = top  + panelH - 24;
+
+            const ClipRect shadow = { left + 6, top + 6, right + 6, bottom + 6 };
+            const ClipRect body   = { left, top, right, bottom };
+            const ClipRect header = { left, top, right, top + 28 };
+            renderer.FillRect    ( shadow, 0x50000000 );
+            renderer.FillRect    ( body,   0xff2a2e38 );
+            renderer.FillGradient( header, &workload.Header );
+            renderer.DrawMask    ( left + 10, top + 8, 12 * TILE_GLYPH_W, TILE_GLYPH_H, &workload.Texts[3][0], 12 * TILE_GLYPH_W, 0xffffffff );
+
+            // スクロールする行はパネル本体で切り抜く.
+            const ClipRect content = { left, top + 28, right, bottom };
+            renderer.SetScissor( &content );
+            for( int y = top + 32 - scroll; y < bottom; y += TILE_PANEL_ROW_H )
+            {
+                const uint32_t index  = text % uint32_t( workload.Texts.size() );
+                const uint32_t length = workload.TextLengths[index];
+                const uint32_t width  = length * TILE_GLYPH_W;
+                text++;
+
+                if ( ( text & 3 ) == 0 )
+                {
+                    const ClipRect highlight = { left + 4, y, right - 4, y + TILE_PANEL_ROW_H - 2 };
+                    renderer.FillRect( highlight, 0x40304060 );
+                }
+
+                renderer.DrawImage( left + 8, y + 2, &workload.Icons[text % 4] );
+                renderer.DrawMask ( left + 36, y + 6, width, TILE_GLYPH_H, &workload.Texts[index][0], width, 0xffd0d4dc );
+
+                const ClipRect button = { right - 56, y + 3, right - 8, y + TILE_PANEL_ROW_H - 5 };
+                renderer.FillRect( button, ( text & 1 ) ? 0xc0405890 : 0xff3a6ea5 );
+            }
+            renderer.SetScissor( nullptr );
+        }
+    }
+
+    // 画面中央の半透明なツールチップ.
+    const ClipRect tooltip = { int( GRADIENT_WIDTH ) / 2 - 300, int( GRADIENT_HEIGHT ) / 2 - 60, int( GRADIENT_WIDTH ) / 2 + 300, int( GRADIENT_HEIGHT ) / 2 + 60 };
+    renderer.FillRect( tooltip, 0xc0101010 );
+    const uint32_t last = uint32_t( workload.Texts.size() ) - 1;
+    renderer.DrawMask( tooltip.Left + 20, tooltip.Top + 20, workload.TextLengths[last] * TILE_GLYPH_W, TILE_GLYPH_H,
+        &workload.Texts[last][0], workload.TextLengths[last] * TILE_GLYPH_W, 0xffffffff );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      UI を模した 1080p のコマンド列をタイルに振り分けて描画し, スレッド数ごとの速度を比較します.
+//      全てのスレッド数で 1 スレッドと同じ画素になることを確認します.
+//-------------------------------------------------------------------------------------------------
+bool RunTileBenchmark()
+{
+    TileWorkload workload;
+    if ( !CreateTileWorkload( workload ) )
+    {
+        ELOG( "Error : CreateTileWorkload() Failed." );
+        return false;
+    }
+
+    TileRenderer renderer;
+    if ( !renderer.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : TileRenderer::Init() Failed." );
+        return false;
+    }
+
+    Surface direct;
+    Surface expected;
+    Surface target;
+    if ( !direct.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT )
+      || !expected.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT )
+      || !target.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    // タイルに分けずに順番に描画した結果と比較する (グラデーションのスパンの始点が異なる分だけ差が出る).
+    RecordTileWorkload( renderer, workload, 0 );
+    direct.Clear( 0 );
+    renderer.RenderDirect( direct );
+    expected.Clear( 0 );
+    renderer.Render( expected, nullptr );
+
+    renderer.ResetStats();
+    Timer timer;
+    double directMsec = 0.0;
+    for( uint32_t frame = 0; frame < TILE_FRAMES; ++frame )
+    {
+        RecordTileWorkload( renderer, workload, frame );
+        timer.Reset();
+        renderer.RenderDirect( target );
+        directMsec += timer.GetElapsedMsec();
+    }
+
+    std::printf( "Tile : %u x %u, %u commands, %u tiles, %u hardware threads, %u frames\n",
+        GRADIENT_WIDTH, GRADIENT_HEIGHT, renderer.GetCommandCount(), renderer.GetTileCount(),
+        std::thread::hardware_concurrency(), TILE_FRAMES );
+    std::printf( "untiled : %.3f ms/frame, max diff vs tiled %u\n", directMsec / TILE_FRAMES, GetMaxChannelDiff( direct, expected ) );
+    std::printf( "threads, record ms, render ms, speedup, bins/frame, occluded/frame, identical\n" );
+
+    double baseMsec = 0.0;
+    for( uint32_t threads = 1; threads <= TILE_MAX_THREADS; threads *= 2 )
+    {
+        // 呼び出し元のスレッドも ParallelFor() を手伝うので, プールには 1 つ少なく作る.
+        ThreadPool pool;
+        if ( threads > 1 && !pool.Init( threads - 1 ) )
+        {
+            ELOG( "Error : ThreadPool::Init() Failed." );
+            return false;
+        }
+
+        renderer.ResetStats();
+        double recordMsec = 0.0;
+        for( uint32_t frame = 0; frame < TILE_FRAMES; ++frame )
+        {
+            timer.Reset();
+            RecordTileWorkload( renderer, workload, frame );
+            recordMsec += timer.GetElapsedMsec();
+
+            renderer.Render( target, ( threads > 1 ) ? &pool : nullptr );
+        }
+
+        // 最初のフレームを描き直して 1 スレッドの結果と比較.
+        RecordTileWorkload( renderer, workload, 0 );
+        target.Clear( 0 );
+        renderer.Render( target, ( threads > 1 ) ? &pool : nullptr );
+        const bool identical = ( GetMaxChannelDiff( target, expected ) == 0 );
+
+        const TileRenderer::Stats stats = renderer.GetStats();
+        const double renderMsec = stats.RenderMsec / double( stats.FrameCount );
+        if ( threads == 1 )
+        { baseMsec = renderMsec; }
+
+        std::printf( "%u, %.3f, %.3f, %.2fx, %llu, %llu, %s\n",
+            threads,
+            recordMsec / TILE_FRAMES,
+            renderMsec,
+            ( renderMsec > 0.0 ) ? baseMsec / renderMsec : 0.0,
+            (unsigned long long)( stats.BinCount      / stats.FrameCount ),
+            (unsigned long long)( stats.OccludedCount / stats.FrameCount ),
+            identical ? "yes" : "NO" );
+
+        if ( !identical )
+        {
+            ELOG( "Error : Tiled result depends on thread count." );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ベンチマークに使うフォントファイルを求めます. 引数の指定が無い場合は既定の場所を探します.
+//-------------------------------------------------------------------------------------------------
+void FindFontPaths( std::vector<const char*>& paths )
+{
+    paths.clear();
+    for( int i = 0; i < g_ArgCount; ++i )
+    { paths.push_back( g_ppArgs[i] ); }
+
+    if ( !paths.empty() )
+    { return; }
+
+    for( size_t i = 0; i < sizeof(FONT_PATHS) / sizeof(FONT_PATHS[0]); ++i )
+    {
+        FILE* pFile = std::fopen( FONT_PATHS[i], "rb" );
+        if ( pFile == nullptr )
+        { continue; }
+
+        std::fclose( pFile );
+        paths.push_back( FONT_PATHS[i] );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フォントファイルを読み込んで, 輪郭のデコードとラスタライズの速度, 文字コードの検索速度,
+//      フェイスごとのメモリ量を計測します. 引数でフォントファイルを指定できます.
+//-------------------------------------------------------------------------------------------------
+bool RunFontBenchmark()
+{
+    std::vector<const char*> paths;
+    FindFontPaths( paths );
+    if ( paths.empty() )
+    {
+        ELOG( "Error : No font file. usage : -bench font <path> ..." );
+        return false;
+    }
+
+    // "ぽえ～ん。" と ASCII の混在した文字列.
+    const uint32_t text[] = { 0x307D, 0x3048, 0xFF5E, 0x3093, 0x3002, 'H', 'e', 'l', 'l', 'o', ',', ' ', 0x6F22, 0x5B57, 0x1F600, '!' };
+    const uint32_t textLength = sizeof(text) / sizeof(text[0]);
+
+    GlyphRasterizer rasterizer;
+    GlyphBitmap     bitmap;
+    GlyphOutline    outline;
+
+    for( size_t f = 0; f < paths.size(); ++f )
+    {
+        Timer timer;
+        FontFace face;
+        if ( !face.Init( paths[f] ) )
+        {
+            ELOG( "Error : FontFace::Init() Failed. path = %s", paths[f] );
+            return false;
+        }
+        const double loadMsec = timer.GetElapsedMsec();
+
+        const FontMetrics metrics = face.GetMetrics();
+        std::printf( "font : %s\n", paths[f] );
+        std::printf( "  outlines = %s, glyphs = %u, upem = %u, file = %.1f KiB, face memory = %u bytes, load = %.3f ms\n",
+            face.IsCFF() ? "CFF" : "glyf",
+            metrics.GlyphCount,
+            metrics.UnitsPerEm,
+            double( face.GetFileSize() ) / 1024.0,
+            uint32_t( face.GetMemoryUsage() ),
+            loadMsec );
+
+        // 全グリフの輪郭をデコード.
+        uint64_t commandCount = 0;
+        uint32_t failCount    = 0;
+        timer.Reset();
+        for( uint32_t glyph = 0; glyph < metrics.GlyphCount; ++glyph )
+        {
+            if ( !face.GetOutline( glyph, outline ) )
+            { failCount++; }
+            commandCount += outline.Commands.size();
+        }
+        const double decodeMsec = timer.GetElapsedMsec();
+        std::printf( "  decode : %.0f glyphs/s, %.1f commands/glyph, %u failed\n",
+            double( metrics.GlyphCount ) * 1000.0 / std::max( decodeMsec, 1e-6 ),
+            double( commandCount ) / std::max( double( metrics.GlyphCount ), 1.0 ),
+            failCount );
+
+        // 全体から均等に選んだグリフの輪郭をあらかじめデコードしておく.
+        const uint32_t sampleCount = std::min( metrics.GlyphCount, FONT_SAMPLES );
+        std::vector<GlyphOutline> samples( sampleCount );
+        for( uint32_t i = 0; i < sampleCount; ++i )
+        { face.GetOutline( uint32_t( uint64_t( i ) * metrics.GlyphCount / sampleCount ), samples[i] ); }
+
+        std::printf( "  size, raster glyphs/s, decode+raster glyphs/s, avg pixels, avg coverage\n" );
+        for( size_t s = 0; s < sizeof(FONT_SIZES) / sizeof(FONT_SIZES[0]); ++s )
+        {
+            const float scale = float( FONT_SIZES[s] ) / float( metrics.UnitsPerEm );
+
+            // サブピクセル位置は 1/4 ピクセル刻み.
+            uint64_t pixelCount    = 0;
+            uint64_t coverageTotal = 0;
+            timer.Reset();
+            for( uint32_t i = 0; i < sampleCount; ++i )
+            {
+                rasterizer.Rasterize( samples[i], scale, float( i & 3 ) * 0.25f, float( ( i >> 2 ) & 3 ) * 0.25f, bitmap );
+                pixelCount += bitmap.Pixels.size();
+                for( size_t j = 0; j < bitmap.Pixels.size(); ++j )
+                { coverageTotal += bitmap.Pixels[j]; }
+            }
+            const double rasterMsec = timer.GetElapsedMsec();
+
+            timer.Reset();
+            for( uint32_t i = 0; i < sampleCount; ++i )
+            {
+                face.GetOutline( uint32_t( uint64_t( i ) * metrics.GlyphCount / sampleCount ), outline );
+                rasterizer.Rasterize( outline, scale, float( i & 3 ) * 0.25f, float( ( i >> 2 ) & 3 ) * 0.25f, bitmap );
+            }
+            const double totalMsec = timer.GetElapsedMsec();
+
+            std::printf( "  %u, %.0f, %.0f, %.1f, %.1f%%\n",
+                FONT_SIZES[s],
+                double( sampleCount ) * 1000.0 / std::max( rasterMsec, 1e-6 ),
+                double( sampleCount ) * 1000.0 / std::max( totalMsec,  1e-6 ),
+                double( pixelCount ) / std::max( double( sampleCount ), 1.0 ),
+                double( coverageTotal ) * 100.0 / 255.0 / std::max( double( pixelCount ), 1.0 ) );
+        }
+
+        // 文字コードからグリフ番号への変換.
+        uint32_t checksum = 0;
+        timer.Reset();
+        for( uint32_t i = 0; i < FONT_LOOKUPS; ++i )
+        { checksum += face.GetGlyphIndex( text[i % textLength] ); }
+        const double lookupMsec = timer.GetElapsedMsec();
+
+        std::printf( "  cmap : %.1f ns/lookup, \"ぽえ～ん。\" -> %u %u %u %u %u (checksum %u)\n",
+            lookupMsec * 1e6 / double( FONT_LOOKUPS ),
+            face.GetGlyphIndex( text[0] ),
+            face.GetGlyphIndex( text[1] ),
+            face.GetGlyphIndex( text[2] ),
+            face.GetGlyphIndex( text[3] ),
+            face.GetGlyphIndex( text[4] ),
+            checksum );
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      日本語と英語の混在した段落を生成します.
+//-------------------------------------------------------------------------------------------------
+void MakeTextParagraph( uint32_t& seed, std::vector<uint32_t>& text )
+{
+    // "ぽえ～ん。"
+    const uint32_t poen[] = { 0x307D, 0x3048, 0xFF5E, 0x3093, 0x3002 };
+
+    text.clear();
+    seed = seed * 1664525u + 1013904223u;
+    const uint32_t length   = TEXT_MIN_LENGTH + ( seed >> 8 ) % ( TEXT_MAX_LENGTH - TEXT_MIN_LENGTH );
+    const bool     japanese = ( seed & 1 ) != 0;
+
+    while( text.size() < length )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const uint32_t r = seed >> 8;
+        const uint32_t kind = japanese ? r % 8 : 5 + r % 3;
+        switch( kind )
+        {
+        case 0:
+            text.insert( text.end(), poen, poen + 5 );
+            break;
+
+        case 1:
+        case 2:
+            // 漢字とひらがなの文節.
+            for( uint32_t i = 0; i < 1 + ( r >> 4 ) % 3; ++i )
+            { text.push_back( 0x4E00 + ( ( r >> ( i * 3 ) ) * 2654435761u ) % 0x5000 ); }
+            for( uint32_t i = 0; i < 1 + ( r >> 8 ) % 4; ++i )
+            { text.push_back( 0x3042 + ( ( r >> ( i * 2 ) ) * 40503u ) % 0x50 ); }
+            break;
+
+        case 3:
+            text.push_back( ( r & 16 ) ? 0x3001 : 0x3002 );
+            break;
+
+        case 4:
+            text.push_back( 0x300C );
+            for( uint32_t i = 0; i < 2 + ( r >> 4 ) % 6; ++i )
+            { text.push_back( 0x30A2 + ( ( r >> i ) * 40503u ) % 0x50 ); }
+            text.push_back( 0x300D );
+            break;
+
+        default:
+            // 英単語と空白, 句読点.
+            for( uint32_t i = 0; i < 2 + ( r >> 4 ) % 8; ++i )
+            { text.push_back( 'a' + ( ( r >> i ) * 2654435761u >> 7 ) % 26 ); }
+            if ( ( r & 7 ) == 0 )
+            { text.push_back( ( r & 8 ) ? ',' : '.' ); }
+            text.push_back( ' ' );
+            break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ウィンドウのリサイズを想定して折り返し幅を段階的に変え, 1～100k 段落の文書について
+//      変化した段落だけを再レイアウトする場合と全段落を再レイアウトする場合の時間を計測します.
+//      引数でフォントファイルを指定できます.
+//-------------------------------------------------------------------------------------------------
+bool RunTextBenchmark()
+{
+    std::vector<const char*> paths;
+    FindFontPaths( paths );
+    if ( paths.empty() )
+    {
+        ELOG( "Error : No font file. usage : -bench text <path>" );
+        return false;
+    }
+
+    FontFace face;
+    if ( !face.Init( paths[0] ) )
+    {
+        ELOG( "Error : FontFace::Init() Failed. path = %s", paths[0] );
+        return false;
+    }
+
+    // 縮めてから広げる.
+    std::vector<float> widths;
+    for( uint32_t w = TEXT_MAX_WIDTH; w > TEXT_MIN_WIDTH; w -= TEXT_RESIZE_STEP )
+    { widths.push_back( float( w ) ); }
+    for( uint32_t w = TEXT_MIN_WIDTH; w <= TEXT_MAX_WIDTH; w += TEXT_RESIZE_STEP )
+    { widths.push_back( float( w ) ); }
+
+    std::printf( "Text : %s, %.0f px, %u resize steps of %u px between %u and %u\n",
+        paths[0], TEXT_FONT_SIZE, uint32_t( widths.size() ), TEXT_RESIZE_STEP, TEXT_MIN_WIDTH, TEXT_MAX_WIDTH );
+    std::printf( "paragraphs, clusters, shape ms, memory KiB, lines, incremental ms/step, max ms, reflowed/step, full ms/step, speedup, identical\n" );
+
+    std::vector<uint32_t> text;
+    for( size_t n = 0; n < sizeof(TEXT_PARAGRAPHS) / sizeof(TEXT_PARAGRAPHS[0]); ++n )
+    {
+        const uint32_t count = TEXT_PARAGRAPHS[n];
+
+        TextLayout incremental;
+        TextLayout full;
+        if ( !incremental.Init( &face, TEXT_FONT_SIZE ) || !full.Init( &face, TEXT_FONT_SIZE ) )
+        {
+            ELOG( "Error : TextLayout::Init() Failed." );
+            return false;
+        }
+        incremental.SetAlignment( TEXT_ALIGNMENT_CENTER );
+        full       .SetAlignment( TEXT_ALIGNMENT_CENTER );
+
+        uint32_t seed     = 1;
+        uint64_t clusters = 0;
+        Timer timer;
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            MakeTextParagraph( seed, text );
+            incremental.AddParagraph( text.data(), uint32_t( text.size() ) );
+            clusters += text.size();
+        }
+        const double shapeMsec = timer.GetElapsedMsec();
+
+        seed = 1;
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            MakeTextParagraph( seed, text );
+            full.AddParagraph( text.data(), uint32_t( text.size() ) );
+        }
+
+        incremental.SetMaxWidth( float( TEXT_MAX_WIDTH ) );
+        incremental.Update();
+        full.SetMaxWidth( float( TEXT_MAX_WIDTH ) );
+        full.Update();
+        const uint32_t initialLines = incremental.GetLineCount();
+        incremental.ResetStats();
+
+        double   incrementalMsec = 0.0;
+        double   incrementalMax  = 0.0;
+        double   fullMsec        = 0.0;
+        bool     identical       = true;
+        for( size_t s = 0; s < widths.size(); ++s )
+        {
+            timer.Reset();
+            incremental.SetMaxWidth( widths[s] );
+            incremental.Update();
+            const double msec = timer.GetElapsedMsec();
+            incrementalMsec += msec;
+            incrementalMax   = std::max( incrementalMax, msec );
+
+            timer.Reset();
+            full.SetMaxWidth( widths[s] );
+            full.Invalidate();
+            full.Update();
+            fullMsec += timer.GetElapsedMsec();
+
+            identical = identical && ( incremental.GetLineCount() == full.GetLineCount() );
+            for( uint32_t i = 0; i < count && identical; ++i )
+            { identical = ( incremental.GetLineCount( i ) == full.GetLineCount( i ) ); }
+        }
+
+        const TextLayout::Stats stats = incremental.GetStats();
+        const double steps = double( widths.size() );
+        std::printf( "%u, %llu, %.3f, %.1f, %u, %.4f, %.4f, %.1f, %.4f, %.1fx, %s\n",
+            count,
+            (unsigned long long)clusters,
+            shapeMsec,
+            double( incremental.GetMemoryUsage() ) / 1024.0,
+            initialLines,
+            incrementalMsec / steps,
+            incrementalMax,
+            double( stats.ReflowCount ) / steps,
+            fullMsec / steps,
+            ( incrementalMsec > 0.0 ) ? fullMsec / incrementalMsec : 0.0,
+            identical ? "yes" : "NO" );
+
+        if ( !identical )
+        {
+            ELOG( "Error : Incremental layout differs from full layout." );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ログの 1 行を生成します (改行を含みます).
+//-------------------------------------------------------------------------------------------------
+void MakeLogLine( uint32_t& seed, uint64_t index, char* buffer, size_t size, int& length )
+{
+    static const char* levels[] = { "INFO ", "DEBUG", "WARN ", "ERROR" };
+    static const char* messages[] = {
+        "request completed",
+        "cache miss, fetching from origin",
+        "retrying connection\tattempt",
+        "\xE3\x81\xBD\xE3\x81\x88\xEF\xBD\x9E\xE3\x82\x93\xE3\x80\x82",     // ぽえ～ん。
+        "frame presented",
+    };
+
+    seed = seed * 1664525u + 1013904223u;
+    const uint32_t r = seed >> 8;
+    length = std::snprintf( buffer, size, "2026-10-18 %02u:%02u:%02u.%03u [%s] worker-%u: %s %llu (%u ms)\n",
+        uint32_t( index / 3600000 % 24 ), uint32_t( index / 60000 % 60 ), uint32_t( index / 1000 % 60 ), uint32_t( index % 1000 ),
+        levels[r % 4], ( r >> 2 ) % 16, messages[( r >> 6 ) % 5], (unsigned long long)index, ( r >> 9 ) % 1000 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定行数のログファイルを書き出します.
+//-------------------------------------------------------------------------------------------------
+bool WriteLogFile( const char* path, uint64_t lines, uint64_t& bytes )
+{
+    FILE* pFile = std::fopen( path, "wb" );
+    if ( pFile == nullptr )
+    {
+        ELOG( "Error : fopen() Failed. path = %s", path );
+        return false;
+    }
+
+    std::vector<char> chunk;
+    chunk.reserve( 1024 * 1024 );
+
+    uint32_t seed = 1;
+    char     line[256];
+    bytes = 0;
+    for( uint64_t i = 0; i < lines; ++i )
+    {
+        int length = 0;
+        MakeLogLine( seed, i, line, sizeof(line), length );
+        chunk.insert( chunk.end(), line, line + length );
+
+        if ( chunk.size() >= 1024 * 1024 - sizeof(line) || i + 1 == lines )
+        {
+            std::fwrite( chunk.data(), 1, chunk.size(), pFile );
+            bytes += chunk.size();
+            chunk.clear();
+        }
+    }
+
+    std::fclose( pFile );
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1k～10M 行のログファイルをメモリマップして表示し, ランダムな位置へのジャンプと, 末尾への
+//      追記を伴う連続スクロールのフレーム時間を計測します. 表示範囲の行だけを整形するので,
+//      フレーム時間とビューのメモリは行数に依存しないはずです. 最後にキャッシュを使わずに
+//      描画した結果と比較します. 引数でフォントファイルを指定できます.
+//-------------------------------------------------------------------------------------------------
+bool RunViewBenchmark()
+{
+    std::vector<const char*> paths;
+    FindFontPaths( paths );
+    if ( paths.empty() )
+    {
+        ELOG( "Error : No font file. usage : -bench view <path>" );
+        return false;
+    }
+
+    FontFace face;
+    if ( !face.Init( paths[0] ) )
+    {
+        ELOG( "Error : FontFace::Init() Failed. path = %s", paths[0] );
+        return false;
+    }
+
+    Surface target;
+    Surface reference;
+    if ( !target.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) || !reference.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    std::printf( "View : %s, %.0f px, %ux%u, %u scroll frames of %u px, 1 appended line per %u frames, %u jumps\n",
+        paths[0], VIEW_FONT_SIZE, GRADIENT_WIDTH, GRADIENT_HEIGHT, VIEW_FRAMES, VIEW_SCROLL_STEP, VIEW_APPEND_RATE, VIEW_JUMPS );
+    std::printf( "lines, file MiB, index ms, buffer KiB, view KiB, scroll ms/frame, max ms, shaped lines/frame, jump ms, identical\n" );
+
+    bool result = true;
+    for( size_t n = 0; n < sizeof(VIEW_LINES) / sizeof(VIEW_LINES[0]) && result; ++n )
+    {
+        const uint64_t lines = VIEW_LINES[n];
+
+        uint64_t bytes = 0;
+        if ( !WriteLogFile( VIEW_TEMP_PATH, lines, bytes ) )
+        { return false; }
+
+        TextBuffer buffer;
+        TextView   view;
+        TextView   fresh;
+
+        Timer timer;
+        if ( !buffer.Open( VIEW_TEMP_PATH ) )
+        {
+            ELOG( "Error : TextBuffer::Open() Failed." );
+            result = false;
+            break;
+        }
+        const double indexMsec = timer.GetElapsedMsec();
+
+        if ( !view.Init( &face, VIEW_FONT_SIZE, GRADIENT_WIDTH, GRADIENT_HEIGHT )
+          || !fresh.Init( &face, VIEW_FONT_SIZE, GRADIENT_WIDTH, GRADIENT_HEIGHT ) )
+        {
+            ELOG( "Error : TextView::Init() Failed." );
+            result = false;
+            break;
+        }
+        view.SetBuffer( &buffer );
+        view.Draw( target );
+
+        // ランダムな位置へのジャンプ (全ての行を描画し直す).
+        uint32_t seed = 7;
+        double   jumpMsec = 0.0;
+        for( uint32_t i = 0; i < VIEW_JUMPS; ++i )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            view.ScrollToLine( ( uint64_t( seed ) * lines ) >> 32 );
+
+            timer.Reset();
+            view.Draw( target );
+            jumpMsec += timer.GetElapsedMsec();
+        }
+
+        // 中央から連続スクロールしながら末尾に追記する.
+        view.ScrollToLine( lines / 2 );
+        view.Draw( target );
+        view.ResetStats();
+
+        uint32_t logSeed = 11;
+        double   scrollMsec = 0.0;
+        double   maxMsec    = 0.0;
+        for( uint32_t i = 0; i < VIEW_FRAMES; ++i )
+        {
+            timer.Reset();
+            if ( i % VIEW_APPEND_RATE == 0 )
+            {
+                char line[256];
+                int  length = 0;
+                MakeLogLine( logSeed, lines + i, line, sizeof(line), length );
+                buffer.Append( line, size_t( length ) );
+            }
+            view.ScrollBy( double( VIEW_SCROLL_STEP ) );
+            view.Draw( target );
+
+            const double msec = timer.GetElapsedMsec();
+            scrollMsec += msec;
+            maxMsec     = std::max( maxMsec, msec );
+        }
+        const TextView::Stats stats = view.GetStats();
+
+        // キャッシュを使わない描画と比較する.
+        fresh.SetBuffer( &buffer );
+        fresh.ScrollTo( view.GetScroll() );
+        fresh.Draw( reference );
+
+        bool identical = true;
+        for( uint32_t y = 0; y < GRADIENT_HEIGHT && identical; ++y )
+        { identical = ( memcmp( target.GetRow( y ), reference.GetRow( y ), GRADIENT_WIDTH * sizeof(uint32_t) ) == 0 ); }
+
+        std::printf( "%llu, %.1f, %.2f, %.1f, %.1f, %.4f, %.4f, %.2f, %.3f, %s\n",
+            (unsigned long long)lines,
+            double( bytes ) / ( 1024.0 * 1024.0 ),
+            indexMsec,
+            double( buffer.GetMemoryUsage() ) / 1024.0,
+            double( view.GetMemoryUsage() ) / 1024.0,
+            scrollMsec / double( VIEW_FRAMES ),
+            maxMsec,
+            double( stats.StripMissCount ) / double( VIEW_FRAMES ),
+            jumpMsec / double( VIEW_JUMPS ),
+            identical ? "yes" : "NO" );
+
+        if ( !identical )
+        {
+            ELOG( "Error : Cached view differs from uncached view." );
+            result = false;
+        }
+    }
+
+    std::remove( VIEW_TEMP_PATH );
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ソフトウェアスワップチェインの提出モードとバッファ数ごとに, 描画が垂直同期より速い場合と
+//      遅い場合のフレームレート, 破棄数, 表示待ちフレーム数, 提出から表示までの待ち時間, 描画側が
+//      空きバッファを待った時間を計測します. 表示スレッドは走査時に画素とフレーム番号を照合し,
+//      描画中のバッファを表示していないこと, 表示順が逆転していないことを確認します.
+//-------------------------------------------------------------------------------------------------
+bool RunSwapChainBenchmark()
+{
+    const char* MODE_NAMES[PRESENT_MODE_COUNT] = { "fifo", "mailbox", "latest" };
+
+    std::printf( "SwapChain : %ux%u, %.0f Hz refresh, %u frames per run\n",
+        GRADIENT_WIDTH, GRADIENT_HEIGHT, SWAP_REFRESH, SWAP_FRAMES );
+    std::printf( "mode, buffers, render ms, rendered fps, displayed fps, dropped, repeated, in flight avg, in flight max, latency ms avg, latency ms max, blocked ms/frame, valid\n" );
+
+    bool result = true;
+    for( uint32_t mode = 0; mode < PRESENT_MODE_COUNT; ++mode )
+    for( size_t b = 0; b < sizeof(SWAP_BUFFERS) / sizeof(SWAP_BUFFERS[0]); ++b )
+    for( size_t r = 0; r < sizeof(SWAP_RENDER_MSEC) / sizeof(SWAP_RENDER_MSEC[0]); ++r )
+    {
+        const double renderMsec = SWAP_RENDER_MSEC[r];
+
+        // 走査は表示スレッドで行われるので, 描画スレッドとは別に結果を記録する.
+        uint64_t lastFrame = UINT64_MAX;
+        bool     valid     = true;
+        auto scanout = [&]( const Surface& surface, uint64_t frameId )
+        {
+            const uint32_t expected = 0xFF000000u | ( uint32_t( frameId * 2654435761u ) & 0xFFFFFFu );
+            if ( surface.GetRow( 0 )[0] != expected
+              || surface.GetRow( surface.GetHeight() - 1 )[surface.GetWidth() - 1] != expected
+              || ( lastFrame != UINT64_MAX && frameId < lastFrame ) )
+            { valid = false; }
+            lastFrame = frameId;
+        };
+
+        SoftwareSwapChain swapChain;
+        if ( !swapChain.Init( GRADIENT_WIDTH, GRADIENT_HEIGHT, SWAP_BUFFERS[b], PRESENT_MODE( mode ), SWAP_REFRESH, scanout ) )
+        {
+            ELOG( "Error : SoftwareSwapChain::Init() Failed." );
+            return false;
+        }
+
+        Timer timer;
+        for( uint32_t i = 0; i < SWAP_FRAMES; ++i )
+        {
+            uint32_t index    = 0;
+            Surface* pSurface = swapChain.Acquire( index );
+            if ( pSurface == nullptr )
+            {
+                ELOG( "Error : SoftwareSwapChain::Acquire() Failed." );
+                return false;
+            }
+
+            // 塗りつぶしを実際の書き込みとし, 残りの描画時間はスリープで模擬する.
+            Timer frame;
+            pSurface->Clear( 0xFF000000u | ( uint32_t( uint64_t( i ) * 2654435761u ) & 0xFFFFFFu ) );
+            const double restMsec = renderMsec - frame.GetElapsedMsec();
+            if ( restMsec > 0.0 )
+            { std::this_thread::sleep_for( std::chrono::microseconds( int64_t( restMsec * 1000.0 ) ) ); }
+
+            swapChain.Present( index );
+        }
+        swapChain.WaitIdle();
+        const double sec = timer.GetElapsedSec();
+
+        const SoftwareSwapChain::Stats stats = swapChain.GetStats();
+        swapChain.Term();
+
+        std::printf( "%s, %u, %.1f, %.1f, %.1f, %llu, %llu, %.2f, %u, %.2f, %.2f, %.3f, %s\n",
+            MODE_NAMES[mode],
+            SWAP_BUFFERS[b],
+            renderMsec,
+            double( SWAP_FRAMES ) / sec,
+            double( stats.DisplayCount ) / sec,
+            (unsigned long long)stats.DropCount,
+            (unsigned long long)stats.RepeatCount,
+            double( stats.InFlightSum ) / double( SWAP_FRAMES ),
+            stats.MaxInFlight,
+            ( stats.DisplayCount > 0 ) ? Timer::ToMsec( stats.LatencyTicks ) / double( stats.DisplayCount ) : 0.0,
+            Timer::ToMsec( stats.MaxLatencyTicks ),
+            Timer::ToMsec( stats.BlockedTicks ) / double( SWAP_FRAMES ),
+            valid ? "yes" : "NO" );
+
+        if ( !valid || stats.DisplayCount + stats.DropCount != SWAP_FRAMES )
+        {
+            ELOG( "Error : Swap chain displayed a buffer in use or lost a frame." );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      4K 画像の画素フォーマット変換の速度 (読み書きの合計 GB/s) を, スカラー, SSE2, AVX2,
+//      スレッドプールによる行の並列化で比較します. SIMD 版と並列版はスカラー版と結果が一致する
+//      ことを確認し, 浮動小数を経由した往復変換の誤差も表示します.
+//-------------------------------------------------------------------------------------------------
+bool RunConvertBenchmark()
+{
+    const char* FORMAT_NAMES[PIXEL_FORMAT_COUNT] = {
+        "bgra8", "bgra8p", "rgba8", "rgba8p", "rgba16f", "rgba32f"
+    };
+    const char* LEVEL_NAMES[] = { "scalar", "sse2", "avx2" };
+
+    const SIMD_LEVEL maxLevel = GetSimdLevel();
+    const uint32_t   width    = CONVERT_WIDTH;
+    const uint32_t   height   = CONVERT_HEIGHT;
+    const size_t     pixels   = size_t( width ) * height;
+
+    // 呼び出し元のスレッドも ParallelFor() を手伝うので, プールには 1 つ少なく作る.
+    const uint32_t threads = std::max( std::thread::hardware_concurrency(), 1u );
+    ThreadPool pool;
+    if ( threads > 1 && !pool.Init( threads - 1 ) )
+    {
+        ELOG( "Error : ThreadPool::Init() Failed." );
+        return false;
+    }
+
+    // 乱数のストレートアルファ画像を元に, 各フォーマットの入力をスカラー版で作る.
+    std::vector<uint8_t> base( pixels * 4 );
+    uint32_t seed = 1;
+    for( size_t i = 0; i < base.size(); ++i )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        base[i] = uint8_t( seed >> 24 );
+    }
+
+    std::printf( "Convert : %ux%u, SIMD level %s, %u threads, best of %u\n",
+        width, height, LEVEL_NAMES[maxLevel], threads, CONVERT_REPEAT );
+    std::printf( "conversion, scalar GB/s, sse2 GB/s, avx2 GB/s, threaded GB/s, identical\n" );
+
+    bool result = true;
+    for( size_t p = 0; p < sizeof(CONVERT_PAIRS) / sizeof(CONVERT_PAIRS[0]); ++p )
+    {
+        const PIXEL_FORMAT srcFormat = CONVERT_PAIRS[p][0];
+        const PIXEL_FORMAT dstFormat = CONVERT_PAIRS[p][1];
+        const uint32_t srcPitch = width * GetPixelFormatSize( srcFormat );
+        const uint32_t dstPitch = width * GetPixelFormatSize( dstFormat );
+
+        std::vector<uint8_t> src( size_t( srcPitch ) * height );
+        std::vector<uint8_t> dst( size_t( dstPitch ) * height );
+        std::vector<uint8_t> reference( dst.size() );
+        ConvertPixels( base.data(), width * 4, PIXEL_FORMAT_B8G8R8A8, src.data(), srcPitch, srcFormat, width, height, nullptr, SIMD_LEVEL_SCALAR );
+
+        const double bytes = double( src.size() + dst.size() );
+        double gbps[4] = { 0.0, 0.0, 0.0, 0.0 };
+        bool   identical = true;
+
+        // 0～2 は各 SIMD レベルの単一スレッド, 3 は最大レベルの並列版.
+        for( uint32_t run = 0; run < 4; ++run )
+        {
+            if ( run <= SIMD_LEVEL_AVX2 && run > uint32_t( maxLevel ) )
+            { continue; }
+
+            const SIMD_LEVEL level = ( run == 3 ) ? maxLevel : SIMD_LEVEL( run );
+            ThreadPool*      pPool = ( run == 3 && threads > 1 ) ? &pool : nullptr;
+
+            double bestMsec = 0.0;
+            for( uint32_t i = 0; i < CONVERT_REPEAT; ++i )
+            {
+                Timer timer;
+                ConvertPixels( src.data(), srcPitch, srcFormat, dst.data(), dstPitch, dstFormat, width, height, pPool, level );
+                const double msec = timer.GetElapsedMsec();
+                bestMsec = ( i == 0 || msec < bestMsec ) ? msec : bestMsec;
+            }
+            gbps[run] = bytes / ( bestMsec * 1.0e6 );
+
+            if ( run == 0 )
+            { reference.swap( dst ); }
+            else if ( memcmp( dst.data(), reference.data(), dst.size() ) != 0 )
+            { identical = false; }
+        }
+
+        char name[64];
+        std::snprintf( name, sizeof(name), "%s -> %s", FORMAT_NAMES[srcFormat], FORMAT_NAMES[dstFormat] );
+        std::printf( "%-20s, %.2f, %.2f, %.2f, %.2f, %s\n",
+            name, gbps[0], gbps[1], gbps[2], gbps[3], identical ? "yes" : "NO" );
+
+        if ( !identical )
+        {
+            ELOG( "Error : SIMD conversion differs from scalar conversion." );
+            result = false;
+        }
+    }
+
+    // 乗算済み 8bit から浮動小数を経由して戻した際の誤差.
+    for( uint32_t f = PIXEL_FORMAT_R16G16B16A16_FLOAT; f <= PIXEL_FORMAT_R32G32B32A32_FLOAT; ++f )
+    {
+        const PIXEL_FORMAT format = PIXEL_FORMAT( f );
+        const uint32_t     pitch  = width * GetPixelFormatSize( format );
+
+        std::vector<uint8_t> premul( pixels * 4 );
+        std::vector<uint8_t> linear( size_t( pitch ) * height );
+        std::vector<uint8_t> back  ( pixels * 4 );
+        ConvertPixels( base.data(),   width * 4, PIXEL_FORMAT_B8G8R8A8,        premul.data(), width * 4, PIXEL_FORMAT_B8G8R8A8_PREMUL, width, height, &pool );
+        ConvertPixels( premul.data(), width * 4, PIXEL_FORMAT_B8G8R8A8_PREMUL, linear.data(), pitch,     format,                       width, height, &pool );
+        ConvertPixels( linear.data(), pitch,     format,                       back.data(),   width * 4, PIXEL_FORMAT_B8G8R8A8_PREMUL, width, height, &pool );
+
+        int maxDiff = 0;
+        for( size_t i = 0; i < premul.size(); ++i )
+        { maxDiff = std::max( maxDiff, std::abs( int( premul[i] ) - int( back[i] ) ) ); }
+
+        std::printf( "round trip bgra8p -> %s -> bgra8p : max channel diff %d\n", FORMAT_NAMES[format], maxDiff );
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      チャンネルごとの差の絶対値の平均を求めます.
+//-------------------------------------------------------------------------------------------------
+double GetMeanChannelDiff( const Surface& a, const Surface& b )
+{
+    uint64_t sum = 0;
+    for( uint32_t y = 0; y < a.GetHeight(); ++y )
+    {
+        const uint32_t* pA = a.GetRow( y );
+        const uint32_t* pB = b.GetRow( y );
+        for( uint32_t x = 0; x < a.GetWidth(); ++x )
+        {
+            for( uint32_t shift = 0; shift < 32; shift += 8 )
+            {
+                const int ca = int( ( pA[x] >> shift ) & 0xff );
+                const int cb = int( ( pB[x] >> shift ) & 0xff );
+                sum += uint64_t( ( ca > cb ) ? ca - cb : cb - ca );
+            }
+        }
+    }
+    return double( sum ) / ( double( a.GetWidth() ) * a.GetHeight() * 4.0 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      アンチエイリアス比較用のシーンを生成します. App の頂点カラーの三角形に, 星形, 半透明の円,
+//      細い線を重ねます. 座標はピクセル単位です.
+//-------------------------------------------------------------------------------------------------
+void BuildAntialiasScene( uint32_t width, uint32_t height, std::vector<MeshVertex>& vertices )
+{
+    vertices.clear();
+
+    // App::InitD3D() と同じ三角形を正規化デバイス座標からピクセルへ変換する.
+    const float triangle[3][2] = { { -0.3f, -0.5f }, { 0.0f, 0.5f }, { 0.3f, -0.5f } };
+    for( uint32_t i = 0; i < 3; ++i )
+    {
+        MeshVertex v = {};
+        v.Position[0] = ( triangle[i][0] * 0.5f + 0.5f ) * float( width );
+        v.Position[1] = ( 0.5f - triangle[i][1] * 0.5f ) * float( height );
+        v.Color[i]    = 1.0f;
+        v.Color[3]    = 1.0f;
+        vertices.push_back( v );
+    }
+
+    Tessellator tessellator;
+    uint32_t seed = 5;
+    for( uint32_t i = 0; i < MSAA_SHAPES; ++i )
+    {
+        float r[6];
+        for( uint32_t j = 0; j < 6; ++j )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            r[j] = float( seed >> 8 ) / float( 1 << 24 );
+        }
+
+        const float cx    = r[0] * float( width );
+        const float cy    = r[1] * float( height );
+        const float size  = 8.0f + r[2] * 48.0f;
+        const float color[4] = { r[3], r[4], r[5], ( i % 3 == 1 ) ? 0.5f : 1.0f };
+
+        Path path;
+        switch( i % 3 )
+        {
+        case 0:
+            {
+                // 星形.
+                for( uint32_t k = 0; k < 10; ++k )
+                {
+                    const float angle  = r[5] * 6.2831853f + float( k ) * 0.62831853f;
+                    const float radius = ( k & 1 ) ? size * 0.4f : size;
+                    const float px = cx + radius * cosf( angle );
+                    const float py = cy + radius * sinf( angle );
+                    if ( k == 0 ) { path.MoveTo( px, py ); } else { path.LineTo( px, py ); }
+                }
+                path.Close();
+                tessellator.Fill( path, FILL_RULE_NONZERO, 1.0f, color, vertices );
+            }
+            break;
+
+        case 1:
+            {
+                // 半透明の円.
+                const float k = size * 0.5522847f;
+                path.MoveTo ( cx + size, cy );
+                path.CubicTo( cx + size, cy + k, cx + k, cy + size, cx, cy + size );
+                path.CubicTo( cx - k, cy + size, cx - size, cy + k, cx - size, cy );
+                path.CubicTo( cx - size, cy - k, cx - k, cy - size, cx, cy - size );
+                path.CubicTo( cx + k, cy - size, cx + size, cy - k, cx + size, cy );
+                path.Close();
+                tessellator.Fill( path, FILL_RULE_NONZERO, 1.0f, color, vertices );
+            }
+            break;
+
+        default:
+            {
+                // 細い線.
+                const StrokeStyle style = { 0.75f + r[2] * 1.75f, LINE_JOIN_MITER, LINE_CAP_BUTT, 4.0f };
+                path.MoveTo( cx, cy );
+                path.LineTo( cx + ( r[3] - 0.5f ) * 400.0f, cy + ( r[4] - 0.5f ) * 400.0f );
+                tessellator.Stroke( path, style, 1.0f, color, vertices );
+            }
+            break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ソフトウェアラスタライザのアンチエイリアスを比較します. カバレッジマスクの MSAA 4x/8x と
+//      4x SSAA について, 描画と解決の時間, シェーディング回数, 圧縮画素の割合, メモリ量, および
+//      8x8 のスーパーサンプリングを基準とした誤差を表示します. 解決の SIMD 版とスカラー版が
+//      一致することも確認します.
+//-------------------------------------------------------------------------------------------------
+bool RunMsaaBenchmark()
+{
+    const char* MODE_NAMES[AA_MODE_COUNT] = { "none", "msaa4x", "msaa8x", "ssaa4x" };
+    const uint32_t width  = MSAA_WIDTH;
+    const uint32_t height = MSAA_HEIGHT;
+
+    std::vector<MeshVertex> vertices;
+    BuildAntialiasScene( width, height, vertices );
+
+    // 基準画像は縦横 MSAA_REFERENCE 倍で描画して箱型フィルタで縮小する.
+    Surface reference;
+    Surface target;
+    Surface scalar;
+    if ( !reference.Init( width, height ) || !target.Init( width, height ) || !scalar.Init( width, height ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+
+    {
+        const uint32_t n = MSAA_REFERENCE;
+        std::vector<MeshVertex> scaled( vertices );
+        for( size_t i = 0; i < scaled.size(); ++i )
+        {
+            scaled[i].Position[0] *= float( n );
+            scaled[i].Position[1] *= float( n );
+        }
+
+        TriangleRasterizer rasterizer;
+        Surface            large;
+        if ( !rasterizer.Init( width * n, height * n, AA_MODE_NONE ) || !large.Init( width * n, height * n ) )
+        {
+            ELOG( "Error : Reference Init Failed." );
+            return false;
+        }
+        rasterizer.Clear( MSAA_BACKGROUND );
+        rasterizer.DrawTriangles( scaled.data(), scaled.size() );
+        rasterizer.Resolve( large );
+
+        for( uint32_t y = 0; y < height; ++y )
+        {
+            uint32_t* pDst = reference.GetRow( y );
+            for( uint32_t x = 0; x < width; ++x )
+            {
+                uint32_t sum[4] = { 0, 0, 0, 0 };
+                for( uint32_t j = 0; j < n; ++j )
+                {
+                    const uint32_t* pSrc = large.GetRow( y * n + j ) + x * n;
+                    for( uint32_t i = 0; i < n; ++i )
+                    for( uint32_t c = 0; c < 4; ++c )
+                    { sum[c] += ( pSrc[i] >> ( c * 8 ) ) & 0xFF; }
+                }
+
+                uint32_t result = 0;
+                for( uint32_t c = 0; c < 4; ++c )
+                { result |= ( ( sum[c] + n * n / 2 ) / ( n * n ) ) << ( c * 8 ); }
+                pDst[x] = result;
+            }
+        }
+    }
+
+    std::printf( "Antialias : %ux%u, %u triangles, %u frames, reference %ux%u supersampled\n",
+        width, height, uint32_t( vertices.size() / 3 ), MSAA_FRAMES, MSAA_REFERENCE, MSAA_REFERENCE );
+    std::printf( "mode, raster ms, resolve ms, scalar resolve ms, shaded/frame, sample writes/frame, partial px, decompressions, compressed %%, memory MiB, mean error, max error, identical\n" );
+
+    bool result = true;
+    for( uint32_t mode = 0; mode < AA_MODE_COUNT; ++mode )
+    {
+        TriangleRasterizer rasterizer;
+        if ( !rasterizer.Init( width, height, AA_MODE( mode ) ) )
+        {
+            ELOG( "Error : TriangleRasterizer::Init() Failed." );
+            return false;
+        }
+
+        Timer  timer;
+        double rasterMsec  = 0.0;
+        double resolveMsec = 0.0;
+        double scalarMsec  = 0.0;
+        for( uint32_t frame = 0; frame < MSAA_FRAMES; ++frame )
+        {
+            timer.Reset();
+            rasterizer.Clear( MSAA_BACKGROUND );
+            rasterizer.DrawTriangles( vertices.data(), vertices.size() );
+            rasterMsec += timer.GetElapsedMsec();
+
+            timer.Reset();
+            rasterizer.Resolve( target );
+            resolveMsec += timer.GetElapsedMsec();
+
+            timer.Reset();
+            rasterizer.ResolveScalar( scalar );
+            scalarMsec += timer.GetElapsedMsec();
+        }
+
+        const TriangleRasterizer::Stats stats = rasterizer.GetStats();
+        const bool identical = ( GetMaxChannelDiff( target, scalar ) == 0 );
+
+        std::printf( "%s, %.2f, %.3f, %.3f, %.0f, %.0f, %.0f, %.0f, %.1f, %.1f, %.3f, %u, %s\n",
+            MODE_NAMES[mode],
+            rasterMsec  / MSAA_FRAMES,
+            resolveMsec / MSAA_FRAMES,
+            scalarMsec  / MSAA_FRAMES,
+            double( stats.ShadedCount )      / MSAA_FRAMES,
+            double( stats.SampleWriteCount ) / MSAA_FRAMES,
+            double( stats.PartialCount )     / MSAA_FRAMES,
+            double( stats.DecompressCount )  / MSAA_FRAMES,
+            rasterizer.GetCompressedRatio() * 100.0,
+            double( rasterizer.GetMemoryUsage() ) / ( 1024.0 * 1024.0 ),
+            GetMeanChannelDiff( target, reference ),
+            GetMaxChannelDiff( target, reference ),
+            identical ? "yes" : "NO" );
+
+        if ( !identical )
+        {
+            ELOG( "Error : SIMD resolve differs from scalar resolve." );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      App::Init() と同じ依存関係を持つスタブの初期化タスクを, 直列に実行した場合と
+//      初期化グラフでスレッドプールに分散した場合とで最初のフレームまでの時間を比較します.
+//      スタブは待ち時間だけを模擬するので, ウィンドウやデバイスの無い環境でも計測できます.
+//-------------------------------------------------------------------------------------------------
+bool RunInitBenchmark()
+{
+    const uint32_t count = uint32_t( sizeof(INIT_STUBS) / sizeof(INIT_STUBS[0]) );
+
+    double serialMsec = 0.0;
+    for( uint32_t i = 0; i < count; ++i )
+    { serialMsec += INIT_STUBS[i].Msec; }
+
+    std::printf( "Init : %u stub tasks, %.1f ms of work, first frame %.1f ms, %u runs\n",
+        count, serialMsec, INIT_FRAME_MSEC, INIT_REPEAT );
+    std::printf( "mode, threads, init ms avg, init ms min, first frame ms avg, first frame ms min, speedup\n" );
+
+    InitGraph graph;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const double msec = INIT_STUBS[i].Msec;
+        graph.AddTask( INIT_STUBS[i].Name, [msec]()
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( int64_t( msec * 1000.0 ) ) );
+            return true;
+        }, INIT_STUBS[i].MainThread );
+
+        for( uint32_t j = 0; INIT_STUBS[i].Dependencies[j] >= 0; ++j )
+        { graph.AddDependency( i, uint32_t( INIT_STUBS[i].Dependencies[j] ) ); }
+    }
+
+    // 0 番目は直列実行で, 以降はスレッド数を変えてグラフで実行する.
+    const uint32_t modeCount = 1 + uint32_t( sizeof(INIT_THREADS) / sizeof(INIT_THREADS[0]) );
+    double baseMsec = 0.0;
+    for( uint32_t mode = 0; mode < modeCount; ++mode )
+    {
+        const uint32_t threads = ( mode == 0 ) ? 0 : INIT_THREADS[mode - 1];
+
+        ThreadPool pool;
+        if ( threads > 0 && !pool.Init( threads ) )
+        {
+            ELOG( "Error : ThreadPool::Init() Failed." );
+            return false;
+        }
+
+        double initSum  = 0.0;
+        double initMin  = 0.0;
+        double frameSum = 0.0;
+        double frameMin = 0.0;
+        for( uint32_t r = 0; r < INIT_REPEAT; ++r )
+        {
+            Timer timer;
+            if ( !graph.Run( ( threads > 0 ) ? &pool : nullptr ) )
+            {
+                ELOG( "Error : InitGraph::Run() Failed." );
+                return false;
+            }
+            const double initMsec = timer.GetElapsedMsec();
+
+            // 最初のフレームは全ての初期化の完了後にメインスレッドで描画する.
+            std::this_thread::sleep_for( std::chrono::microseconds( int64_t( INIT_FRAME_MSEC * 1000.0 ) ) );
+            const double frameMsec = timer.GetElapsedMsec();
+
+            initSum  += initMsec;
+            frameSum += frameMsec;
+            initMin   = ( r == 0 || initMsec  < initMin  ) ? initMsec  : initMin;
+            frameMin  = ( r == 0 || frameMsec < frameMin ) ? frameMsec : frameMin;
+        }
+
+        const double frameAvg = frameSum / double( INIT_REPEAT );
+        if ( mode == 0 )
+        { baseMsec = frameAvg; }
+
+        std::printf( "%s, %u, %.2f, %.2f, %.2f, %.2f, %.2fx\n",
+            ( mode == 0 ) ? "serial" : "graph",
+            threads,
+            initSum / double( INIT_REPEAT ),
+            initMin,
+            frameAvg,
+            frameMin,
+            baseMsec / frameAvg );
+
+        pool.Term();
+    }
+
+    // 最後に実行したグラフのタイムラインとクリティカルパスを表示する.
+    std::printf( "\n" );
+    graph.PrintTimeline();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      App::OnResize() と DrawLogView() が作り直すリソースのスタブです.
+//      GPU リソースは一意なハンドル値で代用し, CPU サーフェイスは実際に確保します.
+//-------------------------------------------------------------------------------------------------
+struct ResizeStub
+{
+    uintptr_t       NextHandle;         //!< 次に発行するハンドル値です.
+    const void*     pSwapChain;         //!< スワップチェインです (作り直さずにサイズだけ変わります).
+    const void*     pView;              //!< レンダーターゲットビューです.
+    const void*     pDepth;             //!< 深度ステンシルビューです.
+    const void*     pTarget;            //!< バックバッファを共有する D2D ビットマップです.
+    const void*     pLogBitmap;         //!< ログ表示の転送先ビットマップです.
+    Surface         LogSurface;         //!< ログ表示の描画先です.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      スタブを未生成の状態にします.
+//-------------------------------------------------------------------------------------------------
+void ResetResizeStub( ResizeStub& stub )
+{
+    stub.NextHandle = 0x1000;
+    stub.pSwapChain = nullptr;
+    stub.pView      = nullptr;
+    stub.pDepth     = nullptr;
+    stub.pTarget    = nullptr;
+    stub.pLogBitmap = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スタブのハンドルを発行します.
+//-------------------------------------------------------------------------------------------------
+const void* NewStubHandle( ResizeStub& stub )
+{ return reinterpret_cast<const void*>( stub.NextHandle++ ); }
+
+//-------------------------------------------------------------------------------------------------
+//      App::OnResize() と同じ順にリソースを解放して作り直し, トラッカーに登録します.
+//      leakDepth が true の場合は深度バッファの登録解除を忘れる不具合を再現します.
+//-------------------------------------------------------------------------------------------------
+bool ResizeStubResources( ResourceTracker& tracker, ResizeStub& stub, uint32_t width, uint32_t height, bool leakDepth )
+{
+    const uint64_t pixels = uint64_t( width ) * height;
+
+    tracker.Untrack( stub.pView );
+    if ( !leakDepth )
+    { tracker.Untrack( stub.pDepth ); }
+    tracker.Untrack( stub.pTarget );
+
+    if ( stub.pSwapChain == nullptr )
+    { stub.pSwapChain = NewStubHandle( stub ); }
+    else
+    { tracker.Untrack( stub.pSwapChain ); }
+
+    stub.pView   = NewStubHandle( stub );
+    stub.pDepth  = NewStubHandle( stub );
+    stub.pTarget = NewStubHandle( stub );
+    tracker.Track( stub.pSwapChain, RESOURCE_CATEGORY_SWAP_CHAIN,    pixels * 4 * MEMORY_BUFFERS );
+    tracker.Track( stub.pView,      RESOURCE_CATEGORY_VIEW,          0 );
+    tracker.Track( stub.pDepth,     RESOURCE_CATEGORY_DEPTH_STENCIL, pixels * 4 );
+    tracker.Track( stub.pTarget,    RESOURCE_CATEGORY_D2D_BITMAP,    0 );
+
+    // ログ表示は次の描画でサイズの変化に気付いて作り直す.
+    tracker.Untrack( stub.pLogBitmap );
+    tracker.Untrack( stub.LogSurface.GetPixels() );
+    if ( !stub.LogSurface.Init( width, height ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return false;
+    }
+    stub.pLogBitmap = NewStubHandle( stub );
+    tracker.Track( stub.pLogBitmap, RESOURCE_CATEGORY_D2D_BITMAP, pixels * 4 );
+    tracker.Track( stub.LogSurface.GetPixels(), RESOURCE_CATEGORY_SURFACE, uint64_t( stub.LogSurface.GetPitch() ) * height );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ウィンドウのリサイズで作り直すリソースをトラッカーで計上しながら 10k 回リサイズし,
+//      メモリが増えないことを確認します. 登録解除を忘れた場合に増加を検出できることと,
+//      予算を超えたときにキャッシュの削減が呼ばれて予算内に収まることも確認します.
+//-------------------------------------------------------------------------------------------------
+bool RunMemoryBenchmark()
+{
+    const uint32_t sizeCount = uint32_t( sizeof(MEMORY_SIZES) / sizeof(MEMORY_SIZES[0]) );
+    const double   MiB       = 1024.0 * 1024.0;
+
+    std::printf( "Memory : %u resize cycles over %u window sizes, %u back buffers\n", MEMORY_CYCLES, sizeCount, MEMORY_BUFFERS );
+    std::printf( "case, cycles, start MiB, end MiB, peak MiB, resources, max churn MiB/frame, ns/resize, growth, result\n" );
+
+    bool result = true;
+    for( uint32_t leak = 0; leak < 2; ++leak )
+    {
+        ResourceTracker tracker;
+        ResizeStub      stub;
+        ResetResizeStub( stub );
+
+        // 最初のサイズで作ってから計測を始める.
+        if ( !ResizeStubResources( tracker, stub, MEMORY_SIZES[0][0], MEMORY_SIZES[0][1], false ) )
+        { return false; }
+        tracker.EndFrame();
+        const ResourceTracker::Snapshot before = tracker.GetSnapshot();
+
+        Timer timer;
+        for( uint32_t i = 1; i <= MEMORY_CYCLES; ++i )
+        {
+            const uint32_t* size = MEMORY_SIZES[i % sizeCount];
+            if ( !ResizeStubResources( tracker, stub, size[0], size[1], leak != 0 ) )
+            { return false; }
+            tracker.EndFrame();
+        }
+        const double nsec = timer.GetElapsedMsec() * 1000000.0 / double( MEMORY_CYCLES );
+
+        // 元のサイズに戻して比較する.
+        if ( !ResizeStubResources( tracker, stub, MEMORY_SIZES[0][0], MEMORY_SIZES[0][1], leak != 0 ) )
+        { return false; }
+        tracker.EndFrame();
+        const ResourceTracker::Snapshot after = tracker.GetSnapshot();
+
+        const bool grew     = ( after.Total.Bytes != before.Total.Bytes || after.Total.Count != before.Total.Count );
+        const bool expected = ( grew == ( leak != 0 ) );
+        std::printf( "%s, %u, %.2f, %.2f, %.2f, %u, %.2f, %.1f, %s, %s\n",
+            ( leak != 0 ) ? "leak depth (control)" : "balanced",
+            MEMORY_CYCLES,
+            double( before.Total.Bytes ) / MiB,
+            double( after.Total.Bytes ) / MiB,
+            double( after.Total.PeakBytes ) / MiB,
+            after.Total.Count,
+            double( after.MaxFrameChurnBytes ) / MiB,
+            nsec,
+            grew ? "yes" : "no",
+            expected ? "ok" : "NG" );
+
+        if ( !expected )
+        {
+            ELOG( "Error : Unexpected memory growth result. leak = %u", leak );
+            result = false;
+        }
+    }
+
+    // 予算: キャッシュを毎フレーム増やし, 超過分を古いものから削減させる.
+    {
+        ResourceTracker tracker;
+        ResizeStub      stub;
+        ResetResizeStub( stub );
+        if ( !ResizeStubResources( tracker, stub, MEMORY_SIZES[1][0], MEMORY_SIZES[1][1], false ) )
+        { return false; }
+
+        const uint64_t budget = tracker.GetSnapshot().Total.Bytes + MEMORY_CACHE_BUDGET;
+        std::deque<const void*> cache;
+        tracker.SetBudget( budget, [&]( uint64_t excessBytes )
+        {
+            uint64_t freed = 0;
+            while( freed < excessBytes && !cache.empty() )
+            {
+                tracker.Untrack( cache.front() );
+                cache.pop_front();
+                freed += MEMORY_MESH_BYTES;
+            }
+        });
+
+        uint64_t maxAfterTrim = 0;
+        for( uint32_t i = 0; i < MEMORY_CYCLES; ++i )
+        {
+            cache.push_back( NewStubHandle( stub ) );
+            tracker.Track( cache.back(), RESOURCE_CATEGORY_VERTEX_BUFFER, MEMORY_MESH_BYTES );
+            tracker.EndFrame();
+
+            const uint64_t bytes = tracker.GetSnapshot().Total.Bytes;
+            if ( bytes > maxAfterTrim )
+            { maxAfterTrim = bytes; }
+        }
+
+        const ResourceTracker::Snapshot snapshot = tracker.GetSnapshot();
+        const bool withinBudget = ( maxAfterTrim <= budget && snapshot.TrimCount > 0 );
+        std::printf( "budget, %u frames, budget %.2f MiB, peak %.2f MiB, max after trim %.2f MiB, %llu trims, %u cached, %s\n",
+            MEMORY_CYCLES,
+            double( budget ) / MiB,
+            double( snapshot.Total.PeakBytes ) / MiB,
+            double( maxAfterTrim ) / MiB,
+            (unsigned long long)snapshot.TrimCount,
+            uint32_t( cache.size() ),
+            withinBudget ? "ok" : "NG" );
+
+        if ( !withinBudget )
+        {
+            ELOG( "Error : Cache trimming did not keep usage within budget." );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画スレッドを模したメッセージを書き込み, LOGGER_BATCH 件ごとの所要時間を記録します.
+//      pLogger が nullptr の場合は ELOG() の従来の実装と同じく fprintf() で直接書き込みます.
+//-------------------------------------------------------------------------------------------------
+void WriteFrameLogs( Logger* pLogger, FILE* pFile, const char* format, uint32_t first, uint32_t count, uint32_t pauseUsec, std::vector<int64_t>& batches )
+{
+    for( uint32_t i = 0; i < count; i += LOGGER_BATCH )
+    {
+        const uint32_t end   = ( i + LOGGER_BATCH < count ) ? i + LOGGER_BATCH : count;
+        const int64_t  begin = Timer::GetTicks();
+
+        for( uint32_t j = i; j < end; ++j )
+        {
+            const uint32_t frame = first + j;
+            const double   msec  = double( frame % 1000 ) * 0.0167;
+            const int      draws = int( frame % 977 );
+            const char*    pass  = LOGGER_PASSES[frame % 4];
+
+            if ( pLogger != nullptr )
+            { pLogger->Write( &LOGGER_SITE, frame, msec, draws, pass ); }
+            else
+            { std::fprintf( pFile, format, LOGGER_SITE.File, LOGGER_SITE.Line, frame, msec, draws, pass ); }
+        }
+
+        batches.push_back( Timer::GetTicks() - begin );
+
+        if ( pauseUsec > 0 )
+        { std::this_thread::sleep_for( std::chrono::microseconds( pauseUsec ) ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      一時ファイルの内容を読み込みます.
+//-------------------------------------------------------------------------------------------------
+void ReadTempFile( FILE* pFile, std::vector<char>& data )
+{
+    fflush( pFile );
+    const long size = ftell( pFile );
+    data.resize( ( size > 0 ) ? size_t( size ) : 0 );
+    rewind( pFile );
+    if ( !data.empty() )
+    { data.resize( fread( &data[0], 1, data.size(), pFile ) ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      非同期ロガーと fprintf() の書き込み 1 件あたりの呼び出し元の時間を比較します.
+//      先に少量のメッセージで出力内容が fprintf() と一致することを確認します.
+//-------------------------------------------------------------------------------------------------
+bool RunLoggerBenchmark()
+{
+    char format[256];
+    std::snprintf( format, sizeof(format), "[File: %%s, Line: %%d] %s\n", LOGGER_SITE.Format );
+
+    // 出力内容の確認.
+    {
+        FILE* pDirect = tmpfile();
+        FILE* pAsync  = tmpfile();
+        if ( pDirect == nullptr || pAsync == nullptr )
+        {
+            ELOG( "Error : tmpfile() Failed." );
+            if ( pDirect != nullptr ) { fclose( pDirect ); }
+            if ( pAsync  != nullptr ) { fclose( pAsync );  }
+            return false;
+        }
+
+        std::vector<int64_t> batches;
+        WriteFrameLogs( nullptr, pDirect, format, 0, LOGGER_VERIFY, 0, batches );
+
+        Logger logger;
+        logger.Init( pAsync, LOGGER_BUFFER );
+        WriteFrameLogs( &logger, nullptr, format, 0, LOGGER_VERIFY, 0, batches );
+        logger.Flush();
+        const Logger::Stats stats = logger.GetStats();
+        logger.Term();
+
+        std::vector<char> direct;
+        std::vector<char> async;
+        ReadTempFile( pDirect, direct );
+        ReadTempFile( pAsync,  async );
+        fclose( pDirect );
+        fclose( pAsync );
+
+        const bool match = ( stats.DropCount == 0 && direct == async );
+        std::printf( "Logger : %u messages, output %s fprintf (%u bytes), %llu dropped\n",
+            LOGGER_VERIFY, match ? "matches" : "DIFFERS from", uint32_t( direct.size() ), (unsigned long long)stats.DropCount );
+        if ( !match )
+        {
+            ELOG( "Error : Logger output does not match fprintf()." );
+            return false;
+        }
+    }
+
+    std::printf( "Logger : %u messages per run, %u KiB ring per thread\n", LOGGER_MESSAGES, LOGGER_BUFFER / 1024 );
+    std::printf( "mode, threads, ns/call avg, ns/call p99, total ms, written, dropped\n" );
+
+    // 0 : fprintf(), 1 : 非同期で連続書き込み, 2 : 非同期で LOGGER_BATCH 件ごとに間隔を空ける.
+    static const char* modeNames[] = { "fprintf", "async burst", "async paced" };
+    const uint32_t threadCases = uint32_t( sizeof(LOGGER_THREADS) / sizeof(LOGGER_THREADS[0]) );
+    for( uint32_t mode = 0; mode < 3; ++mode )
+    {
+        for( uint32_t t = 0; t < threadCases; ++t )
+        {
+            const uint32_t threadCount = LOGGER_THREADS[t];
+            const uint32_t perThread   = LOGGER_MESSAGES / threadCount;
+            const uint32_t pauseUsec   = ( mode == 2 ) ? LOGGER_PAUSE_USEC : 0;
+
+            FILE* pFile = tmpfile();
+            if ( pFile == nullptr )
+            {
+                ELOG( "Error : tmpfile() Failed." );
+                return false;
+            }
+
+            Logger logger;
+            Logger* pLogger = nullptr;
+            if ( mode > 0 )
+            {
+                logger.Init( pFile, LOGGER_BUFFER );
+                pLogger = &logger;
+            }
+
+            std::vector<std::vector<int64_t>> batches( threadCount );
+            std::vector<std::thread> threads;
+
+            Timer timer;
+            for( uint32_t i = 0; i < threadCount; ++i )
+            {
+                threads.push_back( std::thread( [&, i]()
+                { WriteFrameLogs( pLogger, pFile, format, i * perThread, perThread, pauseUsec, batches[i] ); } ) );
+            }
+            for( size_t i = 0; i < threads.size(); ++i )
+            { threads[i].join(); }
+
+            // 非同期の場合はバックグラウンドスレッドが書き終えるまでを含める.
+            if ( pLogger != nullptr )
+            { pLogger->Flush(); }
+            else
+            { fflush( pFile ); }
+            const double totalMsec = timer.GetElapsedMsec();
+
+            Logger::Stats stats;
+            memset( &stats, 0, sizeof(stats) );
+            if ( pLogger != nullptr )
+            {
+                stats = pLogger->GetStats();
+                pLogger->Term();
+            }
+            else
+            { stats.WriteCount = uint64_t( perThread ) * threadCount; }
+            fclose( pFile );
+
+            std::vector<int64_t> all;
+            for( uint32_t i = 0; i < threadCount; ++i )
+            { all.insert( all.end(), batches[i].begin(), batches[i].end() ); }
+            std::sort( all.begin(), all.end() );
+
+            int64_t sum = 0;
+            for( size_t i = 0; i < all.size(); ++i )
+            { sum += all[i]; }
+
+            const double calls = double( perThread ) * double( threadCount );
+            const double avg   = Timer::ToNsec( sum ) / calls;
+            const double p99   = Timer::ToNsec( all[ ( all.size() * 99 ) / 100 ] ) / double( LOGGER_BATCH );
+
+            std::printf( "%s, %u, %.1f, %.1f, %.2f, %llu, %llu\n",
+                modeNames[mode],
+                threadCount,
+                avg,
+                p99,
+                totalMsec,
+                (unsigned long long)stats.WriteCount,
+                (unsigned long long)stats.DropCount );
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      オフスクリーンパスを多数持つフレームをレンダーグラフに登録します.
+//      追加順はわざと一時リソースの生存期間が長くなる順にしており, 並べ替えで短くなります.
+//      debug normals パスの出力はどこからも読まれないため除かれます.
+//-------------------------------------------------------------------------------------------------
+void BuildGraphFrame( RenderGraph& graph, uint32_t width, uint32_t height, uint32_t& executed )
+{
+    // Format は DXGI_FORMAT の値.
+    const RenderTextureDesc rgba8   = { width,     height,     28, 4, 1 };    // R8G8B8A8_UNORM
+    const RenderTextureDesc rgba16f = { width,     height,     10, 8, 1 };    // R16G16B16A16_FLOAT
+    const RenderTextureDesc r16f    = { width,     height,     54, 2, 1 };    // R16_FLOAT
+    const RenderTextureDesc depth32 = { width,     height,     40, 4, 1 };    // D32_FLOAT
+    const RenderTextureDesc half16f = { width / 2, height / 2, 10, 8, 1 };
+    const RenderTextureDesc quart16f= { width / 4, height / 4, 10, 8, 1 };
+    const RenderTextureDesc half8   = { width / 2, height / 2, 28, 4, 1 };
+    const RenderTextureDesc shadow  = { GRAPH_SHADOW_SIZE, GRAPH_SHADOW_SIZE, 40, 4, 1 };
+    const RenderTextureDesc back    = { width,     height,     87, 4, 1 };    // B8G8R8A8_UNORM
+
+    const uint32_t backBuffer   = graph.ImportTexture( "back buffer", back, nullptr );
+    const uint32_t uiLayer      = graph.CreateTexture( "ui layer",     rgba8 );
+    const uint32_t shadowMap    = graph.CreateTexture( "shadow map",   shadow );
+    const uint32_t albedo       = graph.CreateTexture( "albedo",       rgba8 );
+    const uint32_t normal       = graph.CreateTexture( "normal",       rgba16f );
+    const uint32_t depth        = graph.CreateTexture( "depth",        depth32 );
+    const uint32_t ao           = graph.CreateTexture( "ao",           r16f );
+    const uint32_t aoBlur       = graph.CreateTexture( "ao blur",      r16f );
+    const uint32_t hdr          = graph.CreateTexture( "hdr",          rgba16f );
+    const uint32_t bloomHalf    = graph.CreateTexture( "bloom half",   half16f );
+    const uint32_t bloomQuarter = graph.CreateTexture( "bloom quarter",quart16f );
+    const uint32_t bloomUp      = graph.CreateTexture( "bloom up",     half16f );
+    const uint32_t ldr          = graph.CreateTexture( "ldr",          rgba8 );
+    const uint32_t blurH        = graph.CreateTexture( "backdrop h",   half8 );
+    const uint32_t blurV        = graph.CreateTexture( "backdrop v",   half8 );
+    const uint32_t debugView    = graph.CreateTexture( "debug view",   rgba8 );
+
+    const RenderGraph::PassFunc func = [&executed]( const RenderGraph& ) { executed++; };
+
+    uint32_t pass = graph.AddPass( "ui", func );
+    graph.Write( pass, uiLayer );
+
+    pass = graph.AddPass( "shadow", func );
+    graph.Write( pass, shadowMap );
+
+    pass = graph.AddPass( "gbuffer", func );
+    graph.Write( pass, albedo );
+    graph.Write( pass, normal );
+    graph.Write( pass, depth );
+
+    pass = graph.AddPass( "debug normals", func );
+    graph.Read ( pass, normal );
+    graph.Write( pass, debugView );
+
+    pass = graph.AddPass( "ssao", func );
+    graph.Read ( pass, normal );
+    graph.Read ( pass, depth );
+    graph.Write( pass, ao );
+
+    pass = graph.AddPass( "ssao blur", func );
+    graph.Read ( pass, ao );
+    graph.Write( pass, aoBlur );
+
+    pass = graph.AddPass( "lighting", func );
+    graph.Read ( pass, albedo );
+    graph.Read ( pass, normal );
+    graph.Read ( pass, depth );
+    graph.Read ( pass, aoBlur );
+    graph.Read ( pass, shadowMap );
+    graph.Write( pass, hdr );
+
+    pass = graph.AddPass( "bloom down", func );
+    graph.Read ( pass, hdr );
+    graph.Write( pass, bloomHalf );
+
+    pass = graph.AddPass( "bloom down 2", func );
+    graph.Read ( pass, bloomHalf );
+    graph.Write( pass, bloomQuarter );
+
+    pass = graph.AddPass( "bloom up", func );
+    graph.Read ( pass, bloomQuarter );
+    graph.Read ( pass, bloomHalf );
+    graph.Write( pass, bloomUp );
+
+    pass = graph.AddPass( "tonemap", func );
+    graph.Read ( pass, hdr );
+    graph.Read ( pass, bloomUp );
+    graph.Write( pass, ldr );
+
+    pass = graph.AddPass( "backdrop blur h", func );
+    graph.Read ( pass, ldr );
+    graph.Write( pass, blurH );
+
+    pass = graph.AddPass( "backdrop blur v", func );
+    graph.Read ( pass, blurH );
+    graph.Write( pass, blurV );
+
+    pass = graph.AddPass( "composite", func );
+    graph.Read ( pass, ldr );
+    graph.Read ( pass, uiLayer );
+    graph.Read ( pass, blurV );
+    graph.Write( pass, backBuffer );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      コンパイル結果を検証します. 依存するパスが先に実行されることと, 生存期間が重なる
+//      一時リソースが実テクスチャもヒープ内の範囲も共有しないことを確認します.
+//-------------------------------------------------------------------------------------------------
+bool ValidateGraph( const RenderGraph& graph )
+{
+    const uint32_t count = graph.GetResourceCount();
+    for( uint32_t a = 0; a < count; ++a )
+    {
+        const RenderGraph::ResourceInfo& ra = graph.GetResourceInfo( a );
+        if ( ra.Imported || ra.FirstPass > ra.LastPass )
+        { continue; }
+
+        for( uint32_t b = a + 1; b < count; ++b )
+        {
+            const RenderGraph::ResourceInfo& rb = graph.GetResourceInfo( b );
+            if ( rb.Imported || rb.FirstPass > rb.LastPass )
+            { continue; }
+
+            if ( ra.FirstPass > rb.LastPass || rb.FirstPass > ra.LastPass )
+            { continue; }
+
+            const bool sameSlot   = ( ra.Slot == rb.Slot );
+            const bool sameMemory = ( ra.HeapOffset < rb.HeapOffset + rb.Bytes ) && ( rb.HeapOffset < ra.HeapOffset + ra.Bytes );
+            if ( sameSlot || sameMemory )
+            {
+                ELOG( "Error : Aliased resources are alive at the same time. (%s, %s)", ra.Name, rb.Name );
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      多数のオフスクリーンパスを持つフレームをレンダーグラフで組み立て, 一時リソースの
+//      ピークメモリをエイリアス無し, 同じ記述の使い回し, ヒープ内配置で比較します.
+//-------------------------------------------------------------------------------------------------
+bool RunRenderGraphBenchmark()
+{
+    const uint32_t sizeCount = uint32_t( sizeof(GRAPH_SIZES) / sizeof(GRAPH_SIZES[0]) );
+    const double   MiB       = 1024.0 * 1024.0;
+
+    // 実テクスチャの生成と破棄を数える.
+    uint32_t  createCount  = 0;
+    uint32_t  destroyCount = 0;
+    uintptr_t nextHandle   = 0x1000;
+
+    RenderGraph graph;
+    graph.SetAllocator(
+        [&]( const RenderTextureDesc& ) -> void* { createCount++; nextHandle += 0x10; return reinterpret_cast<void*>( nextHandle ); },
+        [&]( void* ) { destroyCount++; } );
+
+    std::printf( "Render Graph : %u frames per size, transient memory in MiB\n", GRAPH_FRAMES );
+    std::printf( "size, passes, culled, transient, physical, unaliased, pooled, placed, lower bound, placed saving, compile us/frame, creates first/steady\n" );
+
+    bool result = true;
+    for( uint32_t s = 0; s < sizeCount; ++s )
+    {
+        const uint32_t width  = GRAPH_SIZES[s][0];
+        const uint32_t height = GRAPH_SIZES[s][1];
+
+        uint32_t executed     = 0;
+        uint32_t firstCreates = 0;
+        int64_t  compileTicks = 0;
+        for( uint32_t frame = 0; frame < GRAPH_FRAMES; ++frame )
+        {
+            const uint32_t before = createCount;
+            const int64_t  begin  = Timer::GetTicks();
+
+            graph.Reset();
+            BuildGraphFrame( graph, width, height, executed );
+            if ( !graph.Compile() )
+            {
+                ELOG( "Error : RenderGraph::Compile() Failed." );
+                return false;
+            }
+
+            compileTicks += Timer::GetTicks() - begin;
+            graph.Execute();
+
+            if ( frame == 0 )
+            {
+                firstCreates = createCount - before;
+                if ( !ValidateGraph( graph ) )
+                { result = false; }
+            }
+        }
+
+        const RenderGraph::Stats& stats = graph.GetStats();
+        const uint32_t steadyCreates = createCount - firstCreates;
+        createCount = 0;
+
+        const uint32_t liveCount = stats.PassCount - stats.CulledPassCount;
+        if ( executed != liveCount * GRAPH_FRAMES )
+        {
+            ELOG( "Error : Unexpected executed pass count. (%u != %u)", executed, liveCount * GRAPH_FRAMES );
+            result = false;
+        }
+
+        std::printf( "%ux%u, %u, %u, %u, %u, %.2f, %.2f, %.2f, %.2f, %.1f %%, %.2f, %u/%u\n",
+            width, height,
+            stats.PassCount,
+            stats.CulledPassCount,
+            stats.TransientCount,
+            stats.PhysicalCount,
+            double( stats.UnaliasedBytes  ) / MiB,
+            double( stats.PooledBytes     ) / MiB,
+            double( stats.PlacedBytes     ) / MiB,
+            double( stats.LowerBoundBytes ) / MiB,
+            100.0 * ( 1.0 - double( stats.PlacedBytes ) / double( stats.UnaliasedBytes ) ),
+            Timer::ToMsec( compileTicks ) * 1000.0 / double( GRAPH_FRAMES ),
+            firstCreates,
+            steadyCreates );
+    }
+
+    // 最後の解像度のスケジュールを表示.
+    std::printf( "\n" );
+    graph.PrintSchedule();
+
+    graph.Term();
+    std::printf( "physical textures destroyed on resize and term : %u\n", destroyCount );
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// StateDraw structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct StateDraw
+{
+    uint32_t    Pipeline;       //!< パイプライン番号です.
+    uint32_t    Texture;        //!< テクスチャ番号です.
+    uint32_t    Mesh;           //!< 頂点バッファ番号です.
+    uint32_t    VertexCount;    //!< 頂点数です.
+
+    bool operator < ( const StateDraw& value ) const
+    {
+        if ( Pipeline != value.Pipeline ) { return Pipeline < value.Pipeline; }
+        if ( Texture  != value.Texture  ) { return Texture  < value.Texture; }
+        return Mesh < value.Mesh;
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+//      ベンチマーク用の偽のハンドルを生成します. 種類ごとに異なる値になります.
+//-------------------------------------------------------------------------------------------------
+inline void* MakeStateHandle( uint32_t kind, uint32_t index )
+{ return reinterpret_cast<void*>( uintptr_t( ( kind + 1 ) << 16 ) + uintptr_t( index + 1 ) * 16 ); }
+
+//-------------------------------------------------------------------------------------------------
+//      1フレーム分の描画を StateCache に発行します. App::OnRenderD3D() と同じく,
+//      描画ごとにフレーム先頭のターゲットとパイプラインから全てのステートを設定し直します.
+//-------------------------------------------------------------------------------------------------
+void SubmitStateFrame( StateCache& cache, const std::vector<StateDraw>& draws )
+{
+    cache.SetRenderTargets( MakeStateHandle( 10, 0 ), MakeStateHandle( 11, 0 ) );
+    for( size_t i = 0; i < draws.size(); ++i )
+    {
+        const StateDraw& draw = draws[i];
+        cache.SetPipeline    ( draw.Pipeline );
+        cache.SetSampler     ( MakeStateHandle( 12, 0 ) );
+        cache.SetTexture     ( MakeStateHandle( 13, draw.Texture ) );
+        cache.SetVertexBuffer( MakeStateHandle( 14, draw.Mesh ), 32, 0 );
+        cache.Draw           ( draw.VertexCount, 0 );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      冗長なステート設定の除去を検証します. 多数の描画を持つシーンを StateCache の有効と
+//      無効で記録用のコンテキストに発行し, 発行された呼び出し数と描画時点のステートの
+//      チェックサムを比較します. デバイスを使わないのでどの環境でも実行できます.
+//-------------------------------------------------------------------------------------------------
+bool RunStateCacheBenchmark()
+{
+    RecordingRenderContext context;
+    StateCache cache;
+    if ( !cache.Init( &context ) )
+    {
+        ELOG( "Error : StateCache::Init() Failed." );
+        return false;
+    }
+
+    // パイプラインを作成. 2回目は全て既存のものが返るはず.
+    std::vector<uint32_t> pipelines;
+    for( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        pipelines.clear();
+        for( uint32_t v = 0; v < STATE_SHADERS; ++v )
+        for( uint32_t m = 0; m < STATE_MATERIALS; ++m )
+        for( uint32_t b = 0; b < STATE_BLENDS; ++b )
+        {
+            PipelineDesc desc = {};
+            desc.pInputLayout       = MakeStateHandle( 0, v );
+            desc.pVertexShader      = MakeStateHandle( 1, v );
+            desc.pPixelShader       = MakeStateHandle( 2, m );
+            desc.pBlendState        = ( b == 0 ) ? nullptr : MakeStateHandle( 3, b );
+            desc.pDepthStencilState = MakeStateHandle( 4, 0 );
+            desc.pRasterizerState   = nullptr;
+            desc.Topology           = 4;    // D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+            pipelines.push_back( cache.CreatePipeline( desc ) );
+        }
+    }
+
+    bool result = true;
+    if ( cache.GetPipelineCount() != pipelines.size() )
+    {
+        ELOG( "Error : Duplicate pipelines were created. (%u != %u)", cache.GetPipelineCount(), uint32_t( pipelines.size() ) );
+        result = false;
+    }
+
+    // シーンを生成. 同じ形状は同じテクスチャとシェーダを使いがちなように偏らせる.
+    std::vector<StateDraw> unsorted( STATE_DRAWS );
+    uint32_t seed = 12345;
+    for( uint32_t i = 0; i < STATE_DRAWS; ++i )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const uint32_t mesh = ( seed >> 8 ) % STATE_MESHES;
+        seed = seed * 1664525u + 1013904223u;
+
+        StateDraw& draw = unsorted[i];
+        draw.Mesh        = mesh;
+        draw.Pipeline    = pipelines[ ( mesh * 7 + ( ( seed >> 24 ) & 1 ) ) % pipelines.size() ];
+        draw.Texture     = ( mesh + ( ( seed >> 16 ) % 3 ) ) % STATE_TEXTURES;
+        draw.VertexCount = 36 + 6 * ( mesh % 16 );
+    }
+
+    std::vector<StateDraw> sorted( unsorted );
+    std::sort( sorted.begin(), sorted.end() );
+
+    // App::OnRenderD3D() と同じく1フレーム1描画のシーン.
+    std::vector<StateDraw> single( 1, unsorted[0] );
+
+    struct Scene
+    {
+        const char*                     Name;
+        const std::vector<StateDraw>*   pDraws;
+    };
+    const Scene scenes[] = {
+        { "single",   &single },
+        { "unsorted", &unsorted },
+        { "sorted",   &sorted },
+    };
+
+    std::printf( "State Cache : %u frames, %u pipelines, %u textures, %u meshes\n",
+        STATE_FRAMES, cache.GetPipelineCount(), STATE_TEXTURES, STATE_MESHES );
+    std::printf( "scene, draws/frame, calls/frame off, calls/frame on, elided, pipeline changes/frame, ns/draw off, ns/draw on, checksum\n" );
+
+    StateCache::Stats sortedStats = {};
+    for( size_t s = 0; s < sizeof(scenes) / sizeof(scenes[0]); ++s )
+    {
+        const std::vector<StateDraw>& draws = *scenes[s].pDraws;
+
+        uint64_t calls   [2] = {};
+        uint64_t checksum[2] = {};
+        double   msec    [2] = {};
+        StateCache::Stats stats = {};
+        for( uint32_t mode = 0; mode < 2; ++mode )
+        {
+            context.Reset();
+            cache.SetEnabled( mode == 1 );
+            cache.ResetStats();
+
+            const int64_t begin = Timer::GetTicks();
+            for( uint32_t frame = 0; frame < STATE_FRAMES; ++frame )
+            { SubmitStateFrame( cache, draws ); }
+            msec[mode] = Timer::ToMsec( Timer::GetTicks() - begin );
+
+            calls   [mode] = context.GetStateCallCount();
+            checksum[mode] = context.GetChecksum();
+            stats          = cache.GetStats();
+
+            if ( context.GetCallCount( RENDER_CALL_DRAW ) != uint64_t( draws.size() ) * STATE_FRAMES )
+            {
+                ELOG( "Error : Draw calls were dropped. (%s)", scenes[s].Name );
+                result = false;
+            }
+        }
+
+        const bool   match  = ( checksum[0] == checksum[1] );
+        const double frames = double( STATE_FRAMES );
+        const double count  = double( draws.size() ) * frames;
+        if ( !match )
+        {
+            ELOG( "Error : State at draw time differs with filtering. (%s)", scenes[s].Name );
+            result = false;
+        }
+
+        std::printf( "%s, %u, %.1f, %.1f, %.1f %%, %.1f, %.1f, %.1f, %s\n",
+            scenes[s].Name,
+            uint32_t( draws.size() ),
+            double( calls[0] ) / frames,
+            double( calls[1] ) / frames,
+            100.0 * ( 1.0 - double( calls[1] ) / double( calls[0] ) ),
+            double( stats.PipelineChangeCount ) / frames,
+            msec[0] * 1000000.0 / count,
+            msec[1] * 1000000.0 / count,
+            match ? "match" : "MISMATCH" );
+
+        if ( scenes[s].pDraws == &sorted )
+        { sortedStats = stats; }
+    }
+
+    // 並べ替えたシーンの呼び出しの種類ごとの内訳.
+    const char* names[RENDER_CALL_COUNT] = {
+        "targets", "input layout", "vertex buffer", "topology", "vertex shader", "pixel shader",
+        "blend", "depth stencil", "rasterizer", "texture", "sampler", "instance buffer", "draw",
+    };
+    std::printf( "\nsorted scene breakdown per frame : call, issued, elided\n" );
+    for( uint32_t i = 0; i < RENDER_CALL_COUNT; ++i )
+    {
+        std::printf( "  %-15s %10.1f %10.1f\n", names[i],
+            double( sortedStats.Issued[i] ) / double( STATE_FRAMES ),
+            double( sortedStats.Elided[i] ) / double( STATE_FRAMES ) );
+    }
+
+    cache.Term();
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リングバッファに1フレーム分のデータを書き込みます. 確保した領域はフレーム番号で
+//      塗りつぶし, GPU 役のスレッドが処理を終える時点で書き換えられていないかを検証します.
+//-------------------------------------------------------------------------------------------------
+bool StreamRingFrame( RingBuffer& ring, std::vector<uint8_t>& storage, uint32_t frame, uint32_t& seed, std::vector<RingAllocation>& allocs )
+{
+    allocs.clear();
+
+    const uint32_t total = RING_VERTEX_CHUNKS + RING_INDEX_CHUNKS + RING_CONSTANT_CHUNKS;
+    for( uint32_t i = 0; i < total; ++i )
+    {
+        seed = seed * 1664525u + 1013904223u;
+
+        uint64_t size      = 256;
+        uint64_t alignment = 256;
+        if ( i < RING_VERTEX_CHUNKS )
+        {
+            size      = 8 * 1024 + ( ( seed >> 8 ) % ( 48 * 1024 ) );
+            alignment = 16;
+        }
+        else if ( i < RING_VERTEX_CHUNKS + RING_INDEX_CHUNKS )
+        {
+            size      = 2 * 1024 + ( ( seed >> 8 ) % ( 12 * 1024 ) );
+            alignment = 4;
+        }
+
+        RingAllocation alloc;
+        if ( !ring.Allocate( size, alignment, alloc ) )
+        { return false; }
+
+        memset( &storage[size_t( alloc.Offset )], int( frame & 0xff ), size_t( alloc.Size ) );
+        allocs.push_back( alloc );
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      毎フレームの頂点, インデックス, 定数データをフェンス付きのリングバッファで転送し,
+//      転送量とリングの折り返しによる待ちを計測します. GPU の代わりに一定時間ごとに
+//      フェンスを完了するスレッドを使い, 使用中の領域が上書きされないことも検証します.
+//-------------------------------------------------------------------------------------------------
+bool RunRingBufferBenchmark()
+{
+    const uint32_t capacityCount = uint32_t( sizeof(RING_CAPACITIES) / sizeof(RING_CAPACITIES[0]) );
+    const uint32_t gpuCount      = uint32_t( sizeof(RING_GPU_MSEC)   / sizeof(RING_GPU_MSEC[0]) );
+    const double   MiB           = 1024.0 * 1024.0;
+
+    std::printf( "Ring Buffer : %u frames, %u allocations/frame, CPU runs up to %u frames ahead\n",
+        RING_FRAMES, RING_VERTEX_CHUNKS + RING_INDEX_CHUNKS + RING_CONSTANT_CHUNKS, RING_LATENCY );
+    std::printf( "capacity MiB, frames in ring, gpu ms/frame, MB/s, frames/s, stalls, stall ms/frame, wraps, padding, peak MiB, corrupted\n" );
+
+    bool result = true;
+    for( uint32_t g = 0; g < gpuCount; ++g )
+    {
+        for( uint32_t c = 0; c < capacityCount; ++c )
+        {
+            const uint64_t capacity = RING_CAPACITIES[c];
+
+            std::vector<uint8_t> storage( size_t( capacity ), 0 );
+            std::vector< std::vector<RingAllocation> > frames( RING_FRAMES );
+            std::atomic<uint32_t> corrupted( 0 );
+
+            // GPU 役のスレッドが処理を終える時点で, そのフレームのデータが残っているかを確認する.
+            SimulatedGpuFence fence;
+            fence.Init( RING_GPU_MSEC[g], [&]( uint64_t value )
+            {
+                const uint32_t frame = uint32_t( value - 1 );
+                const std::vector<RingAllocation>& allocs = frames[frame];
+                for( size_t i = 0; i < allocs.size(); ++i )
+                {
+                    const uint8_t* pData = &storage[size_t( allocs[i].Offset )];
+                    for( uint64_t j = 0; j < allocs[i].Size; j += 64 )
+                    {
+                        if ( pData[j] != uint8_t( frame & 0xff ) )
+                        {
+                            corrupted++;
+                            break;
+                        }
+                    }
+                }
+            });
+
+            RingBuffer ring;
+            if ( !ring.Init( capacity, &fence ) )
+            {
+                ELOG( "Error : RingBuffer::Init() Failed." );
+                return false;
+            }
+
+            uint32_t seed = 1;
+            const int64_t begin = Timer::GetTicks();
+            for( uint32_t frame = 0; frame < RING_FRAMES; ++frame )
+            {
+                // Present() と同じく, 先行しすぎた場合は GPU を待つ.
+                if ( frame >= RING_LATENCY )
+                { fence.Wait( frame - RING_LATENCY + 1 ); }
+
+                if ( !StreamRingFrame( ring, storage, frame, seed, frames[frame] ) )
+                {
+                    ELOG( "Error : StreamRingFrame() Failed." );
+                    result = false;
+                    break;
+                }
+
+                ring.EndFrame();
+            }
+            fence.Wait( RING_FRAMES );
+            const double sec = Timer::ToSec( Timer::GetTicks() - begin );
+
+            const RingBuffer::Stats stats = ring.GetStats();
+            ring.Term();
+            fence.Term();
+
+            if ( corrupted > 0 )
+            {
+                ELOG( "Error : In-flight data was overwritten. (%u allocations)", corrupted.load() );
+                result = false;
+            }
+
+            const double frameBytes = double( stats.AllocBytes ) / double( stats.FrameCount );
+            std::printf( "%.2f, %.2f, %.1f, %.1f, %.1f, %llu, %.3f, %llu, %.2f %%, %.2f, %u\n",
+                double( capacity ) / MiB,
+                double( capacity ) / frameBytes,
+                RING_GPU_MSEC[g],
+                double( stats.AllocBytes ) / sec / 1000000.0,
+                double( stats.FrameCount ) / sec,
+                (unsigned long long)stats.StallCount,
+                stats.StallMsec / double( stats.FrameCount ),
+                (unsigned long long)stats.WrapCount,
+                100.0 * double( stats.PaddingBytes ) / double( stats.AllocBytes + stats.PaddingBytes ),
+                double( stats.PeakBytes ) / MiB,
+                corrupted.load() );
+        }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// MovingObject structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct MovingObject
+{
+    float       Position[2];    //!< 位置です (ピクセル).
+    float       Velocity[2];    //!< 1フレームの移動量です.
+    float       Rotation;       //!< 回転角です (ラジアン).
+    float       Spin;           //!< 1フレームの回転量です.
+    float       Color[4];       //!< 頂点カラーに乗算する色です.
+    uint32_t    Mesh;           //!< メッシュ番号です.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      物体が共有するメッシュを生成します. 原点を中心とする正多角形を中心からの三角形で
+//      分割したもので, 中心は白, 外周はメッシュごとの色にします.
+//-------------------------------------------------------------------------------------------------
+void BuildTransformMeshes( uint32_t vertexCount, std::vector<MeshVertex>& meshes )
+{
+    const uint32_t sides = vertexCount / 3;
+    meshes.assign( size_t( vertexCount ) * XFORM_MESHES, MeshVertex() );
+
+    uint32_t seed = 7;
+    for( uint32_t m = 0; m < XFORM_MESHES; ++m )
+    {
+        float r[4];
+        for( uint32_t j = 0; j < 4; ++j )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            r[j] = float( seed >> 8 ) / float( 1 << 24 );
+        }
+
+        const float radius = 4.0f + r[0] * 12.0f;
+        MeshVertex* pMesh  = &meshes[size_t( m ) * vertexCount];
+        for( uint32_t i = 0; i < sides; ++i )
+        {
+            MeshVertex* pTri = &pMesh[i * 3];
+            for( uint32_t k = 0; k < 3; ++k )
+            {
+                const float angle = 6.2831853f * float( i + k - 1 ) / float( sides );
+                const bool  rim   = ( k != 0 );
+                pTri[k].Position[0] = rim ? radius * cosf( angle ) : 0.0f;
+                pTri[k].Position[1] = rim ? radius * sinf( angle ) : 0.0f;
+                pTri[k].Position[2] = 0.0f;
+                pTri[k].Color[0]    = rim ? r[1] : 1.0f;
+                pTri[k].Color[1]    = rim ? r[2] : 1.0f;
+                pTri[k].Color[2]    = rim ? r[3] : 1.0f;
+                pTri[k].Color[3]    = 1.0f;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      物体の初期位置と動きを乱数で決めます. 同じメッシュの物体は連続して並べます.
+//-------------------------------------------------------------------------------------------------
+void InitMovingObjects( std::vector<MovingObject>& objects )
+{
+    uint32_t seed = 11;
+    for( size_t i = 0; i < objects.size(); ++i )
+    {
+        float r[9];
+        for( uint32_t j = 0; j < 9; ++j )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            r[j] = float( seed >> 8 ) / float( 1 << 24 );
+        }
+
+        MovingObject& object = objects[i];
+        object.Position[0] = r[0] * float( XFORM_WIDTH );
+        object.Position[1] = r[1] * float( XFORM_HEIGHT );
+        object.Velocity[0] = r[2] * 4.0f - 2.0f;
+        object.Velocity[1] = r[3] * 4.0f - 2.0f;
+        object.Rotation    = r[4] * 6.2831853f;
+        object.Spin        = r[5] * 0.1f - 0.05f;
+        object.Color[0]    = 0.5f + r[6] * 0.5f;
+        object.Color[1]    = 0.5f + r[7] * 0.5f;
+        object.Color[2]    = 0.5f + r[8] * 0.5f;
+        object.Color[3]    = ( i % 4 == 0 ) ? 0.5f : 1.0f;
+        object.Mesh        = uint32_t( uint64_t( i ) * XFORM_MESHES / objects.size() );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      物体を1フレーム分動かします. 範囲の外に出た物体は反対側に戻します.
+//-------------------------------------------------------------------------------------------------
+void MoveObjects( std::vector<MovingObject>& objects )
+{
+    const float size[2] = { float( XFORM_WIDTH ), float( XFORM_HEIGHT ) };
+    for( size_t i = 0; i < objects.size(); ++i )
+    {
+        MovingObject& object = objects[i];
+        for( uint32_t j = 0; j < 2; ++j )
+        {
+            object.Position[j] += object.Velocity[j];
+            if ( object.Position[j] < 0.0f )
+            { object.Position[j] += size[j]; }
+            else if ( object.Position[j] >= size[j] )
+            { object.Position[j] -= size[j]; }
+        }
+        object.Rotation += object.Spin;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      毎フレーム動く 100k 個の物体について, 頂点データを書き換えて転送する場合 (スカラー版と
+//      SIMD 版の頂点変換) と, 描画ごとの変換 (DrawTransform) だけをまとめて転送する場合の
+//      CPU 時間と転送量を比較します. 転送先は動的バッファのマップ先を模擬した配列です.
+//      SIMD 版の頂点変換がスカラー版と一致すること, ラスタライザの頂点ステージで変換した
+//      結果が変換済みの頂点を描画した結果と一致することも検証します.
+//-------------------------------------------------------------------------------------------------
+bool RunTransformBenchmark()
+{
+    const uint32_t sizeCount = uint32_t( sizeof(XFORM_VERTICES) / sizeof(XFORM_VERTICES[0]) );
+    const double   MB        = 1000.0 * 1000.0;
+
+    std::printf( "Transforms : %u moving objects/frame, %u shared meshes, %u frames\n",
+        XFORM_OBJECTS, XFORM_MESHES, XFORM_FRAMES );
+    std::printf( "vertices/object, path, ms/frame, upload MB/frame, draws/frame, matches reference\n" );
+
+    bool result = true;
+    for( uint32_t s = 0; s < sizeCount; ++s )
+    {
+        const uint32_t vertexCount = XFORM_VERTICES[s];
+
+        std::vector<MeshVertex> meshes;
+        BuildTransformMeshes( vertexCount, meshes );
+
+        std::vector<MovingObject> objects( XFORM_OBJECTS );
+        InitMovingObjects( objects );
+
+        std::vector<MeshVertex>    scalarVertices( size_t( XFORM_OBJECTS ) * vertexCount );
+        std::vector<MeshVertex>    simdVertices  ( size_t( XFORM_OBJECTS ) * vertexCount );
+        std::vector<DrawTransform> transforms    ( XFORM_OBJECTS );
+
+        Timer  timer;
+        double scalarMsec  = 0.0;
+        double simdMsec    = 0.0;
+        double streamMsec  = 0.0;
+        bool   simdMatches = true;
+        for( uint32_t frame = 0; frame < XFORM_FRAMES; ++frame )
+        {
+            MoveObjects( objects );
+
+            // 頂点データを書き換える (スカラー版).
+            timer.Reset();
+            for( size_t i = 0; i < objects.size(); ++i )
+            {
+                const MovingObject& object = objects[i];
+                DrawTransform transform;
+                SetDrawTransform( transform, object.Position[0], object.Position[1], object.Rotation, 1.0f, object.Color );
+                TransformVertices_Scalar( &meshes[size_t( object.Mesh ) * vertexCount], vertexCount, transform, &scalarVertices[i * vertexCount] );
+            }
+            scalarMsec += timer.GetElapsedMsec();
+
+            // 頂点データを書き換える (SIMD 版).
+            timer.Reset();
+            for( size_t i = 0; i < objects.size(); ++i )
+            {
+                const MovingObject& object = objects[i];
+                DrawTransform transform;
+                SetDrawTransform( transform, object.Position[0], object.Position[1], object.Rotation, 1.0f, object.Color );
+                TransformVertices( &meshes[size_t( object.Mesh ) * vertexCount], vertexCount, transform, &simdVertices[i * vertexCount] );
+            }
+            simdMsec += timer.GetElapsedMsec();
+
+            // 描画ごとの変換だけを書き込む. 頂点データは初期化時に転送したものを使い続ける.
+            timer.Reset();
+            for( size_t i = 0; i < objects.size(); ++i )
+            {
+                const MovingObject& object = objects[i];
+                SetDrawTransform( transforms[i], object.Position[0], object.Position[1], object.Rotation, 1.0f, object.Color );
+            }
+            streamMsec += timer.GetElapsedMsec();
+
+            if ( memcmp( scalarVertices.data(), simdVertices.data(), scalarVertices.size() * sizeof(MeshVertex) ) != 0 )
+            { simdMatches = false; }
+        }
+
+        // 最終フレームの先頭の物体を, 変換済みの頂点とラスタライザの頂点ステージとで描画して比較する.
+        TriangleRasterizer expected;
+        TriangleRasterizer actual;
+        Surface expectedImage;
+        Surface actualImage;
+        if ( !expected.Init( XFORM_WIDTH, XFORM_HEIGHT, AA_MODE_NONE ) || !actual.Init( XFORM_WIDTH, XFORM_HEIGHT, AA_MODE_NONE )
+          || !expectedImage.Init( XFORM_WIDTH, XFORM_HEIGHT ) || !actualImage.Init( XFORM_WIDTH, XFORM_HEIGHT ) )
+        {
+            ELOG( "Error : Verification Init Failed." );
+            return false;
+        }
+
+        expected.Clear( XFORM_BACKGROUND );
+        expected.DrawTriangles( scalarVertices.data(), size_t( XFORM_VERIFY ) * vertexCount );
+        expected.Resolve( expectedImage );
+
+        actual.Clear( XFORM_BACKGROUND );
+        for( uint32_t i = 0; i < XFORM_VERIFY; ++i )
+        { actual.DrawTriangles( &meshes[size_t( objects[i].Mesh ) * vertexCount], vertexCount, transforms[i] ); }
+        actual.Resolve( actualImage );
+
+        const bool stageMatches = ( GetMaxChannelDiff( expectedImage, actualImage ) == 0 );
+
+        // 頂点を書き換える場合は全物体を1つの頂点バッファにまとめて1回で描画できる.
+        // 変換を転送する場合は同じメッシュの物体が連続するので, メッシュごとに1回のインスタンス描画になる.
+        const double vertexBytes    = double( scalarVertices.size() * sizeof(MeshVertex) );
+        const double transformBytes = double( transforms.size() * sizeof(DrawTransform) );
+        std::printf( "%u, rewrite scalar, %.3f, %.2f, 1, %s\n",
+            vertexCount, scalarMsec / XFORM_FRAMES, vertexBytes / MB, "yes" );
+        std::printf( "%u, rewrite simd, %.3f, %.2f, 1, %s\n",
+            vertexCount, simdMsec / XFORM_FRAMES, vertexBytes / MB, simdMatches ? "yes" : "NO" );
+        std::printf( "%u, transform stream, %.3f, %.2f, %u, %s\n",
+            vertexCount, streamMsec / XFORM_FRAMES, transformBytes / MB, XFORM_MESHES, stageMatches ? "yes" : "NO" );
+
+        if ( !simdMatches )
+        {
+            ELOG( "Error : SIMD vertex transform differs from scalar transform." );
+            result = false;
+        }
+
+        if ( !stageMatches )
+        {
+            ELOG( "Error : Rasterizer vertex stage differs from pre-transformed vertices." );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乱数の B8G8R8A8 画像を SIMD 版とスカラー版で I420 に変換し, 全プレーンが一致するか確認します.
+//      行ピッチには余白を入れ, 余白が書き換えられていないことも合わせて確認します.
+//-------------------------------------------------------------------------------------------------
+bool ConvertI420Matches( uint32_t width, uint32_t height, uint32_t& seed )
+{
+    const uint32_t srcPitch = width * 4 + 12;
+    const uint32_t pitchY   = width + 3;
+    const uint32_t pitchUV  = ( width + 1 ) / 2 + 5;
+    const size_t   sizeY    = size_t( pitchY ) * height;
+    const size_t   sizeUV   = size_t( pitchUV ) * ( ( height + 1 ) / 2 );
+
+    std::vector<uint8_t> src( size_t( srcPitch ) * height );
+    for( size_t i = 0; i < src.size(); ++i )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        src[i] = uint8_t( seed >> 24 );
+    }
+
+    std::vector<uint8_t> simd  ( sizeY + sizeUV * 2, 0xCD );
+    std::vector<uint8_t> scalar( sizeY + sizeUV * 2, 0xCD );
+
+    PlanarYUV dst;
+    dst.PitchY  = pitchY;
+    dst.PitchUV = pitchUV;
+
+    dst.pY = simd.data();
+    dst.pU = dst.pY + sizeY;
+    dst.pV = dst.pU + sizeUV;
+    ConvertBGRAToI420( src.data(), srcPitch, width, height, dst );
+
+    dst.pY = scalar.data();
+    dst.pU = dst.pY + sizeY;
+    dst.pV = dst.pU + sizeUV;
+    ConvertBGRAToI420_Scalar( src.data(), srcPitch, width, height, dst );
+
+    return memcmp( simd.data(), scalar.data(), simd.size() ) == 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      録画用の合成フレームを生成します. 横に流れるグラデーションに乱数のノイズを重ねます.
+//-------------------------------------------------------------------------------------------------
+void BuildRecordFrame( uint32_t index, std::vector<uint8_t>& pixels )
+{
+    pixels.resize( size_t( RECORD_WIDTH ) * RECORD_HEIGHT * 4 );
+
+    uint32_t seed = index + 1;
+    for( uint32_t y = 0; y < RECORD_HEIGHT; ++y )
+    {
+        uint8_t* pRow = &pixels[size_t( y ) * RECORD_WIDTH * 4];
+        for( uint32_t x = 0; x < RECORD_WIDTH; ++x )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const uint32_t noise = ( seed >> 28 );
+            pRow[x * 4 + 0] = uint8_t( ( x + index * 16 ) * 255 / ( RECORD_WIDTH + RECORD_SOURCES * 16 ) + noise );
+            pRow[x * 4 + 1] = uint8_t( y * 255 / RECORD_HEIGHT );
+            pRow[x * 4 + 2] = uint8_t( ( x ^ y ) + index * 32 );
+            pRow[x * 4 + 3] = 0xFF;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      書き出されたファイルの最終フレームが, 元画像をスカラー版で変換した結果と一致するか確認します.
+//-------------------------------------------------------------------------------------------------
+bool LastRecordedFrameMatches( const char* path, const std::vector<uint8_t>& source )
+{
+    const size_t sizeY   = size_t( RECORD_WIDTH ) * RECORD_HEIGHT;
+    const size_t sizeUV  = size_t( ( RECORD_WIDTH + 1 ) / 2 ) * ( ( RECORD_HEIGHT + 1 ) / 2 );
+    const size_t size    = sizeY + sizeUV * 2;
+    const char   tag[]   = "FRAME\n";
+
+    std::vector<uint8_t> expected( size );
+    PlanarYUV yuv;
+    yuv.pY      = expected.data();
+    yuv.pU      = yuv.pY + sizeY;
+    yuv.pV      = yuv.pU + sizeUV;
+    yuv.PitchY  = RECORD_WIDTH;
+    yuv.PitchUV = ( RECORD_WIDTH + 1 ) / 2;
+    ConvertBGRAToI420_Scalar( source.data(), RECORD_WIDTH * 4, RECORD_WIDTH, RECORD_HEIGHT, yuv );
+
+    FILE* pFile = std::fopen( path, "rb" );
+    if ( pFile == nullptr )
+    { return false; }
+
+    std::vector<uint8_t> actual( sizeof(tag) - 1 + size );
+    const bool read = std::fseek( pFile, -long( actual.size() ), SEEK_END ) == 0
+                   && std::fread( actual.data(), 1, actual.size(), pFile ) == actual.size();
+    std::fclose( pFile );
+
+    return read
+        && memcmp( actual.data(), tag, sizeof(tag) - 1 ) == 0
+        && memcmp( actual.data() + sizeof(tag) - 1, expected.data(), size ) == 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1080p の合成フレームを描画スレッドから FrameRecorder に投入し, 変換スレッドと書き出し
+//      スレッドを通した持続 fps, 投入時のキュー長, バッファ待ちによる停止をキュー長ごとに計測します.
+//      先に奇数サイズを含む画像で SIMD 版の I420 変換がスカラー版と一致することを確認し, 最後に
+//      書き出されたファイルの最終フレームを照合します.
+//-------------------------------------------------------------------------------------------------
+bool RunRecordBenchmark()
+{
+    const uint32_t depthCount = uint32_t( sizeof(RECORD_DEPTHS)       / sizeof(RECORD_DEPTHS[0]) );
+    const uint32_t sizeCount  = uint32_t( sizeof(RECORD_VERIFY_SIZES) / sizeof(RECORD_VERIFY_SIZES[0]) );
+
+    bool result = true;
+
+    // SIMD 版とスカラー版の比較.
+    uint32_t seed = 1;
+    uint32_t mismatches = 0;
+    for( uint32_t i = 0; i < sizeCount; ++i )
+    {
+        const uint32_t width  = RECORD_VERIFY_SIZES[i][0];
+        const uint32_t height = RECORD_VERIFY_SIZES[i][1];
+        if ( !ConvertI420Matches( width, height, seed ) )
+        {
+            ELOG( "Error : SIMD I420 conversion differs from scalar conversion. size = %ux%u", width, height );
+            mismatches++;
+        }
+    }
+    std::printf( "I420 : SIMD vs scalar on %u sizes (odd widths and heights included), identical %s\n",
+        sizeCount, ( mismatches == 0 ) ? "yes" : "NO" );
+    if ( mismatches > 0 )
+    { result = false; }
+
+    std::vector< std::vector<uint8_t> > sources( RECORD_SOURCES );
+    for( uint32_t i = 0; i < RECORD_SOURCES; ++i )
+    { BuildRecordFrame( i, sources[i] ); }
+
+    std::printf( "Record : %ux%u, %u frames per run, render thread submits without waiting for vsync\n",
+        RECORD_WIDTH, RECORD_HEIGHT, RECORD_FRAMES );
+    std::printf( "queue depth, fps, submit fps, convert ns/pixel, avg depth, max depth, stalled frames, stall ms, written, last frame matches\n" );
+
+    for( uint32_t d = 0; d < depthCount; ++d )
+    {
+        FrameRecorder recorder;
+        if ( !recorder.Open( RECORD_TEMP_PATH, RECORD_WIDTH, RECORD_HEIGHT, 60, RECORD_DEPTHS[d] ) )
+        {
+            ELOG( "Error : FrameRecorder::Open() Failed." );
+            return false;
+        }
+
+        Timer timer;
+        for( uint32_t frame = 0; frame < RECORD_FRAMES; ++frame )
+        {
+            const std::vector<uint8_t>& source = sources[frame % RECORD_SOURCES];
+            if ( !recorder.PushFrame( source.data(), RECORD_WIDTH * 4, RECORD_WIDTH, RECORD_HEIGHT ) )
+            {
+                ELOG( "Error : FrameRecorder::PushFrame() Failed. frame = %u", frame );
+                result = false;
+                break;
+            }
+        }
+        const double submitMsec = timer.GetElapsedMsec();
+
+        // 閉じるまでにキューに残ったフレームが全て書き出される.
+        recorder.Close();
+        const double totalMsec = timer.GetElapsedMsec();
+
+        const FrameRecorder::Stats stats = recorder.GetStats();
+        const bool matches = !stats.WriteFailed
+                          && stats.WrittenFrames == RECORD_FRAMES
+                          && LastRecordedFrameMatches( RECORD_TEMP_PATH, sources[( RECORD_FRAMES - 1 ) % RECORD_SOURCES] );
+        std::remove( RECORD_TEMP_PATH );
+
+        std::printf( "%u, %.1f, %.1f, %.3f, %.2f, %u, %llu, %.1f, %llu, %s\n",
+            RECORD_DEPTHS[d],
+            RECORD_FRAMES * 1000.0 / totalMsec,
+            RECORD_FRAMES * 1000.0 / submitMsec,
+            stats.ConvertNsPerPixel,
+            stats.AvgQueueDepth,
+            uint32_t( stats.MaxQueueDepth ),
+            (unsigned long long)stats.BlockedFrames,
+            stats.BlockedMsec,
+            (unsigned long long)stats.WrittenFrames,
+            matches ? "yes" : "NO" );
+
+        if ( !matches )
+        {
+            ELOG( "Error : Recorded output differs from scalar conversion." );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      模擬クロック上で FramePacer を通して count フレームを描画し, 表示時刻を presents に追加します.
+//-------------------------------------------------------------------------------------------------
+void RunPacedFrames
+(
+    FramePacer&             pacer,
+    SimulatedFrameClock&    clock,
+    uint32_t                count,
+    int64_t                 renderTicks,
+    uint32_t&               seed,
+    std::vector<int64_t>&   presents
+)
+{
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        pacer.BeginFrame();
+
+        seed = seed * 1664525u + 1013904223u;
+        clock.Advance( renderTicks + int64_t( ( seed >> 16 ) % uint32_t( PACER_JITTER_TICKS ) ) );
+        presents.push_back( clock.GetTicks() );
+
+        pacer.EndFrame();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      FramePacer の統計を 1 行出力します.
+//-------------------------------------------------------------------------------------------------
+void PrintPacerStats( const char* phase, const FramePacer::Stats& stats )
+{
+    std::printf( "%s, %llu, %llu, %.3f, %.3f, %.3f, %.3f\n",
+        phase,
+        (unsigned long long)stats.FrameCount,
+        (unsigned long long)stats.MissedDeadlines,
+        stats.MaxLatenessMsec,
+        stats.MeanFrameMsec,
+        stats.OversleepMsec,
+        stats.PredictedRenderMsec );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      模擬クロック上で FramePacer を動かし, 一定の描画時間での表示期限の遵守, 寝過ごし量を
+//      増減させた時の推定値の追従, 描画時間の突発的な遅れの後に遅れを取り戻そうと連続して
+//      表示せず刻み直すことを確認します. 実時間では待たないのでウィンドウは不要です.
+//-------------------------------------------------------------------------------------------------
+bool RunPacerBenchmark()
+{
+    SimulatedFrameClock clock( PACER_TICKS_PER_SEC, PACER_OVERSLEEP_LOW, PACER_SPIN_TICKS );
+    FramePacer pacer( &clock );
+    pacer.SetTargetRate( PACER_RATE );
+
+    const int64_t period     = int64_t( double( PACER_TICKS_PER_SEC ) / PACER_RATE );
+    const double  ticksPerMs = double( PACER_TICKS_PER_SEC ) / 1000.0;
+
+    bool result = true;
+    uint32_t seed = 1;
+    std::vector<int64_t> presents;
+    presents.reserve( PACER_WARMUP_FRAMES + PACER_SETTLE_FRAMES + PACER_PHASE_FRAMES * 4 + 1 );
+
+    std::printf( "Pacer : simulated clock, target %.1f fps, render %.1f-%.1f ms, oversleep %.1f ms then %.1f ms\n",
+        PACER_RATE,
+        double( PACER_RENDER_TICKS ) / ticksPerMs,
+        double( PACER_RENDER_TICKS + PACER_JITTER_TICKS ) / ticksPerMs,
+        double( PACER_OVERSLEEP_LOW ) / ticksPerMs,
+        double( PACER_OVERSLEEP_HIGH ) / ticksPerMs );
+    std::printf( "phase, frames, missed, max lateness ms, mean frame ms, oversleep estimate ms, predicted render ms\n" );
+
+    // 定常状態. 予測が収束した後は表示期限を外さない.
+    RunPacedFrames( pacer, clock, PACER_WARMUP_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, PACER_PHASE_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    {
+        const FramePacer::Stats stats = pacer.GetStats();
+        PrintPacerStats( "steady", stats );
+        if ( stats.MissedDeadlines != 0 )
+        {
+            ELOG( "Error : Missed deadlines in steady state. missed = %llu", (unsigned long long)stats.MissedDeadlines );
+            result = false;
+        }
+    }
+
+    // 寝過ごし量の増加. 推定値は直ちに追従し, その後は表示期限を外さない.
+    clock.SetSleepOvershoot( PACER_OVERSLEEP_HIGH );
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, PACER_SETTLE_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    const uint64_t settleMissed = pacer.GetStats().MissedDeadlines;
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, PACER_PHASE_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    {
+        const FramePacer::Stats stats = pacer.GetStats();
+        PrintPacerStats( "oversleep up", stats );
+        std::printf( "  missed while adapting : %llu in %u frames\n", (unsigned long long)settleMissed, PACER_SETTLE_FRAMES );
+        if ( stats.MissedDeadlines != 0 )
+        {
+            ELOG( "Error : Missed deadlines after oversleep increase. missed = %llu", (unsigned long long)stats.MissedDeadlines );
+            result = false;
+        }
+        if ( fabs( stats.OversleepMsec * ticksPerMs - double( PACER_OVERSLEEP_HIGH ) ) > 0.1 * double( PACER_OVERSLEEP_HIGH ) )
+        {
+            ELOG( "Error : Oversleep estimate did not follow increase. estimate = %.3f ms", stats.OversleepMsec );
+            result = false;
+        }
+    }
+
+    // 寝過ごし量の減少. 推定値はゆっくり戻る.
+    clock.SetSleepOvershoot( PACER_OVERSLEEP_LOW );
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, PACER_PHASE_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    {
+        const FramePacer::Stats stats = pacer.GetStats();
+        PrintPacerStats( "oversleep down", stats );
+        if ( stats.MissedDeadlines != 0 )
+        {
+            ELOG( "Error : Missed deadlines after oversleep decrease. missed = %llu", (unsigned long long)stats.MissedDeadlines );
+            result = false;
+        }
+        if ( fabs( stats.OversleepMsec * ticksPerMs - double( PACER_OVERSLEEP_LOW ) ) > 0.1 * double( PACER_OVERSLEEP_LOW ) )
+        {
+            ELOG( "Error : Oversleep estimate did not follow decrease. estimate = %.3f ms", stats.OversleepMsec );
+            result = false;
+        }
+    }
+
+    // 描画時間の突発的な遅れ. 遅れたフレームの後は現在時刻から刻み直し, 続けて表示しない.
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, 1, PACER_SPIKE_TICKS, seed, presents );
+    const uint64_t spikeMissed = pacer.GetStats().MissedDeadlines;
+    const size_t   spikeIndex  = presents.size() - 1;
+    pacer.ResetStats();
+    RunPacedFrames( pacer, clock, PACER_PHASE_FRAMES, PACER_RENDER_TICKS, seed, presents );
+    {
+        const FramePacer::Stats stats = pacer.GetStats();
+        PrintPacerStats( "after spike", stats );
+
+        const int64_t windowEnd = presents[spikeIndex] + period * PACER_BURST_PERIODS;
+        uint32_t burst = 0;
+        for( size_t i = spikeIndex + 1; i < presents.size() && presents[i] <= windowEnd; ++i )
+        { burst++; }
+
+        std::printf( "  spike : %.1f ms render, %llu missed, %u frames presented in the next %u periods\n",
+            double( PACER_SPIKE_TICKS ) / ticksPerMs,
+            (unsigned long long)spikeMissed,
+            burst,
+            PACER_BURST_PERIODS );
+
+        if ( burst > PACER_BURST_PERIODS )
+        {
+            ELOG( "Error : Frames burst after a late frame. frames = %u, periods = %u", burst, PACER_BURST_PERIODS );
+            result = false;
+        }
+        if ( stats.MissedDeadlines != 0 )
+        {
+            ELOG( "Error : Missed deadlines after a late frame. missed = %llu", (unsigned long long)stats.MissedDeadlines );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      遅延が既知のイベントを InputLatencyTracker に投入し, 種別ごとのイベント数, 平均,
+//      パーセンタイル, 最大値が期待値と一致すること, 容量を超えた分が破棄として数えられることを
+//      確認します. 表示時刻は模擬した値を渡すので実時間では待ちません.
+//-------------------------------------------------------------------------------------------------
+bool RunLatencyBenchmark()
+{
+    const uint32_t typeCount    = uint32_t( sizeof(LATENCY_BASE_USEC)   / sizeof(LATENCY_BASE_USEC[0]) );
+    const uint32_t pctCount     = uint32_t( sizeof(LATENCY_PERCENTILES) / sizeof(LATENCY_PERCENTILES[0]) );
+    const uint64_t perType      = uint64_t( LATENCY_FRAMES ) * LATENCY_PER_FRAME;
+    const int64_t  ticksPerSec  = Timer::GetTicksPerSec();
+    const int64_t  period       = ticksPerSec / 60;
+    const double   bucketMsec   = double( LatencyHistogram::BucketUsec ) / 1000.0;
+
+    bool result = true;
+
+    InputLatencyTracker tracker;
+    if ( !tracker.Init() )
+    {
+        ELOG( "Error : InputLatencyTracker::Init() Failed." );
+        return false;
+    }
+
+    // 種別ごとに base + k * step (k = 0 ～ perType - 1) の遅延を順序を混ぜて投入する.
+    Timer timer;
+    int64_t present = ticksPerSec;
+    for( uint32_t frame = 0; frame < LATENCY_FRAMES; ++frame )
+    {
+        present += period;
+        for( uint32_t t = 0; t < typeCount; ++t )
+        {
+            for( uint32_t j = 0; j < LATENCY_PER_FRAME; ++j )
+            {
+                const uint64_t k     = ( uint64_t( frame * LATENCY_PER_FRAME + j ) * 389 ) % perType;
+                const uint64_t usec  = LATENCY_BASE_USEC[t] + k * LATENCY_STEP_USEC;
+                const int64_t  ticks = int64_t( usec ) * ticksPerSec / 1000000;
+                if ( !tracker.PushEvent( INPUT_EVENT_TYPE( t ), present - ticks ) )
+                {
+                    ELOG( "Error : InputLatencyTracker::PushEvent() Failed." );
+                    result = false;
+                }
+            }
+        }
+
+        tracker.BeginFrame();
+        tracker.EndFrame( present );
+    }
+    const double elapsedMsec = timer.GetElapsedMsec();
+
+    std::printf( "Latency : %u frames, %u events per type per frame, delays base + k * %.2f ms, %.1f ns per event\n",
+        LATENCY_FRAMES, LATENCY_PER_FRAME, double( LATENCY_STEP_USEC ) / 1000.0,
+        elapsedMsec * 1e6 / double( perType * typeCount ) );
+    std::printf( "type, events, mean ms (expected), p50 ms (expected), p95 ms (expected), p99 ms (expected), max ms (expected), matches\n" );
+
+    for( uint32_t t = 0; t < typeCount; ++t )
+    {
+        const InputLatencyTracker::Summary s = tracker.GetSummary( INPUT_EVENT_TYPE( t ) );
+        const double pcts[] = { s.P50Msec, s.P95Msec, s.P99Msec };
+
+        const double meanMsec = ( double( LATENCY_BASE_USEC[t] ) + double( LATENCY_STEP_USEC ) * double( perType - 1 ) * 0.5 ) / 1000.0;
+        const double maxMsec  = double( LATENCY_BASE_USEC[t] + ( perType - 1 ) * LATENCY_STEP_USEC ) / 1000.0;
+
+        // パーセンタイルはバケットの上端を返すので, 真の値から 1 バケット以内に入る.
+        double expected[3];
+        bool matches = ( s.Count == perType )
+                    && fabs( s.MeanMsec - meanMsec ) < 0.001
+                    && fabs( s.MaxMsec  - maxMsec  ) < 0.001;
+        for( uint32_t p = 0; p < pctCount; ++p )
+        {
+            const uint64_t rank = uint64_t( double( perType ) * LATENCY_PERCENTILES[p] / 100.0 + 0.5 );
+            expected[p] = double( LATENCY_BASE_USEC[t] + ( rank - 1 ) * LATENCY_STEP_USEC ) / 1000.0;
+            if ( pcts[p] < expected[p] - 0.001 || pcts[p] > expected[p] + bucketMsec + 0.001 )
+            { matches = false; }
+        }
+
+        std::printf( "%s, %llu, %.3f (%.3f), %.2f (%.2f), %.2f (%.2f), %.2f (%.2f), %.3f (%.3f), %s\n",
+            LATENCY_NAMES[t],
+            (unsigned long long)s.Count,
+            s.MeanMsec, meanMsec,
+            s.P50Msec, expected[0],
+            s.P95Msec, expected[1],
+            s.P99Msec, expected[2],
+            s.MaxMsec, maxMsec,
+            matches ? "yes" : "NO" );
+
+        if ( !matches )
+        {
+            ELOG( "Error : Latency summary differs from injected delays. type = %s", LATENCY_NAMES[t] );
+            result = false;
+        }
+    }
+
+    const InputLatencyTracker::Summary total = tracker.GetTotalSummary();
+    if ( total.Count != perType * typeCount || tracker.GetDroppedCount() != 0 )
+    {
+        ELOG( "Error : Total latency count mismatch. count = %llu, dropped = %llu",
+            (unsigned long long)total.Count, (unsigned long long)tracker.GetDroppedCount() );
+        result = false;
+    }
+
+    // リングバッファの容量を超えて投入した分は破棄され, 残りだけが集計される.
+    if ( !tracker.Init( LATENCY_CAPACITY ) )
+    {
+        ELOG( "Error : InputLatencyTracker::Init() Failed." );
+        return false;
+    }
+    present += period;
+    for( uint32_t i = 0; i < LATENCY_FLOOD; ++i )
+    { tracker.PushEvent( INPUT_EVENT_SYNTHETIC, present - period ); }
+    tracker.BeginFrame();
+    tracker.EndFrame( present );
+
+    const uint64_t kept    = tracker.GetTotalSummary().Count;
+    const uint64_t dropped = tracker.GetDroppedCount();
+    std::printf( "Overflow : %u events into capacity %u, %llu counted, %llu dropped\n",
+        LATENCY_FLOOD, LATENCY_CAPACITY, (unsigned long long)kept, (unsigned long long)dropped );
+    if ( kept != LATENCY_CAPACITY || dropped != LATENCY_FLOOD - LATENCY_CAPACITY )
+    {
+        ELOG( "Error : Overflow accounting mismatch." );
+        result = false;
+    }
+
+    tracker.Term();
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark Table.
+//-------------------------------------------------------------------------------------------------
+const BenchmarkEntry BENCHMARKS[] = {
+    { "gradient",   "SIMD gradient spans vs per-pixel stop evaluation",                 RunGradientBenchmark },
+    { "blur",       "1080p gaussian/box blur and drop shadow vs radius and threads",    RunBlurBenchmark },
+    { "clip",       "nested clipped panels with and without the scissor fast path",     RunClipBenchmark },
+    { "sprite",     "sprite collection and radix sort into instanced draws, 10k-1M",    RunSpriteBenchmark },
+    { "scene",      "100k-node scene graph, 1% dirty per frame, incremental vs full",   RunSceneBenchmark },
+    { "spatial",    "loose quadtree culling and hit-testing of 1M primitives while panning", RunSpatialBenchmark },
+    { "tile",       "screen-tile binned UI rendering on the work-stealing pool, 1-32 threads", RunTileBenchmark },
+    { "font",       "TTF/OTF outline decode and analytic rasterization, args: font paths", RunFontBenchmark },
+    { "text",       "paragraph reflow per resize step, incremental vs full, 1-100k paragraphs", RunTextBenchmark },
+    { "view",       "virtualized scrolling of 1k-10M line logs with line strip reuse",  RunViewBenchmark },
+    { "swapchain",  "software swap chain fifo/mailbox/latest with 2-4 buffers vs render cost", RunSwapChainBenchmark },
+    { "convert",    "4K pixel format conversion GB/s, scalar vs SSE2/AVX2 vs threaded rows", RunConvertBenchmark },
+    { "msaa",       "software rasterizer coverage-mask MSAA 4x/8x vs 4x SSAA, cost and error", RunMsaaBenchmark },
+    { "init",       "startup init tasks with stub backends, serial vs dependency graph on 1-4 threads", RunInitBenchmark },
+    { "memory",     "resource memory accounting over 10k resize cycles, leak control and budget trimming", RunMemoryBenchmark },
+    { "logger",     "async binary logger vs fprintf, ns per call on 1-4 threads and drop counts", RunLoggerBenchmark },
+    { "statecache", "redundant state filtering on a many-draw scene against a recording mock context", RunStateCacheBenchmark },
+    { "ringbuffer", "fenced ring buffer streaming, MB/s and wraparound stalls against a simulated GPU", RunRingBufferBenchmark },
+    { "rendergraph", "multi-pass frame graph culling/ordering, transient memory with and without aliasing", RunRenderGraphBenchmark },
+    { "transforms", "100k moving objects per frame, per-draw transform stream vs rewriting vertices", RunTransformBenchmark },
+    { "record",     "1080p frames through the Y4M recorder pipeline, fps/queue depth/stalls, SIMD vs scalar I420", RunRecordBenchmark },
+    { "pacer",      "frame pacer on a simulated clock, render cost, injected oversleep and a late frame", RunPacerBenchmark },
+    { "latency",    "input latency histograms from events with known delays, percentiles and per-type counts", RunLatencyBenchmark },
+};
+
+} // namespace /* anonymous */
+
+
+//-------------------------------------------------------------------------------------------------
+//      名前を指定してベンチマークを実行します.
+//-------------------------------------------------------------------------------------------------
+bool RunBenchmark( const char* name, int argc, char** argv )
+{
+    g_ArgCount = argc;
+    g_ppArgs   = argv;
+
+    const size_t count = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+    if ( name != nullptr && strcmp( name, "list" ) != 0 )
+    {
+        for( size_t i = 0; i < count; ++i )
+        {
+            if ( strcmp( BENCHMARKS[i].Name, name ) == 0 )
+            { return BENCHMARKS[i].Func(); }
+        }
+
+        ELOG( "Error : Unknown benchmark \"%s\".", name );
+    }
+
+    std::printf( "Benchmarks :\n" );
+    for( size_t i = 0; i < count; ++i )
+    { std::printf( "  %-12s : %s\n", BENCHMARKS[i].Name, BENCHMARKS[i].Desc ); }
+
+    return ( name != nullptr && strcmp( name, "list" ) == 0 );
+}
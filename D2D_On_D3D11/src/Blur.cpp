@@ -0,0 +1,720 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Blur.cpp
+// Desc : Gaussian Blur and Drop Shadow Effect.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Blur.h>
+#include <Logger.h>
+#include <Timer.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t ROW_BLOCK    = 16;       // 行単位で並列化する際の1タスクあたりの行数.
+const uint32_t COLUMN_STRIP = 64;       // 列単位で並列化する際の1タスクあたりの画素数.
+
+//-------------------------------------------------------------------------------------------------
+//      4の倍数に切り上げます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t AlignUp4( uint32_t value )
+{ return ( value + 3 ) & ~3u; }
+
+//-------------------------------------------------------------------------------------------------
+//      必要な場合のみサーフェイスを作り直します.
+//-------------------------------------------------------------------------------------------------
+bool EnsureSize( Surface& surface, uint32_t width, uint32_t height )
+{
+    if ( surface.IsValid() && surface.GetWidth() == width && surface.GetHeight() == height )
+    { return true; }
+
+    return surface.Init( width, height );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 小数部を持つ 16bit 固定小数を四捨五入して 4画素 (16byte) に詰めます.
+//-------------------------------------------------------------------------------------------------
+inline __m128i PackFixed8( __m128i lo, __m128i hi )
+{
+    const __m128i half = _mm_set1_epi16( 128 );
+    return _mm_packus_epi16( _mm_srli_epi16( _mm_add_epi16( lo, half ), 8 ), _mm_srli_epi16( _mm_add_epi16( hi, half ), 8 ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      count 画素幅 (4の倍数) の列に垂直方向のボックスブラーを1回適用します. 範囲外は透明黒です.
+//      移動和はチャンネルごとに 16bit で持つので, 窓の幅は 255 以下である必要があります.
+//-------------------------------------------------------------------------------------------------
+void BoxPass
+(
+    const uint32_t* pSrc,
+    size_t          srcPitch,
+    uint32_t*       pDst,
+    size_t          dstPitch,
+    uint32_t        count,
+    uint32_t        height,
+    int             radius
+)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const int     size  = radius * 2 + 1;
+    const __m128i scale = _mm_set1_epi16( short( uint16_t( ( 65536 + size - 1 ) / size ) ) );
+    const __m128i half  = _mm_set1_epi16( short( size / 2 ) );
+
+    if ( radius <= 0 )
+    {
+        for( uint32_t y = 0; y < height; ++y )
+        { memcpy( pDst + y * dstPitch, pSrc + y * srcPitch, count * sizeof(uint32_t) ); }
+        return;
+    }
+
+    // 4画素 = 16チャンネル分の移動和を 2 レジスタずつ持つ.
+    __m128i sum[COLUMN_STRIP / 2];
+    for( uint32_t i = 0; i < count / 2; ++i )
+    { sum[i] = zero; }
+
+    for( int y = 0; y <= radius && y < int( height ); ++y )
+    {
+        const uint32_t* pRow = pSrc + y * srcPitch;
+        for( uint32_t x = 0; x < count; x += 4 )
+        {
+            const __m128i v = _mm_load_si128( reinterpret_cast<const __m128i*>( pRow + x ) );
+            sum[x / 2 + 0] = _mm_add_epi16( sum[x / 2 + 0], _mm_unpacklo_epi8( v, zero ) );
+            sum[x / 2 + 1] = _mm_add_epi16( sum[x / 2 + 1], _mm_unpackhi_epi8( v, zero ) );
+        }
+    }
+
+    for( uint32_t y = 0; y < height; ++y )
+    {
+        const int enter = int( y ) + radius + 1;
+        const int leave = int( y ) - radius;
+        const uint32_t* pEnter = ( enter < int( height ) ) ? pSrc + enter * srcPitch : nullptr;
+        const uint32_t* pLeave = ( leave >= 0 )            ? pSrc + leave * srcPitch : nullptr;
+        uint32_t*       pRow   = pDst + y * dstPitch;
+
+        for( uint32_t x = 0; x < count; x += 4 )
+        {
+            __m128i lo = sum[x / 2 + 0];
+            __m128i hi = sum[x / 2 + 1];
+
+            const __m128i out = _mm_packus_epi16(
+                _mm_mulhi_epu16( _mm_add_epi16( lo, half ), scale ),
+                _mm_mulhi_epu16( _mm_add_epi16( hi, half ), scale ) );
+
+            if ( pEnter != nullptr )
+            {
+                const __m128i v = _mm_load_si128( reinterpret_cast<const __m128i*>( pEnter + x ) );
+                lo = _mm_add_epi16( lo, _mm_unpacklo_epi8( v, zero ) );
+                hi = _mm_add_epi16( hi, _mm_unpackhi_epi8( v, zero ) );
+            }
+            if ( pLeave != nullptr )
+            {
+                const __m128i v = _mm_load_si128( reinterpret_cast<const __m128i*>( pLeave + x ) );
+                lo = _mm_sub_epi16( lo, _mm_unpacklo_epi8( v, zero ) );
+                hi = _mm_sub_epi16( hi, _mm_unpackhi_epi8( v, zero ) );
+            }
+
+            sum[x / 2 + 0] = lo;
+            sum[x / 2 + 1] = hi;
+
+            _mm_store_si128( reinterpret_cast<__m128i*>( pRow + x ), out );
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      16bit の各要素について v * a / 255 を四捨五入で求めます.
+//-------------------------------------------------------------------------------------------------
+inline __m128i MulDiv255( __m128i v, __m128i a )
+{
+    const __m128i x = _mm_add_epi16( _mm_mullo_epi16( v, a ), _mm_set1_epi16( 128 ) );
+    return _mm_srli_epi16( _mm_add_epi16( x, _mm_srli_epi16( x, 8 ) ), 8 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      16bit に展開した2画素のアルファを各チャンネルに複製します.
+//-------------------------------------------------------------------------------------------------
+inline __m128i BroadcastAlpha( __m128i v )
+{ return _mm_shufflehi_epi16( _mm_shufflelo_epi16( v, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      1画素分の v * a / 255 を求めます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MulDiv255Pixel( uint32_t color, uint32_t alpha )
+{
+    uint32_t result = 0;
+    for( uint32_t shift = 0; shift < 32; shift += 8 )
+    {
+        const uint32_t x = ( ( color >> shift ) & 0xff ) * alpha + 128;
+        result |= ( ( x + ( x >> 8 ) ) >> 8 ) << shift;
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1行分のハッシュ値を求めます. 依存チェーンを短くするため2系列で計算します.
+//-------------------------------------------------------------------------------------------------
+uint64_t HashRow( const uint32_t* pRow, uint32_t count )
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t h0 = 0xcbf29ce484222325ull;
+    uint64_t h1 = 0x84222325cbf29ce4ull;
+
+    uint32_t i = 0;
+    for( ; i + 4 <= count; i += 4 )
+    {
+        uint64_t w[2];
+        memcpy( w, pRow + i, sizeof(w) );
+        h0 = ( h0 ^ w[0] ) * prime;
+        h1 = ( h1 ^ w[1] ) * prime;
+    }
+    for( ; i < count; ++i )
+    { h0 = ( h0 ^ pRow[i] ) * prime; }
+
+    return ( h0 ^ ( h1 >> 29 ) ^ ( h1 << 35 ) ) * prime;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ハッシュ値を結合します.
+//-------------------------------------------------------------------------------------------------
+inline uint64_t CombineHash( uint64_t seed, uint64_t value )
+{ return ( seed ^ ( value + 0x9E3779B97F4A7C15ull + ( seed << 6 ) + ( seed >> 2 ) ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ガウス分布を3回のボックスブラーで近似する際の各半径を求めます.
+//-------------------------------------------------------------------------------------------------
+void GetBoxRadii( float sigma, int radii[3] )
+{
+    const float variance = 12.0f * sigma * sigma;
+    int lower = int( std::floor( std::sqrt( variance / 3.0f + 1.0f ) ) );
+    if ( ( lower % 2 ) == 0 )
+    { lower--; }
+    if ( lower < 1 )
+    { lower = 1; }
+
+    const int upper = lower + 2;
+    const int count = int( std::floor( ( variance - 3.0f * lower * lower - 12.0f * lower - 9.0f ) / ( -4.0f * lower - 4.0f ) + 0.5f ) );
+    for( int i = 0; i < 3; ++i )
+    { radii[i] = std::min( ( ( i < count ) ? lower : upper ) / 2, 127 ); }
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BlurEffect class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+BlurEffect::BlurEffect()
+: m_pPool   ( nullptr )
+, m_Mode    ( BLUR_MODE_AUTO )
+, m_KeyValid( false )
+{
+    m_Key.Hash   = 0;
+    m_Key.Width  = 0;
+    m_Key.Height = 0;
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+BlurEffect::~BlurEffect()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      並列処理に使うスレッドプールを設定します. nullptr の場合は呼び出しスレッドで処理します.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::SetThreadPool( ThreadPool* pPool )
+{ m_pPool = pPool; }
+
+//-------------------------------------------------------------------------------------------------
+//      ブラーの方式を設定します.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::SetMode( BLUR_MODE mode )
+{
+    if ( m_Mode != mode )
+    { Invalidate(); }
+
+    m_Mode = mode;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ガウスブラーを適用します. 半径は 3σ に相当します.
+//      入力とパラメータが前回と同じ場合は前回の結果をそのまま返します.
+//-------------------------------------------------------------------------------------------------
+const Surface* BlurEffect::ApplyBlur( const Surface& source, float radius )
+{
+    if ( !source.IsValid() )
+    { return nullptr; }
+
+    const float params[3] = { 0.0f, radius, float( m_Mode ) };
+
+    m_Stats.ApplyCount++;
+    if ( CheckCache( source, params, sizeof(params) ) )
+    {
+        m_Stats.CacheHitCount++;
+        return &m_Output;
+    }
+
+    Timer timer;
+
+    if ( !EnsureSize( m_Output, source.GetWidth(), source.GetHeight() ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        m_KeyValid = false;
+        return nullptr;
+    }
+
+    Blur( source, radius, m_Output );
+
+    m_Stats.ProcessMsec += timer.GetElapsedMsec();
+    return &m_Output;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ドロップシャドウを適用します.
+//      入力のアルファを color で着色し, (offsetX, offsetY) ずらしてぼかした影の上に入力を合成します.
+//-------------------------------------------------------------------------------------------------
+const Surface* BlurEffect::ApplyShadow
+(
+    const Surface&  source,
+    float           radius,
+    const float     color[4],
+    int             offsetX,
+    int             offsetY
+)
+{
+    if ( !source.IsValid() )
+    { return nullptr; }
+
+    const float params[9] = { 1.0f, radius, float( m_Mode ), color[0], color[1], color[2], color[3], float( offsetX ), float( offsetY ) };
+
+    m_Stats.ApplyCount++;
+    if ( CheckCache( source, params, sizeof(params) ) )
+    {
+        m_Stats.CacheHitCount++;
+        return &m_Output;
+    }
+
+    Timer timer;
+
+    const uint32_t width  = source.GetWidth ();
+    const uint32_t height = source.GetHeight();
+    if ( !EnsureSize( m_Output, width, height ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        m_KeyValid = false;
+        return nullptr;
+    }
+
+    // 影の元画像を m_Output に作る.
+    const uint32_t  shadow   = Surface::PackColor( color[0], color[1], color[2], color[3] );
+    const __m128i   shadow16 = _mm_unpacklo_epi8( _mm_set1_epi32( int( shadow ) ), _mm_setzero_si128() );
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const uint32_t y1 = std::min( ( block + 1 ) * ROW_BLOCK, height );
+        for( uint32_t y = block * ROW_BLOCK; y < y1; ++y )
+        {
+            uint32_t* pDst = m_Output.GetRow( y );
+            const int sy = int( y ) - offsetY;
+            if ( sy < 0 || sy >= int( height ) )
+            {
+                memset( pDst, 0, width * sizeof(uint32_t) );
+                continue;
+            }
+
+            // 入力の範囲内にある列 [x0, x1) を求める.
+            const uint32_t* pSrc = source.GetRow( uint32_t( sy ) );
+            const int x0 = std::min( std::max( offsetX, 0 ), int( width ) );
+            const int x1 = std::max( std::min( int( width ) + offsetX, int( width ) ), x0 );
+
+            int x = 0;
+            for( ; x < x0; ++x )
+            { pDst[x] = 0; }
+
+            const __m128i zero = _mm_setzero_si128();
+            for( ; x + 4 <= x1; x += 4 )
+            {
+                const __m128i s  = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + x - offsetX ) );
+                const __m128i lo = MulDiv255( shadow16, BroadcastAlpha( _mm_unpacklo_epi8( s, zero ) ) );
+                const __m128i hi = MulDiv255( shadow16, BroadcastAlpha( _mm_unpackhi_epi8( s, zero ) ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x ), _mm_packus_epi16( lo, hi ) );
+            }
+
+            for( ; x < x1; ++x )
+            { pDst[x] = MulDiv255Pixel( shadow, pSrc[x - offsetX] >> 24 ); }
+
+            for( ; x < int( width ); ++x )
+            { pDst[x] = 0; }
+        }
+    });
+
+    // Blur() は入力を最初のパスでしか読まないので, 入出力に同じサーフェイスを指定できる.
+    Blur( m_Output, radius, m_Output );
+
+    // 入力を影の上に合成する (乗算済みアルファの over).
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16( 255 );
+
+        const uint32_t y1 = std::min( ( block + 1 ) * ROW_BLOCK, height );
+        for( uint32_t y = block * ROW_BLOCK; y < y1; ++y )
+        {
+            const uint32_t* pSrc = source.GetRow( y );
+            uint32_t*       pDst = m_Output.GetRow( y );
+
+            uint32_t x = 0;
+            for( ; x + 4 <= width; x += 4 )
+            {
+                const __m128i s = _mm_load_si128( reinterpret_cast<const __m128i*>( pSrc + x ) );
+                const __m128i d = _mm_load_si128( reinterpret_cast<const __m128i*>( pDst + x ) );
+                const __m128i lo = MulDiv255( _mm_unpacklo_epi8( d, zero ), _mm_sub_epi16( full, BroadcastAlpha( _mm_unpacklo_epi8( s, zero ) ) ) );
+                const __m128i hi = MulDiv255( _mm_unpackhi_epi8( d, zero ), _mm_sub_epi16( full, BroadcastAlpha( _mm_unpackhi_epi8( s, zero ) ) ) );
+                _mm_store_si128( reinterpret_cast<__m128i*>( pDst + x ), _mm_adds_epu8( s, _mm_packus_epi16( lo, hi ) ) );
+            }
+
+            for( ; x < width; ++x )
+            { pDst[x] = pSrc[x] + MulDiv255Pixel( pDst[x], 255 - ( pSrc[x] >> 24 ) ); }
+        }
+    });
+
+    m_Stats.ProcessMsec += timer.GetElapsedMsec();
+    return &m_Output;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュを破棄し, 次回の Apply で必ず再計算させます.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::Invalidate()
+{ m_KeyValid = false; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+BlurEffect::Stats BlurEffect::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::ResetStats()
+{
+    m_Stats.ApplyCount    = 0;
+    m_Stats.CacheHitCount = 0;
+    m_Stats.HashMsec      = 0.0;
+    m_Stats.ProcessMsec   = 0.0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入力画素とパラメータのハッシュを求め, 前回の結果を再利用できるかチェックします.
+//      ハッシュが衝突した場合は古い結果を返しますが, 64bit なので実用上は無視できます.
+//-------------------------------------------------------------------------------------------------
+bool BlurEffect::CheckCache( const Surface& source, const void* pParams, size_t paramSize )
+{
+    Timer timer;
+
+    const uint32_t width  = source.GetWidth ();
+    const uint32_t height = source.GetHeight();
+
+    m_RowHash.resize( height );
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const uint32_t y1 = std::min( ( block + 1 ) * ROW_BLOCK, height );
+        for( uint32_t y = block * ROW_BLOCK; y < y1; ++y )
+        { m_RowHash[y] = HashRow( source.GetRow( y ), width ); }
+    });
+
+    uint64_t hash = HashRow( static_cast<const uint32_t*>( pParams ), uint32_t( paramSize / sizeof(uint32_t) ) );
+    for( uint32_t y = 0; y < height; ++y )
+    { hash = CombineHash( hash, m_RowHash[y] ); }
+
+    const bool hit = m_KeyValid
+                  && m_Key.Hash   == hash
+                  && m_Key.Width  == width
+                  && m_Key.Height == height;
+
+    m_Key.Hash   = hash;
+    m_Key.Width  = width;
+    m_Key.Height = height;
+    m_KeyValid   = true;
+
+    m_Stats.HashMsec += timer.GetElapsedMsec();
+    return hit;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ブラーを適用します. source は最初のパスでのみ読み, dest は最後のパスでのみ書き込みます.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::Blur( const Surface& source, float radius, Surface& dest )
+{
+    const uint32_t width  = source.GetWidth ();
+    const uint32_t height = source.GetHeight();
+    const int      r      = int( std::ceil( radius ) );
+
+    if ( r <= 0 )
+    {
+        if ( &source != &dest )
+        {
+            for( uint32_t y = 0; y < height; ++y )
+            { memcpy( dest.GetRow( y ), source.GetRow( y ), width * sizeof(uint32_t) ); }
+        }
+        return;
+    }
+
+    // m_Temp[1] は転置した大きさで使う.
+    if ( !EnsureSize( m_Temp[0], width, height ) || !EnsureSize( m_Temp[1], height, width ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return;
+    }
+
+    const float sigma    = std::max( radius / 3.0f, 0.3f );
+    const bool  gaussian = ( m_Mode == BLUR_MODE_GAUSSIAN )
+                        || ( m_Mode == BLUR_MODE_AUTO && uint32_t( r ) <= GaussianRadiusLimit );
+
+    if ( gaussian )
+    {
+        // 重みは 16bit 固定小数 (合計 65535 以下) で持ち, 画素は 8bit 左シフトして乗算する.
+        std::vector<float> weights( size_t( r ) * 2 + 1 );
+
+        float sum = 0.0f;
+        for( int i = -r; i <= r; ++i )
+        {
+            weights[i + r] = std::exp( -float( i * i ) / ( 2.0f * sigma * sigma ) );
+            sum += weights[i + r];
+        }
+
+        m_Kernel.resize( weights.size() );
+        for( size_t i = 0; i < weights.size(); ++i )
+        { m_Kernel[i] = uint16_t( weights[i] / sum * 65535.0f ); }
+
+        GaussianH( source,    m_Temp[0], r );
+        GaussianV( m_Temp[0], dest,      r );
+    }
+    else
+    {
+        // ボックスブラーは半径によらず1画素あたりの計算量が一定.
+        // 水平方向は転置して垂直方向の処理を使い回す.
+        int radii[3];
+        GetBoxRadii( sigma, radii );
+
+        BoxV     ( source,    m_Temp[0], radii );
+        Transpose( m_Temp[0], m_Temp[1] );
+        BoxV     ( m_Temp[1], m_Temp[1], radii );
+        Transpose( m_Temp[1], dest );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      水平方向のガウスカーネルを適用します. 範囲外は透明黒として扱います.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::GaussianH( const Surface& source, Surface& dest, int radius )
+{
+    const uint32_t  width   = source.GetWidth ();
+    const uint32_t  height  = source.GetHeight();
+    const uint32_t  taps    = uint32_t( radius ) * 2 + 1;
+    const uint16_t* pKernel = m_Kernel.data();
+
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        // 両端に radius 画素の透明黒を付けた作業行. 4画素単位で読むため末尾にも余裕を持たせる.
+        std::vector<uint32_t> row( AlignUp4( width ) + taps + 4, 0 );
+
+        const uint32_t y1 = std::min( ( block + 1 ) * ROW_BLOCK, height );
+        for( uint32_t y = block * ROW_BLOCK; y < y1; ++y )
+        {
+            memcpy( &row[radius], source.GetRow( y ), width * sizeof(uint32_t) );
+
+            uint32_t* pDst = dest.GetRow( y );
+            for( uint32_t x = 0; x < width; x += 4 )
+            {
+                __m128i lo = zero;
+                __m128i hi = zero;
+                for( uint32_t k = 0; k < taps; ++k )
+                {
+                    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &row[x + k] ) );
+                    const __m128i w = _mm_set1_epi16( short( pKernel[k] ) );
+                    lo = _mm_add_epi16( lo, _mm_mulhi_epu16( _mm_unpacklo_epi8( zero, v ), w ) );
+                    hi = _mm_add_epi16( hi, _mm_mulhi_epu16( _mm_unpackhi_epi8( zero, v ), w ) );
+                }
+
+                // 行ピッチは 64byte 境界なので, 4画素単位の書き込みは行内に収まる.
+                _mm_store_si128( reinterpret_cast<__m128i*>( pDst + x ), PackFixed8( lo, hi ) );
+            }
+        }
+    });
+}
+
+//-------------------------------------------------------------------------------------------------
+//      垂直方向のガウスカーネルを適用します. 4画素ごとにレジスタ上で各行を重み付き加算します.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::GaussianV( const Surface& source, Surface& dest, int radius )
+{
+    const uint32_t  width   = source.GetWidth ();
+    const uint32_t  height  = source.GetHeight();
+    const uint16_t* pKernel = m_Kernel.data();
+
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const __m128i zero = _mm_setzero_si128();
+        std::vector<const uint32_t*> rows;
+        std::vector<uint16_t>        weights;   // 重みを 8 要素ずつ複製したもの.
+
+        const uint32_t y1 = std::min( ( block + 1 ) * ROW_BLOCK, height );
+        for( uint32_t y = block * ROW_BLOCK; y < y1; ++y )
+        {
+            // 範囲外の行は透明黒なので加算しない.
+            rows   .clear();
+            weights.clear();
+            for( int k = -radius; k <= radius; ++k )
+            {
+                const int sy = int( y ) + k;
+                if ( sy < 0 || sy >= int( height ) )
+                { continue; }
+
+                rows   .push_back( source.GetRow( uint32_t( sy ) ) );
+                weights.insert( weights.end(), 8, pKernel[k + radius] );
+            }
+
+            const size_t count = rows.size();
+            uint32_t* pDst = dest.GetRow( y );
+            for( uint32_t x = 0; x < width; x += 4 )
+            {
+                __m128i lo = zero;
+                __m128i hi = zero;
+                for( size_t k = 0; k < count; ++k )
+                {
+                    const __m128i v = _mm_load_si128( reinterpret_cast<const __m128i*>( rows[k] + x ) );
+                    const __m128i w = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &weights[k * 8] ) );
+                    lo = _mm_add_epi16( lo, _mm_mulhi_epu16( _mm_unpacklo_epi8( zero, v ), w ) );
+                    hi = _mm_add_epi16( hi, _mm_mulhi_epu16( _mm_unpackhi_epi8( zero, v ), w ) );
+                }
+
+                _mm_store_si128( reinterpret_cast<__m128i*>( pDst + x ), PackFixed8( lo, hi ) );
+            }
+        }
+    });
+}
+
+//-------------------------------------------------------------------------------------------------
+//      垂直方向のボックスブラーを3回続けて適用します.
+//      列を短冊に分けて並列化し, 短冊ごとに中間結果を作業領域に置いてキャッシュ内で3パスを済ませます.
+//      各短冊は自分の列のみを読み書きし, 最初のパスで入力を読み終えるので source と dest は同じでも構いません.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::BoxV( const Surface& source, Surface& dest, const int radii[3] )
+{
+    const uint32_t width  = source.GetWidth ();
+    const uint32_t height = source.GetHeight();
+    const uint32_t w4     = AlignUp4( width );
+    const uint32_t strips = ( w4 + COLUMN_STRIP - 1 ) / COLUMN_STRIP;
+    const size_t   area   = size_t( height ) * COLUMN_STRIP;
+
+    if ( m_Scratch.size() < area * 2 * strips )
+    { m_Scratch.resize( area * 2 * strips ); }
+
+    Dispatch( strips, [&]( uint32_t strip )
+    {
+        const uint32_t x0    = strip * COLUMN_STRIP;
+        const uint32_t count = std::min( x0 + COLUMN_STRIP, w4 ) - x0;
+        uint32_t*      pA    = &m_Scratch[area * 2 * strip];
+        uint32_t*      pB    = pA + area;
+
+        const size_t srcPitch = source.GetPitch() / sizeof(uint32_t);
+        const size_t dstPitch = dest  .GetPitch() / sizeof(uint32_t);
+
+        BoxPass( source.GetRow( 0 ) + x0, srcPitch,     pA,                     COLUMN_STRIP, count, height, radii[0] );
+        BoxPass( pA,                      COLUMN_STRIP, pB,                     COLUMN_STRIP, count, height, radii[1] );
+        BoxPass( pB,                      COLUMN_STRIP, dest.GetRow( 0 ) + x0,  dstPitch,     count, height, radii[2] );
+    });
+}
+
+//-------------------------------------------------------------------------------------------------
+//      画像を転置します. dest は source の縦横を入れ替えた大きさである必要があります.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::Transpose( const Surface& source, Surface& dest )
+{
+    const uint32_t width  = source.GetWidth ();
+    const uint32_t height = source.GetHeight();
+
+    Dispatch( ( height + ROW_BLOCK - 1 ) / ROW_BLOCK, [&]( uint32_t block )
+    {
+        const uint32_t y0 = block * ROW_BLOCK;
+        const uint32_t y1 = std::min( y0 + ROW_BLOCK, height );
+
+        uint32_t y = y0;
+        for( ; y + 4 <= y1; y += 4 )
+        {
+            const uint32_t* pRow0 = source.GetRow( y + 0 );
+            const uint32_t* pRow1 = source.GetRow( y + 1 );
+            const uint32_t* pRow2 = source.GetRow( y + 2 );
+            const uint32_t* pRow3 = source.GetRow( y + 3 );
+
+            uint32_t x = 0;
+            for( ; x + 4 <= width; x += 4 )
+            {
+                const __m128i r0 = _mm_load_si128( reinterpret_cast<const __m128i*>( pRow0 + x ) );
+                const __m128i r1 = _mm_load_si128( reinterpret_cast<const __m128i*>( pRow1 + x ) );
+                const __m128i r2 = _mm_load_si128( reinterpret_cast<const __m128i*>( pRow2 + x ) );
+                const __m128i r3 = _mm_load_si128( reinterpret_cast<const __m128i*>( pRow3 + x ) );
+
+                const __m128i t0 = _mm_unpacklo_epi32( r0, r1 );
+                const __m128i t1 = _mm_unpacklo_epi32( r2, r3 );
+                const __m128i t2 = _mm_unpackhi_epi32( r0, r1 );
+                const __m128i t3 = _mm_unpackhi_epi32( r2, r3 );
+
+                _mm_store_si128( reinterpret_cast<__m128i*>( dest.GetRow( x + 0 ) + y ), _mm_unpacklo_epi64( t0, t1 ) );
+                _mm_store_si128( reinterpret_cast<__m128i*>( dest.GetRow( x + 1 ) + y ), _mm_unpackhi_epi64( t0, t1 ) );
+                _mm_store_si128( reinterpret_cast<__m128i*>( dest.GetRow( x + 2 ) + y ), _mm_unpacklo_epi64( t2, t3 ) );
+                _mm_store_si128( reinterpret_cast<__m128i*>( dest.GetRow( x + 3 ) + y ), _mm_unpackhi_epi64( t2, t3 ) );
+            }
+
+            for( ; x < width; ++x )
+            {
+                uint32_t* pDst = dest.GetRow( x ) + y;
+                pDst[0] = pRow0[x];
+                pDst[1] = pRow1[x];
+                pDst[2] = pRow2[x];
+                pDst[3] = pRow3[x];
+            }
+        }
+
+        for( ; y < y1; ++y )
+        {
+            const uint32_t* pRow = source.GetRow( y );
+            for( uint32_t x = 0; x < width; ++x )
+            { dest.GetRow( x )[y] = pRow[x]; }
+        }
+    });
+}
+
+//-------------------------------------------------------------------------------------------------
+//      タスクをスレッドプールで並列実行します. プールが無い場合は順に実行します.
+//-------------------------------------------------------------------------------------------------
+void BlurEffect::Dispatch( uint32_t count, const std::function<void(uint32_t)>& task )
+{
+    if ( m_pPool != nullptr )
+    {
+        m_pPool->ParallelFor( count, task );
+        return;
+    }
+
+    for( uint32_t i = 0; i < count; ++i )
+    { task( i ); }
+}
@@ -0,0 +1,671 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ClipStack.cpp
+// Desc : Clip and Layer Stack with Scissor Fast Path.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <ClipStack.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const float AXIS_EPSILON = 1e-6f;       // 軸平行とみなす回転成分の許容値.
+
+//-------------------------------------------------------------------------------------------------
+//      変換行列が軸平行 (拡大縮小, 平行移動, 90度単位の回転, 反転のみ) かどうかチェックします.
+//-------------------------------------------------------------------------------------------------
+inline bool IsAxisAligned( const float m[6] )
+{
+    return ( std::fabs( m[1] ) < AXIS_EPSILON && std::fabs( m[2] ) < AXIS_EPSILON )
+        || ( std::fabs( m[0] ) < AXIS_EPSILON && std::fabs( m[3] ) < AXIS_EPSILON );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      座標を最も近い画素境界に合わせます.
+//-------------------------------------------------------------------------------------------------
+inline int Snap( float value )
+{ return int( std::floor( value + 0.5f ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      1画素の各チャンネルに a / 255 を掛けます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MulDiv255Pixel( uint32_t color, uint32_t a )
+{
+    uint32_t result = 0;
+    for( uint32_t shift = 0; shift < 32; shift += 8 )
+    {
+        const uint32_t x = ( ( color >> shift ) & 0xff ) * a + 128;
+        result |= ( ( x + ( x >> 8 ) ) >> 8 ) << shift;
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みアルファで src を dst の上に合成します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t BlendOver( uint32_t src, uint32_t dst )
+{
+    const uint32_t alpha = src >> 24;
+    if ( alpha == 255 )
+    { return src; }
+    if ( src == 0 )
+    { return dst; }
+
+    return src + MulDiv255Pixel( dst, 255 - alpha );
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ClipStack class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+ClipStack::ClipStack()
+: m_pSurface    ( nullptr )
+, m_pPool       ( nullptr )
+, m_pTarget     ( nullptr )
+, m_OriginX     ( 0 )
+, m_OriginY     ( 0 )
+, m_pMask       ( nullptr )
+, m_FastPath    ( true )
+{
+    const float identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    SetTransform( identity );
+
+    m_Scissor.Left   = 0;
+    m_Scissor.Top    = 0;
+    m_Scissor.Right  = 0;
+    m_Scissor.Bottom = 0;
+
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+ClipStack::~ClipStack()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. レイヤーのサーフェイスは pPool から取得します.
+//-------------------------------------------------------------------------------------------------
+bool ClipStack::Init( Surface* pTarget, SurfacePool* pPool )
+{
+    if ( pTarget == nullptr || pPool == nullptr || !pTarget->IsValid() )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pSurface = pTarget;
+    m_pPool    = pPool;
+    Reset();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::Term()
+{
+    if ( m_pSurface != nullptr )
+    { Reset(); }
+
+    m_FreeMasks.clear();
+    m_Masks    .clear();
+
+    m_pSurface = nullptr;
+    m_pPool    = nullptr;
+    m_pTarget  = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      積まれているクリップとレイヤーを全て破棄し, 描画先全体をシザー矩形にします.
+//      レイヤーの内容は合成されません.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::Reset()
+{
+    while( !m_Stack.empty() )
+    {
+        const Entry& entry = m_Stack.back();
+        if ( entry.OwnsMask )
+        { m_FreeMasks.push_back( m_pMask ); }
+        if ( entry.pLayer != nullptr )
+        { m_pPool->Release( entry.pLayer ); }
+
+        m_pMask = entry.pMask;
+        m_Stack.pop_back();
+    }
+
+    m_pTarget        = m_pSurface;
+    m_OriginX        = 0;
+    m_OriginY        = 0;
+    m_pMask          = nullptr;
+    m_Scissor.Left   = 0;
+    m_Scissor.Top    = 0;
+    m_Scissor.Right  = ( m_pSurface != nullptr ) ? int( m_pSurface->GetWidth () ) : 0;
+    m_Scissor.Bottom = ( m_pSurface != nullptr ) ? int( m_pSurface->GetHeight() ) : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      軸平行なクリップをシザー矩形で処理するかどうか設定します.
+//      無効にすると全てのクリップでマスクを生成します (比較用).
+//-------------------------------------------------------------------------------------------------
+void ClipStack::SetScissorFastPath( bool enable )
+{ m_FastPath = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      以降に積むクリップの変換行列を設定します. 要素の並びは D2D1_MATRIX_3X2_F と同じです.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::SetTransform( const float matrix[6] )
+{
+    for( int i = 0; i < 6; ++i )
+    { m_Transform[i] = matrix[i]; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      矩形クリップを積みます.
+//      変換が軸平行な場合は画素境界に合わせたシザー矩形との共通部分を取るだけで, メモリを確保しません.
+//      それ以外の場合は変換後の四角形からカバレッジマスクを生成します.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PushAxisAlignedClip( float left, float top, float right, float bottom )
+{
+    m_Stats.ClipCount++;
+
+    const float* m = m_Transform;
+    if ( m_FastPath && IsAxisAligned( m ) )
+    {
+        const float x0 = left  * m[0] + top    * m[2] + m[4];
+        const float y0 = left  * m[1] + top    * m[3] + m[5];
+        const float x1 = right * m[0] + bottom * m[2] + m[4];
+        const float y1 = right * m[1] + bottom * m[3] + m[5];
+
+        ClipRect rect;
+        rect.Left   = Snap( std::min( x0, x1 ) );
+        rect.Top    = Snap( std::min( y0, y1 ) );
+        rect.Right  = Snap( std::max( x0, x1 ) );
+        rect.Bottom = Snap( std::max( y0, y1 ) );
+
+        // 既にマスクがある場合もマスクはそのまま使い, シザー矩形だけを狭める.
+        PushEntry( ENTRY_TYPE_CLIP );
+        m_Scissor = Intersect( m_Scissor, rect );
+        m_Stats.ScissorCount++;
+        return;
+    }
+
+    const float corners[8] = {
+        left,  top,
+        right, top,
+        right, bottom,
+        left,  bottom,
+    };
+
+    m_Points.resize( 8 );
+    for( int i = 0; i < 4; ++i )
+    {
+        const float x = corners[i * 2 + 0];
+        const float y = corners[i * 2 + 1];
+        m_Points[i * 2 + 0] = x * m[0] + y * m[2] + m[4];
+        m_Points[i * 2 + 1] = x * m[1] + y * m[3] + m[5];
+    }
+
+    PushMask();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      任意の多角形クリップ (非ゼロ規則) を積みます. pPoints は x, y を count 組並べたものです.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PushPolygonClip( const float* pPoints, uint32_t count )
+{
+    m_Stats.ClipCount++;
+
+    const float* m = m_Transform;
+    m_Points.resize( size_t( count ) * 2 );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const float x = pPoints[i * 2 + 0];
+        const float y = pPoints[i * 2 + 1];
+        m_Points[i * 2 + 0] = x * m[0] + y * m[2] + m[4];
+        m_Points[i * 2 + 1] = x * m[1] + y * m[3] + m[5];
+    }
+
+    PushMask();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      クリップを取り除きます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PopClip()
+{
+    if ( m_Stack.empty() || m_Stack.back().Type != ENTRY_TYPE_CLIP )
+    {
+        ELOG( "Error : PopClip() does not match the top of the stack." );
+        return;
+    }
+
+    const Entry entry = m_Stack.back();
+    m_Stack.pop_back();
+
+    if ( entry.OwnsMask )
+    { m_FreeMasks.push_back( m_pMask ); }
+
+    m_Scissor = entry.Scissor;
+    m_pMask   = entry.pMask;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レイヤーを積みます. 現在のシザー矩形の大きさのサーフェイスをプールから取得し,
+//      PopLayer() までの描画はそこに行います.
+//-------------------------------------------------------------------------------------------------
+bool ClipStack::PushLayer( float opacity )
+{
+    PushEntry( ENTRY_TYPE_LAYER );
+    m_Stack.back().Opacity = std::min( std::max( opacity, 0.0f ), 1.0f );
+    m_Stats.LayerCount++;
+
+    // 見えないレイヤーはサーフェイスを取得しない. シザー矩形が空なので描画も全て省かれる.
+    if ( m_Scissor.IsEmpty() )
+    { return true; }
+
+    const uint32_t width  = uint32_t( m_Scissor.Right  - m_Scissor.Left );
+    const uint32_t height = uint32_t( m_Scissor.Bottom - m_Scissor.Top  );
+
+    Surface* pLayer = m_pPool->Acquire( width, height );
+    if ( pLayer == nullptr )
+    {
+        ELOG( "Error : SurfacePool::Acquire() Failed." );
+        m_Stack.pop_back();
+        return false;
+    }
+
+    for( uint32_t y = 0; y < height; ++y )
+    { std::fill( pLayer->GetRow( y ), pLayer->GetRow( y ) + width, 0u ); }
+
+    m_Stack.back().pLayer = pLayer;
+    m_pTarget = pLayer;
+    m_OriginX = m_Scissor.Left;
+    m_OriginY = m_Scissor.Top;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レイヤーを取り除き, 不透明度を掛けて1つ下の描画先に合成します.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PopLayer()
+{
+    if ( m_Stack.empty() || m_Stack.back().Type != ENTRY_TYPE_LAYER )
+    {
+        ELOG( "Error : PopLayer() does not match the top of the stack." );
+        return;
+    }
+
+    const Entry entry = m_Stack.back();
+    m_Stack.pop_back();
+
+    if ( entry.pLayer != nullptr )
+    {
+        // レイヤーへの描画時にクリップは適用済みなので, 合成時はマスクを使わない.
+        const ClipRect& bounds  = entry.Scissor;
+        const uint32_t  opacity = uint32_t( entry.Opacity * 255.0f + 0.5f );
+        const int       width   = bounds.Right - bounds.Left;
+
+        for( int y = bounds.Top; y < bounds.Bottom; ++y )
+        {
+            const uint32_t* pSrc = entry.pLayer->GetRow( uint32_t( y - bounds.Top ) );
+            uint32_t*       pDst = entry.pTarget->GetRow( uint32_t( y - entry.OriginY ) ) + ( bounds.Left - entry.OriginX );
+
+            for( int x = 0; x < width; ++x )
+            {
+                const uint32_t src = ( opacity == 255 ) ? pSrc[x] : MulDiv255Pixel( pSrc[x], opacity );
+                pDst[x] = BlendOver( src, pDst[x] );
+            }
+        }
+
+        m_pPool->Release( entry.pLayer );
+    }
+
+    m_pTarget = entry.pTarget;
+    m_OriginX = entry.OriginX;
+    m_OriginY = entry.OriginY;
+    m_Scissor = entry.Scissor;
+    m_pMask   = entry.pMask;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デバイス座標の矩形を乗算済み B8G8R8A8 の単色で塗りつぶします. 現在のクリップが適用されます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::FillRect( const ClipRect& rect, uint32_t color )
+{
+    const ClipRect r = Intersect( rect, m_Scissor );
+    if ( r.IsEmpty() || m_pTarget == nullptr )
+    { return; }
+
+    const int width = r.Right - r.Left;
+    for( int y = r.Top; y < r.Bottom; ++y )
+    {
+        uint32_t* pDst = m_pTarget->GetRow( uint32_t( y - m_OriginY ) ) + ( r.Left - m_OriginX );
+
+        if ( m_pMask == nullptr )
+        {
+            if ( ( color >> 24 ) == 255 )
+            { std::fill( pDst, pDst + width, color ); }
+            else
+            {
+                for( int x = 0; x < width; ++x )
+                { pDst[x] = BlendOver( color, pDst[x] ); }
+            }
+            continue;
+        }
+
+        // シザー矩形はマスクの範囲内に収まっている.
+        const uint8_t* pCoverage = m_pMask->GetRow( y ) + ( r.Left - m_pMask->Bounds.Left );
+        for( int x = 0; x < width; ++x )
+        {
+            const uint32_t coverage = pCoverage[x];
+            if ( coverage == 0 )
+            { continue; }
+
+            const uint32_t src = ( coverage == 255 ) ? color : MulDiv255Pixel( color, coverage );
+            pDst[x] = BlendOver( src, pDst[x] );
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デバイス座標 (x, y) から count 画素分の乗算済み B8G8R8A8 を合成します. 現在のクリップが適用されます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::BlendSpan( int x, int y, uint32_t count, const uint32_t* pSrc )
+{
+    if ( y < m_Scissor.Top || y >= m_Scissor.Bottom || m_pTarget == nullptr )
+    { return; }
+
+    const int x0 = std::max( x, m_Scissor.Left );
+    const int x1 = std::min( x + int( count ), m_Scissor.Right );
+    if ( x0 >= x1 )
+    { return; }
+
+    uint32_t*       pDst      = m_pTarget->GetRow( uint32_t( y - m_OriginY ) ) + ( x0 - m_OriginX );
+    const uint32_t* pSpan     = pSrc + ( x0 - x );
+    const uint8_t*  pCoverage = ( m_pMask != nullptr ) ? m_pMask->GetRow( y ) + ( x0 - m_pMask->Bounds.Left ) : nullptr;
+
+    for( int i = 0; i < x1 - x0; ++i )
+    {
+        uint32_t src = pSpan[i];
+        if ( pCoverage != nullptr && pCoverage[i] != 255 )
+        { src = MulDiv255Pixel( src, pCoverage[i] ); }
+
+        pDst[i] = BlendOver( src, pDst[i] );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在のシザー矩形を取得します.
+//-------------------------------------------------------------------------------------------------
+ClipRect ClipStack::GetScissor() const
+{ return m_Scissor; }
+
+//-------------------------------------------------------------------------------------------------
+//      スタックの深さを取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t ClipStack::GetDepth() const
+{ return uint32_t( m_Stack.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+ClipStack::Stats ClipStack::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします. 確保済みのマスクのサイズは維持します.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::ResetStats()
+{
+    m_Stats.ClipCount      = 0;
+    m_Stats.ScissorCount   = 0;
+    m_Stats.MaskCount      = 0;
+    m_Stats.MaskAllocCount = 0;
+    m_Stats.LayerCount     = 0;
+    m_Stats.MaxDepth       = 0;
+
+    m_Stats.MaskBytes = 0;
+    for( size_t i = 0; i < m_Masks.size(); ++i )
+    { m_Stats.MaskBytes += m_Masks[i]->Coverage.capacity(); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在の状態を保存したエントリを積みます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PushEntry( ENTRY_TYPE type )
+{
+    Entry entry;
+    entry.Type     = type;
+    entry.Scissor  = m_Scissor;
+    entry.pMask    = m_pMask;
+    entry.OwnsMask = false;
+    entry.pTarget  = m_pTarget;
+    entry.OriginX  = m_OriginX;
+    entry.OriginY  = m_OriginY;
+    entry.pLayer   = nullptr;
+    entry.Opacity  = 1.0f;
+
+    m_Stack.push_back( entry );
+    m_Stats.MaxDepth = std::max( m_Stats.MaxDepth, uint32_t( m_Stack.size() ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      m_Points の多角形からマスクを生成して積みます. 親のマスクがある場合は掛け合わせます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::PushMask()
+{
+    PushEntry( ENTRY_TYPE_CLIP );
+
+    if ( m_Points.size() < 6 )
+    {
+        m_Scissor.Right  = m_Scissor.Left;
+        m_Scissor.Bottom = m_Scissor.Top;
+        return;
+    }
+
+    float minX = m_Points[0], maxX = m_Points[0];
+    float minY = m_Points[1], maxY = m_Points[1];
+    for( size_t i = 2; i < m_Points.size(); i += 2 )
+    {
+        minX = std::min( minX, m_Points[i + 0] );
+        maxX = std::max( maxX, m_Points[i + 0] );
+        minY = std::min( minY, m_Points[i + 1] );
+        maxY = std::max( maxY, m_Points[i + 1] );
+    }
+
+    ClipRect bounds;
+    bounds.Left   = int( std::floor( minX ) );
+    bounds.Top    = int( std::floor( minY ) );
+    bounds.Right  = int( std::ceil ( maxX ) );
+    bounds.Bottom = int( std::ceil ( maxY ) );
+    bounds = Intersect( bounds, m_Scissor );
+
+    // 見えないクリップはマスクを作らず, 以降の描画を全て省く.
+    if ( bounds.IsEmpty() )
+    {
+        m_Scissor = bounds;
+        return;
+    }
+
+    Mask* pMask = AcquireMask( bounds );
+    Rasterize( *pMask );
+    m_Stats.MaskCount++;
+
+    // 子のマスクの範囲は親のマスクの範囲に含まれる.
+    if ( m_pMask != nullptr )
+    {
+        const size_t width = size_t( bounds.Right - bounds.Left );
+        for( int y = bounds.Top; y < bounds.Bottom; ++y )
+        {
+            uint8_t*       pDst    = &pMask->Coverage[size_t( y - bounds.Top ) * width];
+            const uint8_t* pParent = m_pMask->GetRow( y ) + ( bounds.Left - m_pMask->Bounds.Left );
+            for( size_t x = 0; x < width; ++x )
+            { pDst[x] = uint8_t( ( uint32_t( pDst[x] ) * pParent[x] + 127 ) / 255 ); }
+        }
+    }
+
+    m_Stack.back().OwnsMask = true;
+    m_pMask   = pMask;
+    m_Scissor = bounds;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      マスクを取得します. 解放済みのもので容量が足りるものがあれば再利用します.
+//-------------------------------------------------------------------------------------------------
+ClipStack::Mask* ClipStack::AcquireMask( const ClipRect& bounds )
+{
+    const size_t size = size_t( bounds.Right - bounds.Left ) * size_t( bounds.Bottom - bounds.Top );
+
+    size_t best = m_FreeMasks.size();
+    for( size_t i = 0; i < m_FreeMasks.size(); ++i )
+    {
+        const size_t capacity = m_FreeMasks[i]->Coverage.capacity();
+        if ( capacity < size )
+        { continue; }
+
+        if ( best == m_FreeMasks.size() || capacity < m_FreeMasks[best]->Coverage.capacity() )
+        { best = i; }
+    }
+
+    Mask* pMask = nullptr;
+    if ( best != m_FreeMasks.size() )
+    {
+        pMask = m_FreeMasks[best];
+        m_FreeMasks[best] = m_FreeMasks.back();
+        m_FreeMasks.pop_back();
+    }
+    else
+    {
+        std::unique_ptr<Mask> mask( new Mask() );
+        mask->Coverage.reserve( size );
+        pMask = mask.get();
+        m_Masks.push_back( std::move( mask ) );
+
+        m_Stats.MaskAllocCount++;
+        m_Stats.MaskBytes += size;
+    }
+
+    pMask->Bounds = bounds;
+    pMask->Coverage.resize( size );
+    return pMask;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      m_Points の多角形を非ゼロ規則でラスタライズします.
+//      1画素あたり SubSamples 本の走査線を取り, 水平方向は交点の位置から面積を求めます.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::Rasterize( Mask& mask )
+{
+    const ClipRect& bounds = mask.Bounds;
+    const int       width  = bounds.Right  - bounds.Left;
+    const int       height = bounds.Bottom - bounds.Top;
+    const uint32_t  count  = uint32_t( m_Points.size() / 2 );
+    const float     step   = 1.0f / float( SubSamples );
+
+    // 前半は端の画素への直接の加算, 後半は完全に覆われた画素の差分配列.
+    m_Accum.resize( size_t( width + 1 ) * 2 );
+    float* pDirect = m_Accum.data();
+    float* pDelta  = pDirect + width + 1;
+
+    for( int y = 0; y < height; ++y )
+    {
+        std::fill( m_Accum.begin(), m_Accum.end(), 0.0f );
+
+        for( int s = 0; s < SubSamples; ++s )
+        {
+            const float sy = float( bounds.Top + y ) + ( float( s ) + 0.5f ) * step;
+
+            m_Crossings.clear();
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                const uint32_t j  = ( i + 1 == count ) ? 0 : i + 1;
+                const float    x0 = m_Points[i * 2 + 0];
+                const float    y0 = m_Points[i * 2 + 1];
+                const float    x1 = m_Points[j * 2 + 0];
+                const float    y1 = m_Points[j * 2 + 1];
+                if ( ( y0 <= sy ) == ( y1 <= sy ) )
+                { continue; }
+
+                Crossing crossing;
+                crossing.X       = x0 + ( sy - y0 ) * ( x1 - x0 ) / ( y1 - y0 );
+                crossing.Winding = ( y1 > y0 ) ? 1 : -1;
+                m_Crossings.push_back( crossing );
+            }
+
+            std::sort( m_Crossings.begin(), m_Crossings.end() );
+
+            int   winding = 0;
+            float start   = 0.0f;
+            for( size_t i = 0; i < m_Crossings.size(); ++i )
+            {
+                const int prev = winding;
+                winding += m_Crossings[i].Winding;
+
+                if ( prev == 0 && winding != 0 )
+                { start = m_Crossings[i].X; }
+                else if ( prev != 0 && winding == 0 )
+                { AddSpan( start, m_Crossings[i].X, bounds ); }
+            }
+        }
+
+        uint8_t* pRow = &mask.Coverage[size_t( y ) * size_t( width )];
+        float    run  = 0.0f;
+        for( int x = 0; x < width; ++x )
+        {
+            run += pDelta[x];
+            const float coverage = std::min( run + pDirect[x], 1.0f );
+            pRow[x] = uint8_t( coverage * 255.0f + 0.5f );
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1本の走査線上の区間 [x0, x1) を m_Accum に加算します.
+//-------------------------------------------------------------------------------------------------
+void ClipStack::AddSpan( float x0, float x1, const ClipRect& bounds )
+{
+    const int   width  = bounds.Right - bounds.Left;
+    const float weight = 1.0f / float( SubSamples );
+
+    x0 = std::max( x0, float( bounds.Left  ) ) - float( bounds.Left );
+    x1 = std::min( x1, float( bounds.Right ) ) - float( bounds.Left );
+    if ( x0 >= x1 )
+    { return; }
+
+    float* pDirect = m_Accum.data();
+    float* pDelta  = pDirect + width + 1;
+
+    const int i0 = int( x0 );
+    const int i1 = int( x1 );
+    if ( i0 == i1 )
+    {
+        pDirect[i0] += ( x1 - x0 ) * weight;
+        return;
+    }
+
+    pDirect[i0]     += ( float( i0 + 1 ) - x0 ) * weight;
+    pDelta [i0 + 1] += weight;
+    pDelta [i1]     -= weight;
+    if ( i1 < width )
+    { pDirect[i1] += ( x1 - float( i1 ) ) * weight; }
+}
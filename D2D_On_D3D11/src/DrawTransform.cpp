@@ -0,0 +1,111 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : DrawTransform.cpp
+// Desc : Per-Draw Transform and Color Constants.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <DrawTransform.h>
+#include <emmintrin.h>
+#include <cmath>
+
+
+//-------------------------------------------------------------------------------------------------
+//      恒等変換と白色を設定します.
+//-------------------------------------------------------------------------------------------------
+void SetIdentityTransform( DrawTransform& result )
+{ SetDrawTransform( result, 0.0f, 0.0f, 0.0f, 1.0f, nullptr ); }
+
+//-------------------------------------------------------------------------------------------------
+//      XY 平面の拡大・回転・平行移動を設定します.
+//-------------------------------------------------------------------------------------------------
+void SetDrawTransform
+(
+    DrawTransform&  result,
+    float           x,
+    float           y,
+    float           rotation,
+    float           scale,
+    const float*    pColor
+)
+{
+    const float c = ( rotation == 0.0f ) ? scale : cosf( rotation ) * scale;
+    const float s = ( rotation == 0.0f ) ? 0.0f  : sinf( rotation ) * scale;
+
+    result.Row0[0] = c;    result.Row0[1] = -s;   result.Row0[2] = 0.0f; result.Row0[3] = x;
+    result.Row1[0] = s;    result.Row1[1] = c;    result.Row1[2] = 0.0f; result.Row1[3] = y;
+    result.Row2[0] = 0.0f; result.Row2[1] = 0.0f; result.Row2[2] = 1.0f; result.Row2[3] = 0.0f;
+
+    for( uint32_t i = 0; i < 4; ++i )
+    { result.Color[i] = ( pColor != nullptr ) ? pColor[i] : 1.0f; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      頂点に描画ごとの変換と色を適用します. 行列を列ごとにまとめておき, 1 頂点を
+//      4 回の積和で変換します. 加算の順序はスカラー版と同じです.
+//-------------------------------------------------------------------------------------------------
+void TransformVertices
+(
+    const MeshVertex*       pSrc,
+    size_t                  count,
+    const DrawTransform&    transform,
+    MeshVertex*             pDst
+)
+{
+    if ( pSrc == nullptr || pDst == nullptr )
+    { return; }
+
+    const __m128 col0 = _mm_setr_ps( transform.Row0[0], transform.Row1[0], transform.Row2[0], 0.0f );
+    const __m128 col1 = _mm_setr_ps( transform.Row0[1], transform.Row1[1], transform.Row2[1], 0.0f );
+    const __m128 col2 = _mm_setr_ps( transform.Row0[2], transform.Row1[2], transform.Row2[2], 0.0f );
+    const __m128 col3 = _mm_setr_ps( transform.Row0[3], transform.Row1[3], transform.Row2[3], 0.0f );
+    const __m128 tint = _mm_loadu_ps( transform.Color );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        // Position[3] の直後は Color[0] なので, 4 要素まとめて読み込める.
+        const __m128 p = _mm_loadu_ps( pSrc[i].Position );
+        const __m128 c = _mm_loadu_ps( pSrc[i].Color );
+
+        __m128 r = _mm_mul_ps( col0, _mm_shuffle_ps( p, p, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( col1, _mm_shuffle_ps( p, p, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( col2, _mm_shuffle_ps( p, p, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+        r = _mm_add_ps( r, col3 );
+
+        // 4 要素目は Color[0] にはみ出すが, 直後に色で上書きする.
+        _mm_storeu_ps( pDst[i].Position, r );
+        _mm_storeu_ps( pDst[i].Color,    _mm_mul_ps( c, tint ) );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      TransformVertices() のスカラー版です.
+//-------------------------------------------------------------------------------------------------
+void TransformVertices_Scalar
+(
+    const MeshVertex*       pSrc,
+    size_t                  count,
+    const DrawTransform&    transform,
+    MeshVertex*             pDst
+)
+{
+    if ( pSrc == nullptr || pDst == nullptr )
+    { return; }
+
+    const float* rows[3] = { transform.Row0, transform.Row1, transform.Row2 };
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        const float x = pSrc[i].Position[0];
+        const float y = pSrc[i].Position[1];
+        const float z = pSrc[i].Position[2];
+
+        for( uint32_t j = 0; j < 3; ++j )
+        { pDst[i].Position[j] = rows[j][0] * x + rows[j][1] * y + rows[j][2] * z + rows[j][3]; }
+
+        for( uint32_t j = 0; j < 4; ++j )
+        { pDst[i].Color[j] = pSrc[i].Color[j] * transform.Color[j]; }
+    }
+}
@@ -0,0 +1,1335 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FontFace.cpp
+// Desc : TrueType / OpenType Font Face.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <FontFace.h>
+#include <Logger.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  MAX_COMPOSITE_DEPTH = 8;        // 複合グリフの入れ子の上限.
+const uint32_t  MAX_SUBR_DEPTH      = 10;       // Type2 サブルーチン呼び出しの入れ子の上限 (仕様).
+const uint32_t  MAX_DICT_OPERANDS   = 48;
+
+const uint32_t  FLAG_ON_CURVE       = 0x01;     // glyf : 曲線上の点.
+const uint32_t  FLAG_X_SHORT        = 0x02;     // glyf : X は 1 バイト.
+const uint32_t  FLAG_Y_SHORT        = 0x04;     // glyf : Y は 1 バイト.
+const uint32_t  FLAG_REPEAT         = 0x08;     // glyf : 次のバイトが繰り返し回数.
+const uint32_t  FLAG_X_SAME         = 0x10;     // glyf : X が前と同じ, または 1 バイトの符号が正.
+const uint32_t  FLAG_Y_SAME         = 0x20;     // glyf : Y が前と同じ, または 1 バイトの符号が正.
+
+const uint32_t  COMPONENT_ARG_WORDS     = 0x0001;   // 引数が 2 バイト.
+const uint32_t  COMPONENT_XY_VALUES     = 0x0002;   // 引数がオフセット (そうでなければ点の番号).
+const uint32_t  COMPONENT_SCALE         = 0x0008;
+const uint32_t  COMPONENT_MORE          = 0x0020;
+const uint32_t  COMPONENT_XY_SCALE      = 0x0040;
+const uint32_t  COMPONENT_TWO_BY_TWO    = 0x0080;
+
+const uint32_t  DICT_CHAR_STRINGS   = 17;
+const uint32_t  DICT_PRIVATE        = 18;
+const uint32_t  DICT_SUBRS          = 19;
+const uint32_t  DICT_ROS            = 0x0c00 | 30;
+const uint32_t  DICT_FD_ARRAY       = 0x0c00 | 36;
+const uint32_t  DICT_FD_SELECT      = 0x0c00 | 37;
+
+const float     IDENTITY[6]         = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+
+//-------------------------------------------------------------------------------------------------
+//      ビッグエンディアンの値を読み取ります.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t ReadU16( const uint8_t* p )
+{ return ( uint32_t( p[0] ) << 8 ) | p[1]; }
+
+inline int32_t ReadS16( const uint8_t* p )
+{ return int16_t( ReadU16( p ) ); }
+
+inline uint32_t ReadU32( const uint8_t* p )
+{ return ( uint32_t( p[0] ) << 24 ) | ( uint32_t( p[1] ) << 16 ) | ( uint32_t( p[2] ) << 8 ) | p[3]; }
+
+inline uint32_t ReadOffset( const uint8_t* p, uint32_t size )
+{
+    uint32_t result = 0;
+    for( uint32_t i = 0; i < size; ++i )
+    { result = ( result << 8 ) | p[i]; }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      4 文字のタグを生成します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MakeTag( char a, char b, char c, char d )
+{ return ( uint32_t( uint8_t( a ) ) << 24 ) | ( uint32_t( uint8_t( b ) ) << 16 ) | ( uint32_t( uint8_t( c ) ) << 8 ) | uint8_t( d ); }
+
+//-------------------------------------------------------------------------------------------------
+//      [pos, pos + length) がファイルに収まるかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+inline bool InRange( uint32_t size, uint64_t pos, uint64_t length )
+{ return pos + length <= size; }
+
+//-------------------------------------------------------------------------------------------------
+//      Type2 サブルーチン番号のバイアスを求めます.
+//-------------------------------------------------------------------------------------------------
+inline int32_t GetSubrBias( uint32_t count )
+{
+    if ( count < 1240 )
+    { return 107; }
+    if ( count < 33900 )
+    { return 1131; }
+    return 32768;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      変換行列を適用して輪郭に点を追加します.
+//-------------------------------------------------------------------------------------------------
+inline void AddPoint( GlyphOutline& outline, const float m[6], float x, float y )
+{
+    outline.Points.push_back( x * m[0] + y * m[2] + m[4] );
+    outline.Points.push_back( x * m[1] + y * m[3] + m[5] );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      CFF の DICT から指定した演算子の引数を探します.
+//-------------------------------------------------------------------------------------------------
+bool FindDictOperator( const uint8_t* p, const uint8_t* pEnd, uint32_t op, double* pOperands, uint32_t& count )
+{
+    count = 0;
+    while( p < pEnd )
+    {
+        const uint32_t b0 = *p++;
+        if ( b0 <= 21 )
+        {
+            uint32_t code = b0;
+            if ( b0 == 12 )
+            {
+                if ( p >= pEnd )
+                { return false; }
+                code = 0x0c00 | *p++;
+            }
+
+            if ( code == op )
+            { return true; }
+
+            count = 0;
+            continue;
+        }
+
+        double value = 0.0;
+        if ( b0 == 28 )
+        {
+            if ( pEnd - p < 2 )
+            { return false; }
+            value = ReadS16( p );
+            p += 2;
+        }
+        else if ( b0 == 29 )
+        {
+            if ( pEnd - p < 4 )
+            { return false; }
+            value = int32_t( ReadU32( p ) );
+            p += 4;
+        }
+        else if ( b0 == 30 )
+        {
+            // 実数は 4bit ごとの 10 進表記.
+            static const char* nibbles[16] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ".", "E", "E-", "", "-", "" };
+            char text[64] = {};
+            size_t length = 0;
+            bool   done   = false;
+            while( !done && p < pEnd )
+            {
+                const uint32_t byte = *p++;
+                for( uint32_t shift = 4; ; shift -= 4 )
+                {
+                    const uint32_t nibble = ( byte >> shift ) & 0xf;
+                    if ( nibble == 0xf )
+                    {
+                        done = true;
+                        break;
+                    }
+                    const size_t n = strlen( nibbles[nibble] );
+                    if ( length + n < sizeof(text) )
+                    {
+                        memcpy( text + length, nibbles[nibble], n );
+                        length += n;
+                    }
+                    if ( shift == 0 )
+                    { break; }
+                }
+            }
+            value = strtod( text, nullptr );
+        }
+        else if ( 32 <= b0 && b0 <= 246 )
+        { value = int32_t( b0 ) - 139; }
+        else if ( 247 <= b0 && b0 <= 254 )
+        {
+            if ( p >= pEnd )
+            { return false; }
+            const int32_t magnitude = int32_t( b0 - ( ( b0 <= 250 ) ? 247 : 251 ) ) * 256 + *p++ + 108;
+            value = ( b0 <= 250 ) ? magnitude : -magnitude;
+        }
+        else
+        { return false; }
+
+        if ( count < MAX_DICT_OPERANDS )
+        { pOperands[count++] = value; }
+    }
+
+    return false;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FontFace class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+FontFace::FontFace()
+: m_pData       ( nullptr )
+, m_Size        ( 0 )
+, m_CmapPos     ( 0 )
+, m_CmapFormat  ( 0 )
+, m_MetricCount ( 0 )
+, m_LocaFormat  ( 0 )
+, m_FDSelectPos ( 0 )
+{
+    memset( &m_Head,        0, sizeof(m_Head) );
+    memset( &m_Hhea,        0, sizeof(m_Hhea) );
+    memset( &m_Hmtx,        0, sizeof(m_Hmtx) );
+    memset( &m_Loca,        0, sizeof(m_Loca) );
+    memset( &m_Glyf,        0, sizeof(m_Glyf) );
+    memset( &m_Cff,         0, sizeof(m_Cff) );
+    memset( &m_Metrics,     0, sizeof(m_Metrics) );
+    memset( &m_CharStrings, 0, sizeof(m_CharStrings) );
+    memset( &m_GlobalSubrs, 0, sizeof(m_GlobalSubrs) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+FontFace::~FontFace()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. フォントファイル (TTF, OTF, TTC) をメモリにマップして, テーブルの位置だけを
+//      読み取ります. 文字の対応付けと輪郭はマップしたデータから必要になった時に直接デコードします.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::Init( const char* path, uint32_t faceIndex )
+{
+    Term();
+
+    if ( !m_File.Open( path ) )
+    {
+        ELOG( "Error : MappedFile::Open() Failed." );
+        return false;
+    }
+
+    if ( m_File.GetSize() > 0xffffffffu )
+    {
+        ELOG( "Error : Font file is too large. path = %s", path );
+        Term();
+        return false;
+    }
+
+    m_pData = m_File.GetData();
+    m_Size  = uint32_t( m_File.GetSize() );
+
+    if ( !ParseTables( faceIndex ) )
+    {
+        ELOG( "Error : FontFace::ParseTables() Failed. path = %s", path );
+        Term();
+        return false;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void FontFace::Term()
+{
+    m_File.Close();
+    std::vector<CffIndex>().swap( m_LocalSubrs );
+
+    m_pData       = nullptr;
+    m_Size        = 0;
+    m_CmapPos     = 0;
+    m_CmapFormat  = 0;
+    m_MetricCount = 0;
+    m_LocaFormat  = 0;
+    m_FDSelectPos = 0;
+    memset( &m_Cff,     0, sizeof(m_Cff) );
+    memset( &m_Metrics, 0, sizeof(m_Metrics) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      読み込み済みかどうかを取得します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::IsValid() const
+{ return m_pData != nullptr; }
+
+//-------------------------------------------------------------------------------------------------
+//      輪郭が CFF (3 次ベジェ曲線) で記述されているかどうかを取得します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::IsCFF() const
+{ return m_Cff.Length > 0; }
+
+//-------------------------------------------------------------------------------------------------
+//      文字コード (UTF-32) に対応するグリフ番号を取得します. 対応が無い場合は 0 (.notdef) です.
+//-------------------------------------------------------------------------------------------------
+uint32_t FontFace::GetGlyphIndex( uint32_t codePoint ) const
+{
+    if ( m_CmapPos == 0 )
+    { return 0; }
+
+    const uint8_t* p = m_pData + m_CmapPos;
+    uint32_t glyph = 0;
+
+    if ( m_CmapFormat == 4 )
+    {
+        if ( codePoint > 0xffff )
+        { return 0; }
+
+        const uint32_t segX2    = ReadU16( p + 6 );
+        const uint32_t segCount = segX2 / 2;
+        const uint32_t ends     = m_CmapPos + 14;
+        const uint32_t starts   = ends   + segX2 + 2;
+        const uint32_t deltas   = starts + segX2;
+        const uint32_t ranges   = deltas + segX2;
+
+        // endCode が codePoint 以上になる最初の区間を探す.
+        uint32_t lo = 0;
+        uint32_t hi = segCount;
+        while( lo < hi )
+        {
+            const uint32_t mid = ( lo + hi ) / 2;
+            if ( ReadU16( m_pData + ends + mid * 2 ) < codePoint )
+            { lo = mid + 1; }
+            else
+            { hi = mid; }
+        }
+        if ( lo >= segCount )
+        { return 0; }
+
+        const uint32_t start = ReadU16( m_pData + starts + lo * 2 );
+        if ( codePoint < start )
+        { return 0; }
+
+        const uint32_t delta  = ReadU16( m_pData + deltas + lo * 2 );
+        const uint32_t offset = ReadU16( m_pData + ranges + lo * 2 );
+        if ( offset == 0 )
+        { glyph = ( codePoint + delta ) & 0xffff; }
+        else
+        {
+            const uint32_t pos = ranges + lo * 2 + offset + ( codePoint - start ) * 2;
+            if ( !InRange( m_Size, pos, 2 ) )
+            { return 0; }
+
+            glyph = ReadU16( m_pData + pos );
+            if ( glyph != 0 )
+            { glyph = ( glyph + delta ) & 0xffff; }
+        }
+    }
+    else if ( m_CmapFormat == 12 )
+    {
+        const uint32_t groups = ReadU32( p + 12 );
+        const uint8_t* pGroup = p + 16;
+
+        uint32_t lo = 0;
+        uint32_t hi = groups;
+        while( lo < hi )
+        {
+            const uint32_t mid = ( lo + hi ) / 2;
+            const uint8_t* g   = pGroup + mid * 12;
+            if ( ReadU32( g + 4 ) < codePoint )
+            { lo = mid + 1; }
+            else if ( ReadU32( g ) > codePoint )
+            { hi = mid; }
+            else
+            {
+                glyph = ReadU32( g + 8 ) + ( codePoint - ReadU32( g ) );
+                break;
+            }
+        }
+    }
+
+    return ( glyph < m_Metrics.GlyphCount ) ? glyph : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      グリフの輪郭をフォント単位で取得します. 空白などの輪郭が無いグリフでも成功します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::GetOutline( uint32_t glyph, GlyphOutline& outline ) const
+{
+    outline.Clear();
+
+    if ( m_pData == nullptr || glyph >= m_Metrics.GlyphCount )
+    { return false; }
+
+    if ( IsCFF() )
+    { return DecodeCff( glyph, outline ); }
+
+    return DecodeGlyf( glyph, IDENTITY, 0, outline );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      グリフの送り幅をフォント単位で取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t FontFace::GetAdvance( uint32_t glyph ) const
+{
+    if ( m_MetricCount == 0 )
+    { return 0; }
+
+    const uint32_t index = ( glyph < m_MetricCount ) ? glyph : m_MetricCount - 1;
+    return ReadU16( m_pData + m_Hmtx.Offset + index * 4 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フォント全体の寸法を取得します.
+//-------------------------------------------------------------------------------------------------
+FontMetrics FontFace::GetMetrics() const
+{ return m_Metrics; }
+
+//-------------------------------------------------------------------------------------------------
+//      フェイスが確保しているメモリ量を取得します. マップしたファイルは含みません.
+//-------------------------------------------------------------------------------------------------
+size_t FontFace::GetMemoryUsage() const
+{ return sizeof(*this) + m_LocalSubrs.capacity() * sizeof(CffIndex); }
+
+//-------------------------------------------------------------------------------------------------
+//      マップしたファイルのサイズを取得します.
+//-------------------------------------------------------------------------------------------------
+size_t FontFace::GetFileSize() const
+{ return m_File.GetSize(); }
+
+//-------------------------------------------------------------------------------------------------
+//      テーブルディレクトリを読み取ります.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::ParseTables( uint32_t faceIndex )
+{
+    if ( !InRange( m_Size, 0, 12 ) )
+    { return false; }
+
+    // フォントコレクションの場合は指定番号のフェイスのディレクトリを使う.
+    uint32_t dir = 0;
+    if ( ReadU32( m_pData ) == MakeTag( 't', 't', 'c', 'f' ) )
+    {
+        const uint32_t faces = ReadU32( m_pData + 8 );
+        if ( faceIndex >= faces || !InRange( m_Size, 12, uint64_t( faces ) * 4 ) )
+        { return false; }
+
+        dir = ReadU32( m_pData + 12 + faceIndex * 4 );
+    }
+    else if ( faceIndex != 0 )
+    { return false; }
+
+    if ( !InRange( m_Size, dir, 12 ) )
+    { return false; }
+
+    const uint32_t version = ReadU32( m_pData + dir );
+    if ( version != 0x00010000 && version != MakeTag( 'O', 'T', 'T', 'O' ) && version != MakeTag( 't', 'r', 'u', 'e' ) )
+    { return false; }
+
+    const uint32_t tableCount = ReadU16( m_pData + dir + 4 );
+    if ( !InRange( m_Size, dir + 12, uint64_t( tableCount ) * 16 ) )
+    { return false; }
+
+    TableRange cmap = { 0, 0 };
+    TableRange maxp = { 0, 0 };
+    for( uint32_t i = 0; i < tableCount; ++i )
+    {
+        const uint8_t* pRecord = m_pData + dir + 12 + i * 16;
+        TableRange range;
+        range.Offset = ReadU32( pRecord + 8 );
+        range.Length = ReadU32( pRecord + 12 );
+        if ( !InRange( m_Size, range.Offset, range.Length ) )
+        { continue; }
+
+        const uint32_t tag = ReadU32( pRecord );
+        if      ( tag == MakeTag( 'h', 'e', 'a', 'd' ) ) { m_Head = range; }
+        else if ( tag == MakeTag( 'h', 'h', 'e', 'a' ) ) { m_Hhea = range; }
+        else if ( tag == MakeTag( 'h', 'm', 't', 'x' ) ) { m_Hmtx = range; }
+        else if ( tag == MakeTag( 'm', 'a', 'x', 'p' ) ) { maxp   = range; }
+        else if ( tag == MakeTag( 'c', 'm', 'a', 'p' ) ) { cmap   = range; }
+        else if ( tag == MakeTag( 'l', 'o', 'c', 'a' ) ) { m_Loca = range; }
+        else if ( tag == MakeTag( 'g', 'l', 'y', 'f' ) ) { m_Glyf = range; }
+        else if ( tag == MakeTag( 'C', 'F', 'F', ' ' ) ) { m_Cff  = range; }
+    }
+
+    if ( m_Head.Length < 54 || m_Hhea.Length < 36 || maxp.Length < 6 )
+    { return false; }
+
+    m_Metrics.UnitsPerEm = ReadU16( m_pData + m_Head.Offset + 18 );
+    m_Metrics.Ascender   = ReadS16( m_pData + m_Hhea.Offset + 4 );
+    m_Metrics.Descender  = ReadS16( m_pData + m_Hhea.Offset + 6 );
+    m_Metrics.LineGap    = ReadS16( m_pData + m_Hhea.Offset + 8 );
+    m_Metrics.GlyphCount = ReadU16( m_pData + maxp.Offset + 4 );
+    m_LocaFormat         = ReadU16( m_pData + m_Head.Offset + 50 );
+    m_MetricCount        = ReadU16( m_pData + m_Hhea.Offset + 34 );
+
+    if ( m_Metrics.UnitsPerEm == 0 )
+    { m_Metrics.UnitsPerEm = 1000; }
+
+    if ( uint64_t( m_MetricCount ) * 4 > m_Hmtx.Length )
+    { m_MetricCount = m_Hmtx.Length / 4; }
+
+    if ( !ParseCmap( cmap ) )
+    { return false; }
+
+    if ( m_Cff.Length > 0 )
+    { return ParseCff(); }
+
+    const uint32_t locaSize = ( m_LocaFormat == 0 ) ? 2 : 4;
+    return m_Glyf.Length > 0 && uint64_t( m_Metrics.GlyphCount + 1 ) * locaSize <= m_Loca.Length;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      使用する cmap サブテーブルを選びます. Unicode 全体を扱える形式 12 を優先し, 無ければ BMP の形式 4 を使います.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::ParseCmap( const TableRange& cmap )
+{
+    if ( cmap.Length < 4 )
+    { return false; }
+
+    const uint32_t count = ReadU16( m_pData + cmap.Offset + 2 );
+    if ( uint64_t( count ) * 8 + 4 > cmap.Length )
+    { return false; }
+
+    uint32_t bestScore = 0;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const uint8_t* pRecord  = m_pData + cmap.Offset + 4 + i * 8;
+        const uint32_t platform = ReadU16( pRecord );
+        const uint32_t encoding = ReadU16( pRecord + 2 );
+        const uint32_t pos      = cmap.Offset + ReadU32( pRecord + 4 );
+        if ( !InRange( m_Size, pos, 16 ) )
+        { continue; }
+
+        const bool     unicode = ( platform == 0 ) || ( platform == 3 && ( encoding == 1 || encoding == 10 ) );
+        const uint32_t format  = ReadU16( m_pData + pos );
+
+        uint32_t score = 0;
+        if ( format == 12 )
+        {
+            const uint32_t groups = ReadU32( m_pData + pos + 12 );
+            if ( InRange( m_Size, pos + 16, uint64_t( groups ) * 12 ) )
+            { score = unicode ? 4 : 2; }
+        }
+        else if ( format == 4 )
+        {
+            const uint32_t segX2 = ReadU16( m_pData + pos + 6 );
+            if ( InRange( m_Size, pos + 16, uint64_t( segX2 ) * 4 ) )
+            { score = unicode ? 3 : 1; }
+        }
+
+        if ( score > bestScore )
+        {
+            bestScore    = score;
+            m_CmapPos    = pos;
+            m_CmapFormat = format;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      CFF テーブルの INDEX と Private DICT の位置を読み取ります. CID フォントの場合は
+//      Font DICT ごとのローカルサブルーチンを読み取ります.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::ParseCff()
+{
+    const uint32_t base = m_Cff.Offset;
+    if ( m_Cff.Length < 4 )
+    { return false; }
+
+    CffIndex names;
+    CffIndex topDicts;
+    CffIndex strings;
+    if ( !ReadIndex( base + m_pData[base + 2], names )
+      || !ReadIndex( names.End, topDicts )
+      || !ReadIndex( topDicts.End, strings )
+      || !ReadIndex( strings.End, m_GlobalSubrs ) )
+    { return false; }
+
+    uint32_t begin;
+    uint32_t end;
+    if ( !GetIndexItem( topDicts, 0, begin, end ) )
+    { return false; }
+
+    const uint8_t* pBegin = m_pData + begin;
+    const uint8_t* pEnd   = m_pData + end;
+
+    double   operands[MAX_DICT_OPERANDS];
+    uint32_t count;
+    if ( !FindDictOperator( pBegin, pEnd, DICT_CHAR_STRINGS, operands, count ) || count < 1
+      || !ReadIndex( base + uint32_t( operands[0] ), m_CharStrings ) )
+    { return false; }
+
+    if ( m_CharStrings.Count < m_Metrics.GlyphCount )
+    { m_Metrics.GlyphCount = m_CharStrings.Count; }
+
+    if ( FindDictOperator( pBegin, pEnd, DICT_ROS, operands, count ) )
+    {
+        // CID フォント : グリフごとに FDSelect で Font DICT を選ぶ.
+        CffIndex fdArray;
+        if ( !FindDictOperator( pBegin, pEnd, DICT_FD_ARRAY, operands, count ) || count < 1
+          || !ReadIndex( base + uint32_t( operands[0] ), fdArray ) )
+        { return false; }
+
+        if ( !FindDictOperator( pBegin, pEnd, DICT_FD_SELECT, operands, count ) || count < 1 )
+        { return false; }
+
+        m_FDSelectPos = base + uint32_t( operands[0] );
+        if ( !InRange( m_Size, m_FDSelectPos, 3 ) )
+        { return false; }
+
+        m_LocalSubrs.resize( fdArray.Count );
+        for( uint32_t i = 0; i < fdArray.Count; ++i )
+        {
+            if ( !GetIndexItem( fdArray, i, begin, end ) )
+            { return false; }
+
+            memset( &m_LocalSubrs[i], 0, sizeof(CffIndex) );
+            if ( FindDictOperator( m_pData + begin, m_pData + end, DICT_PRIVATE, operands, count ) && count >= 2 )
+            {
+                const uint32_t privateBegin = base + uint32_t( operands[1] );
+                if ( !ReadPrivateSubrs( privateBegin, privateBegin + uint32_t( operands[0] ), m_LocalSubrs[i] ) )
+                { return false; }
+            }
+        }
+    }
+    else
+    {
+        m_LocalSubrs.resize( 1 );
+        memset( &m_LocalSubrs[0], 0, sizeof(CffIndex) );
+        if ( FindDictOperator( pBegin, pEnd, DICT_PRIVATE, operands, count ) && count >= 2 )
+        {
+            const uint32_t privateBegin = base + uint32_t( operands[1] );
+            if ( !ReadPrivateSubrs( privateBegin, privateBegin + uint32_t( operands[0] ), m_LocalSubrs[0] ) )
+            { return false; }
+        }
+    }
+
+    return !m_LocalSubrs.empty();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      CFF の INDEX の位置を読み取ります.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::ReadIndex( uint32_t pos, CffIndex& index ) const
+{
+    memset( &index, 0, sizeof(index) );
+    if ( !InRange( m_Size, pos, 2 ) )
+    { return false; }
+
+    index.Count = ReadU16( m_pData + pos );
+    if ( index.Count == 0 )
+    {
+        index.OffsetPos = pos + 2;
+        index.DataPos   = pos + 2;
+        index.End       = pos + 2;
+        return true;
+    }
+
+    if ( !InRange( m_Size, pos + 2, 1 ) )
+    { return false; }
+
+    index.OffSize = m_pData[pos + 2];
+    if ( index.OffSize < 1 || index.OffSize > 4 )
+    { return false; }
+
+    index.OffsetPos = pos + 3;
+    const uint64_t offsetBytes = uint64_t( index.Count + 1 ) * index.OffSize;
+    if ( !InRange( m_Size, index.OffsetPos, offsetBytes ) )
+    { return false; }
+
+    index.DataPos = index.OffsetPos + uint32_t( offsetBytes ) - 1;
+
+    const uint64_t end = uint64_t( index.DataPos ) + ReadOffset( m_pData + index.OffsetPos + index.Count * index.OffSize, index.OffSize );
+    if ( end > m_Size )
+    { return false; }
+
+    index.End = uint32_t( end );
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      INDEX の要素の範囲を取得します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::GetIndexItem( const CffIndex& index, uint32_t item, uint32_t& begin, uint32_t& end ) const
+{
+    if ( item >= index.Count )
+    { return false; }
+
+    const uint8_t* p = m_pData + index.OffsetPos + item * index.OffSize;
+    const uint32_t first = ReadOffset( p, index.OffSize );
+    const uint32_t last  = ReadOffset( p + index.OffSize, index.OffSize );
+    if ( first == 0 || first > last || uint64_t( index.DataPos ) + last > index.End )
+    { return false; }
+
+    begin = index.DataPos + first;
+    end   = index.DataPos + last;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Private DICT からローカルサブルーチンの INDEX を読み取ります. 無い場合は空の INDEX とします.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::ReadPrivateSubrs( uint32_t dictBegin, uint32_t dictEnd, CffIndex& subrs ) const
+{
+    memset( &subrs, 0, sizeof(subrs) );
+    if ( dictEnd < dictBegin || dictEnd > m_Size )
+    { return false; }
+
+    double   operands[MAX_DICT_OPERANDS];
+    uint32_t count;
+    if ( !FindDictOperator( m_pData + dictBegin, m_pData + dictEnd, DICT_SUBRS, operands, count ) || count < 1 )
+    { return true; }
+
+    return ReadIndex( dictBegin + uint32_t( operands[0] ), subrs );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      CID フォントでグリフが使う Font DICT の番号を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t FontFace::GetFontDict( uint32_t glyph ) const
+{
+    if ( m_FDSelectPos == 0 )
+    { return 0; }
+
+    uint32_t fd = 0;
+    const uint32_t format = m_pData[m_FDSelectPos];
+    if ( format == 0 )
+    {
+        if ( InRange( m_Size, m_FDSelectPos + 1 + glyph, 1 ) )
+        { fd = m_pData[m_FDSelectPos + 1 + glyph]; }
+    }
+    else if ( format == 3 )
+    {
+        // 開始グリフ番号が glyph 以下となる最後の範囲を探す.
+        const uint32_t ranges = ReadU16( m_pData + m_FDSelectPos + 1 );
+        const uint32_t pos    = m_FDSelectPos + 3;
+        if ( ranges > 0 && InRange( m_Size, pos, uint64_t( ranges ) * 3 + 2 ) )
+        {
+            uint32_t lo = 0;
+            uint32_t hi = ranges;
+            while( hi - lo > 1 )
+            {
+                const uint32_t mid = ( lo + hi ) / 2;
+                if ( ReadU16( m_pData + pos + mid * 3 ) <= glyph )
+                { lo = mid; }
+                else
+                { hi = mid; }
+            }
+            fd = m_pData[pos + lo * 3 + 2];
+        }
+    }
+
+    return ( fd < m_LocalSubrs.size() ) ? fd : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      glyf テーブルのグリフをデコードします. 複合グリフは部品ごとに変換行列を合成して再帰的に展開します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::DecodeGlyf( uint32_t glyph, const float matrix[6], uint32_t depth, GlyphOutline& outline ) const
+{
+    if ( depth > MAX_COMPOSITE_DEPTH || glyph >= m_Metrics.GlyphCount )
+    { return false; }
+
+    const uint8_t* pLoca = m_pData + m_Loca.Offset;
+    uint32_t begin;
+    uint32_t end;
+    if ( m_LocaFormat == 0 )
+    {
+        begin = ReadU16( pLoca + glyph * 2     ) * 2;
+        end   = ReadU16( pLoca + glyph * 2 + 2 ) * 2;
+    }
+    else
+    {
+        begin = ReadU32( pLoca + glyph * 4     );
+        end   = ReadU32( pLoca + glyph * 4 + 4 );
+    }
+
+    // 輪郭の無いグリフ.
+    if ( end <= begin )
+    { return true; }
+
+    if ( end > m_Glyf.Length || end - begin < 10 )
+    { return false; }
+
+    const uint8_t* p    = m_pData + m_Glyf.Offset + begin;
+    const uint8_t* pEnd = m_pData + m_Glyf.Offset + end;
+
+    const int32_t contours = ReadS16( p );
+    if ( contours >= 0 )
+    {
+        const uint8_t* pEndPoints = p + 10;
+        if ( pEnd - pEndPoints < contours * 2 + 2 )
+        { return false; }
+
+        const uint32_t pointCount   = ( contours > 0 ) ? ReadU16( pEndPoints + ( contours - 1 ) * 2 ) + 1 : 0;
+        const uint32_t instructions = ReadU16( pEndPoints + contours * 2 );
+        const uint8_t* q = pEndPoints + contours * 2 + 2 + instructions;
+        if ( q > pEnd )
+        { return false; }
+
+        // フラグを展開.
+        std::vector<uint8_t> flags( pointCount );
+        for( uint32_t i = 0; i < pointCount; )
+        {
+            if ( q >= pEnd )
+            { return false; }
+
+            const uint8_t flag = *q++;
+            uint32_t repeat = 1;
+            if ( flag & FLAG_REPEAT )
+            {
+                if ( q >= pEnd )
+                { return false; }
+                repeat += *q++;
+            }
+
+            for( ; repeat > 0 && i < pointCount; --repeat )
+            { flags[i++] = flag; }
+        }
+
+        // 座標は前の点からの差分.
+        std::vector<float> points( pointCount * 2 );
+        for( uint32_t axis = 0; axis < 2; ++axis )
+        {
+            const uint32_t shortBit = ( axis == 0 ) ? FLAG_X_SHORT : FLAG_Y_SHORT;
+            const uint32_t sameBit  = ( axis == 0 ) ? FLAG_X_SAME  : FLAG_Y_SAME;
+
+            int32_t value = 0;
+            for( uint32_t i = 0; i < pointCount; ++i )
+            {
+                if ( flags[i] & shortBit )
+                {
+                    if ( q >= pEnd )
+                    { return false; }
+                    value += ( flags[i] & sameBit ) ? int32_t( *q ) : -int32_t( *q );
+                    q++;
+                }
+                else if ( !( flags[i] & sameBit ) )
+                {
+                    if ( pEnd - q < 2 )
+                    { return false; }
+                    value += ReadS16( q );
+                    q += 2;
+                }
+                points[i * 2 + axis] = float( value );
+            }
+        }
+
+        // 曲線外の点が続く場合は中点に曲線上の点を補う.
+        uint32_t start = 0;
+        for( int32_t c = 0; c < contours; ++c )
+        {
+            const uint32_t last = ReadU16( pEndPoints + c * 2 );
+            if ( last < start || last >= pointCount )
+            { return false; }
+
+            const uint32_t count = last - start + 1;
+            if ( count < 2 )
+            {
+                start = last + 1;
+                continue;
+            }
+
+            uint32_t first = count;
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                if ( flags[start + i] & FLAG_ON_CURVE )
+                {
+                    first = i;
+                    break;
+                }
+            }
+
+            float startX;
+            float startY;
+            uint32_t skip;
+            if ( first < count )
+            {
+                startX = points[( start + first ) * 2 + 0];
+                startY = points[( start + first ) * 2 + 1];
+                skip   = first;
+            }
+            else
+            {
+                startX = ( points[start * 2 + 0] + points[start * 2 + 2] ) * 0.5f;
+                startY = ( points[start * 2 + 1] + points[start * 2 + 3] ) * 0.5f;
+                skip   = 0;
+            }
+
+            outline.Commands.push_back( GLYPH_COMMAND_MOVE_TO );
+            AddPoint( outline, matrix, startX, startY );
+
+            bool  hasControl = false;
+            float controlX   = 0.0f;
+            float controlY   = 0.0f;
+            const uint32_t steps = ( first < count ) ? count - 1 : count;
+            for( uint32_t i = 1; i <= steps + 1; ++i )
+            {
+                float x;
+                float y;
+                bool  onCurve;
+                if ( i <= steps )
+                {
+                    const uint32_t index = start + ( skip + i ) % count;
+                    x       = points[index * 2 + 0];
+                    y       = points[index * 2 + 1];
+                    onCurve = ( flags[index] & FLAG_ON_CURVE ) != 0;
+                }
+                else
+                {
+                    // 始点に戻って閉じる.
+                    x       = startX;
+                    y       = startY;
+                    onCurve = true;
+                }
+
+                if ( onCurve )
+                {
+                    if ( hasControl )
+                    {
+                        outline.Commands.push_back( GLYPH_COMMAND_QUAD_TO );
+                        AddPoint( outline, matrix, controlX, controlY );
+                    }
+                    else
+                    { outline.Commands.push_back( GLYPH_COMMAND_LINE_TO ); }
+
+                    AddPoint( outline, matrix, x, y );
+                    hasControl = false;
+                }
+                else
+                {
+                    if ( hasControl )
+                    {
+                        outline.Commands.push_back( GLYPH_COMMAND_QUAD_TO );
+                        AddPoint( outline, matrix, controlX, controlY );
+                        AddPoint( outline, matrix, ( controlX + x ) * 0.5f, ( controlY + y ) * 0.5f );
+                    }
+                    controlX   = x;
+                    controlY   = y;
+                    hasControl = true;
+                }
+            }
+
+            start = last + 1;
+        }
+
+        return true;
+    }
+
+    // 複合グリフ.
+    const uint8_t* q = p + 10;
+    for( ;; )
+    {
+        if ( pEnd - q < 4 )
+        { return false; }
+
+        const uint32_t flags     = ReadU16( q );
+        const uint32_t component = ReadU16( q + 2 );
+        q += 4;
+
+        float dx = 0.0f;
+        float dy = 0.0f;
+        if ( flags & COMPONENT_ARG_WORDS )
+        {
+            if ( pEnd - q < 4 )
+            { return false; }
+            dx = float( ReadS16( q ) );
+            dy = float( ReadS16( q + 2 ) );
+            q += 4;
+        }
+        else
+        {
+            if ( pEnd - q < 2 )
+            { return false; }
+            dx = float( int8_t( q[0] ) );
+            dy = float( int8_t( q[1] ) );
+            q += 2;
+        }
+
+        // 点の番号で位置を合わせる指定は扱わず, 原点に置く.
+        if ( !( flags & COMPONENT_XY_VALUES ) )
+        {
+            dx = 0.0f;
+            dy = 0.0f;
+        }
+
+        float local[6] = { 1.0f, 0.0f, 0.0f, 1.0f, dx, dy };
+        if ( flags & COMPONENT_SCALE )
+        {
+            if ( pEnd - q < 2 )
+            { return false; }
+            local[0] = local[3] = float( ReadS16( q ) ) / 16384.0f;
+            q += 2;
+        }
+        else if ( flags & COMPONENT_XY_SCALE )
+        {
+            if ( pEnd - q < 4 )
+            { return false; }
+            local[0] = float( ReadS16( q     ) ) / 16384.0f;
+            local[3] = float( ReadS16( q + 2 ) ) / 16384.0f;
+            q += 4;
+        }
+        else if ( flags & COMPONENT_TWO_BY_TWO )
+        {
+            if ( pEnd - q < 8 )
+            { return false; }
+            local[0] = float( ReadS16( q     ) ) / 16384.0f;
+            local[1] = float( ReadS16( q + 2 ) ) / 16384.0f;
+            local[2] = float( ReadS16( q + 4 ) ) / 16384.0f;
+            local[3] = float( ReadS16( q + 6 ) ) / 16384.0f;
+            q += 8;
+        }
+
+        // 部品の変換を適用した後に親の変換を適用する.
+        const float combined[6] = {
+            local[0] * matrix[0] + local[1] * matrix[2],
+            local[0] * matrix[1] + local[1] * matrix[3],
+            local[2] * matrix[0] + local[3] * matrix[2],
+            local[2] * matrix[1] + local[3] * matrix[3],
+            local[4] * matrix[0] + local[5] * matrix[2] + matrix[4],
+            local[4] * matrix[1] + local[5] * matrix[3] + matrix[5] };
+
+        if ( !DecodeGlyf( component, combined, depth + 1, outline ) )
+        { return false; }
+
+        if ( !( flags & COMPONENT_MORE ) )
+        { break; }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      CFF のグリフの Type2 charstring を実行して輪郭を取得します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::DecodeCff( uint32_t glyph, GlyphOutline& outline ) const
+{
+    uint32_t begin;
+    uint32_t end;
+    if ( !GetIndexItem( m_CharStrings, glyph, begin, end ) )
+    { return false; }
+
+    CharStringState state;
+    state.Count       = 0;
+    state.Stems       = 0;
+    state.X           = 0.0f;
+    state.Y           = 0.0f;
+    state.Ended       = false;
+    state.pLocalSubrs = &m_LocalSubrs[GetFontDict( glyph )];
+    state.pOutline    = &outline;
+
+    return RunCharString( begin, end, 0, state );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Type2 charstring を実行します. ヒントは読み飛ばし, 算術演算子は扱いません.
+//      引数の数が演算子の要求より多い場合, 先頭の余分な引数は送り幅として無視します.
+//-------------------------------------------------------------------------------------------------
+bool FontFace::RunCharString( uint32_t begin, uint32_t end, uint32_t depth, CharStringState& state ) const
+{
+    if ( depth > MAX_SUBR_DEPTH )
+    { return false; }
+
+    float* s = state.Stack;
+
+    struct Path
+    {
+        static void MoveTo( CharStringState& st, float dx, float dy )
+        {
+            st.X += dx;
+            st.Y += dy;
+            st.pOutline->Commands.push_back( GLYPH_COMMAND_MOVE_TO );
+            st.pOutline->Points.push_back( st.X );
+            st.pOutline->Points.push_back( st.Y );
+        }
+
+        static void LineTo( CharStringState& st, float dx, float dy )
+        {
+            st.X += dx;
+            st.Y += dy;
+            st.pOutline->Commands.push_back( GLYPH_COMMAND_LINE_TO );
+            st.pOutline->Points.push_back( st.X );
+            st.pOutline->Points.push_back( st.Y );
+        }
+
+        static void CurveTo( CharStringState& st, float dx1, float dy1, float dx2, float dy2, float dx3, float dy3 )
+        {
+            const float x1 = st.X + dx1;
+            const float y1 = st.Y + dy1;
+            const float x2 = x1 + dx2;
+            const float y2 = y1 + dy2;
+            st.X = x2 + dx3;
+            st.Y = y2 + dy3;
+
+            const float points[6] = { x1, y1, x2, y2, st.X, st.Y };
+            st.pOutline->Commands.push_back( GLYPH_COMMAND_CUBIC_TO );
+            st.pOutline->Points.insert( st.pOutline->Points.end(), points, points + 6 );
+        }
+    };
+
+    uint32_t i = 0;
+
+    uint32_t pos = begin;
+    while( pos < end )
+    {
+        const uint32_t b0 = m_pData[pos++];
+
+        // 数値.
+        if ( b0 >= 32 || b0 == 28 )
+        {
+            float value;
+            if ( b0 == 28 )
+            {
+                if ( end - pos < 2 )
+                { return false; }
+                value = float( ReadS16( m_pData + pos ) );
+                pos += 2;
+            }
+            else if ( b0 <= 246 )
+            { value = float( int32_t( b0 ) - 139 ); }
+            else if ( b0 <= 254 )
+            {
+                if ( pos >= end )
+                { return false; }
+                const int32_t magnitude = int32_t( b0 - ( ( b0 <= 250 ) ? 247 : 251 ) ) * 256 + m_pData[pos++] + 108;
+                value = float( ( b0 <= 250 ) ? magnitude : -magnitude );
+            }
+            else
+            {
+                if ( end - pos < 4 )
+                { return false; }
+                value = float( int32_t( ReadU32( m_pData + pos ) ) ) / 65536.0f;
+                pos += 4;
+            }
+
+            if ( state.Count >= 48 )
+            { return false; }
+
+            s[state.Count++] = value;
+            continue;
+        }
+
+        const uint32_t count = state.Count;
+        switch( b0 )
+        {
+        case 1:     // hstem
+        case 3:     // vstem
+        case 18:    // hstemhm
+        case 23:    // vstemhm
+            state.Stems += count / 2;
+            break;
+
+        case 19:    // hintmask
+        case 20:    // cntrmask
+            state.Stems += count / 2;
+            pos += ( state.Stems + 7 ) / 8;
+            if ( pos > end )
+            { return false; }
+            break;
+
+        case 21:    // rmoveto
+            if ( count < 2 )
+            { return false; }
+            Path::MoveTo( state, s[count - 2], s[count - 1] );
+            break;
+
+        case 22:    // hmoveto
+            if ( count < 1 )
+            { return false; }
+            Path::MoveTo( state, s[count - 1], 0.0f );
+            break;
+
+        case 4:     // vmoveto
+            if ( count < 1 )
+            { return false; }
+            Path::MoveTo( state, 0.0f, s[count - 1] );
+            break;
+
+        case 5:     // rlineto
+            for( i = 0; i + 1 < count; i += 2 )
+            { Path::LineTo( state, s[i], s[i + 1] ); }
+            break;
+
+        case 6:     // hlineto
+        case 7:     // vlineto
+            {
+                bool horizontal = ( b0 == 6 );
+                for( i = 0; i < count; ++i )
+                {
+                    if ( horizontal )
+                    { Path::LineTo( state, s[i], 0.0f ); }
+                    else
+                    { Path::LineTo( state, 0.0f, s[i] ); }
+                    horizontal = !horizontal;
+                }
+            }
+            break;
+
+        case 8:     // rrcurveto
+            for( i = 0; i + 5 < count; i += 6 )
+            { Path::CurveTo( state, s[i], s[i + 1], s[i + 2], s[i + 3], s[i + 4], s[i + 5] ); }
+            break;
+
+        case 24:    // rcurveline
+            if ( count < 8 )
+            { return false; }
+            for( i = 0; i + 6 < count - 1; i += 6 )
+            { Path::CurveTo( state, s[i], s[i + 1], s[i + 2], s[i + 3], s[i + 4], s[i + 5] ); }
+            Path::LineTo( state, s[count - 2], s[count - 1] );
+            break;
+
+        case 25:    // rlinecurve
+            if ( count < 8 )
+            { return false; }
+            for( i = 0; i + 6 < count; i += 2 )
+            { Path::LineTo( state, s[i], s[i + 1] ); }
+            Path::CurveTo( state, s[count - 6], s[count - 5], s[count - 4], s[count - 3], s[count - 2], s[count - 1] );
+            break;
+
+        case 26:    // vvcurveto
+            {
+                float dx1 = 0.0f;
+                i = 0;
+                if ( count & 1 )
+                {
+                    dx1 = s[0];
+                    i   = 1;
+                }
+                for( ; i + 3 < count; i += 4 )
+                {
+                    Path::CurveTo( state, dx1, s[i], s[i + 1], s[i + 2], 0.0f, s[i + 3] );
+                    dx1 = 0.0f;
+                }
+            }
+            break;
+
+        case 27:    // hhcurveto
+            {
+                float dy1 = 0.0f;
+                i = 0;
+                if ( count & 1 )
+                {
+                    dy1 = s[0];
+                    i   = 1;
+                }
+                for( ; i + 3 < count; i += 4 )
+                {
+                    Path::CurveTo( state, s[i], dy1, s[i + 1], s[i + 2], s[i + 3], 0.0f );
+                    dy1 = 0.0f;
+                }
+            }
+            break;
+
+        case 30:    // vhcurveto
+        case 31:    // hvcurveto
+            {
+                bool horizontal = ( b0 == 31 );
+                for( i = 0; i + 3 < count; i += 4 )
+                {
+                    const float last = ( count - i == 5 ) ? s[i + 4] : 0.0f;
+                    if ( horizontal )
+                    { Path::CurveTo( state, s[i], 0.0f, s[i + 1], s[i + 2], last, s[i + 3] ); }
+                    else
+                    { Path::CurveTo( state, 0.0f, s[i], s[i + 1], s[i + 2], s[i + 3], last ); }
+                    horizontal = !horizontal;
+                }
+            }
+            break;
+
+        case 10:    // callsubr
+        case 29:    // callgsubr
+            {
+                if ( count < 1 )
+                { return false; }
+
+                const CffIndex& subrs = ( b0 == 10 ) ? *state.pLocalSubrs : m_GlobalSubrs;
+                const int32_t   index = int32_t( s[--state.Count] ) + GetSubrBias( subrs.Count );
+
+                uint32_t subrBegin;
+                uint32_t subrEnd;
+                if ( index < 0 || !GetIndexItem( subrs, uint32_t( index ), subrBegin, subrEnd ) )
+                { return false; }
+
+                if ( !RunCharString( subrBegin, subrEnd, depth + 1, state ) )
+                { return false; }
+
+                if ( state.Ended )
+                { return true; }
+            }
+            continue;   // スタックは呼び出し元に引き継ぐ.
+
+        case 11:    // return
+            return true;
+
+        case 14:    // endchar
+            state.Ended = true;
+            return true;
+
+        case 12:    // escape
+            {
+                if ( pos >= end )
+                { return false; }
+
+                const uint32_t b1 = m_pData[pos++];
+                if ( b1 == 35 && count >= 13 )          // flex
+                {
+                    Path::CurveTo( state, s[0], s[1], s[2], s[3], s[4],  s[5]  );
+                    Path::CurveTo( state, s[6], s[7], s[8], s[9], s[10], s[11] );
+                }
+                else if ( b1 == 34 && count >= 7 )      // hflex
+                {
+                    Path::CurveTo( state, s[0], 0.0f, s[1], s[2],  s[3], 0.0f );
+                    Path::CurveTo( state, s[4], 0.0f, s[5], -s[2], s[6], 0.0f );
+                }
+                else if ( b1 == 36 && count >= 9 )      // hflex1
+                {
+                    Path::CurveTo( state, s[0], s[1], s[2], s[3], s[4], 0.0f );
+                    Path::CurveTo( state, s[5], 0.0f, s[6], s[7], s[8], -( s[1] + s[3] + s[7] ) );
+                }
+                else if ( b1 == 37 && count >= 11 )     // flex1
+                {
+                    const float dx = s[0] + s[2] + s[4] + s[6] + s[8];
+                    const float dy = s[1] + s[3] + s[5] + s[7] + s[9];
+                    Path::CurveTo( state, s[0], s[1], s[2], s[3], s[4], s[5] );
+                    if ( std::fabs( dx ) > std::fabs( dy ) )
+                    { Path::CurveTo( state, s[6], s[7], s[8], s[9], s[10], -dy ); }
+                    else
+                    { Path::CurveTo( state, s[6], s[7], s[8], s[9], -dx, s[10] ); }
+                }
+            }
+            break;
+
+        default:
+            return false;
+        }
+
+        // パスとヒントの演算子はスタックを空にする.
+        state.Count = 0;
+    }
+
+    return true;
+}
@@ -0,0 +1,381 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FramePacer.cpp
+// Desc : Frame Rate Limiter and Pacing Controller.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <FramePacer.h>
+#include <Timer.h>
+#include <cmath>
+#include <thread>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <emmintrin.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+static const double PredictAlpha    = 0.1;      //!< 描画時間予測の平滑化係数です.
+static const double PredictSigma    = 2.0;      //!< 予測に加える標準偏差の倍率です.
+static const double OversleepAlpha  = 0.05;     //!< 寝過ごし量が減る方向の平滑化係数です.
+static const double SpinWindowMsec  = 1.0;      //!< 寝過ごし量に加えて必ずスピンで待つ時間です.
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SystemFrameClock class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SystemFrameClock::SystemFrameClock()
+{
+#if defined(_WIN32)
+    // Sleep() の分解能を 1ms に上げる.
+    timeBeginPeriod( 1 );
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SystemFrameClock::~SystemFrameClock()
+{
+#if defined(_WIN32)
+    timeEndPeriod( 1 );
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在時刻を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t SystemFrameClock::GetTicks()
+{ return Timer::GetTicks(); }
+
+//-------------------------------------------------------------------------------------------------
+//      1秒あたりのティック数を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t SystemFrameClock::GetTicksPerSec()
+{ return Timer::GetTicksPerSec(); }
+
+//-------------------------------------------------------------------------------------------------
+//      スリープします.
+//-------------------------------------------------------------------------------------------------
+void SystemFrameClock::SleepFor( int64_t ticks )
+{
+    const int64_t usec = ticks * 1000000 / Timer::GetTicksPerSec();
+    if ( usec <= 0 )
+    { return; }
+
+#if defined(_WIN32)
+    Sleep( DWORD( ( usec + 999 ) / 1000 ) );
+#else
+    std::this_thread::sleep_for( std::chrono::microseconds( usec ) );
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スピン待機します.
+//-------------------------------------------------------------------------------------------------
+void SystemFrameClock::Spin()
+{
+#if defined(_WIN32)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SimulatedFrameClock class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SimulatedFrameClock::SimulatedFrameClock( int64_t ticksPerSec, int64_t sleepOvershoot, int64_t spinCost )
+: m_Now             ( 1 )
+, m_TicksPerSec     ( ticksPerSec )
+, m_SleepOvershoot  ( sleepOvershoot )
+, m_SpinCost        ( ( spinCost > 0 ) ? spinCost : 1 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SimulatedFrameClock::~SimulatedFrameClock()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      現在時刻を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t SimulatedFrameClock::GetTicks()
+{ return m_Now; }
+
+//-------------------------------------------------------------------------------------------------
+//      1秒あたりのティック数を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t SimulatedFrameClock::GetTicksPerSec()
+{ return m_TicksPerSec; }
+
+//-------------------------------------------------------------------------------------------------
+//      スリープします. 設定された寝過ごし量だけ余分に時間が進みます.
+//-------------------------------------------------------------------------------------------------
+void SimulatedFrameClock::SleepFor( int64_t ticks )
+{ m_Now += ticks + m_SleepOvershoot; }
+
+//-------------------------------------------------------------------------------------------------
+//      スピン待機します.
+//-------------------------------------------------------------------------------------------------
+void SimulatedFrameClock::Spin()
+{ m_Now += m_SpinCost; }
+
+//-------------------------------------------------------------------------------------------------
+//      時刻を進めます. 描画処理のシミュレートに使います.
+//-------------------------------------------------------------------------------------------------
+void SimulatedFrameClock::Advance( int64_t ticks )
+{ m_Now += ticks; }
+
+//-------------------------------------------------------------------------------------------------
+//      寝過ごし量を設定します.
+//-------------------------------------------------------------------------------------------------
+void SimulatedFrameClock::SetSleepOvershoot( int64_t ticks )
+{ m_SleepOvershoot = ticks; }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです. pClock が nullptr の場合はシステムクロックを使います.
+//      システムクロックはタイマー分解能を変更するので, 必要な場合にだけ生成します.
+//-------------------------------------------------------------------------------------------------
+FramePacer::FramePacer( FrameClock* pClock )
+: m_pClock          ( pClock )
+, m_pSystemClock    ( nullptr )
+, m_TicksPerMsec    ( 0.0 )
+, m_Period          ( 0 )
+, m_SafetyMargin    ( 0 )
+, m_Deadline        ( 0 )
+, m_FrameBegin      ( 0 )
+, m_LastPresent     ( 0 )
+, m_RenderMean      ( 0.0 )
+, m_RenderVar       ( 0.0 )
+, m_Oversleep       ( 0.0 )
+{
+    if ( m_pClock == nullptr )
+    {
+        m_pSystemClock = new SystemFrameClock();
+        m_pClock       = m_pSystemClock;
+    }
+
+    m_TicksPerMsec = double( m_pClock->GetTicksPerSec() ) / 1000.0;
+    m_SafetyMargin = int64_t( 0.25 * m_TicksPerMsec );
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+FramePacer::~FramePacer()
+{
+    delete m_pSystemClock;
+    m_pSystemClock = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      目標フレームレートを設定します. 0 以下の場合は制限しません.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::SetTargetRate( double framesPerSec )
+{
+    m_Period = ( framesPerSec > 0.0 )
+        ? int64_t( double( m_pClock->GetTicksPerSec() ) / framesPerSec )
+        : 0;
+    Resync();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画時間の予測に加える余裕をミリ秒単位で設定します.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::SetSafetyMargin( double msec )
+{ m_SafetyMargin = int64_t( msec * m_TicksPerMsec ); }
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの開始処理です.
+//      次の表示期限から予測描画時間を引いた時刻まで待機し, できるだけ遅く描画を開始します.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::BeginFrame()
+{
+    const int64_t now = m_pClock->GetTicks();
+
+    if ( m_Period > 0 )
+    {
+        if ( m_Deadline == 0 )
+        { m_Deadline = now + m_Period; }
+
+        const int64_t start = m_Deadline - PredictRenderTicks();
+        if ( start > now )
+        { WaitUntil( start ); }
+    }
+
+    m_FrameBegin = m_pClock->GetTicks();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの終了処理です. Present() の直後に呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::EndFrame()
+{
+    const int64_t now = m_pClock->GetTicks();
+
+    // 描画時間の予測を更新.
+    const double render = double( now - m_FrameBegin );
+    if ( m_RenderMean <= 0.0 )
+    {
+        m_RenderMean = render;
+        m_RenderVar  = 0.0;
+    }
+    else
+    {
+        const double diff = render - m_RenderMean;
+        m_RenderMean += PredictAlpha * diff;
+        m_RenderVar   = ( 1.0 - PredictAlpha ) * ( m_RenderVar + PredictAlpha * diff * diff );
+    }
+
+    // 表示間隔の統計を更新.
+    if ( m_LastPresent != 0 )
+    {
+        const double interval = double( now - m_LastPresent ) / m_TicksPerMsec;
+        m_FrameCount++;
+
+        const double delta = interval - m_IntervalMean;
+        m_IntervalMean += delta / double( m_FrameCount );
+        m_IntervalM2   += delta * ( interval - m_IntervalMean );
+    }
+    m_LastPresent = now;
+
+    if ( m_Period > 0 && m_Deadline != 0 )
+    {
+        const int64_t lateness = now - m_Deadline;
+        if ( lateness > 0 )
+        {
+            m_MissedCount++;
+            if ( lateness > m_MaxLateness )
+            { m_MaxLateness = lateness; }
+        }
+
+        // 1周期以上遅れた場合は取り戻そうとせず, 現在時刻から刻み直す.
+        m_Deadline += m_Period;
+        if ( m_Deadline <= now )
+        { m_Deadline = now + m_Period; }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      表示期限を再設定します. リサイズなどで長時間停止した後に呼び出します.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::Resync()
+{
+    m_Deadline    = 0;
+    m_LastPresent = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+FramePacer::Stats FramePacer::GetStats() const
+{
+    Stats result;
+    result.FrameCount          = m_FrameCount;
+    result.MissedDeadlines     = m_MissedCount;
+    result.MeanFrameMsec       = m_IntervalMean;
+    result.FrameVarianceMsec2  = ( m_FrameCount > 1 ) ? m_IntervalM2 / double( m_FrameCount - 1 ) : 0.0;
+    result.MaxLatenessMsec     = double( m_MaxLateness ) / m_TicksPerMsec;
+    result.PredictedRenderMsec = double( PredictRenderTicks() ) / m_TicksPerMsec;
+    result.OversleepMsec       = m_Oversleep / m_TicksPerMsec;
+    result.SleepMsec           = double( m_SleepTicks ) / m_TicksPerMsec;
+    result.SpinMsec            = double( m_SpinTicks  ) / m_TicksPerMsec;
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::ResetStats()
+{
+    m_FrameCount   = 0;
+    m_MissedCount  = 0;
+    m_IntervalMean = 0.0;
+    m_IntervalM2   = 0.0;
+    m_MaxLateness  = 0;
+    m_SleepTicks   = 0;
+    m_SpinTicks    = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定時刻まで待機します.
+//      寝過ごし量の推定値より十分手前まではスリープし, 残りはスピンで詰めます.
+//-------------------------------------------------------------------------------------------------
+void FramePacer::WaitUntil( int64_t target )
+{
+    const int64_t spinWindow = int64_t( SpinWindowMsec * m_TicksPerMsec );
+
+    for( ;; )
+    {
+        const int64_t now       = m_pClock->GetTicks();
+        const int64_t remaining = target - now;
+        if ( remaining <= 0 )
+        { break; }
+
+        const int64_t threshold = int64_t( m_Oversleep ) + spinWindow;
+        if ( remaining > threshold )
+        {
+            const int64_t request = remaining - threshold;
+            m_pClock->SleepFor( request );
+
+            const int64_t slept = m_pClock->GetTicks() - now;
+            m_SleepTicks += slept;
+
+            // 寝過ごしは即座に反映し, 改善はゆっくり反映する.
+            const double oversleep = double( slept - request );
+            if ( oversleep > m_Oversleep )
+            { m_Oversleep = oversleep; }
+            else
+            { m_Oversleep += OversleepAlpha * ( oversleep - m_Oversleep ); }
+        }
+        else
+        {
+            m_pClock->Spin();
+            m_SpinTicks += m_pClock->GetTicks() - now;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画に必要な時間を予測します.
+//-------------------------------------------------------------------------------------------------
+int64_t FramePacer::PredictRenderTicks() const
+{
+    const double sigma = sqrt( ( m_RenderVar > 0.0 ) ? m_RenderVar : 0.0 );
+    int64_t predict = int64_t( m_RenderMean + PredictSigma * sigma ) + m_SafetyMargin;
+
+    // 周期を超える予測は待機しないのと同じなので丸める.
+    if ( m_Period > 0 && predict > m_Period )
+    { predict = m_Period; }
+
+    return predict;
+}
@@ -0,0 +1,299 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : FrameRecorder.cpp
+// Desc : Y4M Frame Recorder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <FrameRecorder.h>
+#include <Logger.h>
+#include <PixelConvert.h>
+#include <Timer.h>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+//      バイナリ書き込みモードでファイルを開きます.
+//-------------------------------------------------------------------------------------------------
+FILE* OpenFileForWrite( const char* path )
+{
+    FILE* pFile = nullptr;
+#if defined(_MSC_VER)
+    if ( fopen_s( &pFile, path, "wb" ) != 0 )
+    { pFile = nullptr; }
+#else
+    pFile = fopen( path, "wb" );
+#endif
+    return pFile;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FrameRecorder class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+FrameRecorder::FrameRecorder()
+: m_pFile           ( nullptr )
+, m_Width           ( 0 )
+, m_Height          ( 0 )
+, m_FreeQueue       ( 1 )
+, m_ConvertQueue    ( 1 )
+, m_WriteQueue      ( 1 )
+, m_SubmittedFrames ( 0 )
+, m_BlockedFrames   ( 0 )
+, m_BlockedTicks    ( 0 )
+, m_WrittenFrames   ( 0 )
+, m_ConvertTicks    ( 0 )
+, m_ConvertPixels   ( 0 )
+, m_WriteFailed     ( false )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+FrameRecorder::~FrameRecorder()
+{ Close(); }
+
+//-------------------------------------------------------------------------------------------------
+//      録画を開始します.
+//-------------------------------------------------------------------------------------------------
+bool FrameRecorder::Open
+(
+    const char* path,
+    uint32_t    width,
+    uint32_t    height,
+    uint32_t    fps,
+    uint32_t    queueDepth
+)
+{
+    Close();
+
+    if ( path == nullptr || width == 0 || height == 0 || fps == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pFile = OpenFileForWrite( path );
+    if ( m_pFile == nullptr )
+    {
+        ELOG( "Error : File Open Failed. path = %s", path );
+        return false;
+    }
+
+    // ストリームヘッダを書き出し. 色差は 2x2 平均なので中央配置 (420jpeg).
+    if ( fprintf( m_pFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width, height, fps ) < 0 )
+    {
+        ELOG( "Error : File Write Failed. path = %s", path );
+        fclose( m_pFile );
+        m_pFile = nullptr;
+        return false;
+    }
+
+    m_Width  = width;
+    m_Height = height;
+
+    // 描画スレッドが書き込み中の1枚と書き出し中の1枚を加えた数だけ確保.
+    // 全て使用中になれば描画スレッドが待機するので, メモリ使用量はこれ以上増えない.
+    const size_t frameCount = size_t( queueDepth ) + 2;
+    const size_t sizeY      = size_t( width ) * height;
+    const size_t sizeUV     = size_t( ( width + 1 ) / 2 ) * ( ( height + 1 ) / 2 );
+
+    m_Frames.resize( frameCount );
+    m_FreeQueue   .Reopen( frameCount );
+    m_ConvertQueue.Reopen( queueDepth );
+    m_WriteQueue  .Reopen( queueDepth );
+    m_ConvertQueue.ResetStats();
+
+    for( size_t i = 0; i < frameCount; ++i )
+    {
+        m_Frames[i].BGRA.resize( sizeY * 4 );
+        m_Frames[i].YUV .resize( sizeY + sizeUV * 2 );
+        m_FreeQueue.Push( &m_Frames[i] );
+    }
+
+    m_SubmittedFrames = 0;
+    m_BlockedFrames   = 0;
+    m_BlockedTicks    = 0;
+    m_WrittenFrames   = 0;
+    m_ConvertTicks    = 0;
+    m_ConvertPixels   = 0;
+    m_WriteFailed     = false;
+
+    m_ConvertThread = std::thread( &FrameRecorder::ConvertProc, this );
+    m_WriteThread   = std::thread( &FrameRecorder::WriteProc,   this );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      録画を終了します. キューに残っているフレームは全て書き出されます.
+//-------------------------------------------------------------------------------------------------
+void FrameRecorder::Close()
+{
+    if ( m_pFile == nullptr )
+    { return; }
+
+    // 変換スレッドが終了すると書き出しキューも閉じられる.
+    m_ConvertQueue.Close();
+    if ( m_ConvertThread.joinable() )
+    { m_ConvertThread.join(); }
+
+    if ( m_WriteThread.joinable() )
+    { m_WriteThread.join(); }
+
+    m_FreeQueue.Close();
+
+    if ( fclose( m_pFile ) != 0 )
+    { SetWriteFailed( "fclose()" ); }
+    m_pFile = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームを投入します.
+//-------------------------------------------------------------------------------------------------
+bool FrameRecorder::PushFrame
+(
+    const uint8_t*  pBGRA,
+    uint32_t        pitch,
+    uint32_t        width,
+    uint32_t        height
+)
+{
+    if ( m_pFile == nullptr || pBGRA == nullptr || m_WriteFailed )
+    { return false; }
+
+    // 空きバッファを取得. 無ければ書き出しが追いつくまで待機する.
+    Frame* pFrame = nullptr;
+    if ( !m_FreeQueue.TryPop( pFrame ) )
+    {
+        const int64_t begin = Timer::GetTicks();
+        if ( !m_FreeQueue.Pop( pFrame ) )
+        { return false; }
+
+        m_BlockedFrames++;
+        m_BlockedTicks += Timer::GetTicks() - begin;
+    }
+
+    // 録画サイズに合わせて切り抜き, 足りない部分は黒で埋める.
+    const uint32_t copyW   = ( width  < m_Width  ) ? width  : m_Width;
+    const uint32_t copyH   = ( height < m_Height ) ? height : m_Height;
+    const size_t   dstPitch = size_t( m_Width ) * 4;
+
+    uint8_t* pDst = pFrame->BGRA.data();
+    for( uint32_t y = 0; y < copyH; ++y )
+    {
+        memcpy( pDst + y * dstPitch, pBGRA + size_t( y ) * pitch, size_t( copyW ) * 4 );
+        if ( copyW < m_Width )
+        { memset( pDst + y * dstPitch + copyW * 4, 0, ( m_Width - copyW ) * 4 ); }
+    }
+    if ( copyH < m_Height )
+    { memset( pDst + copyH * dstPitch, 0, ( m_Height - copyH ) * dstPitch ); }
+
+    m_SubmittedFrames++;
+    return m_ConvertQueue.Push( pFrame );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      録画中かどうかチェックします.
+//-------------------------------------------------------------------------------------------------
+bool FrameRecorder::IsOpen() const
+{ return m_pFile != nullptr; }
+
+//-------------------------------------------------------------------------------------------------
+//      書き出しに失敗したかどうかチェックします. 失敗後は PushFrame() が false を返します.
+//-------------------------------------------------------------------------------------------------
+bool FrameRecorder::IsFailed() const
+{ return m_WriteFailed; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+FrameRecorder::Stats FrameRecorder::GetStats() const
+{
+    const BoundedQueue<Frame*>::Stats queueStats = m_ConvertQueue.GetStats();
+    const uint64_t pixels = m_ConvertPixels;
+
+    Stats result;
+    result.SubmittedFrames   = m_SubmittedFrames;
+    result.WrittenFrames     = m_WrittenFrames;
+    result.ConvertNsPerPixel = ( pixels > 0 ) ? Timer::ToNsec( m_ConvertTicks ) / double( pixels ) : 0.0;
+    result.AvgQueueDepth     = ( queueStats.PushCount > 0 ) ? double( queueStats.DepthSum ) / double( queueStats.PushCount ) : 0.0;
+    result.MaxQueueDepth     = queueStats.MaxDepth;
+    result.BlockedFrames     = m_BlockedFrames;
+    result.BlockedMsec       = Timer::ToMsec( m_BlockedTicks );
+    result.WriteFailed       = m_WriteFailed;
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      変換スレッドの処理です.
+//-------------------------------------------------------------------------------------------------
+void FrameRecorder::ConvertProc()
+{
+    const size_t sizeY  = size_t( m_Width ) * m_Height;
+    const size_t sizeUV = size_t( ( m_Width + 1 ) / 2 ) * ( ( m_Height + 1 ) / 2 );
+
+    Frame* pFrame = nullptr;
+    while( m_ConvertQueue.Pop( pFrame ) )
+    {
+        PlanarYUV yuv;
+        yuv.pY      = pFrame->YUV.data();
+        yuv.pU      = yuv.pY + sizeY;
+        yuv.pV      = yuv.pU + sizeUV;
+        yuv.PitchY  = m_Width;
+        yuv.PitchUV = ( m_Width + 1 ) / 2;
+
+        const int64_t begin = Timer::GetTicks();
+        ConvertBGRAToI420( pFrame->BGRA.data(), m_Width * 4, m_Width, m_Height, yuv );
+        m_ConvertTicks  += Timer::GetTicks() - begin;
+        m_ConvertPixels += sizeY;
+
+        m_WriteQueue.Push( pFrame );
+    }
+
+    m_WriteQueue.Close();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      書き出しスレッドの処理です.
+//-------------------------------------------------------------------------------------------------
+void FrameRecorder::WriteProc()
+{
+    static const char FrameTag[] = "FRAME\n";
+
+    Frame* pFrame = nullptr;
+    while( m_WriteQueue.Pop( pFrame ) )
+    {
+        // 失敗後も空きバッファは返して, 待機中の描画スレッドを止めないようにする.
+        if ( !m_WriteFailed )
+        {
+            if ( fwrite( FrameTag, 1, sizeof(FrameTag) - 1, m_pFile ) != sizeof(FrameTag) - 1
+              || fwrite( pFrame->YUV.data(), 1, pFrame->YUV.size(), m_pFile ) != pFrame->YUV.size() )
+            { SetWriteFailed( "fwrite()" ); }
+            else
+            { m_WrittenFrames++; }
+        }
+
+        m_FreeQueue.Push( pFrame );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      書き出しの失敗を記録します. ログは最初の1回だけ出力します.
+//-------------------------------------------------------------------------------------------------
+void FrameRecorder::SetWriteFailed( const char* what )
+{
+    if ( !m_WriteFailed.exchange( true ) )
+    { ELOG( "Error : %s Failed. Recording stopped after %llu frames.", what, (unsigned long long)m_WrittenFrames.load() ); }
+}
@@ -0,0 +1,353 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : GeometryCache.cpp
+// Desc : Tessellated Geometry Realization Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <GeometryCache.h>
+#include <Logger.h>
+#include <SafeRelease.h>
+#include <Timer.h>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const UINT64    FNV_PRIME           = 1099511628211ULL;
+const int       BANDS_PER_OCTAVE    = 4;        // スケール帯の細かさ (1オクターブあたり).
+const UINT8     TAG_FILL            = 'F';
+const UINT8     TAG_STROKE          = 'S';
+
+//-------------------------------------------------------------------------------------------------
+//      FNV-1a ハッシュにバイト列を混ぜ込みます.
+//-------------------------------------------------------------------------------------------------
+inline UINT64 HashBytes( UINT64 hash, const void* pData, size_t size )
+{
+    const UINT8* pBytes = static_cast<const UINT8*>( pData );
+    for( size_t i = 0; i < size; ++i )
+    {
+        hash ^= pBytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GeometryCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+GeometryCache::GeometryCache()
+: m_pDevice     ( nullptr )
+, m_pTracker    ( nullptr )
+, m_BudgetBytes ( 0 )
+, m_BufferBytes ( 0 )
+, m_FrameIndex  ( 0 )
+, m_Enabled     ( true )
+{ ResetStats(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+GeometryCache::~GeometryCache()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. budgetBytes を超えると古いエントリから破棄します.
+//      pTracker を指定すると, 生成した頂点バッファを登録します.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::Init( ID3D11Device* pDevice, UINT64 budgetBytes, ResourceTracker* pTracker )
+{
+    if ( pDevice == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    m_pDevice = pDevice;
+    m_pDevice->AddRef();
+
+    m_pTracker    = pTracker;
+    m_BudgetBytes = budgetBytes;
+    m_BufferBytes = 0;
+    m_FrameIndex  = 0;
+    ResetStats();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::Term()
+{
+    for( auto itr = m_Entries.begin(); itr != m_Entries.end(); ++itr )
+    { Release( itr->second.Mesh.pVertexBuffer ); }
+    m_Entries.clear();
+
+    for( size_t i = 0; i < m_Transient.size(); ++i )
+    { Release( m_Transient[i] ); }
+    m_Transient.clear();
+
+    m_BufferBytes = 0;
+    m_pTracker    = nullptr;
+    SafeRelease( m_pDevice );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュの有効/無効を設定します. 無効時は毎回テッセレーションします.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::SetEnabled( bool enable )
+{ m_Enabled = enable; }
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュが有効かどうかチェックします.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::IsEnabled() const
+{ return m_Enabled; }
+
+//-------------------------------------------------------------------------------------------------
+//      塗りつぶしメッシュを取得します. 無ければテッセレーションして登録します.
+//      scale はパス座標1単位あたりのデバイスピクセル数です.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::GetFill
+(
+    const Path&     path,
+    FILL_RULE       rule,
+    float           scale,
+    const float     color[4],
+    GeometryMesh&   result
+)
+{
+    Key key;
+    key.Hash = HashBytes( path.GetHash(), &TAG_FILL, sizeof(TAG_FILL) );
+    key.Hash = HashBytes( key.Hash, &rule, sizeof(rule) );
+    key.Hash = HashBytes( key.Hash, color, sizeof(float) * 4 );
+    key.Band = GetScaleBand( scale );
+
+    if ( Find( key, result ) )
+    { return true; }
+
+    Timer timer;
+    m_Vertices.clear();
+    m_Tessellator.Fill( path, rule, GetBandScale( key.Band ), color, m_Vertices );
+    m_Stats.TessellateMsec += timer.GetElapsedMsec();
+
+    return Realize( key, result );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      線のメッシュを取得します. 無ければテッセレーションして登録します.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::GetStroke
+(
+    const Path&         path,
+    const StrokeStyle&  style,
+    float               scale,
+    const float         color[4],
+    GeometryMesh&       result
+)
+{
+    Key key;
+    key.Hash = HashBytes( path.GetHash(), &TAG_STROKE, sizeof(TAG_STROKE) );
+    key.Hash = HashBytes( key.Hash, &style.Width,      sizeof(style.Width) );
+    key.Hash = HashBytes( key.Hash, &style.Join,       sizeof(style.Join) );
+    key.Hash = HashBytes( key.Hash, &style.Cap,        sizeof(style.Cap) );
+    key.Hash = HashBytes( key.Hash, &style.MiterLimit, sizeof(style.MiterLimit) );
+    key.Hash = HashBytes( key.Hash, color, sizeof(float) * 4 );
+    key.Band = GetScaleBand( scale );
+
+    if ( Find( key, result ) )
+    { return true; }
+
+    Timer timer;
+    m_Vertices.clear();
+    m_Tessellator.Stroke( path, style, GetBandScale( key.Band ), color, m_Vertices );
+    m_Stats.TessellateMsec += timer.GetElapsedMsec();
+
+    return Realize( key, result );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの終了処理です. 一時バッファを解放し, 容量超過分を破棄します.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::EndFrame()
+{
+    for( size_t i = 0; i < m_Transient.size(); ++i )
+    { Release( m_Transient[i] ); }
+    m_Transient.clear();
+
+    Evict( m_BudgetBytes );
+    m_FrameIndex++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      頂点バッファの合計が targetBytes 以下になるまで古いエントリを破棄します.
+//      メモリ予算の超過時に呼び出します. 予算そのものは変更しません.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::Trim( UINT64 targetBytes )
+{ Evict( targetBytes ); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+GeometryCache::Stats GeometryCache::GetStats() const
+{
+    Stats result = m_Stats;
+    result.EntryCount  = UINT( m_Entries.size() );
+    result.BufferBytes = m_BufferBytes;
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      スケールが属するスケール帯を求めます. 帯は 1/4 オクターブ刻みです.
+//-------------------------------------------------------------------------------------------------
+int GeometryCache::GetScaleBand( float scale )
+{
+    if ( !( scale > 0.0f ) )
+    { return 0; }
+
+    return int( std::floor( std::log2( scale ) * BANDS_PER_OCTAVE ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スケール帯のテッセレーションに使うスケールを求めます.
+//      帯の上端を使うので, 帯内のどのスケールでも許容誤差を超えません.
+//-------------------------------------------------------------------------------------------------
+float GeometryCache::GetBandScale( int band )
+{ return std::pow( 2.0f, float( band + 1 ) / float( BANDS_PER_OCTAVE ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュからメッシュを検索します.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::Find( const Key& key, GeometryMesh& result )
+{
+    if ( !m_Enabled )
+    { return false; }
+
+    auto itr = m_Entries.find( key );
+    if ( itr == m_Entries.end() )
+    { return false; }
+
+    itr->second.LastFrame = m_FrameIndex;
+    result = itr->second.Mesh;
+    m_Stats.HitCount++;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テッセレーション結果から頂点バッファを生成して登録します.
+//-------------------------------------------------------------------------------------------------
+bool GeometryCache::Realize( const Key& key, GeometryMesh& result )
+{
+    m_Stats.MissCount++;
+    m_Stats.TessellatedVertices += m_Vertices.size();
+
+    result.pVertexBuffer = nullptr;
+    result.VertexCount   = UINT( m_Vertices.size() );
+
+    const UINT bytes = UINT( sizeof(MeshVertex) * m_Vertices.size() );
+    if ( bytes > 0 )
+    {
+        Timer timer;
+
+        D3D11_BUFFER_DESC bd;
+        ZeroMemory( &bd, sizeof(bd) );
+        bd.ByteWidth = bytes;
+        bd.Usage     = D3D11_USAGE_IMMUTABLE;
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA res;
+        ZeroMemory( &res, sizeof(res) );
+        res.pSysMem = m_Vertices.data();
+
+        HRESULT hr = m_pDevice->CreateBuffer( &bd, &res, &result.pVertexBuffer );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            result.VertexCount = 0;
+            return false;
+        }
+
+        if ( m_pTracker != nullptr )
+        { m_pTracker->Track( result.pVertexBuffer, RESOURCE_CATEGORY_VERTEX_BUFFER, bytes ); }
+
+        m_Stats.UploadMsec += timer.GetElapsedMsec();
+    }
+
+    if ( !m_Enabled )
+    {
+        if ( result.pVertexBuffer != nullptr )
+        { m_Transient.push_back( result.pVertexBuffer ); }
+        return true;
+    }
+
+    Entry entry;
+    entry.Mesh      = result;
+    entry.Bytes     = bytes;
+    entry.LastFrame = m_FrameIndex;
+    m_Entries[key]  = entry;
+    m_BufferBytes  += bytes;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      limitBytes を超えている間, 最も長く使われていないエントリを破棄します.
+//      現在のフレームで使用したエントリは描画に使われるので破棄しません.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::Evict( UINT64 limitBytes )
+{
+    while( m_BufferBytes > limitBytes )
+    {
+        auto oldest = m_Entries.end();
+        for( auto itr = m_Entries.begin(); itr != m_Entries.end(); ++itr )
+        {
+            if ( itr->second.LastFrame >= m_FrameIndex )
+            { continue; }
+
+            if ( oldest == m_Entries.end() || itr->second.LastFrame < oldest->second.LastFrame )
+            { oldest = itr; }
+        }
+
+        if ( oldest == m_Entries.end() )
+        { break; }
+
+        m_BufferBytes -= oldest->second.Bytes;
+        Release( oldest->second.Mesh.pVertexBuffer );
+        m_Entries.erase( oldest );
+        m_Stats.EvictCount++;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      頂点バッファの登録を解除して解放します.
+//-------------------------------------------------------------------------------------------------
+void GeometryCache::Release( ID3D11Buffer*& pBuffer )
+{
+    if ( m_pTracker != nullptr )
+    { m_pTracker->Untrack( pBuffer ); }
+    SafeRelease( pBuffer );
+}
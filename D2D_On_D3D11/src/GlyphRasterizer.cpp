@@ -0,0 +1,325 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : GlyphRasterizer.cpp
+// Desc : Analytic Coverage Glyph Rasterizer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <GlyphRasterizer.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const float     FLATTEN_TOLERANCE   = 3.0f;     // 曲線の分割数の係数 (大きいほど細かく分割する).
+const uint32_t  MAX_CURVE_SEGMENTS  = 64;       // 曲線 1 本あたりの分割数の上限.
+
+//-------------------------------------------------------------------------------------------------
+//      曲がり具合 (2 階差分の長さの 2 乗) から曲線の分割数を求めます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t GetSegmentCount( float deviationSq )
+{
+    const uint32_t count = 1 + uint32_t( std::sqrt( std::sqrt( FLATTEN_TOLERANCE * deviationSq ) ) );
+    return std::min( count, MAX_CURVE_SEGMENTS );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2 階差分の長さの 2 乗を求めます.
+//-------------------------------------------------------------------------------------------------
+inline float GetDeviationSq( const float* p0, const float* p1, const float* p2 )
+{
+    const float dx = p0[0] - 2.0f * p1[0] + p2[0];
+    const float dy = p0[1] - 2.0f * p1[1] + p2[1];
+    return dx * dx + dy * dy;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GlyphRasterizer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+GlyphRasterizer::GlyphRasterizer()
+: m_Stride  ( 0 )
+, m_Width   ( 0 )
+, m_Height  ( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+GlyphRasterizer::~GlyphRasterizer()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      輪郭をラスタライズします. scale はフォント単位からピクセルへの倍率で, offsetX, offsetY は
+//      ペン位置の小数部 (サブピクセル位置) です. 各ピクセルのカバレッジは線分が横切る面積から
+//      解析的に求めます (非ゼロ規則の近似として, 巻き数の絶対値を 1 で飽和させます).
+//-------------------------------------------------------------------------------------------------
+bool GlyphRasterizer::Rasterize( const GlyphOutline& outline, float scale, float offsetX, float offsetY, GlyphBitmap& bitmap )
+{
+    bitmap.Left   = 0;
+    bitmap.Top    = 0;
+    bitmap.Width  = 0;
+    bitmap.Height = 0;
+    bitmap.Pixels.clear();
+
+    if ( !( scale > 0.0f ) )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    if ( outline.Points.empty() )
+    { return true; }
+
+    // ピクセル座標 (y は下向き) に変換して範囲を求める.
+    const size_t pointCount = outline.Points.size() / 2;
+    m_Points.resize( pointCount * 2 );
+
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -minX;
+    float maxY = -minY;
+    for( size_t i = 0; i < pointCount; ++i )
+    {
+        const float x =  outline.Points[i * 2 + 0] * scale + offsetX;
+        const float y = -outline.Points[i * 2 + 1] * scale + offsetY;
+        if ( !std::isfinite( x ) || !std::isfinite( y ) )
+        {
+            ELOG( "Error : Invalid Outline." );
+            return false;
+        }
+
+        m_Points[i * 2 + 0] = x;
+        m_Points[i * 2 + 1] = y;
+        minX = std::min( minX, x );
+        minY = std::min( minY, y );
+        maxX = std::max( maxX, x );
+        maxY = std::max( maxY, y );
+    }
+
+    if ( !( maxX - minX < float( MaxBitmapSize ) ) || !( maxY - minY < float( MaxBitmapSize ) ) )
+    {
+        ELOG( "Error : Glyph is too large." );
+        return false;
+    }
+
+    const int left   = int( std::floor( minX ) );
+    const int top    = int( std::floor( minY ) );
+    const int right  = int( std::ceil ( maxX ) );
+    const int bottom = int( std::ceil ( maxY ) );
+
+    m_Width  = uint32_t( std::max( right  - left, 1 ) );
+    m_Height = uint32_t( std::max( bottom - top,  1 ) );
+    m_Stride = m_Width + 2;
+    m_Accumulation.assign( m_Stride * m_Height, 0.0f );
+
+    for( size_t i = 0; i < pointCount; ++i )
+    {
+        m_Points[i * 2 + 0] -= float( left );
+        m_Points[i * 2 + 1] -= float( top );
+    }
+
+    // 輪郭ごとに始点へ戻る線分を補って閉じる.
+    const float* p        = m_Points.data();
+    const float* pEnd     = p + m_Points.size();
+    const float* pStart   = nullptr;
+    const float* pCurrent = nullptr;
+    for( size_t i = 0; i < outline.Commands.size(); ++i )
+    {
+        const uint32_t command = outline.Commands[i];
+        const uint32_t count   = ( command == GLYPH_COMMAND_QUAD_TO ) ? 2 : ( command == GLYPH_COMMAND_CUBIC_TO ) ? 3 : 1;
+        if ( pEnd - p < ptrdiff_t( count * 2 ) )
+        { break; }
+
+        if ( command == GLYPH_COMMAND_MOVE_TO )
+        {
+            if ( pStart != nullptr )
+            { DrawLine( pCurrent[0], pCurrent[1], pStart[0], pStart[1] ); }
+            pStart = p;
+        }
+        else if ( pCurrent == nullptr )
+        { break; }
+        else if ( command == GLYPH_COMMAND_LINE_TO )
+        { DrawLine( pCurrent[0], pCurrent[1], p[0], p[1] ); }
+        else if ( command == GLYPH_COMMAND_QUAD_TO )
+        { DrawQuad( pCurrent, p, p + 2 ); }
+        else
+        { DrawCubic( pCurrent, p, p + 2, p + 4 ); }
+
+        p += count * 2;
+        pCurrent = p - 2;
+    }
+    if ( pStart != nullptr )
+    { DrawLine( pCurrent[0], pCurrent[1], pStart[0], pStart[1] ); }
+
+    // 行ごとに累積和を取ってカバレッジにする.
+    bitmap.Left   = left;
+    bitmap.Top    = top;
+    bitmap.Width  = m_Width;
+    bitmap.Height = m_Height;
+    bitmap.Pixels.resize( m_Width * m_Height );
+
+    for( uint32_t y = 0; y < m_Height; ++y )
+    {
+        const float* pRow = m_Accumulation.data() + y * m_Stride;
+        uint8_t*     pDst = bitmap.Pixels.data() + y * m_Width;
+
+        float sum = 0.0f;
+        for( uint32_t x = 0; x < m_Width; ++x )
+        {
+            sum += pRow[x];
+            const float coverage = std::min( std::fabs( sum ), 1.0f );
+            pDst[x] = uint8_t( coverage * 255.0f + 0.5f );
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      線分が各ピクセルを横切る符号付き面積を累積バッファに加えます.
+//      行内の累積和が線分より右側のピクセルの被覆率になるように, 差分の形で書き込みます.
+//-------------------------------------------------------------------------------------------------
+void GlyphRasterizer::DrawLine( float x0, float y0, float x1, float y1 )
+{
+    if ( y0 == y1 )
+    { return; }
+
+    float dir = 1.0f;
+    if ( y0 > y1 )
+    {
+        std::swap( x0, x1 );
+        std::swap( y0, y1 );
+        dir = -1.0f;
+    }
+
+    const float maxX = float( m_Width );
+    const float dxdy = ( x1 - x0 ) / ( y1 - y0 );
+
+    float x = x0;
+    if ( y0 < 0.0f )
+    {
+        x -= y0 * dxdy;
+        y0 = 0.0f;
+    }
+    y1 = std::min( y1, float( m_Height ) );
+    if ( y0 >= y1 )
+    { return; }
+
+    const uint32_t yBegin = uint32_t( y0 );
+    const uint32_t yEnd   = std::min( uint32_t( std::ceil( y1 ) ), m_Height );
+    for( uint32_t y = yBegin; y < yEnd; ++y )
+    {
+        float* pRow = m_Accumulation.data() + y * m_Stride;
+
+        const float dy    = std::min( float( y + 1 ), y1 ) - std::max( float( y ), y0 );
+        const float xNext = x + dxdy * dy;
+        const float d     = dy * dir;
+
+        const float xa = std::min( std::max( std::min( x, xNext ), 0.0f ), maxX );
+        const float xb = std::min( std::max( std::max( x, xNext ), 0.0f ), maxX );
+
+        const float    xaFloor = std::floor( xa );
+        const uint32_t xai     = uint32_t( xaFloor );
+        const float    xbCeil  = std::ceil( xb );
+        const uint32_t xbi     = uint32_t( xbCeil );
+
+        if ( xbi <= xai + 1 )
+        {
+            // 1 ピクセル内に収まる : 中点の位置で面積を左右に分ける.
+            const float xm = 0.5f * ( xa + xb ) - xaFloor;
+            pRow[xai + 0] += d - d * xm;
+            pRow[xai + 1] += d * xm;
+        }
+        else
+        {
+            // 複数ピクセルにまたがる : 両端は三角形, 間は一定の傾きで面積を配分する.
+            const float s   = 1.0f / ( xb - xa );
+            const float xaf = xa - xaFloor;
+            const float a0  = 0.5f * s * ( 1.0f - xaf ) * ( 1.0f - xaf );
+            const float xbf = xb - xbCeil + 1.0f;
+            const float am  = 0.5f * s * xbf * xbf;
+
+            pRow[xai] += d * a0;
+            if ( xbi == xai + 2 )
+            { pRow[xai + 1] += d * ( 1.0f - a0 - am ); }
+            else
+            {
+                const float a1 = s * ( 1.5f - xaf );
+                pRow[xai + 1] += d * ( a1 - a0 );
+                for( uint32_t xi = xai + 2; xi < xbi - 1; ++xi )
+                { pRow[xi] += d * s; }
+
+                const float a2 = a1 + float( xbi - xai - 3 ) * s;
+                pRow[xbi - 1] += d * ( 1.0f - a2 - am );
+            }
+            pRow[xbi] += d * am;
+        }
+
+        x = xNext;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2 次ベジェ曲線を曲がり具合に応じた数の線分に分割して描画します.
+//-------------------------------------------------------------------------------------------------
+void GlyphRasterizer::DrawQuad( const float* p0, const float* p1, const float* p2 )
+{
+    const uint32_t count = GetSegmentCount( GetDeviationSq( p0, p1, p2 ) );
+    const float    step  = 1.0f / float( count );
+
+    float x = p0[0];
+    float y = p0[1];
+    for( uint32_t i = 1; i <= count; ++i )
+    {
+        const float t  = float( i ) * step;
+        const float mt = 1.0f - t;
+        const float nx = mt * mt * p0[0] + 2.0f * mt * t * p1[0] + t * t * p2[0];
+        const float ny = mt * mt * p0[1] + 2.0f * mt * t * p1[1] + t * t * p2[1];
+        DrawLine( x, y, nx, ny );
+        x = nx;
+        y = ny;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      3 次ベジェ曲線を曲がり具合に応じた数の線分に分割して描画します.
+//-------------------------------------------------------------------------------------------------
+void GlyphRasterizer::DrawCubic( const float* p0, const float* p1, const float* p2, const float* p3 )
+{
+    const float    deviationSq = std::max( GetDeviationSq( p0, p1, p2 ), GetDeviationSq( p1, p2, p3 ) );
+    const uint32_t count       = GetSegmentCount( deviationSq * 2.25f );
+    const float    step        = 1.0f / float( count );
+
+    float x = p0[0];
+    float y = p0[1];
+    for( uint32_t i = 1; i <= count; ++i )
+    {
+        const float t  = float( i ) * step;
+        const float mt = 1.0f - t;
+        const float c0 = mt * mt * mt;
+        const float c1 = 3.0f * mt * mt * t;
+        const float c2 = 3.0f * mt * t * t;
+        const float c3 = t * t * t;
+        const float nx = c0 * p0[0] + c1 * p1[0] + c2 * p2[0] + c3 * p3[0];
+        const float ny = c0 * p0[1] + c1 * p1[1] + c2 * p2[1] + c3 * p3[1];
+        DrawLine( x, y, nx, ny );
+        x = nx;
+        y = ny;
+    }
+}
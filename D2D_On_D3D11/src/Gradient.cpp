@@ -0,0 +1,559 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Gradient.cpp
+// Desc : Gradient Brush Span Generators.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Gradient.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const float PI          = 3.14159265358979f;
+const float TWO_PI      = 6.28318530717959f;
+const float T_LIMIT     = 1048576.0f;       // 床関数を整数変換で求めるための t の上限.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// IndexBlock union
+///////////////////////////////////////////////////////////////////////////////////////////////////
+union IndexBlock
+{
+    __m128i     Vector[2];      //!< SIMD レジスタからの格納先です.
+    int32_t     Index[8];       //!< 色テーブルのインデックスです.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      4要素の床関数です.
+//-------------------------------------------------------------------------------------------------
+inline __m128 Floor4( __m128 v )
+{
+    const __m128 t = _mm_cvtepi32_ps( _mm_cvttps_epi32( v ) );
+    return _mm_sub_ps( t, _mm_and_ps( _mm_cmpgt_ps( t, v ), _mm_set1_ps( 1.0f ) ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      4要素に延長モードを適用し, [0, 1] に収めます.
+//-------------------------------------------------------------------------------------------------
+inline __m128 Extend4( __m128 t, EXTEND_MODE mode )
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps( 1.0f );
+
+    if ( mode == EXTEND_MODE_WRAP )
+    {
+        t = _mm_min_ps( _mm_max_ps( t, _mm_set1_ps( -T_LIMIT ) ), _mm_set1_ps( T_LIMIT ) );
+        t = _mm_sub_ps( t, Floor4( t ) );
+    }
+    else if ( mode == EXTEND_MODE_MIRROR )
+    {
+        t = _mm_min_ps( _mm_max_ps( t, _mm_set1_ps( -T_LIMIT ) ), _mm_set1_ps( T_LIMIT ) );
+
+        // u = t mod 2, t = 1 - |u - 1|.
+        const __m128 u   = _mm_sub_ps( t, _mm_mul_ps( _mm_set1_ps( 2.0f ), Floor4( _mm_mul_ps( t, _mm_set1_ps( 0.5f ) ) ) ) );
+        const __m128 d   = _mm_sub_ps( u, one );
+        const __m128 abs = _mm_andnot_ps( _mm_set1_ps( -0.0f ), d );
+        t = _mm_sub_ps( one, abs );
+    }
+
+    return _mm_min_ps( _mm_max_ps( t, zero ), one );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      [0, 1] の t 8画素分を色テーブルから引いて書き込みます.
+//-------------------------------------------------------------------------------------------------
+inline void StoreLut8( __m128 t0, __m128 t1, const uint32_t* pLut, uint32_t* pDst )
+{
+    const __m128 scale = _mm_set1_ps( float( GradientBrush::LutSize - 1 ) );
+    const __m128 half  = _mm_set1_ps( 0.5f );
+
+    IndexBlock block;
+    block.Vector[0] = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( t0, scale ), half ) );
+    block.Vector[1] = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( t1, scale ), half ) );
+
+    // SSE2 にはギャザー命令が無いのでテーブル参照はスカラーで行う.
+    pDst[0] = pLut[ block.Index[0] ];
+    pDst[1] = pLut[ block.Index[1] ];
+    pDst[2] = pLut[ block.Index[2] ];
+    pDst[3] = pLut[ block.Index[3] ];
+    pDst[4] = pLut[ block.Index[4] ];
+    pDst[5] = pLut[ block.Index[5] ];
+    pDst[6] = pLut[ block.Index[6] ];
+    pDst[7] = pLut[ block.Index[7] ];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      [0, 1] の t を色テーブルのインデックスに変換します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t ToLutIndex( float t )
+{ return uint32_t( t * float( GradientBrush::LutSize - 1 ) + 0.5f ); }
+
+//-------------------------------------------------------------------------------------------------
+//      4要素の atan2 を多項式近似で求めます (最大誤差 約 1e-5 rad).
+//-------------------------------------------------------------------------------------------------
+inline __m128 Atan2_4( __m128 y, __m128 x )
+{
+    const __m128 signMask = _mm_set1_ps( -0.0f );
+    const __m128 ax = _mm_andnot_ps( signMask, x );
+    const __m128 ay = _mm_andnot_ps( signMask, y );
+    const __m128 mn = _mm_min_ps( ax, ay );
+    const __m128 mx = _mm_max_ps( ax, ay );
+
+    // mx が 0 の場合は z = 0 とする.
+    const __m128 valid = _mm_cmpgt_ps( mx, _mm_setzero_ps() );
+    const __m128 z  = _mm_and_ps( _mm_div_ps( mn, _mm_or_ps( mx, _mm_andnot_ps( valid, _mm_set1_ps( 1.0f ) ) ) ), valid );
+    const __m128 z2 = _mm_mul_ps( z, z );
+
+    __m128 p = _mm_set1_ps( 0.0208351f );
+    p = _mm_add_ps( _mm_mul_ps( p, z2 ), _mm_set1_ps( -0.0851330f ) );
+    p = _mm_add_ps( _mm_mul_ps( p, z2 ), _mm_set1_ps(  0.1801410f ) );
+    p = _mm_add_ps( _mm_mul_ps( p, z2 ), _mm_set1_ps( -0.3302995f ) );
+    p = _mm_add_ps( _mm_mul_ps( p, z2 ), _mm_set1_ps(  0.9998660f ) );
+    __m128 a = _mm_mul_ps( p, z );
+
+    // 象限の補正.
+    const __m128 swap = _mm_cmpgt_ps( ay, ax );
+    a = _mm_or_ps( _mm_and_ps( swap, _mm_sub_ps( _mm_set1_ps( PI * 0.5f ), a ) ), _mm_andnot_ps( swap, a ) );
+
+    const __m128 negX = _mm_cmplt_ps( x, _mm_setzero_ps() );
+    a = _mm_or_ps( _mm_and_ps( negX, _mm_sub_ps( _mm_set1_ps( PI ), a ) ), _mm_andnot_ps( negX, a ) );
+
+    return _mm_or_ps( a, _mm_and_ps( y, signMask ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ストレートアルファの色を線形補間します.
+//-------------------------------------------------------------------------------------------------
+inline void LerpColor( const float* a, const float* b, float f, float* result )
+{
+    for( int i = 0; i < 4; ++i )
+    { result[i] = a[i] + ( b[i] - a[i] ) * f; }
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+GradientBrush::GradientBrush()
+: m_ExtendMode( EXTEND_MODE_CLAMP )
+{
+    for( uint32_t i = 0; i < LutSize; ++i )
+    { m_Lut[i] = 0; }
+
+    const float identity[6] = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    for( int i = 0; i < 6; ++i )
+    { m_Inverse[i] = identity[i]; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+GradientBrush::~GradientBrush()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      グラデーションの停止点を設定し, 色テーブルを作り直します.
+//      補間はストレートアルファで行い, テーブルには乗算済みの値を格納します.
+//-------------------------------------------------------------------------------------------------
+bool GradientBrush::SetStops( const GradientStop* pStops, uint32_t count )
+{
+    if ( pStops == nullptr || count == 0 )
+    { return false; }
+
+    m_Stops.assign( pStops, pStops + count );
+    for( size_t i = 0; i < m_Stops.size(); ++i )
+    { m_Stops[i].Position = std::min( std::max( m_Stops[i].Position, 0.0f ), 1.0f ); }
+
+    std::stable_sort( m_Stops.begin(), m_Stops.end(),
+        []( const GradientStop& a, const GradientStop& b ) { return a.Position < b.Position; } );
+
+    for( uint32_t i = 0; i < LutSize; ++i )
+    { m_Lut[i] = EvaluateStops( float( i ) / float( LutSize - 1 ) ); }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      延長モードを設定します.
+//-------------------------------------------------------------------------------------------------
+void GradientBrush::SetExtendMode( EXTEND_MODE mode )
+{ m_ExtendMode = mode; }
+
+//-------------------------------------------------------------------------------------------------
+//      ブラシの変換行列を設定します. 要素の並びは D2D1_MATRIX_3X2_F と同じです.
+//-------------------------------------------------------------------------------------------------
+bool GradientBrush::SetTransform( const float matrix[6] )
+{
+    const float det = matrix[0] * matrix[3] - matrix[1] * matrix[2];
+    if ( std::fabs( det ) < 1e-12f )
+    { return false; }
+
+    const float inv = 1.0f / det;
+    m_Inverse[0] =  matrix[3] * inv;
+    m_Inverse[1] = -matrix[1] * inv;
+    m_Inverse[2] = -matrix[2] * inv;
+    m_Inverse[3] =  matrix[0] * inv;
+    m_Inverse[4] = -( matrix[4] * m_Inverse[0] + matrix[5] * m_Inverse[2] );
+    m_Inverse[5] = -( matrix[4] * m_Inverse[1] + matrix[5] * m_Inverse[3] );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      矩形 [x0, x1) x [y0, y1) を塗りつぶします. サーフェイス外は切り取ります.
+//-------------------------------------------------------------------------------------------------
+void GradientBrush::FillRect( Surface& surface, int x0, int y0, int x1, int y1 ) const
+{
+    x0 = std::max( x0, 0 );
+    y0 = std::max( y0, 0 );
+    x1 = std::min( x1, int( surface.GetWidth () ) );
+    y1 = std::min( y1, int( surface.GetHeight() ) );
+    if ( x0 >= x1 || y0 >= y1 )
+    { return; }
+
+    for( int y = y0; y < y1; ++y )
+    { FillSpan( x0, y, uint32_t( x1 - x0 ), surface.GetRow( uint32_t( y ) ) + x0 ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      FillRect() の比較用です. 画素ごとに停止点を評価します.
+//-------------------------------------------------------------------------------------------------
+void GradientBrush::FillRectReference( Surface& surface, int x0, int y0, int x1, int y1 ) const
+{
+    x0 = std::max( x0, 0 );
+    y0 = std::max( y0, 0 );
+    x1 = std::min( x1, int( surface.GetWidth () ) );
+    y1 = std::min( y1, int( surface.GetHeight() ) );
+    if ( x0 >= x1 || y0 >= y1 )
+    { return; }
+
+    for( int y = y0; y < y1; ++y )
+    { FillSpanReference( x0, y, uint32_t( x1 - x0 ), surface.GetRow( uint32_t( y ) ) + x0 ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      色テーブルを使わず, 画素ごとに停止点を評価してスパンを生成します.
+//-------------------------------------------------------------------------------------------------
+void GradientBrush::FillSpanReference( int x, int y, uint32_t count, uint32_t* pDst ) const
+{
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        float gx, gy;
+        MapPoint( float( x + int( i ) ) + 0.5f, float( y ) + 0.5f, gx, gy );
+        pDst[i] = EvaluateStops( ApplyExtend( ComputeT( gx, gy ) ) );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デバイス座標をグラデーション空間に変換します.
+//-------------------------------------------------------------------------------------------------
+void GradientBrush::MapPoint( float px, float py, float& gx, float& gy ) const
+{
+    gx = px * m_Inverse[0] + py * m_Inverse[2] + m_Inverse[4];
+    gy = px * m_Inverse[1] + py * m_Inverse[3] + m_Inverse[5];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      延長モードを適用し, [0, 1] に収めます.
+//-------------------------------------------------------------------------------------------------
+float GradientBrush::ApplyExtend( float t ) const
+{
+    t = std::min( std::max( t, -T_LIMIT ), T_LIMIT );
+
+    if ( m_ExtendMode == EXTEND_MODE_WRAP )
+    { t -= std::floor( t ); }
+    else if ( m_ExtendMode == EXTEND_MODE_MIRROR )
+    { t = 1.0f - std::fabs( t - 2.0f * std::floor( t * 0.5f ) - 1.0f ); }
+
+    return std::min( std::max( t, 0.0f ), 1.0f );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      停止点を評価して乗算済み B8G8R8A8 を求めます.
+//-------------------------------------------------------------------------------------------------
+uint32_t GradientBrush::EvaluateStops( float t ) const
+{
+    if ( m_Stops.empty() )
+    { return 0; }
+
+    const GradientStop& first = m_Stops.front();
+    const GradientStop& last  = m_Stops.back();
+
+    float color[4];
+    if ( t <= first.Position )
+    { LerpColor( first.Color, first.Color, 0.0f, color ); }
+    else if ( t >= last.Position )
+    { LerpColor( last.Color, last.Color, 0.0f, color ); }
+    else
+    {
+        size_t k = 1;
+        while( k + 1 < m_Stops.size() && m_Stops[k].Position < t )
+        { ++k; }
+
+        const GradientStop& a = m_Stops[k - 1];
+        const GradientStop& b = m_Stops[k];
+        const float range = b.Position - a.Position;
+        const float f = ( range > 0.0f ) ? ( t - a.Position ) / range : 1.0f;
+        LerpColor( a.Color, b.Color, f, color );
+    }
+
+    return Surface::PackColor( color[0], color[1], color[2], color[3] );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LinearGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+LinearGradientBrush::LinearGradientBrush()
+: m_StartX  ( 0.0f )
+, m_StartY  ( 0.0f )
+, m_DirX    ( 1.0f )
+, m_DirY    ( 0.0f )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+LinearGradientBrush::~LinearGradientBrush()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      始点と終点を設定します.
+//-------------------------------------------------------------------------------------------------
+void LinearGradientBrush::SetPoints( float x0, float y0, float x1, float y1 )
+{
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float lengthSq = dx * dx + dy * dy;
+
+    m_StartX = x0;
+    m_StartY = y0;
+    m_DirX   = ( lengthSq > 0.0f ) ? dx / lengthSq : 0.0f;
+    m_DirY   = ( lengthSq > 0.0f ) ? dy / lengthSq : 0.0f;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スパンを生成します. t は x に対して線形なので, 8画素ずつ t を求めて表を引きます.
+//-------------------------------------------------------------------------------------------------
+void LinearGradientBrush::FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const
+{
+    float gx, gy;
+    MapPoint( float( x ) + 0.5f, float( y ) + 0.5f, gx, gy );
+
+    const float t0 = ComputeT( gx, gy );
+    const float dt = m_Inverse[0] * m_DirX + m_Inverse[1] * m_DirY;
+
+    const __m128 vt0   = _mm_set1_ps( t0 );
+    const __m128 vdt   = _mm_set1_ps( dt );
+    const __m128 lane  = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+    const __m128 four  = _mm_set1_ps( 4.0f );
+
+    uint32_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        // 累積による誤差を避けるため毎回 t0 + i * dt で求める.
+        const __m128 idx0 = _mm_add_ps( _mm_set1_ps( float( i ) ), lane );
+        const __m128 idx1 = _mm_add_ps( idx0, four );
+        const __m128 ta   = Extend4( _mm_add_ps( vt0, _mm_mul_ps( idx0, vdt ) ), m_ExtendMode );
+        const __m128 tb   = Extend4( _mm_add_ps( vt0, _mm_mul_ps( idx1, vdt ) ), m_ExtendMode );
+        StoreLut8( ta, tb, m_Lut, pDst + i );
+    }
+
+    for( ; i < count; ++i )
+    { pDst[i] = m_Lut[ ToLutIndex( ApplyExtend( t0 + float( i ) * dt ) ) ]; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      始点から終点方向への射影で t を求めます.
+//-------------------------------------------------------------------------------------------------
+float LinearGradientBrush::ComputeT( float gx, float gy ) const
+{ return ( gx - m_StartX ) * m_DirX + ( gy - m_StartY ) * m_DirY; }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RadialGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+RadialGradientBrush::RadialGradientBrush()
+: m_CenterX     ( 0.0f )
+, m_CenterY     ( 0.0f )
+, m_InvRadiusX  ( 1.0f )
+, m_InvRadiusY  ( 1.0f )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+RadialGradientBrush::~RadialGradientBrush()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      中心と半径を設定します. 焦点のずれ (GradientOriginOffset) には対応しません.
+//-------------------------------------------------------------------------------------------------
+void RadialGradientBrush::SetEllipse( float centerX, float centerY, float radiusX, float radiusY )
+{
+    m_CenterX    = centerX;
+    m_CenterY    = centerY;
+    m_InvRadiusX = ( radiusX > 0.0f ) ? 1.0f / radiusX : 0.0f;
+    m_InvRadiusY = ( radiusY > 0.0f ) ? 1.0f / radiusY : 0.0f;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スパンを生成します. 正規化した中心からの距離を 8画素ずつ求めて表を引きます.
+//-------------------------------------------------------------------------------------------------
+void RadialGradientBrush::FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const
+{
+    float gx, gy;
+    MapPoint( float( x ) + 0.5f, float( y ) + 0.5f, gx, gy );
+
+    const float u0 = ( gx - m_CenterX ) * m_InvRadiusX;
+    const float v0 = ( gy - m_CenterY ) * m_InvRadiusY;
+    const float du = m_Inverse[0] * m_InvRadiusX;
+    const float dv = m_Inverse[1] * m_InvRadiusY;
+
+    const __m128 vu0  = _mm_set1_ps( u0 );
+    const __m128 vv0  = _mm_set1_ps( v0 );
+    const __m128 vdu  = _mm_set1_ps( du );
+    const __m128 vdv  = _mm_set1_ps( dv );
+    const __m128 lane = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+    const __m128 four = _mm_set1_ps( 4.0f );
+
+    uint32_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m128 idx0 = _mm_add_ps( _mm_set1_ps( float( i ) ), lane );
+        const __m128 idx1 = _mm_add_ps( idx0, four );
+
+        const __m128 ua = _mm_add_ps( vu0, _mm_mul_ps( idx0, vdu ) );
+        const __m128 va = _mm_add_ps( vv0, _mm_mul_ps( idx0, vdv ) );
+        const __m128 ub = _mm_add_ps( vu0, _mm_mul_ps( idx1, vdu ) );
+        const __m128 vb = _mm_add_ps( vv0, _mm_mul_ps( idx1, vdv ) );
+
+        const __m128 ta = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( ua, ua ), _mm_mul_ps( va, va ) ) );
+        const __m128 tb = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( ub, ub ), _mm_mul_ps( vb, vb ) ) );
+        StoreLut8( Extend4( ta, m_ExtendMode ), Extend4( tb, m_ExtendMode ), m_Lut, pDst + i );
+    }
+
+    for( ; i < count; ++i )
+    {
+        const float u = u0 + float( i ) * du;
+        const float v = v0 + float( i ) * dv;
+        pDst[i] = m_Lut[ ToLutIndex( ApplyExtend( std::sqrt( u * u + v * v ) ) ) ];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      楕円で正規化した中心からの距離を t とします.
+//-------------------------------------------------------------------------------------------------
+float RadialGradientBrush::ComputeT( float gx, float gy ) const
+{
+    const float u = ( gx - m_CenterX ) * m_InvRadiusX;
+    const float v = ( gy - m_CenterY ) * m_InvRadiusY;
+    return std::sqrt( u * u + v * v );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SweepGradientBrush class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SweepGradientBrush::SweepGradientBrush()
+: m_CenterX     ( 0.0f )
+, m_CenterY     ( 0.0f )
+, m_StartTurn   ( 0.0f )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SweepGradientBrush::~SweepGradientBrush()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      中心と開始角度 (ラジアン) を設定します.
+//-------------------------------------------------------------------------------------------------
+void SweepGradientBrush::SetCenter( float centerX, float centerY, float startAngle )
+{
+    m_CenterX   = centerX;
+    m_CenterY   = centerY;
+    m_StartTurn = startAngle / TWO_PI;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スパンを生成します. 角度は1周で必ず繰り返すので延長モードは影響しません.
+//-------------------------------------------------------------------------------------------------
+void SweepGradientBrush::FillSpan( int x, int y, uint32_t count, uint32_t* pDst ) const
+{
+    float gx, gy;
+    MapPoint( float( x ) + 0.5f, float( y ) + 0.5f, gx, gy );
+
+    const float dx0 = gx - m_CenterX;
+    const float dy0 = gy - m_CenterY;
+    const float ddx = m_Inverse[0];
+    const float ddy = m_Inverse[1];
+
+    const __m128 vdx0   = _mm_set1_ps( dx0 );
+    const __m128 vdy0   = _mm_set1_ps( dy0 );
+    const __m128 vddx   = _mm_set1_ps( ddx );
+    const __m128 vddy   = _mm_set1_ps( ddy );
+    const __m128 lane   = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+    const __m128 four   = _mm_set1_ps( 4.0f );
+    const __m128 toTurn = _mm_set1_ps( 1.0f / TWO_PI );
+    const __m128 start  = _mm_set1_ps( m_StartTurn );
+
+    uint32_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m128 idx0 = _mm_add_ps( _mm_set1_ps( float( i ) ), lane );
+        const __m128 idx1 = _mm_add_ps( idx0, four );
+
+        __m128 ta = _mm_sub_ps( _mm_mul_ps( Atan2_4( _mm_add_ps( vdy0, _mm_mul_ps( idx0, vddy ) ),
+                                                     _mm_add_ps( vdx0, _mm_mul_ps( idx0, vddx ) ) ), toTurn ), start );
+        __m128 tb = _mm_sub_ps( _mm_mul_ps( Atan2_4( _mm_add_ps( vdy0, _mm_mul_ps( idx1, vddy ) ),
+                                                     _mm_add_ps( vdx0, _mm_mul_ps( idx1, vddx ) ) ), toTurn ), start );
+        ta = Extend4( ta, EXTEND_MODE_WRAP );
+        tb = Extend4( tb, EXTEND_MODE_WRAP );
+        StoreLut8( ta, tb, m_Lut, pDst + i );
+    }
+
+    for( ; i < count; ++i )
+    {
+        float t = ComputeT( gx + float( i ) * ddx, gy + float( i ) * ddy );
+        pDst[i] = m_Lut[ ToLutIndex( t ) ];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      中心周りの角度を [0, 1) の t とします.
+//-------------------------------------------------------------------------------------------------
+float SweepGradientBrush::ComputeT( float gx, float gy ) const
+{
+    float t = std::atan2( gy - m_CenterY, gx - m_CenterX ) / TWO_PI - m_StartTurn;
+    t -= std::floor( t );
+    return std::min( t, 1.0f );
+}
@@ -0,0 +1,376 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : InitGraph.cpp
+// Desc : Dependency Graph of Initialization Tasks.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <InitGraph.h>
+#include <Logger.h>
+#include <ThreadPool.h>
+#include <Timer.h>
+#include <cstdio>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  INVALID_TASK   = UINT32_MAX;    //!< 無効なタスク番号です.
+const uint32_t  TIMELINE_WIDTH = 48;            //!< タイムラインの横幅 (文字数) です.
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// InitGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+InitGraph::InitGraph()
+: m_pPool       ( nullptr )
+, m_DoneCount   ( 0 )
+, m_BaseTicks   ( 0 )
+, m_TotalTicks  ( 0 )
+, m_Failed      ( false )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+InitGraph::~InitGraph()
+{ Clear(); }
+
+//-------------------------------------------------------------------------------------------------
+//      タスクを追加します. mainThread が true の場合は Run() を呼び出したスレッドで実行します.
+//-------------------------------------------------------------------------------------------------
+uint32_t InitGraph::AddTask( const char* name, const Task& task, bool mainThread )
+{
+    TaskInfo info;
+    info.Func       = task;
+    info.MainThread = mainThread;
+    info.Remaining  = 0;
+
+    info.Result.Name        = ( name != nullptr ) ? name : "";
+    info.Result.State       = INIT_TASK_STATE_PENDING;
+    info.Result.ThreadIndex = 0;
+    info.Result.ReadyTicks  = 0;
+    info.Result.BeginTicks  = 0;
+    info.Result.EndTicks    = 0;
+    info.Result.Critical    = false;
+
+    m_Tasks.push_back( info );
+    return uint32_t( m_Tasks.size() - 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      task が dependsOn の完了後に実行されるように依存関係を追加します.
+//-------------------------------------------------------------------------------------------------
+bool InitGraph::AddDependency( uint32_t task, uint32_t dependsOn )
+{
+    if ( task >= m_Tasks.size() || dependsOn >= m_Tasks.size() || task == dependsOn )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_Tasks[task]     .Dependencies.push_back( dependsOn );
+    m_Tasks[dependsOn].Successors  .push_back( task );
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      依存関係の順にタスクを実行し, 全て完了するまで待機します.
+//      pPool が nullptr の場合は全てのタスクを呼び出し元のスレッドで直列に実行します.
+//-------------------------------------------------------------------------------------------------
+bool InitGraph::Run( ThreadPool* pPool )
+{
+    const uint32_t count = uint32_t( m_Tasks.size() );
+
+    // 循環している依存関係が無いか確認する.
+    {
+        std::vector<uint32_t> remaining( count );
+        std::vector<uint32_t> stack;
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            remaining[i] = uint32_t( m_Tasks[i].Dependencies.size() );
+            if ( remaining[i] == 0 )
+            { stack.push_back( i ); }
+        }
+
+        uint32_t visited = 0;
+        while( !stack.empty() )
+        {
+            const uint32_t index = stack.back();
+            stack.pop_back();
+            visited++;
+
+            const std::vector<uint32_t>& successors = m_Tasks[index].Successors;
+            for( size_t i = 0; i < successors.size(); ++i )
+            {
+                if ( --remaining[successors[i]] == 0 )
+                { stack.push_back( successors[i] ); }
+            }
+        }
+
+        if ( visited != count )
+        {
+            ELOG( "Error : Init Task Dependency Cycle Detected." );
+            return false;
+        }
+    }
+
+    std::unique_lock<std::mutex> locker( m_Mutex );
+
+    m_pPool      = ( pPool != nullptr && pPool->GetThreadCount() > 0 ) ? pPool : nullptr;
+    m_DoneCount  = 0;
+    m_TotalTicks = 0;
+    m_Failed     = false;
+    m_MainQueue.clear();
+    m_ThreadIds.clear();
+    m_ThreadIds.push_back( std::this_thread::get_id() );
+
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        Record& record = m_Tasks[i].Result;
+        record.State       = INIT_TASK_STATE_PENDING;
+        record.ThreadIndex = 0;
+        record.ReadyTicks  = 0;
+        record.BeginTicks  = 0;
+        record.EndTicks    = 0;
+        record.Critical    = false;
+        m_Tasks[i].Remaining = uint32_t( m_Tasks[i].Dependencies.size() );
+    }
+
+    m_BaseTicks = Timer::GetTicks();
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        if ( m_Tasks[i].Remaining == 0 )
+        { Schedule( i, 0 ); }
+    }
+
+    // 呼び出し元スレッドで実行するタスクを処理しながら全ての完了を待つ.
+    while( m_DoneCount < count )
+    {
+        if ( !m_MainQueue.empty() )
+        {
+            const uint32_t index = m_MainQueue.front();
+            m_MainQueue.pop_front();
+
+            locker.unlock();
+            Execute( index );
+            locker.lock();
+            continue;
+        }
+
+        m_Cond.wait( locker );
+    }
+
+    m_TotalTicks = Timer::GetTicks() - m_BaseTicks;
+    m_pPool      = nullptr;
+    MarkCriticalPath();
+
+    return !m_Failed;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全てのタスクを削除します.
+//-------------------------------------------------------------------------------------------------
+void InitGraph::Clear()
+{
+    m_Tasks    .clear();
+    m_MainQueue.clear();
+    m_ThreadIds.clear();
+    m_DoneCount  = 0;
+    m_TotalTicks = 0;
+    m_Failed     = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      タスク数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t InitGraph::GetTaskCount() const
+{ return uint32_t( m_Tasks.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      タスクの実行記録を取得します.
+//-------------------------------------------------------------------------------------------------
+const InitGraph::Record& InitGraph::GetRecord( uint32_t index ) const
+{ return m_Tasks[index].Result; }
+
+//-------------------------------------------------------------------------------------------------
+//      最後に完了したタスクから, 実行を待たせていた依存タスクを辿った経路を開始順に取得します.
+//-------------------------------------------------------------------------------------------------
+std::vector<uint32_t> InitGraph::GetCriticalPath() const
+{
+    std::vector<uint32_t> result;
+    for( uint32_t i = 0; i < m_Tasks.size(); ++i )
+    {
+        if ( m_Tasks[i].Result.Critical )
+        { result.push_back( i ); }
+    }
+
+    for( size_t i = 1; i < result.size(); ++i )
+    {
+        const uint32_t index = result[i];
+        size_t j = i;
+        for( ; j > 0 && m_Tasks[result[j - 1]].Result.BeginTicks > m_Tasks[index].Result.BeginTicks; --j )
+        { result[j] = result[j - 1]; }
+        result[j] = index;
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      直前の Run() の所要時間をミリ秒単位で取得します.
+//-------------------------------------------------------------------------------------------------
+double InitGraph::GetTotalMsec() const
+{ return Timer::ToMsec( m_TotalTicks ); }
+
+//-------------------------------------------------------------------------------------------------
+//      直前の Run() のタイムラインを標準出力に表示します.
+//      '.' は依存タスクの完了から実行開始までの待ち, '#' は実行中, '*' はクリティカルパスを表します.
+//-------------------------------------------------------------------------------------------------
+void InitGraph::PrintTimeline() const
+{
+    const double total = ( m_TotalTicks > 0 ) ? double( m_TotalTicks ) : 1.0;
+
+    std::printf( "Startup Timeline : %u tasks, %u threads, total %.3f ms\n",
+        GetTaskCount(), uint32_t( m_ThreadIds.size() ), GetTotalMsec() );
+    std::printf( "  %-16s thread  ready(ms) begin(ms)   end(ms)\n", "task" );
+
+    for( uint32_t i = 0; i < m_Tasks.size(); ++i )
+    {
+        const Record& record = m_Tasks[i].Result;
+
+        char bar[TIMELINE_WIDTH + 1];
+        const uint32_t ready = uint32_t( double( record.ReadyTicks ) / total * TIMELINE_WIDTH );
+        const uint32_t begin = uint32_t( double( record.BeginTicks ) / total * TIMELINE_WIDTH );
+        uint32_t       end   = uint32_t( double( record.EndTicks   ) / total * TIMELINE_WIDTH + 0.999 );
+        if ( end <= begin )
+        { end = begin + 1; }
+
+        for( uint32_t x = 0; x < TIMELINE_WIDTH; ++x )
+        { bar[x] = ( x >= begin && x < end ) ? '#' : ( x >= ready && x < begin ) ? '.' : ' '; }
+        bar[TIMELINE_WIDTH] = '\0';
+
+        static const char* states[] = { "pending", "", "FAILED", "skipped" };
+        std::printf( "  %-16s %6u %10.3f %9.3f %9.3f |%s| %s%s\n",
+            record.Name.c_str(), record.ThreadIndex,
+            Timer::ToMsec( record.ReadyTicks ), Timer::ToMsec( record.BeginTicks ), Timer::ToMsec( record.EndTicks ),
+            bar, record.Critical ? "*" : " ", states[record.State] );
+    }
+
+    const std::vector<uint32_t> path = GetCriticalPath();
+    int64_t busy = 0;
+    std::printf( "  critical path : " );
+    for( size_t i = 0; i < path.size(); ++i )
+    {
+        const Record& record = m_Tasks[path[i]].Result;
+        busy += record.EndTicks - record.BeginTicks;
+        std::printf( "%s%s", ( i > 0 ) ? " -> " : "", record.Name.c_str() );
+    }
+    std::printf( " (%.3f ms running, %.3f ms waiting)\n", Timer::ToMsec( busy ), Timer::ToMsec( m_TotalTicks - busy ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      実行の準備ができたタスクを実行先に積みます. ロックを保持した状態で呼び出します.
+//-------------------------------------------------------------------------------------------------
+void InitGraph::Schedule( uint32_t index, int64_t now )
+{
+    TaskInfo& info = m_Tasks[index];
+    info.Result.ReadyTicks = now;
+
+    if ( m_pPool == nullptr || info.MainThread )
+    {
+        m_MainQueue.push_back( index );
+        m_Cond.notify_all();
+        return;
+    }
+
+    m_pPool->Submit( [this, index]() { Execute( index ); } );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      タスクを実行し, 完了を後続のタスクに伝えます.
+//-------------------------------------------------------------------------------------------------
+void InitGraph::Execute( uint32_t index )
+{
+    TaskInfo& info = m_Tasks[index];
+
+    // 失敗したタスクがあれば以降は実行せず, 完了の伝搬だけを行う.
+    bool skip;
+    {
+        std::lock_guard<std::mutex> locker( m_Mutex );
+        skip = m_Failed;
+    }
+
+    const int64_t begin   = Timer::GetTicks() - m_BaseTicks;
+    const bool    success = !skip && info.Func();
+    const int64_t end     = Timer::GetTicks() - m_BaseTicks;
+
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    const std::thread::id id = std::this_thread::get_id();
+    uint32_t thread = 0;
+    while( thread < m_ThreadIds.size() && m_ThreadIds[thread] != id )
+    { thread++; }
+    if ( thread == m_ThreadIds.size() )
+    { m_ThreadIds.push_back( id ); }
+
+    Record& record = info.Result;
+    record.ThreadIndex = thread;
+    record.BeginTicks  = begin;
+    record.EndTicks    = end;
+    record.State       = skip ? INIT_TASK_STATE_SKIPPED : success ? INIT_TASK_STATE_DONE : INIT_TASK_STATE_FAILED;
+
+    if ( !skip && !success )
+    {
+        ELOG( "Error : Init Task Failed. name = %s", record.Name.c_str() );
+        m_Failed = true;
+    }
+
+    for( size_t i = 0; i < info.Successors.size(); ++i )
+    {
+        const uint32_t next = info.Successors[i];
+        if ( --m_Tasks[next].Remaining == 0 )
+        { Schedule( next, end ); }
+    }
+
+    // Run() はロックを取得するまで戻らないので, 通知はロックを保持したまま行う.
+    m_DoneCount++;
+    m_Cond.notify_all();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      最後に完了したタスクから, 最も遅く完了した依存タスクを辿ってクリティカルパスに印を付けます.
+//-------------------------------------------------------------------------------------------------
+void InitGraph::MarkCriticalPath()
+{
+    uint32_t index = INVALID_TASK;
+    for( uint32_t i = 0; i < m_Tasks.size(); ++i )
+    {
+        if ( index == INVALID_TASK || m_Tasks[i].Result.EndTicks > m_Tasks[index].Result.EndTicks )
+        { index = i; }
+    }
+
+    while( index != INVALID_TASK )
+    {
+        m_Tasks[index].Result.Critical = true;
+
+        const std::vector<uint32_t>& deps = m_Tasks[index].Dependencies;
+        uint32_t next = INVALID_TASK;
+        for( size_t i = 0; i < deps.size(); ++i )
+        {
+            if ( next == INVALID_TASK || m_Tasks[deps[i]].Result.EndTicks > m_Tasks[next].Result.EndTicks )
+            { next = deps[i]; }
+        }
+        index = next;
+    }
+}
@@ -0,0 +1,388 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : InputLatency.cpp
+// Desc : Input-to-Present Latency Tracker.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <InputLatency.h>
+#include <Timer.h>
+#include <cstring>
+#include <chrono>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LatencyHistogram class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+{ Reset(); }
+
+//-------------------------------------------------------------------------------------------------
+//      サンプルを追加します.
+//-------------------------------------------------------------------------------------------------
+void LatencyHistogram::AddSample( uint64_t usec )
+{
+    uint64_t bucket = usec / BucketUsec;
+    if ( bucket > BucketCount )
+    { bucket = BucketCount; }
+
+    m_Buckets[bucket]++;
+    m_Count++;
+    m_SumUsec += usec;
+    if ( usec > m_MaxUsec )
+    { m_MaxUsec = usec; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リセットします.
+//-------------------------------------------------------------------------------------------------
+void LatencyHistogram::Reset()
+{
+    memset( m_Buckets, 0, sizeof(m_Buckets) );
+    m_Count   = 0;
+    m_SumUsec = 0;
+    m_MaxUsec = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サンプル数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::GetCount() const
+{ return m_Count; }
+
+//-------------------------------------------------------------------------------------------------
+//      平均値をミリ秒単位で取得します.
+//-------------------------------------------------------------------------------------------------
+double LatencyHistogram::GetMeanMsec() const
+{ return ( m_Count > 0 ) ? double( m_SumUsec ) / double( m_Count ) / 1000.0 : 0.0; }
+
+//-------------------------------------------------------------------------------------------------
+//      最大値をミリ秒単位で取得します.
+//-------------------------------------------------------------------------------------------------
+double LatencyHistogram::GetMaxMsec() const
+{ return double( m_MaxUsec ) / 1000.0; }
+
+//-------------------------------------------------------------------------------------------------
+//      パーセンタイル値をミリ秒単位で取得します. 値はバケットの上端 (最大値以下) です.
+//-------------------------------------------------------------------------------------------------
+double LatencyHistogram::GetPercentileMsec( double percentile ) const
+{
+    if ( m_Count == 0 )
+    { return 0.0; }
+
+    const uint64_t rank = uint64_t( double( m_Count ) * percentile / 100.0 + 0.5 );
+
+    uint64_t accum = 0;
+    for( uint32_t i = 0; i < BucketCount; ++i )
+    {
+        accum += m_Buckets[i];
+        if ( accum >= rank && accum > 0 )
+        {
+            const uint64_t upper = uint64_t( i + 1 ) * BucketUsec;
+            return double( ( upper < m_MaxUsec ) ? upper : m_MaxUsec ) / 1000.0;
+        }
+    }
+
+    return GetMaxMsec();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// InputLatencyTracker class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::InputLatencyTracker()
+: m_pCells      ( nullptr )
+, m_Mask        ( 0 )
+, m_EnqueuePos  ( 0 )
+, m_DequeuePos  ( 0 )
+, m_DroppedCount( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::~InputLatencyTracker()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. capacity は2のべき乗に切り上げられます.
+//-------------------------------------------------------------------------------------------------
+bool InputLatencyTracker::Init( uint32_t capacity )
+{
+    Term();
+
+    size_t size = 2;
+    while( size < capacity )
+    { size <<= 1; }
+
+    m_pCells = new Cell[size];
+    for( size_t i = 0; i < size; ++i )
+    { m_pCells[i].Sequence.store( i, std::memory_order_relaxed ); }
+
+    m_Mask = size - 1;
+    m_EnqueuePos  .store( 0 );
+    m_DequeuePos  .store( 0 );
+    m_DroppedCount.store( 0 );
+
+    m_FrameEvents.reserve( size );
+
+    for( uint32_t i = 0; i < INPUT_EVENT_COUNT; ++i )
+    { m_Histograms[i].Reset(); }
+    m_Total .Reset();
+    m_Recent.Reset();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void InputLatencyTracker::Term()
+{
+    delete [] m_pCells;
+    m_pCells = nullptr;
+    m_Mask   = 0;
+    m_FrameEvents.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入力イベントを登録します. 任意のスレッドからロックなしで呼び出せます.
+//      リングバッファが満杯の場合は破棄して false を返します.
+//-------------------------------------------------------------------------------------------------
+bool InputLatencyTracker::PushEvent( INPUT_EVENT_TYPE type, int64_t timestamp )
+{
+    if ( m_pCells == nullptr )
+    { return false; }
+
+    Cell*  pCell = nullptr;
+    size_t pos   = m_EnqueuePos.load( std::memory_order_relaxed );
+
+    for( ;; )
+    {
+        pCell = &m_pCells[ pos & m_Mask ];
+        const size_t   seq  = pCell->Sequence.load( std::memory_order_acquire );
+        const intptr_t diff = intptr_t( seq ) - intptr_t( pos );
+
+        if ( diff == 0 )
+        {
+            if ( m_EnqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+            { break; }
+        }
+        else if ( diff < 0 )
+        {
+            m_DroppedCount.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+        else
+        { pos = m_EnqueuePos.load( std::memory_order_relaxed ); }
+    }
+
+    pCell->Data.Type      = type;
+    pCell->Data.Timestamp = timestamp;
+    pCell->Sequence.store( pos + 1, std::memory_order_release );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの開始処理です. ここまでに到着したイベントをこのフレームに割り当てます.
+//-------------------------------------------------------------------------------------------------
+void InputLatencyTracker::BeginFrame()
+{
+    Event evt;
+    while( PopEvent( evt ) )
+    { m_FrameEvents.push_back( evt ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの終了処理です. Present() の直後の時刻を渡してください.
+//-------------------------------------------------------------------------------------------------
+void InputLatencyTracker::EndFrame( int64_t presentTicks )
+{
+    const int64_t ticksPerSec = Timer::GetTicksPerSec();
+
+    for( size_t i = 0; i < m_FrameEvents.size(); ++i )
+    {
+        const Event& evt = m_FrameEvents[i];
+        const int64_t ticks = ( presentTicks > evt.Timestamp ) ? presentTicks - evt.Timestamp : 0;
+        const uint64_t usec = uint64_t( ticks ) * 1000000 / uint64_t( ticksPerSec );
+
+        m_Histograms[evt.Type].AddSample( usec );
+        m_Total .AddSample( usec );
+        m_Recent.AddSample( usec );
+    }
+
+    m_FrameEvents.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      イベント種別ごとの集計結果を取得します. 描画スレッドから呼び出してください.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::Summary InputLatencyTracker::GetSummary( INPUT_EVENT_TYPE type ) const
+{ return MakeSummary( m_Histograms[type] ); }
+
+//-------------------------------------------------------------------------------------------------
+//      全イベントの集計結果を取得します.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::Summary InputLatencyTracker::GetTotalSummary() const
+{ return MakeSummary( m_Total ); }
+
+//-------------------------------------------------------------------------------------------------
+//      前回の ResetRecent() 以降の集計結果を取得します.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::Summary InputLatencyTracker::GetRecentSummary() const
+{ return MakeSummary( m_Recent ); }
+
+//-------------------------------------------------------------------------------------------------
+//      直近の集計をリセットします.
+//-------------------------------------------------------------------------------------------------
+void InputLatencyTracker::ResetRecent()
+{ m_Recent.Reset(); }
+
+//-------------------------------------------------------------------------------------------------
+//      リングバッファ溢れで破棄されたイベント数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t InputLatencyTracker::GetDroppedCount() const
+{ return m_DroppedCount.load( std::memory_order_relaxed ); }
+
+//-------------------------------------------------------------------------------------------------
+//      イベントを1つ取り出します.
+//-------------------------------------------------------------------------------------------------
+bool InputLatencyTracker::PopEvent( Event& result )
+{
+    if ( m_pCells == nullptr )
+    { return false; }
+
+    Cell*  pCell = nullptr;
+    size_t pos   = m_DequeuePos.load( std::memory_order_relaxed );
+
+    for( ;; )
+    {
+        pCell = &m_pCells[ pos & m_Mask ];
+        const size_t   seq  = pCell->Sequence.load( std::memory_order_acquire );
+        const intptr_t diff = intptr_t( seq ) - intptr_t( pos + 1 );
+
+        if ( diff == 0 )
+        {
+            if ( m_DequeuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+            { break; }
+        }
+        else if ( diff < 0 )
+        { return false; }
+        else
+        { pos = m_DequeuePos.load( std::memory_order_relaxed ); }
+    }
+
+    result = pCell->Data;
+    pCell->Sequence.store( pos + m_Mask + 1, std::memory_order_release );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ヒストグラムから集計結果を作成します.
+//-------------------------------------------------------------------------------------------------
+InputLatencyTracker::Summary InputLatencyTracker::MakeSummary( const LatencyHistogram& histogram )
+{
+    Summary result;
+    result.Count    = histogram.GetCount();
+    result.MeanMsec = histogram.GetMeanMsec();
+    result.P50Msec  = histogram.GetPercentileMsec( 50.0 );
+    result.P95Msec  = histogram.GetPercentileMsec( 95.0 );
+    result.P99Msec  = histogram.GetPercentileMsec( 99.0 );
+    result.MaxMsec  = histogram.GetMaxMsec();
+
+    return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SyntheticInputGenerator class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SyntheticInputGenerator::SyntheticInputGenerator()
+: m_Running     ( false )
+, m_EmittedCount( 0 )
+, m_EventsPerSec( 0.0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SyntheticInputGenerator::~SyntheticInputGenerator()
+{ Stop(); }
+
+//-------------------------------------------------------------------------------------------------
+//      一定間隔でイベントの発行を開始します. emit は専用スレッドから発行時刻を引数に呼び出されます.
+//-------------------------------------------------------------------------------------------------
+bool SyntheticInputGenerator::Start( double eventsPerSec, const EmitFunc& emit )
+{
+    Stop();
+
+    if ( eventsPerSec <= 0.0 || !emit )
+    { return false; }
+
+    m_Emit         = emit;
+    m_EventsPerSec = eventsPerSec;
+    m_EmittedCount = 0;
+    m_Running      = true;
+    m_Thread       = std::thread( &SyntheticInputGenerator::ThreadProc, this );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      イベントの発行を停止します.
+//-------------------------------------------------------------------------------------------------
+void SyntheticInputGenerator::Stop()
+{
+    m_Running = false;
+    if ( m_Thread.joinable() )
+    { m_Thread.join(); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      発行したイベント数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t SyntheticInputGenerator::GetEmittedCount() const
+{ return m_EmittedCount.load(); }
+
+//-------------------------------------------------------------------------------------------------
+//      イベント発行スレッドの処理です.
+//-------------------------------------------------------------------------------------------------
+void SyntheticInputGenerator::ThreadProc()
+{
+    const int64_t period = int64_t( double( Timer::GetTicksPerSec() ) / m_EventsPerSec );
+    int64_t next = Timer::GetTicks();
+
+    while( m_Running )
+    {
+        // 受け取り側がキューで待った時間も計測できるよう, 発行時刻を渡す.
+        m_Emit( Timer::GetTicks() );
+        m_EmittedCount.fetch_add( 1 );
+
+        // フレーム周期と同期しないよう, 一定間隔で発行し続ける.
+        next += period;
+        const int64_t wait = next - Timer::GetTicks();
+        if ( wait > 0 )
+        {
+            const int64_t usec = wait * 1000000 / Timer::GetTicksPerSec();
+            std::this_thread::sleep_for( std::chrono::microseconds( usec ) );
+        }
+        else
+        { next = Timer::GetTicks(); }
+    }
+}
@@ -0,0 +1,750 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Logger.cpp
+// Desc : Asynchronous Binary Logger.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Logger.h>
+#include <ThreadLocal.h>
+#include <Timer.h>
+#include <chrono>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  LOG_PADDING         = 0xffffffff;   // リングバッファの末尾を埋めるレコードの ArgCount.
+const uint32_t  LOG_MAX_RECORD_SIZE = uint32_t( sizeof(LogRecord) ) + LOG_MAX_ARGS * ( 8 + ( ( LOG_MAX_STRING + 7 ) & ~7u ) );
+const uint32_t  LOG_MIN_BUFFER_SIZE = 4096;         // リングバッファの最小サイズ.
+const size_t    LOG_MAX_LINE        = 4096;         // 1 行の最大文字数. 超えた分は切り捨てる.
+const size_t    LOG_OUTPUT_CHUNK    = 32 * 1024;    // まとめて書き出すバイト数.
+
+//-------------------------------------------------------------------------------------------------
+// Global Variables.
+//-------------------------------------------------------------------------------------------------
+std::atomic<uint32_t>   g_NextGeneration( 1 );
+// 関数内 static は VS2013 ではスレッドセーフでないため, 名前空間スコープに置く.
+Logger                  g_DefaultLogger;
+
+//-------------------------------------------------------------------------------------------------
+// Thread Local Variables.
+//-------------------------------------------------------------------------------------------------
+THREAD_LOCAL uint32_t   t_Generation = 0;           //!< t_pBuffer を取得したロガーの世代です.
+THREAD_LOCAL void*      t_pBuffer    = nullptr;     //!< 書き込み先のリングバッファです.
+THREAD_LOCAL uint64_t   t_Scratch[ LOG_MAX_RECORD_SIZE / 8 ];  //!< 直ちに出力する場合の作業領域です.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// LogArg structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct LogArg
+{
+    uint8_t         Type;       //!< 引数の型です.
+    uint64_t        Bits;       //!< 数値の場合の値です. 文字列の場合は長さです.
+    const char*     pString;    //!< 文字列の場合の内容です (終端文字無し).
+};
+
+//-------------------------------------------------------------------------------------------------
+//      レコードから引数を 1 つ読み出します.
+//-------------------------------------------------------------------------------------------------
+const uint8_t* ReadArg( const LogRecord& record, uint32_t index, const uint8_t* pSrc, LogArg& arg )
+{
+    arg.Type    = record.Types[index];
+    arg.pString = nullptr;
+    memcpy( &arg.Bits, pSrc, sizeof(arg.Bits) );
+    pSrc += 8;
+
+    if ( arg.Type == LOG_ARG_TYPE_STRING )
+    {
+        arg.pString = reinterpret_cast<const char*>( pSrc );
+        pSrc += ( arg.Bits + 7 ) & ~7ull;
+    }
+
+    return pSrc;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      引数を符号付き整数として取得します. 32bit の引数は printf と同じく 32bit として解釈します.
+//-------------------------------------------------------------------------------------------------
+long long ToSigned( const LogArg& arg )
+{
+    switch( arg.Type )
+    {
+    case LOG_ARG_TYPE_INT32:
+    case LOG_ARG_TYPE_UINT32:
+        return (long long)int32_t( uint32_t( arg.Bits ) );
+
+    case LOG_ARG_TYPE_DOUBLE:
+        {
+            double value;
+            memcpy( &value, &arg.Bits, sizeof(value) );
+            return (long long)value;
+        }
+
+    case LOG_ARG_TYPE_STRING:
+        return 0;
+
+    default:
+        return (long long)arg.Bits;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      引数を符号無し整数として取得します.
+//-------------------------------------------------------------------------------------------------
+unsigned long long ToUnsigned( const LogArg& arg )
+{
+    switch( arg.Type )
+    {
+    case LOG_ARG_TYPE_INT32:
+    case LOG_ARG_TYPE_UINT32:
+        return (unsigned long long)uint32_t( arg.Bits );
+
+    case LOG_ARG_TYPE_DOUBLE:
+        return (unsigned long long)ToSigned( arg );
+
+    case LOG_ARG_TYPE_STRING:
+        return 0;
+
+    default:
+        return (unsigned long long)arg.Bits;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      引数を浮動小数として取得します.
+//-------------------------------------------------------------------------------------------------
+double ToDouble( const LogArg& arg )
+{
+    if ( arg.Type == LOG_ARG_TYPE_DOUBLE )
+    {
+        double value;
+        memcpy( &value, &arg.Bits, sizeof(value) );
+        return value;
+    }
+
+    if ( arg.Type == LOG_ARG_TYPE_UINT32 || arg.Type == LOG_ARG_TYPE_UINT64 )
+    { return double( ToUnsigned( arg ) ); }
+
+    return double( ToSigned( arg ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      書き込んだ文字数を切り詰めて位置を進めます.
+//-------------------------------------------------------------------------------------------------
+void Advance( size_t& pos, int written, size_t capacity )
+{
+    if ( written <= 0 )
+    { return; }
+
+    pos += size_t( written );
+    if ( pos >= capacity )
+    { pos = capacity - 1; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レコードを書式に従って 1 行の文字列に変換します. 戻り値は改行を含む文字数です.
+//      書式指定は 1 つずつ snprintf() に渡し, 長さ修飾子は記録した型に合わせて付け直します.
+//-------------------------------------------------------------------------------------------------
+size_t FormatRecord( const LogRecord& record, char* pDst, size_t capacity )
+{
+    const LogSite& site = *record.pSite;
+
+    size_t pos = 0;
+    if ( site.Level == LOG_LEVEL_ERROR )
+    { Advance( pos, std::snprintf( pDst, capacity, "[File: %s, Line: %d] ", site.File, site.Line ), capacity ); }
+
+    const uint8_t* pArgs = reinterpret_cast<const uint8_t*>( &record + 1 );
+    uint32_t index = 0;
+
+    const char* f = site.Format;
+    while( *f != '\0' && pos + 2 < capacity )
+    {
+        if ( f[0] != '%' )
+        {
+            pDst[pos++] = *f++;
+            continue;
+        }
+
+        if ( f[1] == '%' )
+        {
+            pDst[pos++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // フラグと幅と精度を取り出す. '*' は引数の値に置き換える.
+        char spec[64];
+        size_t n = 0;
+        int precision = -1;
+        spec[n++] = *f++;
+
+        while( *f != '\0' && strchr( "-+ #0", *f ) != nullptr && n < 16 )
+        { spec[n++] = *f++; }
+
+        for( int part = 0; part < 2; ++part )
+        {
+            if ( part == 1 )
+            {
+                if ( *f != '.' )
+                { break; }
+                spec[n++] = *f++;
+                precision = 0;
+            }
+
+            int value = 0;
+            if ( *f == '*' )
+            {
+                f++;
+                if ( index < record.ArgCount )
+                {
+                    LogArg arg;
+                    pArgs = ReadArg( record, index++, pArgs, arg );
+                    value = int( ToSigned( arg ) );
+                }
+                n += size_t( std::snprintf( spec + n, sizeof(spec) - n - 8, "%d", value ) );
+            }
+            else
+            {
+                while( *f >= '0' && *f <= '9' && n < 40 )
+                {
+                    value = value * 10 + ( *f - '0' );
+                    spec[n++] = *f++;
+                }
+            }
+
+            if ( part == 1 )
+            { precision = value; }
+        }
+
+        // 長さ修飾子は読み飛ばす (MSVC の I64 を含む).
+        while( *f != '\0' && strchr( "hlLqjztI", *f ) != nullptr )
+        {
+            if ( f[0] == 'I' && f[1] == '6' && f[2] == '4' )
+            { f += 3; }
+            else if ( f[0] == 'I' && f[1] == '3' && f[2] == '2' )
+            { f += 3; }
+            else
+            { f++; }
+        }
+
+        const char conv = *f;
+        if ( conv == '\0' )
+        { break; }
+        f++;
+
+        if ( conv == 'n' )
+        { continue; }
+
+        if ( index >= record.ArgCount )
+        {
+            Advance( pos, std::snprintf( pDst + pos, capacity - pos, "(missing)" ), capacity );
+            continue;
+        }
+
+        LogArg arg;
+        pArgs = ReadArg( record, index++, pArgs, arg );
+
+        char* pOut = pDst + pos;
+        const size_t rest = capacity - pos;
+        switch( conv )
+        {
+        case 'd':
+        case 'i':
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            Advance( pos, std::snprintf( pOut, rest, spec, ToSigned( arg ) ), capacity );
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+            Advance( pos, std::snprintf( pOut, rest, spec, ToUnsigned( arg ) ), capacity );
+            break;
+
+        case 'c':
+            spec[n++] = conv; spec[n] = '\0';
+            Advance( pos, std::snprintf( pOut, rest, spec, int( ToSigned( arg ) ) ), capacity );
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec[n++] = conv; spec[n] = '\0';
+            Advance( pos, std::snprintf( pOut, rest, spec, ToDouble( arg ) ), capacity );
+            break;
+
+        case 'p':
+            spec[n++] = conv; spec[n] = '\0';
+            Advance( pos, std::snprintf( pOut, rest, spec, reinterpret_cast<void*>( uintptr_t( arg.Bits ) ) ), capacity );
+            break;
+
+        case 's':
+            if ( arg.Type == LOG_ARG_TYPE_STRING )
+            {
+                // 記録した文字列は終端文字を持たないので精度で長さを渡す.
+                int length = int( arg.Bits );
+                if ( precision >= 0 && precision < length )
+                { length = precision; }
+
+                if ( precision >= 0 )
+                {
+                    while( n > 0 && spec[n - 1] != '.' )
+                    { n--; }
+                    n--;
+                }
+                spec[n++] = '.'; spec[n++] = '*'; spec[n++] = 's'; spec[n] = '\0';
+                Advance( pos, std::snprintf( pOut, rest, spec, length, arg.pString ), capacity );
+            }
+            else
+            { Advance( pos, std::snprintf( pOut, rest, "(null)" ), capacity ); }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    pDst[pos++] = '\n';
+    return pos;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Logger::Buffer structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct Logger::Buffer
+{
+    std::vector<uint64_t>   Data;           //!< リングバッファです. 8 バイト境界に揃えるため uint64_t で確保します.
+    uint32_t                Capacity;       //!< リングバッファのバイト数です (2 の累乗).
+    uint32_t                ThreadIndex;    //!< 書き込むスレッドの番号です (1 から).
+    std::thread::id         ThreadId;       //!< 書き込むスレッドの ID です.
+    uint64_t                PendingHead;    //!< 書き込み中のレコードの終端です. 書き込み側だけが使います.
+    uint64_t                CachedTail;     //!< 最後に読んだ Tail です. 書き込み側だけが使います.
+    std::atomic<uint64_t>   Head;           //!< 書き込み位置です. 書き込み側だけが更新します.
+    std::atomic<uint64_t>   WriteCount;     //!< 書き込んだメッセージ数です.
+    std::atomic<uint64_t>   DropCount;      //!< 破棄したメッセージ数です.
+    uint8_t                 Padding[64];    //!< Tail を書き込み側と別のキャッシュラインに置くための詰め物です.
+    std::atomic<uint64_t>   Tail;           //!< 読み出し位置です. バックグラウンドスレッドだけが更新します.
+    uint64_t                ReportedDrops;  //!< 破棄を報告済みのメッセージ数です. バックグラウンドスレッドだけが使います.
+
+    Buffer( uint32_t capacity, uint32_t threadIndex )
+    : Data          ( capacity / 8 )
+    , Capacity      ( capacity )
+    , ThreadIndex   ( threadIndex )
+    , ThreadId      ( std::this_thread::get_id() )
+    , PendingHead   ( 0 )
+    , CachedTail    ( 0 )
+    , Head          ( 0 )
+    , WriteCount    ( 0 )
+    , DropCount     ( 0 )
+    , Tail          ( 0 )
+    , ReportedDrops ( 0 )
+    { memset( Padding, 0, sizeof(Padding) ); }
+
+    uint8_t* GetBytes( uint64_t position )
+    { return reinterpret_cast<uint8_t*>( &Data[0] ) + ( position & ( Capacity - 1 ) ); }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Logger class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+Logger::Logger()
+: m_pFile       ( stderr )
+, m_BufferBytes ( 0 )
+, m_FlushMsec   ( 0 )
+, m_Generation  ( 0 )
+, m_FlushRequest( 0 )
+, m_FlushDone   ( 0 )
+, m_OutputCount ( 0 )
+, m_OutputBytes ( 0 )
+, m_Exit        ( false )
+, m_Running     ( false )
+#if defined(DEBUG) || defined(_DEBUG)
+, m_Level       ( LOG_LEVEL_DEBUG )
+#else
+, m_Level       ( LOG_LEVEL_INFO )
+#endif
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+Logger::~Logger()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. バックグラウンドスレッドを起動します.
+//      bufferBytes はスレッドごとのリングバッファのサイズで, 2 の累乗に切り上げます.
+//-------------------------------------------------------------------------------------------------
+bool Logger::Init( FILE* pFile, uint32_t bufferBytes, uint32_t flushMsec )
+{
+    if ( pFile == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    uint32_t capacity = LOG_MIN_BUFFER_SIZE;
+    while( capacity < bufferBytes || capacity < LOG_MAX_RECORD_SIZE * 2 )
+    { capacity <<= 1; }
+
+    m_pFile        = pFile;
+    m_BufferBytes  = capacity;
+    m_FlushMsec    = ( flushMsec > 0 ) ? flushMsec : 1;
+    m_Generation   = g_NextGeneration.fetch_add( 1 );
+    m_FlushRequest = 0;
+    m_FlushDone    = 0;
+    m_Exit         = false;
+
+    m_Thread = std::thread( &Logger::ThreadMain, this );
+    m_Running.store( true, std::memory_order_release );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 残っているメッセージを全て出力してからスレッドを停止します.
+//      他のスレッドが Write() を呼び出していないときに呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void Logger::Term()
+{
+    if ( !m_Running.load( std::memory_order_acquire ) )
+    { return; }
+
+    {
+        std::lock_guard<std::mutex> locker( m_Mutex );
+        m_Exit = true;
+    }
+    m_WakeCond.notify_all();
+
+    if ( m_Thread.joinable() )
+    { m_Thread.join(); }
+
+    m_Running.store( false, std::memory_order_release );
+
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    for( size_t i = 0; i < m_Buffers.size(); ++i )
+    { delete m_Buffers[i]; }
+    m_Buffers.clear();
+
+    fflush( m_pFile );
+    m_pFile      = stderr;
+    m_Generation = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      呼び出し時点までに書き込まれたメッセージが出力されるまで待機します.
+//-------------------------------------------------------------------------------------------------
+void Logger::Flush()
+{
+    if ( !m_Running.load( std::memory_order_acquire ) )
+    {
+        fflush( m_pFile );
+        return;
+    }
+
+    std::unique_lock<std::mutex> locker( m_Mutex );
+    const uint64_t request = ++m_FlushRequest;
+    m_WakeCond.notify_all();
+    m_FlushCond.wait( locker, [this, request] { return m_FlushDone >= request; } );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      出力するログレベルの下限を設定します.
+//-------------------------------------------------------------------------------------------------
+void Logger::SetLevel( LOG_LEVEL level )
+{ m_Level.store( uint32_t( level ), std::memory_order_relaxed ); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+Logger::Stats Logger::GetStats() const
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    Stats stats;
+    memset( &stats, 0, sizeof(stats) );
+    for( size_t i = 0; i < m_Buffers.size(); ++i )
+    {
+        stats.WriteCount += m_Buffers[i]->WriteCount.load( std::memory_order_relaxed );
+        stats.DropCount  += m_Buffers[i]->DropCount .load( std::memory_order_relaxed );
+    }
+    stats.OutputCount = m_OutputCount;
+    stats.OutputBytes = m_OutputBytes;
+    stats.BufferCount = uint32_t( m_Buffers.size() );
+
+    return stats;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします. 書き込み数と破棄数はバッファの所有スレッドが更新するため,
+//      Write() を呼び出しているスレッドが無いときに呼び出してください.
+//-------------------------------------------------------------------------------------------------
+void Logger::ResetStats()
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    for( size_t i = 0; i < m_Buffers.size(); ++i )
+    {
+        m_Buffers[i]->WriteCount.store( 0, std::memory_order_relaxed );
+        m_Buffers[i]->DropCount .store( 0, std::memory_order_relaxed );
+    }
+    m_OutputCount = 0;
+    m_OutputBytes = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ELOG() などのマクロが使うロガーを取得します.
+//-------------------------------------------------------------------------------------------------
+Logger& Logger::GetDefault()
+{ return g_DefaultLogger; }
+
+//-------------------------------------------------------------------------------------------------
+//      レコードを書き込む領域を確保します. 満杯の場合は破棄数を数えて nullptr を返します.
+//-------------------------------------------------------------------------------------------------
+LogRecord* Logger::Begin( uint32_t size, Buffer*& pBuffer )
+{
+    LogRecord* pRecord = nullptr;
+
+    if ( !m_Running.load( std::memory_order_acquire ) )
+    {
+        pBuffer = nullptr;
+        pRecord = reinterpret_cast<LogRecord*>( t_Scratch );
+    }
+    else
+    {
+        pBuffer = GetBuffer();
+        if ( pBuffer == nullptr )
+        { return nullptr; }
+
+        Buffer& buffer = *pBuffer;
+
+        uint64_t head = buffer.Head.load( std::memory_order_relaxed );
+        const uint32_t offset     = uint32_t( head & ( buffer.Capacity - 1 ) );
+        const uint32_t contiguous = buffer.Capacity - offset;
+        const uint32_t padding    = ( contiguous < size ) ? contiguous : 0;
+
+        // 読み出し位置はキャッシュしておき, 足りないときだけ読み直す.
+        if ( head + padding + size - buffer.CachedTail > buffer.Capacity )
+        {
+            buffer.CachedTail = buffer.Tail.load( std::memory_order_acquire );
+            if ( head + padding + size - buffer.CachedTail > buffer.Capacity )
+            {
+                buffer.DropCount.store( buffer.DropCount.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+                return nullptr;
+            }
+        }
+
+        // 末尾に収まらない場合は残りを埋めて先頭から書く.
+        if ( padding > 0 )
+        {
+            LogRecord* pPadding = reinterpret_cast<LogRecord*>( buffer.GetBytes( head ) );
+            pPadding->Size     = padding;
+            pPadding->ArgCount = LOG_PADDING;
+            head += padding;
+        }
+
+        pRecord = reinterpret_cast<LogRecord*>( buffer.GetBytes( head ) );
+        buffer.PendingHead = head + size;
+    }
+
+    pRecord->Ticks = Timer::GetTicks();
+    return pRecord;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      書き込んだレコードを公開します. バックグラウンドスレッドが無い場合は直ちに出力します.
+//-------------------------------------------------------------------------------------------------
+void Logger::End( Buffer* pBuffer, LogRecord* pRecord )
+{
+    if ( pBuffer == nullptr )
+    {
+        char line[LOG_MAX_LINE];
+        const size_t length = FormatRecord( *pRecord, line, sizeof(line) );
+        fwrite( line, 1, length, m_pFile );
+        return;
+    }
+
+    pBuffer->Head.store( pBuffer->PendingHead, std::memory_order_release );
+    pBuffer->WriteCount.store( pBuffer->WriteCount.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      呼び出したスレッドのリングバッファを取得します. 初回だけロックして生成します.
+//-------------------------------------------------------------------------------------------------
+Logger::Buffer* Logger::GetBuffer()
+{
+    if ( t_Generation == m_Generation )
+    { return static_cast<Buffer*>( t_pBuffer ); }
+
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    // 複数のロガーを交互に使った場合は登録済みのバッファを探す.
+    const std::thread::id id = std::this_thread::get_id();
+    Buffer* pBuffer = nullptr;
+    for( size_t i = 0; i < m_Buffers.size(); ++i )
+    {
+        if ( m_Buffers[i]->ThreadId == id )
+        {
+            pBuffer = m_Buffers[i];
+            break;
+        }
+    }
+
+    if ( pBuffer == nullptr )
+    {
+        pBuffer = new (std::nothrow) Buffer( m_BufferBytes, uint32_t( m_Buffers.size() + 1 ) );
+        if ( pBuffer == nullptr )
+        { return nullptr; }
+
+        m_Buffers.push_back( pBuffer );
+    }
+
+    t_Generation = m_Generation;
+    t_pBuffer    = pBuffer;
+    return pBuffer;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      バックグラウンドスレッドの処理です. 書き込みが無ければ flushMsec ごとに確認します.
+//-------------------------------------------------------------------------------------------------
+void Logger::ThreadMain()
+{
+    std::vector<Buffer*> buffers;
+    std::vector<char>    output;
+    output.reserve( LOG_OUTPUT_CHUNK + LOG_MAX_LINE );
+
+    std::unique_lock<std::mutex> locker( m_Mutex );
+    for( ;; )
+    {
+        const uint64_t request = m_FlushRequest;
+        const bool     exit    = m_Exit;
+        buffers.assign( m_Buffers.begin(), m_Buffers.end() );
+        locker.unlock();
+
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+        Drain( buffers, output, count, bytes );
+
+        locker.lock();
+        m_OutputCount += count;
+        m_OutputBytes += bytes;
+        if ( request > m_FlushDone )
+        {
+            m_FlushDone = request;
+            m_FlushCond.notify_all();
+        }
+
+        if ( exit )
+        { break; }
+
+        if ( count == 0 && m_FlushRequest == request && !m_Exit )
+        { m_WakeCond.wait_for( locker, std::chrono::milliseconds( m_FlushMsec ) ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全てのリングバッファからレコードを取り出して出力します.
+//      各バッファの先頭のうち最も古いものから取り出し, スレッドをまたいだ順序を保ちます.
+//-------------------------------------------------------------------------------------------------
+void Logger::Drain( const std::vector<Buffer*>& buffers, std::vector<char>& output, uint64_t& count, uint64_t& bytes )
+{
+    char line[LOG_MAX_LINE];
+    output.clear();
+
+    for( ;; )
+    {
+        Buffer*          pOldest = nullptr;
+        const LogRecord* pRecord = nullptr;
+
+        for( size_t i = 0; i < buffers.size(); ++i )
+        {
+            Buffer& buffer = *buffers[i];
+
+            uint64_t       tail = buffer.Tail.load( std::memory_order_relaxed );
+            const uint64_t head = buffer.Head.load( std::memory_order_acquire );
+
+            const LogRecord* pFront = nullptr;
+            while( tail != head )
+            {
+                pFront = reinterpret_cast<const LogRecord*>( buffer.GetBytes( tail ) );
+                if ( pFront->ArgCount != LOG_PADDING )
+                { break; }
+
+                tail += pFront->Size;
+                buffer.Tail.store( tail, std::memory_order_release );
+                pFront = nullptr;
+            }
+
+            if ( pFront != nullptr && ( pRecord == nullptr || pFront->Ticks < pRecord->Ticks ) )
+            {
+                pOldest = &buffer;
+                pRecord = pFront;
+            }
+        }
+
+        if ( pRecord == nullptr )
+        { break; }
+
+        const size_t length = FormatRecord( *pRecord, line, sizeof(line) );
+        output.insert( output.end(), line, line + length );
+
+        pOldest->Tail.store( pOldest->Tail.load( std::memory_order_relaxed ) + pRecord->Size, std::memory_order_release );
+        count++;
+
+        if ( output.size() >= LOG_OUTPUT_CHUNK )
+        {
+            fwrite( &output[0], 1, output.size(), m_pFile );
+            bytes += output.size();
+            output.clear();
+        }
+    }
+
+    // 破棄したメッセージがあれば報告する.
+    for( size_t i = 0; i < buffers.size(); ++i )
+    {
+        Buffer& buffer = *buffers[i];
+
+        const uint64_t drops = buffer.DropCount.load( std::memory_order_relaxed );
+        if ( drops < buffer.ReportedDrops )
+        { buffer.ReportedDrops = drops; }   // ResetStats() でリセットされた.
+        else if ( drops > buffer.ReportedDrops )
+        {
+            const int length = std::snprintf( line, sizeof(line), "[Logger] %llu messages dropped. thread = %u\n",
+                (unsigned long long)( drops - buffer.ReportedDrops ), buffer.ThreadIndex );
+            if ( length > 0 )
+            { output.insert( output.end(), line, line + length ); }
+            buffer.ReportedDrops = drops;
+        }
+    }
+
+    if ( !output.empty() )
+    {
+        fwrite( &output[0], 1, output.size(), m_pFile );
+        bytes += output.size();
+        output.clear();
+    }
+
+    if ( count > 0 || bytes > 0 )
+    { fflush( m_pFile ); }
+}
@@ -8,6 +8,10 @@
 // Includes
 //-------------------------------------------------------------------------------------------------
 #include <App.h>
+#include <Benchmark.h>
+#include <Logger.h>
+#include <cstring>
+#include <cstdlib>
 
 
 //-------------------------------------------------------------------------------------------------
@@ -15,9 +19,98 @@
 //-------------------------------------------------------------------------------------------------
 int main( int argc, char** argv )
 {
+    // ELOG() などの出力はバックグラウンドスレッドで行う.
+    Logger::GetDefault().Init( stderr );
+
     App app;
 
-    app.Run();
+    // コマンドライン引数を解析.
+    for( int i = 1; i < argc; ++i )
+    {
+        // -record <path> : 描画結果を Y4M ファイルに録画します.
+        if ( strcmp( argv[i], "-record" ) == 0 && ( i + 1 ) < argc )
+        { app.SetRecordPath( argv[++i] ); }
+
+        // -surfaces <count> : 指定数のオフスクリーンサーフェイスを並列に描画します.
+        else if ( strcmp( argv[i], "-surfaces" ) == 0 && ( i + 1 ) < argc )
+        { app.SetSurfaceCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -threads <count> : サーフェイス描画に使うスレッド数を指定します.
+        else if ( strcmp( argv[i], "-threads" ) == 0 && ( i + 1 ) < argc )
+        { app.SetThreadCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -surface-bench : ウィンドウを作らずにサーフェイス数 1～64 とスレッド数を変えて総描画レートを計測します.
+        else if ( strcmp( argv[i], "-surface-bench" ) == 0 )
+        { app.EnableSurfaceBenchmark( true ); }
+
+        // -fps <rate> : 目標フレームレートを指定します. 0 の場合は制限しません.
+        else if ( strcmp( argv[i], "-fps" ) == 0 && ( i + 1 ) < argc )
+        { app.SetTargetFrameRate( atof( argv[++i] ) ); }
+
+        // -vsync <interval> : Present() の垂直同期間隔を指定します.
+        else if ( strcmp( argv[i], "-vsync" ) == 0 && ( i + 1 ) < argc )
+        { app.SetSyncInterval( UINT( atoi( argv[++i] ) ) ); }
+
+        // -buffers <count> : スワップチェインのバックバッファ数を指定します (2～16).
+        else if ( strcmp( argv[i], "-buffers" ) == 0 && ( i + 1 ) < argc )
+        { app.SetBackBufferCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -synthetic-input <rate> : 1秒あたり指定数の合成入力イベントを発行して入力遅延を計測します.
+        else if ( strcmp( argv[i], "-synthetic-input" ) == 0 && ( i + 1 ) < argc )
+        { app.SetSyntheticInputRate( atof( argv[++i] ) ); }
+
+        // -shapes <count> : 指定数のベクター形状をテッセレーションして描画します.
+        else if ( strcmp( argv[i], "-shapes" ) == 0 && ( i + 1 ) < argc )
+        { app.SetShapeCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -no-shape-cache : テッセレーション結果をキャッシュせず毎フレーム生成します.
+        else if ( strcmp( argv[i], "-no-shape-cache" ) == 0 )
+        { app.EnableShapeCache( false ); }
+
+        // -no-state-cache : 変化していないステートの設定も毎回デバイスコンテキストに発行します.
+        else if ( strcmp( argv[i], "-no-state-cache" ) == 0 )
+        { app.EnableStateCache( false ); }
+
+        // -sprites <count> : 指定数のスプライトをテクスチャとブレンドステートで並べ替えて描画します.
+        else if ( strcmp( argv[i], "-sprites" ) == 0 && ( i + 1 ) < argc )
+        { app.SetSpriteCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -scene <count> : 指定数のノードを持つシーングラフを差分更新しながら描画します.
+        else if ( strcmp( argv[i], "-scene" ) == 0 && ( i + 1 ) < argc )
+        { app.SetSceneNodeCount( UINT( atoi( argv[++i] ) ) ); }
+
+        // -log <path> : テキストファイルをメモリマップして表示します (ホイールとキーでスクロール).
+        else if ( strcmp( argv[i], "-log" ) == 0 && ( i + 1 ) < argc )
+        { app.SetLogPath( argv[++i] ); }
+
+        // -log-font <path> : テキストの表示に使うフォントファイルを指定します.
+        else if ( strcmp( argv[i], "-log-font" ) == 0 && ( i + 1 ) < argc )
+        { app.SetLogFontPath( argv[++i] ); }
+
+        // -serial-init : 初期化処理を並列化せずに直列に実行します (起動時間の比較用).
+        else if ( strcmp( argv[i], "-serial-init" ) == 0 )
+        { app.EnableParallelInit( false ); }
+
+        // -memory-budget <MiB> : リソースのメモリ予算を指定します. 超過するとキャッシュを削減します.
+        else if ( strcmp( argv[i], "-memory-budget" ) == 0 && ( i + 1 ) < argc )
+        { app.SetMemoryBudget( UINT64( atof( argv[++i] ) * 1024.0 * 1024.0 ) ); }
+
+        // -resize-test <cycles> : ウィンドウのリサイズを繰り返してリソースのメモリが増えないことを確認します.
+        else if ( strcmp( argv[i], "-resize-test" ) == 0 && ( i + 1 ) < argc )
+        { app.SetResizeTestCycles( UINT( atoi( argv[++i] ) ) ); }
+
+        // -bench <name> [args...] : ウィンドウを生成せずに指定のベンチマークを実行して終了します.
+        else if ( strcmp( argv[i], "-bench" ) == 0 )
+        {
+            const bool hasName = ( i + 1 ) < argc;
+            const bool result  = RunBenchmark( hasName ? argv[i + 1] : nullptr, hasName ? argc - ( i + 2 ) : 0, hasName ? argv + i + 2 : nullptr );
+            Logger::GetDefault().Term();
+            return result ? 0 : 1;
+        }
+    }
+
+    const bool result = app.Run();
 
-    return 0;
+    Logger::GetDefault().Term();
+    return result ? 0 : 1;
 }
@@ -0,0 +1,163 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : MappedFile.cpp
+// Desc : Read-Only Memory Mapped File.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <MappedFile.h>
+#include <Logger.h>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+MappedFile::MappedFile()
+: m_pData   ( nullptr )
+, m_Size    ( 0 )
+, m_hFile   ( nullptr )
+, m_hMapping( nullptr )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{ Close(); }
+
+//-------------------------------------------------------------------------------------------------
+//      ファイルを読み取り専用でメモリにマップします. ページは参照した時に読み込まれます.
+//-------------------------------------------------------------------------------------------------
+bool MappedFile::Open( const char* path )
+{
+    Close();
+
+    if ( path == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+#if defined(_WIN32)
+    HANDLE hFile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( hFile == INVALID_HANDLE_VALUE )
+    {
+        ELOG( "Error : CreateFileA() Failed. path = %s", path );
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx( hFile, &size ) || size.QuadPart == 0 )
+    {
+        ELOG( "Error : GetFileSizeEx() Failed. path = %s", path );
+        CloseHandle( hFile );
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( hMapping == nullptr )
+    {
+        ELOG( "Error : CreateFileMappingA() Failed. path = %s", path );
+        CloseHandle( hFile );
+        return false;
+    }
+
+    const void* pView = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( pView == nullptr )
+    {
+        ELOG( "Error : MapViewOfFile() Failed. path = %s", path );
+        CloseHandle( hMapping );
+        CloseHandle( hFile );
+        return false;
+    }
+
+    m_hFile    = hFile;
+    m_hMapping = hMapping;
+    m_pData    = static_cast<const uint8_t*>( pView );
+    m_Size     = size_t( size.QuadPart );
+#else
+    const int fd = open( path, O_RDONLY );
+    if ( fd < 0 )
+    {
+        ELOG( "Error : open() Failed. path = %s", path );
+        return false;
+    }
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size == 0 )
+    {
+        ELOG( "Error : fstat() Failed. path = %s", path );
+        close( fd );
+        return false;
+    }
+
+    void* pView = mmap( nullptr, size_t( info.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( pView == MAP_FAILED )
+    {
+        ELOG( "Error : mmap() Failed. path = %s", path );
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>( pView );
+    m_Size  = size_t( info.st_size );
+#endif
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      マップを解除します.
+//-------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+    if ( m_pData == nullptr )
+    { return; }
+
+#if defined(_WIN32)
+    UnmapViewOfFile( m_pData );
+    CloseHandle( static_cast<HANDLE>( m_hMapping ) );
+    CloseHandle( static_cast<HANDLE>( m_hFile ) );
+#else
+    munmap( const_cast<uint8_t*>( m_pData ), m_Size );
+#endif
+
+    m_pData    = nullptr;
+    m_Size     = 0;
+    m_hFile    = nullptr;
+    m_hMapping = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      マップされているかどうかを取得します.
+//-------------------------------------------------------------------------------------------------
+bool MappedFile::IsOpen() const
+{ return m_pData != nullptr; }
+
+//-------------------------------------------------------------------------------------------------
+//      先頭アドレスを取得します.
+//-------------------------------------------------------------------------------------------------
+const uint8_t* MappedFile::GetData() const
+{ return m_pData; }
+
+//-------------------------------------------------------------------------------------------------
+//      サイズを取得します.
+//-------------------------------------------------------------------------------------------------
+size_t MappedFile::GetSize() const
+{ return m_Size; }
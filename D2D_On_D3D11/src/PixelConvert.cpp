@@ -0,0 +1,1184 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : PixelConvert.cpp
+// Desc : Pixel Format Conversion Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <PixelConvert.h>
+#include <ThreadPool.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+
+// AVX2 のカーネルだけを AVX2 向けにコンパイルする. MSVC は指定無しで組み込み関数を使える.
+// FMA は有効にしない (乗算と加算が融合されるとスカラー版と結果が一致しなくなるため).
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+// BT.601 リミテッドレンジの 8bit 固定小数係数 (B, G, R の順).
+static const int COEF_Y[3] = {  25,  129,   66 };
+static const int COEF_U[3] = { 112,  -74,  -38 };
+static const int COEF_V[3] = { -18,  -94,  112 };
+
+// 汎用フォーマット変換.
+static const uint32_t   ENCODE_TABLE_SIZE   = 4096;         // リニアから sRGB への変換テーブルの要素数.
+static const uint32_t   CHUNK_PIXELS        = 256;          // 中間バッファを経由する変換で 1 度に処理する画素数.
+static const size_t     PARALLEL_MIN_BYTES  = 256 * 1024;   // 並列化する最小のデータ量 (読み書きの合計).
+static const uint32_t   BAND_MIN_ROWS       = 16;           // 並列化する際の 1 タスクあたりの最小行数.
+static const float      INV_255             = 1.0f / 255.0f;
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ALPHA_OP enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum ALPHA_OP
+{
+    ALPHA_OP_NONE = 0,          //!< アルファはそのままです.
+    ALPHA_OP_PREMULTIPLY,       //!< ストレートから乗算済みにします.
+    ALPHA_OP_UNPREMULTIPLY,     //!< 乗算済みからストレートにします.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// FormatInfo structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct FormatInfo
+{
+    uint32_t    Size;           //!< 1画素あたりのバイト数です.
+    uint32_t    Bits;           //!< 1要素あたりのビット数 (8, 16, 32) です.
+    bool        Swap;           //!< メモリ上で B, G, R の順に並んでいる場合は true です.
+    bool        Premul;         //!< 乗算済みアルファの場合は true です.
+};
+
+const FormatInfo FORMAT_INFO[PIXEL_FORMAT_COUNT] = {
+    {  4,  8, true,  false },   // PIXEL_FORMAT_B8G8R8A8
+    {  4,  8, true,  true  },   // PIXEL_FORMAT_B8G8R8A8_PREMUL
+    {  4,  8, false, false },   // PIXEL_FORMAT_R8G8B8A8
+    {  4,  8, false, true  },   // PIXEL_FORMAT_R8G8B8A8_PREMUL
+    {  8, 16, false, true  },   // PIXEL_FORMAT_R16G16B16A16_FLOAT
+    { 16, 32, false, true  },   // PIXEL_FORMAT_R32G32B32A32_FLOAT
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ColorTables structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct ColorTables
+{
+    float       Decode[256];                    //!< sRGB 8bit からリニアへの変換テーブルです.
+    uint32_t    Encode[ENCODE_TABLE_SIZE];      //!< リニア (0～1 を 4095 等分) から sRGB 8bit への変換テーブルです.
+
+    ColorTables()
+    {
+        for( uint32_t i = 0; i < 256; ++i )
+        {
+            const double c = double( i ) / 255.0;
+            Decode[i] = float( ( c <= 0.04045 ) ? c / 12.92 : pow( ( c + 0.055 ) / 1.055, 2.4 ) );
+        }
+
+        for( uint32_t i = 0; i < ENCODE_TABLE_SIZE; ++i )
+        {
+            const double l = double( i ) / double( ENCODE_TABLE_SIZE - 1 );
+            const double c = ( l <= 0.0031308 ) ? l * 12.92 : 1.055 * pow( l, 1.0 / 2.4 ) - 0.055;
+            Encode[i] = uint32_t( c * 255.0 + 0.5 );
+        }
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+//      CPU が対応している SIMD レベルを調べます.
+//-------------------------------------------------------------------------------------------------
+SIMD_LEVEL DetectSimdLevel()
+{
+    uint32_t ecx1 = 0;
+    uint32_t edx1 = 0;
+    uint32_t ebx7 = 0;
+    uint64_t xcr0 = 0;
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid( info, 0 );
+    const int maxLeaf = info[0];
+    __cpuid( info, 1 );
+    ecx1 = uint32_t( info[2] );
+    edx1 = uint32_t( info[3] );
+    if ( maxLeaf >= 7 )
+    {
+        __cpuidex( info, 7, 0 );
+        ebx7 = uint32_t( info[1] );
+    }
+    if ( ecx1 & ( 1u << 27 ) )
+    { xcr0 = _xgetbv( 0 ); }
+#else
+    unsigned int a, b, c, d;
+    if ( __get_cpuid( 1, &a, &b, &c, &d ) )
+    {
+        ecx1 = c;
+        edx1 = d;
+    }
+    if ( __get_cpuid_count( 7, 0, &a, &b, &c, &d ) )
+    { ebx7 = b; }
+    if ( ecx1 & ( 1u << 27 ) )
+    {
+        uint32_t lo, hi;
+        __asm__ volatile( "xgetbv" : "=a"( lo ), "=d"( hi ) : "c"( 0 ) );
+        xcr0 = ( uint64_t( hi ) << 32 ) | lo;
+    }
+#endif
+
+    const bool sse2 = ( edx1 & ( 1u << 26 ) ) != 0;
+    const bool avx  = ( ecx1 & ( 1u << 28 ) ) != 0 && ( xcr0 & 0x6 ) == 0x6;   // OS が YMM レジスタを退避するか.
+    const bool f16c = ( ecx1 & ( 1u << 29 ) ) != 0;
+    const bool avx2 = ( ebx7 & ( 1u << 5  ) ) != 0;
+
+    if ( avx && avx2 && f16c )
+    { return SIMD_LEVEL_AVX2; }
+
+    return sse2 ? SIMD_LEVEL_SSE2 : SIMD_LEVEL_SCALAR;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Global Variables.
+//-------------------------------------------------------------------------------------------------
+const ColorTables   g_Tables;                           //!< sRGB の変換テーブルです.
+const SIMD_LEVEL    g_SimdLevel = DetectSimdLevel();    //!< 実行中の CPU の SIMD レベルです.
+
+
+//-------------------------------------------------------------------------------------------------
+//      1画素の輝度値を求めます.
+//-------------------------------------------------------------------------------------------------
+inline uint8_t ComputeY( const uint8_t* pBGRA )
+{
+    const int y = COEF_Y[0] * pBGRA[0] + COEF_Y[1] * pBGRA[1] + COEF_Y[2] * pBGRA[2];
+    return uint8_t( ( ( y + 128 ) >> 8 ) + 16 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      4画素分の合計値から色差値を求めます.
+//-------------------------------------------------------------------------------------------------
+inline uint8_t ComputeChroma( const int* coef, int sumB, int sumG, int sumR )
+{
+    const int c = coef[0] * sumB + coef[1] * sumG + coef[2] * sumR;
+    return uint8_t( ( ( c + 512 ) >> 10 ) + 128 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定範囲をスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void ConvertBlockScalar
+(
+    const uint8_t*      pSrc,
+    uint32_t            srcPitch,
+    uint32_t            width,
+    uint32_t            height,
+    uint32_t            x0,
+    uint32_t            x1,
+    uint32_t            y,
+    const PlanarYUV&    dst
+)
+{
+    const uint32_t y1 = ( y + 1 < height ) ? y + 1 : y;
+    const uint8_t* pRow0 = pSrc + size_t( y  ) * srcPitch;
+    const uint8_t* pRow1 = pSrc + size_t( y1 ) * srcPitch;
+
+    for( uint32_t x = x0; x < x1; x += 2 )
+    {
+        const uint32_t xn = ( x + 1 < width ) ? x + 1 : x;
+
+        const uint8_t* p00 = pRow0 + x  * 4;
+        const uint8_t* p01 = pRow0 + xn * 4;
+        const uint8_t* p10 = pRow1 + x  * 4;
+        const uint8_t* p11 = pRow1 + xn * 4;
+
+        dst.pY[ size_t( y ) * dst.PitchY + x ] = ComputeY( p00 );
+        if ( xn != x )
+        { dst.pY[ size_t( y ) * dst.PitchY + xn ] = ComputeY( p01 ); }
+
+        if ( y1 != y )
+        {
+            dst.pY[ size_t( y1 ) * dst.PitchY + x ] = ComputeY( p10 );
+            if ( xn != x )
+            { dst.pY[ size_t( y1 ) * dst.PitchY + xn ] = ComputeY( p11 ); }
+        }
+
+        const int sumB = p00[0] + p01[0] + p10[0] + p11[0];
+        const int sumG = p00[1] + p01[1] + p10[1] + p11[1];
+        const int sumR = p00[2] + p01[2] + p10[2] + p11[2];
+
+        const size_t idx = size_t( y / 2 ) * dst.PitchUV + x / 2;
+        dst.pU[ idx ] = ComputeChroma( COEF_U, sumB, sumG, sumR );
+        dst.pV[ idx ] = ComputeChroma( COEF_V, sumB, sumG, sumR );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      隣接する32bit要素の和を求めます.
+//      戻り値は [a0+a1, a2+a3, b0+b1, b2+b3] です.
+//-------------------------------------------------------------------------------------------------
+inline __m128i SumPairs( __m128i a, __m128i b )
+{
+    const __m128 fa = _mm_castsi128_ps( a );
+    const __m128 fb = _mm_castsi128_ps( b );
+    const __m128i even = _mm_castps_si128( _mm_shuffle_ps( fa, fb, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+    const __m128i odd  = _mm_castps_si128( _mm_shuffle_ps( fa, fb, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+    return _mm_add_epi32( even, odd );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8画素分の輝度値を求めます. 入力は16bitに展開済みの2画素x4レジスタです.
+//-------------------------------------------------------------------------------------------------
+inline __m128i ComputeY8( __m128i p01, __m128i p23, __m128i p45, __m128i p67, __m128i coef )
+{
+    const __m128i round  = _mm_set1_epi32( 128 );
+    const __m128i offset = _mm_set1_epi32( 16 );
+
+    __m128i y0 = SumPairs( _mm_madd_epi16( p01, coef ), _mm_madd_epi16( p23, coef ) );
+    __m128i y1 = SumPairs( _mm_madd_epi16( p45, coef ), _mm_madd_epi16( p67, coef ) );
+    y0 = _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( y0, round ), 8 ), offset );
+    y1 = _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( y1, round ), 8 ), offset );
+
+    const __m128i y16 = _mm_packs_epi32( y0, y1 );
+    return _mm_packus_epi16( y16, y16 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2x2 ブロック4個分の色差値を求めます. 入力は2行を加算済みの16bit値です.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t ComputeChroma4( __m128i s01, __m128i s23, __m128i s45, __m128i s67, __m128i coef )
+{
+    const __m128i round  = _mm_set1_epi32( 512 );
+    const __m128i offset = _mm_set1_epi32( 128 );
+
+    const __m128i c03 = SumPairs( _mm_madd_epi16( s01, coef ), _mm_madd_epi16( s23, coef ) );
+    const __m128i c47 = SumPairs( _mm_madd_epi16( s45, coef ), _mm_madd_epi16( s67, coef ) );
+    __m128i c = SumPairs( c03, c47 );
+    c = _mm_add_epi32( _mm_srai_epi32( _mm_add_epi32( c, round ), 10 ), offset );
+
+    const __m128i c16 = _mm_packs_epi32( c, c );
+    return uint32_t( _mm_cvtsi128_si32( _mm_packus_epi16( c16, c16 ) ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2行分を SSE2 で変換します. 戻り値は処理済みの画素数です.
+//-------------------------------------------------------------------------------------------------
+uint32_t ConvertRowPairSSE2
+(
+    const uint8_t*      pRow0,
+    const uint8_t*      pRow1,
+    uint32_t            width,
+    uint8_t*            pY0,
+    uint8_t*            pY1,
+    uint8_t*            pU,
+    uint8_t*            pV
+)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i coefY = _mm_setr_epi16( COEF_Y[0], COEF_Y[1], COEF_Y[2], 0, COEF_Y[0], COEF_Y[1], COEF_Y[2], 0 );
+    const __m128i coefU = _mm_setr_epi16( COEF_U[0], COEF_U[1], COEF_U[2], 0, COEF_U[0], COEF_U[1], COEF_U[2], 0 );
+    const __m128i coefV = _mm_setr_epi16( COEF_V[0], COEF_V[1], COEF_V[2], 0, COEF_V[0], COEF_V[1], COEF_V[2], 0 );
+
+    const uint32_t count = width & ~7u;
+    for( uint32_t x = 0; x < count; x += 8 )
+    {
+        const __m128i a0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow0 + x * 4 ) );
+        const __m128i a1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow0 + x * 4 + 16 ) );
+        const __m128i b0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow1 + x * 4 ) );
+        const __m128i b1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow1 + x * 4 + 16 ) );
+
+        const __m128i a01 = _mm_unpacklo_epi8( a0, zero );
+        const __m128i a23 = _mm_unpackhi_epi8( a0, zero );
+        const __m128i a45 = _mm_unpacklo_epi8( a1, zero );
+        const __m128i a67 = _mm_unpackhi_epi8( a1, zero );
+        const __m128i b01 = _mm_unpacklo_epi8( b0, zero );
+        const __m128i b23 = _mm_unpackhi_epi8( b0, zero );
+        const __m128i b45 = _mm_unpacklo_epi8( b1, zero );
+        const __m128i b67 = _mm_unpackhi_epi8( b1, zero );
+
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( pY0 + x ), ComputeY8( a01, a23, a45, a67, coefY ) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( pY1 + x ), ComputeY8( b01, b23, b45, b67, coefY ) );
+
+        const __m128i s01 = _mm_add_epi16( a01, b01 );
+        const __m128i s23 = _mm_add_epi16( a23, b23 );
+        const __m128i s45 = _mm_add_epi16( a45, b45 );
+        const __m128i s67 = _mm_add_epi16( a67, b67 );
+
+        const uint32_t u = ComputeChroma4( s01, s23, s45, s67, coefU );
+        const uint32_t v = ComputeChroma4( s01, s23, s45, s67, coefV );
+        memcpy( pU + x / 2, &u, sizeof(u) );
+        memcpy( pV + x / 2, &v, sizeof(v) );
+    }
+
+    return count;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 値にアルファを乗算します (c * a / 255 を丸めた値).
+//-------------------------------------------------------------------------------------------------
+inline uint32_t Premultiply8( uint32_t c, uint32_t a )
+{
+    const uint32_t t = c * a + 128;
+    return ( t + ( t >> 8 ) ) >> 8;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みの 8bit 値をアルファで除算します. SIMD 版と同じ順序で単精度演算します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t Unpremultiply8( uint32_t c, uint32_t a )
+{
+    if ( a == 0 )
+    { return 0; }
+
+    const float v = float( ( c < a ) ? c : a ) * 255.0f / float( a ) + 0.5f;
+    return uint32_t( v );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      0～1 に制限します. NaN は 0 になります.
+//-------------------------------------------------------------------------------------------------
+inline float Clamp01( float value )
+{
+    value = ( value > 0.0f ) ? value : 0.0f;
+    return ( value < 1.0f ) ? value : 1.0f;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      半精度浮動小数を単精度浮動小数に変換します.
+//-------------------------------------------------------------------------------------------------
+inline float HalfToFloat( uint16_t half )
+{
+    const uint32_t sign = uint32_t( half & 0x8000 ) << 16;
+    uint32_t exponent   = ( half >> 10 ) & 0x1F;
+    uint32_t mantissa   = half & 0x3FF;
+    uint32_t bits;
+
+    if ( exponent == 0 )
+    {
+        if ( mantissa == 0 )
+        { bits = sign; }
+        else
+        {
+            // 非正規化数を正規化する.
+            exponent = 113;
+            while( ( mantissa & 0x400 ) == 0 )
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | ( exponent << 23 ) | ( ( mantissa & 0x3FF ) << 13 );
+        }
+    }
+    else if ( exponent == 31 )
+    { bits = sign | 0x7F800000 | ( mantissa << 13 ) | ( ( mantissa != 0 ) ? 0x400000 : 0 ); }
+    else
+    { bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 ); }
+
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      単精度浮動小数を半精度浮動小数に変換します (最近接偶数丸め).
+//-------------------------------------------------------------------------------------------------
+inline uint16_t FloatToHalf( float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+
+    const uint32_t sign = ( bits >> 16 ) & 0x8000;
+    const uint32_t abs  = bits & 0x7FFFFFFF;
+
+    // 無限大と NaN.
+    if ( abs >= 0x7F800000 )
+    { return uint16_t( sign | 0x7C00 | ( ( abs > 0x7F800000 ) ? ( 0x200 | ( ( abs >> 13 ) & 0x3FF ) ) : 0 ) ); }
+
+    // 65520 以上は丸めると無限大.
+    if ( abs >= 0x477FF000 )
+    { return uint16_t( sign | 0x7C00 ); }
+
+    // 2^-14 未満は非正規化数 (2^-25 以下は 0).
+    if ( abs < 0x38800000 )
+    {
+        if ( abs <= 0x33000000 )
+        { return uint16_t( sign ); }
+
+        const uint32_t shift    = 126 - ( abs >> 23 );
+        const uint32_t mantissa = ( abs & 0x7FFFFF ) | 0x800000;
+        const uint32_t rest     = mantissa & ( ( 1u << shift ) - 1 );
+        const uint32_t halfway  = 1u << ( shift - 1 );
+        uint32_t result = mantissa >> shift;
+        if ( rest > halfway || ( rest == halfway && ( result & 1 ) ) )
+        { result++; }
+        return uint16_t( sign | result );
+    }
+
+    // 正規化数. 仮数の桁上がりはそのまま指数に繰り上がる.
+    uint32_t result = ( abs - 0x38000000 ) >> 13;
+    const uint32_t rest = abs & 0x1FFF;
+    if ( rest > 0x1000 || ( rest == 0x1000 && ( result & 1 ) ) )
+    { result++; }
+    return uint16_t( sign | result );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式同士の並べ替えとアルファの乗除算をスカラー演算で行います.
+//-------------------------------------------------------------------------------------------------
+void Convert8Scalar( const uint8_t* pSrc, uint8_t* pDst, uint32_t count, bool swap, ALPHA_OP op )
+{
+    for( uint32_t i = 0; i < count; ++i, pSrc += 4, pDst += 4 )
+    {
+        uint32_t c0 = pSrc[0];
+        uint32_t c1 = pSrc[1];
+        uint32_t c2 = pSrc[2];
+        const uint32_t a = pSrc[3];
+
+        if ( op == ALPHA_OP_PREMULTIPLY )
+        {
+            c0 = Premultiply8( c0, a );
+            c1 = Premultiply8( c1, a );
+            c2 = Premultiply8( c2, a );
+        }
+        else if ( op == ALPHA_OP_UNPREMULTIPLY )
+        {
+            c0 = Unpremultiply8( c0, a );
+            c1 = Unpremultiply8( c1, a );
+            c2 = Unpremultiply8( c2, a );
+        }
+
+        pDst[0] = uint8_t( swap ? c2 : c0 );
+        pDst[1] = uint8_t( c1 );
+        pDst[2] = uint8_t( swap ? c0 : c2 );
+        pDst[3] = uint8_t( a );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式をリニアの乗算済み RGBA 単精度浮動小数にスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void Unpack8Scalar( const uint8_t* pSrc, float* pDst, uint32_t count, bool swap, bool premul )
+{
+    const uint32_t ir = swap ? 2 : 0;
+    const uint32_t ib = swap ? 0 : 2;
+
+    for( uint32_t i = 0; i < count; ++i, pSrc += 4, pDst += 4 )
+    {
+        const uint32_t a = pSrc[3];
+        uint32_t r = pSrc[ir];
+        uint32_t g = pSrc[1];
+        uint32_t b = pSrc[ib];
+
+        if ( premul )
+        {
+            r = Unpremultiply8( r, a );
+            g = Unpremultiply8( g, a );
+            b = Unpremultiply8( b, a );
+        }
+
+        const float alpha = float( a ) * INV_255;
+        pDst[0] = g_Tables.Decode[r] * alpha;
+        pDst[1] = g_Tables.Decode[g] * alpha;
+        pDst[2] = g_Tables.Decode[b] * alpha;
+        pDst[3] = alpha;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの乗算済み RGBA 単精度浮動小数を 8bit 形式にスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void Pack8Scalar( const float* pSrc, uint8_t* pDst, uint32_t count, bool swap, bool premul )
+{
+    for( uint32_t i = 0; i < count; ++i, pSrc += 4, pDst += 4 )
+    {
+        const float    alpha = Clamp01( pSrc[3] );
+        const uint32_t a     = uint32_t( alpha * 255.0f + 0.5f );
+
+        uint32_t c[3];
+        for( uint32_t j = 0; j < 3; ++j )
+        {
+            const float v = Clamp01( ( alpha > 0.0f ) ? pSrc[j] / alpha : 0.0f );
+            c[j] = g_Tables.Encode[ uint32_t( v * float( ENCODE_TABLE_SIZE - 1 ) + 0.5f ) ];
+            if ( premul )
+            { c[j] = Premultiply8( c[j], a ); }
+        }
+
+        pDst[0] = uint8_t( swap ? c[2] : c[0] );
+        pDst[1] = uint8_t( c[1] );
+        pDst[2] = uint8_t( swap ? c[0] : c[2] );
+        pDst[3] = uint8_t( a );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      半精度浮動小数の配列をスカラー演算で単精度に変換します.
+//-------------------------------------------------------------------------------------------------
+void HalfToFloatScalar( const uint16_t* pSrc, float* pDst, uint32_t count )
+{
+    for( uint32_t i = 0; i < count; ++i )
+    { pDst[i] = HalfToFloat( pSrc[i] ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      単精度浮動小数の配列をスカラー演算で半精度に変換します.
+//-------------------------------------------------------------------------------------------------
+void FloatToHalfScalar( const float* pSrc, uint16_t* pDst, uint32_t count )
+{
+    for( uint32_t i = 0; i < count; ++i )
+    { pDst[i] = FloatToHalf( pSrc[i] ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      32bit 要素ごとの 8bit 値 4個にアルファを乗算します.
+//-------------------------------------------------------------------------------------------------
+inline __m128i Premultiply4( __m128i c, __m128i a )
+{
+    // 上位16bitは 0 なので 16bit 乗算の下位で c * a (最大 65025) が得られる.
+    const __m128i t = _mm_add_epi32( _mm_mullo_epi16( c, a ), _mm_set1_epi32( 128 ) );
+    return _mm_srli_epi32( _mm_add_epi32( t, _mm_srli_epi32( t, 8 ) ), 8 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      32bit 要素ごとの乗算済み 8bit 値 4個をアルファで除算します.
+//-------------------------------------------------------------------------------------------------
+inline __m128i Unpremultiply4( __m128i c, __m128 alpha, __m128 zeroMask )
+{
+    const __m128 v = _mm_min_ps( _mm_cvtepi32_ps( c ), alpha );
+    const __m128 q = _mm_add_ps( _mm_div_ps( _mm_mul_ps( v, _mm_set1_ps( 255.0f ) ), alpha ), _mm_set1_ps( 0.5f ) );
+    return _mm_andnot_si128( _mm_castps_si128( zeroMask ), _mm_cvttps_epi32( q ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テーブルから 4要素を引きます.
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+inline void Lookup4( const T* pTable, __m128i index, T* pResult )
+{
+    uint32_t idx[4];
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( idx ), index );
+    pResult[0] = pTable[idx[0]];
+    pResult[1] = pTable[idx[1]];
+    pResult[2] = pTable[idx[2]];
+    pResult[3] = pTable[idx[3]];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの値 4個を sRGB の 8bit 値にします.
+//-------------------------------------------------------------------------------------------------
+inline __m128i Encode4( __m128 c, __m128 alpha, __m128 validMask )
+{
+    __m128 v = _mm_and_ps( _mm_div_ps( c, alpha ), validMask );
+    v = _mm_min_ps( _mm_max_ps( v, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+    v = _mm_add_ps( _mm_mul_ps( v, _mm_set1_ps( float( ENCODE_TABLE_SIZE - 1 ) ) ), _mm_set1_ps( 0.5f ) );
+
+    uint32_t result[4];
+    Lookup4( g_Tables.Encode, _mm_cvttps_epi32( v ), result );
+    return _mm_loadu_si128( reinterpret_cast<const __m128i*>( result ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式同士の変換を SSE2 で行います. 戻り値は処理済みの画素数です.
+//-------------------------------------------------------------------------------------------------
+uint32_t Convert8SSE2( const uint8_t* pSrc, uint8_t* pDst, uint32_t count, bool swap, ALPHA_OP op )
+{
+    const __m128i mask = _mm_set1_epi32( 0xFF );
+    const __m128  zero = _mm_setzero_ps();
+
+    const uint32_t done = count & ~3u;
+    for( uint32_t x = 0; x < done; x += 4 )
+    {
+        const __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + x * 4 ) );
+        __m128i c0 = _mm_and_si128( px, mask );
+        __m128i c1 = _mm_and_si128( _mm_srli_epi32( px, 8 ), mask );
+        __m128i c2 = _mm_and_si128( _mm_srli_epi32( px, 16 ), mask );
+        const __m128i a = _mm_srli_epi32( px, 24 );
+
+        if ( op == ALPHA_OP_PREMULTIPLY )
+        {
+            c0 = Premultiply4( c0, a );
+            c1 = Premultiply4( c1, a );
+            c2 = Premultiply4( c2, a );
+        }
+        else if ( op == ALPHA_OP_UNPREMULTIPLY )
+        {
+            const __m128 alpha    = _mm_cvtepi32_ps( a );
+            const __m128 zeroMask = _mm_cmpeq_ps( alpha, zero );
+            c0 = Unpremultiply4( c0, alpha, zeroMask );
+            c1 = Unpremultiply4( c1, alpha, zeroMask );
+            c2 = Unpremultiply4( c2, alpha, zeroMask );
+        }
+
+        if ( swap )
+        { std::swap( c0, c2 ); }
+
+        __m128i result = _mm_or_si128( c0, _mm_slli_epi32( c1, 8 ) );
+        result = _mm_or_si128( result, _mm_slli_epi32( c2, 16 ) );
+        result = _mm_or_si128( result, _mm_slli_epi32( a, 24 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x * 4 ), result );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式をリニアの乗算済み RGBA 単精度浮動小数に SSE2 で変換します.
+//-------------------------------------------------------------------------------------------------
+uint32_t Unpack8SSE2( const uint8_t* pSrc, float* pDst, uint32_t count, bool swap, bool premul )
+{
+    const __m128i mask = _mm_set1_epi32( 0xFF );
+    const __m128  zero = _mm_setzero_ps();
+
+    const uint32_t done = count & ~3u;
+    for( uint32_t x = 0; x < done; x += 4 )
+    {
+        const __m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + x * 4 ) );
+        __m128i c0 = _mm_and_si128( px, mask );
+        __m128i c1 = _mm_and_si128( _mm_srli_epi32( px, 8 ), mask );
+        __m128i c2 = _mm_and_si128( _mm_srli_epi32( px, 16 ), mask );
+        const __m128 a = _mm_cvtepi32_ps( _mm_srli_epi32( px, 24 ) );
+
+        if ( premul )
+        {
+            const __m128 zeroMask = _mm_cmpeq_ps( a, zero );
+            c0 = Unpremultiply4( c0, a, zeroMask );
+            c1 = Unpremultiply4( c1, a, zeroMask );
+            c2 = Unpremultiply4( c2, a, zeroMask );
+        }
+
+        float r[4], g[4], b[4];
+        Lookup4( g_Tables.Decode, swap ? c2 : c0, r );
+        Lookup4( g_Tables.Decode, c1, g );
+        Lookup4( g_Tables.Decode, swap ? c0 : c2, b );
+
+        __m128 alpha = _mm_mul_ps( a, _mm_set1_ps( INV_255 ) );
+        __m128 vr    = _mm_mul_ps( _mm_loadu_ps( r ), alpha );
+        __m128 vg    = _mm_mul_ps( _mm_loadu_ps( g ), alpha );
+        __m128 vb    = _mm_mul_ps( _mm_loadu_ps( b ), alpha );
+        _MM_TRANSPOSE4_PS( vr, vg, vb, alpha );
+
+        _mm_storeu_ps( pDst + x * 4 + 0,  vr );
+        _mm_storeu_ps( pDst + x * 4 + 4,  vg );
+        _mm_storeu_ps( pDst + x * 4 + 8,  vb );
+        _mm_storeu_ps( pDst + x * 4 + 12, alpha );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの乗算済み RGBA 単精度浮動小数を 8bit 形式に SSE2 で変換します.
+//-------------------------------------------------------------------------------------------------
+uint32_t Pack8SSE2( const float* pSrc, uint8_t* pDst, uint32_t count, bool swap, bool premul )
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps( 1.0f );
+
+    const uint32_t done = count & ~3u;
+    for( uint32_t x = 0; x < done; x += 4 )
+    {
+        __m128 r     = _mm_loadu_ps( pSrc + x * 4 + 0 );
+        __m128 g     = _mm_loadu_ps( pSrc + x * 4 + 4 );
+        __m128 b     = _mm_loadu_ps( pSrc + x * 4 + 8 );
+        __m128 alpha = _mm_loadu_ps( pSrc + x * 4 + 12 );
+        _MM_TRANSPOSE4_PS( r, g, b, alpha );
+
+        alpha = _mm_min_ps( _mm_max_ps( alpha, zero ), one );
+        const __m128  validMask = _mm_cmpgt_ps( alpha, zero );
+        const __m128i a = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( alpha, _mm_set1_ps( 255.0f ) ), _mm_set1_ps( 0.5f ) ) );
+
+        __m128i cr = Encode4( r, alpha, validMask );
+        __m128i cg = Encode4( g, alpha, validMask );
+        __m128i cb = Encode4( b, alpha, validMask );
+        if ( premul )
+        {
+            cr = Premultiply4( cr, a );
+            cg = Premultiply4( cg, a );
+            cb = Premultiply4( cb, a );
+        }
+
+        __m128i result = _mm_or_si128( swap ? cb : cr, _mm_slli_epi32( cg, 8 ) );
+        result = _mm_or_si128( result, _mm_slli_epi32( swap ? cr : cb, 16 ) );
+        result = _mm_or_si128( result, _mm_slli_epi32( a, 24 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x * 4 ), result );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      32bit 要素ごとの 8bit 値 8個にアルファを乗算します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 inline __m256i Premultiply8x8( __m256i c, __m256i a )
+{
+    const __m256i t = _mm256_add_epi32( _mm256_mullo_epi16( c, a ), _mm256_set1_epi32( 128 ) );
+    return _mm256_srli_epi32( _mm256_add_epi32( t, _mm256_srli_epi32( t, 8 ) ), 8 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      32bit 要素ごとの乗算済み 8bit 値 8個をアルファで除算します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 inline __m256i Unpremultiply8x8( __m256i c, __m256 alpha, __m256 zeroMask )
+{
+    const __m256 v = _mm256_min_ps( _mm256_cvtepi32_ps( c ), alpha );
+    const __m256 q = _mm256_add_ps( _mm256_div_ps( _mm256_mul_ps( v, _mm256_set1_ps( 255.0f ) ), alpha ), _mm256_set1_ps( 0.5f ) );
+    return _mm256_andnot_si256( _mm256_castps_si256( zeroMask ), _mm256_cvttps_epi32( q ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの値 8個を sRGB の 8bit 値にします.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 inline __m256i Encode8x8( __m256 c, __m256 alpha, __m256 validMask )
+{
+    __m256 v = _mm256_and_ps( _mm256_div_ps( c, alpha ), validMask );
+    v = _mm256_min_ps( _mm256_max_ps( v, _mm256_setzero_ps() ), _mm256_set1_ps( 1.0f ) );
+    v = _mm256_add_ps( _mm256_mul_ps( v, _mm256_set1_ps( float( ENCODE_TABLE_SIZE - 1 ) ) ), _mm256_set1_ps( 0.5f ) );
+    return _mm256_i32gather_epi32( reinterpret_cast<const int*>( g_Tables.Encode ), _mm256_cvttps_epi32( v ), 4 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式同士の変換を AVX2 で行います. 戻り値は処理済みの画素数です.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 uint32_t Convert8AVX2( const uint8_t* pSrc, uint8_t* pDst, uint32_t count, bool swap, ALPHA_OP op )
+{
+    const __m256i mask = _mm256_set1_epi32( 0xFF );
+    const __m256  zero = _mm256_setzero_ps();
+
+    const uint32_t done = count & ~7u;
+    for( uint32_t x = 0; x < done; x += 8 )
+    {
+        const __m256i px = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + x * 4 ) );
+        __m256i c0 = _mm256_and_si256( px, mask );
+        __m256i c1 = _mm256_and_si256( _mm256_srli_epi32( px, 8 ), mask );
+        __m256i c2 = _mm256_and_si256( _mm256_srli_epi32( px, 16 ), mask );
+        const __m256i a = _mm256_srli_epi32( px, 24 );
+
+        if ( op == ALPHA_OP_PREMULTIPLY )
+        {
+            c0 = Premultiply8x8( c0, a );
+            c1 = Premultiply8x8( c1, a );
+            c2 = Premultiply8x8( c2, a );
+        }
+        else if ( op == ALPHA_OP_UNPREMULTIPLY )
+        {
+            const __m256 alpha    = _mm256_cvtepi32_ps( a );
+            const __m256 zeroMask = _mm256_cmp_ps( alpha, zero, _CMP_EQ_OQ );
+            c0 = Unpremultiply8x8( c0, alpha, zeroMask );
+            c1 = Unpremultiply8x8( c1, alpha, zeroMask );
+            c2 = Unpremultiply8x8( c2, alpha, zeroMask );
+        }
+
+        if ( swap )
+        { std::swap( c0, c2 ); }
+
+        __m256i result = _mm256_or_si256( c0, _mm256_slli_epi32( c1, 8 ) );
+        result = _mm256_or_si256( result, _mm256_slli_epi32( c2, 16 ) );
+        result = _mm256_or_si256( result, _mm256_slli_epi32( a, 24 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + x * 4 ), result );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式をリニアの乗算済み RGBA 単精度浮動小数に AVX2 で変換します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 uint32_t Unpack8AVX2( const uint8_t* pSrc, float* pDst, uint32_t count, bool swap, bool premul )
+{
+    const __m256i mask = _mm256_set1_epi32( 0xFF );
+    const __m256  zero = _mm256_setzero_ps();
+
+    const uint32_t done = count & ~7u;
+    for( uint32_t x = 0; x < done; x += 8 )
+    {
+        const __m256i px = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pSrc + x * 4 ) );
+        __m256i c0 = _mm256_and_si256( px, mask );
+        __m256i c1 = _mm256_and_si256( _mm256_srli_epi32( px, 8 ), mask );
+        __m256i c2 = _mm256_and_si256( _mm256_srli_epi32( px, 16 ), mask );
+        const __m256 a = _mm256_cvtepi32_ps( _mm256_srli_epi32( px, 24 ) );
+
+        if ( premul )
+        {
+            const __m256 zeroMask = _mm256_cmp_ps( a, zero, _CMP_EQ_OQ );
+            c0 = Unpremultiply8x8( c0, a, zeroMask );
+            c1 = Unpremultiply8x8( c1, a, zeroMask );
+            c2 = Unpremultiply8x8( c2, a, zeroMask );
+        }
+
+        const __m256 alpha = _mm256_mul_ps( a, _mm256_set1_ps( INV_255 ) );
+        const __m256 r = _mm256_mul_ps( _mm256_i32gather_ps( g_Tables.Decode, swap ? c2 : c0, 4 ), alpha );
+        const __m256 g = _mm256_mul_ps( _mm256_i32gather_ps( g_Tables.Decode, c1, 4 ), alpha );
+        const __m256 b = _mm256_mul_ps( _mm256_i32gather_ps( g_Tables.Decode, swap ? c0 : c2, 4 ), alpha );
+
+        // 成分ごとのレジスタを画素ごとに並べ替える.
+        const __m256 rg0 = _mm256_unpacklo_ps( r, g );      // r0 g0 r1 g1 | r4 g4 r5 g5
+        const __m256 rg1 = _mm256_unpackhi_ps( r, g );      // r2 g2 r3 g3 | r6 g6 r7 g7
+        const __m256 ba0 = _mm256_unpacklo_ps( b, alpha );
+        const __m256 ba1 = _mm256_unpackhi_ps( b, alpha );
+        const __m256 p04 = _mm256_shuffle_ps( rg0, ba0, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 p15 = _mm256_shuffle_ps( rg0, ba0, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        const __m256 p26 = _mm256_shuffle_ps( rg1, ba1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 p37 = _mm256_shuffle_ps( rg1, ba1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+
+        _mm256_storeu_ps( pDst + x * 4 + 0,  _mm256_permute2f128_ps( p04, p15, 0x20 ) );
+        _mm256_storeu_ps( pDst + x * 4 + 8,  _mm256_permute2f128_ps( p26, p37, 0x20 ) );
+        _mm256_storeu_ps( pDst + x * 4 + 16, _mm256_permute2f128_ps( p04, p15, 0x31 ) );
+        _mm256_storeu_ps( pDst + x * 4 + 24, _mm256_permute2f128_ps( p26, p37, 0x31 ) );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの乗算済み RGBA 単精度浮動小数を 8bit 形式に AVX2 で変換します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 uint32_t Pack8AVX2( const float* pSrc, uint8_t* pDst, uint32_t count, bool swap, bool premul )
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one  = _mm256_set1_ps( 1.0f );
+
+    const uint32_t done = count & ~7u;
+    for( uint32_t x = 0; x < done; x += 8 )
+    {
+        const __m256 v01 = _mm256_loadu_ps( pSrc + x * 4 + 0 );
+        const __m256 v23 = _mm256_loadu_ps( pSrc + x * 4 + 8 );
+        const __m256 v45 = _mm256_loadu_ps( pSrc + x * 4 + 16 );
+        const __m256 v67 = _mm256_loadu_ps( pSrc + x * 4 + 24 );
+
+        // 画素ごとの並びを成分ごとのレジスタに並べ替える.
+        const __m256 p04 = _mm256_permute2f128_ps( v01, v45, 0x20 );
+        const __m256 p15 = _mm256_permute2f128_ps( v01, v45, 0x31 );
+        const __m256 p26 = _mm256_permute2f128_ps( v23, v67, 0x20 );
+        const __m256 p37 = _mm256_permute2f128_ps( v23, v67, 0x31 );
+        const __m256 rg0 = _mm256_unpacklo_ps( p04, p15 );  // r0 r1 g0 g1 | r4 r5 g4 g5
+        const __m256 ba0 = _mm256_unpackhi_ps( p04, p15 );
+        const __m256 rg1 = _mm256_unpacklo_ps( p26, p37 );
+        const __m256 ba1 = _mm256_unpackhi_ps( p26, p37 );
+        const __m256 r   = _mm256_shuffle_ps( rg0, rg1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        const __m256 g   = _mm256_shuffle_ps( rg0, rg1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+        const __m256 b   = _mm256_shuffle_ps( ba0, ba1, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+        __m256 alpha     = _mm256_shuffle_ps( ba0, ba1, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+
+        alpha = _mm256_min_ps( _mm256_max_ps( alpha, zero ), one );
+        const __m256  validMask = _mm256_cmp_ps( alpha, zero, _CMP_GT_OQ );
+        const __m256i a = _mm256_cvttps_epi32( _mm256_add_ps( _mm256_mul_ps( alpha, _mm256_set1_ps( 255.0f ) ), _mm256_set1_ps( 0.5f ) ) );
+
+        __m256i cr = Encode8x8( r, alpha, validMask );
+        __m256i cg = Encode8x8( g, alpha, validMask );
+        __m256i cb = Encode8x8( b, alpha, validMask );
+        if ( premul )
+        {
+            cr = Premultiply8x8( cr, a );
+            cg = Premultiply8x8( cg, a );
+            cb = Premultiply8x8( cb, a );
+        }
+
+        __m256i result = _mm256_or_si256( swap ? cb : cr, _mm256_slli_epi32( cg, 8 ) );
+        result = _mm256_or_si256( result, _mm256_slli_epi32( swap ? cr : cb, 16 ) );
+        result = _mm256_or_si256( result, _mm256_slli_epi32( a, 24 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( pDst + x * 4 ), result );
+    }
+
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      半精度浮動小数の配列を F16C で単精度に変換します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 uint32_t HalfToFloatAVX2( const uint16_t* pSrc, float* pDst, uint32_t count )
+{
+    const uint32_t done = count & ~7u;
+    for( uint32_t i = 0; i < done; i += 8 )
+    {
+        const __m128i h = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrc + i ) );
+        _mm256_storeu_ps( pDst + i, _mm256_cvtph_ps( h ) );
+    }
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      単精度浮動小数の配列を F16C で半精度に変換します.
+//-------------------------------------------------------------------------------------------------
+TARGET_AVX2 uint32_t FloatToHalfAVX2( const float* pSrc, uint16_t* pDst, uint32_t count )
+{
+    const uint32_t done = count & ~7u;
+    for( uint32_t i = 0; i < done; i += 8 )
+    {
+        const __m128i h = _mm256_cvtps_ph( _mm256_loadu_ps( pSrc + i ), _MM_FROUND_TO_NEAREST_INT );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + i ), h );
+    }
+    return done;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式同士を変換します.
+//-------------------------------------------------------------------------------------------------
+void Convert8( SIMD_LEVEL level, const uint8_t* pSrc, uint8_t* pDst, uint32_t count, bool swap, ALPHA_OP op )
+{
+    uint32_t done = 0;
+    if ( level >= SIMD_LEVEL_AVX2 )
+    { done = Convert8AVX2( pSrc, pDst, count, swap, op ); }
+    else if ( level >= SIMD_LEVEL_SSE2 )
+    { done = Convert8SSE2( pSrc, pDst, count, swap, op ); }
+
+    Convert8Scalar( pSrc + done * 4, pDst + done * 4, count - done, swap, op );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 形式をリニアの乗算済み RGBA 単精度浮動小数に変換します.
+//-------------------------------------------------------------------------------------------------
+void Unpack8( SIMD_LEVEL level, const uint8_t* pSrc, float* pDst, uint32_t count, bool swap, bool premul )
+{
+    uint32_t done = 0;
+    if ( level >= SIMD_LEVEL_AVX2 )
+    { done = Unpack8AVX2( pSrc, pDst, count, swap, premul ); }
+    else if ( level >= SIMD_LEVEL_SSE2 )
+    { done = Unpack8SSE2( pSrc, pDst, count, swap, premul ); }
+
+    Unpack8Scalar( pSrc + done * 4, pDst + done * 4, count - done, swap, premul );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リニアの乗算済み RGBA 単精度浮動小数を 8bit 形式に変換します.
+//-------------------------------------------------------------------------------------------------
+void Pack8( SIMD_LEVEL level, const float* pSrc, uint8_t* pDst, uint32_t count, bool swap, bool premul )
+{
+    uint32_t done = 0;
+    if ( level >= SIMD_LEVEL_AVX2 )
+    { done = Pack8AVX2( pSrc, pDst, count, swap, premul ); }
+    else if ( level >= SIMD_LEVEL_SSE2 )
+    { done = Pack8SSE2( pSrc, pDst, count, swap, premul ); }
+
+    Pack8Scalar( pSrc + done * 4, pDst + done * 4, count - done, swap, premul );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      半精度浮動小数の配列を単精度に変換します. F16C が無い場合はスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void HalfToFloatRow( SIMD_LEVEL level, const uint16_t* pSrc, float* pDst, uint32_t count )
+{
+    const uint32_t done = ( level >= SIMD_LEVEL_AVX2 ) ? HalfToFloatAVX2( pSrc, pDst, count ) : 0;
+    HalfToFloatScalar( pSrc + done, pDst + done, count - done );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      単精度浮動小数の配列を半精度に変換します. F16C が無い場合はスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void FloatToHalfRow( SIMD_LEVEL level, const float* pSrc, uint16_t* pDst, uint32_t count )
+{
+    const uint32_t done = ( level >= SIMD_LEVEL_AVX2 ) ? FloatToHalfAVX2( pSrc, pDst, count ) : 0;
+    FloatToHalfScalar( pSrc + done, pDst + done, count - done );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1行を変換します.
+//-------------------------------------------------------------------------------------------------
+void ConvertRow
+(
+    SIMD_LEVEL      level,
+    PIXEL_FORMAT    srcFormat,
+    PIXEL_FORMAT    dstFormat,
+    const uint8_t*  pSrc,
+    uint8_t*        pDst,
+    uint32_t        width
+)
+{
+    const FormatInfo& src = FORMAT_INFO[srcFormat];
+    const FormatInfo& dst = FORMAT_INFO[dstFormat];
+
+    if ( srcFormat == dstFormat )
+    {
+        memcpy( pDst, pSrc, size_t( width ) * src.Size );
+        return;
+    }
+
+    // 8bit 同士は sRGB のまま並べ替えとアルファの乗除算だけを行う.
+    if ( src.Bits == 8 && dst.Bits == 8 )
+    {
+        const ALPHA_OP op = ( src.Premul == dst.Premul ) ? ALPHA_OP_NONE
+                          : ( dst.Premul ) ? ALPHA_OP_PREMULTIPLY : ALPHA_OP_UNPREMULTIPLY;
+        Convert8( level, pSrc, pDst, width, src.Swap != dst.Swap, op );
+        return;
+    }
+
+    // 浮動小数同士は精度の変換のみ.
+    if ( src.Bits != 8 && dst.Bits != 8 )
+    {
+        if ( src.Bits == 16 )
+        { HalfToFloatRow( level, reinterpret_cast<const uint16_t*>( pSrc ), reinterpret_cast<float*>( pDst ), width * 4 ); }
+        else
+        { FloatToHalfRow( level, reinterpret_cast<const float*>( pSrc ), reinterpret_cast<uint16_t*>( pDst ), width * 4 ); }
+        return;
+    }
+
+    // 単精度はそのまま読み書きし, 半精度は単精度の中間バッファを経由する.
+    if ( src.Bits == 8 )
+    {
+        if ( dst.Bits == 32 )
+        {
+            Unpack8( level, pSrc, reinterpret_cast<float*>( pDst ), width, src.Swap, src.Premul );
+            return;
+        }
+
+        float temp[CHUNK_PIXELS * 4];
+        uint16_t* pHalf = reinterpret_cast<uint16_t*>( pDst );
+        for( uint32_t x = 0; x < width; x += CHUNK_PIXELS )
+        {
+            const uint32_t count = ( width - x < CHUNK_PIXELS ) ? width - x : CHUNK_PIXELS;
+            Unpack8( level, pSrc + x * 4, temp, count, src.Swap, src.Premul );
+            FloatToHalfRow( level, temp, pHalf + x * 4, count * 4 );
+        }
+    }
+    else
+    {
+        if ( src.Bits == 32 )
+        {
+            Pack8( level, reinterpret_cast<const float*>( pSrc ), pDst, width, dst.Swap, dst.Premul );
+            return;
+        }
+
+        float temp[CHUNK_PIXELS * 4];
+        const uint16_t* pHalf = reinterpret_cast<const uint16_t*>( pSrc );
+        for( uint32_t x = 0; x < width; x += CHUNK_PIXELS )
+        {
+            const uint32_t count = ( width - x < CHUNK_PIXELS ) ? width - x : CHUNK_PIXELS;
+            HalfToFloatRow( level, pHalf + x * 4, temp, count * 4 );
+            Pack8( level, temp, pDst + x * 4, count, dst.Swap, dst.Premul );
+        }
+    }
+}
+
+} // namespace /* anonymous */
+
+
+//-------------------------------------------------------------------------------------------------
+//      B8G8R8A8 画像を YUV 4:2:0 に変換します.
+//-------------------------------------------------------------------------------------------------
+void ConvertBGRAToI420
+(
+    const uint8_t*      pSrc,
+    uint32_t            srcPitch,
+    uint32_t            width,
+    uint32_t            height,
+    const PlanarYUV&    dst
+)
+{
+    for( uint32_t y = 0; y < height; y += 2 )
+    {
+        uint32_t done = 0;
+
+        // 2行揃っている場合のみベクトル化.
+        if ( y + 1 < height )
+        {
+            done = ConvertRowPairSSE2(
+                pSrc + size_t( y     ) * srcPitch,
+                pSrc + size_t( y + 1 ) * srcPitch,
+                width,
+                dst.pY + size_t( y     ) * dst.PitchY,
+                dst.pY + size_t( y + 1 ) * dst.PitchY,
+                dst.pU + size_t( y / 2 ) * dst.PitchUV,
+                dst.pV + size_t( y / 2 ) * dst.PitchUV );
+        }
+
+        // 端数はスカラーで処理.
+        if ( done < width )
+        { ConvertBlockScalar( pSrc, srcPitch, width, height, done, width, y, dst ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      B8G8R8A8 画像を YUV 4:2:0 にスカラー演算で変換します.
+//-------------------------------------------------------------------------------------------------
+void ConvertBGRAToI420_Scalar
+(
+    const uint8_t*      pSrc,
+    uint32_t            srcPitch,
+    uint32_t            width,
+    uint32_t            height,
+    const PlanarYUV&    dst
+)
+{
+    for( uint32_t y = 0; y < height; y += 2 )
+    { ConvertBlockScalar( pSrc, srcPitch, width, height, 0, width, y, dst ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      実行中の CPU で使える最も高い SIMD レベルを取得します.
+//-------------------------------------------------------------------------------------------------
+SIMD_LEVEL GetSimdLevel()
+{ return g_SimdLevel; }
+
+//-------------------------------------------------------------------------------------------------
+//      1画素あたりのバイト数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t GetPixelFormatSize( PIXEL_FORMAT format )
+{ return ( format < PIXEL_FORMAT_COUNT ) ? FORMAT_INFO[format].Size : 0; }
+
+//-------------------------------------------------------------------------------------------------
+//      画素フォーマットを変換します.
+//-------------------------------------------------------------------------------------------------
+bool ConvertPixels
+(
+    const void*         pSrc,
+    uint32_t            srcPitch,
+    PIXEL_FORMAT        srcFormat,
+    void*               pDst,
+    uint32_t            dstPitch,
+    PIXEL_FORMAT        dstFormat,
+    uint32_t            width,
+    uint32_t            height,
+    ThreadPool*         pPool,
+    SIMD_LEVEL          maxLevel
+)
+{
+    if ( pSrc == nullptr || pDst == nullptr
+      || srcFormat >= PIXEL_FORMAT_COUNT || dstFormat >= PIXEL_FORMAT_COUNT
+      || size_t( srcPitch ) < size_t( width ) * FORMAT_INFO[srcFormat].Size
+      || size_t( dstPitch ) < size_t( width ) * FORMAT_INFO[dstFormat].Size )
+    { return false; }
+
+    const SIMD_LEVEL level = ( maxLevel < g_SimdLevel ) ? maxLevel : g_SimdLevel;
+    const uint8_t*   pSrcBytes = static_cast<const uint8_t*>( pSrc );
+    uint8_t*         pDstBytes = static_cast<uint8_t*>( pDst );
+
+    const size_t bytes = size_t( width ) * height * ( FORMAT_INFO[srcFormat].Size + FORMAT_INFO[dstFormat].Size );
+    if ( pPool != nullptr && bytes >= PARALLEL_MIN_BYTES && height >= BAND_MIN_ROWS * 2 )
+    {
+        // 呼び出し元も含めた 1 スレッドあたり 4 帯程度に分けて, 負荷の偏りを吸収する.
+        uint32_t bandRows = height / ( ( pPool->GetThreadCount() + 1 ) * 4 );
+        if ( bandRows < BAND_MIN_ROWS )
+        { bandRows = BAND_MIN_ROWS; }
+
+        const uint32_t bandCount = ( height + bandRows - 1 ) / bandRows;
+        pPool->ParallelFor( bandCount, [&]( uint32_t index )
+        {
+            const uint32_t y0 = index * bandRows;
+            const uint32_t y1 = ( y0 + bandRows < height ) ? y0 + bandRows : height;
+            for( uint32_t y = y0; y < y1; ++y )
+            { ConvertRow( level, srcFormat, dstFormat, pSrcBytes + size_t( y ) * srcPitch, pDstBytes + size_t( y ) * dstPitch, width ); }
+        });
+        return true;
+    }
+
+    for( uint32_t y = 0; y < height; ++y )
+    { ConvertRow( level, srcFormat, dstFormat, pSrcBytes + size_t( y ) * srcPitch, pDstBytes + size_t( y ) * dstPitch, width ); }
+
+    return true;
+}
@@ -0,0 +1,734 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : RenderGraph.cpp
+// Desc : Frame Render Graph with Transient Resource Aliasing.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <RenderGraph.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  INVALID_PASS    = 0xffffffff;       //!< 無効なパス番号です.
+const uint32_t  INVALID_SLOT    = 0xffffffff;       //!< 無効なスロット番号です.
+const uint64_t  HEAP_ALIGNMENT  = 64 * 1024;        //!< ヒープ内の配置境界です (タイルリソースのタイルサイズ).
+const uint32_t  SCHEDULE_WIDTH  = 32;               //!< 生存期間の表示の最大幅 (文字数) です.
+
+//-------------------------------------------------------------------------------------------------
+//      テクスチャの記述が等しいかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+bool IsSameDesc( const RenderTextureDesc& a, const RenderTextureDesc& b )
+{
+    return a.Width         == b.Width
+        && a.Height        == b.Height
+        && a.Format        == b.Format
+        && a.BytesPerPixel == b.BytesPerPixel
+        && a.SampleCount   == b.SampleCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      生存期間が重なるかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+bool IsOverlapped( const RenderGraph::ResourceInfo& a, const RenderGraph::ResourceInfo& b )
+{ return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass; }
+
+//-------------------------------------------------------------------------------------------------
+//      ヒープ内の配置境界に切り上げます.
+//-------------------------------------------------------------------------------------------------
+uint64_t AlignHeap( uint64_t bytes )
+{ return ( bytes + HEAP_ALIGNMENT - 1 ) & ~( HEAP_ALIGNMENT - 1 ); }
+
+//-------------------------------------------------------------------------------------------------
+//      重複しないように要素を追加します.
+//-------------------------------------------------------------------------------------------------
+bool PushUnique( std::vector<uint32_t>& values, uint32_t value )
+{
+    if ( std::find( values.begin(), values.end(), value ) != values.end() )
+    { return false; }
+
+    values.push_back( value );
+    return true;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RenderGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+RenderGraph::RenderGraph()
+: m_Compiled( false )
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+RenderGraph::~RenderGraph()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      一時リソースの実体を生成・破棄する処理を設定します.
+//      設定しない場合は実体を持たず, 配置とメモリ量の計算だけを行います.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::SetAllocator( const CreateFunc& create, const DestroyFunc& destroy )
+{
+    m_Create  = create;
+    m_Destroy = destroy;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレーム内だけで使う一時テクスチャを宣言します. 実体は Compile() で割り当てます.
+//-------------------------------------------------------------------------------------------------
+uint32_t RenderGraph::CreateTexture( const char* name, const RenderTextureDesc& desc )
+{
+    ResourceInfo info;
+    info.Name       = ( name != nullptr ) ? name : "";
+    info.Desc       = desc;
+    info.Bytes      = GetTextureBytes( desc );
+    info.Imported   = false;
+    info.pPhysical  = nullptr;
+    info.FirstPass  = INVALID_PASS;
+    info.LastPass   = 0;
+    info.Slot       = INVALID_SLOT;
+    info.HeapOffset = 0;
+
+    m_Resources.push_back( info );
+    m_Compiled = false;
+    return uint32_t( m_Resources.size() - 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      外部で管理するテクスチャを登録します. 書き込むパスはグラフの出力として扱います.
+//-------------------------------------------------------------------------------------------------
+uint32_t RenderGraph::ImportTexture( const char* name, const RenderTextureDesc& desc, void* pPhysical )
+{
+    const uint32_t index = CreateTexture( name, desc );
+    m_Resources[index].Imported  = true;
+    m_Resources[index].pPhysical = pPhysical;
+    return index;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パスを追加します. 追加した順序がリソースの読み書きの順序になります.
+//      sideEffect が true の場合は出力が使われなくても実行します (読み戻しなど).
+//-------------------------------------------------------------------------------------------------
+uint32_t RenderGraph::AddPass( const char* name, const PassFunc& func, bool sideEffect )
+{
+    PassInfo info;
+    info.Name       = ( name != nullptr ) ? name : "";
+    info.Func       = func;
+    info.SideEffect = sideEffect;
+    info.Live       = false;
+    info.Remaining  = 0;
+    info.Position   = INVALID_PASS;
+
+    m_Passes.push_back( info );
+    m_Compiled = false;
+    return uint32_t( m_Passes.size() - 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パスがリソースを読み込むことを宣言します.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::Read( uint32_t pass, uint32_t resource )
+{ return AddAccess( pass, resource, false ); }
+
+//-------------------------------------------------------------------------------------------------
+//      パスがリソースに書き込むことを宣言します.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::Write( uint32_t pass, uint32_t resource )
+{ return AddAccess( pass, resource, true ); }
+
+//-------------------------------------------------------------------------------------------------
+//      不要なパスを除き, 実行順を決めて一時リソースの実体を割り当てます.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::Compile()
+{
+    memset( &m_Stats, 0, sizeof(m_Stats) );
+    m_Stats.PassCount = uint32_t( m_Passes.size() );
+    m_Compiled = false;
+
+    BuildEdges();
+    CullPasses();
+
+    if ( !SortPasses() )
+    {
+        ELOG( "Error : RenderGraph::SortPasses() Failed." );
+        return false;
+    }
+
+    ComputeLifetimes();
+    AssignSlots();
+    PlaceInHeap();
+
+    for( size_t i = 0; i < m_Resources.size(); ++i )
+    {
+        const ResourceInfo& info = m_Resources[i];
+        if ( info.Imported || info.FirstPass == INVALID_PASS )
+        { continue; }
+
+        if ( m_Create && info.pPhysical == nullptr )
+        {
+            ELOG( "Error : Transient Texture Creation Failed. name = %s", info.Name );
+            return false;
+        }
+    }
+
+    m_Compiled = true;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      実行するパスを実行順に呼び出します.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::Execute()
+{
+    if ( !m_Compiled )
+    {
+        ELOG( "Error : RenderGraph is not compiled." );
+        return false;
+    }
+
+    for( size_t i = 0; i < m_Order.size(); ++i )
+    {
+        const PassInfo& pass = m_Passes[m_Order[i]];
+        if ( pass.Func )
+        { pass.Func( *this ); }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      次のフレームのためにパスとリソースの宣言を破棄します. 一時リソースの実体は使い回します.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::Reset()
+{
+    m_Passes   .clear();
+    m_Resources.clear();
+    m_Order    .clear();
+    m_Compiled = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 一時リソースの実体を全て破棄します.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::Term()
+{
+    Reset();
+
+    for( size_t i = 0; i < m_Slots.size(); ++i )
+    {
+        if ( m_Slots[i].pPhysical != nullptr && m_Destroy )
+        { m_Destroy( m_Slots[i].pPhysical ); }
+    }
+    m_Slots.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リソースの実体を取得します.
+//-------------------------------------------------------------------------------------------------
+void* RenderGraph::GetPhysical( uint32_t resource ) const
+{ return ( resource < m_Resources.size() ) ? m_Resources[resource].pPhysical : nullptr; }
+
+//-------------------------------------------------------------------------------------------------
+//      リソースの情報を取得します.
+//-------------------------------------------------------------------------------------------------
+const RenderGraph::ResourceInfo& RenderGraph::GetResourceInfo( uint32_t resource ) const
+{ return m_Resources[resource]; }
+
+//-------------------------------------------------------------------------------------------------
+//      リソース数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t RenderGraph::GetResourceCount() const
+{ return uint32_t( m_Resources.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      実行順のパス番号を取得します.
+//-------------------------------------------------------------------------------------------------
+const std::vector<uint32_t>& RenderGraph::GetOrder() const
+{ return m_Order; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+const RenderGraph::Stats& RenderGraph::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      実行順と一時リソースの生存期間, 割り当て結果を表示します.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::PrintSchedule() const
+{
+    const double MiB = 1024.0 * 1024.0;
+
+    std::printf( "Render Graph : %u passes, %u culled, %u transient textures in %u physical\n",
+        m_Stats.PassCount, m_Stats.CulledPassCount, m_Stats.TransientCount, m_Stats.PhysicalCount );
+
+    std::printf( "  order : " );
+    for( size_t i = 0; i < m_Order.size(); ++i )
+    { std::printf( "%s%s", ( i > 0 ) ? " -> " : "", m_Passes[m_Order[i]].Name ); }
+    std::printf( "\n" );
+
+    std::printf( "  culled :" );
+    for( size_t i = 0; i < m_Passes.size(); ++i )
+    {
+        if ( !m_Passes[i].Live )
+        { std::printf( " %s", m_Passes[i].Name ); }
+    }
+    std::printf( "\n" );
+
+    const uint32_t width = ( m_Order.size() < SCHEDULE_WIDTH ) ? uint32_t( m_Order.size() ) : SCHEDULE_WIDTH;
+    std::printf( "  %-16s %9s %-*s %5s %10s\n", "resource", "MiB", int( width + 2 ), "lifetime", "slot", "offset MiB" );
+    for( size_t i = 0; i < m_Resources.size(); ++i )
+    {
+        const ResourceInfo& info = m_Resources[i];
+
+        char bar[SCHEDULE_WIDTH + 1];
+        for( uint32_t x = 0; x < width; ++x )
+        { bar[x] = ( info.FirstPass != INVALID_PASS && x >= info.FirstPass && x <= info.LastPass ) ? '#' : '.'; }
+        bar[width] = '\0';
+
+        if ( info.Imported )
+        { std::printf( "  %-16s %9.2f |%s| %5s %10s\n", info.Name, double( info.Bytes ) / MiB, bar, "-", "imported" ); }
+        else if ( info.FirstPass == INVALID_PASS )
+        { std::printf( "  %-16s %9.2f |%s| %5s %10s\n", info.Name, double( info.Bytes ) / MiB, bar, "-", "unused" ); }
+        else
+        { std::printf( "  %-16s %9.2f |%s| %5u %10.2f\n", info.Name, double( info.Bytes ) / MiB, bar, info.Slot, double( info.HeapOffset ) / MiB ); }
+    }
+
+    std::printf( "  transient memory : %.2f MiB unaliased, %.2f MiB pooled, %.2f MiB placed, %.2f MiB lower bound\n",
+        double( m_Stats.UnaliasedBytes  ) / MiB,
+        double( m_Stats.PooledBytes     ) / MiB,
+        double( m_Stats.PlacedBytes     ) / MiB,
+        double( m_Stats.LowerBoundBytes ) / MiB );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テクスチャのバイト数を求めます.
+//-------------------------------------------------------------------------------------------------
+uint64_t RenderGraph::GetTextureBytes( const RenderTextureDesc& desc )
+{
+    const uint64_t samples = ( desc.SampleCount > 0 ) ? desc.SampleCount : 1;
+    return uint64_t( desc.Width ) * desc.Height * desc.BytesPerPixel * samples;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パスのリソースへのアクセスを追加します. 同じリソースへの読み書きは 1 つにまとめます.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::AddAccess( uint32_t pass, uint32_t resource, bool write )
+{
+    if ( pass >= m_Passes.size() || resource >= m_Resources.size() )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    std::vector<Access>& accesses = m_Passes[pass].Accesses;
+    for( size_t i = 0; i < accesses.size(); ++i )
+    {
+        if ( accesses[i].Resource == resource )
+        {
+            accesses[i].Read  |= !write;
+            accesses[i].Write |= write;
+            return true;
+        }
+    }
+
+    Access access;
+    access.Resource = resource;
+    access.Read     = !write;
+    access.Write    = write;
+    accesses.push_back( access );
+
+    m_Compiled = false;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リソースごとに追加順でアクセスをたどって依存関係を作ります.
+//      書き込みの後の読み込み (RAW), 読み込みの後の書き込み (WAR), 書き込み同士 (WAW) の順序を保ちます.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::BuildEdges()
+{
+    for( size_t i = 0; i < m_Passes.size(); ++i )
+    {
+        m_Passes[i].Producers .clear();
+        m_Passes[i].Successors.clear();
+        m_Passes[i].Live     = false;
+        m_Passes[i].Position = INVALID_PASS;
+    }
+
+    std::vector<uint32_t>& readers = m_Work;
+    for( uint32_t r = 0; r < m_Resources.size(); ++r )
+    {
+        uint32_t lastWriter = INVALID_PASS;
+        readers.clear();
+
+        for( uint32_t p = 0; p < m_Passes.size(); ++p )
+        {
+            const std::vector<Access>& accesses = m_Passes[p].Accesses;
+            for( size_t a = 0; a < accesses.size(); ++a )
+            {
+                const Access& access = accesses[a];
+                if ( access.Resource != r )
+                { continue; }
+
+                if ( access.Read && lastWriter != INVALID_PASS )
+                {
+                    PushUnique( m_Passes[lastWriter].Successors, p );
+                    PushUnique( m_Passes[p].Producers, lastWriter );
+                }
+
+                if ( access.Write )
+                {
+                    if ( lastWriter != INVALID_PASS )
+                    { PushUnique( m_Passes[lastWriter].Successors, p ); }
+
+                    for( size_t k = 0; k < readers.size(); ++k )
+                    {
+                        if ( readers[k] != p )
+                        { PushUnique( m_Passes[readers[k]].Successors, p ); }
+                    }
+
+                    readers.clear();
+                    lastWriter = p;
+                }
+                else
+                { readers.push_back( p ); }
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      外部リソースに書き込むパスと副作用を持つパスから, 読み込むリソースの書き込み元をたどって
+//      実行するパスを決めます. たどり着かなかったパスは実行しません.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::CullPasses()
+{
+    std::vector<uint32_t>& stack = m_Work;
+    stack.clear();
+
+    for( uint32_t p = 0; p < m_Passes.size(); ++p )
+    {
+        PassInfo& pass = m_Passes[p];
+
+        bool output = pass.SideEffect;
+        for( size_t a = 0; a < pass.Accesses.size() && !output; ++a )
+        { output = pass.Accesses[a].Write && m_Resources[pass.Accesses[a].Resource].Imported; }
+
+        if ( output )
+        {
+            pass.Live = true;
+            stack.push_back( p );
+        }
+    }
+
+    while( !stack.empty() )
+    {
+        const uint32_t p = stack.back();
+        stack.pop_back();
+
+        const std::vector<uint32_t>& producers = m_Passes[p].Producers;
+        for( size_t i = 0; i < producers.size(); ++i )
+        {
+            if ( !m_Passes[producers[i]].Live )
+            {
+                m_Passes[producers[i]].Live = true;
+                stack.push_back( producers[i] );
+            }
+        }
+    }
+
+    for( size_t i = 0; i < m_Passes.size(); ++i )
+    {
+        if ( !m_Passes[i].Live )
+        { m_Stats.CulledPassCount++; }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      実行するパスをトポロジカルソートします. 実行可能なパスのうち, 直前に書き込まれた
+//      リソースを読むものを優先して一時リソースの生存期間を短くします.
+//-------------------------------------------------------------------------------------------------
+bool RenderGraph::SortPasses()
+{
+    uint32_t liveCount = 0;
+    for( size_t i = 0; i < m_Passes.size(); ++i )
+    { m_Passes[i].Remaining = 0; }
+
+    for( size_t i = 0; i < m_Passes.size(); ++i )
+    {
+        if ( !m_Passes[i].Live )
+        { continue; }
+
+        liveCount++;
+        const std::vector<uint32_t>& successors = m_Passes[i].Successors;
+        for( size_t k = 0; k < successors.size(); ++k )
+        {
+            if ( m_Passes[successors[k]].Live )
+            { m_Passes[successors[k]].Remaining++; }
+        }
+    }
+
+    std::vector<uint32_t>& ready = m_Work;
+    ready.clear();
+    for( uint32_t p = 0; p < m_Passes.size(); ++p )
+    {
+        if ( m_Passes[p].Live && m_Passes[p].Remaining == 0 )
+        { ready.push_back( p ); }
+    }
+
+    m_Order.clear();
+    while( !ready.empty() )
+    {
+        // 書き込み元の実行位置が最も新しいものを選ぶ. 同じ場合は追加順を優先する.
+        size_t   best      = 0;
+        int64_t  bestScore = -2;
+        for( size_t i = 0; i < ready.size(); ++i )
+        {
+            const PassInfo& pass = m_Passes[ready[i]];
+
+            int64_t score = -1;
+            for( size_t k = 0; k < pass.Producers.size(); ++k )
+            {
+                const PassInfo& producer = m_Passes[pass.Producers[k]];
+                if ( producer.Live && int64_t( producer.Position ) > score )
+                { score = int64_t( producer.Position ); }
+            }
+
+            if ( score > bestScore || ( score == bestScore && ready[i] < ready[best] ) )
+            {
+                best      = i;
+                bestScore = score;
+            }
+        }
+
+        const uint32_t p = ready[best];
+        ready.erase( ready.begin() + best );
+
+        m_Passes[p].Position = uint32_t( m_Order.size() );
+        m_Order.push_back( p );
+
+        const std::vector<uint32_t>& successors = m_Passes[p].Successors;
+        for( size_t k = 0; k < successors.size(); ++k )
+        {
+            PassInfo& successor = m_Passes[successors[k]];
+            if ( successor.Live && --successor.Remaining == 0 )
+            { ready.push_back( successors[k] ); }
+        }
+    }
+
+    return m_Order.size() == liveCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      リソースを最初と最後に使う実行順の位置を求めます.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::ComputeLifetimes()
+{
+    for( size_t i = 0; i < m_Resources.size(); ++i )
+    {
+        m_Resources[i].FirstPass = INVALID_PASS;
+        m_Resources[i].LastPass  = 0;
+        m_Resources[i].Slot      = INVALID_SLOT;
+        if ( !m_Resources[i].Imported )
+        { m_Resources[i].pPhysical = nullptr; }
+    }
+
+    for( uint32_t position = 0; position < m_Order.size(); ++position )
+    {
+        const std::vector<Access>& accesses = m_Passes[m_Order[position]].Accesses;
+        for( size_t a = 0; a < accesses.size(); ++a )
+        {
+            ResourceInfo& info = m_Resources[accesses[a].Resource];
+            if ( info.FirstPass == INVALID_PASS )
+            { info.FirstPass = position; }
+            info.LastPass = position;
+        }
+    }
+
+    for( size_t i = 0; i < m_Resources.size(); ++i )
+    {
+        const ResourceInfo& info = m_Resources[i];
+        if ( info.Imported || info.FirstPass == INVALID_PASS )
+        { continue; }
+
+        m_Stats.TransientCount++;
+        m_Stats.UnaliasedBytes += info.Bytes;
+    }
+
+    // 各位置で生存している一時リソースの合計の最大値.
+    for( uint32_t position = 0; position < m_Order.size(); ++position )
+    {
+        uint64_t live = 0;
+        for( size_t i = 0; i < m_Resources.size(); ++i )
+        {
+            const ResourceInfo& info = m_Resources[i];
+            if ( !info.Imported && info.FirstPass != INVALID_PASS && info.FirstPass <= position && position <= info.LastPass )
+            { live += info.Bytes; }
+        }
+
+        if ( live > m_Stats.LowerBoundBytes )
+        { m_Stats.LowerBoundBytes = live; }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      同じ記述で生存期間が重ならない一時リソースに同じ実テクスチャを割り当てます.
+//      D3D11 はヒープ内への配置ができないため, 実体の共有はこの方法で行います.
+//      前のフレームの実テクスチャを使い回し, このフレームで使わなかったものは破棄します.
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::AssignSlots()
+{
+    for( size_t i = 0; i < m_Slots.size(); ++i )
+    {
+        m_Slots[i].Used     = false;
+        m_Slots[i].LastPass = 0;
+    }
+
+    // 最初に使う位置の順に割り当てる.
+    std::vector<uint32_t>& indices = m_Work;
+    indices.clear();
+    for( uint32_t i = 0; i < m_Resources.size(); ++i )
+    {
+        if ( !m_Resources[i].Imported && m_Resources[i].FirstPass != INVALID_PASS )
+        { indices.push_back( i ); }
+    }
+    std::stable_sort( indices.begin(), indices.end(), [this]( uint32_t a, uint32_t b )
+    { return m_Resources[a].FirstPass < m_Resources[b].FirstPass; } );
+
+    for( size_t i = 0; i < indices.size(); ++i )
+    {
+        ResourceInfo& info = m_Resources[indices[i]];
+
+        // 同じ記述で空いているもの, 実体を持たないもの, 新規の順に探す.
+        uint32_t slot = INVALID_SLOT;
+        for( uint32_t s = 0; s < m_Slots.size() && slot == INVALID_SLOT; ++s )
+        {
+            const Slot& candidate = m_Slots[s];
+            if ( IsSameDesc( candidate.Desc, info.Desc ) && ( candidate.pPhysical != nullptr || !m_Create )
+              && ( !candidate.Used || candidate.LastPass < info.FirstPass ) )
+            { slot = s; }
+        }
+
+        for( uint32_t s = 0; s < m_Slots.size() && slot == INVALID_SLOT; ++s )
+        {
+            if ( !m_Slots[s].Used && m_Slots[s].pPhysical == nullptr )
+            { slot = s; }
+        }
+
+        if ( slot == INVALID_SLOT )
+        {
+            Slot added;
+            memset( &added, 0, sizeof(added) );
+            m_Slots.push_back( added );
+            slot = uint32_t( m_Slots.size() - 1 );
+        }
+
+        Slot& target = m_Slots[slot];
+        if ( !IsSameDesc( target.Desc, info.Desc ) )
+        {
+            target.Desc = info.Desc;
+            if ( target.pPhysical != nullptr && m_Destroy )
+            { m_Destroy( target.pPhysical ); }
+            target.pPhysical = nullptr;
+        }
+
+        if ( target.pPhysical == nullptr && m_Create )
+        { target.pPhysical = m_Create( info.Desc ); }
+
+        target.Used     = true;
+        target.LastPass = info.LastPass;
+        info.Slot       = slot;
+        info.pPhysical  = target.pPhysical;
+    }
+
+    // このフレームで使わなかった実テクスチャは破棄する.
+    for( size_t i = 0; i < m_Slots.size(); ++i )
+    {
+        Slot& slot = m_Slots[i];
+        if ( slot.Used )
+        {
+            m_Stats.PhysicalCount++;
+            m_Stats.PooledBytes += GetTextureBytes( slot.Desc );
+            continue;
+        }
+
+        if ( slot.pPhysical != nullptr && m_Destroy )
+        { m_Destroy( slot.pPhysical ); }
+        memset( &slot, 0, sizeof(slot) );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      一時リソースを共有ヒープ内に配置します. 大きいものから順に, 生存期間が重なるものと
+//      メモリが重ならない最も低いオフセットに置きます (D3D12 の配置リソースやタイルリソース向け).
+//-------------------------------------------------------------------------------------------------
+void RenderGraph::PlaceInHeap()
+{
+    std::vector<uint32_t>& indices = m_Work;
+    indices.clear();
+    for( uint32_t i = 0; i < m_Resources.size(); ++i )
+    {
+        if ( !m_Resources[i].Imported && m_Resources[i].FirstPass != INVALID_PASS )
+        { indices.push_back( i ); }
+    }
+    std::stable_sort( indices.begin(), indices.end(), [this]( uint32_t a, uint32_t b )
+    { return m_Resources[a].Bytes > m_Resources[b].Bytes; } );
+
+    for( size_t i = 0; i < indices.size(); ++i )
+    {
+        ResourceInfo& info = m_Resources[indices[i]];
+        const uint64_t size = AlignHeap( info.Bytes );
+
+        // 候補は 0 と, 生存期間が重なる配置済みリソースの終端.
+        uint64_t best = UINT64_MAX;
+        for( size_t c = 0; c <= i; ++c )
+        {
+            uint64_t candidate = 0;
+            if ( c < i )
+            {
+                const ResourceInfo& placed = m_Resources[indices[c]];
+                if ( !IsOverlapped( placed, info ) )
+                { continue; }
+                candidate = placed.HeapOffset + AlignHeap( placed.Bytes );
+            }
+
+            if ( candidate >= best )
+            { continue; }
+
+            bool fit = true;
+            for( size_t k = 0; k < i && fit; ++k )
+            {
+                const ResourceInfo& placed = m_Resources[indices[k]];
+                if ( IsOverlapped( placed, info )
+                  && candidate < placed.HeapOffset + AlignHeap( placed.Bytes )
+                  && placed.HeapOffset < candidate + size )
+                { fit = false; }
+            }
+
+            if ( fit )
+            { best = candidate; }
+        }
+
+        info.HeapOffset = best;
+        if ( best + size > m_Stats.PlacedBytes )
+        { m_Stats.PlacedBytes = best + size; }
+    }
+}
@@ -0,0 +1,223 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ResourceTracker.cpp
+// Desc : GPU/CPU Resource Memory Accounting.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <ResourceTracker.h>
+#include <Logger.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+//      使用量を加算し, 最大値を更新します.
+//-------------------------------------------------------------------------------------------------
+void AddUsage( ResourceTracker::Usage& usage, uint64_t bytes )
+{
+    usage.Bytes += bytes;
+    usage.Count++;
+    if ( usage.Bytes > usage.PeakBytes )
+    { usage.PeakBytes = usage.Bytes; }
+    if ( usage.Count > usage.PeakCount )
+    { usage.PeakCount = usage.Count; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      使用量を減算します.
+//-------------------------------------------------------------------------------------------------
+void RemoveUsage( ResourceTracker::Usage& usage, uint64_t bytes )
+{
+    usage.Bytes -= bytes;
+    usage.Count--;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ResourceTracker class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+ResourceTracker::ResourceTracker()
+: m_FrameAlloc  ( 0 )
+, m_FrameFree   ( 0 )
+{ memset( &m_Snapshot, 0, sizeof(m_Snapshot) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+ResourceTracker::~ResourceTracker()
+{ Clear(); }
+
+//-------------------------------------------------------------------------------------------------
+//      生成したリソースを登録します. 登録済みのリソースや nullptr は失敗します.
+//-------------------------------------------------------------------------------------------------
+bool ResourceTracker::Track( const void* pResource, RESOURCE_CATEGORY category, uint64_t bytes )
+{
+    if ( pResource == nullptr || category >= RESOURCE_CATEGORY_COUNT )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    Entry entry;
+    entry.Category = category;
+    entry.Bytes    = bytes;
+    if ( !m_Entries.insert( std::make_pair( pResource, entry ) ).second )
+    {
+        ELOG( "Error : Resource Already Tracked. category = %s", GetCategoryName( category ) );
+        return false;
+    }
+
+    AddUsage( m_Snapshot.Category[category], bytes );
+    AddUsage( m_Snapshot.Total, bytes );
+    m_Snapshot.TotalAllocBytes += bytes;
+    m_FrameAlloc += bytes;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      解放するリソースの登録を解除します. nullptr の場合は何もしません.
+//-------------------------------------------------------------------------------------------------
+bool ResourceTracker::Untrack( const void* pResource )
+{
+    if ( pResource == nullptr )
+    { return true; }
+
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    auto itr = m_Entries.find( pResource );
+    if ( itr == m_Entries.end() )
+    {
+        ELOG( "Error : Resource Not Tracked." );
+        return false;
+    }
+
+    const Entry& entry = itr->second;
+    RemoveUsage( m_Snapshot.Category[entry.Category], entry.Bytes );
+    RemoveUsage( m_Snapshot.Total, entry.Bytes );
+    m_Snapshot.TotalFreeBytes += entry.Bytes;
+    m_FrameFree += entry.Bytes;
+
+    m_Entries.erase( itr );
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全ての登録と統計情報を破棄します.
+//-------------------------------------------------------------------------------------------------
+void ResourceTracker::Clear()
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    m_Entries.clear();
+    m_Trim       = nullptr;
+    m_FrameAlloc = 0;
+    m_FrameFree  = 0;
+    memset( &m_Snapshot, 0, sizeof(m_Snapshot) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      予算と, 超過したときに呼び出す削減処理を設定します. bytes が 0 の場合は無制限です.
+//-------------------------------------------------------------------------------------------------
+void ResourceTracker::SetBudget( uint64_t bytes, const TrimFunc& trim )
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    m_Snapshot.BudgetBytes = bytes;
+    m_Trim                 = trim;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの終わりに呼び出して確保と解放の量を確定し, 予算を超えていれば削減処理を呼び出します.
+//      削減処理はリソースの解放で Untrack() を呼ぶので, ロックを外してから呼び出す.
+//-------------------------------------------------------------------------------------------------
+void ResourceTracker::EndFrame()
+{
+    uint64_t excess = 0;
+    TrimFunc trim;
+    {
+        std::lock_guard<std::mutex> locker( m_Mutex );
+
+        const uint64_t churn = m_FrameAlloc + m_FrameFree;
+        m_Snapshot.FrameCount++;
+        m_Snapshot.FrameAllocBytes = m_FrameAlloc;
+        m_Snapshot.FrameFreeBytes  = m_FrameFree;
+        if ( churn > m_Snapshot.MaxFrameChurnBytes )
+        { m_Snapshot.MaxFrameChurnBytes = churn; }
+        m_FrameAlloc = 0;
+        m_FrameFree  = 0;
+
+        if ( m_Snapshot.BudgetBytes == 0 || m_Snapshot.Total.Bytes <= m_Snapshot.BudgetBytes || !m_Trim )
+        { return; }
+
+        excess = m_Snapshot.Total.Bytes - m_Snapshot.BudgetBytes;
+        trim   = m_Trim;
+        m_Snapshot.TrimCount++;
+    }
+
+    trim( excess );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在の使用量を取得します.
+//-------------------------------------------------------------------------------------------------
+ResourceTracker::Snapshot ResourceTracker::GetSnapshot() const
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    return m_Snapshot;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      最大値と累計をリセットします. 現在の使用量と予算はそのまま残します.
+//-------------------------------------------------------------------------------------------------
+void ResourceTracker::ResetStats()
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    for( uint32_t i = 0; i < RESOURCE_CATEGORY_COUNT; ++i )
+    {
+        m_Snapshot.Category[i].PeakBytes = m_Snapshot.Category[i].Bytes;
+        m_Snapshot.Category[i].PeakCount = m_Snapshot.Category[i].Count;
+    }
+    m_Snapshot.Total.PeakBytes    = m_Snapshot.Total.Bytes;
+    m_Snapshot.Total.PeakCount    = m_Snapshot.Total.Count;
+    m_Snapshot.FrameCount         = 0;
+    m_Snapshot.FrameAllocBytes    = 0;
+    m_Snapshot.FrameFreeBytes     = 0;
+    m_Snapshot.MaxFrameChurnBytes = 0;
+    m_Snapshot.TotalAllocBytes    = 0;
+    m_Snapshot.TotalFreeBytes     = 0;
+    m_Snapshot.TrimCount          = 0;
+    m_FrameAlloc = 0;
+    m_FrameFree  = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      種類の名前を取得します.
+//-------------------------------------------------------------------------------------------------
+const char* ResourceTracker::GetCategoryName( RESOURCE_CATEGORY category )
+{
+    static const char* names[RESOURCE_CATEGORY_COUNT] = {
+        "swap chain",
+        "view",
+        "depth stencil",
+        "d2d bitmap",
+        "vertex buffer",
+        "texture",
+        "staging",
+        "surface",
+    };
+
+    return ( category < RESOURCE_CATEGORY_COUNT ) ? names[category] : "unknown";
+}
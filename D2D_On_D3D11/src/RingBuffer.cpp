@@ -0,0 +1,445 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : RingBuffer.cpp
+// Desc : Fenced Ring Allocator for Per-Frame Streaming Data.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <RingBuffer.h>
+#include <Logger.h>
+#include <Timer.h>
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#endif
+
+
+#if defined(_WIN32)
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// D3D11GpuFence class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+D3D11GpuFence::D3D11GpuFence()
+: m_pContext ( nullptr )
+, m_Signaled ( 0 )
+, m_Completed( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+D3D11GpuFence::~D3D11GpuFence()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. maxPending は同時に GPU に積めるフェンスの最大数です.
+//-------------------------------------------------------------------------------------------------
+bool D3D11GpuFence::Init( ID3D11Device* pDevice, ID3D11DeviceContext* pContext, uint32_t maxPending )
+{
+    if ( pDevice == nullptr || pContext == nullptr || maxPending == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    D3D11_QUERY_DESC desc;
+    desc.Query     = D3D11_QUERY_EVENT;
+    desc.MiscFlags = 0;
+
+    m_Queries.resize( maxPending, nullptr );
+    for( uint32_t i = 0; i < maxPending; ++i )
+    {
+        HRESULT hr = pDevice->CreateQuery( &desc, &m_Queries[i] );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateQuery() Failed." );
+            Term();
+            return false;
+        }
+    }
+
+    m_pContext  = pContext;
+    m_Signaled  = 0;
+    m_Completed = 0;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void D3D11GpuFence::Term()
+{
+    for( size_t i = 0; i < m_Queries.size(); ++i )
+    {
+        if ( m_Queries[i] )
+        { m_Queries[i]->Release(); }
+    }
+    m_Queries.clear();
+    m_pContext = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フェンスを置きます. クエリを使い切っている場合は最も古いフェンスを待ちます.
+//-------------------------------------------------------------------------------------------------
+uint64_t D3D11GpuFence::Signal()
+{
+    const uint64_t value = m_Signaled + 1;
+    const uint64_t count = m_Queries.size();
+    if ( value > count && m_Completed < value - count )
+    { Wait( value - count ); }
+
+    m_pContext->End( m_Queries[ ( value - 1 ) % count ] );
+    m_Signaled = value;
+    return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      GPU が処理を終えたフェンスの最大値を取得します. コマンドのフラッシュは行いません.
+//-------------------------------------------------------------------------------------------------
+uint64_t D3D11GpuFence::GetCompletedValue()
+{
+    while( m_Completed < m_Signaled )
+    {
+        ID3D11Query* pQuery = m_Queries[ m_Completed % m_Queries.size() ];
+
+        BOOL done = FALSE;
+        if ( m_pContext->GetData( pQuery, &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH ) != S_OK || !done )
+        { break; }
+
+        m_Completed++;
+    }
+
+    return m_Completed;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定したフェンスまで GPU が処理を終えるのを待ちます.
+//-------------------------------------------------------------------------------------------------
+void D3D11GpuFence::Wait( uint64_t value )
+{
+    if ( value > m_Signaled )
+    { value = m_Signaled; }
+
+    // 積まれたままのコマンドが GPU に送られるよう, 待つ前に一度フラッシュする.
+    if ( GetCompletedValue() < value )
+    { m_pContext->Flush(); }
+
+    while( GetCompletedValue() < value )
+    { std::this_thread::yield(); }
+}
+#endif//defined(_WIN32)
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SimulatedGpuFence class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SimulatedGpuFence::SimulatedGpuFence()
+: m_Completed( 0 )
+, m_Signaled ( 0 )
+, m_FrameMsec( 0.0 )
+, m_Quit     ( false )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SimulatedGpuFence::~SimulatedGpuFence()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. GPU の代わりにフェンスを1つずつ処理するスレッドを起動します.
+//      フェンス1つ分の処理に frameMsec だけかかり, 完了の直前に execute を呼び出します.
+//-------------------------------------------------------------------------------------------------
+bool SimulatedGpuFence::Init( double frameMsec, const ExecuteFunc& execute )
+{
+    if ( frameMsec < 0.0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    m_FrameMsec = frameMsec;
+    m_Execute   = execute;
+    m_Signaled  = 0;
+    m_Completed = 0;
+    m_Quit      = false;
+    m_Thread    = std::thread( &SimulatedGpuFence::ThreadMain, this );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 未処理のフェンスは完了したものとして扱います.
+//-------------------------------------------------------------------------------------------------
+void SimulatedGpuFence::Term()
+{
+    if ( !m_Thread.joinable() )
+    { return; }
+
+    {
+        std::lock_guard<std::mutex> locker( m_Mutex );
+        m_Quit = true;
+    }
+    m_Cond.notify_all();
+    m_Thread.join();
+
+    m_Pending.clear();
+    m_Completed = m_Signaled;
+    m_Execute   = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フェンスを置きます.
+//-------------------------------------------------------------------------------------------------
+uint64_t SimulatedGpuFence::Signal()
+{
+    uint64_t value = 0;
+    {
+        std::lock_guard<std::mutex> locker( m_Mutex );
+        value = ++m_Signaled;
+        m_Pending.push_back( value );
+    }
+    m_Cond.notify_all();
+    return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      処理を終えたフェンスの最大値を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t SimulatedGpuFence::GetCompletedValue()
+{ return m_Completed.load(); }
+
+//-------------------------------------------------------------------------------------------------
+//      指定したフェンスまで処理を終えるのを待ちます.
+//-------------------------------------------------------------------------------------------------
+void SimulatedGpuFence::Wait( uint64_t value )
+{
+    std::unique_lock<std::mutex> locker( m_Mutex );
+    m_Cond.wait( locker, [&]() { return m_Quit || m_Completed.load() >= value; } );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      GPU の代わりにフェンスを順に処理するスレッドです.
+//-------------------------------------------------------------------------------------------------
+void SimulatedGpuFence::ThreadMain()
+{
+    for( ;; )
+    {
+        uint64_t value = 0;
+        {
+            std::unique_lock<std::mutex> locker( m_Mutex );
+            m_Cond.wait( locker, [&]() { return m_Quit || !m_Pending.empty(); } );
+            if ( m_Quit )
+            { break; }
+
+            value = m_Pending.front();
+        }
+
+        if ( m_FrameMsec > 0.0 )
+        { std::this_thread::sleep_for( std::chrono::microseconds( int64_t( m_FrameMsec * 1000.0 ) ) ); }
+
+        if ( m_Execute )
+        { m_Execute( value ); }
+
+        {
+            std::lock_guard<std::mutex> locker( m_Mutex );
+            m_Pending.pop_front();
+            m_Completed.store( value );
+        }
+        m_Cond.notify_all();
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RingBuffer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+RingBuffer::RingBuffer()
+: m_pFence  ( nullptr )
+, m_Capacity( 0 )
+, m_Head    ( 0 )
+, m_Tail    ( 0 )
+, m_Discard ( true )
+{ ResetStats(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+RingBuffer::~RingBuffer()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. capacity はバッファのバイト数で, pFence は GPU の進み具合を
+//      知るためのフェンスです. バッファの実体は呼び出し側が持ちます.
+//-------------------------------------------------------------------------------------------------
+bool RingBuffer::Init( uint64_t capacity, GpuFence* pFence )
+{
+    if ( capacity == 0 || pFence == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    m_pFence   = pFence;
+    m_Capacity = capacity;
+    m_Head     = 0;
+    m_Tail     = 0;
+    m_Discard  = true;
+    ResetStats();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. バッファを解放できるよう, GPU が使用中のフレームを待ちます.
+//-------------------------------------------------------------------------------------------------
+void RingBuffer::Term()
+{
+    if ( m_pFence != nullptr && !m_Frames.empty() )
+    { m_pFence->Wait( m_Frames.back().Fence ); }
+
+    m_Frames.clear();
+    m_pFence   = nullptr;
+    m_Capacity = 0;
+    m_Head     = 0;
+    m_Tail     = 0;
+    m_Discard  = true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      領域を確保します. alignment は 2 のべき乗で, 容量を割り切れる必要があります.
+//      末尾に収まらない場合は先頭に折り返し, GPU が使用中の領域と重なる場合は
+//      重ならなくなるまで古いフレームのフェンスを待ちます.
+//-------------------------------------------------------------------------------------------------
+bool RingBuffer::Allocate( uint64_t size, uint64_t alignment, RingAllocation& result )
+{
+    if ( m_pFence == nullptr || size == 0 || size > m_Capacity
+      || alignment == 0 || ( alignment & ( alignment - 1 ) ) != 0 || ( m_Capacity % alignment ) != 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    // 完了済みのフレームを解放.
+    Retire();
+
+    uint64_t pos    = ( m_Head + alignment - 1 ) & ~( alignment - 1 );
+    uint64_t offset = pos % m_Capacity;
+    if ( offset + size > m_Capacity )
+    {
+        pos   += m_Capacity - offset;
+        offset = 0;
+        m_Stats.WrapCount++;
+    }
+
+    // GPU が使用中の領域と重なる間は古いフレームから待つ.
+    while( pos + size - m_Tail > m_Capacity )
+    {
+        if ( m_Frames.empty() )
+        {
+            ELOG( "Error : Ring buffer overflow in a single frame. (size = %llu, capacity = %llu)",
+                (unsigned long long)size, (unsigned long long)m_Capacity );
+            return false;
+        }
+
+        const int64_t begin = Timer::GetTicks();
+        m_pFence->Wait( m_Frames.front().Fence );
+        m_Stats.StallCount++;
+        m_Stats.StallMsec += Timer::ToMsec( Timer::GetTicks() - begin );
+
+        Retire();
+    }
+
+    m_Stats.AllocCount++;
+    m_Stats.AllocBytes   += size;
+    m_Stats.PaddingBytes += pos - m_Head;
+
+    result.Offset  = offset;
+    result.Size    = size;
+    result.MapType = ( m_Discard ) ? RING_MAP_DISCARD : RING_MAP_NO_OVERWRITE;
+
+    m_Discard = false;
+    m_Head    = pos + size;
+
+    if ( m_Head - m_Tail > m_Stats.PeakBytes )
+    { m_Stats.PeakBytes = m_Head - m_Tail; }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの終わりを記録します. このフレームで確保した領域は, ここで置いたフェンスを
+//      GPU が通過するまで再利用されません. 描画コマンドの発行後に呼び出します.
+//-------------------------------------------------------------------------------------------------
+void RingBuffer::EndFrame()
+{
+    if ( m_pFence == nullptr )
+    { return; }
+
+    FrameMark mark;
+    mark.Fence = m_pFence->Signal();
+    mark.End   = m_Head;
+    m_Frames.push_back( mark );
+
+    m_Stats.FrameCount++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      容量を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t RingBuffer::GetCapacity() const
+{ return m_Capacity; }
+
+//-------------------------------------------------------------------------------------------------
+//      GPU が使用中の可能性がある領域を含めた使用量を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t RingBuffer::GetUsedBytes() const
+{ return m_Head - m_Tail; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+RingBuffer::Stats RingBuffer::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void RingBuffer::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      GPU が処理を終えたフレームの領域を解放します.
+//-------------------------------------------------------------------------------------------------
+void RingBuffer::Retire()
+{
+    if ( m_Frames.empty() )
+    { return; }
+
+    const uint64_t completed = m_pFence->GetCompletedValue();
+    while( !m_Frames.empty() && m_Frames.front().Fence <= completed )
+    {
+        m_Tail = m_Frames.front().End;
+        m_Frames.pop_front();
+    }
+}
@@ -0,0 +1,563 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SceneGraph.cpp
+// Desc : Retained 2D Scene Graph.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SceneGraph.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  FLAG_HAS_CONTENT    = 0x01;     // 描画内容を持ちます.
+const uint32_t  FLAG_HAS_CLIP       = 0x02;     // クリップ矩形を持ちます.
+const uint32_t  DIRTY_LOCAL         = 0x10;     // 変換行列, 不透明度, クリップが変更されました (部分木全体を再計算).
+const uint32_t  DIRTY_BOUNDS        = 0x20;     // 描画内容の範囲か子の構成が変更されました.
+const uint32_t  DIRTY_DESCENDANT    = 0x40;     // 子孫のいずれかが変更されました.
+const uint32_t  DIRTY_MASK          = DIRTY_LOCAL | DIRTY_BOUNDS | DIRTY_DESCENDANT;
+const uint32_t  INVALID_INDEX       = 0xffffffff;
+
+const float     IDENTITY[6]         = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+const SceneRect EMPTY_RECT          = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+//-------------------------------------------------------------------------------------------------
+//      3x2 行列を乗算します (a を適用した後に b を適用).
+//-------------------------------------------------------------------------------------------------
+inline void Multiply( const float a[6], const float b[6], float result[6] )
+{
+    result[0] = a[0] * b[0] + a[1] * b[2];
+    result[1] = a[0] * b[1] + a[1] * b[3];
+    result[2] = a[2] * b[0] + a[3] * b[2];
+    result[3] = a[2] * b[1] + a[3] * b[3];
+    result[4] = a[4] * b[0] + a[5] * b[2] + b[4];
+    result[5] = a[4] * b[1] + a[5] * b[3] + b[5];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      矩形を変換して, 変換後の矩形を囲む軸平行な矩形を求めます.
+//-------------------------------------------------------------------------------------------------
+inline SceneRect TransformRect( const float m[6], const SceneRect& rect )
+{
+    const float cx = ( rect.Left + rect.Right  ) * 0.5f;
+    const float cy = ( rect.Top  + rect.Bottom ) * 0.5f;
+    const float ex = ( rect.Right  - rect.Left ) * 0.5f;
+    const float ey = ( rect.Bottom - rect.Top  ) * 0.5f;
+
+    const float x  = cx * m[0] + cy * m[2] + m[4];
+    const float y  = cx * m[1] + cy * m[3] + m[5];
+    const float hx = ex * std::fabs( m[0] ) + ey * std::fabs( m[2] );
+    const float hy = ex * std::fabs( m[1] ) + ey * std::fabs( m[3] );
+
+    SceneRect result = { x - hx, y - hy, x + hx, y + hy };
+    return result;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SceneGraph class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SceneGraph::SceneGraph()
+{ ResetStats(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SceneGraph::~SceneGraph()
+{ Clear(); }
+
+//-------------------------------------------------------------------------------------------------
+//      ノードを生成して, 親の最後の子として追加します. parent が INVALID_SCENE_NODE の場合は
+//      最上位に追加します. 親の部分木の直後に挿入するので, 深さ優先の順に構築すると
+//      配列の要素はずれません.
+//-------------------------------------------------------------------------------------------------
+SceneNodeId SceneGraph::CreateNode( SceneNodeId parent )
+{
+    uint32_t parentIndex = INVALID_INDEX;
+    if ( parent != INVALID_SCENE_NODE )
+    {
+        if ( FindNode( parent ) == nullptr )
+        { return INVALID_SCENE_NODE; }
+        parentIndex = m_Slots[parent];
+    }
+
+    // ノード ID を割り当てる.
+    SceneNodeId id;
+    if ( !m_FreeIds.empty() )
+    {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+    }
+    else
+    {
+        id = SceneNodeId( m_Slots.size() );
+        m_Slots.push_back( INVALID_INDEX );
+    }
+
+    const uint32_t pos = ( parentIndex != INVALID_INDEX ) ? m_Links[parentIndex].End : uint32_t( m_Links.size() );
+
+    NodeLink link;
+    link.Id     = id;
+    link.Parent = parentIndex;
+    link.End    = pos + 1;
+    link.Flags  = 0;
+    link.Bounds = EMPTY_RECT;
+
+    NodeData data;
+    memcpy( data.Local, IDENTITY, sizeof(IDENTITY) );
+    memcpy( data.World, IDENTITY, sizeof(IDENTITY) );
+    data.Opacity       = 1.0f;
+    data.WorldOpacity  = 1.0f;
+    data.Content       = 0;
+    data.ContentBounds = EMPTY_RECT;
+    data.Clip          = EMPTY_RECT;
+
+    // 挿入位置以降のノードの配列位置をずらす.
+    m_Links.insert( m_Links.begin() + pos, link );
+    m_Data .insert( m_Data .begin() + pos, data );
+    for( uint32_t i = pos + 1; i < uint32_t( m_Links.size() ); ++i )
+    {
+        NodeLink& item = m_Links[i];
+        item.End++;
+        if ( item.Parent != INVALID_INDEX && item.Parent >= pos )
+        { item.Parent++; }
+        m_Slots[item.Id] = i;
+    }
+
+    // 祖先の部分木を広げる.
+    for( uint32_t p = parentIndex; p != INVALID_INDEX; p = m_Links[p].Parent )
+    { m_Links[p].End++; }
+
+    m_Slots[id] = pos;
+    MarkDirty( pos, DIRTY_LOCAL );
+    if ( parentIndex != INVALID_INDEX )
+    { MarkDirty( parentIndex, DIRTY_BOUNDS ); }
+
+    return id;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ノードを子孫ごと破棄します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::DestroyNode( SceneNodeId id )
+{
+    if ( FindNode( id ) == nullptr )
+    { return; }
+
+    const uint32_t begin  = m_Slots[id];
+    const uint32_t end    = m_Links[begin].End;
+    const uint32_t count  = end - begin;
+    const uint32_t parent = m_Links[begin].Parent;
+
+    for( uint32_t i = begin; i < end; ++i )
+    {
+        m_Slots  [m_Links[i].Id] = INVALID_INDEX;
+        m_FreeIds.push_back( m_Links[i].Id );
+    }
+
+    m_Links.erase( m_Links.begin() + begin, m_Links.begin() + end );
+    m_Data .erase( m_Data .begin() + begin, m_Data .begin() + end );
+    for( uint32_t i = begin; i < uint32_t( m_Links.size() ); ++i )
+    {
+        NodeLink& item = m_Links[i];
+        item.End -= count;
+        if ( item.Parent != INVALID_INDEX && item.Parent >= end )
+        { item.Parent -= count; }
+        m_Slots[item.Id] = i;
+    }
+
+    for( uint32_t p = parent; p != INVALID_INDEX; p = m_Links[p].Parent )
+    { m_Links[p].End -= count; }
+
+    if ( parent != INVALID_INDEX )
+    { MarkDirty( parent, DIRTY_BOUNDS ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全てのノードを破棄します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::Clear()
+{
+    m_Links      .clear();
+    m_Data       .clear();
+    m_Slots      .clear();
+    m_FreeIds    .clear();
+    m_BoundsQueue.clear();
+    m_DirtyIds   .clear();
+    m_DirtyQueue .clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      親空間への変換行列 (D2D1_MATRIX_3X2_F と同じ並び) を設定します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::SetTransform( SceneNodeId id, const float matrix[6] )
+{
+    NodeData* pNode = FindNode( id );
+    if ( pNode == nullptr )
+    { return; }
+
+    memcpy( pNode->Local, matrix, sizeof(pNode->Local) );
+    MarkDirty( m_Slots[id], DIRTY_LOCAL );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      不透明度を設定します. 子孫の不透明度に乗算されます.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::SetOpacity( SceneNodeId id, float opacity )
+{
+    NodeData* pNode = FindNode( id );
+    if ( pNode == nullptr )
+    { return; }
+
+    pNode->Opacity = opacity;
+    MarkDirty( m_Slots[id], DIRTY_LOCAL );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ローカル空間でのクリップ矩形を設定します. nullptr の場合はクリップしません.
+//      クリップは自身の描画内容と子孫のバウンディングボックスに適用されます.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::SetClip( SceneNodeId id, const SceneRect* pClip )
+{
+    NodeData* pNode = FindNode( id );
+    if ( pNode == nullptr )
+    { return; }
+
+    NodeLink& link = m_Links[m_Slots[id]];
+    if ( pClip != nullptr )
+    {
+        pNode->Clip  = *pClip;
+        link.Flags  |= FLAG_HAS_CLIP;
+    }
+    else
+    {
+        pNode->Clip  = EMPTY_RECT;
+        link.Flags  &= ~FLAG_HAS_CLIP;
+    }
+    MarkDirty( m_Slots[id], DIRTY_BOUNDS );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画内容の番号とローカル空間での範囲を設定します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::SetContent( SceneNodeId id, uint32_t content, const SceneRect& bounds )
+{
+    NodeData* pNode = FindNode( id );
+    if ( pNode == nullptr )
+    { return; }
+
+    pNode->Content       = content;
+    pNode->ContentBounds = bounds;
+    m_Links[m_Slots[id]].Flags |= FLAG_HAS_CONTENT;
+    MarkDirty( m_Slots[id], DIRTY_BOUNDS );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      変更されたノードの部分木だけワールド変換とバウンディングボックスを再計算します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::Update()
+{ UpdateNodes( false ); }
+
+//-------------------------------------------------------------------------------------------------
+//      変更の有無にかかわらず全てのノードを再計算します.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::UpdateAll()
+{ UpdateNodes( true ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ビューポートと重なる描画内容を持つノードを描画順に列挙します.
+//      バウンディングボックスが重ならない部分木はまとめて読み飛ばします. Update() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::Cull( const SceneRect& viewport, std::vector<SceneNodeId>& result ) const
+{
+    result.clear();
+
+    uint32_t i = 0;
+    const uint32_t count = uint32_t( m_Links.size() );
+    while( i < count )
+    {
+        const NodeLink& link = m_Links[i];
+        const NodeData& data = m_Data [i];
+        if ( !Overlaps( link.Bounds, viewport ) )
+        {
+            i = link.End;
+            continue;
+        }
+
+        if ( ( link.Flags & FLAG_HAS_CONTENT ) && data.WorldOpacity > 0.0f )
+        { result.push_back( link.Id ); }
+
+        i++;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ノード数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SceneGraph::GetNodeCount() const
+{ return uint32_t( m_Links.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      親ノードを取得します.
+//-------------------------------------------------------------------------------------------------
+SceneNodeId SceneGraph::GetParent( SceneNodeId id ) const
+{
+    if ( FindNode( id ) == nullptr )
+    { return INVALID_SCENE_NODE; }
+
+    const uint32_t parent = m_Links[m_Slots[id]].Parent;
+    return ( parent != INVALID_INDEX ) ? m_Links[parent].Id : INVALID_SCENE_NODE;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      親空間への変換行列を取得します.
+//-------------------------------------------------------------------------------------------------
+const float* SceneGraph::GetLocalTransform( SceneNodeId id ) const
+{
+    const NodeData* pNode = FindNode( id );
+    return ( pNode != nullptr ) ? pNode->Local : IDENTITY;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ワールド変換行列を取得します. Update() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+const float* SceneGraph::GetWorldTransform( SceneNodeId id ) const
+{
+    const NodeData* pNode = FindNode( id );
+    return ( pNode != nullptr ) ? pNode->World : IDENTITY;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      祖先の不透明度を掛け合わせた不透明度を取得します. Update() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+float SceneGraph::GetWorldOpacity( SceneNodeId id ) const
+{
+    const NodeData* pNode = FindNode( id );
+    return ( pNode != nullptr ) ? pNode->WorldOpacity : 0.0f;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      部分木全体のワールド空間でのバウンディングボックスを取得します. Update() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+SceneRect SceneGraph::GetWorldBounds( SceneNodeId id ) const
+{
+    return ( FindNode( id ) != nullptr ) ? m_Links[m_Slots[id]].Bounds : EMPTY_RECT;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画内容の番号を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SceneGraph::GetContent( SceneNodeId id ) const
+{
+    const NodeData* pNode = FindNode( id );
+    return ( pNode != nullptr ) ? pNode->Content : 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画内容のローカル空間での範囲を取得します.
+//-------------------------------------------------------------------------------------------------
+SceneRect SceneGraph::GetContentBounds( SceneNodeId id ) const
+{
+    const NodeData* pNode = FindNode( id );
+    return ( pNode != nullptr ) ? pNode->ContentBounds : EMPTY_RECT;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SceneGraph::Stats SceneGraph::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ノード ID からノードを検索します.
+//-------------------------------------------------------------------------------------------------
+SceneGraph::NodeData* SceneGraph::FindNode( SceneNodeId id )
+{
+    if ( id >= m_Slots.size() || m_Slots[id] == INVALID_INDEX )
+    { return nullptr; }
+
+    return &m_Data[m_Slots[id]];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ノード ID からノードを検索します.
+//-------------------------------------------------------------------------------------------------
+const SceneGraph::NodeData* SceneGraph::FindNode( SceneNodeId id ) const
+{
+    if ( id >= m_Slots.size() || m_Slots[id] == INVALID_INDEX )
+    { return nullptr; }
+
+    return &m_Data[m_Slots[id]];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      変更フラグを設定し, 祖先に子孫が変更されたことを伝えます.
+//      既に印の付いた祖先より上は印が付いているので, そこで打ち切ります.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::MarkDirty( uint32_t index, uint32_t flag )
+{
+    if ( ( m_Links[index].Flags & ( DIRTY_LOCAL | DIRTY_BOUNDS ) ) == 0 )
+    { m_DirtyIds.push_back( m_Links[index].Id ); }
+
+    m_Links[index].Flags |= flag;
+
+    for( uint32_t p = m_Links[index].Parent; p != INVALID_INDEX; p = m_Links[p].Parent )
+    {
+        if ( m_Links[p].Flags & DIRTY_DESCENDANT )
+        { break; }
+
+        m_Links[p].Flags |= DIRTY_DESCENDANT;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ワールド変換とバウンディングボックスを更新します. 差分更新では変更されたノードを
+//      配列位置の順に処理し, 変換が変わったノードは部分木全体を再計算します. 子は親より
+//      後ろに並んでいるので, 親から子への伝搬は前から順に, 範囲の集約は後ろから順に行います.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::UpdateNodes( bool force )
+{
+    Timer timer;
+
+    const uint32_t count = uint32_t( m_Links.size() );
+
+    m_BoundsQueue.clear();
+    m_DirtyQueue .clear();
+
+    if ( force )
+    {
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            ComputeWorld( i );
+            m_Links[i].Flags &= ~DIRTY_MASK;
+            m_BoundsQueue.push_back( i );
+        }
+        m_Stats.VisitCount += count;
+    }
+    else
+    {
+        // 変更されたノードを配列位置の順に並べる. 破棄されたノードは除く.
+        for( size_t k = 0; k < m_DirtyIds.size(); ++k )
+        {
+            const SceneNodeId id = m_DirtyIds[k];
+            if ( id < m_Slots.size() && m_Slots[id] != INVALID_INDEX )
+            { m_DirtyQueue.push_back( m_Slots[id] ); }
+        }
+        std::sort( m_DirtyQueue.begin(), m_DirtyQueue.end() );
+        m_DirtyQueue.erase( std::unique( m_DirtyQueue.begin(), m_DirtyQueue.end() ), m_DirtyQueue.end() );
+
+        uint32_t forceEnd = 0;     // この位置までは再計算済み.
+        for( size_t k = 0; k < m_DirtyQueue.size(); ++k )
+        {
+            const uint32_t index = m_DirtyQueue[k];
+            if ( index < forceEnd )
+            { continue; }
+
+            NodeLink& link = m_Links[index];
+            if ( link.Flags & DIRTY_LOCAL )
+            {
+                for( uint32_t i = index; i < link.End; ++i )
+                {
+                    ComputeWorld( i );
+                    m_Links[i].Flags &= ~DIRTY_MASK;
+                    m_BoundsQueue.push_back( i );
+                }
+                m_Stats.VisitCount += link.End - index;
+                forceEnd = link.End;
+            }
+            else if ( link.Flags & DIRTY_BOUNDS )
+            {
+                link.Flags &= ~DIRTY_BOUNDS;
+                m_BoundsQueue.push_back( index );
+                m_Stats.VisitCount++;
+            }
+
+            // 祖先の範囲も更新する. 既に辿った祖先より上は辿らない.
+            for( uint32_t p = link.Parent; p != INVALID_INDEX; p = m_Links[p].Parent )
+            {
+                if ( ( m_Links[p].Flags & DIRTY_DESCENDANT ) == 0 )
+                { break; }
+
+                m_Links[p].Flags &= ~DIRTY_DESCENDANT;
+                m_BoundsQueue.push_back( p );
+                m_Stats.VisitCount++;
+            }
+        }
+
+        std::sort( m_BoundsQueue.begin(), m_BoundsQueue.end() );
+        m_BoundsQueue.erase( std::unique( m_BoundsQueue.begin(), m_BoundsQueue.end() ), m_BoundsQueue.end() );
+    }
+    m_DirtyIds.clear();
+
+    // 子は親より後ろに並んでいるので, 逆順に処理すれば子が先に確定する.
+    for( size_t k = m_BoundsQueue.size(); k > 0; --k )
+    { ComputeBounds( m_BoundsQueue[k - 1] ); }
+
+    m_Stats.UpdateCount++;
+    m_Stats.UpdateMsec += timer.GetElapsedMsec();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      親のワールド変換と不透明度からノードのワールド変換と不透明度を求めます.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::ComputeWorld( uint32_t index )
+{
+    NodeData&      node        = m_Data[index];
+    const uint32_t parentIndex = m_Links[index].Parent;
+    if ( parentIndex != INVALID_INDEX )
+    {
+        const NodeData& parent = m_Data[parentIndex];
+        Multiply( node.Local, parent.World, node.World );
+        node.WorldOpacity = node.Opacity * parent.WorldOpacity;
+    }
+    else
+    {
+        memcpy( node.World, node.Local, sizeof(node.World) );
+        node.WorldOpacity = node.Opacity;
+    }
+
+    m_Stats.TransformCount++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      自身の描画内容と直接の子のバウンディングボックスを合わせて, 部分木の範囲を求めます.
+//-------------------------------------------------------------------------------------------------
+void SceneGraph::ComputeBounds( uint32_t index )
+{
+    NodeLink&       link = m_Links[index];
+    const NodeData& node = m_Data [index];
+
+    SceneRect bounds = EMPTY_RECT;
+    if ( link.Flags & FLAG_HAS_CONTENT )
+    { bounds = TransformRect( node.World, node.ContentBounds ); }
+
+    for( uint32_t child = index + 1; child < link.End; child = m_Links[child].End )
+    { bounds = Union( bounds, m_Links[child].Bounds ); }
+
+    if ( link.Flags & FLAG_HAS_CLIP )
+    { bounds = Intersect( bounds, TransformRect( node.World, node.Clip ) ); }
+
+    link.Bounds = ( bounds.IsEmpty() ) ? EMPTY_RECT : bounds;
+    m_Stats.BoundsCount++;
+}
@@ -0,0 +1,331 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SoftwareSwapChain.cpp
+// Desc : CPU Swap Chain with Present Thread.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SoftwareSwapChain.h>
+#include <Logger.h>
+#include <Timer.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  NO_BUFFER = UINT32_MAX;     //!< 表示中のバッファが無いことを表す値です.
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SoftwareSwapChain class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SoftwareSwapChain::SoftwareSwapChain()
+: m_Mode            ( PRESENT_MODE_FIFO )
+, m_IntervalTicks   ( 0 )
+, m_Front           ( NO_BUFFER )
+, m_NextFrameId     ( 0 )
+, m_Stop            ( false )
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SoftwareSwapChain::~SoftwareSwapChain()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理を行います.
+//-------------------------------------------------------------------------------------------------
+bool SoftwareSwapChain::Init
+(
+    uint32_t        width,
+    uint32_t        height,
+    uint32_t        bufferCount,
+    PRESENT_MODE    mode,
+    double          refreshRate,
+    std::function<void( const Surface&, uint64_t )> scanout
+)
+{
+    if ( width == 0 || height == 0
+      || bufferCount < MinBufferCount || bufferCount > MaxBufferCount
+      || mode >= PRESENT_MODE_COUNT || refreshRate <= 0.0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    m_Surfaces.resize( bufferCount );
+    m_Buffers .resize( bufferCount );
+    for( uint32_t i = 0; i < bufferCount; ++i )
+    {
+        m_Surfaces[i].reset( new Surface() );
+        if ( !m_Surfaces[i]->Init( width, height ) )
+        {
+            ELOG( "Error : Surface::Init() Failed." );
+            m_Surfaces.clear();
+            m_Buffers .clear();
+            return false;
+        }
+
+        m_Buffers[i].State       = BUFFER_STATE_FREE;
+        m_Buffers[i].FrameId     = 0;
+        m_Buffers[i].SubmitTicks = 0;
+    }
+
+    m_Queue.clear();
+    m_Scanout       = scanout;
+    m_Mode          = mode;
+    m_IntervalTicks = int64_t( double( Timer::GetTicksPerSec() ) / refreshRate );
+    m_Front         = NO_BUFFER;
+    m_NextFrameId   = 0;
+    m_Stop          = false;
+    if ( m_IntervalTicks < 1 )
+    { m_IntervalTicks = 1; }
+
+    ResetStats();
+
+    m_Thread = std::thread( &SoftwareSwapChain::PresentThread, this );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理を行います. 表示待ちのフレームは破棄します.
+//-------------------------------------------------------------------------------------------------
+void SoftwareSwapChain::Term()
+{
+    if ( m_Thread.joinable() )
+    {
+        {
+            std::lock_guard<std::mutex> locker( m_Mutex );
+            m_Stop = true;
+        }
+        m_WakeCond.notify_all();
+        m_FreeCond.notify_all();
+        m_IdleCond.notify_all();
+        m_Thread.join();
+    }
+
+    m_Surfaces.clear();
+    m_Buffers .clear();
+    m_Queue   .clear();
+    m_Scanout = nullptr;
+    m_Front   = NO_BUFFER;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画先のバッファを取得します. 空きが無ければ表示が進むまで待機します.
+//-------------------------------------------------------------------------------------------------
+Surface* SoftwareSwapChain::Acquire( uint32_t& index )
+{
+    std::unique_lock<std::mutex> locker( m_Mutex );
+
+    int64_t begin   = 0;
+    bool    blocked = false;
+    for( ;; )
+    {
+        if ( m_Stop || m_Buffers.empty() )
+        { return nullptr; }
+
+        for( uint32_t i = 0; i < uint32_t( m_Buffers.size() ); ++i )
+        {
+            if ( m_Buffers[i].State != BUFFER_STATE_FREE )
+            { continue; }
+
+            m_Buffers[i].State = BUFFER_STATE_RENDERING;
+            if ( blocked )
+            {
+                m_Stats.BlockedCount++;
+                m_Stats.BlockedTicks += Timer::GetTicks() - begin;
+            }
+
+            index = i;
+            return m_Surfaces[i].get();
+        }
+
+        if ( !blocked )
+        {
+            begin   = Timer::GetTicks();
+            blocked = true;
+        }
+        m_FreeCond.wait( locker );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画を終えたバッファを表示待ちに積みます.
+//-------------------------------------------------------------------------------------------------
+bool SoftwareSwapChain::Present( uint32_t index )
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+
+    if ( index >= m_Buffers.size() || m_Buffers[index].State != BUFFER_STATE_RENDERING )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    // MAILBOX は表示待ちを 1 つに保つので, まだ表示されていないフレームを置き換える.
+    if ( m_Mode == PRESENT_MODE_MAILBOX && !m_Queue.empty() )
+    {
+        for( size_t i = 0; i < m_Queue.size(); ++i )
+        { m_Buffers[m_Queue[i]].State = BUFFER_STATE_FREE; }
+
+        m_Stats.DropCount += m_Queue.size();
+        m_Queue.clear();
+        m_FreeCond.notify_all();
+    }
+
+    BufferInfo& info = m_Buffers[index];
+    info.State       = BUFFER_STATE_QUEUED;
+    info.FrameId     = m_NextFrameId++;
+    info.SubmitTicks = Timer::GetTicks();
+    m_Queue.push_back( index );
+
+    const uint32_t inFlight = uint32_t( m_Queue.size() );
+    m_Stats.PresentCount++;
+    m_Stats.InFlightSum += inFlight;
+    if ( inFlight > m_Stats.MaxInFlight )
+    { m_Stats.MaxInFlight = inFlight; }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      表示待ちのフレームが無くなるまで待機します.
+//-------------------------------------------------------------------------------------------------
+void SoftwareSwapChain::WaitIdle()
+{
+    std::unique_lock<std::mutex> locker( m_Mutex );
+    while( !m_Stop && !m_Queue.empty() )
+    { m_IdleCond.wait( locker ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      バッファ数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SoftwareSwapChain::GetBufferCount() const
+{ return uint32_t( m_Buffers.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      提出モードを取得します.
+//-------------------------------------------------------------------------------------------------
+PRESENT_MODE SoftwareSwapChain::GetMode() const
+{ return m_Mode; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SoftwareSwapChain::Stats SoftwareSwapChain::GetStats() const
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    return m_Stats;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SoftwareSwapChain::ResetStats()
+{
+    std::lock_guard<std::mutex> locker( m_Mutex );
+    memset( &m_Stats, 0, sizeof(m_Stats) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      垂直同期の間隔でフレームを表示するスレッドです.
+//-------------------------------------------------------------------------------------------------
+void SoftwareSwapChain::PresentThread()
+{
+    std::unique_lock<std::mutex> locker( m_Mutex );
+
+    const int64_t ticksPerSec = Timer::GetTicksPerSec();
+    int64_t next = Timer::GetTicks() + m_IntervalTicks;
+
+    while( !m_Stop )
+    {
+        // 次の垂直同期まで待機.
+        int64_t now = Timer::GetTicks();
+        if ( now < next )
+        {
+            const int64_t usec = ( next - now ) * 1000000 / ticksPerSec;
+            m_WakeCond.wait_for( locker, std::chrono::microseconds( ( usec > 0 ) ? usec : 1 ) );
+            continue;
+        }
+
+        Flip( now );
+
+        // 表示中のバッファは描画側が触らないので, ロックを外して走査する.
+        if ( m_Scanout && m_Front != NO_BUFFER )
+        {
+            const uint32_t front   = m_Front;
+            const uint64_t frameId = m_Buffers[front].FrameId;
+            locker.unlock();
+            m_Scanout( *m_Surfaces[front], frameId );
+            locker.lock();
+        }
+
+        // 間に合わなかった垂直同期は飛ばして, 位相を保ったまま次へ進める.
+        now = Timer::GetTicks();
+        next += m_IntervalTicks;
+        if ( next <= now )
+        { next += ( ( now - next ) / m_IntervalTicks + 1 ) * m_IntervalTicks; }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      垂直同期 1 回分の表示の切り替えを行います. ロックを保持した状態で呼び出します.
+//-------------------------------------------------------------------------------------------------
+void SoftwareSwapChain::Flip( int64_t now )
+{
+    if ( m_Queue.empty() )
+    {
+        if ( m_Front != NO_BUFFER )
+        { m_Stats.RepeatCount++; }
+        return;
+    }
+
+    // FIFO と MAILBOX は先頭を, LATEST は最新を表示し, それより古いものを破棄する.
+    uint32_t next = m_Queue.front();
+    m_Queue.pop_front();
+    if ( m_Mode == PRESENT_MODE_LATEST )
+    {
+        while( !m_Queue.empty() )
+        {
+            m_Buffers[next].State = BUFFER_STATE_FREE;
+            m_Stats.DropCount++;
+            next = m_Queue.front();
+            m_Queue.pop_front();
+        }
+    }
+
+    if ( m_Front != NO_BUFFER )
+    { m_Buffers[m_Front].State = BUFFER_STATE_FREE; }
+
+    m_Front = next;
+    m_Buffers[next].State = BUFFER_STATE_FRONT;
+
+    const int64_t latency = now - m_Buffers[next].SubmitTicks;
+    m_Stats.DisplayCount++;
+    m_Stats.LatencyTicks += latency;
+    if ( latency > m_Stats.MaxLatencyTicks )
+    { m_Stats.MaxLatencyTicks = latency; }
+
+    m_FreeCond.notify_all();
+    if ( m_Queue.empty() )
+    { m_IdleCond.notify_all(); }
+}
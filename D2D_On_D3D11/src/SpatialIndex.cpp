@@ -0,0 +1,474 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpatialIndex.cpp
+// Desc : Loose Quadtree Spatial Index.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SpatialIndex.h>
+#include <Logger.h>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  INVALID_INDEX   = 0xffffffff;
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpatialIndex class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpatialIndex::SpatialIndex()
+: m_WorldSize   ( 0.0f )
+, m_Depth       ( 0 )
+, m_FreeItem    ( INVALID_INDEX )
+, m_Count       ( 0 )
+{
+    memset( &m_World, 0, sizeof(m_World) );
+    memset( m_LevelOffset, 0, sizeof(m_LevelOffset) );
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpatialIndex::~SpatialIndex()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. world を一辺の長い方に合わせた正方形として depth 段まで 4 分割します.
+//      world の外側の要素も登録できますが, 離れるほど浅いセルに入り判定が増えるので,
+//      world は想定する範囲を覆うように指定してください.
+//-------------------------------------------------------------------------------------------------
+bool SpatialIndex::Init( const SceneRect& world, uint32_t depth )
+{
+    Term();
+
+    if ( world.IsEmpty() || depth > MaxDepth )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const float width  = world.Right  - world.Left;
+    const float height = world.Bottom - world.Top;
+
+    m_World     = world;
+    m_WorldSize = ( width > height ) ? width : height;
+    m_Depth     = depth;
+
+    // 深さごとのセルは行優先で並べ, 浅い順に連結する.
+    uint32_t offset = 0;
+    for( uint32_t level = 0; level <= depth + 1; ++level )
+    {
+        m_LevelOffset[level] = offset;
+        offset += ( 1u << level ) * ( 1u << level );
+    }
+
+    m_Cells.resize( m_LevelOffset[depth + 1] );
+    for( size_t i = 0; i < m_Cells.size(); ++i )
+    { m_Cells[i].SubtreeCount = 0; }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Term()
+{
+    std::vector<Cell> ().swap( m_Cells );
+    std::vector<Item> ().swap( m_Items );
+    std::vector<Visit>().swap( m_Stack );
+
+    m_FreeItem = INVALID_INDEX;
+    m_Count    = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全ての要素を削除します. セルと要素の領域は再利用します.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Clear()
+{
+    for( size_t i = 0; i < m_Cells.size(); ++i )
+    {
+        m_Cells[i].Entries.clear();
+        m_Cells[i].SubtreeCount = 0;
+    }
+
+    m_Items.clear();
+    m_FreeItem = INVALID_INDEX;
+    m_Count    = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      要素を登録します. 問い合わせでは userData が返されます.
+//-------------------------------------------------------------------------------------------------
+SpatialHandle SpatialIndex::Insert( const SceneRect& bounds, uint32_t userData )
+{
+    if ( m_Cells.empty() )
+    { return INVALID_SPATIAL_HANDLE; }
+
+    uint32_t index = m_FreeItem;
+    if ( index != INVALID_INDEX )
+    { m_FreeItem = m_Items[index].Slot; }
+    else
+    {
+        index = uint32_t( m_Items.size() );
+        m_Items.push_back( Item() );
+    }
+
+    Entry entry;
+    entry.Bounds   = bounds;
+    entry.UserData = userData;
+    entry.Handle   = index;
+
+    Link( index, FindCell( bounds ), entry );
+
+    m_Count++;
+    m_Stats.InsertCount++;
+    return index;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      要素の範囲を更新します. 所属するセルが変わらない場合は範囲を書き換えるだけです.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Update( SpatialHandle handle, const SceneRect& bounds )
+{
+    if ( handle >= m_Items.size() || m_Items[handle].Cell == INVALID_INDEX )
+    { return; }
+
+    const Item& item = m_Items[handle];
+    Entry& entry = m_Cells[item.Cell].Entries[item.Slot];
+    entry.Bounds = bounds;
+    m_Stats.UpdateCount++;
+
+    const uint32_t cell = FindCell( bounds );
+    if ( cell == item.Cell )
+    { return; }
+
+    const Entry moved = entry;
+    Unlink( handle );
+    Link  ( handle, cell, moved );
+    m_Stats.RelinkCount++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      要素を削除します. ハンドルは後の Insert() で再利用されます.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Remove( SpatialHandle handle )
+{
+    if ( handle >= m_Items.size() || m_Items[handle].Cell == INVALID_INDEX )
+    { return; }
+
+    Unlink( handle );
+
+    Item& item = m_Items[handle];
+    item.Cell = INVALID_INDEX;
+    item.Slot = m_FreeItem;
+    m_FreeItem = handle;
+
+    m_Count--;
+    m_Stats.RemoveCount++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      矩形と重なる要素の userData を列挙します. 順序は不定です.
+//      ルーズ境界が矩形に完全に含まれるセルは, 部分木の要素を判定せずにそのまま返します.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::QueryRect( const SceneRect& rect, std::vector<uint32_t>& result ) const
+{
+    result.clear();
+    m_Stats.QueryCount++;
+
+    if ( m_Cells.empty() || rect.IsEmpty() )
+    { return; }
+
+    m_Stack.clear();
+    Visit root = { 0, 0, 0, false };
+    m_Stack.push_back( root );
+
+    while( !m_Stack.empty() )
+    {
+        const Visit visit = m_Stack.back();
+        m_Stack.pop_back();
+
+        const uint32_t stride = 1u << visit.Level;
+        const Cell& cell = m_Cells[m_LevelOffset[visit.Level] + visit.Y * stride + visit.X];
+        if ( cell.SubtreeCount == 0 )
+        { continue; }
+
+        bool inside = visit.Inside;
+        if ( !inside )
+        {
+            const SceneRect loose = GetLooseRect( visit.Level, visit.X, visit.Y );
+            if ( !Overlaps( loose, rect ) )
+            { continue; }
+
+            inside = Contains( rect, loose );
+        }
+
+        m_Stats.CellVisitCount++;
+
+        const uint32_t count = uint32_t( cell.Entries.size() );
+        if ( inside )
+        {
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                if ( !cell.Entries[i].Bounds.IsEmpty() )
+                { result.push_back( cell.Entries[i].UserData ); }
+            }
+        }
+        else
+        {
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                if ( Overlaps( cell.Entries[i].Bounds, rect ) )
+                { result.push_back( cell.Entries[i].UserData ); }
+            }
+            m_Stats.ItemTestCount += count;
+        }
+
+        if ( visit.Level < m_Depth && cell.SubtreeCount > count )
+        {
+            for( uint32_t i = 0; i < 4; ++i )
+            {
+                Visit child = {
+                    visit.Level + 1,
+                    visit.X * 2 + ( i & 1 ),
+                    visit.Y * 2 + ( i >> 1 ),
+                    inside };
+                m_Stack.push_back( child );
+            }
+        }
+    }
+
+    m_Stats.ResultCount += result.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      点を含む要素の userData を列挙します. 順序は不定です.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::QueryPoint( float x, float y, std::vector<uint32_t>& result ) const
+{
+    result.clear();
+    m_Stats.QueryCount++;
+
+    if ( m_Cells.empty() )
+    { return; }
+
+    m_Stack.clear();
+    Visit root = { 0, 0, 0, false };
+    m_Stack.push_back( root );
+
+    while( !m_Stack.empty() )
+    {
+        const Visit visit = m_Stack.back();
+        m_Stack.pop_back();
+
+        const uint32_t stride = 1u << visit.Level;
+        const Cell& cell = m_Cells[m_LevelOffset[visit.Level] + visit.Y * stride + visit.X];
+        if ( cell.SubtreeCount == 0 )
+        { continue; }
+
+        if ( !Contains( GetLooseRect( visit.Level, visit.X, visit.Y ), x, y ) )
+        { continue; }
+
+        m_Stats.CellVisitCount++;
+
+        const uint32_t count = uint32_t( cell.Entries.size() );
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            if ( Contains( cell.Entries[i].Bounds, x, y ) )
+            { result.push_back( cell.Entries[i].UserData ); }
+        }
+        m_Stats.ItemTestCount += count;
+
+        if ( visit.Level < m_Depth && cell.SubtreeCount > count )
+        {
+            for( uint32_t i = 0; i < 4; ++i )
+            {
+                Visit child = {
+                    visit.Level + 1,
+                    visit.X * 2 + ( i & 1 ),
+                    visit.Y * 2 + ( i >> 1 ),
+                    false };
+                m_Stack.push_back( child );
+            }
+        }
+    }
+
+    m_Stats.ResultCount += result.size();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      登録されている要素数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SpatialIndex::GetCount() const
+{ return m_Count; }
+
+//-------------------------------------------------------------------------------------------------
+//      要素の範囲を取得します.
+//-------------------------------------------------------------------------------------------------
+SceneRect SpatialIndex::GetBounds( SpatialHandle handle ) const
+{
+    if ( handle >= m_Items.size() || m_Items[handle].Cell == INVALID_INDEX )
+    {
+        SceneRect empty = { 0.0f, 0.0f, 0.0f, 0.0f };
+        return empty;
+    }
+
+    const Item& item = m_Items[handle];
+    return m_Cells[item.Cell].Entries[item.Slot].Bounds;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SpatialIndex::Stats SpatialIndex::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      要素を登録するセルを求めます. 要素の長辺がセルの一辺以下になる最も深い段の,
+//      中心を含むセルを選びます. ルーズ境界はセルを各辺に半分ずつ広げた範囲なので, 要素は必ず収まります.
+//-------------------------------------------------------------------------------------------------
+uint32_t SpatialIndex::FindCell( const SceneRect& bounds ) const
+{
+    const float cx = ( bounds.Left + bounds.Right  ) * 0.5f;
+    const float cy = ( bounds.Top  + bounds.Bottom ) * 0.5f;
+
+    // NaN を含む範囲は最上位のセルに登録する.
+    if ( cx != cx || cy != cy )
+    { return 0; }
+
+    const float width  = bounds.Right  - bounds.Left;
+    const float height = bounds.Bottom - bounds.Top;
+    float extent = ( width > height ) ? width : height;
+
+    // 中心が world の外側にある場合は端のセルに寄せ, はみ出した分だけ大きな要素として扱う.
+    const float right  = m_World.Left + m_WorldSize;
+    const float bottom = m_World.Top  + m_WorldSize;
+    const float dx = ( cx < m_World.Left ) ? m_World.Left - cx : ( cx > right  ) ? cx - right  : 0.0f;
+    const float dy = ( cy < m_World.Top  ) ? m_World.Top  - cy : ( cy > bottom ) ? cy - bottom : 0.0f;
+    extent += 2.0f * ( ( dx > dy ) ? dx : dy );
+
+    uint32_t level = 0;
+    float    size  = m_WorldSize;
+    while( level < m_Depth && size * 0.5f >= extent )
+    {
+        size *= 0.5f;
+        level++;
+    }
+
+    const uint32_t stride = 1u << level;
+    const float fx = ( cx - m_World.Left ) / size;
+    const float fy = ( cy - m_World.Top  ) / size;
+    uint32_t x = ( fx > 0.0f ) ? ( ( fx < float( stride ) ) ? uint32_t( fx ) : stride - 1 ) : 0;
+    uint32_t y = ( fy > 0.0f ) ? ( ( fy < float( stride ) ) ? uint32_t( fy ) : stride - 1 ) : 0;
+    if ( x >= stride ) { x = stride - 1; }
+    if ( y >= stride ) { y = stride - 1; }
+
+    return m_LevelOffset[level] + y * stride + x;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      要素をセルの末尾に追加します.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Link( uint32_t item, uint32_t cell, const Entry& entry )
+{
+    Cell& owner = m_Cells[cell];
+
+    m_Items[item].Cell = cell;
+    m_Items[item].Slot = uint32_t( owner.Entries.size() );
+    owner.Entries.push_back( entry );
+
+    AddCount( cell, 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      要素をセルから外します. 空いた位置にはセルの末尾の要素を移します.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::Unlink( uint32_t item )
+{
+    const Item& target = m_Items[item];
+    Cell& owner = m_Cells[target.Cell];
+
+    const uint32_t last = uint32_t( owner.Entries.size() ) - 1;
+    if ( target.Slot != last )
+    {
+        owner.Entries[target.Slot] = owner.Entries[last];
+        m_Items[owner.Entries[target.Slot].Handle].Slot = target.Slot;
+    }
+    owner.Entries.pop_back();
+
+    AddCount( target.Cell, -1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      セルとその祖先の部分木の要素数を増減します.
+//-------------------------------------------------------------------------------------------------
+void SpatialIndex::AddCount( uint32_t cell, int delta )
+{
+    uint32_t level = m_Depth;
+    while( cell < m_LevelOffset[level] )
+    { level--; }
+
+    uint32_t local = cell - m_LevelOffset[level];
+    uint32_t x = local & ( ( 1u << level ) - 1 );
+    uint32_t y = local >> level;
+
+    for( ;; )
+    {
+        Cell& target = m_Cells[m_LevelOffset[level] + ( y << level ) + x];
+        target.SubtreeCount = uint32_t( int( target.SubtreeCount ) + delta );
+
+        if ( level == 0 )
+        { break; }
+
+        level--;
+        x >>= 1;
+        y >>= 1;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      セルのルーズ境界を求めます. 最上位のセルは world から大きくはみ出す要素も持つので無限大とします.
+//-------------------------------------------------------------------------------------------------
+SceneRect SpatialIndex::GetLooseRect( uint32_t level, uint32_t x, uint32_t y ) const
+{
+    if ( level == 0 )
+    {
+        SceneRect infinite = { -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX };
+        return infinite;
+    }
+
+    const float size = m_WorldSize / float( 1u << level );
+    const float left = m_World.Left + size * float( x );
+    const float top  = m_World.Top  + size * float( y );
+
+    SceneRect result = {
+        left - size * 0.5f,
+        top  - size * 0.5f,
+        left + size * 1.5f,
+        top  + size * 1.5f };
+    return result;
+}
@@ -0,0 +1,245 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpriteBatch.cpp
+// Desc : Sorted Sprite Instance Stream.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SpriteBatch.h>
+#include <Timer.h>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint32_t  RADIX_BITS      = 8;
+const uint32_t  RADIX_SIZE      = 1 << RADIX_BITS;
+const uint32_t  RADIX_PASSES    = 32 / RADIX_BITS;      // ソートキー (上位 32bit) の桁数.
+const uint32_t  KEY_SHIFT       = 32;
+const uint64_t  INDEX_MASK      = 0xffffffffULL;
+
+//-------------------------------------------------------------------------------------------------
+//      ソートキーを生成します. レイヤー, ブレンドステート, テクスチャの順に比較されます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MakeKey( uint8_t layer, SPRITE_BLEND blend, uint32_t texture )
+{ return ( uint32_t( layer ) << 24 ) | ( ( uint32_t( blend ) & 0xff ) << 16 ) | ( texture & 0xffff ); }
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteBatch class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpriteBatch::SpriteBatch()
+: m_Count   ( 0 )
+, m_ScaleX  ( 0.0f )
+, m_ScaleY  ( 0.0f )
+{ ResetStats(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpriteBatch::~SpriteBatch()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの収集を開始します. 前のフレームのインスタンスは破棄しますが, 領域は再利用します.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::Begin( float viewportWidth, float viewportHeight )
+{
+    m_Instances.clear();
+    m_Keys     .clear();
+    m_Runs     .clear();
+    m_Count = 0;
+
+    m_ScaleX = ( viewportWidth  > 0.0f ) ?  2.0f / viewportWidth  : 0.0f;
+    m_ScaleY = ( viewportHeight > 0.0f ) ? -2.0f / viewportHeight : 0.0f;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スプライトをインスタンス列に追加します. 頂点シェーダで座標変換しないように,
+//      ここで回転と正規化デバイス座標への変換を済ませます.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::Draw( const Sprite& sprite, uint32_t texture, SPRITE_BLEND blend )
+{
+    float c = 1.0f;
+    float s = 0.0f;
+    if ( sprite.Rotation != 0.0f )
+    {
+        c = std::cos( sprite.Rotation );
+        s = std::sin( sprite.Rotation );
+    }
+
+    const float hw = sprite.Width  * 0.5f;
+    const float hh = sprite.Height * 0.5f;
+
+    SpriteInstance instance;
+    instance.Center[0]   = sprite.X * m_ScaleX - 1.0f;
+    instance.Center[1]   = sprite.Y * m_ScaleY + 1.0f;
+    instance.AxisX[0]    =  c * hw * m_ScaleX;
+    instance.AxisX[1]    =  s * hw * m_ScaleY;
+    instance.AxisY[0]    = -s * hh * m_ScaleX;
+    instance.AxisY[1]    =  c * hh * m_ScaleY;
+    instance.TexCoord[0] = sprite.TexCoord[0];
+    instance.TexCoord[1] = sprite.TexCoord[1];
+    instance.TexCoord[2] = sprite.TexCoord[2];
+    instance.TexCoord[3] = sprite.TexCoord[3];
+    instance.Color       = sprite.Color;
+
+    const uint64_t key = MakeKey( sprite.Layer, blend, texture );
+    m_Instances.push_back( instance );
+    m_Keys     .push_back( ( key << KEY_SHIFT ) | uint64_t( m_Count ) );
+    m_Count++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの収集を終了します. インスタンスをソートして, 同じステートが続く範囲をランにまとめます.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::End()
+{
+    Timer timer;
+
+    SortKeys ();
+    BuildRuns();
+
+    m_Stats.FrameCount++;
+    m_Stats.SpriteCount += m_Count;
+    m_Stats.RunCount    += m_Runs.size();
+    m_Stats.SortMsec    += timer.GetElapsedMsec();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在のフレームのスプライト数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SpriteBatch::GetSpriteCount() const
+{ return m_Count; }
+
+//-------------------------------------------------------------------------------------------------
+//      ソート済みのインスタンス列を取得します. End() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+const SpriteInstance* SpriteBatch::GetInstances() const
+{ return ( m_Sorted.empty() ) ? nullptr : &m_Sorted[0]; }
+
+//-------------------------------------------------------------------------------------------------
+//      ランを取得します. End() の後で有効です.
+//-------------------------------------------------------------------------------------------------
+const SpriteRun* SpriteBatch::GetRuns() const
+{ return ( m_Runs.empty() ) ? nullptr : &m_Runs[0]; }
+
+//-------------------------------------------------------------------------------------------------
+//      ラン数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t SpriteBatch::GetRunCount() const
+{ return uint32_t( m_Runs.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SpriteBatch::Stats SpriteBatch::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ソートキーを LSD 基数ソートで並べ替えます. 全ての要素で同じ値になる桁はパスを省略します.
+//      安定ソートなので, 同じキーのスプライトは登録順を保ちます.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::SortKeys()
+{
+    if ( m_Count <= 1 )
+    {
+        m_Sorted = m_Instances;
+        return;
+    }
+
+    // 全桁のヒストグラムを1回の走査でまとめて求める.
+    uint32_t histogram[RADIX_PASSES][RADIX_SIZE];
+    memset( histogram, 0, sizeof(histogram) );
+
+    for( uint32_t i = 0; i < m_Count; ++i )
+    {
+        const uint32_t key = uint32_t( m_Keys[i] >> KEY_SHIFT );
+        for( uint32_t pass = 0; pass < RADIX_PASSES; ++pass )
+        { histogram[pass][( key >> ( pass * RADIX_BITS ) ) & ( RADIX_SIZE - 1 )]++; }
+    }
+
+    m_Temp.resize( m_Count );
+    uint64_t* pSrc = &m_Keys[0];
+    uint64_t* pDst = &m_Temp[0];
+
+    for( uint32_t pass = 0; pass < RADIX_PASSES; ++pass )
+    {
+        const uint32_t shift = KEY_SHIFT + pass * RADIX_BITS;
+        const uint32_t digit = uint32_t( pSrc[0] >> shift ) & ( RADIX_SIZE - 1 );
+        if ( histogram[pass][digit] == m_Count )
+        { continue; }
+
+        uint32_t offset[RADIX_SIZE];
+        uint32_t sum = 0;
+        for( uint32_t i = 0; i < RADIX_SIZE; ++i )
+        {
+            offset[i] = sum;
+            sum += histogram[pass][i];
+        }
+
+        for( uint32_t i = 0; i < m_Count; ++i )
+        {
+            const uint32_t bucket = uint32_t( pSrc[i] >> shift ) & ( RADIX_SIZE - 1 );
+            pDst[offset[bucket]++] = pSrc[i];
+        }
+
+        uint64_t* pSwap = pSrc;
+        pSrc = pDst;
+        pDst = pSwap;
+        m_Stats.SortPassCount++;
+    }
+
+    if ( pSrc != &m_Keys[0] )
+    { m_Keys.swap( m_Temp ); }
+
+    // 登録番号に従ってインスタンスを並べ替える.
+    m_Sorted.resize( m_Count );
+    for( uint32_t i = 0; i < m_Count; ++i )
+    { m_Sorted[i] = m_Instances[size_t( m_Keys[i] & INDEX_MASK )]; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ソート済みのキー列から, 同じキーが続く範囲をランとして登録します.
+//-------------------------------------------------------------------------------------------------
+void SpriteBatch::BuildRuns()
+{
+    m_Runs.clear();
+
+    uint32_t start = 0;
+    while( start < m_Count )
+    {
+        const uint32_t key = uint32_t( m_Keys[start] >> KEY_SHIFT );
+
+        uint32_t end = start + 1;
+        while( end < m_Count && uint32_t( m_Keys[end] >> KEY_SHIFT ) == key )
+        { end++; }
+
+        SpriteRun run;
+        run.Texture = key & 0xffff;
+        run.Blend   = SPRITE_BLEND( ( key >> 16 ) & 0xff );
+        run.Start   = start;
+        run.Count   = end - start;
+        m_Runs.push_back( run );
+
+        start = end;
+    }
+}
@@ -0,0 +1,421 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SpriteRenderer.cpp
+// Desc : Instanced Sprite Renderer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SpriteRenderer.h>
+#include <Logger.h>
+#include <SafeRelease.h>
+#include <Timer.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const UINT  QUAD_VERTEX_COUNT   = 4;        // 三角形ストリップの頂点数 (頂点シェーダで SV_VertexID から生成).
+const UINT  INVALID_TEXTURE     = ~0u;
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SpriteRenderer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpriteRenderer::SpriteRenderer()
+: m_pDevice         ( nullptr )
+, m_pTracker        ( nullptr )
+, m_pInstanceBuffer ( nullptr )
+, m_pInputLayout    ( nullptr )
+, m_pVertexShader   ( nullptr )
+, m_pPixelShader    ( nullptr )
+, m_pSampler        ( nullptr )
+, m_pRasterizer     ( nullptr )
+, m_pDepthStencil   ( nullptr )
+, m_MaxInstances    ( 0 )
+{
+    for( UINT i = 0; i < SPRITE_BLEND_COUNT; ++i )
+    { m_pBlend[i] = nullptr; }
+
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SpriteRenderer::~SpriteRenderer()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. maxInstances は1回の転送でインスタンスバッファに書き込める最大数です.
+//      pTracker を指定すると, インスタンスバッファと登録したテクスチャの使用量を記録します.
+//-------------------------------------------------------------------------------------------------
+bool SpriteRenderer::Init( ID3D11Device* pDevice, UINT maxInstances, ResourceTracker* pTracker )
+{
+    Term();
+
+    if ( pDevice == nullptr || maxInstances == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    // 頂点シェーダで SV_VertexID を使うので, シェーダモデル 4.0 以上が必要.
+    if ( pDevice->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0 )
+    {
+        ELOG( "Error : Feature Level 10.0 or higher is required." );
+        return false;
+    }
+
+    m_pDevice      = pDevice;
+    m_pTracker     = pTracker;
+    m_MaxInstances = maxInstances;
+
+    // インスタンスバッファを生成.
+    {
+        D3D11_BUFFER_DESC bd;
+        ZeroMemory( &bd, sizeof(bd) );
+        bd.ByteWidth      = UINT( sizeof(SpriteInstance) ) * maxInstances;
+        bd.Usage          = D3D11_USAGE_DYNAMIC;
+        bd.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        HRESULT hr = m_pDevice->CreateBuffer( &bd, nullptr, &m_pInstanceBuffer );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            Term();
+            return false;
+        }
+
+        if ( m_pTracker != nullptr )
+        { m_pTracker->Track( m_pInstanceBuffer, RESOURCE_CATEGORY_VERTEX_BUFFER, bd.ByteWidth ); }
+    }
+
+    if ( !CreateShaders() )
+    {
+        ELOG( "Error : CreateShaders() Failed." );
+        Term();
+        return false;
+    }
+
+    if ( !CreateStates() )
+    {
+        ELOG( "Error : CreateStates() Failed." );
+        Term();
+        return false;
+    }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void SpriteRenderer::Term()
+{
+    for( size_t i = 0; i < m_Textures.size(); ++i )
+    {
+        if ( m_pTracker != nullptr )
+        { m_pTracker->Untrack( m_Textures[i] ); }
+        SafeRelease( m_Textures[i] );
+    }
+    m_Textures.clear();
+
+    for( UINT i = 0; i < SPRITE_BLEND_COUNT; ++i )
+    { SafeRelease( m_pBlend[i] ); }
+
+    SafeRelease( m_pDepthStencil );
+    SafeRelease( m_pRasterizer );
+    SafeRelease( m_pSampler );
+    SafeRelease( m_pPixelShader );
+    SafeRelease( m_pVertexShader );
+    SafeRelease( m_pInputLayout );
+
+    if ( m_pTracker != nullptr )
+    { m_pTracker->Untrack( m_pInstanceBuffer ); }
+    SafeRelease( m_pInstanceBuffer );
+
+    m_pDevice      = nullptr;
+    m_pTracker     = nullptr;
+    m_MaxInstances = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テクスチャを登録して, SpriteBatch::Draw() に渡すテクスチャ番号を返します.
+//      失敗した場合は SpriteBatch::MaxTextures 以上の値を返します. bytes はテクスチャのサイズで,
+//      同じビューを複数回登録しないでください.
+//-------------------------------------------------------------------------------------------------
+UINT SpriteRenderer::AddTexture( ID3D11ShaderResourceView* pTexture, UINT64 bytes )
+{
+    if ( pTexture == nullptr || m_Textures.size() >= SpriteBatch::MaxTextures )
+    { return INVALID_TEXTURE; }
+
+    if ( m_pTracker != nullptr )
+    { m_pTracker->Track( pTexture, RESOURCE_CATEGORY_TEXTURE, bytes ); }
+
+    pTexture->AddRef();
+    m_Textures.push_back( pTexture );
+    return UINT( m_Textures.size() - 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ソート済みのスプライトを描画します. インスタンス列をバッファ容量ごとに転送し,
+//      各ランを1回のインスタンス描画で発行します. ステートは切り替わる時だけ設定します.
+//      呼び出し後は入力アセンブラとシェーダの設定が変わるので, 呼び出し側で再設定してください.
+//-------------------------------------------------------------------------------------------------
+void SpriteRenderer::Render( ID3D11DeviceContext* pContext, const SpriteBatch& batch )
+{
+    const UINT count = batch.GetSpriteCount();
+    if ( pContext == nullptr || m_pInstanceBuffer == nullptr || count == 0 )
+    { return; }
+
+    Timer timer;
+
+    const SpriteInstance* pInstances = batch.GetInstances();
+    const SpriteRun*      pRuns      = batch.GetRuns();
+    const UINT            runCount   = batch.GetRunCount();
+
+    const UINT stride = sizeof(SpriteInstance);
+    const UINT offset = 0;
+
+    pContext->IASetInputLayout( m_pInputLayout );
+    pContext->IASetVertexBuffers( 0, 1, &m_pInstanceBuffer, &stride, &offset );
+    pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP );
+    pContext->VSSetShader( m_pVertexShader, nullptr, 0 );
+    pContext->PSSetShader( m_pPixelShader,  nullptr, 0 );
+    pContext->PSSetSamplers( 0, 1, &m_pSampler );
+    pContext->RSSetState( m_pRasterizer );
+    pContext->OMSetDepthStencilState( m_pDepthStencil, 0 );
+
+    UINT currentTexture = INVALID_TEXTURE;
+    UINT currentBlend   = INVALID_TEXTURE;
+    UINT run            = 0;
+    UINT runOffset      = 0;    // 現在のランのうち描画済みの数.
+
+    for( UINT chunk = 0; chunk < count; chunk += m_MaxInstances )
+    {
+        const UINT chunkCount = ( count - chunk < m_MaxInstances ) ? count - chunk : m_MaxInstances;
+
+        // 前の転送分を GPU が参照中でもドライバが別領域を割り当てるように破棄して書き込む.
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = pContext->Map( m_pInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11DeviceContext::Map() Failed." );
+            break;
+        }
+        memcpy( mapped.pData, pInstances + chunk, sizeof(SpriteInstance) * chunkCount );
+        pContext->Unmap( m_pInstanceBuffer, 0 );
+        m_Stats.UploadBytes += UINT64( sizeof(SpriteInstance) ) * chunkCount;
+
+        // この転送分に含まれるランを描画. バッファ境界をまたぐランは分割する.
+        UINT drawn = 0;
+        while( drawn < chunkCount && run < runCount )
+        {
+            const SpriteRun& item = pRuns[run];
+            const UINT remain = item.Count - runOffset;
+            const UINT n      = ( remain < chunkCount - drawn ) ? remain : chunkCount - drawn;
+
+            if ( item.Texture != currentTexture )
+            {
+                ID3D11ShaderResourceView* pTexture = ( item.Texture < m_Textures.size() ) ? m_Textures[item.Texture] : nullptr;
+                pContext->PSSetShaderResources( 0, 1, &pTexture );
+                currentTexture = item.Texture;
+                m_Stats.TextureChangeCount++;
+            }
+
+            if ( UINT( item.Blend ) != currentBlend )
+            {
+                const FLOAT blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                pContext->OMSetBlendState( m_pBlend[item.Blend], blendFactor, 0xffffffff );
+                currentBlend = UINT( item.Blend );
+                m_Stats.BlendChangeCount++;
+            }
+
+            pContext->DrawInstanced( QUAD_VERTEX_COUNT, n, 0, drawn );
+            m_Stats.DrawCount++;
+
+            drawn     += n;
+            runOffset += n;
+            if ( runOffset == item.Count )
+            {
+                run++;
+                runOffset = 0;
+            }
+        }
+    }
+
+    // 既定のステートに戻す.
+    ID3D11ShaderResourceView* pNull = nullptr;
+    pContext->PSSetShaderResources( 0, 1, &pNull );
+    pContext->OMSetBlendState( nullptr, nullptr, 0xffffffff );
+    pContext->OMSetDepthStencilState( nullptr, 0 );
+    pContext->RSSetState( nullptr );
+
+    m_Stats.FrameCount++;
+    m_Stats.SpriteCount += count;
+    m_Stats.RenderMsec  += timer.GetElapsedMsec();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SpriteRenderer::Stats SpriteRenderer::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SpriteRenderer::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      シェーダと入力レイアウトを生成します. 頂点データは持たず, インスタンスごとの
+//      データだけを入力スロット 0 から読み込みます.
+//-------------------------------------------------------------------------------------------------
+bool SpriteRenderer::CreateShaders()
+{
+    HRESULT hr = S_OK;
+
+    // 頂点シェーダ・入力レイアウト生成.
+    {
+        #include "../res/Compiled/SpriteVS_VSFunc.inc"
+
+        hr = m_pDevice->CreateVertexShader( SpriteVS_VSFunc, sizeof(SpriteVS_VSFunc), nullptr, &m_pVertexShader );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateVertexShader() Failed." );
+            return false;
+        }
+
+        D3D11_INPUT_ELEMENT_DESC elementDesc[] = {
+            { "SPRITE_CENTER",   0, DXGI_FORMAT_R32G32_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "SPRITE_AXIS",     0, DXGI_FORMAT_R32G32_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "SPRITE_AXIS",     1, DXGI_FORMAT_R32G32_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "SPRITE_TEXCOORD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "SPRITE_COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        };
+
+        hr = m_pDevice->CreateInputLayout( elementDesc, _countof(elementDesc), SpriteVS_VSFunc, sizeof(SpriteVS_VSFunc), &m_pInputLayout );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+            return false;
+        }
+    }
+
+    // ピクセルシェーダ生成.
+    {
+        #include "../res/Compiled/SpritePS_PSFunc.inc"
+
+        hr = m_pDevice->CreatePixelShader( SpritePS_PSFunc, sizeof(SpritePS_PSFunc), nullptr, &m_pPixelShader );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreatePixelShader() Failed." );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サンプラー, ラスタライザ, 深度, ブレンドのステートを生成します.
+//-------------------------------------------------------------------------------------------------
+bool SpriteRenderer::CreateStates()
+{
+    HRESULT hr = S_OK;
+
+    // サンプラー.
+    {
+        D3D11_SAMPLER_DESC sd;
+        ZeroMemory( &sd, sizeof(sd) );
+        sd.Filter         = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        sd.AddressU       = D3D11_TEXTURE_ADDRESS_CLAMP;
+        sd.AddressV       = D3D11_TEXTURE_ADDRESS_CLAMP;
+        sd.AddressW       = D3D11_TEXTURE_ADDRESS_CLAMP;
+        sd.ComparisonFunc = D3D11_COMPARISON_NEVER;
+        sd.MaxLOD         = D3D11_FLOAT32_MAX;
+
+        hr = m_pDevice->CreateSamplerState( &sd, &m_pSampler );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateSamplerState() Failed." );
+            return false;
+        }
+    }
+
+    // 回転や反転したスプライトも描くためカリングしない.
+    {
+        D3D11_RASTERIZER_DESC rd;
+        ZeroMemory( &rd, sizeof(rd) );
+        rd.FillMode        = D3D11_FILL_SOLID;
+        rd.CullMode        = D3D11_CULL_NONE;
+        rd.DepthClipEnable = TRUE;
+
+        hr = m_pDevice->CreateRasterizerState( &rd, &m_pRasterizer );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateRasterizerState() Failed." );
+            return false;
+        }
+    }
+
+    // 描画順はソートキーで決めるので深度テストは行わない.
+    {
+        D3D11_DEPTH_STENCIL_DESC dd;
+        ZeroMemory( &dd, sizeof(dd) );
+        dd.DepthEnable    = FALSE;
+        dd.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+        dd.DepthFunc      = D3D11_COMPARISON_ALWAYS;
+
+        hr = m_pDevice->CreateDepthStencilState( &dd, &m_pDepthStencil );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateDepthStencilState() Failed." );
+            return false;
+        }
+    }
+
+    // ブレンドステート (色は乗算済みアルファ).
+    {
+        const D3D11_BLEND srcBlend [SPRITE_BLEND_COUNT] = { D3D11_BLEND_ONE,  D3D11_BLEND_ONE,           D3D11_BLEND_ONE };
+        const D3D11_BLEND destBlend[SPRITE_BLEND_COUNT] = { D3D11_BLEND_ZERO, D3D11_BLEND_INV_SRC_ALPHA, D3D11_BLEND_ONE };
+
+        for( UINT i = 0; i < SPRITE_BLEND_COUNT; ++i )
+        {
+            D3D11_BLEND_DESC bd;
+            ZeroMemory( &bd, sizeof(bd) );
+            bd.RenderTarget[0].BlendEnable           = ( i != SPRITE_BLEND_OPAQUE ) ? TRUE : FALSE;
+            bd.RenderTarget[0].SrcBlend              = srcBlend [i];
+            bd.RenderTarget[0].DestBlend             = destBlend[i];
+            bd.RenderTarget[0].BlendOp               = D3D11_BLEND_OP_ADD;
+            bd.RenderTarget[0].SrcBlendAlpha         = srcBlend [i];
+            bd.RenderTarget[0].DestBlendAlpha        = destBlend[i];
+            bd.RenderTarget[0].BlendOpAlpha          = D3D11_BLEND_OP_ADD;
+            bd.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+            hr = m_pDevice->CreateBlendState( &bd, &m_pBlend[i] );
+            if ( FAILED( hr ) )
+            {
+                ELOG( "Error : ID3D11Device::CreateBlendState() Failed." );
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
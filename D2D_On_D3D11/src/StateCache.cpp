@@ -0,0 +1,702 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : StateCache.cpp
+// Desc : Redundant State Filter and Pipeline State Objects.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <StateCache.h>
+#include <Logger.h>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <d3d11.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint64_t  FNV_OFFSET_BASIS    = 14695981039346656037ULL;
+const uint64_t  FNV_PRIME           = 1099511628211ULL;
+const uint32_t  INVALID_PIPELINE    = 0xffffffff;
+
+//-------------------------------------------------------------------------------------------------
+//      ハッシュに値を混ぜ込みます. 描画ごとに呼ばれるので, FNV-1a をバイト単位ではなく
+//      64bit 単位で適用します.
+//-------------------------------------------------------------------------------------------------
+inline uint64_t MixHash( uint64_t hash, uint64_t value )
+{
+    hash ^= value;
+    hash *= FNV_PRIME;
+    return hash ^ ( hash >> 29 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パイプラインの記述のハッシュを計算します. 構造体のパディングを含めないよう
+//      メンバーごとに混ぜ込みます.
+//-------------------------------------------------------------------------------------------------
+uint64_t HashPipeline( const PipelineDesc& desc )
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = MixHash( hash, uintptr_t( desc.pInputLayout ) );
+    hash = MixHash( hash, uintptr_t( desc.pVertexShader ) );
+    hash = MixHash( hash, uintptr_t( desc.pPixelShader ) );
+    hash = MixHash( hash, uintptr_t( desc.pBlendState ) );
+    hash = MixHash( hash, uintptr_t( desc.pDepthStencilState ) );
+    hash = MixHash( hash, uintptr_t( desc.pRasterizerState ) );
+    hash = MixHash( hash, desc.Topology );
+    return hash;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パイプラインの記述が等しいかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+inline bool IsSamePipeline( const PipelineDesc& a, const PipelineDesc& b )
+{
+    return a.pInputLayout       == b.pInputLayout
+        && a.pVertexShader      == b.pVertexShader
+        && a.pPixelShader       == b.pPixelShader
+        && a.pBlendState        == b.pBlendState
+        && a.pDepthStencilState == b.pDepthStencilState
+        && a.pRasterizerState   == b.pRasterizerState
+        && a.Topology           == b.Topology;
+}
+
+} // namespace /* anonymous */
+
+
+#if defined(_WIN32)
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// D3D11RenderContext class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+D3D11RenderContext::D3D11RenderContext()
+: m_pContext( nullptr )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+D3D11RenderContext::~D3D11RenderContext()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      呼び出しの発行先のデバイスコンテキストを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetContext( ID3D11DeviceContext* pContext )
+{ m_pContext = pContext; }
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーターゲットと深度ステンシルビューを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetRenderTargets( void* pRenderTarget, void* pDepthStencil )
+{
+    ID3D11RenderTargetView* pRTV = static_cast<ID3D11RenderTargetView*>( pRenderTarget );
+    m_pContext->OMSetRenderTargets( 1, &pRTV, static_cast<ID3D11DepthStencilView*>( pDepthStencil ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入力レイアウトを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetInputLayout( void* pInputLayout )
+{ m_pContext->IASetInputLayout( static_cast<ID3D11InputLayout*>( pInputLayout ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      スロット 0 の頂点バッファを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    ID3D11Buffer* pVB = static_cast<ID3D11Buffer*>( pBuffer );
+    UINT strides = stride;
+    UINT offsets = offset;
+    m_pContext->IASetVertexBuffers( 0, 1, &pVB, &strides, &offsets );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スロット 1 のインスタンスごとの頂点バッファを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    ID3D11Buffer* pVB = static_cast<ID3D11Buffer*>( pBuffer );
+    UINT strides = stride;
+    UINT offsets = offset;
+    m_pContext->IASetVertexBuffers( 1, 1, &pVB, &strides, &offsets );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      プリミティブトポロジーを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetTopology( uint32_t topology )
+{ m_pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY( topology ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      頂点シェーダを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetVertexShader( void* pShader )
+{ m_pContext->VSSetShader( static_cast<ID3D11VertexShader*>( pShader ), nullptr, 0 ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetPixelShader( void* pShader )
+{ m_pContext->PSSetShader( static_cast<ID3D11PixelShader*>( pShader ), nullptr, 0 ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ブレンドステートを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetBlendState( void* pState )
+{ m_pContext->OMSetBlendState( static_cast<ID3D11BlendState*>( pState ), nullptr, 0xffffffff ); }
+
+//-------------------------------------------------------------------------------------------------
+//      深度ステンシルステートを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetDepthStencilState( void* pState )
+{ m_pContext->OMSetDepthStencilState( static_cast<ID3D11DepthStencilState*>( pState ), 0 ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ラスタライザーステートを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetRasterizerState( void* pState )
+{ m_pContext->RSSetState( static_cast<ID3D11RasterizerState*>( pState ) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダのスロット 0 のテクスチャを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetTexture( void* pTexture )
+{
+    ID3D11ShaderResourceView* pSRV = static_cast<ID3D11ShaderResourceView*>( pTexture );
+    m_pContext->PSSetShaderResources( 0, 1, &pSRV );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダのスロット 0 のサンプラーを設定します.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::SetSampler( void* pSampler )
+{
+    ID3D11SamplerState* pState = static_cast<ID3D11SamplerState*>( pSampler );
+    m_pContext->PSSetSamplers( 0, 1, &pState );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画します. インスタンス数が 1 の場合は Draw() を使います.
+//-------------------------------------------------------------------------------------------------
+void D3D11RenderContext::Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance )
+{
+    if ( instanceCount == 1 && startInstance == 0 )
+    { m_pContext->Draw( vertexCount, startVertex ); }
+    else
+    { m_pContext->DrawInstanced( vertexCount, instanceCount, startVertex, startInstance ); }
+}
+#endif//defined(_WIN32)
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// RecordingRenderContext class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+RecordingRenderContext::RecordingRenderContext()
+{ Reset(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+RecordingRenderContext::~RecordingRenderContext()
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーターゲットと深度ステンシルビューを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetRenderTargets( void* pRenderTarget, void* pDepthStencil )
+{
+    m_State[RENDER_CALL_TARGETS] = uintptr_t( pRenderTarget );
+    m_DepthStencil = uintptr_t( pDepthStencil );
+    m_CallCount[RENDER_CALL_TARGETS]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      入力レイアウトを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetInputLayout( void* pInputLayout )
+{
+    m_State[RENDER_CALL_INPUT_LAYOUT] = uintptr_t( pInputLayout );
+    m_CallCount[RENDER_CALL_INPUT_LAYOUT]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      頂点バッファを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    m_State[RENDER_CALL_VERTEX_BUFFER] = uintptr_t( pBuffer );
+    m_Stride = stride;
+    m_Offset = offset;
+    m_CallCount[RENDER_CALL_VERTEX_BUFFER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      プリミティブトポロジーを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetTopology( uint32_t topology )
+{
+    m_State[RENDER_CALL_TOPOLOGY] = topology;
+    m_CallCount[RENDER_CALL_TOPOLOGY]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      頂点シェーダを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetVertexShader( void* pShader )
+{
+    m_State[RENDER_CALL_VERTEX_SHADER] = uintptr_t( pShader );
+    m_CallCount[RENDER_CALL_VERTEX_SHADER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetPixelShader( void* pShader )
+{
+    m_State[RENDER_CALL_PIXEL_SHADER] = uintptr_t( pShader );
+    m_CallCount[RENDER_CALL_PIXEL_SHADER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ブレンドステートを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetBlendState( void* pState )
+{
+    m_State[RENDER_CALL_BLEND] = uintptr_t( pState );
+    m_CallCount[RENDER_CALL_BLEND]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      深度ステンシルステートを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetDepthStencilState( void* pState )
+{
+    m_State[RENDER_CALL_DEPTH_STENCIL] = uintptr_t( pState );
+    m_CallCount[RENDER_CALL_DEPTH_STENCIL]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ラスタライザーステートを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetRasterizerState( void* pState )
+{
+    m_State[RENDER_CALL_RASTERIZER] = uintptr_t( pState );
+    m_CallCount[RENDER_CALL_RASTERIZER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テクスチャを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetTexture( void* pTexture )
+{
+    m_State[RENDER_CALL_TEXTURE] = uintptr_t( pTexture );
+    m_CallCount[RENDER_CALL_TEXTURE]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サンプラーを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetSampler( void* pSampler )
+{
+    m_State[RENDER_CALL_SAMPLER] = uintptr_t( pSampler );
+    m_CallCount[RENDER_CALL_SAMPLER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      インスタンスバッファを記録します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    m_State[RENDER_CALL_INSTANCE_BUFFER] = uintptr_t( pBuffer );
+    m_InstanceStride = stride;
+    m_InstanceOffset = offset;
+    m_CallCount[RENDER_CALL_INSTANCE_BUFFER]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画を記録します. 描画時点のステートと引数をチェックサムに畳み込むので,
+//      フィルタの有無でチェックサムが一致すれば描画結果も一致します.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance )
+{
+    uint64_t hash = m_Checksum;
+    for( uint32_t i = 0; i < RENDER_CALL_DRAW; ++i )
+    { hash = MixHash( hash, m_State[i] ); }
+    hash = MixHash( hash, m_DepthStencil );
+    hash = MixHash( hash, ( uint64_t( m_Stride ) << 32 ) | m_Offset );
+    hash = MixHash( hash, ( uint64_t( m_InstanceStride ) << 32 ) | m_InstanceOffset );
+    hash = MixHash( hash, ( uint64_t( vertexCount ) << 32 ) | instanceCount );
+    hash = MixHash( hash, ( uint64_t( startVertex ) << 32 ) | startInstance );
+
+    m_Checksum = hash;
+    m_CallCount[RENDER_CALL_DRAW]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      記録したステートと呼び出し数をリセットします.
+//-------------------------------------------------------------------------------------------------
+void RecordingRenderContext::Reset()
+{
+    memset( m_State,     0, sizeof(m_State) );
+    memset( m_CallCount, 0, sizeof(m_CallCount) );
+    m_DepthStencil   = 0;
+    m_Stride         = 0;
+    m_Offset         = 0;
+    m_InstanceStride = 0;
+    m_InstanceOffset = 0;
+    m_Checksum       = FNV_OFFSET_BASIS;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定した種類の呼び出し数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t RecordingRenderContext::GetCallCount( RENDER_CALL call ) const
+{ return ( call < RENDER_CALL_COUNT ) ? m_CallCount[call] : 0; }
+
+//-------------------------------------------------------------------------------------------------
+//      描画以外の呼び出し数の合計を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t RecordingRenderContext::GetStateCallCount() const
+{
+    uint64_t count = 0;
+    for( uint32_t i = 0; i < RENDER_CALL_DRAW; ++i )
+    { count += m_CallCount[i]; }
+    return count;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画ごとのステートを畳み込んだチェックサムを取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t RecordingRenderContext::GetChecksum() const
+{ return m_Checksum; }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// StateCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+StateCache::StateCache()
+: m_pContext ( nullptr )
+, m_ValidMask( 0 )
+, m_Enabled  ( true )
+{
+    memset( &m_Bound, 0, sizeof(m_Bound) );
+    m_Bound.PipelineId = INVALID_PIPELINE;
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+StateCache::~StateCache()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. 現在コンテキストに設定されているステートは分からないものとして扱います.
+//-------------------------------------------------------------------------------------------------
+bool StateCache::Init( RenderContext* pContext )
+{
+    if ( pContext == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pContext = pContext;
+    Invalidate();
+    ResetStats();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 作成したパイプラインも破棄します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::Term()
+{
+    m_pContext = nullptr;
+    m_Pipelines.clear();
+    m_PipelineMap.clear();
+    Invalidate();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パイプラインを作成します. 同じ記述のパイプラインが既にあればその番号を返します.
+//      作成したパイプラインは Term() まで変更されません.
+//-------------------------------------------------------------------------------------------------
+uint32_t StateCache::CreatePipeline( const PipelineDesc& desc )
+{
+    const uint64_t hash = HashPipeline( desc );
+
+    uint32_t* pHead = nullptr;
+    std::unordered_map<uint64_t, uint32_t>::iterator itr = m_PipelineMap.find( hash );
+    if ( itr != m_PipelineMap.end() )
+    {
+        // ハッシュが衝突した場合に備えて記述も比較する.
+        for( uint32_t id = itr->second; id != INVALID_PIPELINE; id = m_Pipelines[id].Next )
+        {
+            if ( IsSamePipeline( m_Pipelines[id].Desc, desc ) )
+            { return id; }
+        }
+        pHead = &itr->second;
+    }
+
+    PipelineState state;
+    state.Desc = desc;
+    state.Hash = hash;
+    state.Next = ( pHead != nullptr ) ? *pHead : INVALID_PIPELINE;
+
+    const uint32_t id = uint32_t( m_Pipelines.size() );
+    m_Pipelines.push_back( state );
+
+    if ( pHead != nullptr )
+    { *pHead = id; }
+    else
+    { m_PipelineMap[hash] = id; }
+
+    return id;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パイプラインの記述を取得します.
+//-------------------------------------------------------------------------------------------------
+const PipelineDesc& StateCache::GetPipeline( uint32_t pipeline ) const
+{ return m_Pipelines[pipeline].Desc; }
+
+//-------------------------------------------------------------------------------------------------
+//      作成したパイプライン数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t StateCache::GetPipelineCount() const
+{ return uint32_t( m_Pipelines.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      冗長な呼び出しを省くかどうかを設定します. 無効にすると全ての呼び出しを発行します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetEnabled( bool enabled )
+{
+    m_Enabled = enabled;
+    Invalidate();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      冗長な呼び出しを省くかどうかを取得します.
+//-------------------------------------------------------------------------------------------------
+bool StateCache::IsEnabled() const
+{ return m_Enabled; }
+
+//-------------------------------------------------------------------------------------------------
+//      記録しているステートを破棄します. StateCache を通さずにコンテキストのステートを
+//      変更した後 (ClearState() や別の描画クラスの呼び出し) に呼び出します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::Invalidate()
+{
+    m_ValidMask        = 0;
+    m_Bound.PipelineId = INVALID_PIPELINE;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      レンダーターゲットと深度ステンシルビューを設定します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetRenderTargets( void* pRenderTarget, void* pDepthStencil )
+{
+    const bool same = ( m_Bound.pRenderTarget == pRenderTarget ) && ( m_Bound.pDepthStencil == pDepthStencil );
+    if ( !NeedsCall( RENDER_CALL_TARGETS, same ) )
+    { return; }
+
+    m_Bound.pRenderTarget = pRenderTarget;
+    m_Bound.pDepthStencil = pDepthStencil;
+    m_pContext->SetRenderTargets( pRenderTarget, pDepthStencil );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パイプラインを設定します. 直前と同じパイプラインなら比較を省略し, 異なる場合は
+//      パイプラインを構成するステートごとに変化したものだけを発行します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetPipeline( uint32_t pipeline )
+{
+    if ( pipeline >= m_Pipelines.size() )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return;
+    }
+
+    if ( m_Enabled && pipeline == m_Bound.PipelineId )
+    {
+        m_Stats.PipelineHitCount++;
+        for( uint32_t i = RENDER_CALL_INPUT_LAYOUT; i <= RENDER_CALL_RASTERIZER; ++i )
+        {
+            if ( i != RENDER_CALL_VERTEX_BUFFER )
+            { m_Stats.Elided[i]++; }
+        }
+        return;
+    }
+
+    const PipelineDesc& desc  = m_Pipelines[pipeline].Desc;
+    PipelineDesc&       bound = m_Bound.Pipeline;
+
+    m_Bound.PipelineId = pipeline;
+    m_Stats.PipelineChangeCount++;
+
+    if ( NeedsCall( RENDER_CALL_INPUT_LAYOUT, bound.pInputLayout == desc.pInputLayout ) )
+    {
+        bound.pInputLayout = desc.pInputLayout;
+        m_pContext->SetInputLayout( desc.pInputLayout );
+    }
+
+    if ( NeedsCall( RENDER_CALL_TOPOLOGY, bound.Topology == desc.Topology ) )
+    {
+        bound.Topology = desc.Topology;
+        m_pContext->SetTopology( desc.Topology );
+    }
+
+    if ( NeedsCall( RENDER_CALL_VERTEX_SHADER, bound.pVertexShader == desc.pVertexShader ) )
+    {
+        bound.pVertexShader = desc.pVertexShader;
+        m_pContext->SetVertexShader( desc.pVertexShader );
+    }
+
+    if ( NeedsCall( RENDER_CALL_PIXEL_SHADER, bound.pPixelShader == desc.pPixelShader ) )
+    {
+        bound.pPixelShader = desc.pPixelShader;
+        m_pContext->SetPixelShader( desc.pPixelShader );
+    }
+
+    if ( NeedsCall( RENDER_CALL_BLEND, bound.pBlendState == desc.pBlendState ) )
+    {
+        bound.pBlendState = desc.pBlendState;
+        m_pContext->SetBlendState( desc.pBlendState );
+    }
+
+    if ( NeedsCall( RENDER_CALL_DEPTH_STENCIL, bound.pDepthStencilState == desc.pDepthStencilState ) )
+    {
+        bound.pDepthStencilState = desc.pDepthStencilState;
+        m_pContext->SetDepthStencilState( desc.pDepthStencilState );
+    }
+
+    if ( NeedsCall( RENDER_CALL_RASTERIZER, bound.pRasterizerState == desc.pRasterizerState ) )
+    {
+        bound.pRasterizerState = desc.pRasterizerState;
+        m_pContext->SetRasterizerState( desc.pRasterizerState );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スロット 0 の頂点バッファを設定します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetVertexBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    const bool same = ( m_Bound.pVertexBuffer == pBuffer ) && ( m_Bound.Stride == stride ) && ( m_Bound.Offset == offset );
+    if ( !NeedsCall( RENDER_CALL_VERTEX_BUFFER, same ) )
+    { return; }
+
+    m_Bound.pVertexBuffer = pBuffer;
+    m_Bound.Stride        = stride;
+    m_Bound.Offset        = offset;
+    m_pContext->SetVertexBuffer( pBuffer, stride, offset );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダのスロット 0 のテクスチャを設定します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetTexture( void* pTexture )
+{
+    if ( !NeedsCall( RENDER_CALL_TEXTURE, m_Bound.pTexture == pTexture ) )
+    { return; }
+
+    m_Bound.pTexture = pTexture;
+    m_pContext->SetTexture( pTexture );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ピクセルシェーダのスロット 0 のサンプラーを設定します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetSampler( void* pSampler )
+{
+    if ( !NeedsCall( RENDER_CALL_SAMPLER, m_Bound.pSampler == pSampler ) )
+    { return; }
+
+    m_Bound.pSampler = pSampler;
+    m_pContext->SetSampler( pSampler );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スロット 1 のインスタンスごとの頂点バッファを設定します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::SetInstanceBuffer( void* pBuffer, uint32_t stride, uint32_t offset )
+{
+    const bool same = ( m_Bound.pInstanceBuffer == pBuffer )
+                   && ( m_Bound.InstanceStride  == stride )
+                   && ( m_Bound.InstanceOffset  == offset );
+    if ( !NeedsCall( RENDER_CALL_INSTANCE_BUFFER, same ) )
+    { return; }
+
+    m_Bound.pInstanceBuffer = pBuffer;
+    m_Bound.InstanceStride  = stride;
+    m_Bound.InstanceOffset  = offset;
+    m_pContext->SetInstanceBuffer( pBuffer, stride, offset );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::Draw( uint32_t vertexCount, uint32_t startVertex )
+{
+    m_Stats.Issued[RENDER_CALL_DRAW]++;
+    m_pContext->Draw( vertexCount, 1, startVertex, 0 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      インスタンス描画します.
+//-------------------------------------------------------------------------------------------------
+void StateCache::DrawInstanced( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance )
+{
+    m_Stats.Issued[RENDER_CALL_DRAW]++;
+    m_pContext->Draw( vertexCount, instanceCount, startVertex, startInstance );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+StateCache::Stats StateCache::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void StateCache::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      呼び出しを発行する必要があるかどうかを判定し, 統計情報を更新します.
+//      same は記録しているステートと設定しようとしている値が等しいかどうかです.
+//-------------------------------------------------------------------------------------------------
+bool StateCache::NeedsCall( RENDER_CALL call, bool same )
+{
+    const uint32_t bit = 1u << call;
+    if ( m_Enabled && same && ( m_ValidMask & bit ) )
+    {
+        m_Stats.Elided[call]++;
+        return false;
+    }
+
+    m_ValidMask |= bit;
+    m_Stats.Issued[call]++;
+    return true;
+}
@@ -0,0 +1,187 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Surface.cpp
+// Desc : CPU Pixel Surface (Premultiplied B8G8R8A8).
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Surface.h>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+//      アライメントを指定してメモリを確保します.
+//-------------------------------------------------------------------------------------------------
+void* AlignedAlloc( size_t size, size_t alignment )
+{
+#if defined(_MSC_VER)
+    return _aligned_malloc( size, alignment );
+#else
+    void* ptr = nullptr;
+    return ( posix_memalign( &ptr, alignment, size ) == 0 ) ? ptr : nullptr;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      AlignedAlloc() で確保したメモリを解放します.
+//-------------------------------------------------------------------------------------------------
+void AlignedFree( void* ptr )
+{
+#if defined(_MSC_VER)
+    _aligned_free( ptr );
+#else
+    free( ptr );
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      [0, 1] の値を 8bit に変換します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t ToByte( float value )
+{
+    if ( !( value > 0.0f ) )
+    { return 0; }
+    if ( value >= 1.0f )
+    { return 255; }
+    return uint32_t( value * 255.0f + 0.5f );
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Surface class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+Surface::Surface()
+: m_pPixels ( nullptr )
+, m_Width   ( 0 )
+, m_Height  ( 0 )
+, m_Pitch   ( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+Surface::~Surface()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. 行ピッチは Alignment の倍数に切り上げ, 画素は透明黒で初期化します.
+//-------------------------------------------------------------------------------------------------
+bool Surface::Init( uint32_t width, uint32_t height )
+{
+    Term();
+
+    if ( width == 0 || height == 0 )
+    { return false; }
+
+    const uint32_t pitch = ( width * 4 + Alignment - 1 ) & ~( Alignment - 1 );
+    m_pPixels = static_cast<uint8_t*>( AlignedAlloc( size_t( pitch ) * height, Alignment ) );
+    if ( m_pPixels == nullptr )
+    { return false; }
+
+    m_Width  = width;
+    m_Height = height;
+    m_Pitch  = pitch;
+    memset( m_pPixels, 0, size_t( pitch ) * height );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void Surface::Term()
+{
+    if ( m_pPixels != nullptr )
+    { AlignedFree( m_pPixels ); }
+
+    m_pPixels = nullptr;
+    m_Width   = 0;
+    m_Height  = 0;
+    m_Pitch   = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全画素を指定色 (乗算済み B8G8R8A8) で塗りつぶします.
+//-------------------------------------------------------------------------------------------------
+void Surface::Clear( uint32_t color )
+{
+    for( uint32_t y = 0; y < m_Height; ++y )
+    {
+        uint32_t* pRow = GetRow( y );
+        for( uint32_t x = 0; x < m_Width; ++x )
+        { pRow[x] = color; }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      有効なサーフェイスかどうかチェックします.
+//-------------------------------------------------------------------------------------------------
+bool Surface::IsValid() const
+{ return m_pPixels != nullptr; }
+
+//-------------------------------------------------------------------------------------------------
+//      横幅を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t Surface::GetWidth() const
+{ return m_Width; }
+
+//-------------------------------------------------------------------------------------------------
+//      縦幅を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t Surface::GetHeight() const
+{ return m_Height; }
+
+//-------------------------------------------------------------------------------------------------
+//      行ピッチ (バイト単位) を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t Surface::GetPitch() const
+{ return m_Pitch; }
+
+//-------------------------------------------------------------------------------------------------
+//      画素データの先頭を取得します.
+//-------------------------------------------------------------------------------------------------
+uint8_t* Surface::GetPixels()
+{ return m_pPixels; }
+
+//-------------------------------------------------------------------------------------------------
+//      画素データの先頭を取得します.
+//-------------------------------------------------------------------------------------------------
+const uint8_t* Surface::GetPixels() const
+{ return m_pPixels; }
+
+//-------------------------------------------------------------------------------------------------
+//      指定行の先頭を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t* Surface::GetRow( uint32_t y )
+{ return reinterpret_cast<uint32_t*>( m_pPixels + size_t( y ) * m_Pitch ); }
+
+//-------------------------------------------------------------------------------------------------
+//      指定行の先頭を取得します.
+//-------------------------------------------------------------------------------------------------
+const uint32_t* Surface::GetRow( uint32_t y ) const
+{ return reinterpret_cast<const uint32_t*>( m_pPixels + size_t( y ) * m_Pitch ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ストレートアルファの色を乗算済み B8G8R8A8 にパックします.
+//-------------------------------------------------------------------------------------------------
+uint32_t Surface::PackColor( float r, float g, float b, float a )
+{
+    const uint32_t alpha = ToByte( a );
+    const float    scale = float( alpha ) / 255.0f;
+    return ( alpha << 24 ) | ( ToByte( r * scale ) << 16 ) | ( ToByte( g * scale ) << 8 ) | ToByte( b * scale );
+}
@@ -0,0 +1,328 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SurfaceGroup.cpp
+// Desc : Offscreen Render Surface Group.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SurfaceGroup.h>
+#include <Logger.h>
+#include <SafeRelease.h>
+#include <cstdio>
+#include <cmath>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLayoutCache class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextLayoutCache::TextLayoutCache()
+: m_pFactory    ( nullptr )
+, m_pFormat     ( nullptr )
+, m_MaxWidth    ( 0.0f )
+, m_MaxHeight   ( 0.0f )
+, m_HitCount    ( 0 )
+, m_MissCount   ( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextLayoutCache::~TextLayoutCache()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です.
+//-------------------------------------------------------------------------------------------------
+bool TextLayoutCache::Init( IDWriteFactory* pFactory, IDWriteTextFormat* pFormat, FLOAT maxWidth, FLOAT maxHeight )
+{
+    Term();
+
+    if ( pFactory == nullptr || pFormat == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pFactory = pFactory;
+    m_pFactory->AddRef();
+
+    m_pFormat = pFormat;
+    m_pFormat->AddRef();
+
+    m_MaxWidth  = maxWidth;
+    m_MaxHeight = maxHeight;
+    m_HitCount  = 0;
+    m_MissCount = 0;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void TextLayoutCache::Term()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    for( auto itr = m_Layouts.begin(); itr != m_Layouts.end(); ++itr )
+    { SafeRelease( itr->second ); }
+    m_Layouts.clear();
+
+    SafeRelease( m_pFormat );
+    SafeRelease( m_pFactory );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      テキストレイアウトを取得します. 未登録の場合は生成してキャッシュします.
+//      返却されたレイアウトはキャッシュが所有します.
+//-------------------------------------------------------------------------------------------------
+IDWriteTextLayout* TextLayoutCache::GetLayout( const std::wstring& text )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+
+    auto itr = m_Layouts.find( text );
+    if ( itr != m_Layouts.end() )
+    {
+        m_HitCount++;
+        return itr->second;
+    }
+
+    if ( m_pFactory == nullptr )
+    { return nullptr; }
+
+    IDWriteTextLayout* pLayout = nullptr;
+    HRESULT hr = m_pFactory->CreateTextLayout(
+        text.c_str(),
+        UINT32( text.size() ),
+        m_pFormat,
+        m_MaxWidth,
+        m_MaxHeight,
+        &pLayout );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : IDWriteFactory::CreateTextLayout() Failed." );
+        return nullptr;
+    }
+
+    m_MissCount++;
+    m_Layouts[text] = pLayout;
+    return pLayout;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュヒット数を取得します.
+//-------------------------------------------------------------------------------------------------
+UINT TextLayoutCache::GetHitCount() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_HitCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      キャッシュミス数を取得します.
+//-------------------------------------------------------------------------------------------------
+UINT TextLayoutCache::GetMissCount() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_MissCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SurfaceGroup class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SurfaceGroup::SurfaceGroup()
+: m_pTracker( nullptr )
+, m_Width   ( 0 )
+, m_Height  ( 0 )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SurfaceGroup::~SurfaceGroup()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です.
+//      全サーフェイスが1つの D2D デバイスを共有し, デバイスコンテキストのみ個別に生成します.
+//      ウィンドウやスワップチェインには依存しません.
+//-------------------------------------------------------------------------------------------------
+bool SurfaceGroup::Init
+(
+    ID2D1Device*        pDevice,
+    IDWriteFactory*     pDWriteFactory,
+    IDWriteTextFormat*  pTextFormat,
+    UINT                surfaceCount,
+    UINT                width,
+    UINT                height,
+    ResourceTracker*    pTracker
+)
+{
+    Term();
+
+    if ( pDevice == nullptr || surfaceCount == 0 || width == 0 || height == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    if ( !m_LayoutCache.Init( pDWriteFactory, pTextFormat, FLOAT( width ), FLOAT( height ) ) )
+    {
+        ELOG( "Error : TextLayoutCache::Init() Failed." );
+        return false;
+    }
+
+    m_pTracker = pTracker;
+    m_Width    = width;
+    m_Height   = height;
+
+    const auto bitmapProp = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET,
+        D2D1::PixelFormat( DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED ) );
+
+    m_Surfaces.resize( surfaceCount );
+    for( UINT i = 0; i < surfaceCount; ++i )
+    {
+        Surface& surface = m_Surfaces[i];
+        surface.pContext = nullptr;
+        surface.pTarget  = nullptr;
+        surface.pBrush   = nullptr;
+
+        HRESULT hr = pDevice->CreateDeviceContext( D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &surface.pContext );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID2D1Device::CreateDeviceContext() Failed." );
+            Term();
+            return false;
+        }
+
+        hr = surface.pContext->CreateBitmap( D2D1::SizeU( width, height ), nullptr, 0, bitmapProp, &surface.pTarget );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID2D1DeviceContext::CreateBitmap() Failed." );
+            Term();
+            return false;
+        }
+
+        if ( m_pTracker != nullptr )
+        { m_pTracker->Track( surface.pTarget, RESOURCE_CATEGORY_D2D_BITMAP, UINT64( width ) * height * 4 ); }
+
+        hr = surface.pContext->CreateSolidColorBrush( D2D1::ColorF( D2D1::ColorF::White ), &surface.pBrush );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID2D1DeviceContext::CreateSolidColorBrush() Failed." );
+            Term();
+            return false;
+        }
+
+        wchar_t title[32];
+        swprintf( title, 32, L"Panel %02u", i );
+        surface.Title = title;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void SurfaceGroup::Term()
+{
+    for( size_t i = 0; i < m_Surfaces.size(); ++i )
+    {
+        SafeRelease( m_Surfaces[i].pBrush );
+        if ( m_pTracker != nullptr )
+        { m_pTracker->Untrack( m_Surfaces[i].pTarget ); }
+        SafeRelease( m_Surfaces[i].pTarget );
+        SafeRelease( m_Surfaces[i].pContext );
+    }
+    m_Surfaces.clear();
+
+    m_LayoutCache.Term();
+    m_pTracker = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全サーフェイスをスレッドプールで並列に描画します.
+//-------------------------------------------------------------------------------------------------
+void SurfaceGroup::Render( ThreadPool& pool, UINT frameIndex )
+{
+    pool.ParallelFor( UINT( m_Surfaces.size() ), [this, frameIndex]( uint32_t index )
+    { RenderSurface( index, frameIndex ); } );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイス数を取得します.
+//-------------------------------------------------------------------------------------------------
+UINT SurfaceGroup::GetSurfaceCount() const
+{ return UINT( m_Surfaces.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      サーフェイスのビットマップを取得します.
+//-------------------------------------------------------------------------------------------------
+ID2D1Bitmap1* SurfaceGroup::GetBitmap( UINT index ) const
+{
+    if ( index >= m_Surfaces.size() )
+    { return nullptr; }
+
+    return m_Surfaces[index].pTarget;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      共有テキストレイアウトキャッシュを取得します.
+//-------------------------------------------------------------------------------------------------
+const TextLayoutCache& SurfaceGroup::GetLayoutCache() const
+{ return m_LayoutCache; }
+
+//-------------------------------------------------------------------------------------------------
+//      1枚のサーフェイスを描画します. ワーカースレッドから呼び出されます.
+//-------------------------------------------------------------------------------------------------
+void SurfaceGroup::RenderSurface( UINT index, UINT frameIndex )
+{
+    static const wchar_t Caption[] = L"ぽえ～ん。";
+
+    Surface& surface = m_Surfaces[index];
+    ID2D1DeviceContext* pContext = surface.pContext;
+
+    const FLOAT w = FLOAT( m_Width );
+    const FLOAT h = FLOAT( m_Height );
+
+    // パネルごとに位相をずらしたゲージ.
+    const FLOAT phase = FLOAT( ( frameIndex + index * 7 ) % 120 ) / 120.0f;
+    const FLOAT gauge = 0.5f + 0.5f * sinf( phase * 6.2831853f );
+
+    pContext->SetTarget( surface.pTarget );
+    pContext->BeginDraw();
+    pContext->SetTransform( D2D1::Matrix3x2F::Identity() );
+    pContext->Clear( D2D1::ColorF( 0.1f, 0.1f + 0.02f * FLOAT( index % 8 ), 0.2f, 1.0f ) );
+
+    surface.pBrush->SetColor( D2D1::ColorF( 0.2f, 0.6f, 1.0f, 1.0f ) );
+    pContext->FillRectangle( D2D1::RectF( 0.0f, h * 0.8f, w * gauge, h ), surface.pBrush );
+
+    // レイアウトは全サーフェイスで共有し, 毎フレーム再計算しない.
+    surface.pBrush->SetColor( D2D1::ColorF( D2D1::ColorF::White ) );
+    IDWriteTextLayout* pTitle = m_LayoutCache.GetLayout( surface.Title );
+    if ( pTitle != nullptr )
+    { pContext->DrawTextLayout( D2D1::Point2F( 0.0f, -h * 0.25f ), pTitle, surface.pBrush ); }
+
+    IDWriteTextLayout* pCaption = m_LayoutCache.GetLayout( Caption );
+    if ( pCaption != nullptr )
+    { pContext->DrawTextLayout( D2D1::Point2F( 0.0f, h * 0.1f ), pCaption, surface.pBrush ); }
+
+    HRESULT hr = pContext->EndDraw();
+    if ( FAILED( hr ) )
+    { ELOG( "Error : ID2D1DeviceContext::EndDraw() Failed." ); }
+
+    pContext->SetTarget( nullptr );
+}
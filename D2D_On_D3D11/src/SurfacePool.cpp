@@ -0,0 +1,152 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : SurfacePool.cpp
+// Desc : Pooled Offscreen Surface Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <SurfacePool.h>
+#include <Logger.h>
+#include <cstdio>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// SurfacePool class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+SurfacePool::SurfacePool()
+{ ResetStats(); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+SurfacePool::~SurfacePool()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      width x height 以上のサーフェイスを取得します.
+//      解放済みのものから面積が最小のものを選び, 無ければ新たに確保します.
+//      返すサーフェイスの内容は不定なので, 必要に応じて呼び出し側でクリアしてください.
+//-------------------------------------------------------------------------------------------------
+Surface* SurfacePool::Acquire( uint32_t width, uint32_t height )
+{
+    m_Stats.AcquireCount++;
+
+    size_t   best     = m_Free.size();
+    uint64_t bestArea = 0;
+    for( size_t i = 0; i < m_Free.size(); ++i )
+    {
+        const Surface* pSurface = m_Free[i];
+        if ( pSurface->GetWidth() < width || pSurface->GetHeight() < height )
+        { continue; }
+
+        const uint64_t area = uint64_t( pSurface->GetWidth() ) * pSurface->GetHeight();
+        if ( best == m_Free.size() || area < bestArea )
+        {
+            best     = i;
+            bestArea = area;
+        }
+    }
+
+    if ( best != m_Free.size() )
+    {
+        Surface* pResult = m_Free[best];
+        m_Free[best] = m_Free.back();
+        m_Free.pop_back();
+
+        m_Stats.ReuseCount++;
+        m_Stats.FreeCount = uint32_t( m_Free.size() );
+        return pResult;
+    }
+
+    std::unique_ptr<Surface> surface( new Surface() );
+    if ( !surface->Init( width, height ) )
+    {
+        ELOG( "Error : Surface::Init() Failed." );
+        return nullptr;
+    }
+
+    Surface* pResult = surface.get();
+    m_Surfaces.push_back( std::move( surface ) );
+
+    m_Stats.AllocCount++;
+    m_Stats.LiveCount  = uint32_t( m_Surfaces.size() );
+    m_Stats.LiveBytes += uint64_t( pResult->GetPitch() ) * pResult->GetHeight();
+    return pResult;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Acquire() で取得したサーフェイスを返却します.
+//-------------------------------------------------------------------------------------------------
+void SurfacePool::Release( Surface* pSurface )
+{
+    if ( pSurface == nullptr )
+    { return; }
+
+    m_Free.push_back( pSurface );
+    m_Stats.FreeCount = uint32_t( m_Free.size() );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      再利用待ちのサーフェイスを全て破棄します.
+//-------------------------------------------------------------------------------------------------
+void SurfacePool::Trim()
+{
+    for( size_t i = 0; i < m_Free.size(); ++i )
+    {
+        for( size_t j = 0; j < m_Surfaces.size(); ++j )
+        {
+            if ( m_Surfaces[j].get() != m_Free[i] )
+            { continue; }
+
+            m_Stats.LiveBytes -= uint64_t( m_Free[i]->GetPitch() ) * m_Free[i]->GetHeight();
+            m_Surfaces[j] = std::move( m_Surfaces.back() );
+            m_Surfaces.pop_back();
+            break;
+        }
+    }
+
+    m_Free.clear();
+    m_Stats.LiveCount = uint32_t( m_Surfaces.size() );
+    m_Stats.FreeCount = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 返却されていないサーフェイスも破棄します.
+//-------------------------------------------------------------------------------------------------
+void SurfacePool::Term()
+{
+    m_Free    .clear();
+    m_Surfaces.clear();
+
+    m_Stats.LiveCount = 0;
+    m_Stats.FreeCount = 0;
+    m_Stats.LiveBytes = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+SurfacePool::Stats SurfacePool::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      呼び出し回数の統計をリセットします.
+//-------------------------------------------------------------------------------------------------
+void SurfacePool::ResetStats()
+{
+    m_Stats.AcquireCount = 0;
+    m_Stats.ReuseCount   = 0;
+    m_Stats.AllocCount   = 0;
+    m_Stats.LiveCount    = uint32_t( m_Surfaces.size() );
+    m_Stats.FreeCount    = uint32_t( m_Free.size() );
+
+    m_Stats.LiveBytes = 0;
+    for( size_t i = 0; i < m_Surfaces.size(); ++i )
+    { m_Stats.LiveBytes += uint64_t( m_Surfaces[i]->GetPitch() ) * m_Surfaces[i]->GetHeight(); }
+}
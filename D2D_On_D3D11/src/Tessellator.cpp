@@ -0,0 +1,793 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Tessellator.cpp
+// Desc : Vector Path Tessellator.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Tessellator.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint64_t  FNV_OFFSET_BASIS    = 14695981039346656037ULL;
+const uint64_t  FNV_PRIME           = 1099511628211ULL;
+const float     PI                  = 3.14159265358979f;
+const int       MAX_CURVE_SEGMENTS  = 1024;
+const int       MAX_ARC_SEGMENTS    = 256;
+
+//-------------------------------------------------------------------------------------------------
+//      FNV-1a ハッシュにバイト列を混ぜ込みます.
+//-------------------------------------------------------------------------------------------------
+inline uint64_t HashBytes( uint64_t hash, const void* pData, size_t size )
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>( pData );
+    for( size_t i = 0; i < size; ++i )
+    {
+        hash ^= pBytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Wang の公式から曲線の分割数を求めます.
+//      degreeFactor は 2次で 1/4, 3次で 3/4 です.
+//-------------------------------------------------------------------------------------------------
+inline int CurveSegments( float maxSecondDiff, float degreeFactor, float tolerance )
+{
+    const float n = std::sqrt( degreeFactor * maxSecondDiff / tolerance );
+    if ( !( n > 1.0f ) )
+    { return 1; }
+
+    return ( n < float( MAX_CURVE_SEGMENTS ) ) ? int( std::ceil( n ) ) : MAX_CURVE_SEGMENTS;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Path class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+Path::Path()
+: m_Hash( FNV_OFFSET_BASIS )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      新しい輪郭を開始します.
+//-------------------------------------------------------------------------------------------------
+void Path::MoveTo( float x, float y )
+{
+    AddVerb ( VERB_MOVE );
+    AddPoint( x, y );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      直線を追加します.
+//-------------------------------------------------------------------------------------------------
+void Path::LineTo( float x, float y )
+{
+    AddVerb ( VERB_LINE );
+    AddPoint( x, y );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2次ベジェ曲線を追加します.
+//-------------------------------------------------------------------------------------------------
+void Path::QuadTo( float cx, float cy, float x, float y )
+{
+    AddVerb ( VERB_QUAD );
+    AddPoint( cx, cy );
+    AddPoint( x, y );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      3次ベジェ曲線を追加します.
+//-------------------------------------------------------------------------------------------------
+void Path::CubicTo( float c0x, float c0y, float c1x, float c1y, float x, float y )
+{
+    AddVerb ( VERB_CUBIC );
+    AddPoint( c0x, c0y );
+    AddPoint( c1x, c1y );
+    AddPoint( x, y );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      現在の輪郭を閉じます.
+//-------------------------------------------------------------------------------------------------
+void Path::Close()
+{ AddVerb( VERB_CLOSE ); }
+
+//-------------------------------------------------------------------------------------------------
+//      パスを空にします.
+//-------------------------------------------------------------------------------------------------
+void Path::Clear()
+{
+    m_Verbs .clear();
+    m_Points.clear();
+    m_Hash = FNV_OFFSET_BASIS;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パスが空かどうかチェックします.
+//-------------------------------------------------------------------------------------------------
+bool Path::IsEmpty() const
+{ return m_Verbs.empty(); }
+
+//-------------------------------------------------------------------------------------------------
+//      形状のハッシュ値を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t Path::GetHash() const
+{ return m_Hash; }
+
+//-------------------------------------------------------------------------------------------------
+//      コマンド列を取得します.
+//-------------------------------------------------------------------------------------------------
+const std::vector<uint8_t>& Path::GetVerbs() const
+{ return m_Verbs; }
+
+//-------------------------------------------------------------------------------------------------
+//      座標列を取得します.
+//-------------------------------------------------------------------------------------------------
+const std::vector<float>& Path::GetPoints() const
+{ return m_Points; }
+
+//-------------------------------------------------------------------------------------------------
+//      コマンドを追加します.
+//-------------------------------------------------------------------------------------------------
+void Path::AddVerb( VERB verb )
+{
+    const uint8_t value = uint8_t( verb );
+    m_Verbs.push_back( value );
+    m_Hash = HashBytes( m_Hash, &value, sizeof(value) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      座標を追加します.
+//-------------------------------------------------------------------------------------------------
+void Path::AddPoint( float x, float y )
+{
+    m_Points.push_back( x );
+    m_Points.push_back( y );
+    m_Hash = HashBytes( m_Hash, &x, sizeof(x) );
+    m_Hash = HashBytes( m_Hash, &y, sizeof(y) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Tessellator class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+Tessellator::Tessellator()
+: m_Tolerance( 0.25f )
+, m_pOutput  ( nullptr )
+{
+    for( int i = 0; i < 4; ++i )
+    { m_Color[i] = 1.0f; }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      曲線近似の許容誤差をデバイスピクセル単位で設定します.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::SetTolerance( float pixels )
+{ m_Tolerance = ( pixels > 0.01f ) ? pixels : 0.01f; }
+
+//-------------------------------------------------------------------------------------------------
+//      曲線近似の許容誤差を取得します.
+//-------------------------------------------------------------------------------------------------
+float Tessellator::GetTolerance() const
+{ return m_Tolerance; }
+
+//-------------------------------------------------------------------------------------------------
+//      塗りつぶしの三角形リストを生成し, vertices の末尾に追加します.
+//      scale はパス座標1単位あたりのデバイスピクセル数で, 曲線の分割数の決定に使います.
+//      走査線スイープで台形に分割し, 同じ辺の組が続く間は1つの台形にまとめます.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::Fill
+(
+    const Path&                 path,
+    FILL_RULE                   rule,
+    float                       scale,
+    const float                 color[4],
+    std::vector<MeshVertex>&    vertices
+)
+{
+    const float tolerance = m_Tolerance / ( ( scale > 0.0f ) ? scale : 1.0f );
+    Flatten( path, tolerance );
+
+    m_pOutput = &vertices;
+    memcpy( m_Color, color, sizeof(m_Color) );
+
+    // 輪郭を辺に分解. 水平な辺は塗りつぶしに寄与しない.
+    m_Edges .clear();
+    m_SweepY.clear();
+    for( size_t c = 0; c < m_Contours.size(); ++c )
+    {
+        const Contour& contour = m_Contours[c];
+        for( size_t i = contour.Begin; i < contour.End; ++i )
+        {
+            const Point& a = m_Points[i];
+            const Point& b = m_Points[ ( i + 1 < contour.End ) ? i + 1 : contour.Begin ];
+            if ( a.Y == b.Y )
+            { continue; }
+
+            const bool down = ( a.Y < b.Y );
+            const Point& top    = down ? a : b;
+            const Point& bottom = down ? b : a;
+
+            Edge edge;
+            edge.X0      = top.X;
+            edge.Y0      = top.Y;
+            edge.Y1      = bottom.Y;
+            edge.DxDy    = ( bottom.X - top.X ) / ( bottom.Y - top.Y );
+            edge.Winding = down ? 1 : -1;
+            m_Edges.push_back( edge );
+
+            m_SweepY.push_back( edge.Y0 );
+            m_SweepY.push_back( edge.Y1 );
+        }
+    }
+
+    if ( m_Edges.empty() )
+    { return; }
+
+    std::sort( m_SweepY.begin(), m_SweepY.end() );
+    m_SweepY.erase( std::unique( m_SweepY.begin(), m_SweepY.end() ), m_SweepY.end() );
+
+    m_EdgeOrder.resize( m_Edges.size() );
+    for( size_t i = 0; i < m_EdgeOrder.size(); ++i )
+    { m_EdgeOrder[i] = uint32_t( i ); }
+
+    const std::vector<Edge>& edges = m_Edges;
+    std::sort( m_EdgeOrder.begin(), m_EdgeOrder.end(),
+        [&edges]( uint32_t a, uint32_t b ) { return edges[a].Y0 < edges[b].Y0; } );
+
+    m_Active.clear();
+    m_Open  .clear();
+    m_OpenIndex.assign( m_Edges.size(), -1 );
+
+    // 交差判定で進めるスラブ高さの下限.
+    const float minStep = tolerance * 1e-3f;
+
+    size_t next = 0;
+    for( size_t k = 0; k + 1 < m_SweepY.size(); ++k )
+    {
+        float       yTop    = m_SweepY[k];
+        const float yBottom = m_SweepY[k + 1];
+
+        // 通過済みの辺を外し, 新しく始まる辺を加える.
+        size_t count = 0;
+        for( size_t i = 0; i < m_Active.size(); ++i )
+        {
+            if ( m_Edges[ m_Active[i].Index ].Y1 > yTop )
+            { m_Active[count++] = m_Active[i]; }
+        }
+        m_Active.resize( count );
+
+        while( next < m_EdgeOrder.size() && m_Edges[ m_EdgeOrder[next] ].Y0 <= yTop )
+        {
+            ActiveEdge active = { m_EdgeOrder[next++], 0.0f, 0.0f };
+            m_Active.push_back( active );
+        }
+
+        // スラブ内で辺が交差する場合は交点で分割する.
+        while( yTop < yBottom )
+        {
+            for( size_t i = 0; i < m_Active.size(); ++i )
+            {
+                const Edge& edge = m_Edges[ m_Active[i].Index ];
+                m_Active[i].XTop    = edge.X0 + ( yTop    - edge.Y0 ) * edge.DxDy;
+                m_Active[i].XBottom = edge.X0 + ( yBottom - edge.Y0 ) * edge.DxDy;
+            }
+
+            std::sort( m_Active.begin(), m_Active.end(),
+                []( const ActiveEdge& a, const ActiveEdge& b )
+                { return ( a.XTop < b.XTop ) || ( a.XTop == b.XTop && a.XBottom < b.XBottom ); } );
+
+            // 最初の交差は上端で隣接する辺の組で起きる.
+            float ySplit = yBottom;
+            for( size_t i = 0; i + 1 < m_Active.size(); ++i )
+            {
+                const ActiveEdge& a = m_Active[i];
+                const ActiveEdge& b = m_Active[i + 1];
+                if ( a.XBottom <= b.XBottom )
+                { continue; }
+
+                const float dxTop    = b.XTop - a.XTop;
+                const float dxBottom = a.XBottom - b.XBottom;
+                const float y = yTop + ( yBottom - yTop ) * dxTop / ( dxTop + dxBottom );
+                if ( y < ySplit )
+                { ySplit = y; }
+            }
+
+            if ( ySplit < yTop + minStep )
+            { ySplit = std::min( yTop + minStep, yBottom ); }
+
+            SweepSlab( rule, yTop );
+            yTop = ySplit;
+        }
+    }
+
+    FlushSpans( m_SweepY.back() );
+    m_pOutput = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      線の三角形リストを生成し, vertices の末尾に追加します.
+//      結合部は線分の四角形に重ねて描くので, 半透明色では重なりが濃くなります.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::Stroke
+(
+    const Path&                 path,
+    const StrokeStyle&          style,
+    float                       scale,
+    const float                 color[4],
+    std::vector<MeshVertex>&    vertices
+)
+{
+    const float tolerance = m_Tolerance / ( ( scale > 0.0f ) ? scale : 1.0f );
+    const float halfWidth = style.Width * 0.5f;
+    if ( !( halfWidth > 0.0f ) )
+    { return; }
+
+    Flatten( path, tolerance );
+
+    m_pOutput = &vertices;
+    memcpy( m_Color, color, sizeof(m_Color) );
+
+    for( size_t c = 0; c < m_Contours.size(); ++c )
+    {
+        const Contour& contour = m_Contours[c];
+        const Point*   pts     = &m_Points[ contour.Begin ];
+        const size_t   count   = contour.End - contour.Begin;
+
+        // 点1つの場合は端点の形状だけを描く.
+        if ( count == 1 )
+        {
+            if ( style.Cap == LINE_CAP_ROUND )
+            { EmitArc( pts[0], halfWidth, 0.0f, 2.0f * PI, tolerance ); }
+            else if ( style.Cap == LINE_CAP_SQUARE )
+            {
+                const float x0 = pts[0].X - halfWidth, x1 = pts[0].X + halfWidth;
+                const float y0 = pts[0].Y - halfWidth, y1 = pts[0].Y + halfWidth;
+                EmitTriangle( x0, y0, x1, y0, x1, y1 );
+                EmitTriangle( x0, y0, x1, y1, x0, y1 );
+            }
+            continue;
+        }
+
+        const bool   closed       = contour.Closed && count >= 3;
+        const size_t segmentCount = closed ? count : count - 1;
+
+        // 線分の方向と四角形.
+        m_Directions.resize( segmentCount );
+        for( size_t i = 0; i < segmentCount; ++i )
+        {
+            const Point& a = pts[i];
+            const Point& b = pts[ ( i + 1 < count ) ? i + 1 : 0 ];
+
+            float dx = b.X - a.X;
+            float dy = b.Y - a.Y;
+            const float length = std::sqrt( dx * dx + dy * dy );
+            dx /= length;
+            dy /= length;
+
+            m_Directions[i].X = dx;
+            m_Directions[i].Y = dy;
+
+            const float nx = -dy * halfWidth;
+            const float ny =  dx * halfWidth;
+            EmitTriangle( a.X + nx, a.Y + ny, b.X + nx, b.Y + ny, b.X - nx, b.Y - ny );
+            EmitTriangle( a.X + nx, a.Y + ny, b.X - nx, b.Y - ny, a.X - nx, a.Y - ny );
+        }
+
+        // 結合部と端点.
+        if ( closed )
+        {
+            for( size_t i = 0; i < count; ++i )
+            { EmitJoin( style, pts[i], m_Directions[ ( i > 0 ) ? i - 1 : count - 1 ], m_Directions[i], halfWidth, tolerance ); }
+        }
+        else
+        {
+            for( size_t i = 1; i + 1 < count; ++i )
+            { EmitJoin( style, pts[i], m_Directions[i - 1], m_Directions[i], halfWidth, tolerance ); }
+
+            const Point start = { -m_Directions[0].X, -m_Directions[0].Y };
+            EmitCap( style, pts[0], start, halfWidth, tolerance );
+            EmitCap( style, pts[count - 1], m_Directions[count - 2], halfWidth, tolerance );
+        }
+    }
+
+    m_pOutput = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      パスを折れ線の輪郭に変換します. tolerance はパス座標単位です.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::Flatten( const Path& path, float tolerance )
+{
+    m_Points  .clear();
+    m_Contours.clear();
+
+    const std::vector<uint8_t>& verbs  = path.GetVerbs();
+    const std::vector<float>&   coords = path.GetPoints();
+
+    Point  start = { 0.0f, 0.0f };
+    Point  last  = { 0.0f, 0.0f };
+    size_t begin = 0;
+    bool   open  = false;
+    size_t p     = 0;
+
+    // 連続する重複点を除いて追加.
+    auto addPoint = [&]( float x, float y )
+    {
+        if ( !open )
+        {
+            begin = m_Points.size();
+            m_Points.push_back( last );
+            open = true;
+        }
+
+        const Point& prev = m_Points.back();
+        if ( prev.X != x || prev.Y != y )
+        {
+            Point pt = { x, y };
+            m_Points.push_back( pt );
+        }
+        last.X = x;
+        last.Y = y;
+    };
+
+    auto endContour = [&]( bool closed )
+    {
+        if ( !open )
+        { return; }
+
+        // 閉じた輪郭の終点が始点と重なる場合は除く.
+        if ( closed && m_Points.size() - begin > 1 )
+        {
+            const Point& first = m_Points[begin];
+            const Point& back  = m_Points.back();
+            if ( first.X == back.X && first.Y == back.Y )
+            { m_Points.pop_back(); }
+        }
+
+        Contour contour = { begin, m_Points.size(), closed };
+        m_Contours.push_back( contour );
+        open = false;
+    };
+
+    for( size_t v = 0; v < verbs.size(); ++v )
+    {
+        switch( verbs[v] )
+        {
+            case Path::VERB_MOVE:
+                {
+                    endContour( false );
+                    start.X = last.X = coords[p + 0];
+                    start.Y = last.Y = coords[p + 1];
+                    p += 2;
+
+                    begin = m_Points.size();
+                    m_Points.push_back( start );
+                    open = true;
+                }
+                break;
+
+            case Path::VERB_LINE:
+                {
+                    addPoint( coords[p + 0], coords[p + 1] );
+                    p += 2;
+                }
+                break;
+
+            case Path::VERB_QUAD:
+                {
+                    const float x0 = last.X,        y0 = last.Y;
+                    const float x1 = coords[p + 0], y1 = coords[p + 1];
+                    const float x2 = coords[p + 2], y2 = coords[p + 3];
+                    p += 4;
+
+                    const float ddx = x0 - 2.0f * x1 + x2;
+                    const float ddy = y0 - 2.0f * y1 + y2;
+                    const int   n   = CurveSegments( std::sqrt( ddx * ddx + ddy * ddy ), 0.25f, tolerance );
+
+                    for( int i = 1; i < n; ++i )
+                    {
+                        const float t = float( i ) / float( n );
+                        const float s = 1.0f - t;
+                        addPoint( s * s * x0 + 2.0f * s * t * x1 + t * t * x2,
+                                  s * s * y0 + 2.0f * s * t * y1 + t * t * y2 );
+                    }
+                    addPoint( x2, y2 );
+                }
+                break;
+
+            case Path::VERB_CUBIC:
+                {
+                    const float x0 = last.X,        y0 = last.Y;
+                    const float x1 = coords[p + 0], y1 = coords[p + 1];
+                    const float x2 = coords[p + 2], y2 = coords[p + 3];
+                    const float x3 = coords[p + 4], y3 = coords[p + 5];
+                    p += 6;
+
+                    const float ddx0 = x0 - 2.0f * x1 + x2, ddy0 = y0 - 2.0f * y1 + y2;
+                    const float ddx1 = x1 - 2.0f * x2 + x3, ddy1 = y1 - 2.0f * y2 + y3;
+                    const float dd   = std::max( ddx0 * ddx0 + ddy0 * ddy0, ddx1 * ddx1 + ddy1 * ddy1 );
+                    const int   n    = CurveSegments( std::sqrt( dd ), 0.75f, tolerance );
+
+                    for( int i = 1; i < n; ++i )
+                    {
+                        const float t  = float( i ) / float( n );
+                        const float s  = 1.0f - t;
+                        const float b0 = s * s * s;
+                        const float b1 = 3.0f * s * s * t;
+                        const float b2 = 3.0f * s * t * t;
+                        const float b3 = t * t * t;
+                        addPoint( b0 * x0 + b1 * x1 + b2 * x2 + b3 * x3,
+                                  b0 * y0 + b1 * y1 + b2 * y2 + b3 * y3 );
+                    }
+                    addPoint( x3, y3 );
+                }
+                break;
+
+            case Path::VERB_CLOSE:
+                {
+                    endContour( true );
+                    last = start;
+                }
+                break;
+
+            default:
+                { /* DO_NOTHING */ }
+                break;
+        }
+    }
+
+    endContour( false );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      交差のないスラブ内で塗りつぶす区間を求め, 前のスラブから続く台形を延長します.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::SweepSlab( FILL_RULE rule, float yTop )
+{
+    m_NextOpen.clear();
+
+    int winding = 0;
+    for( size_t i = 0; i + 1 < m_Active.size(); ++i )
+    {
+        winding += m_Edges[ m_Active[i].Index ].Winding;
+
+        const bool inside = ( rule == FILL_RULE_EVEN_ODD ) ? ( ( winding & 1 ) != 0 ) : ( winding != 0 );
+        if ( !inside )
+        { continue; }
+
+        const uint32_t left  = m_Active[i    ].Index;
+        const uint32_t right = m_Active[i + 1].Index;
+
+        // 隣り合う区間は1つにまとめる.
+        if ( !m_NextOpen.empty() && m_NextOpen.back().Right == left )
+        {
+            m_NextOpen.back().Right = right;
+            continue;
+        }
+
+        Span span = { left, right, yTop };
+        m_NextOpen.push_back( span );
+    }
+
+    // 同じ辺の組が続いていれば開始位置を引き継ぐ.
+    for( size_t i = 0; i < m_NextOpen.size(); ++i )
+    {
+        Span& span = m_NextOpen[i];
+        const int32_t index = m_OpenIndex[ span.Left ];
+        if ( index >= 0 && m_Open[index].Right == span.Right )
+        {
+            span.YStart = m_Open[index].YStart;
+            m_Open[index].Right = UINT32_MAX;
+        }
+    }
+
+    for( size_t i = 0; i < m_Open.size(); ++i )
+    {
+        if ( m_Open[i].Right != UINT32_MAX )
+        { EmitTrapezoid( m_Open[i], yTop ); }
+        m_OpenIndex[ m_Open[i].Left ] = -1;
+    }
+
+    m_Open.swap( m_NextOpen );
+    for( size_t i = 0; i < m_Open.size(); ++i )
+    { m_OpenIndex[ m_Open[i].Left ] = int32_t( i ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      延長中の台形をすべて出力します.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::FlushSpans( float y )
+{
+    for( size_t i = 0; i < m_Open.size(); ++i )
+    {
+        EmitTrapezoid( m_Open[i], y );
+        m_OpenIndex[ m_Open[i].Left ] = -1;
+    }
+    m_Open.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2辺に挟まれた台形を三角形2つとして出力します.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::EmitTrapezoid( const Span& span, float yEnd )
+{
+    if ( !( yEnd > span.YStart ) )
+    { return; }
+
+    const Edge& l = m_Edges[ span.Left  ];
+    const Edge& r = m_Edges[ span.Right ];
+
+    const float y0  = span.YStart;
+    const float y1  = yEnd;
+    const float xl0 = l.X0 + ( y0 - l.Y0 ) * l.DxDy;
+    const float xr0 = r.X0 + ( y0 - r.Y0 ) * r.DxDy;
+    const float xl1 = l.X0 + ( y1 - l.Y0 ) * l.DxDy;
+    const float xr1 = r.X0 + ( y1 - r.Y0 ) * r.DxDy;
+
+    EmitTriangle( xl0, y0, xr0, y0, xr1, y1 );
+    EmitTriangle( xl0, y0, xr1, y1, xl1, y1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      三角形を出力します. 面積0のものは捨て, 向きは既存の頂点データに合わせて
+//      Y軸上向きの座標系で時計回りに揃えます (既定のカリング設定で表面になります).
+//-------------------------------------------------------------------------------------------------
+void Tessellator::EmitTriangle( float x0, float y0, float x1, float y1, float x2, float y2 )
+{
+    const float area = ( x1 - x0 ) * ( y2 - y0 ) - ( x2 - x0 ) * ( y1 - y0 );
+    if ( area == 0.0f )
+    { return; }
+
+    if ( area > 0.0f )
+    {
+        std::swap( x1, x2 );
+        std::swap( y1, y2 );
+    }
+
+    const float xs[3] = { x0, x1, x2 };
+    const float ys[3] = { y0, y1, y2 };
+    for( int i = 0; i < 3; ++i )
+    {
+        MeshVertex vertex;
+        vertex.Position[0] = xs[i];
+        vertex.Position[1] = ys[i];
+        vertex.Position[2] = 0.0f;
+        memcpy( vertex.Color, m_Color, sizeof(m_Color) );
+        m_pOutput->push_back( vertex );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      線分の結合部を出力します. d0 は入ってくる方向, d1 は出ていく方向です.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::EmitJoin
+(
+    const StrokeStyle&  style,
+    const Point&        p,
+    const Point&        d0,
+    const Point&        d1,
+    float               halfWidth,
+    float               tolerance
+)
+{
+    const float cross = d0.X * d1.Y - d0.Y * d1.X;
+    const float dot   = d0.X * d1.X + d0.Y * d1.Y;
+    if ( std::fabs( cross ) < 1e-6f && dot > 0.0f )
+    { return; }
+
+    // 曲がる向きと反対側に隙間ができる.
+    const float side = ( cross > 0.0f ) ? -halfWidth : halfWidth;
+    const float n0x = -d0.Y * side, n0y = d0.X * side;
+    const float n1x = -d1.Y * side, n1y = d1.X * side;
+
+    if ( style.Join == LINE_JOIN_ROUND )
+    {
+        const float start = std::atan2( n0y, n0x );
+        const float sweep = std::atan2( n0x * n1y - n0y * n1x, n0x * n1x + n0y * n1y );
+        EmitArc( p, halfWidth, start, sweep, tolerance );
+        return;
+    }
+
+    EmitTriangle( p.X, p.Y, p.X + n0x, p.Y + n0y, p.X + n1x, p.Y + n1y );
+
+    if ( style.Join == LINE_JOIN_MITER )
+    {
+        // マイター長 / 線幅 = 1 / cos(θ/2).
+        const float cosHalf = std::sqrt( std::max( 0.0f, ( 1.0f + dot ) * 0.5f ) );
+        if ( cosHalf > 1e-4f && 1.0f / cosHalf <= style.MiterLimit )
+        {
+            float mx = n0x + n1x;
+            float my = n0y + n1y;
+            const float length = std::sqrt( mx * mx + my * my );
+            const float scale  = halfWidth / ( cosHalf * length );
+            mx *= scale;
+            my *= scale;
+
+            EmitTriangle( p.X + n0x, p.Y + n0y, p.X + mx, p.Y + my, p.X + n1x, p.Y + n1y );
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      開いた輪郭の端点を出力します. d は外向きの方向です.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::EmitCap
+(
+    const StrokeStyle&  style,
+    const Point&        p,
+    const Point&        d,
+    float               halfWidth,
+    float               tolerance
+)
+{
+    const float nx = -d.Y * halfWidth;
+    const float ny =  d.X * halfWidth;
+
+    if ( style.Cap == LINE_CAP_SQUARE )
+    {
+        const float ex = d.X * halfWidth;
+        const float ey = d.Y * halfWidth;
+        EmitTriangle( p.X + nx, p.Y + ny, p.X + nx + ex, p.Y + ny + ey, p.X - nx + ex, p.Y - ny + ey );
+        EmitTriangle( p.X + nx, p.Y + ny, p.X - nx + ex, p.Y - ny + ey, p.X - nx, p.Y - ny );
+    }
+    else if ( style.Cap == LINE_CAP_ROUND )
+    {
+        // 法線から外向き方向を通って反対側の法線まで回る.
+        EmitArc( p, halfWidth, std::atan2( ny, nx ), -PI, tolerance );
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      中心から扇形に円弧を出力します.
+//-------------------------------------------------------------------------------------------------
+void Tessellator::EmitArc
+(
+    const Point&    center,
+    float           radius,
+    float           startAngle,
+    float           sweepAngle,
+    float           tolerance
+)
+{
+    // 弦の誤差が許容誤差に収まる角度刻み.
+    const float ratio = 1.0f - tolerance / radius;
+    const float step  = ( ratio > -1.0f ) ? 2.0f * std::acos( ratio ) : PI;
+
+    int count = int( std::ceil( std::fabs( sweepAngle ) / std::max( step, 1e-3f ) ) );
+    count = std::max( 1, std::min( count, MAX_ARC_SEGMENTS ) );
+
+    float px = center.X + radius * std::cos( startAngle );
+    float py = center.Y + radius * std::sin( startAngle );
+    for( int i = 1; i <= count; ++i )
+    {
+        const float angle = startAngle + sweepAngle * float( i ) / float( count );
+        const float x = center.X + radius * std::cos( angle );
+        const float y = center.Y + radius * std::sin( angle );
+        EmitTriangle( center.X, center.Y, px, py, x, y );
+        px = x;
+        py = y;
+    }
+}
@@ -0,0 +1,478 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextBuffer.cpp
+// Desc : Piece Table Text Buffer with Sparse Line Index.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <TextBuffer.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextBuffer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextBuffer::TextBuffer()
+: m_ChangedLine( NoChange )
+{
+    Term();
+    ClearChangedLine();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextBuffer::~TextBuffer()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      ファイルをメモリマップして開きます. ファイルの内容は読み取り専用の元の文字列として参照し,
+//      編集は追記バッファとピースの付け替えだけで行います.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::Open( const char* path )
+{
+    Term();
+
+    if ( !m_File.Open( path ) )
+    {
+        ELOG( "Error : MappedFile::Open() Failed." );
+        return false;
+    }
+
+    Source& source = m_Sources[SOURCE_ORIGINAL];
+    source.pData = reinterpret_cast<const char*>( m_File.GetData() );
+    source.Size  = m_File.GetSize();
+    IndexSource( source, 0 );
+
+    if ( source.Size > 0 )
+    {
+        Piece piece;
+        piece.Source    = SOURCE_ORIGINAL;
+        piece.Start     = 0;
+        piece.Length    = source.Size;
+        piece.LineFeeds = source.LineFeeds;
+        m_Pieces.push_back( piece );
+    }
+    UpdatePrefix( 0 );
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文字列をコピーして初期化します.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::Init( const char* pText, size_t length )
+{
+    Term();
+
+    if ( pText == nullptr && length > 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_Original.assign( pText, pText + length );
+
+    Source& source = m_Sources[SOURCE_ORIGINAL];
+    source.pData = m_Original.empty() ? nullptr : &m_Original[0];
+    source.Size  = m_Original.size();
+    IndexSource( source, 0 );
+
+    if ( source.Size > 0 )
+    {
+        Piece piece;
+        piece.Source    = SOURCE_ORIGINAL;
+        piece.Start     = 0;
+        piece.Length    = source.Size;
+        piece.LineFeeds = source.LineFeeds;
+        m_Pieces.push_back( piece );
+    }
+    UpdatePrefix( 0 );
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void TextBuffer::Term()
+{
+    m_File.Close();
+    std::vector<char>    ().swap( m_Original );
+    std::vector<char>    ().swap( m_Added );
+    std::vector<Piece>   ().swap( m_Pieces );
+
+    for( uint32_t i = 0; i < SOURCE_COUNT; ++i )
+    {
+        m_Sources[i].pData     = nullptr;
+        m_Sources[i].Size      = 0;
+        m_Sources[i].LineFeeds = 0;
+        std::vector<uint64_t>( 1, 0 ).swap( m_Sources[i].Marks );
+    }
+
+    UpdatePrefix( 0 );
+    m_ChangedLine = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書内の位置に文字列を挿入します. 文字列は追記バッファの末尾に追加し, 直前のピースが
+//      追記バッファの末尾を参照している場合 (末尾への連続した追記など) はそのピースを伸ばします.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::Insert( uint64_t offset, const char* pText, size_t length )
+{
+    if ( offset > GetLength() || ( pText == nullptr && length > 0 ) )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    if ( length == 0 )
+    { return true; }
+
+    MarkChanged( offset );
+
+    // 追記バッファに追加して, 改行を索引付けする.
+    Source&        source = m_Sources[SOURCE_ADDED];
+    const uint64_t start  = source.Size;
+    const uint64_t before = source.LineFeeds;
+    m_Added.insert( m_Added.end(), pText, pText + length );
+    source.pData = &m_Added[0];
+    source.Size  = m_Added.size();
+    IndexSource( source, start );
+
+    const uint64_t lineFeeds = source.LineFeeds - before;
+
+    // 直前のピースを伸ばせるか.
+    if ( offset > 0 )
+    {
+        const size_t index = FindPiece( offset - 1 );
+        Piece&       prev  = m_Pieces[index];
+        if ( m_PieceOffsets[index] + prev.Length == offset
+          && prev.Source == SOURCE_ADDED
+          && prev.Start + prev.Length == start )
+        {
+            prev.Length    += length;
+            prev.LineFeeds += lineFeeds;
+            UpdatePrefix( index );
+            return true;
+        }
+    }
+
+    Piece piece;
+    piece.Source    = SOURCE_ADDED;
+    piece.Start     = start;
+    piece.Length    = length;
+    piece.LineFeeds = lineFeeds;
+
+    const size_t index = SplitPiece( offset );
+    m_Pieces.insert( m_Pieces.begin() + index, piece );
+    UpdatePrefix( index );
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書内の範囲を削除します. 元の文字列と追記バッファは変更せず, ピースだけを取り除きます.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::Erase( uint64_t offset, uint64_t length )
+{
+    const uint64_t total = GetLength();
+    if ( offset > total )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    length = std::min( length, total - offset );
+    if ( length == 0 )
+    { return true; }
+
+    MarkChanged( offset );
+
+    // 先頭側で分割されたピースの分だけ終端の番号がずれる.
+    size_t       last  = SplitPiece( offset + length );
+    const size_t count = m_Pieces.size();
+    const size_t first = SplitPiece( offset );
+    last += m_Pieces.size() - count;
+    m_Pieces.erase( m_Pieces.begin() + first, m_Pieces.begin() + last );
+    UpdatePrefix( first );
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書の末尾に文字列を追加します.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::Append( const char* pText, size_t length )
+{ return Insert( GetLength(), pText, length ); }
+
+//-------------------------------------------------------------------------------------------------
+//      文書のバイト数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::GetLength() const
+{ return m_PieceOffsets.back(); }
+
+//-------------------------------------------------------------------------------------------------
+//      行数を取得します. 改行で終わる文書は末尾に空の行を持ちます.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::GetLineCount() const
+{ return m_PieceLines.back() + 1; }
+
+//-------------------------------------------------------------------------------------------------
+//      行の先頭の文書内の位置を取得します. 行に含まれる改行を持つピースを二分探索し,
+//      ピースの中は参照先の文字列の行インデックスで求めます.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::GetLineStart( uint64_t line ) const
+{
+    if ( line == 0 )
+    { return 0; }
+
+    if ( line >= GetLineCount() )
+    { return GetLength(); }
+
+    // line 番目の改行を含むピース.
+    const size_t index = size_t( std::lower_bound( m_PieceLines.begin() + 1, m_PieceLines.end(), line ) - m_PieceLines.begin() ) - 1;
+    const Piece&  piece  = m_Pieces[index];
+    const Source& source = m_Sources[piece.Source];
+
+    const uint64_t pos = FindLineFeed( source, CountLineFeeds( source, piece.Start ) + ( line - m_PieceLines[index] ) );
+    return m_PieceOffsets[index] + ( pos - piece.Start );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書内の位置を含む行の番号を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::GetLineOfOffset( uint64_t offset ) const
+{
+    if ( offset >= GetLength() )
+    { return m_PieceLines.back(); }
+
+    const size_t   index  = FindPiece( offset );
+    const Piece&   piece  = m_Pieces[index];
+    const Source&  source = m_Sources[piece.Source];
+    const uint64_t pos    = piece.Start + ( offset - m_PieceOffsets[index] );
+
+    return m_PieceLines[index] + CountLineFeeds( source, pos ) - CountLineFeeds( source, piece.Start );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      行の文字列を取得します. 改行 (CR LF を含みます) は含まず, 先頭の maxBytes バイトまでで打ち切ります.
+//-------------------------------------------------------------------------------------------------
+bool TextBuffer::GetLine( uint64_t line, std::string& result, size_t maxBytes ) const
+{
+    result.clear();
+
+    if ( line >= GetLineCount() )
+    { return false; }
+
+    uint64_t offset = GetLineStart( line );
+    if ( offset >= GetLength() )
+    { return true; }
+
+    // 改行が見つかるか上限に達するまでピースをたどる.
+    size_t index = FindPiece( offset );
+    bool   found = false;
+    while( index < m_Pieces.size() && !found && result.size() < maxBytes )
+    {
+        const Piece&   piece  = m_Pieces[index];
+        const char*    pBegin = m_Sources[piece.Source].pData + piece.Start + ( offset - m_PieceOffsets[index] );
+        const uint64_t rest   = piece.Length - ( offset - m_PieceOffsets[index] );
+        const size_t   count  = size_t( std::min<uint64_t>( rest, maxBytes - result.size() ) );
+
+        const char* pEnd = static_cast<const char*>( memchr( pBegin, '\n', count ) );
+        if ( pEnd != nullptr )
+        { found = true; }
+        else
+        { pEnd = pBegin + count; }
+
+        result.append( pBegin, pEnd );
+
+        index++;
+        offset = m_PieceOffsets[index];
+    }
+
+    if ( found && !result.empty() && result[result.size() - 1] == '\r' )
+    { result.resize( result.size() - 1 ); }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ピース数を取得します.
+//-------------------------------------------------------------------------------------------------
+size_t TextBuffer::GetPieceCount() const
+{ return m_Pieces.size(); }
+
+//-------------------------------------------------------------------------------------------------
+//      ヒープの使用量を取得します. メモリマップしたファイルは含みません.
+//-------------------------------------------------------------------------------------------------
+size_t TextBuffer::GetMemoryUsage() const
+{
+    size_t bytes = m_Original.capacity()
+        + m_Added       .capacity()
+        + m_Pieces      .capacity() * sizeof(Piece)
+        + m_PieceOffsets.capacity() * sizeof(uint64_t)
+        + m_PieceLines  .capacity() * sizeof(uint64_t);
+
+    for( uint32_t i = 0; i < SOURCE_COUNT; ++i )
+    { bytes += m_Sources[i].Marks.capacity() * sizeof(uint64_t); }
+
+    return bytes;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      最後に ClearChangedLine() を呼んでから変更された最初の行を取得します.
+//      変更が無い場合は NoChange を返します.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::GetChangedLine() const
+{ return m_ChangedLine; }
+
+//-------------------------------------------------------------------------------------------------
+//      変更された行の記録を消去します.
+//-------------------------------------------------------------------------------------------------
+void TextBuffer::ClearChangedLine()
+{ m_ChangedLine = NoChange; }
+
+//-------------------------------------------------------------------------------------------------
+//      文字列の from 以降の改行を数えて, LineIndexStride 個ごとに改行の直後の位置を記録します.
+//-------------------------------------------------------------------------------------------------
+void TextBuffer::IndexSource( Source& source, uint64_t from )
+{
+    const char* pData = source.pData;
+    uint64_t    pos   = from;
+    while( pos < source.Size )
+    {
+        const char* pFound = static_cast<const char*>( memchr( pData + pos, '\n', size_t( source.Size - pos ) ) );
+        if ( pFound == nullptr )
+        { break; }
+
+        pos = uint64_t( pFound - pData ) + 1;
+        source.LineFeeds++;
+
+        if ( source.LineFeeds % LineIndexStride == 0 )
+        { source.Marks.push_back( pos ); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文字列の先頭から pos までにある改行の数を求めます. 直前の記録位置から数えるので,
+//      走査するのは高々 LineIndexStride 行です.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::CountLineFeeds( const Source& source, uint64_t pos ) const
+{
+    const size_t mark  = size_t( std::upper_bound( source.Marks.begin(), source.Marks.end(), pos ) - source.Marks.begin() ) - 1;
+    uint64_t     count = uint64_t( mark ) * LineIndexStride;
+    uint64_t     cur   = source.Marks[mark];
+
+    while( cur < pos )
+    {
+        const char* pFound = static_cast<const char*>( memchr( source.pData + cur, '\n', size_t( pos - cur ) ) );
+        if ( pFound == nullptr )
+        { break; }
+
+        cur = uint64_t( pFound - source.pData ) + 1;
+        count++;
+    }
+
+    return count;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文字列の index 番目 (1 始まり) の改行の直後の位置を求めます.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextBuffer::FindLineFeed( const Source& source, uint64_t index ) const
+{
+    const size_t mark = size_t( index / LineIndexStride );
+    uint64_t     pos  = source.Marks[mark];
+
+    for( uint64_t i = uint64_t( mark ) * LineIndexStride; i < index; ++i )
+    {
+        const char* pFound = static_cast<const char*>( memchr( source.pData + pos, '\n', size_t( source.Size - pos ) ) );
+        pos = uint64_t( pFound - source.pData ) + 1;
+    }
+
+    return pos;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書内の位置を含むピースの番号を二分探索します.
+//-------------------------------------------------------------------------------------------------
+size_t TextBuffer::FindPiece( uint64_t offset ) const
+{
+    return size_t( std::upper_bound( m_PieceOffsets.begin(), m_PieceOffsets.end() - 1, offset ) - m_PieceOffsets.begin() ) - 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文書内の位置でピースを分割し, その位置から始まるピースの番号を返します.
+//      末尾の場合はピース数を返します.
+//-------------------------------------------------------------------------------------------------
+size_t TextBuffer::SplitPiece( uint64_t offset )
+{
+    if ( offset >= GetLength() )
+    { return m_Pieces.size(); }
+
+    const size_t index = FindPiece( offset );
+    if ( m_PieceOffsets[index] == offset )
+    { return index; }
+
+    Piece&         left   = m_Pieces[index];
+    const Source&  source = m_Sources[left.Source];
+    const uint64_t length = offset - m_PieceOffsets[index];
+
+    Piece right;
+    right.Source    = left.Source;
+    right.Start     = left.Start + length;
+    right.Length    = left.Length - length;
+    right.LineFeeds = CountLineFeeds( source, left.Start + left.Length ) - CountLineFeeds( source, right.Start );
+
+    left.Length    = length;
+    left.LineFeeds = left.LineFeeds - right.LineFeeds;
+
+    // 分割位置より後ろの累積値は変わらない.
+    const uint64_t lines = m_PieceLines[index] + left.LineFeeds;
+    m_Pieces      .insert( m_Pieces.begin()       + ( index + 1 ), right );
+    m_PieceOffsets.insert( m_PieceOffsets.begin() + ( index + 1 ), offset );
+    m_PieceLines  .insert( m_PieceLines.begin()   + ( index + 1 ), lines );
+
+    return index + 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      first 番目以降のピースの累積位置と累積改行数を更新します.
+//-------------------------------------------------------------------------------------------------
+void TextBuffer::UpdatePrefix( size_t first )
+{
+    m_PieceOffsets.resize( m_Pieces.size() + 1 );
+    m_PieceLines  .resize( m_Pieces.size() + 1 );
+
+    if ( first == 0 )
+    {
+        m_PieceOffsets[0] = 0;
+        m_PieceLines  [0] = 0;
+    }
+
+    for( size_t i = first; i < m_Pieces.size(); ++i )
+    {
+        m_PieceOffsets[i + 1] = m_PieceOffsets[i] + m_Pieces[i].Length;
+        m_PieceLines  [i + 1] = m_PieceLines  [i] + m_Pieces[i].LineFeeds;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      変更前に呼び出して, 変更された最初の行を記録します.
+//-------------------------------------------------------------------------------------------------
+void TextBuffer::MarkChanged( uint64_t offset )
+{ m_ChangedLine = std::min( m_ChangedLine, GetLineOfOffset( offset ) ); }
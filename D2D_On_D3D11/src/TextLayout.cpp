@@ -0,0 +1,664 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextLayout.cpp
+// Desc : Incremental Paragraph Text Layout.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <TextLayout.h>
+#include <Logger.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint8_t   FLAG_SPACE          = 0x01;     // 行末にぶら下げる空白.
+const float     UNBOUNDED_WIDTH     = std::numeric_limits<float>::infinity();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BREAK_CLASS enum
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum BREAK_CLASS
+{
+    BREAK_CLASS_ALPHA = 0,      // 欧文などの単語の一部.
+    BREAK_CLASS_SPACE,          // 空白.
+    BREAK_CLASS_IDEOGRAPHIC,    // 漢字, かな, ハングルなど. 前後で改行できる.
+    BREAK_CLASS_CLOSE,          // 行頭禁則 (閉じ括弧, 句読点, 小書きかな, 長音など).
+    BREAK_CLASS_OPEN,           // 行末禁則 (開き括弧).
+    BREAK_CLASS_HYPHEN,         // ハイフン. 後ろに単語が続く場合は改行できる.
+    BREAK_CLASS_COMBINING,      // 結合文字. 前で改行しない.
+};
+
+// 行頭禁則の文字 (昇順).
+const uint32_t CLOSE_CHARS[] = {
+    0x0021, 0x0029, 0x002C, 0x002E, 0x003A, 0x003B, 0x003F, 0x005D, 0x007D,
+    0x2010, 0x2013, 0x2019, 0x201D, 0x2025, 0x2026,
+    0x3001, 0x3002, 0x3005, 0x3009, 0x300B, 0x300D, 0x300F, 0x3011, 0x3015, 0x3017, 0x3019, 0x301C, 0x303B,
+    0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3063, 0x3083, 0x3085, 0x3087, 0x308E, 0x3095, 0x3096,
+    0x309B, 0x309C, 0x309D, 0x309E,
+    0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30C3, 0x30E3, 0x30E5, 0x30E7, 0x30EE, 0x30F5, 0x30F6,
+    0x30FB, 0x30FC, 0x30FD, 0x30FE,
+    0xFF01, 0xFF09, 0xFF0C, 0xFF0E, 0xFF1A, 0xFF1B, 0xFF1F, 0xFF3D, 0xFF5D, 0xFF5E, 0xFF61, 0xFF63, 0xFF64, 0xFF70,
+};
+
+// 行末禁則の文字 (昇順).
+const uint32_t OPEN_CHARS[] = {
+    0x0028, 0x005B, 0x007B, 0x2018, 0x201C,
+    0x3008, 0x300A, 0x300C, 0x300E, 0x3010, 0x3014, 0x3016, 0x3018,
+    0xFF08, 0xFF3B, 0xFF5B, 0xFF62,
+};
+
+//-------------------------------------------------------------------------------------------------
+//      文字の改行クラスを求めます (UAX #14 と JIS X 4051 の禁則を簡略化したもの).
+//-------------------------------------------------------------------------------------------------
+BREAK_CLASS GetBreakClass( uint32_t c )
+{
+    const uint32_t* pCloseEnd = CLOSE_CHARS + sizeof(CLOSE_CHARS) / sizeof(CLOSE_CHARS[0]);
+    if ( std::binary_search( CLOSE_CHARS, pCloseEnd, c ) )
+    { return BREAK_CLASS_CLOSE; }
+
+    const uint32_t* pOpenEnd = OPEN_CHARS + sizeof(OPEN_CHARS) / sizeof(OPEN_CHARS[0]);
+    if ( std::binary_search( OPEN_CHARS, pOpenEnd, c ) )
+    { return BREAK_CLASS_OPEN; }
+
+    if ( c == 0x20 || c == 0x09 || ( 0x2000 <= c && c <= 0x200B && c != 0x2007 ) )
+    { return BREAK_CLASS_SPACE; }
+
+    if ( c == 0x2D )
+    { return BREAK_CLASS_HYPHEN; }
+
+    if ( ( 0x0300 <= c && c <= 0x036F )
+      || c == 0x200C || c == 0x200D
+      || c == 0x3099 || c == 0x309A
+      || ( 0xFE00 <= c && c <= 0xFE0F )
+      || ( 0x1F3FB <= c && c <= 0x1F3FF ) )
+    { return BREAK_CLASS_COMBINING; }
+
+    if ( ( 0x2E80  <= c && c <= 0x2FFF  )
+      || ( 0x3000  <= c && c <= 0x30FF  )
+      || ( 0x3100  <= c && c <= 0x31FF  )
+      || ( 0x3400  <= c && c <= 0x4DBF  )
+      || ( 0x4E00  <= c && c <= 0x9FFF  )
+      || ( 0xA000  <= c && c <= 0xA4CF  )
+      || ( 0xAC00  <= c && c <= 0xD7AF  )
+      || ( 0xF900  <= c && c <= 0xFAFF  )
+      || ( 0xFF01  <= c && c <= 0xFF60  )
+      || ( 0xFFE0  <= c && c <= 0xFFE6  )
+      || ( 0x1F300 <= c && c <= 0x1FAFF )
+      || ( 0x20000 <= c && c <= 0x3FFFF ) )
+    { return BREAK_CLASS_IDEOGRAPHIC; }
+
+    return BREAK_CLASS_ALPHA;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      2 つの文字の間で改行できるかどうかを判定します.
+//-------------------------------------------------------------------------------------------------
+bool CanBreakBetween( BREAK_CLASS prev, BREAK_CLASS next )
+{
+    // 空白の連続と結合文字の前, 行頭禁則文字の前, 行末禁則文字の後ろでは改行しない.
+    if ( next == BREAK_CLASS_SPACE || next == BREAK_CLASS_COMBINING || next == BREAK_CLASS_CLOSE )
+    { return false; }
+
+    if ( prev == BREAK_CLASS_OPEN )
+    { return false; }
+
+    if ( prev == BREAK_CLASS_SPACE || prev == BREAK_CLASS_IDEOGRAPHIC || next == BREAK_CLASS_IDEOGRAPHIC )
+    { return true; }
+
+    // 句読点や閉じ括弧の後ろ, ハイフンの後ろの単語の前.
+    return ( prev == BREAK_CLASS_CLOSE && next != BREAK_CLASS_ALPHA && next != BREAK_CLASS_HYPHEN )
+        || ( prev == BREAK_CLASS_HYPHEN && next == BREAK_CLASS_ALPHA );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      UTF-8 から 1 文字を取り出します. 不正なバイト列は U+FFFD とします.
+//-------------------------------------------------------------------------------------------------
+uint32_t DecodeUtf8( const uint8_t*& p, const uint8_t* pEnd )
+{
+    const uint32_t b0 = *p++;
+    if ( b0 < 0x80 )
+    { return b0; }
+
+    uint32_t count;
+    uint32_t c;
+    uint32_t minimum;
+    if      ( ( b0 & 0xE0 ) == 0xC0 ) { count = 1; c = b0 & 0x1F; minimum = 0x80; }
+    else if ( ( b0 & 0xF0 ) == 0xE0 ) { count = 2; c = b0 & 0x0F; minimum = 0x800; }
+    else if ( ( b0 & 0xF8 ) == 0xF0 ) { count = 3; c = b0 & 0x07; minimum = 0x10000; }
+    else
+    { return 0xFFFD; }
+
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        if ( p >= pEnd || ( *p & 0xC0 ) != 0x80 )
+        { return 0xFFFD; }
+        c = ( c << 6 ) | ( *p++ & 0x3F );
+    }
+
+    if ( c < minimum || c > 0x10FFFF || ( 0xD800 <= c && c <= 0xDFFF ) )
+    { return 0xFFFD; }
+
+    return c;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextLayout class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextLayout::TextLayout()
+: m_pFace       ( nullptr )
+, m_FontSize    ( 0.0f )
+, m_Scale       ( 0.0f )
+, m_LineHeight  ( 0.0f )
+, m_Ascent      ( 0.0f )
+, m_MaxWidth    ( FLT_MAX )
+, m_Alignment   ( TEXT_ALIGNMENT_LEADING )
+, m_LineCount   ( 0 )
+, m_Invalid     ( false )
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextLayout::~TextLayout()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. フォントフェイスは呼び出し側が保持します.
+//-------------------------------------------------------------------------------------------------
+bool TextLayout::Init( const FontFace* pFace, float fontSize )
+{
+    Term();
+
+    if ( pFace == nullptr || !pFace->IsValid() || !( fontSize > 0.0f ) )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const FontMetrics metrics = pFace->GetMetrics();
+
+    m_pFace      = pFace;
+    m_FontSize   = fontSize;
+    m_Scale      = fontSize / float( metrics.UnitsPerEm );
+    m_Ascent     = float( metrics.Ascender ) * m_Scale;
+    m_LineHeight = float( metrics.Ascender - metrics.Descender + metrics.LineGap ) * m_Scale;
+    if ( !( m_LineHeight > 0.0f ) )
+    { m_LineHeight = fontSize * 1.2f; }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::Term()
+{
+    Clear();
+
+    std::vector<uint16_t>  ().swap( m_Glyphs );
+    std::vector<float>     ().swap( m_Ends );
+    std::vector<uint8_t>   ().swap( m_Flags );
+    std::vector<BreakPoint>().swap( m_Breaks );
+    std::vector<Paragraph> ().swap( m_Paragraphs );
+    std::vector<uint32_t>  ().swap( m_LineTree );
+
+    m_pFace = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全ての段落を削除します.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::Clear()
+{
+    m_Glyphs    .clear();
+    m_Ends      .clear();
+    m_Flags     .clear();
+    m_Breaks    .clear();
+    m_Paragraphs.clear();
+    m_LineTree  .clear();
+    m_LineCount = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      段落を追加します. 文字をグリフに変換して各クラスタの右端の位置を累積し, 改行できる位置と
+//      そこまでの幅をキャッシュします. 行分割は次の Update() で行います.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::AddParagraph( const uint32_t* pText, uint32_t length )
+{
+    if ( m_pFace == nullptr || ( pText == nullptr && length > 0 ) )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return UINT32_MAX;
+    }
+
+    Paragraph paragraph;
+    paragraph.First      = uint32_t( m_Glyphs.size() );
+    paragraph.Count      = length;
+    paragraph.BreakFirst = uint32_t( m_Breaks.size() );
+    paragraph.MinWidth   = FLT_MAX;
+    paragraph.MaxWidth   = -FLT_MAX;
+
+    m_Glyphs.resize( paragraph.First + length );
+    m_Ends  .resize( paragraph.First + length );
+    m_Flags .resize( paragraph.First + length );
+
+    BREAK_CLASS prev    = BREAK_CLASS_SPACE;
+    float       x       = 0.0f;
+    float       visible = 0.0f;     // 直前の空白以外のクラスタの右端.
+    for( uint32_t i = 0; i < length; ++i )
+    {
+        const uint32_t    glyph = m_pFace->GetGlyphIndex( pText[i] );
+        const BREAK_CLASS next  = GetBreakClass( pText[i] );
+
+        if ( i > 0 && CanBreakBetween( prev, next ) )
+        {
+            BreakPoint point;
+            point.Pos     = i;
+            point.Visible = visible;
+            m_Breaks.push_back( point );
+        }
+
+        x += float( m_pFace->GetAdvance( glyph ) ) * m_Scale;
+        if ( next != BREAK_CLASS_SPACE )
+        { visible = x; }
+
+        m_Glyphs[paragraph.First + i] = uint16_t( glyph );
+        m_Ends  [paragraph.First + i] = x;
+        m_Flags [paragraph.First + i] = ( next == BREAK_CLASS_SPACE ) ? FLAG_SPACE : 0;
+
+        // 結合文字は基底文字の改行クラスを引き継ぐ.
+        if ( next != BREAK_CLASS_COMBINING )
+        { prev = next; }
+    }
+
+    // 段落末.
+    BreakPoint last;
+    last.Pos     = length;
+    last.Visible = visible;
+    m_Breaks.push_back( last );
+    paragraph.BreakCount = uint32_t( m_Breaks.size() ) - paragraph.BreakFirst;
+
+    const uint32_t index = uint32_t( m_Paragraphs.size() );
+    m_Paragraphs.push_back( paragraph );
+
+    // 行数 0 で Fenwick 木に追加する. 区間 (index + 1 - lowbit, index] の和を引き継ぐ.
+    const uint32_t node   = index + 1;
+    const uint32_t parent = node - ( node & ( ~node + 1 ) );
+    if ( m_LineTree.empty() )
+    { m_LineTree.push_back( 0 ); }
+    m_LineTree.push_back( GetLineOffset( index ) - GetLineOffset( parent ) );
+
+    m_Stats.ShapeCount++;
+    return index;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      UTF-8 のテキストを改行 (LF, CRLF, U+2029) で段落に分けて追加します.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::AddText( const char* pUtf8, size_t length )
+{
+    if ( pUtf8 == nullptr )
+    { return; }
+
+    std::vector<uint32_t> text;
+    const uint8_t* p    = reinterpret_cast<const uint8_t*>( pUtf8 );
+    const uint8_t* pEnd = p + length;
+    while( p < pEnd )
+    {
+        const uint32_t c = DecodeUtf8( p, pEnd );
+        if ( c == '\n' || c == 0x2029 )
+        {
+            if ( !text.empty() && text.back() == '\r' )
+            { text.pop_back(); }
+
+            AddParagraph( text.data(), uint32_t( text.size() ) );
+            text.clear();
+        }
+        else
+        { text.push_back( c ); }
+    }
+
+    AddParagraph( text.data(), uint32_t( text.size() ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      折り返し幅を設定します. 行分割は次の Update() で必要な段落だけやり直します.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::SetMaxWidth( float width )
+{ m_MaxWidth = ( width > 0.0f ) ? width : 0.0f; }
+
+//-------------------------------------------------------------------------------------------------
+//      揃えを設定します. 揃えは行の取得時に適用するので行分割はやり直しません.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::SetAlignment( TEXT_ALIGNMENT alignment )
+{ m_Alignment = alignment; }
+
+//-------------------------------------------------------------------------------------------------
+//      次の Update() で全ての段落の行分割をやり直すようにします.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::Invalidate()
+{ m_Invalid = true; }
+
+//-------------------------------------------------------------------------------------------------
+//      行分割を更新します. 各段落は現在の行分割が変わらない幅の範囲を保持しているので,
+//      新しい幅がその範囲から外れた段落だけをやり直します. 戻り値はやり直した段落数です.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::Update()
+{
+    m_Stats.UpdateCount++;
+
+    uint32_t reflowCount = 0;
+    for( size_t i = 0; i < m_Paragraphs.size(); ++i )
+    {
+        Paragraph& paragraph = m_Paragraphs[i];
+        if ( !m_Invalid && paragraph.MinWidth <= m_MaxWidth && m_MaxWidth < paragraph.MaxWidth )
+        { continue; }
+
+        const uint32_t oldLines = uint32_t( paragraph.Lines.size() );
+        Reflow( paragraph );
+        AddLineCount( uint32_t( i ), int32_t( paragraph.Lines.size() ) - int32_t( oldLines ) );
+        reflowCount++;
+    }
+
+    m_Invalid = false;
+    m_Stats.ReflowCount += reflowCount;
+    m_Stats.SkipCount   += m_Paragraphs.size() - reflowCount;
+    return reflowCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      折り返し幅を取得します.
+//-------------------------------------------------------------------------------------------------
+float TextLayout::GetMaxWidth() const
+{ return m_MaxWidth; }
+
+//-------------------------------------------------------------------------------------------------
+//      行の高さを取得します.
+//-------------------------------------------------------------------------------------------------
+float TextLayout::GetLineHeight() const
+{ return m_LineHeight; }
+
+//-------------------------------------------------------------------------------------------------
+//      文書全体の高さを取得します.
+//-------------------------------------------------------------------------------------------------
+float TextLayout::GetHeight() const
+{ return float( m_LineCount ) * m_LineHeight; }
+
+//-------------------------------------------------------------------------------------------------
+//      段落数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::GetParagraphCount() const
+{ return uint32_t( m_Paragraphs.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      全体の行数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::GetLineCount() const
+{ return m_LineCount; }
+
+//-------------------------------------------------------------------------------------------------
+//      段落の行数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::GetLineCount( uint32_t paragraph ) const
+{
+    if ( paragraph >= m_Paragraphs.size() )
+    { return 0; }
+
+    return uint32_t( m_Paragraphs[paragraph].Lines.size() );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      行の範囲と揃えを適用した位置を取得します.
+//-------------------------------------------------------------------------------------------------
+bool TextLayout::GetLine( uint32_t paragraph, uint32_t line, TextLine& result ) const
+{
+    if ( paragraph >= m_Paragraphs.size() || line >= m_Paragraphs[paragraph].Lines.size() )
+    { return false; }
+
+    const std::vector<Line>& lines = m_Paragraphs[paragraph].Lines;
+    result.Begin    = ( line > 0 ) ? lines[line - 1].End : 0;
+    result.End      = lines[line].End;
+    result.Width    = lines[line].Width;
+    result.Offset   = ( result.Begin > 0 ) ? m_Ends[m_Paragraphs[paragraph].First + result.Begin - 1] : 0.0f;
+    result.Baseline = float( GetLineOffset( paragraph ) + line ) * m_LineHeight + m_Ascent;
+
+    const float space = ( m_MaxWidth < FLT_MAX ) ? m_MaxWidth - result.Width : 0.0f;
+    switch( m_Alignment )
+    {
+    case TEXT_ALIGNMENT_TRAILING:   result.X = space;           break;
+    case TEXT_ALIGNMENT_CENTER:     result.X = space * 0.5f;    break;
+    default:                        result.X = 0.0f;            break;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      段落の上端の位置を取得します.
+//-------------------------------------------------------------------------------------------------
+float TextLayout::GetParagraphTop( uint32_t paragraph ) const
+{
+    paragraph = std::min( paragraph, uint32_t( m_Paragraphs.size() ) );
+    return float( GetLineOffset( paragraph ) ) * m_LineHeight;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定した位置を含む段落を探します. 表示範囲の先頭の段落を求めるのに使います.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::FindParagraph( float y ) const
+{
+    const uint32_t count = uint32_t( m_Paragraphs.size() );
+    if ( count == 0 )
+    { return 0; }
+
+    if ( !( y > 0.0f ) )
+    { return 0; }
+
+    if ( y >= GetHeight() )
+    { return count - 1; }
+
+    // 行数の累積和が y の行番号を超える最初の段落を Fenwick 木で二分探索する.
+    uint32_t remain = uint32_t( y / m_LineHeight );
+    uint32_t pos    = 0;
+    uint32_t step   = 1;
+    while( step * 2 <= count )
+    { step *= 2; }
+
+    for( ; step > 0; step /= 2 )
+    {
+        if ( pos + step <= count && m_LineTree[pos + step] <= remain )
+        {
+            pos    += step;
+            remain -= m_LineTree[pos];
+        }
+    }
+
+    return std::min( pos, count - 1 );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      段落のグリフ番号の配列を取得します.
+//-------------------------------------------------------------------------------------------------
+const uint16_t* TextLayout::GetGlyphs( uint32_t paragraph ) const
+{
+    if ( paragraph >= m_Paragraphs.size() || m_Paragraphs[paragraph].Count == 0 )
+    { return nullptr; }
+
+    return &m_Glyphs[m_Paragraphs[paragraph].First];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      段落のクラスタごとの右端の位置の配列を取得します. クラスタ i の左端は i > 0 なら [i - 1] です.
+//-------------------------------------------------------------------------------------------------
+const float* TextLayout::GetClusterEnds( uint32_t paragraph ) const
+{
+    if ( paragraph >= m_Paragraphs.size() || m_Paragraphs[paragraph].Count == 0 )
+    { return nullptr; }
+
+    return &m_Ends[m_Paragraphs[paragraph].First];
+}
+
+//-------------------------------------------------------------------------------------------------
+//      確保しているメモリ量を取得します.
+//-------------------------------------------------------------------------------------------------
+size_t TextLayout::GetMemoryUsage() const
+{
+    size_t result = sizeof(*this)
+        + m_Glyphs    .capacity() * sizeof(uint16_t)
+        + m_Ends      .capacity() * sizeof(float)
+        + m_Flags     .capacity() * sizeof(uint8_t)
+        + m_Breaks    .capacity() * sizeof(BreakPoint)
+        + m_Paragraphs.capacity() * sizeof(Paragraph)
+        + m_LineTree  .capacity() * sizeof(uint32_t);
+
+    for( size_t i = 0; i < m_Paragraphs.size(); ++i )
+    { result += m_Paragraphs[i].Lines.capacity() * sizeof(Line); }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+TextLayout::Stats TextLayout::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      段落を貪欲法で行に分割します. 行頭からの幅は累積位置の差で求まるので, 各行の終わりは
+//      改行位置の配列の二分探索で決まり, 行内のクラスタを走査しません. 行末の空白は幅に含めず
+//      ぶら下げ, 改行位置が無いまま幅を超える場合だけ文字単位で折り返します.
+//      同時に, この行分割が変わらない幅の範囲 [最も長い行の幅, いずれかの行に次の改行位置まで
+//      収まる幅) を求めます.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::Reflow( Paragraph& paragraph )
+{
+    const float*      pEnds    = m_Ends  .data() + paragraph.First;
+    const uint8_t*    pFlags   = m_Flags .data() + paragraph.First;
+    const BreakPoint* pBreaks  = m_Breaks.data() + paragraph.BreakFirst;
+    const uint32_t    count    = paragraph.BreakCount;
+    const float       maxWidth = m_MaxWidth;
+
+    paragraph.Lines.clear();
+    paragraph.MinWidth = 0.0f;
+    paragraph.MaxWidth = UNBOUNDED_WIDTH;
+
+    uint32_t start  = 0;        // 行頭のクラスタ番号.
+    float    offset = 0.0f;     // 段落の先頭から行頭までの距離.
+    uint32_t next   = 0;        // 行頭より後ろの最初の改行位置.
+    for( ;; )
+    {
+        // 行に収まる最後の改行位置を探す.
+        uint32_t lo = next;
+        uint32_t hi = count;
+        while( lo < hi )
+        {
+            const uint32_t mid = ( lo + hi ) / 2;
+            if ( pBreaks[mid].Visible - offset <= maxWidth )
+            { lo = mid + 1; }
+            else
+            { hi = mid; }
+            m_Stats.TestCount++;
+        }
+
+        Line     line   = { paragraph.Count, 0.0f };
+        float    needed = UNBOUNDED_WIDTH;  // この行に次の改行位置まで載せるのに必要な幅.
+        uint32_t fit    = lo;
+        if ( fit == next )
+        {
+            // 改行位置が収まらないので文字単位で折り返す (先頭の 1 クラスタは必ず載せる).
+            const uint32_t limit = pBreaks[next].Pos;
+            float    visible = 0.0f;
+            float    nextVisible = 0.0f;
+            uint32_t i = start;
+            for( ; i < limit; ++i )
+            {
+                nextVisible = ( pFlags[i] & FLAG_SPACE ) ? visible : pEnds[i] - offset;
+                if ( nextVisible > maxWidth && i > start )
+                { break; }
+                visible = nextVisible;
+            }
+            m_Stats.TestCount += i - start;
+
+            if ( i == limit )
+            {
+                // 幅を超えていたのは先頭のクラスタだけだった.
+                fit = next + 1;
+            }
+            else
+            {
+                line.End   = i;
+                line.Width = visible;
+                needed     = nextVisible;
+            }
+        }
+
+        if ( fit > next )
+        {
+            const BreakPoint& point = pBreaks[fit - 1];
+            line.End   = point.Pos;
+            line.Width = point.Visible - offset;
+            needed     = ( fit < count ) ? pBreaks[fit].Visible - offset : UNBOUNDED_WIDTH;
+            next       = fit;
+        }
+
+        // 1 クラスタだけで幅を超える行は, それより狭い幅でも同じ分割になる.
+        paragraph.Lines.push_back( line );
+        paragraph.MinWidth = std::max( paragraph.MinWidth, ( line.Width <= maxWidth ) ? line.Width : 0.0f );
+        paragraph.MaxWidth = std::min( paragraph.MaxWidth, needed );
+
+        if ( line.End >= paragraph.Count )
+        { break; }
+
+        start  = line.End;
+        offset = pEnds[start - 1];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      段落の行数を増減します.
+//-------------------------------------------------------------------------------------------------
+void TextLayout::AddLineCount( uint32_t paragraph, int32_t delta )
+{
+    if ( delta == 0 )
+    { return; }
+
+    for( uint32_t node = paragraph + 1; node < m_LineTree.size(); node += node & ( ~node + 1 ) )
+    { m_LineTree[node] += uint32_t( delta ); }
+
+    m_LineCount += uint32_t( delta );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      指定した段落より前の行数の合計を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextLayout::GetLineOffset( uint32_t paragraph ) const
+{
+    uint32_t result = 0;
+    for( uint32_t node = paragraph; node > 0; node -= node & ( ~node + 1 ) )
+    { result += m_LineTree[node]; }
+
+    return result;
+}
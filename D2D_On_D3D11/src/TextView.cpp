@@ -0,0 +1,524 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TextView.cpp
+// Desc : Virtualized Text View with Line Strip Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <TextView.h>
+#include <Logger.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const uint64_t  INVALID_LINE    = UINT64_MAX;   // 未使用のストリップ.
+const uint32_t  TAB_SPACES      = 4;            // タブ幅 (空白の数).
+const uint32_t  STRIP_MARGIN    = 2;            // 表示行数に対するストリップ数の倍率 (往復スクロールでの再利用).
+
+//-------------------------------------------------------------------------------------------------
+//      UTF-8 から 1 文字を復号します. 不正な並びは U+FFFD にします.
+//-------------------------------------------------------------------------------------------------
+uint32_t DecodeUtf8( const uint8_t*& p, const uint8_t* pEnd )
+{
+    const uint32_t b0 = *p++;
+    if ( b0 < 0x80 )
+    { return b0; }
+
+    uint32_t count;
+    uint32_t c;
+    uint32_t minimum;
+    if      ( ( b0 & 0xE0 ) == 0xC0 ) { count = 1; c = b0 & 0x1F; minimum = 0x80; }
+    else if ( ( b0 & 0xF0 ) == 0xE0 ) { count = 2; c = b0 & 0x0F; minimum = 0x800; }
+    else if ( ( b0 & 0xF8 ) == 0xF0 ) { count = 3; c = b0 & 0x07; minimum = 0x10000; }
+    else
+    { return 0xFFFD; }
+
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        if ( p >= pEnd || ( *p & 0xC0 ) != 0x80 )
+        { return 0xFFFD; }
+        c = ( c << 6 ) | ( *p++ & 0x3F );
+    }
+
+    if ( c < minimum || c > 0x10FFFF || ( 0xD800 <= c && c <= 0xDFFF ) )
+    { return 0xFFFD; }
+
+    return c;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みの色 back と text をカバレッジ a で補間します. 2 チャンネルずつ 16bit 単位で計算します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t BlendColor( uint32_t back, uint32_t text, uint32_t a )
+{
+    const uint32_t ia = 255 - a;
+
+    uint32_t rb = ( back & 0x00FF00FF ) * ia + ( text & 0x00FF00FF ) * a + 0x00800080;
+    rb = ( ( rb + ( ( rb >> 8 ) & 0x00FF00FF ) ) >> 8 ) & 0x00FF00FF;
+
+    uint32_t ag = ( ( back >> 8 ) & 0x00FF00FF ) * ia + ( ( text >> 8 ) & 0x00FF00FF ) * a + 0x00800080;
+    ag = ( ag + ( ( ag >> 8 ) & 0x00FF00FF ) ) & 0xFF00FF00;
+
+    return ag | rb;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TextView class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextView::TextView()
+: m_pFace       ( nullptr )
+, m_pBuffer     ( nullptr )
+, m_Scale       ( 0.0f )
+, m_LineHeight  ( 0 )
+, m_Baseline    ( 0 )
+, m_TabWidth    ( 0.0f )
+, m_Width       ( 0 )
+, m_Height      ( 0 )
+, m_TextColor   ( 0xFFFFFFFF )
+, m_BackColor   ( 0xFF000000 )
+, m_ScrollY     ( 0.0 )
+, m_GlyphBudget ( 0 )
+, m_GlyphBytes  ( 0 )
+, m_FrameIndex  ( 0 )
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TextView::~TextView()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. フォントフェイスとテキストバッファは呼び出し側が保持します.
+//      行の高さは整数ピクセルに切り上げ, ストリップが隙間無く並ぶようにします.
+//-------------------------------------------------------------------------------------------------
+bool TextView::Init( const FontFace* pFace, float fontSize, uint32_t width, uint32_t height, size_t glyphBudget )
+{
+    Term();
+
+    if ( pFace == nullptr || !pFace->IsValid() || !( fontSize > 0.0f ) )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const FontMetrics metrics = pFace->GetMetrics();
+
+    m_pFace       = pFace;
+    m_Scale       = fontSize / float( metrics.UnitsPerEm );
+    m_Baseline    = uint32_t( std::ceil( float( metrics.Ascender ) * m_Scale ) );
+    m_LineHeight  = uint32_t( std::ceil( float( metrics.Ascender - metrics.Descender + metrics.LineGap ) * m_Scale ) );
+    m_LineHeight  = std::max( m_LineHeight, m_Baseline + 1 );
+    m_TabWidth    = float( pFace->GetAdvance( pFace->GetGlyphIndex( ' ' ) ) ) * m_Scale * float( TAB_SPACES );
+    m_GlyphBudget = glyphBudget;
+
+    if ( !( m_TabWidth > 0.0f ) )
+    { m_TabWidth = fontSize * 0.5f * float( TAB_SPACES ); }
+
+    if ( !Resize( width, height ) )
+    {
+        ELOG( "Error : TextView::Resize() Failed." );
+        Term();
+        return false;
+    }
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void TextView::Term()
+{
+    m_Glyphs.clear();
+    std::vector<uint8_t>().swap( m_StripPixels );
+    std::vector<Strip>  ().swap( m_Strips );
+    std::string         ().swap( m_LineText );
+
+    m_pFace      = nullptr;
+    m_pBuffer    = nullptr;
+    m_Width      = 0;
+    m_Height     = 0;
+    m_ScrollY    = 0.0;
+    m_GlyphBytes = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      表示サイズを変更します. ストリップは表示行数の STRIP_MARGIN 倍だけ確保するので,
+//      メモリ使用量は文書の大きさに依存しません.
+//-------------------------------------------------------------------------------------------------
+bool TextView::Resize( uint32_t width, uint32_t height )
+{
+    if ( m_pFace == nullptr || width == 0 || height == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const uint32_t rows  = ( height + m_LineHeight - 1 ) / m_LineHeight + 1;
+    const uint32_t count = rows * STRIP_MARGIN;
+
+    m_Width  = width;
+    m_Height = height;
+
+    std::vector<uint8_t>( size_t( count ) * width * m_LineHeight ).swap( m_StripPixels );
+    std::vector<Strip>  ( count ).swap( m_Strips );
+    Invalidate();
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      表示するテキストバッファを設定します.
+//-------------------------------------------------------------------------------------------------
+void TextView::SetBuffer( TextBuffer* pBuffer )
+{
+    m_pBuffer = pBuffer;
+    m_ScrollY = 0.0;
+    Invalidate();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      文字色と背景色 (乗算済み B8G8R8A8) を設定します. ストリップはカバレッジだけを
+//      保持しているので, 描画し直す必要はありません.
+//-------------------------------------------------------------------------------------------------
+void TextView::SetColors( uint32_t textColor, uint32_t backColor )
+{
+    m_TextColor = textColor;
+    m_BackColor = backColor;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      全てのストリップを破棄します.
+//-------------------------------------------------------------------------------------------------
+void TextView::Invalidate()
+{
+    for( size_t i = 0; i < m_Strips.size(); ++i )
+    {
+        m_Strips[i].Line     = INVALID_LINE;
+        m_Strips[i].InkWidth = 0;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      スクロール位置 (文書の先頭からのピクセル数) を設定します. 範囲は Draw() で制限します.
+//-------------------------------------------------------------------------------------------------
+void TextView::ScrollTo( double y )
+{ m_ScrollY = y; }
+
+//-------------------------------------------------------------------------------------------------
+//      スクロール位置を相対的に移動します.
+//-------------------------------------------------------------------------------------------------
+void TextView::ScrollBy( double dy )
+{ m_ScrollY += dy; }
+
+//-------------------------------------------------------------------------------------------------
+//      指定の行が先頭になるようにスクロールします.
+//-------------------------------------------------------------------------------------------------
+void TextView::ScrollToLine( uint64_t line )
+{ m_ScrollY = double( line ) * double( m_LineHeight ); }
+
+//-------------------------------------------------------------------------------------------------
+//      スクロール位置を取得します.
+//-------------------------------------------------------------------------------------------------
+double TextView::GetScroll() const
+{ return m_ScrollY; }
+
+//-------------------------------------------------------------------------------------------------
+//      文書全体の高さ (ピクセル) を取得します.
+//-------------------------------------------------------------------------------------------------
+double TextView::GetContentHeight() const
+{
+    if ( m_pBuffer == nullptr )
+    { return 0.0; }
+
+    return double( m_pBuffer->GetLineCount() ) * double( m_LineHeight );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      行の高さ (ピクセル) を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextView::GetLineHeight() const
+{ return m_LineHeight; }
+
+//-------------------------------------------------------------------------------------------------
+//      表示範囲の先頭の行番号を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t TextView::GetFirstVisibleLine() const
+{
+    if ( m_LineHeight == 0 || !( m_ScrollY > 0.0 ) )
+    { return 0; }
+
+    return uint64_t( m_ScrollY ) / m_LineHeight;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      表示範囲と重なる行だけをサーフェイスに描画します. 行は描画済みのストリップがあれば
+//      再利用し, 無い場合だけ取得, 整形してストリップに描画します. 1 フレームの処理量は
+//      表示サイズとスクロール量だけで決まり, 文書の行数には依存しません.
+//-------------------------------------------------------------------------------------------------
+bool TextView::Draw( Surface& target )
+{
+    if ( m_pFace == nullptr || !target.IsValid() )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_FrameIndex++;
+    m_Stats.FrameCount++;
+
+    // 変更された行以降のストリップを破棄する.
+    uint64_t lineCount = 0;
+    if ( m_pBuffer != nullptr )
+    {
+        const uint64_t changed = m_pBuffer->GetChangedLine();
+        if ( changed != TextBuffer::NoChange )
+        {
+            for( size_t i = 0; i < m_Strips.size(); ++i )
+            {
+                if ( m_Strips[i].Line != INVALID_LINE && m_Strips[i].Line >= changed )
+                { m_Strips[i].Line = INVALID_LINE; }
+            }
+            m_pBuffer->ClearChangedLine();
+        }
+
+        lineCount = m_pBuffer->GetLineCount();
+    }
+
+    // スクロール位置を文書の範囲に制限する.
+    const double maxScroll = std::max( 0.0, GetContentHeight() - double( m_Height ) );
+    m_ScrollY = std::min( std::max( m_ScrollY, 0.0 ), maxScroll );
+
+    const uint64_t top       = uint64_t( m_ScrollY );
+    const uint32_t width     = std::min( m_Width,  target.GetWidth() );
+    const uint32_t height    = std::min( m_Height, target.GetHeight() );
+    uint64_t       line      = top / m_LineHeight;
+    int32_t        y         = -int32_t( top % m_LineHeight );
+
+    for( ; y < int32_t( height ); y += int32_t( m_LineHeight ), ++line )
+    {
+        const uint8_t* pStrip   = nullptr;
+        uint32_t       inkWidth = 0;
+        if ( line < lineCount )
+        { pStrip = GetStrip( line, inkWidth ); }
+
+        Timer timer;
+
+        const uint32_t rowBegin = uint32_t( std::max( y, 0 ) );
+        const uint32_t rowEnd   = uint32_t( std::min( y + int32_t( m_LineHeight ), int32_t( height ) ) );
+        const uint32_t ink      = std::min( inkWidth, width );
+        for( uint32_t row = rowBegin; row < rowEnd; ++row )
+        {
+            uint32_t*      pDst = target.GetRow( row );
+            const uint8_t* pSrc = ( pStrip != nullptr ) ? pStrip + size_t( int32_t( row ) - y ) * m_Width : nullptr;
+
+            for( uint32_t x = 0; x < ink; ++x )
+            {
+                const uint32_t a = pSrc[x];
+                pDst[x] = ( a == 0 ) ? m_BackColor : ( a == 255 ) ? m_TextColor : BlendColor( m_BackColor, m_TextColor, a );
+            }
+            std::fill( pDst + ink, pDst + width, m_BackColor );
+        }
+
+        m_Stats.ComposeMsec += timer.GetElapsedMsec();
+    }
+
+    EvictGlyphs();
+
+    // 正常終了.
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      メモリ使用量を取得します. ストリップとグリフキャッシュは表示サイズと予算で決まります.
+//-------------------------------------------------------------------------------------------------
+size_t TextView::GetMemoryUsage() const
+{
+    return m_StripPixels.capacity()
+        + m_Strips.capacity() * sizeof(Strip)
+        + m_LineText.capacity()
+        + m_GlyphBytes;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+TextView::Stats TextView::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void TextView::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      行のストリップを取得します. 行番号 % ストリップ数 の位置に別の行があれば描画し直します.
+//-------------------------------------------------------------------------------------------------
+const uint8_t* TextView::GetStrip( uint64_t line, uint32_t& inkWidth )
+{
+    const size_t index   = size_t( line % m_Strips.size() );
+    uint8_t*     pPixels = &m_StripPixels[index * m_Width * m_LineHeight];
+    Strip&       strip   = m_Strips[index];
+
+    if ( strip.Line == line )
+    {
+        m_Stats.StripHitCount++;
+        inkWidth = strip.InkWidth;
+        return pPixels;
+    }
+
+    Timer timer;
+
+    strip.Line     = line;
+    strip.InkWidth = RenderLine( line, pPixels );
+    inkWidth       = strip.InkWidth;
+
+    m_Stats.StripMissCount++;
+    m_Stats.ShapeMsec += timer.GetElapsedMsec();
+
+    return pPixels;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      行を取得して整形し, ストリップにカバレッジを描画します. 表示幅を超えた時点で打ち切ります.
+//      カバレッジが存在する右端の列 + 1 を返します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TextView::RenderLine( uint64_t line, uint8_t* pPixels )
+{
+    memset( pPixels, 0, size_t( m_Width ) * m_LineHeight );
+
+    if ( m_pBuffer == nullptr || !m_pBuffer->GetLine( line, m_LineText, MaxLineBytes ) )
+    { return 0; }
+
+    const uint8_t* p    = reinterpret_cast<const uint8_t*>( m_LineText.data() );
+    const uint8_t* pEnd = p + m_LineText.size();
+
+    uint32_t ink = 0;
+    float    pen = 0.0f;
+    while( p < pEnd && pen < float( m_Width ) )
+    {
+        const uint32_t c = DecodeUtf8( p, pEnd );
+        if ( c == '\t' )
+        {
+            pen = ( std::floor( pen / m_TabWidth ) + 1.0f ) * m_TabWidth;
+            continue;
+        }
+
+        // 制御文字は描画しない.
+        if ( c < 0x20 || c == 0x7F )
+        { continue; }
+
+        const GlyphEntry* pGlyph = FindGlyph( m_pFace->GetGlyphIndex( c ) );
+        if ( pGlyph == nullptr )
+        { continue; }
+
+        // グリフは整数ピクセル位置に置き, 同じビットマップを使い回す.
+        const GlyphBitmap& bitmap = pGlyph->Bitmap;
+        const int32_t left = int32_t( std::floor( pen + 0.5f ) ) + bitmap.Left;
+        const int32_t top  = int32_t( m_Baseline ) + bitmap.Top;
+        const int32_t x0   = std::max( left, 0 );
+        const int32_t x1   = std::min( left + int32_t( bitmap.Width ),  int32_t( m_Width ) );
+        const int32_t y0   = std::max( top, 0 );
+        const int32_t y1   = std::min( top  + int32_t( bitmap.Height ), int32_t( m_LineHeight ) );
+
+        for( int32_t y = y0; y < y1; ++y )
+        {
+            const uint8_t* pSrc = &bitmap.Pixels[size_t( y - top ) * bitmap.Width + ( x0 - left )];
+            uint8_t*       pDst = pPixels + size_t( y ) * m_Width;
+            for( int32_t x = x0; x < x1; ++x, ++pSrc )
+            {
+                // 隣接するグリフの重なりは飽和加算する.
+                const uint32_t sum = uint32_t( pDst[x] ) + *pSrc;
+                pDst[x] = uint8_t( ( sum > 255 ) ? 255 : sum );
+            }
+        }
+
+        if ( x1 > x0 && y1 > y0 )
+        { ink = std::max( ink, uint32_t( x1 ) ); }
+
+        pen += pGlyph->Advance;
+    }
+
+    return ink;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      グリフのビットマップをキャッシュから探します. 無い場合はラスタライズして登録します.
+//-------------------------------------------------------------------------------------------------
+const TextView::GlyphEntry* TextView::FindGlyph( uint32_t glyph )
+{
+    std::map<uint32_t, GlyphEntry>::iterator itr = m_Glyphs.find( glyph );
+    if ( itr != m_Glyphs.end() )
+    {
+        itr->second.LastFrame = m_FrameIndex;
+        m_Stats.GlyphHitCount++;
+        return &itr->second;
+    }
+
+    GlyphEntry& entry = m_Glyphs[glyph];
+    entry.Advance   = float( m_pFace->GetAdvance( glyph ) ) * m_Scale;
+    entry.LastFrame = m_FrameIndex;
+
+    // 輪郭の無いグリフや失敗したグリフは空のビットマップとして送り幅だけを使う.
+    if ( !m_pFace->GetOutline( glyph, m_Outline )
+      || !m_Rasterizer.Rasterize( m_Outline, m_Scale, 0.0f, 0.0f, entry.Bitmap ) )
+    {
+        entry.Bitmap.Left   = 0;
+        entry.Bitmap.Top    = 0;
+        entry.Bitmap.Width  = 0;
+        entry.Bitmap.Height = 0;
+        entry.Bitmap.Pixels.clear();
+    }
+
+    m_GlyphBytes += sizeof(GlyphEntry) + entry.Bitmap.Pixels.capacity();
+    m_Stats.GlyphMissCount++;
+
+    return &entry;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      予算を超えている場合, 今フレームで使っていないグリフを古い順に破棄します.
+//-------------------------------------------------------------------------------------------------
+void TextView::EvictGlyphs()
+{
+    while( m_GlyphBytes > m_GlyphBudget )
+    {
+        std::map<uint32_t, GlyphEntry>::iterator oldest = m_Glyphs.end();
+        for( std::map<uint32_t, GlyphEntry>::iterator itr = m_Glyphs.begin(); itr != m_Glyphs.end(); ++itr )
+        {
+            if ( itr->second.LastFrame >= m_FrameIndex )
+            { continue; }
+
+            if ( oldest == m_Glyphs.end() || itr->second.LastFrame < oldest->second.LastFrame )
+            { oldest = itr; }
+        }
+
+        if ( oldest == m_Glyphs.end() )
+        { break; }
+
+        m_GlyphBytes -= sizeof(GlyphEntry) + oldest->second.Bitmap.Pixels.capacity();
+        m_Glyphs.erase( oldest );
+        m_Stats.GlyphEvictCount++;
+    }
+}
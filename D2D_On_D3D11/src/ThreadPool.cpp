@@ -0,0 +1,305 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : ThreadPool.cpp
+// Desc : Work Stealing Thread Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <ThreadPool.h>
+#include <ThreadLocal.h>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Thread Local Variables.
+//-------------------------------------------------------------------------------------------------
+THREAD_LOCAL const ThreadPool*  t_pOwnerPool  = nullptr;    //!< 実行中のワーカーが属するプールです.
+THREAD_LOCAL uint32_t           t_WorkerIndex = 0;          //!< 実行中のワーカー番号です.
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ParallelForState structure
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct ParallelForState
+{
+    std::atomic<uint32_t>           Next;       //!< 次に処理するインデックスです.
+    std::atomic<uint32_t>           Remaining;  //!< 未完了のインデックス数です.
+    uint32_t                        Count;      //!< インデックス総数です.
+    const ThreadPool::IndexedTask*  pTask;      //!< 実行するタスクです.
+};
+
+//-------------------------------------------------------------------------------------------------
+//      インデックスを取得できる限りタスクを実行します.
+//-------------------------------------------------------------------------------------------------
+void RunParallelFor( ParallelForState& state )
+{
+    for( ;; )
+    {
+        const uint32_t index = state.Next.fetch_add( 1 );
+        if ( index >= state.Count )
+        { break; }
+
+        ( *state.pTask )( index );
+        state.Remaining.fetch_sub( 1 );
+    }
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool()
+: m_QueuedCount     ( 0 )
+, m_UnfinishedCount ( 0 )
+, m_NextQueue       ( 0 )
+, m_StealCount      ( 0 )
+, m_Exit            ( false )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. threadCount が 0 の場合は論理コア数を使います.
+//-------------------------------------------------------------------------------------------------
+bool ThreadPool::Init( uint32_t threadCount )
+{
+    Term();
+
+    if ( threadCount == 0 )
+    { threadCount = std::thread::hardware_concurrency(); }
+    if ( threadCount == 0 )
+    { threadCount = 1; }
+
+    // 末尾のキューはプール外のスレッドが ParallelFor() や Wait() で手伝う際に使う.
+    m_Queues.resize( threadCount + 1 );
+    for( size_t i = 0; i < m_Queues.size(); ++i )
+    { m_Queues[i].reset( new WorkQueue() ); }
+
+    m_QueuedCount     = 0;
+    m_UnfinishedCount = 0;
+    m_NextQueue       = 0;
+    m_StealCount      = 0;
+    m_Exit            = false;
+
+    m_Threads.reserve( threadCount );
+    for( uint32_t i = 0; i < threadCount; ++i )
+    { m_Threads.push_back( std::thread( &ThreadPool::WorkerProc, this, i ) ); }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です. 残っているタスクは全て実行されます.
+//-------------------------------------------------------------------------------------------------
+void ThreadPool::Term()
+{
+    if ( m_Threads.empty() )
+    { return; }
+
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> lock( m_SleepMutex );
+        m_Exit = true;
+    }
+    m_SleepCond.notify_all();
+
+    for( size_t i = 0; i < m_Threads.size(); ++i )
+    { m_Threads[i].join(); }
+
+    m_Threads.clear();
+    m_Queues .clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      タスクを投入します.
+//-------------------------------------------------------------------------------------------------
+void ThreadPool::Submit( const Task& task )
+{
+    if ( m_Threads.empty() )
+    {
+        task();
+        return;
+    }
+
+    // ワーカーからの投入は自分のキューへ, それ以外はラウンドロビンで分散.
+    const uint32_t threadCount = uint32_t( m_Threads.size() );
+    const uint32_t index = ( t_pOwnerPool == this )
+        ? t_WorkerIndex
+        : m_NextQueue.fetch_add( 1 ) % threadCount;
+
+    m_UnfinishedCount.fetch_add( 1 );
+    m_QueuedCount.fetch_add( 1 );
+
+    {
+        std::lock_guard<std::mutex> lock( m_Queues[index]->Mutex );
+        m_Queues[index]->Tasks.push_back( task );
+    }
+
+    // 眠りに入る直前のワーカーを取りこぼさないよう, ロックを経由して通知する.
+    {
+        std::lock_guard<std::mutex> lock( m_SleepMutex );
+    }
+    m_SleepCond.notify_one();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      [0, count) の各インデックスについてタスクを並列実行し, 完了を待ちます.
+//      呼び出し元スレッドも処理に参加します.
+//-------------------------------------------------------------------------------------------------
+void ThreadPool::ParallelFor( uint32_t count, const IndexedTask& task )
+{
+    if ( count == 0 )
+    { return; }
+
+    if ( m_Threads.empty() || count == 1 )
+    {
+        for( uint32_t i = 0; i < count; ++i )
+        { task( i ); }
+        return;
+    }
+
+    // 遅れて起動したタスクが参照しても安全なよう, 状態は共有ポインタで保持する.
+    std::shared_ptr<ParallelForState> state( new ParallelForState() );
+    state->Next      = 0;
+    state->Remaining = count;
+    state->Count     = count;
+    state->pTask     = &task;
+
+    const uint32_t threadCount = uint32_t( m_Threads.size() );
+    const uint32_t helpers     = ( count - 1 < threadCount ) ? count - 1 : threadCount;
+    for( uint32_t i = 0; i < helpers; ++i )
+    { Submit( [state]() { RunParallelFor( *state ); } ); }
+
+    RunParallelFor( *state );
+
+    // 他スレッドが処理中のインデックスを待つ間, 別のタスクを手伝う.
+    const uint32_t self = ( t_pOwnerPool == this ) ? t_WorkerIndex : threadCount;
+    while( state->Remaining.load() > 0 )
+    {
+        if ( !TryRunTask( self ) )
+        { std::this_thread::yield(); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      投入済みのタスクが全て完了するまで待機します.
+//      プール外のスレッドから呼び出してください. 待機中は呼び出し元もタスクを処理します.
+//-------------------------------------------------------------------------------------------------
+void ThreadPool::Wait()
+{
+    if ( m_Threads.empty() )
+    { return; }
+
+    const uint32_t self = uint32_t( m_Threads.size() );
+    while( m_UnfinishedCount.load() > 0 )
+    {
+        if ( !TryRunTask( self ) )
+        { std::this_thread::yield(); }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      ワーカースレッド数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t ThreadPool::GetThreadCount() const
+{ return uint32_t( m_Threads.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      他キューからタスクを奪った回数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint64_t ThreadPool::GetStealCount() const
+{ return m_StealCount.load(); }
+
+//-------------------------------------------------------------------------------------------------
+//      ワーカースレッドの処理です.
+//-------------------------------------------------------------------------------------------------
+void ThreadPool::WorkerProc( uint32_t index )
+{
+    t_pOwnerPool  = this;
+    t_WorkerIndex = index;
+
+    for( ;; )
+    {
+        if ( TryRunTask( index ) )
+        { continue; }
+
+        std::unique_lock<std::mutex> lock( m_SleepMutex );
+        m_SleepCond.wait( lock, [this] { return m_Exit || m_QueuedCount.load() > 0; } );
+
+        if ( m_Exit && m_QueuedCount.load() <= 0 )
+        { break; }
+    }
+
+    t_pOwnerPool = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      タスクを1つ取得して実行します.
+//-------------------------------------------------------------------------------------------------
+bool ThreadPool::TryRunTask( uint32_t index )
+{
+    Task task;
+    if ( !TryPopLocal( index, task ) && !TrySteal( index, task ) )
+    { return false; }
+
+    m_QueuedCount.fetch_sub( 1 );
+    task();
+    m_UnfinishedCount.fetch_sub( 1 );
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      自分のキューの末尾からタスクを取り出します.
+//-------------------------------------------------------------------------------------------------
+bool ThreadPool::TryPopLocal( uint32_t index, Task& task )
+{
+    WorkQueue& queue = *m_Queues[index];
+    std::lock_guard<std::mutex> lock( queue.Mutex );
+
+    if ( queue.Tasks.empty() )
+    { return false; }
+
+    task = std::move( queue.Tasks.back() );
+    queue.Tasks.pop_back();
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      他のキューの先頭からタスクを奪います.
+//-------------------------------------------------------------------------------------------------
+bool ThreadPool::TrySteal( uint32_t index, Task& task )
+{
+    const uint32_t count = uint32_t( m_Queues.size() );
+
+    for( uint32_t i = 1; i < count; ++i )
+    {
+        WorkQueue& queue = *m_Queues[ ( index + i ) % count ];
+
+        // 競合しているキューは飛ばして次を探す.
+        std::unique_lock<std::mutex> lock( queue.Mutex, std::try_to_lock );
+        if ( !lock.owns_lock() || queue.Tasks.empty() )
+        { continue; }
+
+        task = std::move( queue.Tasks.front() );
+        queue.Tasks.pop_front();
+        m_StealCount.fetch_add( 1 );
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,429 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TileRenderer.cpp
+// Desc : Screen Tile Binning Renderer.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <TileRenderer.h>
+#include <Logger.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+//      1画素の各チャンネルに a / 255 を掛けます.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MulDiv255Pixel( uint32_t color, uint32_t a )
+{
+    uint32_t result = 0;
+    for( uint32_t shift = 0; shift < 32; shift += 8 )
+    {
+        const uint32_t x = ( ( color >> shift ) & 0xff ) * a + 128;
+        result |= ( ( x + ( x >> 8 ) ) >> 8 ) << shift;
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みアルファで src を dst の上に合成します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t BlendOver( uint32_t src, uint32_t dst )
+{
+    const uint32_t alpha = src >> 24;
+    if ( alpha == 255 )
+    { return src; }
+    if ( src == 0 )
+    { return dst; }
+
+    return src + MulDiv255Pixel( dst, 255 - alpha );
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TileRenderer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TileRenderer::TileRenderer()
+: m_Width       ( 0 )
+, m_Height      ( 0 )
+, m_TileSize    ( 0 )
+, m_TileCountX  ( 0 )
+, m_TileCountY  ( 0 )
+{
+    memset( &m_Scissor, 0, sizeof(m_Scissor) );
+    ResetStats();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TileRenderer::~TileRenderer()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理です. width x height の画面を tileSize 四方のタイルに分割します.
+//-------------------------------------------------------------------------------------------------
+bool TileRenderer::Init( uint32_t width, uint32_t height, uint32_t tileSize )
+{
+    Term();
+
+    if ( width == 0 || height == 0 || tileSize == 0 || tileSize > MaxTileSize )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_Width      = width;
+    m_Height     = height;
+    m_TileSize   = tileSize;
+    m_TileCountX = ( width  + tileSize - 1 ) / tileSize;
+    m_TileCountY = ( height + tileSize - 1 ) / tileSize;
+
+    m_Bins.resize( m_TileCountX * m_TileCountY );
+    m_ActiveTiles.reserve( m_Bins.size() );
+
+    Reset();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理です.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::Term()
+{
+    std::vector<Command>              ().swap( m_Commands );
+    std::vector<std::vector<uint32_t>>().swap( m_Bins );
+    std::vector<uint32_t>             ().swap( m_ActiveTiles );
+
+    m_Width      = 0;
+    m_Height     = 0;
+    m_TileSize   = 0;
+    m_TileCountX = 0;
+    m_TileCountY = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      フレームの記録を開始します. コマンドとタイルの領域は再利用します.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::Reset()
+{
+    for( size_t i = 0; i < m_ActiveTiles.size(); ++i )
+    { m_Bins[m_ActiveTiles[i]].clear(); }
+
+    m_ActiveTiles.clear();
+    m_Commands   .clear();
+    SetScissor( nullptr );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      以降のコマンドに適用するシザー矩形を設定します. nullptr の場合は画面全体です.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::SetScissor( const ClipRect* pRect )
+{
+    ClipRect screen = { 0, 0, int( m_Width ), int( m_Height ) };
+    m_Scissor = ( pRect != nullptr ) ? Intersect( *pRect, screen ) : screen;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      単色の矩形を記録します. color は乗算済み B8G8R8A8 です.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::FillRect( const ClipRect& rect, uint32_t color )
+{
+    if ( ( color >> 24 ) == 0 )
+    { return; }
+
+    Command command = {};
+    command.Type  = TILE_COMMAND_FILL_RECT;
+    command.Rect  = rect;
+    command.Color = color;
+    AddCommand( command );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      グラデーションの矩形を記録します. ブラシは Render() が終わるまで保持してください.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::FillGradient( const ClipRect& rect, const GradientBrush* pBrush )
+{
+    if ( pBrush == nullptr )
+    { return; }
+
+    Command command = {};
+    command.Type   = TILE_COMMAND_FILL_GRADIENT;
+    command.Rect   = rect;
+    command.pBrush = pBrush;
+    AddCommand( command );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      画像を (x, y) に記録します. 画像は Render() が終わるまで保持してください.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::DrawImage( int x, int y, const Surface* pImage )
+{
+    if ( pImage == nullptr || !pImage->IsValid() )
+    { return; }
+
+    Command command = {};
+    command.Type        = TILE_COMMAND_DRAW_IMAGE;
+    command.Rect.Left   = x;
+    command.Rect.Top    = y;
+    command.Rect.Right  = x + int( pImage->GetWidth () );
+    command.Rect.Bottom = y + int( pImage->GetHeight() );
+    command.OriginX     = x;
+    command.OriginY     = y;
+    command.pImage      = pImage;
+    AddCommand( command );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      カバレッジマスクを (x, y) に記録します. マスクは Render() が終わるまで保持してください.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::DrawMask( int x, int y, uint32_t width, uint32_t height, const uint8_t* pMask, uint32_t pitch, uint32_t color )
+{
+    if ( pMask == nullptr || ( color >> 24 ) == 0 )
+    { return; }
+
+    Command command = {};
+    command.Type        = TILE_COMMAND_DRAW_MASK;
+    command.Rect.Left   = x;
+    command.Rect.Top    = y;
+    command.Rect.Right  = x + int( width  );
+    command.Rect.Bottom = y + int( height );
+    command.OriginX     = x;
+    command.OriginY     = y;
+    command.Color       = color;
+    command.pMask       = pMask;
+    command.MaskPitch   = pitch;
+    AddCommand( command );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      記録したコマンドをタイルごとに描画します. 各タイルは投入順にコマンドを処理するので,
+//      タイル間の処理順に関わらず全体を順番に描画した場合と同じ結果になります.
+//      pPool が nullptr の場合は呼び出したスレッドだけで描画します.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::Render( Surface& target, ThreadPool* pPool )
+{
+    if ( target.GetWidth() != m_Width || target.GetHeight() != m_Height )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return;
+    }
+
+    Timer timer;
+
+    const uint32_t count = uint32_t( m_ActiveTiles.size() );
+    if ( pPool != nullptr && count > 1 )
+    {
+        pPool->ParallelFor( count, [&]( uint32_t index )
+        { RenderTile( target, m_ActiveTiles[index] ); } );
+    }
+    else
+    {
+        for( uint32_t i = 0; i < count; ++i )
+        { RenderTile( target, m_ActiveTiles[i] ); }
+    }
+
+    m_Stats.FrameCount++;
+    m_Stats.CommandCount += m_Commands.size();
+    m_Stats.TileCount    += count;
+    m_Stats.RenderMsec   += timer.GetElapsedMsec();
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Render() の比較用です. タイルに分けずに全てのコマンドを順番に描画します.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::RenderDirect( Surface& target ) const
+{
+    if ( target.GetWidth() != m_Width || target.GetHeight() != m_Height )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return;
+    }
+
+    std::vector<uint32_t> scratch( m_Width );
+    const ClipRect screen = { 0, 0, int( m_Width ), int( m_Height ) };
+
+    for( size_t i = 0; i < m_Commands.size(); ++i )
+    { Execute( m_Commands[i], target, screen, &scratch[0] ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      記録されているコマンド数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TileRenderer::GetCommandCount() const
+{ return uint32_t( m_Commands.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      コマンドを持つタイル数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TileRenderer::GetTileCount() const
+{ return uint32_t( m_ActiveTiles.size() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+TileRenderer::Stats TileRenderer::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }
+
+//-------------------------------------------------------------------------------------------------
+//      コマンドを登録して, 範囲が重なるタイルに振り分けます.
+//      タイル全体を覆う不透明な単色の塗りつぶしは, それまでのコマンドを全て隠すので捨てます.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::AddCommand( const Command& command )
+{
+    const ClipRect rect = Intersect( command.Rect, m_Scissor );
+    if ( rect.IsEmpty() )
+    { return; }
+
+    const uint32_t index = uint32_t( m_Commands.size() );
+    m_Commands.push_back( command );
+    m_Commands.back().Rect = rect;
+
+    const bool opaque = ( command.Type == TILE_COMMAND_FILL_RECT ) && ( command.Color >> 24 ) == 255;
+    const int  size   = int( m_TileSize );
+
+    const uint32_t tx0 = uint32_t( rect.Left ) / m_TileSize;
+    const uint32_t ty0 = uint32_t( rect.Top  ) / m_TileSize;
+    const uint32_t tx1 = uint32_t( rect.Right  - 1 ) / m_TileSize;
+    const uint32_t ty1 = uint32_t( rect.Bottom - 1 ) / m_TileSize;
+
+    for( uint32_t ty = ty0; ty <= ty1; ++ty )
+    {
+        for( uint32_t tx = tx0; tx <= tx1; ++tx )
+        {
+            const uint32_t tile = ty * m_TileCountX + tx;
+            std::vector<uint32_t>& bin = m_Bins[tile];
+
+            if ( bin.empty() )
+            { m_ActiveTiles.push_back( tile ); }
+            else if ( opaque )
+            {
+                const int left   = int( tx ) * size;
+                const int top    = int( ty ) * size;
+                const int right  = std::min( left + size, int( m_Width  ) );
+                const int bottom = std::min( top  + size, int( m_Height ) );
+                if ( rect.Left <= left && right <= rect.Right && rect.Top <= top && bottom <= rect.Bottom )
+                {
+                    m_Stats.OccludedCount += bin.size();
+                    bin.clear();
+                }
+            }
+
+            bin.push_back( index );
+            m_Stats.BinCount++;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1つのタイルのコマンドを投入順に描画します.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::RenderTile( Surface& target, uint32_t tile ) const
+{
+    const int size = int( m_TileSize );
+    const int left = int( tile % m_TileCountX ) * size;
+    const int top  = int( tile / m_TileCountX ) * size;
+
+    ClipRect clip;
+    clip.Left   = left;
+    clip.Top    = top;
+    clip.Right  = std::min( left + size, int( m_Width  ) );
+    clip.Bottom = std::min( top  + size, int( m_Height ) );
+
+    uint32_t scratch[MaxTileSize];
+
+    const std::vector<uint32_t>& bin = m_Bins[tile];
+    for( size_t i = 0; i < bin.size(); ++i )
+    { Execute( m_Commands[bin[i]], target, clip, scratch ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      コマンドを clip の範囲に描画します. pScratch は clip の幅以上の大きさが必要です.
+//-------------------------------------------------------------------------------------------------
+void TileRenderer::Execute( const Command& command, Surface& target, const ClipRect& clip, uint32_t* pScratch )
+{
+    const ClipRect rect = Intersect( command.Rect, clip );
+    if ( rect.IsEmpty() )
+    { return; }
+
+    const uint32_t width = uint32_t( rect.Right - rect.Left );
+
+    switch( command.Type )
+    {
+    case TILE_COMMAND_FILL_RECT:
+        {
+            const uint32_t color = command.Color;
+            for( int y = rect.Top; y < rect.Bottom; ++y )
+            {
+                uint32_t* pDst = target.GetRow( uint32_t( y ) ) + rect.Left;
+                if ( ( color >> 24 ) == 255 )
+                { std::fill( pDst, pDst + width, color ); }
+                else
+                {
+                    const uint32_t inverse = 255 - ( color >> 24 );
+                    for( uint32_t x = 0; x < width; ++x )
+                    { pDst[x] = color + MulDiv255Pixel( pDst[x], inverse ); }
+                }
+            }
+        }
+        break;
+
+    case TILE_COMMAND_FILL_GRADIENT:
+        {
+            for( int y = rect.Top; y < rect.Bottom; ++y )
+            {
+                uint32_t* pDst = target.GetRow( uint32_t( y ) ) + rect.Left;
+                command.pBrush->FillSpan( rect.Left, y, width, pScratch );
+                for( uint32_t x = 0; x < width; ++x )
+                { pDst[x] = BlendOver( pScratch[x], pDst[x] ); }
+            }
+        }
+        break;
+
+    case TILE_COMMAND_DRAW_IMAGE:
+        {
+            for( int y = rect.Top; y < rect.Bottom; ++y )
+            {
+                uint32_t*       pDst = target.GetRow( uint32_t( y ) ) + rect.Left;
+                const uint32_t* pSrc = command.pImage->GetRow( uint32_t( y - command.OriginY ) ) + ( rect.Left - command.OriginX );
+                for( uint32_t x = 0; x < width; ++x )
+                { pDst[x] = BlendOver( pSrc[x], pDst[x] ); }
+            }
+        }
+        break;
+
+    case TILE_COMMAND_DRAW_MASK:
+        {
+            for( int y = rect.Top; y < rect.Bottom; ++y )
+            {
+                uint32_t*      pDst  = target.GetRow( uint32_t( y ) ) + rect.Left;
+                const uint8_t* pMask = command.pMask + size_t( y - command.OriginY ) * command.MaskPitch + ( rect.Left - command.OriginX );
+                for( uint32_t x = 0; x < width; ++x )
+                {
+                    if ( pMask[x] != 0 )
+                    { pDst[x] = BlendOver( MulDiv255Pixel( command.Color, pMask[x] ), pDst[x] ); }
+                }
+            }
+        }
+        break;
+    }
+}
@@ -0,0 +1,117 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : Timer.cpp
+// Desc : High Resolution Timer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <Timer.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+//      1秒あたりのティック数を問い合わせます.
+//-------------------------------------------------------------------------------------------------
+int64_t QueryTicksPerSec()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency( &freq );
+    return freq.QuadPart;
+#else
+    return 1000000000;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// Global Variables.
+//-------------------------------------------------------------------------------------------------
+// 関数内 static は VS2013 ではスレッドセーフでないため, 起動時に確定させておく.
+const int64_t g_TicksPerSec = QueryTicksPerSec();
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+Timer::Timer()
+: m_Start( GetTicks() )
+{ /* DO_NOTHING */ }
+
+//-------------------------------------------------------------------------------------------------
+//      計測開始時刻をリセットします.
+//-------------------------------------------------------------------------------------------------
+void Timer::Reset()
+{ m_Start = GetTicks(); }
+
+//-------------------------------------------------------------------------------------------------
+//      経過ティック数を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t Timer::GetElapsedTicks() const
+{ return GetTicks() - m_Start; }
+
+//-------------------------------------------------------------------------------------------------
+//      経過時間を秒単位で取得します.
+//-------------------------------------------------------------------------------------------------
+double Timer::GetElapsedSec() const
+{ return ToSec( GetElapsedTicks() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      経過時間をミリ秒単位で取得します.
+//-------------------------------------------------------------------------------------------------
+double Timer::GetElapsedMsec() const
+{ return ToMsec( GetElapsedTicks() ); }
+
+//-------------------------------------------------------------------------------------------------
+//      現在のティック数を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t Timer::GetTicks()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+    return counter.QuadPart;
+#else
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return int64_t( ts.tv_sec ) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1秒あたりのティック数を取得します.
+//-------------------------------------------------------------------------------------------------
+int64_t Timer::GetTicksPerSec()
+{ return g_TicksPerSec; }
+
+//-------------------------------------------------------------------------------------------------
+//      ティック数を秒に変換します.
+//-------------------------------------------------------------------------------------------------
+double Timer::ToSec( int64_t ticks )
+{ return double( ticks ) / double( g_TicksPerSec ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ティック数をミリ秒に変換します.
+//-------------------------------------------------------------------------------------------------
+double Timer::ToMsec( int64_t ticks )
+{ return double( ticks ) * 1000.0 / double( g_TicksPerSec ); }
+
+//-------------------------------------------------------------------------------------------------
+//      ティック数をナノ秒に変換します.
+//-------------------------------------------------------------------------------------------------
+double Timer::ToNsec( int64_t ticks )
+{ return double( ticks ) * 1000000000.0 / double( g_TicksPerSec ); }
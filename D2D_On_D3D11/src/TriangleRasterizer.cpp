@@ -0,0 +1,614 @@
+﻿//-------------------------------------------------------------------------------------------------
+// File : TriangleRasterizer.cpp
+// Desc : Software Triangle Rasterizer with Coverage Mask Antialiasing.
+// Copyright(c) Project Asura. All right reserved.
+//-------------------------------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------------------------------
+// Includes
+//-------------------------------------------------------------------------------------------------
+#include <TriangleRasterizer.h>
+#include <Logger.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-------------------------------------------------------------------------------------------------
+// Constant Values.
+//-------------------------------------------------------------------------------------------------
+const int32_t   ONE_PIXEL = 1 << TriangleRasterizer::SubPixelBits;     //!< 固定小数の 1 ピクセルです.
+const int32_t   HALF_PIXEL = ONE_PIXEL / 2;                             //!< 固定小数の 0.5 ピクセルです.
+
+// D3D の標準サンプルパターン (1/16 ピクセル単位).
+const int32_t   SAMPLE_4X[4][2] = { { -2, -6 }, {  6, -2 }, { -6,  2 }, {  2,  6 } };
+const int32_t   SAMPLE_8X[8][2] = {
+    {  1, -3 }, { -1,  3 }, {  5,  1 }, { -3, -5 },
+    { -5,  5 }, { -7, -1 }, {  3,  7 }, {  7, -7 },
+};
+
+
+//-------------------------------------------------------------------------------------------------
+//      8bit 値にアルファを乗算します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t MulDiv255( uint32_t c, uint32_t a )
+{
+    const uint32_t t = c * a + 128;
+    return ( t + ( t >> 8 ) ) >> 8;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みの色を source-over で合成します.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t BlendOver( uint32_t src, uint32_t dst )
+{
+    const uint32_t inv = 255 - ( src >> 24 );
+    uint32_t result = 0;
+    for( uint32_t shift = 0; shift < 32; shift += 8 )
+    {
+        const uint32_t c = ( ( src >> shift ) & 0xFF ) + MulDiv255( ( dst >> shift ) & 0xFF, inv );
+        result |= c << shift;
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      0～1 に制限します.
+//-------------------------------------------------------------------------------------------------
+inline float Saturate( float value )
+{ return ( value < 0.0f ) ? 0.0f : ( value > 1.0f ) ? 1.0f : value; }
+
+//-------------------------------------------------------------------------------------------------
+//      ストレートアルファの色を乗算済み B8G8R8A8 にします.
+//-------------------------------------------------------------------------------------------------
+inline uint32_t PackPremultiplied( float r, float g, float b, float a )
+{
+    a = Saturate( a );
+    const uint32_t ia = uint32_t( a * 255.0f + 0.5f );
+    const uint32_t ir = uint32_t( Saturate( r ) * a * 255.0f + 0.5f );
+    const uint32_t ig = uint32_t( Saturate( g ) * a * 255.0f + 0.5f );
+    const uint32_t ib = uint32_t( Saturate( b ) * a * 255.0f + 0.5f );
+    return ib | ( ig << 8 ) | ( ir << 16 ) | ( ia << 24 );
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// TriangleRasterizer class
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+//-------------------------------------------------------------------------------------------------
+//      コンストラクタです.
+//-------------------------------------------------------------------------------------------------
+TriangleRasterizer::TriangleRasterizer()
+: m_Mode            ( AA_MODE_NONE )
+, m_Width           ( 0 )
+, m_Height          ( 0 )
+, m_BufferWidth     ( 0 )
+, m_BufferHeight    ( 0 )
+, m_SampleCount     ( 1 )
+, m_Scale           ( 1.0f )
+{
+    memset( m_OffsetX, 0, sizeof(m_OffsetX) );
+    memset( m_OffsetY, 0, sizeof(m_OffsetY) );
+    memset( &m_Stats,  0, sizeof(m_Stats) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      デストラクタです.
+//-------------------------------------------------------------------------------------------------
+TriangleRasterizer::~TriangleRasterizer()
+{ Term(); }
+
+//-------------------------------------------------------------------------------------------------
+//      初期化処理を行います.
+//-------------------------------------------------------------------------------------------------
+bool TriangleRasterizer::Init( uint32_t width, uint32_t height, AA_MODE mode )
+{
+    if ( width == 0 || height == 0 || mode >= AA_MODE_COUNT )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    Term();
+
+    m_Mode         = mode;
+    m_Width        = width;
+    m_Height       = height;
+    m_BufferWidth  = width;
+    m_BufferHeight = height;
+    m_SampleCount  = 1;
+    m_Scale        = 1.0f;
+    memset( m_OffsetX, 0, sizeof(m_OffsetX) );
+    memset( m_OffsetY, 0, sizeof(m_OffsetY) );
+
+    switch( mode )
+    {
+    case AA_MODE_MSAA_4X:
+        m_SampleCount = 4;
+        for( uint32_t i = 0; i < 4; ++i )
+        {
+            m_OffsetX[i] = SAMPLE_4X[i][0] * ONE_PIXEL / 16;
+            m_OffsetY[i] = SAMPLE_4X[i][1] * ONE_PIXEL / 16;
+        }
+        break;
+
+    case AA_MODE_MSAA_8X:
+        m_SampleCount = 8;
+        for( uint32_t i = 0; i < 8; ++i )
+        {
+            m_OffsetX[i] = SAMPLE_8X[i][0] * ONE_PIXEL / 16;
+            m_OffsetY[i] = SAMPLE_8X[i][1] * ONE_PIXEL / 16;
+        }
+        break;
+
+    case AA_MODE_SSAA_4X:
+        m_BufferWidth  = width  * 2;
+        m_BufferHeight = height * 2;
+        m_Scale        = 2.0f;
+        break;
+
+    default:
+        break;
+    }
+
+    const size_t pixels = size_t( m_BufferWidth ) * m_BufferHeight;
+    m_Samples   .resize( pixels * m_SampleCount );
+    m_Compressed.resize( pixels );
+
+    Clear( 0 );
+    ResetStats();
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      終了処理を行います.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::Term()
+{
+    m_Samples    .clear();
+    m_Compressed .clear();
+    m_Transformed.clear();
+    m_Samples    .shrink_to_fit();
+    m_Compressed .shrink_to_fit();
+    m_Transformed.shrink_to_fit();
+    m_Width        = 0;
+    m_Height       = 0;
+    m_BufferWidth  = 0;
+    m_BufferHeight = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      乗算済みの色でクリアします. 全画素を圧縮状態にするので面 0 だけを書き込みます.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::Clear( uint32_t color )
+{
+    const size_t pixels = m_Compressed.size();
+    std::fill( m_Samples.begin(), m_Samples.begin() + pixels, color );
+    std::fill( m_Compressed.begin(), m_Compressed.end(), uint8_t( 1 ) );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      三角形リストを描画します. 座標は出力のピクセル単位で, 色はストレートアルファです.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::DrawTriangles( const MeshVertex* pVertices, size_t count )
+{
+    if ( pVertices == nullptr || m_Compressed.empty() )
+    { return; }
+
+    for( size_t i = 0; i + 2 < count; i += 3 )
+    { DrawTriangle( pVertices[i], pVertices[i + 1], pVertices[i + 2] ); }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      描画ごとの変換と色を適用して三角形リストを描画します. 頂点データを書き換えずに
+//      動かせるよう, GPU の頂点シェーダと同じ変換を作業用バッファに行ってから描画します.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::DrawTriangles( const MeshVertex* pVertices, size_t count, const DrawTransform& transform )
+{
+    if ( pVertices == nullptr || m_Compressed.empty() )
+    { return; }
+
+    m_Transformed.resize( count );
+    TransformVertices( pVertices, count, transform, m_Transformed.data() );
+    DrawTriangles( m_Transformed.data(), count );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      1つの三角形を描画します.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::DrawTriangle( const MeshVertex& v0, const MeshVertex& v1, const MeshVertex& v2 )
+{
+    const MeshVertex* pV[3] = { &v0, &v1, &v2 };
+
+    // 固定小数に丸めてから面積を求める. 裏向きは頂点を入れ替えて表向きにする.
+    const float scale = m_Scale * float( ONE_PIXEL );
+    int64_t x[3], y[3];
+    for( uint32_t i = 0; i < 3; ++i )
+    {
+        x[i] = int64_t( floorf( pV[i]->Position[0] * scale + 0.5f ) );
+        y[i] = int64_t( floorf( pV[i]->Position[1] * scale + 0.5f ) );
+    }
+
+    int64_t area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( y[1] - y[0] ) * ( x[2] - x[0] );
+    if ( area == 0 )
+    { return; }
+
+    if ( area < 0 )
+    {
+        std::swap( x[1], x[2] );
+        std::swap( y[1], y[2] );
+        std::swap( pV[1], pV[2] );
+        area = -area;
+    }
+
+    // 画面外は描画しない.
+    const int64_t minX = std::min( std::min( x[0], x[1] ), x[2] );
+    const int64_t maxX = std::max( std::max( x[0], x[1] ), x[2] );
+    const int64_t minY = std::min( std::min( y[0], y[1] ), y[2] );
+    const int64_t maxY = std::max( std::max( y[0], y[1] ), y[2] );
+
+    const int64_t px0 = std::max<int64_t>( minX >> SubPixelBits, 0 );
+    const int64_t py0 = std::max<int64_t>( minY >> SubPixelBits, 0 );
+    const int64_t px1 = std::min<int64_t>( maxX >> SubPixelBits, int64_t( m_BufferWidth  ) - 1 );
+    const int64_t py1 = std::min<int64_t>( maxY >> SubPixelBits, int64_t( m_BufferHeight ) - 1 );
+    if ( px0 > px1 || py0 > py1 )
+    { return; }
+
+    m_Stats.TriangleCount++;
+
+    // 辺関数 E(p) = A * px + B * py + C. 辺 i は頂点 i の対辺で, 内側が正.
+    int64_t A[3], B[3], C[3], bias[3];
+    int64_t minD[3] = { 0, 0, 0 };
+    int64_t maxD[3] = { 0, 0, 0 };
+    int64_t D[3][8];
+    for( uint32_t i = 0; i < 3; ++i )
+    {
+        const uint32_t a = ( i + 1 ) % 3;
+        const uint32_t b = ( i + 2 ) % 3;
+        A[i] = y[a] - y[b];
+        B[i] = x[b] - x[a];
+        C[i] = -( A[i] * x[a] + B[i] * y[a] );
+
+        // トップレフトルール. 左辺と上辺の上にあるサンプルだけを含める.
+        const bool topLeft = ( A[i] > 0 ) || ( A[i] == 0 && B[i] > 0 );
+        bias[i] = topLeft ? 0 : -1;
+
+        for( uint32_t s = 0; s < m_SampleCount; ++s )
+        {
+            D[i][s] = A[i] * m_OffsetX[s] + B[i] * m_OffsetY[s];
+            minD[i] = ( s == 0 || D[i][s] < minD[i] ) ? D[i][s] : minD[i];
+            maxD[i] = ( s == 0 || D[i][s] > maxD[i] ) ? D[i][s] : maxD[i];
+        }
+    }
+
+    const float invArea = 1.0f / float( area );
+    const uint32_t fullMask = ( 1u << m_SampleCount ) - 1;
+
+    for( int64_t py = py0; py <= py1; ++py )
+    {
+        const int64_t cx = px0 * ONE_PIXEL + HALF_PIXEL;
+        const int64_t cy = py  * ONE_PIXEL + HALF_PIXEL;
+
+        int64_t e[3];
+        for( uint32_t i = 0; i < 3; ++i )
+        { e[i] = A[i] * cx + B[i] * cy + C[i]; }
+
+        const size_t rowIndex = size_t( py ) * m_BufferWidth;
+        for( int64_t px = px0; px <= px1; ++px )
+        {
+            // 全サンプルの内外が辺ごとの最小と最大で決まる場合はサンプルを調べない.
+            const int64_t e0 = e[0] + bias[0];
+            const int64_t e1 = e[1] + bias[1];
+            const int64_t e2 = e[2] + bias[2];
+
+            uint32_t mask = 0;
+            if ( e0 + minD[0] >= 0 && e1 + minD[1] >= 0 && e2 + minD[2] >= 0 )
+            { mask = fullMask; }
+            else if ( e0 + maxD[0] >= 0 && e1 + maxD[1] >= 0 && e2 + maxD[2] >= 0 )
+            {
+                for( uint32_t s = 0; s < m_SampleCount; ++s )
+                {
+                    if ( e0 + D[0][s] >= 0 && e1 + D[1][s] >= 0 && e2 + D[2][s] >= 0 )
+                    { mask |= 1u << s; }
+                }
+            }
+
+            if ( mask != 0 )
+            {
+                // 画素中心で 1 回だけシェーディングする. 中心が三角形の外でも外挿して飽和させる.
+                const float l0 = float( e[0] ) * invArea;
+                const float l1 = float( e[1] ) * invArea;
+                const float l2 = float( e[2] ) * invArea;
+                const float r = pV[0]->Color[0] * l0 + pV[1]->Color[0] * l1 + pV[2]->Color[0] * l2;
+                const float g = pV[0]->Color[1] * l0 + pV[1]->Color[1] * l1 + pV[2]->Color[1] * l2;
+                const float b = pV[0]->Color[2] * l0 + pV[1]->Color[2] * l1 + pV[2]->Color[2] * l2;
+                const float a = pV[0]->Color[3] * l0 + pV[1]->Color[3] * l1 + pV[2]->Color[3] * l2;
+
+                m_Stats.ShadedCount++;
+                WritePixel( rowIndex + size_t( px ), mask, fullMask, PackPremultiplied( r, g, b, a ) );
+            }
+
+            e[0] += A[0] * ONE_PIXEL;
+            e[1] += A[1] * ONE_PIXEL;
+            e[2] += A[2] * ONE_PIXEL;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      覆われたサンプルに色を書き込みます.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::WritePixel( size_t index, uint32_t mask, uint32_t fullMask, uint32_t color )
+{
+    const bool opaque = ( color >> 24 ) == 255;
+
+    // 全サンプルを覆い, 結果が全サンプルで等しくなる場合は面 0 だけに書いて圧縮状態にする.
+    if ( mask == fullMask && ( opaque || m_Compressed[index] ) )
+    {
+        uint32_t& dst = m_Samples[index];
+        dst = opaque ? color : BlendOver( color, dst );
+        m_Compressed[index] = 1;
+        m_Stats.SampleWriteCount++;
+        return;
+    }
+
+    const size_t plane = m_Compressed.size();
+    if ( m_Compressed[index] )
+    {
+        const uint32_t value = m_Samples[index];
+        for( uint32_t s = 1; s < m_SampleCount; ++s )
+        { m_Samples[s * plane + index] = value; }
+
+        m_Compressed[index] = 0;
+        m_Stats.DecompressCount++;
+    }
+
+    if ( mask != fullMask )
+    { m_Stats.PartialCount++; }
+
+    for( uint32_t s = 0; s < m_SampleCount; ++s )
+    {
+        if ( ( mask & ( 1u << s ) ) == 0 )
+        { continue; }
+
+        uint32_t& dst = m_Samples[s * plane + index];
+        dst = opaque ? color : BlendOver( color, dst );
+        m_Stats.SampleWriteCount++;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+//      サンプルを平均して出力サーフェイスに書き込みます (SSE2).
+//-------------------------------------------------------------------------------------------------
+bool TriangleRasterizer::Resolve( Surface& target ) const
+{
+    if ( m_Compressed.empty() || target.GetWidth() < m_Width || target.GetHeight() < m_Height )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+
+    // SSAA は内部バッファの 2x2 画素を平均する.
+    if ( m_Mode == AA_MODE_SSAA_4X )
+    {
+        const __m128i round = _mm_set1_epi16( 2 );
+        const uint32_t count = m_Width & ~3u;
+        for( uint32_t y = 0; y < m_Height; ++y )
+        {
+            const uint32_t* pRow0 = &m_Samples[ size_t( y * 2     ) * m_BufferWidth ];
+            const uint32_t* pRow1 = &m_Samples[ size_t( y * 2 + 1 ) * m_BufferWidth ];
+            uint32_t*       pDst  = target.GetRow( y );
+
+            for( uint32_t x = 0; x < count; x += 4 )
+            {
+                __m128i sum[4];
+                for( uint32_t i = 0; i < 2; ++i )
+                {
+                    const __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow0 + x * 2 + i * 4 ) );
+                    const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow1 + x * 2 + i * 4 ) );
+                    sum[i * 2 + 0] = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+                    sum[i * 2 + 1] = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+                }
+
+                // 各レジスタの上下 64bit (横に隣接する 2 画素) を足す.
+                for( uint32_t i = 0; i < 4; ++i )
+                { sum[i] = _mm_add_epi16( sum[i], _mm_srli_si128( sum[i], 8 ) ); }
+
+                __m128i lo = _mm_unpacklo_epi64( sum[0], sum[1] );
+                __m128i hi = _mm_unpacklo_epi64( sum[2], sum[3] );
+                lo = _mm_srli_epi16( _mm_add_epi16( lo, round ), 2 );
+                hi = _mm_srli_epi16( _mm_add_epi16( hi, round ), 2 );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x ), _mm_packus_epi16( lo, hi ) );
+            }
+
+            for( uint32_t x = count; x < m_Width; ++x )
+            {
+                const uint32_t p[4] = { pRow0[x * 2], pRow0[x * 2 + 1], pRow1[x * 2], pRow1[x * 2 + 1] };
+                uint32_t result = 0;
+                for( uint32_t shift = 0; shift < 32; shift += 8 )
+                {
+                    const uint32_t sum = ( ( p[0] >> shift ) & 0xFF ) + ( ( p[1] >> shift ) & 0xFF )
+                                       + ( ( p[2] >> shift ) & 0xFF ) + ( ( p[3] >> shift ) & 0xFF );
+                    result |= ( ( sum + 2 ) >> 2 ) << shift;
+                }
+                pDst[x] = result;
+            }
+        }
+        return true;
+    }
+
+    // MSAA は圧縮された画素は面 0 をそのまま使い, それ以外はサンプルを平均する.
+    const size_t   plane = m_Compressed.size();
+    const uint32_t shift = ( m_SampleCount == 8 ) ? 3 : ( m_SampleCount == 4 ) ? 2 : 0;
+    const __m128i  round = _mm_set1_epi16( int16_t( m_SampleCount / 2 ) );
+    const __m128i  count = _mm_cvtsi32_si128( int( shift ) );
+    const uint32_t width = m_Width & ~3u;
+
+    for( uint32_t y = 0; y < m_Height; ++y )
+    {
+        const size_t row  = size_t( y ) * m_BufferWidth;
+        uint32_t*    pDst = target.GetRow( y );
+
+        for( uint32_t x = 0; x < width; x += 4 )
+        {
+            const size_t  index = row + x;
+            const __m128i s0    = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &m_Samples[index] ) );
+
+            uint32_t flags;
+            memcpy( &flags, &m_Compressed[index], sizeof(flags) );
+            if ( flags == 0x01010101 || m_SampleCount == 1 )
+            {
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x ), s0 );
+                continue;
+            }
+
+            __m128i lo = _mm_unpacklo_epi8( s0, zero );
+            __m128i hi = _mm_unpackhi_epi8( s0, zero );
+            for( uint32_t s = 1; s < m_SampleCount; ++s )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &m_Samples[s * plane + index] ) );
+                lo = _mm_add_epi16( lo, _mm_unpacklo_epi8( v, zero ) );
+                hi = _mm_add_epi16( hi, _mm_unpackhi_epi8( v, zero ) );
+            }
+            lo = _mm_srl_epi16( _mm_add_epi16( lo, round ), count );
+            hi = _mm_srl_epi16( _mm_add_epi16( hi, round ), count );
+            const __m128i average = _mm_packus_epi16( lo, hi );
+
+            // 圧縮された画素の他の面は不定なので面 0 で置き換える.
+            __m128i mask = _mm_unpacklo_epi8( _mm_cvtsi32_si128( int( flags ) ), zero );
+            mask = _mm_cmpeq_epi32( _mm_unpacklo_epi16( mask, zero ), zero );
+            const __m128i result = _mm_or_si128( _mm_and_si128( mask, average ), _mm_andnot_si128( mask, s0 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + x ), result );
+        }
+
+        for( uint32_t x = width; x < m_Width; ++x )
+        {
+            const size_t index = row + x;
+            if ( m_Compressed[index] )
+            {
+                pDst[x] = m_Samples[index];
+                continue;
+            }
+
+            uint32_t result = 0;
+            for( uint32_t c = 0; c < 32; c += 8 )
+            {
+                uint32_t sum = 0;
+                for( uint32_t s = 0; s < m_SampleCount; ++s )
+                { sum += ( m_Samples[s * plane + index] >> c ) & 0xFF; }
+                result |= ( ( sum + m_SampleCount / 2 ) >> shift ) << c;
+            }
+            pDst[x] = result;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      Resolve() のスカラー版です. 検証と速度比較に使います.
+//-------------------------------------------------------------------------------------------------
+bool TriangleRasterizer::ResolveScalar( Surface& target ) const
+{
+    if ( m_Compressed.empty() || target.GetWidth() < m_Width || target.GetHeight() < m_Height )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const size_t   plane  = m_Compressed.size();
+    const bool     ssaa   = ( m_Mode == AA_MODE_SSAA_4X );
+    const uint32_t count  = ssaa ? 4 : m_SampleCount;
+    const uint32_t shift  = ( count == 8 ) ? 3 : ( count == 4 ) ? 2 : 0;
+
+    for( uint32_t y = 0; y < m_Height; ++y )
+    {
+        uint32_t* pDst = target.GetRow( y );
+        for( uint32_t x = 0; x < m_Width; ++x )
+        {
+            // 平均するサンプルを集める.
+            uint32_t samples[8];
+            if ( ssaa )
+            {
+                const size_t index = size_t( y * 2 ) * m_BufferWidth + x * 2;
+                samples[0] = m_Samples[index];
+                samples[1] = m_Samples[index + 1];
+                samples[2] = m_Samples[index + m_BufferWidth];
+                samples[3] = m_Samples[index + m_BufferWidth + 1];
+            }
+            else
+            {
+                const size_t index = size_t( y ) * m_BufferWidth + x;
+                for( uint32_t s = 0; s < count; ++s )
+                { samples[s] = m_Compressed[index] ? m_Samples[index] : m_Samples[s * plane + index]; }
+            }
+
+            uint32_t result = 0;
+            for( uint32_t c = 0; c < 32; c += 8 )
+            {
+                uint32_t sum = 0;
+                for( uint32_t s = 0; s < count; ++s )
+                { sum += ( samples[s] >> c ) & 0xFF; }
+                result |= ( ( sum + count / 2 ) >> shift ) << c;
+            }
+            pDst[x] = result;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+//      アンチエイリアスの方式を取得します.
+//-------------------------------------------------------------------------------------------------
+AA_MODE TriangleRasterizer::GetMode() const
+{ return m_Mode; }
+
+//-------------------------------------------------------------------------------------------------
+//      内部バッファの画素あたりのサンプル数を取得します.
+//-------------------------------------------------------------------------------------------------
+uint32_t TriangleRasterizer::GetSampleCount() const
+{ return m_SampleCount; }
+
+//-------------------------------------------------------------------------------------------------
+//      圧縮状態の画素の割合を取得します.
+//-------------------------------------------------------------------------------------------------
+double TriangleRasterizer::GetCompressedRatio() const
+{
+    if ( m_Compressed.empty() )
+    { return 0.0; }
+
+    size_t count = 0;
+    for( size_t i = 0; i < m_Compressed.size(); ++i )
+    { count += m_Compressed[i]; }
+
+    return double( count ) / double( m_Compressed.size() );
+}
+
+//-------------------------------------------------------------------------------------------------
+//      メモリ使用量を取得します.
+//-------------------------------------------------------------------------------------------------
+size_t TriangleRasterizer::GetMemoryUsage() const
+{ return m_Samples.capacity() * sizeof(uint32_t) + m_Compressed.capacity() + m_Transformed.capacity() * sizeof(MeshVertex); }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-------------------------------------------------------------------------------------------------
+TriangleRasterizer::Stats TriangleRasterizer::GetStats() const
+{ return m_Stats; }
+
+//-------------------------------------------------------------------------------------------------
+//      統計情報をリセットします.
+//-------------------------------------------------------------------------------------------------
+void TriangleRasterizer::ResetStats()
+{ memset( &m_Stats, 0, sizeof(m_Stats) ); }